@@ -297,18 +297,10 @@ documents_recreate_preview_cmd_callback (GtkAction *action,
 
   if (imagefile && gimp_container_have (container, GIMP_OBJECT (imagefile)))
     {
-      GError *error = NULL;
-
-      if (! gimp_imagefile_create_thumbnail (imagefile,
-                                             context, NULL,
-                                             context->gimp->config->thumbnail_size,
-                                             FALSE, &error))
-        {
-          gimp_message_literal (context->gimp,
-                                NULL , GIMP_MESSAGE_ERROR,
-                                error->message);
-          g_clear_error (&error);
-        }
+      gimp_imagefile_queue_thumbnail (imagefile, context,
+                                      context->gimp->config->thumbnail_size,
+                                      FALSE);
+      gimp_imagefile_prioritize_thumbnail (imagefile);
     }
 }
 
@@ -160,6 +160,9 @@ app_run (const gchar         *full_prog_name,
          const gchar         *session_name,
          const gchar         *batch_interpreter,
          const gchar        **batch_commands,
+         const gchar         *batch_file,
+         gint                 batch_jobs,
+         gint                 batch_timeout,
          gboolean             as_new,
          gboolean             no_interface,
          gboolean             no_data,
@@ -323,7 +326,8 @@ app_run (const gchar         *full_prog_name,
     }
 
   if (run_loop)
-    gimp_batch_run (gimp, batch_interpreter, batch_commands);
+    gimp_batch_run (gimp, batch_interpreter, batch_commands,
+                    batch_file, batch_jobs, batch_timeout);
 
   if (run_loop)
     {
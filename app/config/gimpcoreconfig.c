@@ -99,6 +99,8 @@ enum
   PROP_UNDO_PREVIEW_SIZE,
   PROP_FILTER_HISTORY_SIZE,
   PROP_PLUGINRC_PATH,
+  PROP_PLUG_IN_POOL_SIZE,
+  PROP_PLUG_IN_POOL_TIMEOUT,
   PROP_LAYER_PREVIEWS,
   PROP_LAYER_PREVIEW_SIZE,
   PROP_THUMBNAIL_SIZE,
@@ -570,6 +572,20 @@ gimp_core_config_class_init (GimpCoreConfigClass *klass)
                          GIMP_PARAM_STATIC_STRINGS |
                          GIMP_CONFIG_PARAM_RESTART);
 
+  GIMP_CONFIG_PROP_INT (object_class, PROP_PLUG_IN_POOL_SIZE,
+                        "plug-in-pool-size",
+                        "Plug-in pool size",
+                        PLUG_IN_POOL_SIZE_BLURB,
+                        0, 64, 0,
+                        GIMP_PARAM_STATIC_STRINGS);
+
+  GIMP_CONFIG_PROP_INT (object_class, PROP_PLUG_IN_POOL_TIMEOUT,
+                        "plug-in-pool-timeout",
+                        "Plug-in pool timeout",
+                        PLUG_IN_POOL_TIMEOUT_BLURB,
+                        1, 3600, 60,
+                        GIMP_PARAM_STATIC_STRINGS);
+
   GIMP_CONFIG_PROP_BOOLEAN (object_class, PROP_LAYER_PREVIEWS,
                             "layer-previews",
                             "Layer previews",
@@ -896,6 +912,12 @@ gimp_core_config_set_property (GObject      *object,
     case PROP_FILTER_HISTORY_SIZE:
       core_config->filter_history_size = g_value_get_int (value);
       break;
+    case PROP_PLUG_IN_POOL_SIZE:
+      core_config->plug_in_pool_size = g_value_get_int (value);
+      break;
+    case PROP_PLUG_IN_POOL_TIMEOUT:
+      core_config->plug_in_pool_timeout = g_value_get_int (value);
+      break;
     case PROP_UNDO_LEVELS:
       core_config->levels_of_undo = g_value_get_int (value);
       break;
@@ -1087,6 +1109,12 @@ gimp_core_config_get_property (GObject    *object,
     case PROP_FILTER_HISTORY_SIZE:
       g_value_set_int (value, core_config->filter_history_size);
       break;
+    case PROP_PLUG_IN_POOL_SIZE:
+      g_value_set_int (value, core_config->plug_in_pool_size);
+      break;
+    case PROP_PLUG_IN_POOL_TIMEOUT:
+      g_value_set_int (value, core_config->plug_in_pool_timeout);
+      break;
     case PROP_UNDO_LEVELS:
       g_value_set_int (value, core_config->levels_of_undo);
       break;
@@ -84,6 +84,8 @@ struct _GimpCoreConfig
   GimpViewSize            undo_preview_size;
   gint                    filter_history_size;
   gchar                  *plug_in_rc_path;
+  gint                    plug_in_pool_size;
+  gint                    plug_in_pool_timeout;
   gboolean                layer_previews;
   GimpViewSize            layer_preview_size;
   GimpThumbnailSize       thumbnail_size;
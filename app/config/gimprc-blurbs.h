@@ -274,6 +274,15 @@ _("Sets how many threads GIMP should use for operations that support it.")
 #define PLUGINRC_PATH_BLURB \
 "Sets the pluginrc search path."
 
+#define PLUG_IN_POOL_SIZE_BLURB \
+"How many idle plug-in processes to keep running for reuse by later " \
+"non-interactive calls of the same plug-in.  Set this to 0 to start a " \
+"new process for every call."
+
+#define PLUG_IN_POOL_TIMEOUT_BLURB \
+"Sets the number of seconds an idle plug-in process is kept in the " \
+"plug-in pool before it is terminated."
+
 #define LAYER_PREVIEWS_BLURB \
 _("Sets whether GIMP should create previews of layers and channels. " \
   "Previews in the layers and channels dialog are nice to have but they " \
@@ -198,7 +198,10 @@ typedef struct _GimpTagged          GimpTagged;      /* dummy typedef */
 /*  non-object types  */
 
 typedef struct _GimpBoundSeg        GimpBoundSeg;
+typedef struct _GimpChannelBoundaryTiles GimpChannelBoundaryTiles;
+typedef struct _GimpChannelSummary  GimpChannelSummary;
 typedef struct _GimpCoords          GimpCoords;
+typedef struct _GimpDataCache       GimpDataCache;
 typedef struct _GimpGradientSegment GimpGradientSegment;
 typedef struct _GimpPaletteEntry    GimpPaletteEntry;
 typedef struct _GimpSamplePoint     GimpSamplePoint;
@@ -29,34 +29,112 @@
 
 #include "gimp.h"
 #include "gimp-batch.h"
+#include "gimp-gui.h"
+#include "gimpcontext.h"
 #include "gimpparamspecs.h"
 
 #include "pdb/gimppdb.h"
 #include "pdb/gimpprocedure.h"
 
+#include "plug-in/gimppluginmanager.h"
+#include "plug-in/gimppluginprocedure.h"
+
 #include "gimp-intl.h"
 
 
 #define BATCH_DEFAULT_EVAL_PROC   "plug-in-script-fu-eval"
 
 
-static void  gimp_batch_exit_after_callback (Gimp          *gimp) G_GNUC_NORETURN;
-
-static void  gimp_batch_run_cmd             (Gimp          *gimp,
-                                             const gchar   *proc_name,
-                                             GimpProcedure *procedure,
-                                             GimpRunMode    run_mode,
-                                             const gchar   *cmd);
-
+typedef struct _GimpBatchQueue GimpBatchQueue;
+typedef struct _GimpBatchJob   GimpBatchJob;
 
+struct _GimpBatchQueue
+{
+  Gimp                *gimp;
+  GimpPlugInProcedure *procedure;
+  GPtrArray           *commands;
+  gint                 n_jobs;
+  gint                 timeout;
+
+  gint                 next;
+  gint                 n_running;
+  gint                 n_failed;
+  gboolean             starting;
+  GMainLoop           *loop;
+};
+
+struct _GimpBatchJob
+{
+  GimpBatchQueue *queue;
+  gint            index;
+  GimpContext    *context;
+  GTimer         *timer;
+  guint           timeout_id;
+  gboolean        timed_out;
+};
+
+
+static void             gimp_batch_exit_after_callback (Gimp           *gimp) G_GNUC_NORETURN;
+
+static GPtrArray *      gimp_batch_get_commands        (const gchar   **batch_commands,
+                                                        const gchar    *batch_file);
+static GimpValueArray * gimp_batch_get_arguments       (GimpProcedure  *procedure,
+                                                        GimpRunMode     run_mode,
+                                                        const gchar    *cmd);
+
+static void             gimp_batch_run_cmd             (Gimp           *gimp,
+                                                        const gchar    *proc_name,
+                                                        GimpProcedure  *procedure,
+                                                        GimpRunMode     run_mode,
+                                                        const gchar    *cmd);
+
+static void             gimp_batch_run_queue           (Gimp           *gimp,
+                                                        GimpProcedure  *procedure,
+                                                        GPtrArray      *commands,
+                                                        gint            n_jobs,
+                                                        gint            timeout);
+static void             gimp_batch_queue_start_jobs    (GimpBatchQueue *queue);
+static void             gimp_batch_job_return          (GimpValueArray *return_vals,
+                                                        gpointer        data);
+static gboolean         gimp_batch_job_timeout         (GimpBatchJob   *job);
+
+
+/**
+ * gimp_batch_run:
+ * @gimp:              a #Gimp
+ * @batch_interpreter: the procedure to evaluate the commands with,
+ *                     or %NULL for the default
+ * @batch_commands:    a %NULL-terminated array of commands, or %NULL
+ * @batch_file:        a file with one command per line, or %NULL
+ * @n_jobs:            the number of commands to run at once
+ * @timeout:           the time in seconds after which a command is
+ *                     aborted, or 0 for no limit
+ *
+ * Runs the commands of @batch_commands, followed by those of
+ * @batch_file. Empty lines and lines starting with '#' in
+ * @batch_file are skipped.
+ *
+ * If @n_jobs is larger than 1 or a @timeout is given, and the
+ * interpreter is a plug-in, the commands are run as a job queue:
+ * each command gets its own interpreter process, up to @n_jobs of
+ * them run at the same time, and the result and run time of each
+ * command is reported when it finished. Otherwise the commands run
+ * one after the other in order.
+ **/
 void
 gimp_batch_run (Gimp         *gimp,
                 const gchar  *batch_interpreter,
-                const gchar **batch_commands)
+                const gchar **batch_commands,
+                const gchar  *batch_file,
+                gint          n_jobs,
+                gint          timeout)
 {
-  gulong  exit_id;
+  GPtrArray *commands;
+  gulong     exit_id;
 
-  if (! batch_commands || ! batch_commands[0])
+  commands = gimp_batch_get_commands (batch_commands, batch_file);
+
+  if (! commands)
     return;
 
   exit_id = g_signal_connect_after (gimp, "exit",
@@ -80,7 +158,7 @@ gimp_batch_run (Gimp         *gimp,
   /*  script-fu text console, hardcoded for backward compatibility  */
 
   if (strcmp (batch_interpreter, "plug-in-script-fu-eval") == 0 &&
-      strcmp (batch_commands[0], "-") == 0)
+      strcmp (g_ptr_array_index (commands, 0), "-") == 0)
     {
       const gchar   *proc_name = "plug-in-script-fu-text-console";
       GimpProcedure *procedure = gimp_pdb_lookup_procedure (gimp->pdb,
@@ -98,13 +176,21 @@ gimp_batch_run (Gimp         *gimp,
       GimpProcedure *eval_proc = gimp_pdb_lookup_procedure (gimp->pdb,
                                                             batch_interpreter);
 
-      if (eval_proc)
+      if (eval_proc &&
+          GIMP_IS_PLUG_IN_PROCEDURE (eval_proc) &&
+          (n_jobs > 1 || timeout > 0))
+        {
+          gimp_batch_run_queue (gimp, eval_proc, commands,
+                                MAX (n_jobs, 1), MAX (timeout, 0));
+        }
+      else if (eval_proc)
         {
           gint i;
 
-          for (i = 0; batch_commands[i]; i++)
+          for (i = 0; i < commands->len; i++)
             gimp_batch_run_cmd (gimp, batch_interpreter, eval_proc,
-                                GIMP_RUN_NONINTERACTIVE, batch_commands[i]);
+                                GIMP_RUN_NONINTERACTIVE,
+                                g_ptr_array_index (commands, i));
         }
       else
         {
@@ -114,6 +200,8 @@ gimp_batch_run (Gimp         *gimp,
     }
 
   g_signal_handler_disconnect (gimp, exit_id);
+
+  g_ptr_array_free (commands, TRUE);
 }
 
 
@@ -134,17 +222,61 @@ gimp_batch_exit_after_callback (Gimp *gimp)
   exit (EXIT_SUCCESS);
 }
 
-static void
-gimp_batch_run_cmd (Gimp          *gimp,
-                    const gchar   *proc_name,
-                    GimpProcedure *procedure,
-                    GimpRunMode    run_mode,
-                    const gchar   *cmd)
+static GPtrArray *
+gimp_batch_get_commands (const gchar **batch_commands,
+                         const gchar  *batch_file)
+{
+  GPtrArray *commands = g_ptr_array_new_with_free_func (g_free);
+  gint       i;
+
+  for (i = 0; batch_commands && batch_commands[i]; i++)
+    g_ptr_array_add (commands, g_strdup (batch_commands[i]));
+
+  if (batch_file)
+    {
+      gchar  *contents;
+      GError *error = NULL;
+
+      if (g_file_get_contents (batch_file, &contents, NULL, &error))
+        {
+          gchar **lines = g_strsplit (contents, "\n", -1);
+
+          for (i = 0; lines[i]; i++)
+            {
+              gchar *line = g_strstrip (lines[i]);
+
+              if (*line && *line != '#')
+                g_ptr_array_add (commands, g_strdup (line));
+            }
+
+          g_strfreev (lines);
+          g_free (contents);
+        }
+      else
+        {
+          g_message (_("Could not read batch file '%s': %s"),
+                     gimp_filename_to_utf8 (batch_file), error->message);
+          g_clear_error (&error);
+        }
+    }
+
+  if (commands->len == 0)
+    {
+      g_ptr_array_free (commands, TRUE);
+
+      return NULL;
+    }
+
+  return commands;
+}
+
+static GimpValueArray *
+gimp_batch_get_arguments (GimpProcedure *procedure,
+                          GimpRunMode    run_mode,
+                          const gchar   *cmd)
 {
   GimpValueArray *args;
-  GimpValueArray *return_vals;
-  GError         *error = NULL;
-  gint            i     = 0;
+  gint            i = 0;
 
   args = gimp_procedure_get_arguments (procedure);
 
@@ -156,6 +288,22 @@ gimp_batch_run_cmd (Gimp          *gimp,
       GIMP_IS_PARAM_SPEC_STRING (procedure->args[i]))
     g_value_set_static_string (gimp_value_array_index (args, i++), cmd);
 
+  return args;
+}
+
+static void
+gimp_batch_run_cmd (Gimp          *gimp,
+                    const gchar   *proc_name,
+                    GimpProcedure *procedure,
+                    GimpRunMode    run_mode,
+                    const gchar   *cmd)
+{
+  GimpValueArray *args;
+  GimpValueArray *return_vals;
+  GError         *error = NULL;
+
+  args = gimp_batch_get_arguments (procedure, run_mode, cmd);
+
   return_vals =
     gimp_pdb_execute_procedure_by_name_args (gimp->pdb,
                                              gimp_get_user_context (gimp),
@@ -201,3 +349,171 @@ gimp_batch_run_cmd (Gimp          *gimp,
 
   return;
 }
+
+static void
+gimp_batch_run_queue (Gimp          *gimp,
+                      GimpProcedure *procedure,
+                      GPtrArray     *commands,
+                      gint           n_jobs,
+                      gint           timeout)
+{
+  GimpBatchQueue queue = { 0, };
+
+  queue.gimp      = gimp;
+  queue.procedure = GIMP_PLUG_IN_PROCEDURE (procedure);
+  queue.commands  = commands;
+  queue.n_jobs    = n_jobs;
+  queue.timeout   = timeout;
+  queue.loop      = g_main_loop_new (NULL, FALSE);
+
+  if (gimp->be_verbose)
+    g_print ("Running %d batch commands, %d at a time\n",
+             commands->len, n_jobs);
+
+  gimp_batch_queue_start_jobs (&queue);
+
+  /*  jobs which could not be started returned right away  */
+  if (queue.n_running > 0)
+    {
+      gimp_threads_leave (gimp);
+      g_main_loop_run (queue.loop);
+      gimp_threads_enter (gimp);
+    }
+
+  g_main_loop_unref (queue.loop);
+
+  g_printerr ("%d of %d batch commands executed successfully\n",
+              commands->len - queue.n_failed, commands->len);
+}
+
+static void
+gimp_batch_queue_start_jobs (GimpBatchQueue *queue)
+{
+  /*  gimp_plug_in_procedure_run_async() calls gimp_batch_job_return()
+   *  right away for jobs which can't be started, don't recurse then,
+   *  the loop below starts the next job
+   */
+  if (queue->starting)
+    return;
+
+  queue->starting = TRUE;
+
+  while (queue->n_running < queue->n_jobs &&
+         queue->next      < queue->commands->len)
+    {
+      GimpBatchJob   *job = g_slice_new0 (GimpBatchJob);
+      GimpValueArray *args;
+
+      job->queue   = queue;
+      job->index   = queue->next++;
+      job->timer   = g_timer_new ();
+
+      /*  a context of its own, so that context changes of a job don't
+       *  leak into the jobs running at the same time
+       */
+      job->context = gimp_context_new (queue->gimp, "Batch Job",
+                                       gimp_get_user_context (queue->gimp));
+
+      queue->n_running++;
+
+      if (queue->timeout > 0)
+        job->timeout_id =
+          g_timeout_add_seconds (queue->timeout,
+                                 (GSourceFunc) gimp_batch_job_timeout,
+                                 job);
+
+      args = gimp_batch_get_arguments (GIMP_PROCEDURE (queue->procedure),
+                                       GIMP_RUN_NONINTERACTIVE,
+                                       g_ptr_array_index (queue->commands,
+                                                          job->index));
+
+      /*  each job runs in its own interpreter process, sharing the
+       *  core's images and data
+       */
+      gimp_plug_in_procedure_run_async (queue->procedure, queue->gimp,
+                                        job->context,
+                                        NULL, args,
+                                        gimp_batch_job_return, job);
+
+      gimp_value_array_unref (args);
+    }
+
+  queue->starting = FALSE;
+}
+
+static void
+gimp_batch_job_return (GimpValueArray *return_vals,
+                       gpointer        data)
+{
+  GimpBatchJob      *job   = data;
+  GimpBatchQueue    *queue = job->queue;
+  GimpPDBStatusType  status;
+  const gchar       *message = NULL;
+
+  status = g_value_get_enum (gimp_value_array_index (return_vals, 0));
+
+  if (status != GIMP_PDB_SUCCESS                &&
+      gimp_value_array_length (return_vals) > 1 &&
+      G_VALUE_HOLDS_STRING (gimp_value_array_index (return_vals, 1)))
+    {
+      message = g_value_get_string (gimp_value_array_index (return_vals, 1));
+    }
+
+  if (job->timed_out)
+    {
+      g_printerr ("batch job %d timed out after %d seconds\n",
+                  job->index + 1, queue->timeout);
+    }
+  else
+    {
+      switch (status)
+        {
+        case GIMP_PDB_SUCCESS:
+          g_printerr ("batch job %d executed successfully (%.2f seconds)\n",
+                      job->index + 1, g_timer_elapsed (job->timer, NULL));
+          break;
+
+        case GIMP_PDB_CALLING_ERROR:
+          g_printerr ("batch job %d experienced a calling error%s%s\n",
+                      job->index + 1,
+                      message ? ":\n" : "", message ? message : "");
+          break;
+
+        default:
+          g_printerr ("batch job %d experienced an execution error%s%s\n",
+                      job->index + 1,
+                      message ? ":\n" : "", message ? message : "");
+          break;
+        }
+    }
+
+  if (status != GIMP_PDB_SUCCESS || job->timed_out)
+    queue->n_failed++;
+
+  if (job->timeout_id)
+    g_source_remove (job->timeout_id);
+
+  g_object_unref (job->context);
+  g_timer_destroy (job->timer);
+  g_slice_free (GimpBatchJob, job);
+
+  queue->n_running--;
+
+  gimp_batch_queue_start_jobs (queue);
+
+  if (queue->n_running == 0 && ! queue->starting)
+    g_main_loop_quit (queue->loop);
+}
+
+static gboolean
+gimp_batch_job_timeout (GimpBatchJob *job)
+{
+  job->timeout_id = 0;
+  job->timed_out  = TRUE;
+
+  /*  calls gimp_batch_job_return() with an execution error  */
+  gimp_plug_in_manager_abort_async (job->queue->gimp->plug_in_manager,
+                                    gimp_batch_job_return, job);
+
+  return G_SOURCE_REMOVE;
+}
@@ -21,7 +21,10 @@
 
 void   gimp_batch_run (Gimp         *gimp,
                        const gchar  *batch_interpreter,
-                       const gchar **batch_commands);
+                       const gchar **batch_commands,
+                       const gchar  *batch_file,
+                       gint          n_jobs,
+                       gint          timeout);
 
 
 #endif /* __GIMP_BATCH_H__ */
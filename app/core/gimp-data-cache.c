@@ -0,0 +1,422 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimp-data-cache.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gegl.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "core-types.h"
+
+#include "gimp-data-cache.h"
+#include "gimpdata.h"
+
+
+/*  The data cache of a directory in a data path remembers what
+ *  loading each of its data files produced, as far as the data types
+ *  support it, see gimp_data_get_cache_state().  Entries are only used
+ *  while the file's mtime and size are unchanged, so data files which
+ *  were edited, replaced or added are parsed again and the cache is
+ *  rewritten after loading.
+ *
+ *  The cache is a serialized GVariant in the user's GIMP directory,
+ *  with the type name of the cached data and a checksum of the
+ *  directory's URI as file name.  It contains a header and one entry
+ *  per data file: the file's path relative to the directory, its mtime
+ *  and size, and the type, name, mime type and cache state of all data
+ *  objects in the file.
+ *
+ *  GVariant data is stored in host byte order, a cache written on a
+ *  machine with different byte order is rejected like one with a
+ *  different version.
+ */
+
+#define GIMP_DATA_CACHE_DIR        "data-cache"
+
+#define GIMP_DATA_CACHE_MAGIC      "GIMP data cache"
+#define GIMP_DATA_CACHE_VERSION    1
+#define GIMP_DATA_CACHE_BYTE_ORDER 0x01020304
+
+#define GIMP_DATA_CACHE_DATA_TYPE  "a(sssv)"
+#define GIMP_DATA_CACHE_ENTRY_TYPE "(sxt" GIMP_DATA_CACHE_DATA_TYPE ")"
+#define GIMP_DATA_CACHE_TYPE       "(suua" GIMP_DATA_CACHE_ENTRY_TYPE ")"
+
+
+struct _GimpDataCache
+{
+  GType            data_type;
+  GFile           *directory;
+  GFile           *file;
+
+  /*  what was read from the cache file, and its entries by path  */
+  GVariant        *contents;
+  GHashTable      *entries;
+
+  /*  the entries written by gimp_data_cache_save()  */
+  GVariantBuilder  builder;
+  gint             n_added;
+};
+
+
+static void   gimp_data_cache_read (GimpDataCache *cache);
+
+
+/*  public functions  */
+
+GimpDataCache *
+gimp_data_cache_new (GType  data_type,
+                     GFile *directory)
+{
+  GimpDataCache *cache;
+  gchar         *uri;
+  gchar         *checksum;
+  gchar         *type_name;
+  gchar         *basename;
+
+  g_return_val_if_fail (g_type_is_a (data_type, GIMP_TYPE_DATA), NULL);
+  g_return_val_if_fail (G_IS_FILE (directory), NULL);
+
+  cache = g_slice_new0 (GimpDataCache);
+
+  uri       = g_file_get_uri (directory);
+  checksum  = g_compute_checksum_for_string (G_CHECKSUM_MD5, uri, -1);
+  type_name = g_ascii_strdown (g_type_name (data_type), -1);
+  basename  = g_strdup_printf ("%s-%s", type_name, checksum);
+
+  cache->data_type = data_type;
+  cache->directory = g_object_ref (directory);
+  cache->file      = gimp_directory_file (GIMP_DATA_CACHE_DIR, basename, NULL);
+  cache->entries   = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                            NULL,
+                                            (GDestroyNotify) g_variant_unref);
+
+  g_variant_builder_init (&cache->builder,
+                          G_VARIANT_TYPE ("a" GIMP_DATA_CACHE_ENTRY_TYPE));
+
+  g_free (basename);
+  g_free (type_name);
+  g_free (checksum);
+  g_free (uri);
+
+  gimp_data_cache_read (cache);
+
+  return cache;
+}
+
+void
+gimp_data_cache_free (GimpDataCache *cache)
+{
+  g_return_if_fail (cache != NULL);
+
+  g_variant_builder_clear (&cache->builder);
+
+  g_hash_table_unref (cache->entries);
+  g_clear_pointer (&cache->contents, g_variant_unref);
+
+  g_object_unref (cache->file);
+  g_object_unref (cache->directory);
+
+  g_slice_free (GimpDataCache, cache);
+}
+
+/**
+ * gimp_data_cache_lookup:
+ * @cache: a #GimpDataCache
+ * @file:  a data file in the cache's directory
+ * @mtime: the modification time of @file
+ * @size:  the size of @file
+ *
+ * Restores the data objects of @file from @cache if the cache has an
+ * entry for it with the same @mtime and @size.  The objects still need
+ * gimp_data_set_file() and friends, like freshly loaded ones.
+ *
+ * This function can be called from any thread.
+ *
+ * Returns: the list of new data objects, or %NULL.
+ **/
+GList *
+gimp_data_cache_lookup (GimpDataCache *cache,
+                        GFile         *file,
+                        gint64         mtime,
+                        guint64        size)
+{
+  GVariant     *entry;
+  GVariantIter *iter;
+  GList        *data_list = NULL;
+  const gchar  *type_name;
+  const gchar  *name;
+  const gchar  *mime_type;
+  GVariant     *state;
+  gchar        *path;
+  gint64        entry_mtime;
+  guint64       entry_size;
+
+  g_return_val_if_fail (cache != NULL, NULL);
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+
+  path = g_file_get_relative_path (cache->directory, file);
+
+  if (! path)
+    return NULL;
+
+  entry = g_hash_table_lookup (cache->entries, path);
+
+  g_free (path);
+
+  if (! entry)
+    return NULL;
+
+  g_variant_get (entry, GIMP_DATA_CACHE_ENTRY_TYPE,
+                 NULL, &entry_mtime, &entry_size, &iter);
+
+  if (entry_mtime != mtime || entry_size != size)
+    {
+      g_variant_iter_free (iter);
+
+      return NULL;
+    }
+
+  while (g_variant_iter_next (iter, "(&s&s&sv)",
+                              &type_name, &name, &mime_type, &state))
+    {
+      GType     type = g_type_from_name (type_name);
+      GimpData *data;
+
+      if (! g_type_is_a (type, cache->data_type) || G_TYPE_IS_ABSTRACT (type))
+        {
+          g_variant_unref (state);
+          goto error;
+        }
+
+      data = g_object_new (type,
+                           "name",      name,
+                           "mime-type", *mime_type ? mime_type : NULL,
+                           NULL);
+
+      data_list = g_list_prepend (data_list, data);
+
+      if (! gimp_data_set_cache_state (data, state))
+        {
+          g_variant_unref (state);
+          goto error;
+        }
+
+      g_variant_unref (state);
+    }
+
+  g_variant_iter_free (iter);
+
+  return g_list_reverse (data_list);
+
+ error:
+  g_variant_iter_free (iter);
+
+  g_list_free_full (data_list, (GDestroyNotify) g_object_unref);
+
+  return NULL;
+}
+
+/**
+ * gimp_data_cache_add:
+ * @cache:     a #GimpDataCache
+ * @file:      a data file in the cache's directory
+ * @mtime:     the modification time of @file
+ * @size:      the size of @file
+ * @data_list: the data objects loaded from @file
+ *
+ * Adds @data_list to the entries the next gimp_data_cache_save() will
+ * write.  Files containing data which doesn't support the cache are
+ * left out, and loaded from the file each time.
+ **/
+void
+gimp_data_cache_add (GimpDataCache *cache,
+                     GFile         *file,
+                     gint64         mtime,
+                     guint64        size,
+                     GList         *data_list)
+{
+  GVariantBuilder  builder;
+  GList           *list;
+  gchar           *path;
+
+  g_return_if_fail (cache != NULL);
+  g_return_if_fail (G_IS_FILE (file));
+
+  if (! data_list)
+    return;
+
+  path = g_file_get_relative_path (cache->directory, file);
+
+  if (! path)
+    return;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE (GIMP_DATA_CACHE_DATA_TYPE));
+
+  for (list = data_list; list; list = g_list_next (list))
+    {
+      GimpData    *data  = list->data;
+      GVariant    *state = gimp_data_get_cache_state (data);
+      const gchar *name;
+      const gchar *mime_type;
+
+      if (! state)
+        {
+          g_variant_builder_clear (&builder);
+          g_free (path);
+
+          return;
+        }
+
+      name      = gimp_object_get_name (data);
+      mime_type = gimp_data_get_mime_type (data);
+
+      g_variant_builder_add (&builder, "(sssv)",
+                             G_OBJECT_TYPE_NAME (data),
+                             name      ? name      : "",
+                             mime_type ? mime_type : "",
+                             state);
+    }
+
+  g_variant_builder_add (&cache->builder, "(sxt@" GIMP_DATA_CACHE_DATA_TYPE ")",
+                         path, mtime, size,
+                         g_variant_builder_end (&builder));
+
+  cache->n_added++;
+
+  g_free (path);
+}
+
+/**
+ * gimp_data_cache_save:
+ * @cache: a #GimpDataCache
+ * @error: return location for a #GError
+ *
+ * Replaces the cache file by the entries added with
+ * gimp_data_cache_add(), unless they are the same as the ones which
+ * were read.  Data restored by gimp_data_cache_lookup() doesn't
+ * depend on the cache file any longer when this function returns.
+ *
+ * Returns: %FALSE if the cache file could not be written.
+ **/
+gboolean
+gimp_data_cache_save (GimpDataCache  *cache,
+                      GError        **error)
+{
+  GVariant *contents;
+  gboolean  success = TRUE;
+
+  g_return_val_if_fail (cache != NULL, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  contents = g_variant_new ("(suu@a" GIMP_DATA_CACHE_ENTRY_TYPE ")",
+                            GIMP_DATA_CACHE_MAGIC,
+                            GIMP_DATA_CACHE_BYTE_ORDER,
+                            GIMP_DATA_CACHE_VERSION,
+                            g_variant_builder_end (&cache->builder));
+  g_variant_ref_sink (contents);
+
+  g_variant_builder_init (&cache->builder,
+                          G_VARIANT_TYPE ("a" GIMP_DATA_CACHE_ENTRY_TYPE));
+
+  if (cache->contents ?
+      ! g_variant_equal (cache->contents, contents) :
+      cache->n_added > 0)
+    {
+      GFile *dir = g_file_get_parent (cache->file);
+
+      /*  release the old contents before replacing the file  */
+      g_hash_table_remove_all (cache->entries);
+      g_clear_pointer (&cache->contents, g_variant_unref);
+
+      /*  errors are reported by g_file_replace_contents() below  */
+      g_file_make_directory_with_parents (dir, NULL, NULL);
+      g_object_unref (dir);
+
+      success = g_file_replace_contents (cache->file,
+                                         g_variant_get_data (contents),
+                                         g_variant_get_size (contents),
+                                         NULL, FALSE, G_FILE_CREATE_NONE,
+                                         NULL, NULL, error);
+    }
+
+  g_variant_unref (contents);
+
+  cache->n_added = 0;
+
+  return success;
+}
+
+
+/*  private functions  */
+
+static void
+gimp_data_cache_read (GimpDataCache *cache)
+{
+  GBytes       *bytes;
+  GVariant     *entries;
+  GVariant     *entry;
+  GVariantIter  iter;
+  const gchar  *magic;
+  gchar        *data;
+  gsize         length;
+  guint32       byte_order;
+  guint32       version;
+
+  if (! g_file_load_contents (cache->file, NULL, &data, &length, NULL, NULL))
+    return;
+
+  bytes = g_bytes_new_take (data, length);
+
+  cache->contents = g_variant_new_from_bytes (G_VARIANT_TYPE (GIMP_DATA_CACHE_TYPE),
+                                              bytes, FALSE);
+  g_variant_ref_sink (cache->contents);
+
+  g_bytes_unref (bytes);
+
+  g_variant_get (cache->contents, "(&suu@a" GIMP_DATA_CACHE_ENTRY_TYPE ")",
+                 &magic, &byte_order, &version, &entries);
+
+  if (strcmp (magic, GIMP_DATA_CACHE_MAGIC)    ||
+      byte_order != GIMP_DATA_CACHE_BYTE_ORDER ||
+      version    != GIMP_DATA_CACHE_VERSION)
+    {
+      g_variant_unref (entries);
+      g_clear_pointer (&cache->contents, g_variant_unref);
+
+      return;
+    }
+
+  g_variant_iter_init (&iter, entries);
+
+  while ((entry = g_variant_iter_next_value (&iter)))
+    {
+      const gchar *path;
+
+      g_variant_get_child (entry, 0, "&s", &path);
+
+      /*  the path points into cache->contents  */
+      g_hash_table_insert (cache->entries, (gpointer) path, entry);
+    }
+
+  g_variant_unref (entries);
+}
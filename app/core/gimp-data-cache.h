@@ -0,0 +1,42 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimp-data-cache.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_DATA_CACHE_H__
+#define __GIMP_DATA_CACHE_H__
+
+
+GimpDataCache * gimp_data_cache_new    (GType           data_type,
+                                        GFile          *directory);
+void            gimp_data_cache_free   (GimpDataCache  *cache);
+
+GList         * gimp_data_cache_lookup (GimpDataCache  *cache,
+                                        GFile          *file,
+                                        gint64          mtime,
+                                        guint64         size);
+void            gimp_data_cache_add    (GimpDataCache  *cache,
+                                        GFile          *file,
+                                        gint64          mtime,
+                                        guint64         size,
+                                        GList          *data_list);
+
+gboolean        gimp_data_cache_save   (GimpDataCache  *cache,
+                                        GError        **error);
+
+
+#endif /* __GIMP_DATA_CACHE_H__ */
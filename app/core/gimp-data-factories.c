@@ -62,44 +62,44 @@ gimp_data_factories_init (Gimp *gimp)
 {
   static const GimpDataFactoryLoaderEntry brush_loader_entries[] =
   {
-    { gimp_brush_load,           GIMP_BRUSH_FILE_EXTENSION,           FALSE },
-    { gimp_brush_load,           GIMP_BRUSH_PIXMAP_FILE_EXTENSION,    FALSE },
-    { gimp_brush_load_abr,       GIMP_BRUSH_PS_FILE_EXTENSION,        FALSE },
-    { gimp_brush_load_abr,       GIMP_BRUSH_PSP_FILE_EXTENSION,       FALSE },
-    { gimp_brush_generated_load, GIMP_BRUSH_GENERATED_FILE_EXTENSION, TRUE  },
-    { gimp_brush_pipe_load,      GIMP_BRUSH_PIPE_FILE_EXTENSION,      FALSE }
+    { gimp_brush_load,           GIMP_BRUSH_FILE_EXTENSION,           FALSE, TRUE  },
+    { gimp_brush_load,           GIMP_BRUSH_PIXMAP_FILE_EXTENSION,    FALSE, TRUE  },
+    { gimp_brush_load_abr,       GIMP_BRUSH_PS_FILE_EXTENSION,        FALSE, TRUE  },
+    { gimp_brush_load_abr,       GIMP_BRUSH_PSP_FILE_EXTENSION,       FALSE, TRUE  },
+    { gimp_brush_generated_load, GIMP_BRUSH_GENERATED_FILE_EXTENSION, TRUE,  TRUE  },
+    { gimp_brush_pipe_load,      GIMP_BRUSH_PIPE_FILE_EXTENSION,      FALSE, TRUE  }
   };
 
   static const GimpDataFactoryLoaderEntry dynamics_loader_entries[] =
   {
-    { gimp_dynamics_load,        GIMP_DYNAMICS_FILE_EXTENSION,        TRUE  }
+    { gimp_dynamics_load,        GIMP_DYNAMICS_FILE_EXTENSION,        TRUE,  FALSE }
   };
 
   static const GimpDataFactoryLoaderEntry mybrush_loader_entries[] =
   {
-    { gimp_mybrush_load,         GIMP_MYBRUSH_FILE_EXTENSION,         FALSE }
+    { gimp_mybrush_load,         GIMP_MYBRUSH_FILE_EXTENSION,         FALSE, TRUE  }
   };
 
   static const GimpDataFactoryLoaderEntry pattern_loader_entries[] =
   {
-    { gimp_pattern_load,         GIMP_PATTERN_FILE_EXTENSION,         FALSE },
-    { gimp_pattern_load_pixbuf,  NULL /* fallback loader */,          FALSE }
+    { gimp_pattern_load,         GIMP_PATTERN_FILE_EXTENSION,         FALSE, TRUE  },
+    { gimp_pattern_load_pixbuf,  NULL /* fallback loader */,          FALSE, TRUE  }
   };
 
   static const GimpDataFactoryLoaderEntry gradient_loader_entries[] =
   {
-    { gimp_gradient_load,        GIMP_GRADIENT_FILE_EXTENSION,        TRUE  },
-    { gimp_gradient_load_svg,    GIMP_GRADIENT_SVG_FILE_EXTENSION,    FALSE }
+    { gimp_gradient_load,        GIMP_GRADIENT_FILE_EXTENSION,        TRUE,  TRUE  },
+    { gimp_gradient_load_svg,    GIMP_GRADIENT_SVG_FILE_EXTENSION,    FALSE, TRUE  }
   };
 
   static const GimpDataFactoryLoaderEntry palette_loader_entries[] =
   {
-    { gimp_palette_load,         GIMP_PALETTE_FILE_EXTENSION,         TRUE  }
+    { gimp_palette_load,         GIMP_PALETTE_FILE_EXTENSION,         TRUE,  TRUE  }
   };
 
   static const GimpDataFactoryLoaderEntry tool_preset_loader_entries[] =
   {
-    { gimp_tool_preset_load,     GIMP_TOOL_PRESET_FILE_EXTENSION,     TRUE  }
+    { gimp_tool_preset_load,     GIMP_TOOL_PRESET_FILE_EXTENSION,     TRUE,  FALSE }
   };
 
   g_return_if_fail (GIMP_IS_GIMP (gimp));
@@ -542,8 +542,6 @@ find_empty_segs (const GeglRectangle *region,
 
   endx = end;
 
-  line_data += start;
-
   for (x = start; x < end;)
     {
       if (type == GIMP_BOUNDARY_IGNORE_BOUNDS && (endx > x1 || x < x2))
@@ -688,25 +686,32 @@ generate_boundary (GeglBuffer          *buffer,
 
   boundary = gimp_boundary_new (region);
 
-  line_rect.width  = gegl_buffer_get_width (buffer);
-  line_rect.height = 1;
-
-  line_data = g_alloca (sizeof (gfloat) * line_rect.width);
-
   start = 0;
   end   = 0;
 
+  /*  only fetch the part of each scanline find_empty_segs() looks at  */
   if (type == GIMP_BOUNDARY_WITHIN_BOUNDS)
     {
       start = y1;
       end   = y2;
+
+      line_rect.x     = x1;
+      line_rect.width = x2 - x1;
     }
   else if (type == GIMP_BOUNDARY_IGNORE_BOUNDS)
     {
       start = region->y;
       end   = region->y + region->height;
+
+      line_rect.x     = region->x;
+      line_rect.width = region->width;
     }
 
+  line_rect.width  = MAX (line_rect.width, 0);
+  line_rect.height = 1;
+
+  line_data = g_alloca (sizeof (gfloat) * MAX (line_rect.width, 1));
+
   /*  Find the empty segments for the previous and current scanlines  */
   find_empty_segs (region, NULL,
                    start - 1, boundary->empty_segs_l,
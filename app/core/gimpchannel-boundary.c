@@ -0,0 +1,469 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gegl.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "core-types.h"
+
+#include "gegl/gimp-gegl-parallel.h"
+
+#include "gimpboundary.h"
+#include "gimpchannel.h"
+#include "gimpchannel-boundary.h"
+
+
+/*  The boundary of a channel is cached in tiles of TILE_SIZE x TILE_SIZE
+ *  pixels.  A tile owns the boundary segments along the pixel edges on
+ *  its top and left sides and inside it, the tiles at the bottom and
+ *  right also own the channel's bottom and right edges.  Since those
+ *  segments only depend on the tile and a one pixel border around it,
+ *  changing the channel only requires re-tracing the tiles around the
+ *  changed area.  Segments cut at tile borders still meet end to end,
+ *  so gimp_boundary_sort() chains them like before.
+ */
+
+#define TILE_SIZE 256
+
+
+typedef struct
+{
+  gboolean      valid;
+  GimpBoundSeg *segs_in;
+  GimpBoundSeg *segs_out;
+  gint          num_segs_in;
+  gint          num_segs_out;
+} BoundaryTile;
+
+struct _GimpChannelBoundaryTiles
+{
+  gint          width;
+  gint          height;
+  gint          n_cols;
+  gint          n_rows;
+
+  /*  the bounds the segments were found for  */
+  gint          x1, y1;
+  gint          x2, y2;
+
+  BoundaryTile *tiles;
+};
+
+typedef struct
+{
+  GimpChannelBoundaryTiles *tiles;
+  GeglBuffer               *buffer;
+  const Babl               *format;
+  gint                     *dirty;
+  gint                      n_dirty;
+  gint                      next;
+} BoundaryTrace;
+
+
+/*  local function prototypes  */
+
+static GimpChannelBoundaryTiles * boundary_tiles_new   (gint                      width,
+                                                        gint                      height);
+static void                       boundary_tiles_clear (GimpChannelBoundaryTiles *tiles,
+                                                        gint                      col1,
+                                                        gint                      row1,
+                                                        gint                      col2,
+                                                        gint                      row2);
+
+static void   boundary_tile_get_area (GimpChannelBoundaryTiles *tiles,
+                                      gint                      index,
+                                      GeglRectangle            *area);
+static void   boundary_tile_clip     (GimpChannelBoundaryTiles *tiles,
+                                      const GeglRectangle      *area,
+                                      GimpBoundSeg            **segs,
+                                      gint                     *num_segs);
+static void   boundary_tile_trace    (BoundaryTrace            *trace,
+                                      gint                      index);
+static void   boundary_trace_func    (gint                      i,
+                                      gint                      n,
+                                      BoundaryTrace            *trace);
+
+static GimpBoundSeg * boundary_tiles_collect (GimpChannelBoundaryTiles *tiles,
+                                              gboolean                  in,
+                                              gint                     *num_segs);
+
+
+/*  public functions  */
+
+void
+gimp_channel_boundary_tiles_free (GimpChannelBoundaryTiles *tiles)
+{
+  g_return_if_fail (tiles != NULL);
+
+  boundary_tiles_clear (tiles, 0, 0, tiles->n_cols, tiles->n_rows);
+
+  g_free (tiles->tiles);
+
+  g_slice_free (GimpChannelBoundaryTiles, tiles);
+}
+
+void
+gimp_channel_boundary_tiles_invalidate (GimpChannel         *channel,
+                                        const GeglRectangle *area)
+{
+  GimpChannelBoundaryTiles *tiles;
+  gint                      x1, y1;
+  gint                      x2, y2;
+
+  g_return_if_fail (GIMP_IS_CHANNEL (channel));
+
+  tiles = channel->boundary_tiles;
+
+  if (! tiles)
+    return;
+
+  if (! area)
+    {
+      boundary_tiles_clear (tiles, 0, 0, tiles->n_cols, tiles->n_rows);
+      return;
+    }
+
+  /*  a pixel also affects the edges to its right and bottom, which
+   *  may belong to the next tile
+   */
+  x1 = MAX (area->x - 1, 0);
+  y1 = MAX (area->y - 1, 0);
+  x2 = MIN (area->x + area->width  + 1, tiles->width);
+  y2 = MIN (area->y + area->height + 1, tiles->height);
+
+  if (x2 <= x1 || y2 <= y1)
+    return;
+
+  boundary_tiles_clear (tiles,
+                        x1 / TILE_SIZE,           y1 / TILE_SIZE,
+                        (x2 - 1) / TILE_SIZE + 1, (y2 - 1) / TILE_SIZE + 1);
+}
+
+void
+gimp_channel_boundary_tiles_find (GimpChannel *channel,
+                                  gint         x1,
+                                  gint         y1,
+                                  gint         x2,
+                                  gint         y2)
+{
+  GimpChannelBoundaryTiles *tiles;
+  BoundaryTrace             trace;
+  gint                      width;
+  gint                      height;
+  gint                      bx, by, bw, bh;
+  gboolean                  empty;
+  gint                      i;
+
+  g_return_if_fail (GIMP_IS_CHANNEL (channel));
+
+  width  = gimp_item_get_width  (GIMP_ITEM (channel));
+  height = gimp_item_get_height (GIMP_ITEM (channel));
+
+  tiles = channel->boundary_tiles;
+
+  if (tiles && (tiles->width != width || tiles->height != height))
+    {
+      gimp_channel_boundary_tiles_free (tiles);
+      tiles = NULL;
+    }
+
+  if (! tiles)
+    {
+      tiles = boundary_tiles_new (width, height);
+      channel->boundary_tiles = tiles;
+    }
+
+  if (x1 != tiles->x1 || y1 != tiles->y1 ||
+      x2 != tiles->x2 || y2 != tiles->y2)
+    {
+      boundary_tiles_clear (tiles, 0, 0, tiles->n_cols, tiles->n_rows);
+
+      tiles->x1 = x1;
+      tiles->y1 = y1;
+      tiles->x2 = x2;
+      tiles->y2 = y2;
+    }
+
+  empty = ! gimp_item_bounds (GIMP_ITEM (channel), &bx, &by, &bw, &bh);
+
+  trace.tiles   = tiles;
+  trace.buffer  = gimp_drawable_get_buffer (GIMP_DRAWABLE (channel));
+  trace.format  = babl_format ("Y float");
+  trace.dirty   = g_new (gint, tiles->n_cols * tiles->n_rows);
+  trace.n_dirty = 0;
+  trace.next    = 0;
+
+  for (i = 0; i < tiles->n_cols * tiles->n_rows; i++)
+    {
+      BoundaryTile  *tile = &tiles->tiles[i];
+      GeglRectangle  area;
+
+      if (tile->valid)
+        continue;
+
+      boundary_tile_get_area (tiles, i, &area);
+
+      /*  tiles which don't touch the channel's bounds have no boundary  */
+      if (empty ||
+          ! gegl_rectangle_intersect (NULL,
+                                      GEGL_RECTANGLE (area.x - 1,
+                                                      area.y - 1,
+                                                      area.width  + 1,
+                                                      area.height + 1),
+                                      GEGL_RECTANGLE (bx, by, bw, bh)))
+        {
+          tile->valid = TRUE;
+          continue;
+        }
+
+      trace.dirty[trace.n_dirty++] = i;
+    }
+
+  if (trace.n_dirty > 0)
+    {
+      gimp_gegl_parallel_distribute (trace.n_dirty,
+                                     (GimpGeglParallelDistributeFunc)
+                                     boundary_trace_func,
+                                     &trace);
+    }
+
+  g_free (trace.dirty);
+
+  channel->segs_in  = boundary_tiles_collect (tiles, TRUE,
+                                              &channel->num_segs_in);
+  channel->segs_out = boundary_tiles_collect (tiles, FALSE,
+                                              &channel->num_segs_out);
+}
+
+
+/*  private functions  */
+
+static GimpChannelBoundaryTiles *
+boundary_tiles_new (gint width,
+                    gint height)
+{
+  GimpChannelBoundaryTiles *tiles = g_slice_new0 (GimpChannelBoundaryTiles);
+
+  tiles->width  = width;
+  tiles->height = height;
+  tiles->n_cols = (width  + TILE_SIZE - 1) / TILE_SIZE;
+  tiles->n_rows = (height + TILE_SIZE - 1) / TILE_SIZE;
+  tiles->tiles  = g_new0 (BoundaryTile, tiles->n_cols * tiles->n_rows);
+
+  return tiles;
+}
+
+static void
+boundary_tiles_clear (GimpChannelBoundaryTiles *tiles,
+                      gint                      col1,
+                      gint                      row1,
+                      gint                      col2,
+                      gint                      row2)
+{
+  gint col, row;
+
+  for (row = row1; row < MIN (row2, tiles->n_rows); row++)
+    for (col = col1; col < MIN (col2, tiles->n_cols); col++)
+      {
+        BoundaryTile *tile = &tiles->tiles[row * tiles->n_cols + col];
+
+        g_clear_pointer (&tile->segs_in,  g_free);
+        g_clear_pointer (&tile->segs_out, g_free);
+
+        tile->num_segs_in  = 0;
+        tile->num_segs_out = 0;
+        tile->valid        = FALSE;
+      }
+}
+
+static void
+boundary_tile_get_area (GimpChannelBoundaryTiles *tiles,
+                        gint                      index,
+                        GeglRectangle            *area)
+{
+  area->x      = (index % tiles->n_cols) * TILE_SIZE;
+  area->y      = (index / tiles->n_cols) * TILE_SIZE;
+  area->width  = MIN (TILE_SIZE, tiles->width  - area->x);
+  area->height = MIN (TILE_SIZE, tiles->height - area->y);
+}
+
+/*  drops the segments which don't belong to the tile at area and cuts
+ *  the others to its extents
+ */
+static void
+boundary_tile_clip (GimpChannelBoundaryTiles *tiles,
+                    const GeglRectangle      *area,
+                    GimpBoundSeg            **segs,
+                    gint                     *num_segs)
+{
+  GimpBoundSeg *s     = *segs;
+  gint          right = area->x + area->width;
+  gint          lower = area->y + area->height;
+  gint          last_x;
+  gint          last_y;
+  gint          n     = 0;
+  gint          i;
+
+  /*  the last edges the tile owns  */
+  last_x = (right < tiles->width)  ? right - 1 : right;
+  last_y = (lower < tiles->height) ? lower - 1 : lower;
+
+  for (i = 0; i < *num_segs; i++)
+    {
+      GimpBoundSeg seg = s[i];
+
+      if (seg.y1 == seg.y2)
+        {
+          if (seg.y1 < area->y || seg.y1 > last_y)
+            continue;
+
+          seg.x1 = CLAMP (seg.x1, area->x, right);
+          seg.x2 = CLAMP (seg.x2, area->x, right);
+
+          if (seg.x1 == seg.x2)
+            continue;
+        }
+      else
+        {
+          if (seg.x1 < area->x || seg.x1 > last_x)
+            continue;
+
+          seg.y1 = CLAMP (seg.y1, area->y, lower);
+          seg.y2 = CLAMP (seg.y2, area->y, lower);
+
+          if (seg.y1 == seg.y2)
+            continue;
+        }
+
+      s[n++] = seg;
+    }
+
+  if (n == 0)
+    g_clear_pointer (segs, g_free);
+
+  *num_segs = n;
+}
+
+static void
+boundary_tile_trace (BoundaryTrace *trace,
+                     gint           index)
+{
+  GimpChannelBoundaryTiles *tiles = trace->tiles;
+  BoundaryTile             *tile  = &tiles->tiles[index];
+  GeglRectangle             area;
+  GeglRectangle             region;
+  GeglRectangle             within;
+
+  boundary_tile_get_area (tiles, index, &area);
+
+  gegl_rectangle_intersect (&region,
+                            GEGL_RECTANGLE (area.x - 1,
+                                            area.y - 1,
+                                            area.width  + 2,
+                                            area.height + 2),
+                            GEGL_RECTANGLE (0, 0,
+                                            tiles->width, tiles->height));
+
+  tile->segs_out = gimp_boundary_find (trace->buffer, &region,
+                                       trace->format,
+                                       GIMP_BOUNDARY_IGNORE_BOUNDS,
+                                       tiles->x1, tiles->y1,
+                                       tiles->x2, tiles->y2,
+                                       GIMP_BOUNDARY_HALF_WAY,
+                                       &tile->num_segs_out);
+
+  boundary_tile_clip (tiles, &area, &tile->segs_out, &tile->num_segs_out);
+
+  if (gegl_rectangle_intersect (&within, &region,
+                                GEGL_RECTANGLE (tiles->x1, tiles->y1,
+                                                tiles->x2 - tiles->x1,
+                                                tiles->y2 - tiles->y1)))
+    {
+      tile->segs_in = gimp_boundary_find (trace->buffer, &region,
+                                          trace->format,
+                                          GIMP_BOUNDARY_WITHIN_BOUNDS,
+                                          within.x,
+                                          within.y,
+                                          within.x + within.width,
+                                          within.y + within.height,
+                                          GIMP_BOUNDARY_HALF_WAY,
+                                          &tile->num_segs_in);
+
+      boundary_tile_clip (tiles, &area, &tile->segs_in, &tile->num_segs_in);
+    }
+
+  tile->valid = TRUE;
+}
+
+static void
+boundary_trace_func (gint           i,
+                     gint           n,
+                     BoundaryTrace *trace)
+{
+  gint index;
+
+  while ((index = g_atomic_int_add (&trace->next, 1)) < trace->n_dirty)
+    boundary_tile_trace (trace, trace->dirty[index]);
+}
+
+static GimpBoundSeg *
+boundary_tiles_collect (GimpChannelBoundaryTiles *tiles,
+                        gboolean                  in,
+                        gint                     *num_segs)
+{
+  GimpBoundSeg *segs;
+  gint          n_tiles = tiles->n_cols * tiles->n_rows;
+  gint          n       = 0;
+  gint          i;
+
+  for (i = 0; i < n_tiles; i++)
+    n += in ? tiles->tiles[i].num_segs_in : tiles->tiles[i].num_segs_out;
+
+  *num_segs = n;
+
+  if (n == 0)
+    return NULL;
+
+  segs = g_new (GimpBoundSeg, n);
+  n    = 0;
+
+  for (i = 0; i < n_tiles; i++)
+    {
+      BoundaryTile *tile = &tiles->tiles[i];
+
+      if (in && tile->num_segs_in)
+        {
+          memcpy (segs + n, tile->segs_in,
+                  tile->num_segs_in * sizeof (GimpBoundSeg));
+          n += tile->num_segs_in;
+        }
+      else if (! in && tile->num_segs_out)
+        {
+          memcpy (segs + n, tile->segs_out,
+                  tile->num_segs_out * sizeof (GimpBoundSeg));
+          n += tile->num_segs_out;
+        }
+    }
+
+  return segs;
+}
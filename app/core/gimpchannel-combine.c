@@ -31,6 +31,7 @@
 
 #include "gimpchannel.h"
 #include "gimpchannel-combine.h"
+#include "gimpchannel-summary.h"
 
 
 void
@@ -68,7 +69,8 @@ gimp_channel_combine_rect (GimpChannel    *mask,
       if ((y + h) > mask->y2)
         mask->y2 = (y + h);
     }
-  else if (op == GIMP_CHANNEL_OP_REPLACE || mask->empty)
+  else if (op == GIMP_CHANNEL_OP_REPLACE ||
+           (op == GIMP_CHANNEL_OP_ADD && mask->bounds_known && mask->empty))
     {
       mask->empty = FALSE;
       mask->x1    = x;
@@ -87,6 +89,11 @@ gimp_channel_combine_rect (GimpChannel    *mask,
   mask->y2 = CLAMP (mask->y2, 0, gimp_item_get_height (GIMP_ITEM (mask)));
 
   gimp_drawable_update (GIMP_DRAWABLE (mask), x, y, w, h);
+
+  /*  the tiles inside the rectangle are uniform now  */
+  gimp_channel_summary_fill (mask, GEGL_RECTANGLE (x, y, w, h),
+                             (op == GIMP_CHANNEL_OP_ADD ||
+                              op == GIMP_CHANNEL_OP_REPLACE) ? 1.0 : 0.0);
 }
 
 /**
@@ -178,7 +185,8 @@ gimp_channel_combine_ellipse_rect (GimpChannel    *mask,
       if ((x + w) > mask->x2) mask->x2 = (x + w);
       if ((y + h) > mask->y2) mask->y2 = (y + h);
     }
-  else if (op == GIMP_CHANNEL_OP_REPLACE || mask->empty)
+  else if (op == GIMP_CHANNEL_OP_REPLACE ||
+           (op == GIMP_CHANNEL_OP_ADD && mask->bounds_known && mask->empty))
     {
       mask->empty = FALSE;
       mask->x1    = x;
@@ -202,12 +210,52 @@ gimp_channel_combine_mask (GimpChannel    *mask,
                            gint            off_y)
 {
   GeglBuffer *add_on_buffer;
+  gint        x, y, w, h;
 
   g_return_if_fail (GIMP_IS_CHANNEL (mask));
   g_return_if_fail (GIMP_IS_CHANNEL (add_on));
 
   add_on_buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (add_on));
 
+  /*  adding or subtracting zero doesn't change anything, so only the
+   *  part of add_on which isn't zero needs to be combined
+   */
+  if (op != GIMP_CHANNEL_OP_INTERSECT)
+    {
+      gfloat min, max;
+
+      if (! gimp_item_bounds (GIMP_ITEM (add_on), &x, &y, &w, &h))
+        return;
+
+      if (gimp_channel_summary_get_range (add_on,
+                                          GEGL_RECTANGLE (x, y, w, h),
+                                          &min, &max) &&
+          min >= 1.0)
+        {
+          /*  a fully selected add_on is just a rectangle  */
+          gimp_channel_combine_rect (mask,
+                                     op == GIMP_CHANNEL_OP_SUBTRACT ?
+                                     GIMP_CHANNEL_OP_SUBTRACT :
+                                     GIMP_CHANNEL_OP_ADD,
+                                     off_x + x, off_y + y, w, h);
+        }
+      else
+        {
+          GeglBuffer *sub_buffer;
+
+          sub_buffer = gegl_buffer_create_sub_buffer (add_on_buffer,
+                                                      GEGL_RECTANGLE (x, y,
+                                                                      w, h));
+
+          gimp_channel_combine_buffer (mask, sub_buffer,
+                                       op, off_x, off_y);
+
+          g_object_unref (sub_buffer);
+        }
+
+      return;
+    }
+
   gimp_channel_combine_buffer (mask, add_on_buffer,
                                op, off_x, off_y);
 }
@@ -219,8 +267,9 @@ gimp_channel_combine_buffer (GimpChannel    *mask,
                              gint            off_x,
                              gint            off_y)
 {
-  GeglBuffer *buffer;
-  gint        x, y, w, h;
+  GeglBuffer          *buffer;
+  const GeglRectangle *extent;
+  gint                 x, y, w, h;
 
   g_return_if_fail (GIMP_IS_CHANNEL (mask));
   g_return_if_fail (GEGL_IS_BUFFER (add_on_buffer));
@@ -231,9 +280,10 @@ gimp_channel_combine_buffer (GimpChannel    *mask,
                                        op, off_x, off_y))
     return;
 
-  gimp_rectangle_intersect (off_x, off_y,
-                            gegl_buffer_get_width  (add_on_buffer),
-                            gegl_buffer_get_height (add_on_buffer),
+  extent = gegl_buffer_get_extent (add_on_buffer);
+
+  gimp_rectangle_intersect (off_x + extent->x, off_y + extent->y,
+                            extent->width, extent->height,
                             0, 0,
                             gimp_item_get_width  (GIMP_ITEM (mask)),
                             gimp_item_get_height (GIMP_ITEM (mask)),
@@ -0,0 +1,554 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gegl.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "core-types.h"
+
+#include "gegl/gimp-gegl-parallel.h"
+
+#include "gimpchannel.h"
+#include "gimpchannel-summary.h"
+
+
+/*  The summary keeps the minimum and maximum value and the bounds of
+ *  the non-zero pixels of every TILE_SIZE x TILE_SIZE tile of a
+ *  channel.  A tile with a maximum of 0.0 is all unselected, one with
+ *  a minimum of 1.0 is all selected.  Writing to the channel only
+ *  invalidates the tiles it touches, so the bounds and emptiness of a
+ *  channel are found by looking at the changed tiles alone, and tiles
+ *  filled with a single value are known without looking at them at
+ *  all.
+ */
+
+#define TILE_SIZE 256
+
+
+typedef struct
+{
+  gboolean valid;
+  gfloat   min;
+  gfloat   max;
+
+  /*  the bounds of the non-zero pixels, empty if there are none  */
+  gint     x1, y1;
+  gint     x2, y2;
+} SummaryTile;
+
+struct _GimpChannelSummary
+{
+  gint         width;
+  gint         height;
+  gint         n_cols;
+  gint         n_rows;
+
+  SummaryTile *tiles;
+};
+
+typedef struct
+{
+  GimpChannelSummary *summary;
+  GeglBuffer         *buffer;
+  gint               *dirty;
+  gint                n_dirty;
+  gint                next;
+} SummaryScan;
+
+
+/*  local function prototypes  */
+
+static GimpChannelSummary * summary_get      (GimpChannel         *channel,
+                                              gboolean             create);
+static gboolean             summary_get_span (GimpChannelSummary  *summary,
+                                              const GeglRectangle *area,
+                                              gboolean             inner,
+                                              gint                *col1,
+                                              gint                *row1,
+                                              gint                *col2,
+                                              gint                *row2);
+static void                 summary_validate (GimpChannelSummary  *summary,
+                                              GimpChannel         *channel,
+                                              gint                 col1,
+                                              gint                 row1,
+                                              gint                 col2,
+                                              gint                 row2);
+
+static void   summary_tile_get_area (GimpChannelSummary *summary,
+                                     gint                index,
+                                     GeglRectangle      *area);
+static void   summary_tile_scan     (SummaryScan        *scan,
+                                     gint                index);
+static void   summary_scan_func     (gint                i,
+                                     gint                n,
+                                     SummaryScan        *scan);
+
+
+/*  public functions  */
+
+void
+gimp_channel_summary_free (GimpChannelSummary *summary)
+{
+  g_return_if_fail (summary != NULL);
+
+  g_free (summary->tiles);
+
+  g_slice_free (GimpChannelSummary, summary);
+}
+
+void
+gimp_channel_summary_invalidate (GimpChannel         *channel,
+                                 const GeglRectangle *area)
+{
+  GimpChannelSummary *summary;
+  gint                col1, row1;
+  gint                col2, row2;
+  gint                col, row;
+
+  g_return_if_fail (GIMP_IS_CHANNEL (channel));
+
+  summary = summary_get (channel, FALSE);
+
+  if (! summary)
+    return;
+
+  if (! summary_get_span (summary, area, FALSE, &col1, &row1, &col2, &row2))
+    return;
+
+  for (row = row1; row < row2; row++)
+    for (col = col1; col < col2; col++)
+      summary->tiles[row * summary->n_cols + col].valid = FALSE;
+}
+
+/*  to be called after @area of @channel was set to @value, after the
+ *  update of the area invalidated it.  Tiles which are completely
+ *  inside @area become known, the others stay invalid.
+ */
+void
+gimp_channel_summary_fill (GimpChannel         *channel,
+                           const GeglRectangle *area,
+                           gfloat               value)
+{
+  GimpChannelSummary *summary;
+  gint                col1, row1;
+  gint                col2, row2;
+  gint                col, row;
+
+  g_return_if_fail (GIMP_IS_CHANNEL (channel));
+
+  summary = summary_get (channel, TRUE);
+
+  if (! summary_get_span (summary, area, TRUE, &col1, &row1, &col2, &row2))
+    return;
+
+  for (row = row1; row < row2; row++)
+    for (col = col1; col < col2; col++)
+      {
+        gint           index = row * summary->n_cols + col;
+        SummaryTile   *tile  = &summary->tiles[index];
+        GeglRectangle  tile_area;
+
+        summary_tile_get_area (summary, index, &tile_area);
+
+        tile->valid = TRUE;
+        tile->min   = value;
+        tile->max   = value;
+
+        if (value)
+          {
+            tile->x1 = tile_area.x;
+            tile->y1 = tile_area.y;
+            tile->x2 = tile_area.x + tile_area.width;
+            tile->y2 = tile_area.y + tile_area.height;
+          }
+        else
+          {
+            tile->x1 = tile->x2 = tile_area.x;
+            tile->y1 = tile->y2 = tile_area.y;
+          }
+      }
+}
+
+/*  same as gimp_gegl_mask_bounds() on the channel's buffer  */
+gboolean
+gimp_channel_summary_bounds (GimpChannel *channel,
+                             gint        *x1,
+                             gint        *y1,
+                             gint        *x2,
+                             gint        *y2)
+{
+  GimpChannelSummary *summary;
+  gint                tx1, ty1;
+  gint                tx2, ty2;
+  gint                i;
+
+  g_return_val_if_fail (GIMP_IS_CHANNEL (channel), FALSE);
+  g_return_val_if_fail (x1 != NULL, FALSE);
+  g_return_val_if_fail (y1 != NULL, FALSE);
+  g_return_val_if_fail (x2 != NULL, FALSE);
+  g_return_val_if_fail (y2 != NULL, FALSE);
+
+  summary = summary_get (channel, TRUE);
+
+  summary_validate (summary, channel,
+                    0, 0, summary->n_cols, summary->n_rows);
+
+  tx1 = summary->width;
+  ty1 = summary->height;
+  tx2 = 0;
+  ty2 = 0;
+
+  for (i = 0; i < summary->n_cols * summary->n_rows; i++)
+    {
+      SummaryTile *tile = &summary->tiles[i];
+
+      if (tile->x1 < tile->x2)
+        {
+          tx1 = MIN (tx1, tile->x1);
+          ty1 = MIN (ty1, tile->y1);
+          tx2 = MAX (tx2, tile->x2);
+          ty2 = MAX (ty2, tile->y2);
+        }
+    }
+
+  if (tx1 >= tx2)
+    {
+      *x1 = 0;
+      *y1 = 0;
+      *x2 = summary->width;
+      *y2 = summary->height;
+
+      return FALSE;
+    }
+
+  *x1 = tx1;
+  *y1 = ty1;
+  *x2 = tx2;
+  *y2 = ty2;
+
+  return TRUE;
+}
+
+gboolean
+gimp_channel_summary_is_empty (GimpChannel *channel)
+{
+  GimpChannelSummary *summary;
+  gint                i;
+
+  g_return_val_if_fail (GIMP_IS_CHANNEL (channel), FALSE);
+
+  summary = summary_get (channel, TRUE);
+
+  /*  don't look at the changed tiles if a known one isn't empty  */
+  for (i = 0; i < summary->n_cols * summary->n_rows; i++)
+    {
+      SummaryTile *tile = &summary->tiles[i];
+
+      if (tile->valid && tile->x1 < tile->x2)
+        return FALSE;
+    }
+
+  summary_validate (summary, channel,
+                    0, 0, summary->n_cols, summary->n_rows);
+
+  for (i = 0; i < summary->n_cols * summary->n_rows; i++)
+    {
+      SummaryTile *tile = &summary->tiles[i];
+
+      if (tile->x1 < tile->x2)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/*  returns the value range of the tiles overlapping @area, which
+ *  contains the range of the pixels within @area.  A @min of 1.0
+ *  means all of @area is selected, a @max of 0.0 means none of it is.
+ */
+gboolean
+gimp_channel_summary_get_range (GimpChannel         *channel,
+                                const GeglRectangle *area,
+                                gfloat              *min,
+                                gfloat              *max)
+{
+  GimpChannelSummary *summary;
+  gint                col1, row1;
+  gint                col2, row2;
+  gint                col, row;
+
+  g_return_val_if_fail (GIMP_IS_CHANNEL (channel), FALSE);
+  g_return_val_if_fail (area != NULL, FALSE);
+  g_return_val_if_fail (min != NULL, FALSE);
+  g_return_val_if_fail (max != NULL, FALSE);
+
+  summary = summary_get (channel, TRUE);
+
+  if (! summary_get_span (summary, area, FALSE, &col1, &row1, &col2, &row2))
+    return FALSE;
+
+  summary_validate (summary, channel, col1, row1, col2, row2);
+
+  *min = G_MAXFLOAT;
+  *max = -G_MAXFLOAT;
+
+  for (row = row1; row < row2; row++)
+    for (col = col1; col < col2; col++)
+      {
+        SummaryTile *tile = &summary->tiles[row * summary->n_cols + col];
+
+        *min = MIN (*min, tile->min);
+        *max = MAX (*max, tile->max);
+      }
+
+  return TRUE;
+}
+
+
+/*  private functions  */
+
+static GimpChannelSummary *
+summary_get (GimpChannel *channel,
+             gboolean     create)
+{
+  GimpChannelSummary *summary = channel->summary;
+  gint                width   = gimp_item_get_width  (GIMP_ITEM (channel));
+  gint                height  = gimp_item_get_height (GIMP_ITEM (channel));
+
+  if (summary && (summary->width != width || summary->height != height))
+    {
+      gimp_channel_summary_free (summary);
+      summary = channel->summary = NULL;
+    }
+
+  if (! summary && create)
+    {
+      summary = g_slice_new0 (GimpChannelSummary);
+
+      summary->width  = width;
+      summary->height = height;
+      summary->n_cols = (width  + TILE_SIZE - 1) / TILE_SIZE;
+      summary->n_rows = (height + TILE_SIZE - 1) / TILE_SIZE;
+      summary->tiles  = g_new0 (SummaryTile,
+                                summary->n_cols * summary->n_rows);
+
+      channel->summary = summary;
+    }
+
+  return summary;
+}
+
+/*  finds the tiles overlapping @area, or, with @inner, the ones
+ *  completely inside it.  A NULL @area means all of the channel.
+ */
+static gboolean
+summary_get_span (GimpChannelSummary  *summary,
+                  const GeglRectangle *area,
+                  gboolean             inner,
+                  gint                *col1,
+                  gint                *row1,
+                  gint                *col2,
+                  gint                *row2)
+{
+  gint x1, y1;
+  gint x2, y2;
+
+  if (! area)
+    {
+      *col1 = 0;
+      *row1 = 0;
+      *col2 = summary->n_cols;
+      *row2 = summary->n_rows;
+
+      return (summary->n_cols > 0 && summary->n_rows > 0);
+    }
+
+  x1 = MAX (area->x, 0);
+  y1 = MAX (area->y, 0);
+  x2 = MIN (area->x + area->width,  summary->width);
+  y2 = MIN (area->y + area->height, summary->height);
+
+  if (x2 <= x1 || y2 <= y1)
+    return FALSE;
+
+  if (inner)
+    {
+      *col1 = (x1 + TILE_SIZE - 1) / TILE_SIZE;
+      *row1 = (y1 + TILE_SIZE - 1) / TILE_SIZE;
+
+      /*  the last tiles are complete if they end at the channel's edge  */
+      *col2 = (x2 == summary->width)  ? summary->n_cols : x2 / TILE_SIZE;
+      *row2 = (y2 == summary->height) ? summary->n_rows : y2 / TILE_SIZE;
+    }
+  else
+    {
+      *col1 = x1 / TILE_SIZE;
+      *row1 = y1 / TILE_SIZE;
+      *col2 = (x2 - 1) / TILE_SIZE + 1;
+      *row2 = (y2 - 1) / TILE_SIZE + 1;
+    }
+
+  return (*col1 < *col2 && *row1 < *row2);
+}
+
+static void
+summary_validate (GimpChannelSummary *summary,
+                  GimpChannel        *channel,
+                  gint                col1,
+                  gint                row1,
+                  gint                col2,
+                  gint                row2)
+{
+  SummaryScan scan;
+  gint        col, row;
+
+  scan.summary = summary;
+  scan.buffer  = gimp_drawable_get_buffer (GIMP_DRAWABLE (channel));
+  scan.dirty   = NULL;
+  scan.n_dirty = 0;
+  scan.next    = 0;
+
+  for (row = row1; row < row2; row++)
+    for (col = col1; col < col2; col++)
+      {
+        gint index = row * summary->n_cols + col;
+
+        if (summary->tiles[index].valid)
+          continue;
+
+        if (! scan.dirty)
+          scan.dirty = g_new (gint, (row2 - row1) * (col2 - col1));
+
+        scan.dirty[scan.n_dirty++] = index;
+      }
+
+  if (scan.n_dirty > 0)
+    {
+      gimp_gegl_parallel_distribute (scan.n_dirty,
+                                     (GimpGeglParallelDistributeFunc)
+                                     summary_scan_func,
+                                     &scan);
+    }
+
+  g_free (scan.dirty);
+}
+
+static void
+summary_tile_get_area (GimpChannelSummary *summary,
+                       gint                index,
+                       GeglRectangle      *area)
+{
+  area->x      = (index % summary->n_cols) * TILE_SIZE;
+  area->y      = (index / summary->n_cols) * TILE_SIZE;
+  area->width  = MIN (TILE_SIZE, summary->width  - area->x);
+  area->height = MIN (TILE_SIZE, summary->height - area->y);
+}
+
+static void
+summary_tile_scan (SummaryScan *scan,
+                   gint         index)
+{
+  SummaryTile        *tile = &scan->summary->tiles[index];
+  GeglBufferIterator *iter;
+  GeglRectangle      *roi;
+  GeglRectangle       area;
+  gfloat              min  = G_MAXFLOAT;
+  gfloat              max  = -G_MAXFLOAT;
+  gint                x1, y1;
+  gint                x2, y2;
+
+  summary_tile_get_area (scan->summary, index, &area);
+
+  x1 = area.x + area.width;
+  y1 = area.y + area.height;
+  x2 = area.x;
+  y2 = area.y;
+
+  iter = gegl_buffer_iterator_new (scan->buffer, &area, 0,
+                                   babl_format ("Y float"),
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+  roi = &iter->roi[0];
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      const gfloat *data = iter->data[0];
+      gint          x, y;
+
+      for (y = roi->y; y < roi->y + roi->height; y++)
+        {
+          gint first = -1;
+          gint last  = -1;
+
+          for (x = 0; x < roi->width; x++, data++)
+            {
+              const gfloat value = *data;
+
+              if (value < min) min = value;
+              if (value > max) max = value;
+
+              if (value)
+                {
+                  if (first < 0)
+                    first = x;
+
+                  last = x;
+                }
+            }
+
+          if (first >= 0)
+            {
+              x1 = MIN (x1, roi->x + first);
+              x2 = MAX (x2, roi->x + last + 1);
+              y1 = MIN (y1, y);
+              y2 = MAX (y2, y + 1);
+            }
+        }
+    }
+
+  tile->min = min;
+  tile->max = max;
+
+  if (x1 < x2)
+    {
+      tile->x1 = x1;
+      tile->y1 = y1;
+      tile->x2 = x2;
+      tile->y2 = y2;
+    }
+  else
+    {
+      tile->x1 = tile->x2 = area.x;
+      tile->y1 = tile->y2 = area.y;
+    }
+
+  tile->valid = TRUE;
+}
+
+static void
+summary_scan_func (gint         i,
+                   gint         n,
+                   SummaryScan *scan)
+{
+  gint index;
+
+  while ((index = g_atomic_int_add (&scan->next, 1)) < scan->n_dirty)
+    summary_tile_scan (scan, scan->dirty[index]);
+}
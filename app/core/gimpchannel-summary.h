@@ -0,0 +1,42 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_CHANNEL_SUMMARY_H__
+#define __GIMP_CHANNEL_SUMMARY_H__
+
+
+void       gimp_channel_summary_free       (GimpChannelSummary  *summary);
+
+void       gimp_channel_summary_invalidate (GimpChannel         *channel,
+                                            const GeglRectangle *area);
+void       gimp_channel_summary_fill       (GimpChannel         *channel,
+                                            const GeglRectangle *area,
+                                            gfloat               value);
+
+gboolean   gimp_channel_summary_bounds     (GimpChannel         *channel,
+                                            gint                *x1,
+                                            gint                *y1,
+                                            gint                *x2,
+                                            gint                *y2);
+gboolean   gimp_channel_summary_is_empty   (GimpChannel         *channel);
+gboolean   gimp_channel_summary_get_range  (GimpChannel         *channel,
+                                            const GeglRectangle *area,
+                                            gfloat              *min,
+                                            gfloat              *max);
+
+
+#endif /* __GIMP_CHANNEL_SUMMARY_H__ */
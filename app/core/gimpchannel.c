@@ -32,7 +32,6 @@
 #include "paint/gimppaintoptions.h"
 
 #include "gegl/gimp-gegl-apply-operation.h"
-#include "gegl/gimp-gegl-mask.h"
 #include "gegl/gimp-gegl-nodes.h"
 
 #include "gimp.h"
@@ -45,7 +44,9 @@
 #include "gimpimage-undo.h"
 #include "gimpimage-undo-push.h"
 #include "gimpchannel.h"
+#include "gimpchannel-boundary.h"
 #include "gimpchannel-select.h"
+#include "gimpchannel-summary.h"
 #include "gimpcontext.h"
 #include "gimpdrawable-fill.h"
 #include "gimpdrawable-stroke.h"
@@ -151,6 +152,11 @@ static void       gimp_channel_convert_type  (GimpDrawable      *drawable,
                                               GeglDitherMethod   mask_dither_type,
                                               gboolean           push_undo,
                                               GimpProgress      *progress);
+static void gimp_channel_update                (GimpDrawable       *drawable,
+                                                gint                x,
+                                                gint                y,
+                                                gint                width,
+                                                gint                height);
 static void gimp_channel_invalidate_boundary   (GimpDrawable       *drawable);
 static void gimp_channel_get_active_components (GimpDrawable       *drawable,
                                                 gboolean           *active);
@@ -307,6 +313,7 @@ gimp_channel_class_init (GimpChannelClass *klass)
   item_class->raise_failed         = _("Channel cannot be raised higher.");
   item_class->lower_failed         = _("Channel cannot be lowered more.");
 
+  drawable_class->update                = gimp_channel_update;
   drawable_class->convert_type          = gimp_channel_convert_type;
   drawable_class->invalidate_boundary   = gimp_channel_invalidate_boundary;
   drawable_class->get_active_components = gimp_channel_get_active_components;
@@ -348,6 +355,8 @@ gimp_channel_init (GimpChannel *channel)
 
   /*  Selection mask variables  */
   channel->boundary_known = FALSE;
+  channel->boundary_tiles = NULL;
+  channel->summary        = NULL;
   channel->segs_in        = NULL;
   channel->segs_out       = NULL;
   channel->num_segs_in    = 0;
@@ -383,6 +392,11 @@ gimp_channel_finalize (GObject *object)
       channel->segs_out = NULL;
     }
 
+  g_clear_pointer (&channel->boundary_tiles,
+                   gimp_channel_boundary_tiles_free);
+  g_clear_pointer (&channel->summary,
+                   gimp_channel_summary_free);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -510,13 +524,12 @@ gimp_channel_bounds (GimpItem *item,
 
   if (! channel->bounds_known)
     {
-      GeglBuffer *buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (channel));
-
-      channel->empty = ! gimp_gegl_mask_bounds (buffer,
-                                                &channel->x1,
-                                                &channel->y1,
-                                                &channel->x2,
-                                                &channel->y2);
+      /*  only the tiles which changed since the last call are scanned  */
+      channel->empty = ! gimp_channel_summary_bounds (channel,
+                                                      &channel->x1,
+                                                      &channel->y1,
+                                                      &channel->x2,
+                                                      &channel->y2);
 
       channel->bounds_known = TRUE;
     }
@@ -987,6 +1000,29 @@ gimp_channel_convert_type (GimpDrawable     *drawable,
   g_object_unref (dest_buffer);
 }
 
+static void
+gimp_channel_update (GimpDrawable *drawable,
+                     gint          x,
+                     gint          y,
+                     gint          width,
+                     gint          height)
+{
+  GimpChannel *channel = GIMP_CHANNEL (drawable);
+
+  /*  every change of the pixels is followed by an update, so this is
+   *  where the boundary and summary tiles of the changed area are
+   *  thrown away
+   */
+  gimp_channel_boundary_tiles_invalidate (channel,
+                                          GEGL_RECTANGLE (x, y,
+                                                          width, height));
+  gimp_channel_summary_invalidate (channel,
+                                   GEGL_RECTANGLE (x, y, width, height));
+  channel->boundary_known = FALSE;
+
+  GIMP_DRAWABLE_CLASS (parent_class)->update (drawable, x, y, width, height);
+}
+
 static void
 gimp_channel_invalidate_boundary (GimpDrawable *drawable)
 {
@@ -1024,6 +1060,14 @@ gimp_channel_apply_buffer (GimpDrawable           *drawable,
                            gint                    base_x,
                            gint                    base_y)
 {
+  gimp_channel_boundary_tiles_invalidate (GIMP_CHANNEL (drawable),
+                                          GEGL_RECTANGLE (base_x, base_y,
+                                                          buffer_region->width,
+                                                          buffer_region->height));
+  gimp_channel_summary_invalidate (GIMP_CHANNEL (drawable),
+                                   GEGL_RECTANGLE (base_x, base_y,
+                                                   buffer_region->width,
+                                                   buffer_region->height));
   gimp_drawable_invalidate_boundary (drawable);
 
   GIMP_DRAWABLE_CLASS (parent_class)->apply_buffer (drawable, buffer,
@@ -1051,6 +1095,14 @@ gimp_channel_replace_buffer (GimpDrawable        *drawable,
                              gint                 x,
                              gint                 y)
 {
+  gimp_channel_boundary_tiles_invalidate (GIMP_CHANNEL (drawable),
+                                          GEGL_RECTANGLE (x, y,
+                                                          buffer_region->width,
+                                                          buffer_region->height));
+  gimp_channel_summary_invalidate (GIMP_CHANNEL (drawable),
+                                   GEGL_RECTANGLE (x, y,
+                                                   buffer_region->width,
+                                                   buffer_region->height));
   gimp_drawable_invalidate_boundary (drawable);
 
   GIMP_DRAWABLE_CLASS (parent_class)->replace_buffer (drawable, buffer,
@@ -1080,6 +1132,9 @@ gimp_channel_set_buffer (GimpDrawable *drawable,
 
   channel->bounds_known = FALSE;
 
+  gimp_channel_boundary_tiles_invalidate (channel, NULL);
+  gimp_channel_summary_invalidate (channel, NULL);
+
   if (gimp_filter_peek_node (GIMP_FILTER (channel)))
     {
       const Babl *color_format;
@@ -1101,6 +1156,14 @@ gimp_channel_swap_pixels (GimpDrawable *drawable,
                           gint          x,
                           gint          y)
 {
+  gimp_channel_boundary_tiles_invalidate (GIMP_CHANNEL (drawable),
+                                          GEGL_RECTANGLE (x, y,
+                                                          gegl_buffer_get_width  (buffer),
+                                                          gegl_buffer_get_height (buffer)));
+  gimp_channel_summary_invalidate (GIMP_CHANNEL (drawable),
+                                   GEGL_RECTANGLE (x, y,
+                                                   gegl_buffer_get_width  (buffer),
+                                                   gegl_buffer_get_height (buffer)));
   gimp_drawable_invalidate_boundary (drawable);
 
   GIMP_DRAWABLE_CLASS (parent_class)->swap_pixels (drawable, buffer, x, y);
@@ -1148,55 +1211,12 @@ gimp_channel_real_boundary (GimpChannel         *channel,
 {
   if (! channel->boundary_known)
     {
-      gint x3, y3, x4, y4;
-
       /* free the out of date boundary segments */
       g_free (channel->segs_in);
       g_free (channel->segs_out);
 
-      if (gimp_item_bounds (GIMP_ITEM (channel), &x3, &y3, &x4, &y4))
-        {
-          GeglBuffer    *buffer;
-          GeglRectangle  rect = { x3, y3, x4, y4 };
-
-          x4 += x3;
-          y4 += y3;
-
-          buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (channel));
-
-          channel->segs_out = gimp_boundary_find (buffer, &rect,
-                                                  babl_format ("Y float"),
-                                                  GIMP_BOUNDARY_IGNORE_BOUNDS,
-                                                  x1, y1, x2, y2,
-                                                  GIMP_BOUNDARY_HALF_WAY,
-                                                  &channel->num_segs_out);
-          x1 = MAX (x1, x3);
-          y1 = MAX (y1, y3);
-          x2 = MIN (x2, x4);
-          y2 = MIN (y2, y4);
-
-          if (x2 > x1 && y2 > y1)
-            {
-              channel->segs_in = gimp_boundary_find (buffer, NULL,
-                                                     babl_format ("Y float"),
-                                                     GIMP_BOUNDARY_WITHIN_BOUNDS,
-                                                     x1, y1, x2, y2,
-                                                     GIMP_BOUNDARY_HALF_WAY,
-                                                     &channel->num_segs_in);
-            }
-          else
-            {
-              channel->segs_in     = NULL;
-              channel->num_segs_in = 0;
-            }
-        }
-      else
-        {
-          channel->segs_in      = NULL;
-          channel->segs_out     = NULL;
-          channel->num_segs_in  = 0;
-          channel->num_segs_out = 0;
-        }
+      /*  only the tiles which changed since the last call are traced  */
+      gimp_channel_boundary_tiles_find (channel, x1, y1, x2, y2);
 
       channel->boundary_known = TRUE;
     }
@@ -1212,14 +1232,10 @@ gimp_channel_real_boundary (GimpChannel         *channel,
 static gboolean
 gimp_channel_real_is_empty (GimpChannel *channel)
 {
-  GeglBuffer *buffer;
-
   if (channel->bounds_known)
     return channel->empty;
 
-  buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (channel));
-
-  if (! gimp_gegl_mask_is_empty (buffer))
+  if (! gimp_channel_summary_is_empty (channel))
     return FALSE;
 
   /*  The mask is empty, meaning we can set the bounds as known  */
@@ -1348,6 +1364,9 @@ gimp_channel_real_clear (GimpChannel *channel,
   channel->y2           = gimp_item_get_height (GIMP_ITEM (channel));
 
   gimp_drawable_update (GIMP_DRAWABLE (channel), 0, 0, -1, -1);
+
+  /*  ... and the contents of every tile  */
+  gimp_channel_summary_fill (channel, NULL, 0.0);
 }
 
 static void
@@ -1377,6 +1396,9 @@ gimp_channel_real_all (GimpChannel *channel,
   channel->y2           = gimp_item_get_height (GIMP_ITEM (channel));
 
   gimp_drawable_update (GIMP_DRAWABLE (channel), 0, 0, -1, -1);
+
+  /*  ... and the contents of every tile  */
+  gimp_channel_summary_fill (channel, NULL, 1.0);
 }
 
 static void
@@ -1717,6 +1739,9 @@ gimp_channel_new_from_alpha (GimpImage     *image,
 
   channel->bounds_known = FALSE;
 
+  /*  the clear above filled in the channel's summary  */
+  gimp_drawable_update (GIMP_DRAWABLE (channel), 0, 0, -1, -1);
+
   return channel;
 }
 
@@ -53,6 +53,9 @@ struct _GimpChannel
   gboolean      bounds_known;      /*  recalculate the bounds?        */
   gint          x1, y1;            /*  coordinates for bounding box   */
   gint          x2, y2;            /*  lower right hand coordinate    */
+
+  GimpChannelBoundaryTiles *boundary_tiles; /*  boundary segments per tile */
+  GimpChannelSummary       *summary;        /*  value range per tile       */
 };
 
 struct _GimpChannelClass
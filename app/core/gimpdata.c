@@ -186,6 +186,8 @@ gimp_data_class_init (GimpDataClass *klass)
   klass->save                      = NULL;
   klass->get_extension             = NULL;
   klass->duplicate                 = NULL;
+  klass->get_cache_state           = NULL;
+  klass->set_cache_state           = NULL;
 
   g_object_class_install_property (object_class, PROP_FILE,
                                    g_param_spec_object ("file", NULL, NULL,
@@ -1106,6 +1108,53 @@ gimp_data_duplicate (GimpData *data)
   return NULL;
 }
 
+/**
+ * gimp_data_get_cache_state:
+ * @data: a #GimpData object
+ *
+ * Returns what the data cache of #GimpDataFactory keeps about @data,
+ * usually its size, a preview and a checksum, so that a later
+ * gimp_data_set_cache_state() can restore @data without parsing its
+ * file.  Data types which don't support the cache return %NULL.
+ *
+ * Returns: a new floating #GVariant, or %NULL.
+ **/
+GVariant *
+gimp_data_get_cache_state (GimpData *data)
+{
+  g_return_val_if_fail (GIMP_IS_DATA (data), NULL);
+
+  if (GIMP_DATA_GET_CLASS (data)->get_cache_state)
+    return GIMP_DATA_GET_CLASS (data)->get_cache_state (data);
+
+  return NULL;
+}
+
+/**
+ * gimp_data_set_cache_state:
+ * @data:  a newly created #GimpData object
+ * @state: a #GVariant returned by gimp_data_get_cache_state()
+ *
+ * Restores @data from @state.  Anything not contained in @state, like
+ * the pixels of large patterns, is loaded from the data's file when
+ * it is first needed, so gimp_data_set_file() must be called on @data
+ * afterwards.
+ *
+ * Returns: %TRUE if @state could be restored.
+ **/
+gboolean
+gimp_data_set_cache_state (GimpData *data,
+                           GVariant *state)
+{
+  g_return_val_if_fail (GIMP_IS_DATA (data), FALSE);
+  g_return_val_if_fail (state != NULL, FALSE);
+
+  if (GIMP_DATA_GET_CLASS (data)->set_cache_state)
+    return GIMP_DATA_GET_CLASS (data)->set_cache_state (data, state);
+
+  return FALSE;
+}
+
 /**
  * gimp_data_make_internal:
  * @data: a #GimpData object.
@@ -57,11 +57,14 @@ struct _GimpDataClass
   void          (* dirty)         (GimpData  *data);
 
   /*  virtual functions  */
-  gboolean      (* save)          (GimpData       *data,
-                                   GOutputStream  *output,
-                                   GError        **error);
-  const gchar * (* get_extension) (GimpData       *data);
-  GimpData    * (* duplicate)     (GimpData       *data);
+  gboolean      (* save)            (GimpData       *data,
+                                     GOutputStream  *output,
+                                     GError        **error);
+  const gchar * (* get_extension)   (GimpData       *data);
+  GimpData    * (* duplicate)       (GimpData       *data);
+  GVariant    * (* get_cache_state) (GimpData       *data);
+  gboolean      (* set_cache_state) (GimpData       *data,
+                                     GVariant       *state);
 };
 
 
@@ -106,6 +109,10 @@ gint64        gimp_data_get_mtime        (GimpData     *data);
 
 GimpData    * gimp_data_duplicate        (GimpData     *data);
 
+GVariant    * gimp_data_get_cache_state  (GimpData     *data);
+gboolean      gimp_data_set_cache_state  (GimpData     *data,
+                                          GVariant     *state);
+
 void          gimp_data_make_internal    (GimpData     *data,
                                           const gchar  *identifier);
 gboolean      gimp_data_is_internal      (GimpData     *data);
@@ -33,12 +33,15 @@
 #include "core-types.h"
 
 #include "gimp.h"
+#include "gimp-data-cache.h"
 #include "gimp-utils.h"
 #include "gimpcontext.h"
 #include "gimpdata.h"
 #include "gimpdatafactory.h"
 #include "gimplist.h"
 
+#include "gegl/gimp-gegl-parallel.h"
+
 #include "gimp-intl.h"
 
 
@@ -53,6 +56,39 @@ typedef void (* GimpDataForeachFunc) (GimpDataFactory *factory,
                                       gpointer         user_data);
 
 
+typedef struct _GimpDataLoadJob     GimpDataLoadJob;
+typedef struct _GimpDataLoadContext GimpDataLoadContext;
+
+/*  a data file found in the data path, and what loading it produced  */
+struct _GimpDataLoadJob
+{
+  const GimpDataFactoryLoaderEntry *loader;
+  GFile                            *file;
+  GFile                            *top_directory;
+  gboolean                          dir_writable;
+  guint64                           mtime;
+  guint64                           size;
+  GimpDataCache                    *data_cache;
+
+  GList                            *cached_data;
+  gboolean                          loaded;
+  GList                            *data_list;
+  GError                           *error;
+};
+
+struct _GimpDataLoadContext
+{
+  GimpDataFactory *factory;
+  GimpContext     *context;
+  GHashTable      *cache;
+  GPtrArray       *jobs;
+  gint             next_job;
+
+  GList           *data_caches;
+  GimpDataCache   *data_cache;  /*  of the directory being walked  */
+};
+
+
 struct _GimpDataFactoryPriv
 {
   Gimp                             *gimp;
@@ -88,19 +124,25 @@ static void    gimp_data_factory_data_load      (GimpDataFactory     *factory,
 static GFile * gimp_data_factory_get_save_dir   (GimpDataFactory     *factory,
                                                  GError             **error);
 
-static void    gimp_data_factory_load_directory (GimpDataFactory     *factory,
-                                                 GimpContext         *context,
-                                                 GHashTable          *cache,
+static void    gimp_data_factory_load_directory (GimpDataLoadContext *load,
                                                  gboolean             dir_writable,
                                                  GFile               *directory,
                                                  GFile               *top_directory);
-static void    gimp_data_factory_load_data      (GimpDataFactory     *factory,
-                                                 GimpContext         *context,
-                                                 GHashTable          *cache,
+static void    gimp_data_factory_load_add_job   (GimpDataLoadContext *load,
                                                  gboolean             dir_writable,
                                                  GFile               *file,
                                                  GFileInfo           *info,
                                                  GFile               *top_directory);
+static void    gimp_data_factory_load_jobs      (gint                 i,
+                                                 gint                 n,
+                                                 GimpDataLoadContext *load);
+static void    gimp_data_factory_load_job       (GimpDataLoadContext *load,
+                                                 GimpDataLoadJob     *job);
+static void    gimp_data_factory_load_finish    (GimpDataLoadContext *load,
+                                                 GimpDataLoadJob     *job);
+static void    gimp_data_factory_load_job_free  (GimpDataLoadJob     *job);
+static void    gimp_data_factory_save_cache     (GimpDataFactory     *factory,
+                                                 GimpDataCache       *data_cache);
 
 
 G_DEFINE_TYPE (GimpDataFactory, gimp_data_factory, GIMP_TYPE_OBJECT)
@@ -323,11 +365,16 @@ gimp_data_factory_data_load (GimpDataFactory *factory,
                              GimpContext     *context,
                              GHashTable      *cache)
 {
-  gchar *p;
-  gchar *wp;
-  GList *path;
-  GList *writable_path;
-  GList *list;
+  GimpDataLoadContext  load;
+  gchar               *p;
+  gchar               *wp;
+  GList               *path;
+  GList               *writable_path;
+  GList               *list;
+  GType                data_type;
+  GimpDataClass       *data_class;
+  gboolean             use_data_cache;
+  gint                 i;
 
   g_object_get (factory->priv->gimp->config,
                 factory->priv->path_property_name,     &p,
@@ -340,6 +387,23 @@ gimp_data_factory_data_load (GimpDataFactory *factory,
   g_free (p);
   g_free (wp);
 
+  load.factory  = factory;
+  load.context  = context;
+  load.cache    = cache;
+  load.jobs     = g_ptr_array_new_with_free_func ((GDestroyNotify)
+                                                  gimp_data_factory_load_job_free);
+  load.next_job = 0;
+
+  load.data_caches = NULL;
+  load.data_cache  = NULL;
+
+  /*  only data types which can be restored from the cache use it  */
+  data_type      = gimp_data_factory_get_data_type (factory);
+  data_class     = g_type_class_ref (data_type);
+  use_data_cache = (data_class->get_cache_state != NULL);
+  g_type_class_unref (data_class);
+
+  /*  first collect all data files...  */
   for (list = path; list; list = g_list_next (list))
     {
       gboolean dir_writable = FALSE;
@@ -348,12 +412,42 @@ gimp_data_factory_data_load (GimpDataFactory *factory,
                               (GCompareFunc) gimp_file_compare))
         dir_writable = TRUE;
 
-      gimp_data_factory_load_directory (factory, context, cache,
+      if (use_data_cache)
+        {
+          load.data_cache  = gimp_data_cache_new (data_type, list->data);
+          load.data_caches = g_list_prepend (load.data_caches,
+                                             load.data_cache);
+        }
+
+      gimp_data_factory_load_directory (&load,
                                         dir_writable,
                                         list->data,
                                         list->data);
     }
 
+  /*  ...then restore them from the data cache, or read and parse
+   *  them on as many threads as there are processors, which mostly
+   *  matters for large data collections on slow or remote file
+   *  systems...
+   */
+  if (load.jobs->len > 1)
+    gimp_gegl_parallel_distribute (load.jobs->len,
+                                   (GimpGeglParallelDistributeFunc)
+                                   gimp_data_factory_load_jobs,
+                                   &load);
+
+  /*  ...and add the results in their original order  */
+  for (i = 0; i < load.jobs->len; i++)
+    gimp_data_factory_load_finish (&load, g_ptr_array_index (load.jobs, i));
+
+  g_ptr_array_free (load.jobs, TRUE);
+
+  /*  ...and remember what changed for the next time  */
+  for (list = load.data_caches; list; list = g_list_next (list))
+    gimp_data_factory_save_cache (factory, list->data);
+
+  g_list_free_full (load.data_caches, (GDestroyNotify) gimp_data_cache_free);
+
   g_list_free_full (path,          (GDestroyNotify) g_object_unref);
   g_list_free_full (writable_path, (GDestroyNotify) g_object_unref);
 }
@@ -778,12 +872,10 @@ gimp_data_factory_get_save_dir (GimpDataFactory  *factory,
 }
 
 static void
-gimp_data_factory_load_directory (GimpDataFactory *factory,
-                                  GimpContext     *context,
-                                  GHashTable      *cache,
-                                  gboolean         dir_writable,
-                                  GFile           *directory,
-                                  GFile           *top_directory)
+gimp_data_factory_load_directory (GimpDataLoadContext *load,
+                                  gboolean             dir_writable,
+                                  GFile               *directory,
+                                  GFile               *top_directory)
 {
   GFileEnumerator *enumerator;
 
@@ -791,6 +883,7 @@ gimp_data_factory_load_directory (GimpDataFactory *factory,
                                           G_FILE_ATTRIBUTE_STANDARD_NAME ","
                                           G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN ","
                                           G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+                                          G_FILE_ATTRIBUTE_STANDARD_SIZE ","
                                           G_FILE_ATTRIBUTE_TIME_MODIFIED,
                                           G_FILE_QUERY_INFO_NONE,
                                           NULL, NULL);
@@ -815,17 +908,17 @@ gimp_data_factory_load_directory (GimpDataFactory *factory,
 
           if (file_type == G_FILE_TYPE_DIRECTORY)
             {
-              gimp_data_factory_load_directory (factory, context, cache,
+              gimp_data_factory_load_directory (load,
                                                 dir_writable,
                                                 child,
                                                 top_directory);
             }
           else if (file_type == G_FILE_TYPE_REGULAR)
             {
-              gimp_data_factory_load_data (factory, context, cache,
-                                           dir_writable,
-                                           child, info,
-                                           top_directory);
+              gimp_data_factory_load_add_job (load,
+                                              dir_writable,
+                                              child, info,
+                                              top_directory);
             }
 
           g_object_unref (child);
@@ -837,20 +930,16 @@ gimp_data_factory_load_directory (GimpDataFactory *factory,
 }
 
 static void
-gimp_data_factory_load_data (GimpDataFactory *factory,
-                             GimpContext     *context,
-                             GHashTable      *cache,
-                             gboolean         dir_writable,
-                             GFile           *file,
-                             GFileInfo       *info,
-                             GFile           *top_directory)
-{
-  const GimpDataFactoryLoaderEntry *loader    = NULL;
-  GList                            *data_list = NULL;
-  GInputStream                     *input;
-  guint64                           mtime;
+gimp_data_factory_load_add_job (GimpDataLoadContext *load,
+                                gboolean             dir_writable,
+                                GFile               *file,
+                                GFileInfo           *info,
+                                GFile               *top_directory)
+{
+  GimpDataFactory                  *factory = load->factory;
+  const GimpDataFactoryLoaderEntry *loader  = NULL;
+  GimpDataLoadJob                  *job;
   gint                              i;
-  GError                           *error = NULL;
 
   for (i = 0; i < factory->priv->n_loader_entries; i++)
     {
@@ -870,55 +959,120 @@ gimp_data_factory_load_data (GimpDataFactory *factory,
   return;
 
  insert:
-  mtime = g_file_info_get_attribute_uint64 (info,
-                                            G_FILE_ATTRIBUTE_TIME_MODIFIED);
-
-  if (cache)
+  job = g_slice_new0 (GimpDataLoadJob);
+
+  job->loader        = loader;
+  job->file          = g_object_ref (file);
+  job->top_directory = g_object_ref (top_directory);
+  job->dir_writable  = dir_writable;
+  job->mtime         = g_file_info_get_attribute_uint64 (info,
+                                                         G_FILE_ATTRIBUTE_TIME_MODIFIED);
+  job->size          = g_file_info_get_size (info);
+  job->data_cache    = load->data_cache;
+
+  if (load->cache)
     {
-      GList *cached_data = g_hash_table_lookup (cache, file);
+      GList *cached_data = g_hash_table_lookup (load->cache, file);
 
       if (cached_data &&
           gimp_data_get_mtime (cached_data->data) != 0 &&
-          gimp_data_get_mtime (cached_data->data) == mtime)
+          gimp_data_get_mtime (cached_data->data) == job->mtime)
         {
-          GList *list;
+          job->cached_data = cached_data;
+        }
+    }
 
-          for (list = cached_data; list; list = g_list_next (list))
-            gimp_container_add (factory->priv->container, list->data);
+  g_ptr_array_add (load->jobs, job);
+}
 
-          return;
-        }
+static void
+gimp_data_factory_load_jobs (gint                 i,
+                             gint                 n,
+                             GimpDataLoadContext *load)
+{
+  gint index;
+
+  while ((index = g_atomic_int_add (&load->next_job, 1)) < (gint) load->jobs->len)
+    {
+      GimpDataLoadJob *job = g_ptr_array_index (load->jobs, index);
+
+      if (! job->cached_data && job->loader->threadsafe)
+        gimp_data_factory_load_job (load, job);
+    }
+}
+
+static void
+gimp_data_factory_load_job (GimpDataLoadContext *load,
+                            GimpDataLoadJob     *job)
+{
+  GInputStream *input;
+
+  job->loaded = TRUE;
+
+  if (job->data_cache)
+    {
+      job->data_list = gimp_data_cache_lookup (job->data_cache, job->file,
+                                               job->mtime, job->size);
+
+      if (job->data_list)
+        return;
     }
 
-  input = G_INPUT_STREAM (g_file_read (file, NULL, &error));
+  input = G_INPUT_STREAM (g_file_read (job->file, NULL, &job->error));
 
   if (input)
     {
-      data_list = loader->load_func (context, file, input, &error);
+      job->data_list = job->loader->load_func (load->context, job->file,
+                                               input, &job->error);
 
-      if (error)
+      if (job->error)
         {
-          g_prefix_error (&error,
+          g_prefix_error (&job->error,
                           _("Error loading '%s': "),
-                          gimp_file_get_utf8_name (file));
+                          gimp_file_get_utf8_name (job->file));
         }
-      else if (! data_list)
+      else if (! job->data_list)
         {
-          g_set_error (&error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
+          g_set_error (&job->error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
                        _("Error loading '%s'"),
-                       gimp_file_get_utf8_name (file));
+                       gimp_file_get_utf8_name (job->file));
         }
 
       g_object_unref (input);
     }
   else
     {
-      g_prefix_error (&error,
+      g_prefix_error (&job->error,
                       _("Could not open '%s' for reading: "),
-                      gimp_file_get_utf8_name (file));
+                      gimp_file_get_utf8_name (job->file));
+    }
+}
+
+static void
+gimp_data_factory_load_finish (GimpDataLoadContext *load,
+                               GimpDataLoadJob     *job)
+{
+  GimpDataFactory *factory = load->factory;
+
+  if (job->cached_data)
+    {
+      GList *list;
+
+      if (job->data_cache)
+        gimp_data_cache_add (job->data_cache, job->file,
+                             job->mtime, job->size, job->cached_data);
+
+      for (list = job->cached_data; list; list = g_list_next (list))
+        gimp_container_add (factory->priv->container, list->data);
+
+      return;
     }
 
-  if (G_LIKELY (data_list))
+  /*  loaders which can't run in threads load here  */
+  if (! job->loaded)
+    gimp_data_factory_load_job (load, job);
+
+  if (G_LIKELY (job->data_list))
     {
       GList    *list;
       gchar    *uri;
@@ -926,7 +1080,7 @@ gimp_data_factory_load_data (GimpDataFactory *factory,
       gboolean  writable  = FALSE;
       gboolean  deletable = FALSE;
 
-      uri = g_file_get_uri (file);
+      uri = g_file_get_uri (job->file);
 
       obsolete = (strstr (uri, GIMP_OBSOLETE_DATA_DIR_NAME) != 0);
 
@@ -935,16 +1089,22 @@ gimp_data_factory_load_data (GimpDataFactory *factory,
       /* obsolete files are immutable, don't check their writability */
       if (! obsolete)
         {
-          deletable = (g_list_length (data_list) == 1 && dir_writable);
-          writable  = (deletable && loader->writable);
+          deletable = (g_list_length (job->data_list) == 1 &&
+                       job->dir_writable);
+          writable  = (deletable && job->loader->writable);
         }
 
-      for (list = data_list; list; list = g_list_next (list))
+      /*  don't cache what was loaded before an error  */
+      if (job->data_cache && ! job->error)
+        gimp_data_cache_add (job->data_cache, job->file,
+                             job->mtime, job->size, job->data_list);
+
+      for (list = job->data_list; list; list = g_list_next (list))
         {
           GimpData *data = list->data;
 
-          gimp_data_set_file (data, file, writable, deletable);
-          gimp_data_set_mtime (data, mtime);
+          gimp_data_set_file (data, job->file, writable, deletable);
+          gimp_data_set_mtime (data, job->mtime);
           gimp_data_clean (data);
 
           if (obsolete)
@@ -954,7 +1114,7 @@ gimp_data_factory_load_data (GimpDataFactory *factory,
             }
           else
             {
-              gimp_data_set_folder_tags (data, top_directory);
+              gimp_data_set_folder_tags (data, job->top_directory);
 
               gimp_container_add (factory->priv->container,
                                   GIMP_OBJECT (data));
@@ -963,17 +1123,41 @@ gimp_data_factory_load_data (GimpDataFactory *factory,
           g_object_unref (data);
         }
 
-      g_list_free (data_list);
+      g_list_free (job->data_list);
+      job->data_list = NULL;
     }
 
   /*  not else { ... } because loader->load_func() can return a list
    *  of data objects *and* an error message if loading failed after
    *  something was already loaded
    */
-  if (G_UNLIKELY (error))
+  if (G_UNLIKELY (job->error))
     {
       gimp_message (factory->priv->gimp, NULL, GIMP_MESSAGE_ERROR,
-                    _("Failed to load data:\n\n%s"), error->message);
+                    _("Failed to load data:\n\n%s"), job->error->message);
+      g_clear_error (&job->error);
+    }
+}
+
+static void
+gimp_data_factory_load_job_free (GimpDataLoadJob *job)
+{
+  g_object_unref (job->file);
+  g_object_unref (job->top_directory);
+
+  g_slice_free (GimpDataLoadJob, job);
+}
+
+static void
+gimp_data_factory_save_cache (GimpDataFactory *factory,
+                              GimpDataCache   *data_cache)
+{
+  GError *error = NULL;
+
+  if (! gimp_data_cache_save (data_cache, &error))
+    {
+      gimp_message_literal (factory->priv->gimp, NULL, GIMP_MESSAGE_ERROR,
+                            error->message);
       g_clear_error (&error);
     }
 }
@@ -32,6 +32,7 @@
 
 #include "gimp.h"
 #include "gimpchannel.h"
+#include "gimpchannel-summary.h"
 #include "gimpdrawable-combine.h"
 #include "gimpdrawableundo.h"
 #include "gimpimage.h"
@@ -82,6 +83,7 @@ gimp_drawable_real_apply_buffer (GimpDrawable           *drawable,
   if (mask)
     {
       GimpItem *mask_item = GIMP_ITEM (mask);
+      gfloat    min, max;
 
       /*  make sure coordinates are in mask bounds ...
        *  we need to add the layer offset to transform coords
@@ -92,6 +94,19 @@ gimp_drawable_real_apply_buffer (GimpDrawable           *drawable,
                                 gimp_item_get_width  (mask_item),
                                 gimp_item_get_height (mask_item),
                                 &x, &y, &width, &height);
+
+      /*  a mask which is fully selected where it's applied doesn't
+       *  change anything
+       */
+      if (gimp_channel_summary_get_range (mask,
+                                          GEGL_RECTANGLE (x + offset_x,
+                                                          y + offset_y,
+                                                          width, height),
+                                          &min, &max) &&
+          min >= 1.0)
+        {
+          mask = NULL;
+        }
     }
 
   if (push_undo)
@@ -204,6 +219,7 @@ gimp_drawable_real_replace_buffer (GimpDrawable        *drawable,
   if (mask)
     {
       GimpItem *mask_item = GIMP_ITEM (mask);
+      gfloat    min, max;
 
       /*  make sure coordinates are in mask bounds ...
        *  we need to add the layer offset to transform coords
@@ -214,6 +230,19 @@ gimp_drawable_real_replace_buffer (GimpDrawable        *drawable,
                                 gimp_item_get_width  (mask_item),
                                 gimp_item_get_height (mask_item),
                                 &x, &y, &width, &height);
+
+      /*  a mask which is fully selected where it's applied doesn't
+       *  change anything
+       */
+      if (gimp_channel_summary_get_range (mask,
+                                          GEGL_RECTANGLE (x + offset_x,
+                                                          y + offset_y,
+                                                          width, height),
+                                          &min, &max) &&
+          min >= 1.0)
+        {
+          mask = NULL;
+        }
     }
 
   /*  If the calling procedure specified an undo step...  */
@@ -32,6 +32,7 @@
 
 #include "gegl/gimp-babl.h"
 #include "gegl/gimp-gegl-loops.h"
+#include "gegl/gimp-gegl-parallel.h"
 
 #include "gimp.h"
 #include "gimpchannel.h"
@@ -43,6 +44,32 @@
 #include "gimptempbuf.h"
 
 
+typedef struct
+{
+  GimpDrawable                *drawable;
+  GeglBuffer                  *buffer;
+  GeglRectangle                rect;
+  gdouble                      scale;
+  GimpTempBuf                 *preview;
+  GimpDrawablePreviewCallback  callback;
+  gpointer                     user_data;
+} SubPreviewData;
+
+
+/*  local function prototypes  */
+
+static gdouble   gimp_drawable_get_sub_preview_rect (gint            src_x,
+                                                     gint            src_y,
+                                                     gint            src_width,
+                                                     gint            src_height,
+                                                     gint            dest_width,
+                                                     gint            dest_height,
+                                                     GeglRectangle  *rect);
+
+static void      gimp_drawable_sub_preview_func     (SubPreviewData *data);
+static void      gimp_drawable_sub_preview_done     (SubPreviewData *data);
+
+
 /*  public functions  */
 
 GimpTempBuf *
@@ -129,13 +156,12 @@ gimp_drawable_get_sub_preview (GimpDrawable *drawable,
                                gint          dest_width,
                                gint          dest_height)
 {
-  GimpItem    *item;
-  GimpImage   *image;
-  GeglBuffer  *buffer;
-  GimpTempBuf *preview;
-  gdouble      scale;
-  gint         scaled_x;
-  gint         scaled_y;
+  GimpItem     *item;
+  GimpImage    *image;
+  GeglBuffer   *buffer;
+  GimpTempBuf  *preview;
+  GeglRectangle rect;
+  gdouble       scale;
 
   g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), NULL);
   g_return_val_if_fail (src_x >= 0, NULL);
@@ -160,15 +186,12 @@ gimp_drawable_get_sub_preview (GimpDrawable *drawable,
   preview = gimp_temp_buf_new (dest_width, dest_height,
                                gimp_drawable_get_preview_format (drawable));
 
-  scale = MIN ((gdouble) dest_width  / (gdouble) src_width,
-               (gdouble) dest_height / (gdouble) src_height);
-
-  scaled_x = RINT ((gdouble) src_x * scale);
-  scaled_y = RINT ((gdouble) src_y * scale);
+  scale = gimp_drawable_get_sub_preview_rect (src_x, src_y,
+                                              src_width, src_height,
+                                              dest_width, dest_height,
+                                              &rect);
 
-  gegl_buffer_get (buffer,
-                   GEGL_RECTANGLE (scaled_x, scaled_y, dest_width, dest_height),
-                   scale,
+  gegl_buffer_get (buffer, &rect, scale,
                    gimp_temp_buf_get_format (preview),
                    gimp_temp_buf_get_data (preview),
                    GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
@@ -176,6 +199,97 @@ gimp_drawable_get_sub_preview (GimpDrawable *drawable,
   return preview;
 }
 
+/**
+ * gimp_drawable_get_sub_preview_async:
+ * @drawable:    a #GimpDrawable
+ * @src_x:       the area of @drawable to preview
+ * @src_y:
+ * @src_width:
+ * @src_height:
+ * @dest_width:  the size of the preview
+ * @dest_height:
+ * @priority:    the idle priority @callback is called with
+ * @callback:    called from the main loop once the preview is ready
+ * @user_data:   user data for @callback
+ *
+ * Like gimp_drawable_get_sub_preview(), but reads the pixels on a
+ * worker thread, so the caller never blocks on them. When scaling
+ * down, the pixels come from @drawable's mipmap levels rather than
+ * from the full resolution buffer.
+ *
+ * The preview is made from the buffer @drawable has at the time of
+ * the call; changes made to the drawable meanwhile may or may not
+ * show up in it.
+ *
+ * Return value: %FALSE if layer previews are disabled or if
+ *               @drawable's pixels can only be computed on the main
+ *               thread, in which case @callback is never called.
+ **/
+gboolean
+gimp_drawable_get_sub_preview_async (GimpDrawable                *drawable,
+                                     gint                         src_x,
+                                     gint                         src_y,
+                                     gint                         src_width,
+                                     gint                         src_height,
+                                     gint                         dest_width,
+                                     gint                         dest_height,
+                                     gint                         priority,
+                                     GimpDrawablePreviewCallback  callback,
+                                     gpointer                     user_data)
+{
+  GimpItem       *item;
+  GimpImage      *image;
+  SubPreviewData *data;
+
+  g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), FALSE);
+  g_return_val_if_fail (src_x >= 0, FALSE);
+  g_return_val_if_fail (src_y >= 0, FALSE);
+  g_return_val_if_fail (src_width  > 0, FALSE);
+  g_return_val_if_fail (src_height > 0, FALSE);
+  g_return_val_if_fail (dest_width  > 0, FALSE);
+  g_return_val_if_fail (dest_height > 0, FALSE);
+  g_return_val_if_fail (callback != NULL, FALSE);
+
+  item = GIMP_ITEM (drawable);
+
+  g_return_val_if_fail ((src_x + src_width)  <= gimp_item_get_width  (item), FALSE);
+  g_return_val_if_fail ((src_y + src_height) <= gimp_item_get_height (item), FALSE);
+
+  image = gimp_item_get_image (item);
+
+  if (! image->gimp->config->layer_previews)
+    return FALSE;
+
+  /*  the buffer of a group layer is its projection, which renders
+   *  its layer stack on demand and must not do so off the main thread
+   */
+  if (gimp_viewable_get_children (GIMP_VIEWABLE (drawable)))
+    return FALSE;
+
+  data = g_slice_new (SubPreviewData);
+
+  data->drawable  = g_object_ref (drawable);
+  data->buffer    = g_object_ref (gimp_drawable_get_buffer (drawable));
+  data->preview   = gimp_temp_buf_new (dest_width, dest_height,
+                                       gimp_drawable_get_preview_format (drawable));
+  data->callback  = callback;
+  data->user_data = user_data;
+
+  data->scale = gimp_drawable_get_sub_preview_rect (src_x, src_y,
+                                                    src_width, src_height,
+                                                    dest_width, dest_height,
+                                                    &data->rect);
+
+  gimp_gegl_parallel_run_async ((GimpGeglParallelRunAsyncFunc)
+                                gimp_drawable_sub_preview_func,
+                                (GimpGeglParallelRunAsyncFunc)
+                                gimp_drawable_sub_preview_done,
+                                priority,
+                                data);
+
+  return TRUE;
+}
+
 GdkPixbuf *
 gimp_drawable_get_sub_pixbuf (GimpDrawable *drawable,
                               gint          src_x,
@@ -271,3 +385,49 @@ gimp_drawable_get_sub_pixbuf (GimpDrawable *drawable,
 
   return pixbuf;
 }
+
+
+/*  private functions  */
+
+static gdouble
+gimp_drawable_get_sub_preview_rect (gint           src_x,
+                                    gint           src_y,
+                                    gint           src_width,
+                                    gint           src_height,
+                                    gint           dest_width,
+                                    gint           dest_height,
+                                    GeglRectangle *rect)
+{
+  gdouble scale;
+
+  scale = MIN ((gdouble) dest_width  / (gdouble) src_width,
+               (gdouble) dest_height / (gdouble) src_height);
+
+  rect->x      = RINT ((gdouble) src_x * scale);
+  rect->y      = RINT ((gdouble) src_y * scale);
+  rect->width  = dest_width;
+  rect->height = dest_height;
+
+  return scale;
+}
+
+static void
+gimp_drawable_sub_preview_func (SubPreviewData *data)
+{
+  gegl_buffer_get (data->buffer, &data->rect, data->scale,
+                   gimp_temp_buf_get_format (data->preview),
+                   gimp_temp_buf_get_data (data->preview),
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
+}
+
+static void
+gimp_drawable_sub_preview_done (SubPreviewData *data)
+{
+  data->callback (data->drawable, data->preview, data->user_data);
+
+  gimp_temp_buf_unref (data->preview);
+  g_object_unref (data->buffer);
+  g_object_unref (data->drawable);
+
+  g_slice_free (SubPreviewData, data);
+}
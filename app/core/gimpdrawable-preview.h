@@ -19,6 +19,11 @@
 #define __GIMP_DRAWABLE__PREVIEW_H__
 
 
+typedef void (* GimpDrawablePreviewCallback) (GimpDrawable *drawable,
+                                              GimpTempBuf  *preview,
+                                              gpointer      user_data);
+
+
 /*
  *  virtual functions of GimpDrawable -- dont't call directly
  */
@@ -43,6 +48,17 @@ GimpTempBuf * gimp_drawable_get_sub_preview    (GimpDrawable *drawable,
                                                 gint          src_height,
                                                 gint          dest_width,
                                                 gint          dest_height);
+gboolean      gimp_drawable_get_sub_preview_async
+                                               (GimpDrawable                *drawable,
+                                                gint                         src_x,
+                                                gint                         src_y,
+                                                gint                         src_width,
+                                                gint                         src_height,
+                                                gint                         dest_width,
+                                                gint                         dest_height,
+                                                gint                         priority,
+                                                GimpDrawablePreviewCallback  callback,
+                                                gpointer                     user_data);
 GdkPixbuf   * gimp_drawable_get_sub_pixbuf     (GimpDrawable *drawable,
                                                 gint          src_x,
                                                 gint          src_y,
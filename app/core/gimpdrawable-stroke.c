@@ -113,6 +113,71 @@ gimp_drawable_stroke_vectors (GimpDrawable       *drawable,
   return FALSE;
 }
 
+/**
+ * gimp_drawable_stroke_vectors_list:
+ * @drawable:  the #GimpDrawable to stroke to
+ * @options:   the #GimpStrokeOptions
+ * @vectors:   a list of #GimpVectors
+ * @push_undo: whether to push an undo step
+ * @error:     return location for an error
+ *
+ * Strokes all of @vectors with a single scan conversion, so the
+ * drawable is only painted, and only pushed to the undo stack, once.
+ *
+ * Return value: %FALSE if none of @vectors has enough points to stroke.
+ **/
+gboolean
+gimp_drawable_stroke_vectors_list (GimpDrawable       *drawable,
+                                   GimpStrokeOptions  *options,
+                                   GList              *vectors,
+                                   gboolean            push_undo,
+                                   GError            **error)
+{
+  GimpScanConvert *scan_convert = NULL;
+  GList           *list;
+
+  g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), FALSE);
+  g_return_val_if_fail (gimp_item_is_attached (GIMP_ITEM (drawable)), FALSE);
+  g_return_val_if_fail (GIMP_IS_STROKE_OPTIONS (options), FALSE);
+  g_return_val_if_fail (gimp_fill_options_get_style (GIMP_FILL_OPTIONS (options)) !=
+                        GIMP_FILL_STYLE_PATTERN ||
+                        gimp_context_get_pattern (GIMP_CONTEXT (options)) != NULL,
+                        FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  for (list = vectors; list; list = g_list_next (list))
+    {
+      const GimpBezierDesc *bezier;
+
+      g_return_val_if_fail (GIMP_IS_VECTORS (list->data), FALSE);
+
+      bezier = gimp_vectors_get_bezier (list->data);
+
+      if (bezier && bezier->num_data >= 2)
+        {
+          if (! scan_convert)
+            scan_convert = gimp_scan_convert_new ();
+
+          gimp_scan_convert_add_bezier (scan_convert, bezier);
+        }
+    }
+
+  if (scan_convert)
+    {
+      gimp_drawable_stroke_scan_convert (drawable, options,
+                                         scan_convert, push_undo);
+
+      gimp_scan_convert_free (scan_convert);
+
+      return TRUE;
+    }
+
+  g_set_error_literal (error, GIMP_ERROR, GIMP_FAILED,
+                       _("Not enough points to stroke"));
+
+  return FALSE;
+}
+
 void
 gimp_drawable_stroke_scan_convert (GimpDrawable      *drawable,
                                    GimpStrokeOptions *options,
@@ -35,6 +35,11 @@ gboolean   gimp_drawable_stroke_vectors      (GimpDrawable       *drawable,
                                               GimpVectors        *vectors,
                                               gboolean            push_undo,
                                               GError            **error);
+gboolean   gimp_drawable_stroke_vectors_list (GimpDrawable       *drawable,
+                                              GimpStrokeOptions  *options,
+                                              GList              *vectors,
+                                              gboolean            push_undo,
+                                              GError            **error);
 
 void       gimp_drawable_stroke_scan_convert (GimpDrawable      *drawable,
                                               GimpStrokeOptions *options,
@@ -30,10 +30,18 @@
 #include "core-types.h"
 
 #include "gegl/gimp-babl.h"
+#include "gegl/gimp-gegl-parallel.h"
 
 #include "gimphistogram.h"
 
 
+/*  the side of the cells whose histograms are kept by incremental
+ *  histograms, and the smallest area calculated by one thread
+ */
+#define CELL_SIZE    256
+#define MIN_SUB_AREA (128 * 128)
+
+
 enum
 {
   PROP_0,
@@ -44,12 +52,39 @@ enum
 
 struct _GimpHistogramPrivate
 {
-  gboolean  linear;
-  gint      n_channels;
-  gint      n_bins;
-  gdouble  *values;
+  gboolean       linear;
+  gint           n_channels;
+  gint           n_bins;
+  gdouble       *values;
+
+  /*  per-cell histograms of the last incremental calculation  */
+  gboolean       incremental;
+  GeglBuffer    *cache_buffer;
+  GeglRectangle  cache_rect;
+  const Babl    *cache_format;
+  gint           cache_n_cols;
+  gint           cache_n_rows;
+  gdouble       *cache_values;
+  gboolean      *cache_valid;
 };
 
+typedef struct
+{
+  GimpHistogram       *histogram;
+  GeglBuffer          *buffer;
+  const GeglRectangle *buffer_rect;
+  GeglBuffer          *mask;
+  const GeglRectangle *mask_rect;
+  const Babl          *format;
+  gint                 n_components;
+  gint                 n_values;
+  GMutex               mutex;
+
+  /*  the cells to recalculate  */
+  gint                *dirty;
+  gint                 n_dirty;
+} CalculateContext;
+
 
 /*  local function prototypes  */
 
@@ -70,6 +105,17 @@ static void     gimp_histogram_alloc_values (GimpHistogram *histogram,
                                              gint           n_components,
                                              gint           n_bins);
 
+static void     gimp_histogram_clear_cache      (GimpHistogram       *histogram);
+static void     gimp_histogram_calculate_cached (CalculateContext    *context);
+static void     gimp_histogram_calculate_cells  (gsize                offset,
+                                                 gsize                size,
+                                                 CalculateContext    *context);
+static void     gimp_histogram_calculate_area   (const GeglRectangle *area,
+                                                 CalculateContext    *context);
+static void     gimp_histogram_calculate_values (CalculateContext    *context,
+                                                 const GeglRectangle *area,
+                                                 gdouble             *values);
+
 
 G_DEFINE_TYPE (GimpHistogram, gimp_histogram, GIMP_TYPE_OBJECT)
 
@@ -123,6 +169,7 @@ gimp_histogram_finalize (GObject *object)
   GimpHistogram *histogram = GIMP_HISTOGRAM (object);
 
   gimp_histogram_clear_values (histogram);
+  gimp_histogram_clear_cache (histogram);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -181,6 +228,13 @@ gimp_histogram_get_memsize (GimpObject *object,
     memsize += (histogram->priv->n_channels *
                 histogram->priv->n_bins * sizeof (gdouble));
 
+  if (histogram->priv->cache_values)
+    memsize += (histogram->priv->cache_n_cols *
+                histogram->priv->cache_n_rows *
+                (histogram->priv->n_channels *
+                 histogram->priv->n_bins * sizeof (gdouble) +
+                 sizeof (gboolean)));
+
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
 }
@@ -233,8 +287,9 @@ gimp_histogram_calculate (GimpHistogram       *histogram,
                           const GeglRectangle *mask_rect)
 {
   GimpHistogramPrivate *priv;
-  GeglBufferIterator   *iter;
+  CalculateContext      context;
   const Babl           *format;
+  const Babl           *buffer_format;
   gint                  n_components;
   gint                  n_bins;
 
@@ -244,7 +299,7 @@ gimp_histogram_calculate (GimpHistogram       *histogram,
 
   priv = histogram->priv;
 
-  format = gegl_buffer_get_format (buffer);
+  format = buffer_format = gegl_buffer_get_format (buffer);
 
   if (babl_format_get_type (format, 0) == babl_type ("u8"))
     n_bins = 256;
@@ -308,6 +363,33 @@ gimp_histogram_calculate (GimpHistogram       *histogram,
         {
           g_return_if_reached ();
         }
+
+      /*  bin u8 and u16 buffers straight from their pixels if they
+       *  already are in the requested TRC
+       */
+      switch (gimp_babl_format_get_component_type (buffer_format))
+        {
+        case GIMP_COMPONENT_TYPE_U8:
+        case GIMP_COMPONENT_TYPE_U16:
+          {
+            GimpComponentType component;
+            const Babl       *integer_format;
+
+            component = gimp_babl_format_get_component_type (buffer_format);
+
+            integer_format =
+              gimp_babl_format (gimp_babl_format_get_base_type (buffer_format),
+                                gimp_babl_precision (component, priv->linear),
+                                babl_format_has_alpha (buffer_format));
+
+            if (integer_format == buffer_format)
+              format = buffer_format;
+          }
+          break;
+
+        default:
+          break;
+        }
     }
 
   n_components = babl_format_get_n_components (format);
@@ -316,174 +398,102 @@ gimp_histogram_calculate (GimpHistogram       *histogram,
 
   gimp_histogram_alloc_values (histogram, n_components, n_bins);
 
-  iter = gegl_buffer_iterator_new (buffer, buffer_rect, 0, format,
-                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
-
-  if (mask)
-    gegl_buffer_iterator_add (iter, mask, mask_rect, 0,
-                              babl_format ("Y float"),
-                              GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
-
-#define VALUE(c,i) (priv->values[(c) * priv->n_bins + \
-                                 (gint) (CLAMP ((i), 0.0, 1.0) * \
-                                         (priv->n_bins - 0.0001))])
+  context.histogram    = histogram;
+  context.buffer       = buffer;
+  context.buffer_rect  = buffer_rect;
+  context.mask         = mask;
+  context.mask_rect    = mask_rect;
+  context.format       = format;
+  context.n_components = n_components;
+  context.n_values     = priv->n_channels * priv->n_bins;
 
-  while (gegl_buffer_iterator_next (iter))
+  if (priv->incremental && ! mask)
     {
-      const gfloat *data   = iter->data[0];
-      gint          length = iter->length;
-      gfloat        max;
-      gfloat        luminance;
-
-      if (mask)
-        {
-          const gfloat *mask_data = iter->data[1];
-
-          switch (n_components)
-            {
-            case 1:
-              while (length--)
-                {
-                  const gdouble masked = *mask_data;
-
-                  VALUE (0, data[0]) += masked;
-
-                  data += n_components;
-                  mask_data += 1;
-                }
-              break;
-
-            case 2:
-              while (length--)
-                {
-                  const gdouble masked = *mask_data;
-                  const gdouble weight = data[1];
-
-                  VALUE (0, data[0]) += weight * masked;
-                  VALUE (1, data[1]) += masked;
-
-                  data += n_components;
-                  mask_data += 1;
-                }
-              break;
-
-            case 3: /* calculate separate value values */
-              while (length--)
-                {
-                  const gdouble masked = *mask_data;
-
-                  VALUE (1, data[0]) += masked;
-                  VALUE (2, data[1]) += masked;
-                  VALUE (3, data[2]) += masked;
-
-                  max = MAX (data[0], data[1]);
-                  max = MAX (data[2], max);
-                  VALUE (0, max) += masked;
-
-                  luminance = GIMP_RGB_LUMINANCE (data[0], data[1], data[2]);
-                  VALUE (4, luminance) += masked;
-
-                  data += n_components;
-                  mask_data += 1;
-                }
-              break;
-
-            case 4: /* calculate separate value values */
-              while (length--)
-                {
-                  const gdouble masked = *mask_data;
-                  const gdouble weight = data[3];
-
-                  VALUE (1, data[0]) += weight * masked;
-                  VALUE (2, data[1]) += weight * masked;
-                  VALUE (3, data[2]) += weight * masked;
-                  VALUE (4, data[3]) += masked;
-
-                  max = MAX (data[0], data[1]);
-                  max = MAX (data[2], max);
-                  VALUE (0, max) += weight * masked;
+      gimp_histogram_calculate_cached (&context);
+    }
+  else
+    {
+      gimp_histogram_clear_cache (histogram);
 
-                  luminance = GIMP_RGB_LUMINANCE (data[0], data[1], data[2]);
-                  VALUE (5, luminance) += weight * masked;
+      g_mutex_init (&context.mutex);
 
-                  data += n_components;
-                  mask_data += 1;
-                }
-              break;
-            }
-        }
-      else /* no mask */
-        {
-          switch (n_components)
-            {
-            case 1:
-              while (length--)
-                {
-                  VALUE (0, data[0]) += 1.0;
+      gimp_gegl_parallel_distribute_area (buffer_rect, MIN_SUB_AREA,
+                                          (GimpGeglParallelDistributeAreaFunc)
+                                          gimp_histogram_calculate_area,
+                                          &context);
 
-                  data += n_components;
-                }
-              break;
+      g_mutex_clear (&context.mutex);
+    }
 
-            case 2:
-              while (length--)
-                {
-                  const gdouble weight = data[1];
+  g_object_notify (G_OBJECT (histogram), "values");
 
-                  VALUE (0, data[0]) += weight;
-                  VALUE (1, data[1]) += 1.0;
+  g_object_thaw_notify (G_OBJECT (histogram));
+}
 
-                  data += n_components;
-                }
-              break;
+/**
+ * gimp_histogram_set_incremental:
+ * @histogram:   a #GimpHistogram
+ * @incremental: whether to keep partial results between calculations
+ *
+ * Makes gimp_histogram_calculate() keep the histogram of each cell of
+ * the buffer, and only recalculate the cells that were passed to
+ * gimp_histogram_invalidate() since the last calculation of the same
+ * buffer. The caller must report every change of the buffer's
+ * contents. Calculations using a mask are never incremental.
+ **/
+void
+gimp_histogram_set_incremental (GimpHistogram *histogram,
+                                gboolean       incremental)
+{
+  g_return_if_fail (GIMP_IS_HISTOGRAM (histogram));
 
-            case 3: /* calculate separate value values */
-              while (length--)
-                {
-                  VALUE (1, data[0]) += 1.0;
-                  VALUE (2, data[1]) += 1.0;
-                  VALUE (3, data[2]) += 1.0;
+  if (incremental != histogram->priv->incremental)
+    {
+      histogram->priv->incremental = incremental;
 
-                  max = MAX (data[0], data[1]);
-                  max = MAX (data[2], max);
-                  VALUE (0, max) += 1.0;
+      gimp_histogram_clear_cache (histogram);
+    }
+}
 
-                  luminance = GIMP_RGB_LUMINANCE (data[0], data[1], data[2]);
-                  VALUE (4, luminance) += 1.0;
+/**
+ * gimp_histogram_invalidate:
+ * @histogram: a #GimpHistogram
+ * @rect:      the changed area, in buffer coordinates
+ *
+ * Marks @rect of the last calculated buffer as changed, so the next
+ * incremental calculation recalculates the cells intersecting it.
+ **/
+void
+gimp_histogram_invalidate (GimpHistogram       *histogram,
+                           const GeglRectangle *rect)
+{
+  GimpHistogramPrivate *priv;
+  GeglRectangle         dirty;
+  gint                  col0, col1;
+  gint                  row0, row1;
+  gint                  row;
 
-                  data += n_components;
-                }
-              break;
+  g_return_if_fail (GIMP_IS_HISTOGRAM (histogram));
+  g_return_if_fail (rect != NULL);
 
-            case 4: /* calculate separate value values */
-              while (length--)
-                {
-                  const gdouble weight = data[3];
+  priv = histogram->priv;
 
-                  VALUE (1, data[0]) += weight;
-                  VALUE (2, data[1]) += weight;
-                  VALUE (3, data[2]) += weight;
-                  VALUE (4, data[3]) += 1.0;
+  if (! priv->cache_valid ||
+      ! gegl_rectangle_intersect (&dirty, rect, &priv->cache_rect))
+    return;
 
-                  max = MAX (data[0], data[1]);
-                  max = MAX (data[2], max);
-                  VALUE (0, max) += weight;
+  col0 = (dirty.x - priv->cache_rect.x) / CELL_SIZE;
+  row0 = (dirty.y - priv->cache_rect.y) / CELL_SIZE;
+  col1 = (dirty.x + dirty.width  - 1 - priv->cache_rect.x) / CELL_SIZE;
+  row1 = (dirty.y + dirty.height - 1 - priv->cache_rect.y) / CELL_SIZE;
 
-                  luminance = GIMP_RGB_LUMINANCE (data[0], data[1], data[2]);
-                  VALUE (5, luminance) += weight;
+  for (row = row0; row <= row1; row++)
+    {
+      gint col;
 
-                  data += n_components;
-                }
-              break;
-            }
-        }
+      for (col = col0; col <= col1; col++)
+        priv->cache_valid[row * priv->cache_n_cols + col] = FALSE;
     }
-
-  g_object_notify (G_OBJECT (histogram), "values");
-
-  g_object_thaw_notify (G_OBJECT (histogram));
-
-#undef VALUE
 }
 
 void
@@ -956,6 +966,7 @@ gimp_histogram_alloc_values (GimpHistogram *histogram,
       n_bins           != priv->n_bins)
     {
       gimp_histogram_clear_values (histogram);
+      gimp_histogram_clear_cache (histogram);
 
       if (n_components + 2 != priv->n_channels)
         {
@@ -979,3 +990,445 @@ gimp_histogram_alloc_values (GimpHistogram *histogram,
               priv->n_channels * priv->n_bins * sizeof (gdouble));
     }
 }
+
+static void
+gimp_histogram_clear_cache (GimpHistogram *histogram)
+{
+  GimpHistogramPrivate *priv = histogram->priv;
+
+  if (priv->cache_buffer)
+    {
+      g_object_remove_weak_pointer (G_OBJECT (priv->cache_buffer),
+                                    (gpointer) &priv->cache_buffer);
+      priv->cache_buffer = NULL;
+    }
+
+  g_clear_pointer (&priv->cache_values, g_free);
+  g_clear_pointer (&priv->cache_valid,  g_free);
+
+  priv->cache_format = NULL;
+  priv->cache_n_cols = 0;
+  priv->cache_n_rows = 0;
+}
+
+/*  returns the area of cell (col, row) of the cache grid  */
+static void
+gimp_histogram_get_cell (GimpHistogramPrivate *priv,
+                         gint                  col,
+                         gint                  row,
+                         GeglRectangle        *cell)
+{
+  cell->x      = priv->cache_rect.x + col * CELL_SIZE;
+  cell->y      = priv->cache_rect.y + row * CELL_SIZE;
+  cell->width  = MIN (CELL_SIZE,
+                      priv->cache_rect.x + priv->cache_rect.width  - cell->x);
+  cell->height = MIN (CELL_SIZE,
+                      priv->cache_rect.y + priv->cache_rect.height - cell->y);
+}
+
+static void
+gimp_histogram_calculate_cached (CalculateContext *context)
+{
+  GimpHistogramPrivate *priv = context->histogram->priv;
+  gint                  n_cells;
+  gint                  i;
+
+  if (priv->cache_buffer != context->buffer                         ||
+      priv->cache_format != context->format                         ||
+      ! gegl_rectangle_equal (&priv->cache_rect, context->buffer_rect) ||
+      ! priv->cache_values)
+    {
+      gimp_histogram_clear_cache (context->histogram);
+
+      priv->cache_buffer = context->buffer;
+      g_object_add_weak_pointer (G_OBJECT (priv->cache_buffer),
+                                 (gpointer) &priv->cache_buffer);
+
+      priv->cache_format = context->format;
+      priv->cache_rect   = *context->buffer_rect;
+      priv->cache_n_cols = (priv->cache_rect.width  + CELL_SIZE - 1) / CELL_SIZE;
+      priv->cache_n_rows = (priv->cache_rect.height + CELL_SIZE - 1) / CELL_SIZE;
+
+      n_cells = priv->cache_n_cols * priv->cache_n_rows;
+
+      priv->cache_values = g_new (gdouble, n_cells * context->n_values);
+      priv->cache_valid  = g_new0 (gboolean, n_cells);
+    }
+
+  n_cells = priv->cache_n_cols * priv->cache_n_rows;
+
+  /*  recalculate the changed cells in parallel...  */
+  context->dirty   = g_new (gint, n_cells);
+  context->n_dirty = 0;
+
+  for (i = 0; i < n_cells; i++)
+    {
+      if (! priv->cache_valid[i])
+        context->dirty[context->n_dirty++] = i;
+    }
+
+  if (context->n_dirty > 0)
+    {
+      gimp_gegl_parallel_distribute_range (context->n_dirty, 1,
+                                           (GimpGeglParallelDistributeRangeFunc)
+                                           gimp_histogram_calculate_cells,
+                                           context);
+    }
+
+  g_free (context->dirty);
+
+  /*  ...and sum up all of them, which is exact, unlike subtracting
+   *  the old contents of the cells from the total
+   */
+  for (i = 0; i < n_cells; i++)
+    {
+      const gdouble *values = priv->cache_values + i * context->n_values;
+      gint           j;
+
+      for (j = 0; j < context->n_values; j++)
+        priv->values[j] += values[j];
+
+      priv->cache_valid[i] = TRUE;
+    }
+}
+
+static void
+gimp_histogram_calculate_cells (gsize             offset,
+                                gsize             size,
+                                CalculateContext *context)
+{
+  GimpHistogramPrivate *priv = context->histogram->priv;
+  gsize                 i;
+
+  for (i = offset; i < offset + size; i++)
+    {
+      gint           cell   = context->dirty[i];
+      gdouble       *values = priv->cache_values + cell * context->n_values;
+      GeglRectangle  area;
+
+      gimp_histogram_get_cell (priv,
+                               cell % priv->cache_n_cols,
+                               cell / priv->cache_n_cols,
+                               &area);
+
+      memset (values, 0, context->n_values * sizeof (gdouble));
+
+      gimp_histogram_calculate_values (context, &area, values);
+    }
+}
+
+static void
+gimp_histogram_calculate_area (const GeglRectangle *area,
+                               CalculateContext    *context)
+{
+  GimpHistogramPrivate *priv = context->histogram->priv;
+  gdouble              *values;
+  gint                  i;
+
+  values = g_new0 (gdouble, context->n_values);
+
+  gimp_histogram_calculate_values (context, area, values);
+
+  g_mutex_lock (&context->mutex);
+
+  for (i = 0; i < context->n_values; i++)
+    priv->values[i] += values[i];
+
+  g_mutex_unlock (&context->mutex);
+
+  g_free (values);
+}
+
+static const guint16 *
+gimp_histogram_get_u16_bins (void)
+{
+  static guint16 *bins = NULL;
+
+  if (g_once_init_enter (&bins))
+    {
+      guint16 *table = g_new (guint16, 65536);
+      gint     i;
+
+      /*  the same binning as for float values  */
+      for (i = 0; i < 65536; i++)
+        table[i] = (gint) ((gfloat) (i / 65535.0) * (1024 - 0.0001));
+
+      g_once_init_leave (&bins, table);
+    }
+
+  return bins;
+}
+
+/*  adds the histogram of area to values  */
+static void
+gimp_histogram_calculate_values (CalculateContext    *context,
+                                 const GeglRectangle *area,
+                                 gdouble             *values)
+{
+  GimpHistogramPrivate *priv         = context->histogram->priv;
+  const Babl           *type         = babl_format_get_type (context->format, 0);
+  gint                  n_components = context->n_components;
+  gint                  n_bins       = priv->n_bins;
+  GeglBufferIterator   *iter;
+
+  iter = gegl_buffer_iterator_new (context->buffer, area, 0, context->format,
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+
+  if (context->mask)
+    {
+      GeglRectangle mask_area = *area;
+
+      mask_area.x += context->mask_rect->x - context->buffer_rect->x;
+      mask_area.y += context->mask_rect->y - context->buffer_rect->y;
+
+      gegl_buffer_iterator_add (iter, context->mask, &mask_area, 0,
+                                babl_format ("Y float"),
+                                GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+    }
+
+#define VALUE(c,i) (values[(c) * n_bins + \
+                           (gint) (CLAMP ((i), 0.0, 1.0) * \
+                                   (n_bins - 0.0001))])
+
+/*  for u8 and u16 pixels, c is the bin of the component itself  */
+#define BIN(c,b) (values[(c) * n_bins + (b)])
+
+#define CALCULATE_INTEGER(type, BIN_OF, FLOAT_OF)                         \
+  {                                                                       \
+    const type   *data      = iter->data[0];                              \
+    const gfloat *mask_data = context->mask ? iter->data[1] : NULL;       \
+    gint          length    = iter->length;                               \
+                                                                          \
+    while (length--)                                                      \
+      {                                                                   \
+        const gdouble masked = mask_data ? *mask_data++ : 1.0;            \
+                                                                          \
+        switch (n_components)                                             \
+          {                                                               \
+          case 1:                                                         \
+            BIN (0, BIN_OF (data[0])) += masked;                          \
+            break;                                                        \
+                                                                          \
+          case 2:                                                         \
+            {                                                             \
+              const gdouble weight = FLOAT_OF (data[1]);                  \
+                                                                          \
+              BIN (0, BIN_OF (data[0])) += weight * masked;               \
+              BIN (1, BIN_OF (data[1])) += masked;                        \
+            }                                                             \
+            break;                                                        \
+                                                                          \
+          case 3:                                                         \
+          case 4:                                                         \
+            {                                                             \
+              const gdouble weight = (n_components == 4 ?                 \
+                                      FLOAT_OF (data[3]) : 1.0);          \
+              const gint    slot   = (n_components == 4 ? 5 : 4);         \
+              type          max;                                          \
+              gfloat        luminance;                                    \
+                                                                          \
+              BIN (1, BIN_OF (data[0])) += weight * masked;               \
+              BIN (2, BIN_OF (data[1])) += weight * masked;               \
+              BIN (3, BIN_OF (data[2])) += weight * masked;               \
+                                                                          \
+              if (n_components == 4)                                      \
+                BIN (4, BIN_OF (data[3])) += masked;                      \
+                                                                          \
+              max = MAX (data[0], data[1]);                               \
+              max = MAX (data[2], max);                                   \
+              BIN (0, BIN_OF (max)) += weight * masked;                   \
+                                                                          \
+              luminance = GIMP_RGB_LUMINANCE (FLOAT_OF (data[0]),         \
+                                              FLOAT_OF (data[1]),         \
+                                              FLOAT_OF (data[2]));        \
+              VALUE (slot, luminance) += weight * masked;                 \
+            }                                                             \
+            break;                                                        \
+          }                                                               \
+                                                                          \
+        data += n_components;                                             \
+      }                                                                   \
+  }
+
+#define U8_BIN(v)    (v)
+#define U8_FLOAT(v)  ((gfloat) ((v) / 255.0))
+#define U16_BIN(v)   (u16_bins[v])
+#define U16_FLOAT(v) ((gfloat) ((v) / 65535.0))
+
+  if (type == babl_type ("u8"))
+    {
+      while (gegl_buffer_iterator_next (iter))
+        CALCULATE_INTEGER (guint8, U8_BIN, U8_FLOAT);
+
+      return;
+    }
+  else if (type == babl_type ("u16"))
+    {
+      const guint16 *u16_bins = gimp_histogram_get_u16_bins ();
+
+      while (gegl_buffer_iterator_next (iter))
+        CALCULATE_INTEGER (guint16, U16_BIN, U16_FLOAT);
+
+      return;
+    }
+
+#undef U16_FLOAT
+#undef U16_BIN
+#undef U8_FLOAT
+#undef U8_BIN
+#undef CALCULATE_INTEGER
+#undef BIN
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      const gfloat *data   = iter->data[0];
+      gint          length = iter->length;
+      gfloat        max;
+      gfloat        luminance;
+
+      if (context->mask)
+        {
+          const gfloat *mask_data = iter->data[1];
+
+          switch (n_components)
+            {
+            case 1:
+              while (length--)
+                {
+                  const gdouble masked = *mask_data;
+
+                  VALUE (0, data[0]) += masked;
+
+                  data += n_components;
+                  mask_data += 1;
+                }
+              break;
+
+            case 2:
+              while (length--)
+                {
+                  const gdouble masked = *mask_data;
+                  const gdouble weight = data[1];
+
+                  VALUE (0, data[0]) += weight * masked;
+                  VALUE (1, data[1]) += masked;
+
+                  data += n_components;
+                  mask_data += 1;
+                }
+              break;
+
+            case 3: /* calculate separate value values */
+              while (length--)
+                {
+                  const gdouble masked = *mask_data;
+
+                  VALUE (1, data[0]) += masked;
+                  VALUE (2, data[1]) += masked;
+                  VALUE (3, data[2]) += masked;
+
+                  max = MAX (data[0], data[1]);
+                  max = MAX (data[2], max);
+                  VALUE (0, max) += masked;
+
+                  luminance = GIMP_RGB_LUMINANCE (data[0], data[1], data[2]);
+                  VALUE (4, luminance) += masked;
+
+                  data += n_components;
+                  mask_data += 1;
+                }
+              break;
+
+            case 4: /* calculate separate value values */
+              while (length--)
+                {
+                  const gdouble masked = *mask_data;
+                  const gdouble weight = data[3];
+
+                  VALUE (1, data[0]) += weight * masked;
+                  VALUE (2, data[1]) += weight * masked;
+                  VALUE (3, data[2]) += weight * masked;
+                  VALUE (4, data[3]) += masked;
+
+                  max = MAX (data[0], data[1]);
+                  max = MAX (data[2], max);
+                  VALUE (0, max) += weight * masked;
+
+                  luminance = GIMP_RGB_LUMINANCE (data[0], data[1], data[2]);
+                  VALUE (5, luminance) += weight * masked;
+
+                  data += n_components;
+                  mask_data += 1;
+                }
+              break;
+            }
+        }
+      else /* no mask */
+        {
+          switch (n_components)
+            {
+            case 1:
+              while (length--)
+                {
+                  VALUE (0, data[0]) += 1.0;
+
+                  data += n_components;
+                }
+              break;
+
+            case 2:
+              while (length--)
+                {
+                  const gdouble weight = data[1];
+
+                  VALUE (0, data[0]) += weight;
+                  VALUE (1, data[1]) += 1.0;
+
+                  data += n_components;
+                }
+              break;
+
+            case 3: /* calculate separate value values */
+              while (length--)
+                {
+                  VALUE (1, data[0]) += 1.0;
+                  VALUE (2, data[1]) += 1.0;
+                  VALUE (3, data[2]) += 1.0;
+
+                  max = MAX (data[0], data[1]);
+                  max = MAX (data[2], max);
+                  VALUE (0, max) += 1.0;
+
+                  luminance = GIMP_RGB_LUMINANCE (data[0], data[1], data[2]);
+                  VALUE (4, luminance) += 1.0;
+
+                  data += n_components;
+                }
+              break;
+
+            case 4: /* calculate separate value values */
+              while (length--)
+                {
+                  const gdouble weight = data[3];
+
+                  VALUE (1, data[0]) += weight;
+                  VALUE (2, data[1]) += weight;
+                  VALUE (3, data[2]) += weight;
+                  VALUE (4, data[3]) += 1.0;
+
+                  max = MAX (data[0], data[1]);
+                  max = MAX (data[2], max);
+                  VALUE (0, max) += weight;
+
+                  luminance = GIMP_RGB_LUMINANCE (data[0], data[1], data[2]);
+                  VALUE (5, luminance) += weight;
+
+                  data += n_components;
+                }
+              break;
+            }
+        }
+    }
+
+#undef VALUE
+}
@@ -143,6 +143,7 @@
 
 #include "core-types.h"
 
+#include "gegl/gimp-gegl-parallel.h"
 #include "gegl/gimp-gegl-utils.h"
 
 #include "gimp.h"
@@ -190,6 +191,12 @@
 #define G_SCALE 24              /*  scale G (a*) distances by this much  */
 #define B_SCALE 26              /*  and B (b*) by this much              */
 
+/* the smallest areas handed to a thread, histogram generation is
+ * bounded by merging a whole private histogram per area
+ */
+#define HISTOGRAM_MIN_SUB_AREA (256 * 256)
+#define REMAP_MIN_SUB_AREA     (128 * 128)
+
 
 typedef struct _Color Color;
 typedef struct _QuantizeObj QuantizeObj;
@@ -515,6 +522,34 @@ typedef struct
 
 } box, *boxptr;
 
+typedef struct
+{
+  CFHistogram  histogram;
+  GeglBuffer  *buffer;
+  const Babl  *format;
+  gint         offsetx;
+  gint         offsety;
+  gboolean     dither_alpha;
+  GMutex       mutex;
+} HistogramData;
+
+typedef struct
+{
+  QuantizeObj *quantobj;
+  GeglBuffer  *src_buffer;
+  GeglBuffer  *new_buffer;
+  gint         src_bpp;
+  gint         dest_bpp;
+  gboolean     has_alpha;
+  gint         red_pix;
+  gint         green_pix;
+  gint         blue_pix;
+  gint         alpha_pix;
+  gint         offsetx;
+  gint         offsety;
+  GMutex       mutex;
+} RemapData;
+
 
 static void          zero_histogram_gray     (CFHistogram   histogram);
 static void          zero_histogram_rgb      (CFHistogram   histogram);
@@ -1141,6 +1176,100 @@ generate_histogram_gray (CFHistogram  histogram,
 }
 
 
+static void
+generate_histogram_rgb_thread (gint           i,
+                               gint           n,
+                               HistogramData *data)
+{
+  const GeglRectangle *extent = gegl_buffer_get_extent (data->buffer);
+  GeglRectangle        area   = *extent;
+  GeglBufferIterator  *iter;
+  GeglRectangle       *roi;
+  ColorFreq           *counts;
+  gint                 bpp;
+  gboolean             has_alpha;
+
+  bpp       = babl_format_get_bytes_per_pixel (data->format);
+  has_alpha = babl_format_has_alpha (data->format);
+
+  area.y      = extent->y + (2 * i       * extent->height + n) / (2 * n);
+  area.height = extent->y + (2 * (i + 1) * extent->height + n) / (2 * n) -
+                area.y;
+
+  /*  a single thread counts straight into the shared histogram,
+   *  otherwise each thread counts into a private one which is merged
+   *  at the end, so the threads never touch the same cells
+   */
+  if (n == 1)
+    counts = data->histogram;
+  else
+    counts = g_new0 (ColorFreq, HIST_R_ELEMS * HIST_G_ELEMS * HIST_B_ELEMS);
+
+  iter = gegl_buffer_iterator_new (data->buffer, &area, 0, data->format,
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+  roi = &iter->roi[0];
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      const guchar *src = iter->data[0];
+      gint          row;
+
+      for (row = 0; row < roi->height; row++)
+        {
+          gint col;
+
+          for (col = 0; col < roi->width; col++)
+            {
+              gboolean transparent = FALSE;
+
+              if (has_alpha)
+                {
+                  if (data->dither_alpha)
+                    {
+                      /* if alpha-dithering,
+                         we need to be deterministic w.r.t. offsets */
+                      gint dither_x = (col + data->offsetx + roi->x) & DM_WIDTHMASK;
+                      gint dither_y = (row + data->offsety + roi->y) & DM_HEIGHTMASK;
+
+                      if (src[ALPHA] < DM[dither_x][dither_y])
+                        transparent = TRUE;
+                    }
+                  else
+                    {
+                      if (src[ALPHA] <= 127)
+                        transparent = TRUE;
+                    }
+                }
+
+              if (! transparent)
+                {
+                  gint R, G, B;
+
+                  rgb_to_lin (src[RED], src[GREEN], src[BLUE], &R, &G, &B);
+
+                  counts[REF_FUNC (R, G, B)]++;
+                }
+
+              src += bpp;
+            }
+        }
+    }
+
+  if (n > 1)
+    {
+      gint j;
+
+      g_mutex_lock (&data->mutex);
+
+      for (j = 0; j < HIST_R_ELEMS * HIST_G_ELEMS * HIST_B_ELEMS; j++)
+        data->histogram[j] += counts[j];
+
+      g_mutex_unlock (&data->mutex);
+
+      g_free (counts);
+    }
+}
+
 static void
 generate_histogram_rgb (CFHistogram   histogram,
                         GimpLayer    *layer,
@@ -1178,6 +1307,46 @@ generate_histogram_rgb (CFHistogram   histogram,
 
   /*  g_printerr ("col_limit = %d, nfc = %d\n", col_limit, num_found_cols); */
 
+  if (needs_quantize)
+    {
+      /*  plain histogram calculation, which can be split up  */
+      HistogramData        data;
+      const GeglRectangle *extent;
+      gint                 max_n;
+
+      data.histogram    = histogram;
+      data.buffer       = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
+      data.format       = format;
+      data.offsetx      = offsetx;
+      data.offsety      = offsety;
+      data.dither_alpha = dither_alpha;
+
+      g_mutex_init (&data.mutex);
+
+      /*  split into bands of rows, one per thread, since every thread
+       *  needs a histogram of its own
+       */
+      extent = gegl_buffer_get_extent (data.buffer);
+
+      max_n = MIN ((gsize) extent->width * extent->height /
+                   HISTOGRAM_MIN_SUB_AREA, G_MAXINT);
+      max_n = MIN (max_n, extent->height);
+      max_n = MAX (max_n, 1);
+
+      gimp_gegl_parallel_distribute (max_n,
+                                     (GimpGeglParallelDistributeFunc)
+                                     generate_histogram_rgb_thread,
+                                     &data);
+
+      g_mutex_clear (&data.mutex);
+
+      if (progress)
+        gimp_progress_set_value (progress,
+                                 (nth_layer + 1) / (gdouble) n_layers);
+
+      return;
+    }
+
   iter = gegl_buffer_iterator_new (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
                                    NULL, 0, format,
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
@@ -2349,15 +2518,13 @@ select_colors_rgb (QuantizeObj *quantobj,
  */
 
 
-/* log2(histogram cells in update box) for each axis; this can be adjusted */
-/*#define BOX_R_LOG  (PRECISION_R-3)
-  #define BOX_G_LOG  (PRECISION_G-3)
-  #define BOX_B_LOG  (PRECISION_B-3)*/
-
-/*adam*/
-#define BOX_R_LOG 0
-#define BOX_G_LOG 0
-#define BOX_B_LOG 0
+/* log2(histogram cells in update box) for each axis; this can be adjusted.
+ * The inverse colormap is filled in one shot by the pass2 init functions,
+ * so the subbox size recommended above is used.
+ */
+#define BOX_R_LOG  (PRECISION_R-3)
+#define BOX_G_LOG  (PRECISION_G-3)
+#define BOX_B_LOG  (PRECISION_B-3)
 
 #define BOX_R_ELEMS  (1<<BOX_R_LOG) /* # of hist cells in update box */
 #define BOX_G_ELEMS  (1<<BOX_G_LOG)
@@ -2730,6 +2897,30 @@ fill_inverse_cmap_rgb (QuantizeObj *quantobj,
 }
 
 
+/* Fill the inverse-colormap entries of all update boxes in the given
+ * range of red box ids.
+ */
+static void
+fill_inverse_cmap_rgb_range (gsize        offset,
+                             gsize        size,
+                             QuantizeObj *quantobj)
+{
+  gint R, G, B;
+
+  for (R = offset; R < offset + size; R++)
+    {
+      for (G = 0; G < HIST_G_ELEMS; G += BOX_G_ELEMS)
+        {
+          for (B = 0; B < HIST_B_ELEMS; B += BOX_B_ELEMS)
+            {
+              fill_inverse_cmap_rgb (quantobj, quantobj->histogram,
+                                     R << BOX_R_LOG, G, B);
+            }
+        }
+    }
+}
+
+
 /*  This is pass 1  */
 
 static void
@@ -2806,40 +2997,99 @@ custompal_pass1 (QuantizeObj *quantobj)
  */
 
 static void
-median_cut_pass2_no_dither_gray (QuantizeObj *quantobj,
-                                 GimpLayer   *layer,
-                                 GeglBuffer  *new_buffer)
+remap_data_add_used_count (RemapData    *data,
+                           const gulong *index_used_count)
+{
+  gint i;
+
+  g_mutex_lock (&data->mutex);
+
+  for (i = 0; i < 256; i++)
+    data->quantobj->index_used_count[i] += index_used_count[i];
+
+  g_mutex_unlock (&data->mutex);
+}
+
+/*  the non-dithered and positionally dithered remappers only depend
+ *  on the pixel itself and its position, so the layer is split into
+ *  areas which are remapped in parallel, each counting the colormap
+ *  indices it used on its own.
+ */
+static void
+remap_layer_parallel (QuantizeObj                        *quantobj,
+                      GimpLayer                          *layer,
+                      GeglBuffer                         *new_buffer,
+                      GimpGeglParallelDistributeAreaFunc  func)
+{
+  RemapData   data;
+  const Babl *src_format;
+
+  src_format = gimp_drawable_get_format (GIMP_DRAWABLE (layer));
+
+  data.quantobj   = quantobj;
+  data.src_buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
+  data.new_buffer = new_buffer;
+  data.src_bpp    = babl_format_get_bytes_per_pixel (src_format);
+  data.dest_bpp   = babl_format_get_bytes_per_pixel (gegl_buffer_get_format (new_buffer));
+  data.has_alpha  = babl_format_has_alpha (src_format);
+
+  /*  In the case of web/mono palettes, we actually force
+   *   grayscale drawables through the rgb pass2 functions
+   */
+  if (gimp_drawable_is_gray (GIMP_DRAWABLE (layer)))
+    {
+      data.red_pix = data.green_pix = data.blue_pix = GRAY;
+      data.alpha_pix = ALPHA_G;
+    }
+  else
+    {
+      data.red_pix   = RED;
+      data.green_pix = GREEN;
+      data.blue_pix  = BLUE;
+      data.alpha_pix = ALPHA;
+    }
+
+  gimp_item_get_offset (GIMP_ITEM (layer), &data.offsetx, &data.offsety);
+
+  g_mutex_init (&data.mutex);
+
+  gimp_gegl_parallel_distribute_area (gegl_buffer_get_extent (data.src_buffer),
+                                      REMAP_MIN_SUB_AREA,
+                                      func,
+                                      &data);
+
+  g_mutex_clear (&data.mutex);
+
+  if (quantobj->progress)
+    gimp_progress_set_value (quantobj->progress,
+                             (quantobj->nth_layer + 1) /
+                             (gdouble) quantobj->n_layers);
+}
+
+static void
+median_cut_pass2_no_dither_gray_area (const GeglRectangle *area,
+                                      RemapData           *data)
 {
+  QuantizeObj        *quantobj  = data->quantobj;
   GeglBufferIterator *iter;
   CFHistogram         histogram = quantobj->histogram;
   ColorFreq          *cachep;
-  const Babl         *src_format;
-  const Babl         *dest_format;
   GeglRectangle      *src_roi;
-  gint                src_bpp;
-  gint                dest_bpp;
-  gint                has_alpha;
-  gulong             *index_used_count = quantobj->index_used_count;
+  gint                src_bpp          = data->src_bpp;
+  gint                dest_bpp         = data->dest_bpp;
+  gboolean            has_alpha        = data->has_alpha;
+  gulong              index_used_count[256] = { 0, };
   gboolean            dither_alpha     = quantobj->want_dither_alpha;
-  gint                offsetx, offsety;
-
-  gimp_item_get_offset (GIMP_ITEM (layer), &offsetx, &offsety);
+  gint                offsetx          = data->offsetx;
+  gint                offsety          = data->offsety;
 
-  src_format  = gimp_drawable_get_format (GIMP_DRAWABLE (layer));
-  dest_format = gegl_buffer_get_format (new_buffer);
-
-  src_bpp  = babl_format_get_bytes_per_pixel (src_format);
-  dest_bpp = babl_format_get_bytes_per_pixel (dest_format);
-
-  has_alpha = babl_format_has_alpha (src_format);
-
-  iter = gegl_buffer_iterator_new (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
-                                   NULL, 0, NULL,
+  iter = gegl_buffer_iterator_new (data->src_buffer,
+                                   area, 0, NULL,
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
   src_roi = &iter->roi[0];
 
-  gegl_buffer_iterator_add (iter, new_buffer,
-                            NULL, 0, NULL,
+  gegl_buffer_iterator_add (iter, data->new_buffer,
+                            area, 0, NULL,
                             GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
 
   while (gegl_buffer_iterator_next (iter))
@@ -2854,15 +3104,12 @@ median_cut_pass2_no_dither_gray (QuantizeObj *quantobj,
 
           for (col = 0; col < src_roi->width; col++)
             {
-              /* get pixel value and index into the cache */
+              /* get pixel value and index into the cache, which
+               * median_cut_pass2_gray_init() filled completely
+               */
               gint pixel = src[GRAY];
 
               cachep = &histogram[pixel];
-              /* If we have not seen this color before, find nearest
-               * colormap entry and update the cache
-               */
-              if (*cachep == 0)
-                fill_inverse_cmap_gray (quantobj, histogram, pixel);
 
               if (has_alpha)
                 {
@@ -2903,49 +3150,50 @@ median_cut_pass2_no_dither_gray (QuantizeObj *quantobj,
             }
         }
     }
+
+  remap_data_add_used_count (data, index_used_count);
 }
 
 static void
-median_cut_pass2_fixed_dither_gray (QuantizeObj *quantobj,
-                                    GimpLayer   *layer,
-                                    GeglBuffer  *new_buffer)
+median_cut_pass2_no_dither_gray (QuantizeObj *quantobj,
+                                 GimpLayer   *layer,
+                                 GeglBuffer  *new_buffer)
 {
+  remap_layer_parallel (quantobj, layer, new_buffer,
+                        (GimpGeglParallelDistributeAreaFunc)
+                        median_cut_pass2_no_dither_gray_area);
+}
+
+static void
+median_cut_pass2_fixed_dither_gray_area (const GeglRectangle *area,
+                                         RemapData           *data)
+{
+  QuantizeObj        *quantobj  = data->quantobj;
   GeglBufferIterator *iter;
   CFHistogram         histogram = quantobj->histogram;
   ColorFreq          *cachep;
-  const Babl         *src_format;
-  const Babl         *dest_format;
   GeglRectangle      *src_roi;
-  gint                src_bpp;
-  gint                dest_bpp;
-  gboolean            has_alpha;
+  gint                src_bpp          = data->src_bpp;
+  gint                dest_bpp         = data->dest_bpp;
+  gboolean            has_alpha        = data->has_alpha;
   gint                pixval1 = 0;
   gint                pixval2 = 0;
   gint                err1;
   gint                err2;
   Color              *color1;
   Color              *color2;
-  gulong             *index_used_count = quantobj->index_used_count;
+  gulong              index_used_count[256] = { 0, };
   gboolean            dither_alpha     = quantobj->want_dither_alpha;
-  gint                offsetx, offsety;
-
-  gimp_item_get_offset (GIMP_ITEM (layer), &offsetx, &offsety);
-
-  src_format  = gimp_drawable_get_format (GIMP_DRAWABLE (layer));
-  dest_format = gegl_buffer_get_format (new_buffer);
+  gint                offsetx          = data->offsetx;
+  gint                offsety          = data->offsety;
 
-  src_bpp  = babl_format_get_bytes_per_pixel (src_format);
-  dest_bpp = babl_format_get_bytes_per_pixel (dest_format);
-
-  has_alpha = babl_format_has_alpha (src_format);
-
-  iter = gegl_buffer_iterator_new (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
-                                   NULL, 0, NULL,
+  iter = gegl_buffer_iterator_new (data->src_buffer,
+                                   area, 0, NULL,
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
   src_roi = &iter->roi[0];
 
-  gegl_buffer_iterator_add (iter, new_buffer,
-                            NULL, 0, NULL,
+  gegl_buffer_iterator_add (iter, data->new_buffer,
+                            area, 0, NULL,
                             GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
 
   while (gegl_buffer_iterator_next (iter))
@@ -2965,15 +3213,12 @@ median_cut_pass2_fixed_dither_gray (QuantizeObj *quantobj,
                 DM[(col + offsetx + src_roi->x) & DM_WIDTHMASK]
                 [(row + offsety + src_roi->y) & DM_HEIGHTMASK];
 
-              /* get pixel value and index into the cache */
+              /* get pixel value and index into the cache, which
+               * median_cut_pass2_gray_init() filled completely
+               */
               pixel = src[GRAY];
 
               cachep = &histogram[pixel];
-              /* If we have not seen this color before, find nearest
-               * colormap entry and update the cache
-               */
-              if (*cachep == 0)
-                fill_inverse_cmap_gray (quantobj, histogram, pixel);
 
               pixval1 = *cachep - 1;
               color1 = &quantobj->cmap[pixval1];
@@ -2988,11 +3233,6 @@ median_cut_pass2_fixed_dither_gray (QuantizeObj *quantobj,
                       const gint R = CLAMP0255 (RV);
 
                       cachep = &histogram[R];
-                      /* If we have not seen this color before, find
-                       * nearest colormap entry and update the cache
-                       */
-                      if (*cachep == 0)
-                        fill_inverse_cmap_gray (quantobj, histogram, R);
 
                       pixval2 = *cachep - 1;
                       RV += re;
@@ -3071,75 +3311,57 @@ median_cut_pass2_fixed_dither_gray (QuantizeObj *quantobj,
             }
         }
     }
+
+  remap_data_add_used_count (data, index_used_count);
 }
 
 static void
-median_cut_pass2_no_dither_rgb (QuantizeObj *quantobj,
-                                GimpLayer   *layer,
-                                GeglBuffer  *new_buffer)
+median_cut_pass2_fixed_dither_gray (QuantizeObj *quantobj,
+                                    GimpLayer   *layer,
+                                    GeglBuffer  *new_buffer)
 {
+  remap_layer_parallel (quantobj, layer, new_buffer,
+                        (GimpGeglParallelDistributeAreaFunc)
+                        median_cut_pass2_fixed_dither_gray_area);
+}
+
+static void
+median_cut_pass2_no_dither_rgb_area (const GeglRectangle *area,
+                                     RemapData           *data)
+{
+  QuantizeObj        *quantobj  = data->quantobj;
   GeglBufferIterator *iter;
   CFHistogram         histogram = quantobj->histogram;
   ColorFreq          *cachep;
-  const Babl         *src_format;
-  const Babl         *dest_format;
   GeglRectangle      *src_roi;
-  gint                src_bpp;
-  gint                dest_bpp;
-  gint                has_alpha;
+  gint                src_bpp          = data->src_bpp;
+  gint                dest_bpp         = data->dest_bpp;
+  gint                has_alpha        = data->has_alpha;
   gint                R, G, B;
-  gint                red_pix          = RED;
-  gint                green_pix        = GREEN;
-  gint                blue_pix         = BLUE;
-  gint                alpha_pix        = ALPHA;
+  gint                red_pix          = data->red_pix;
+  gint                green_pix        = data->green_pix;
+  gint                blue_pix         = data->blue_pix;
+  gint                alpha_pix        = data->alpha_pix;
   gboolean            dither_alpha     = quantobj->want_dither_alpha;
-  gint                offsetx, offsety;
-  gulong             *index_used_count = quantobj->index_used_count;
-  glong               total_size       = 0;
-  glong               layer_size;
-  gint                count            = 0;
-  gint                nth_layer        = quantobj->nth_layer;
-  gint                n_layers         = quantobj->n_layers;
-
-  gimp_item_get_offset (GIMP_ITEM (layer), &offsetx, &offsety);
-
-  src_format  = gimp_drawable_get_format (GIMP_DRAWABLE (layer));
-  dest_format = gegl_buffer_get_format (new_buffer);
+  gint                offsetx          = data->offsetx;
+  gint                offsety          = data->offsety;
+  gulong              index_used_count[256] = { 0, };
 
-  src_bpp  = babl_format_get_bytes_per_pixel (src_format);
-  dest_bpp = babl_format_get_bytes_per_pixel (dest_format);
-
-  has_alpha = babl_format_has_alpha (src_format);
-
-  /*  In the case of web/mono palettes, we actually force
-   *   grayscale drawables through the rgb pass2 functions
-   */
-  if (gimp_drawable_is_gray (GIMP_DRAWABLE (layer)))
-    {
-      red_pix = green_pix = blue_pix = GRAY;
-      alpha_pix = ALPHA_G;
-    }
-
-  iter = gegl_buffer_iterator_new (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
-                                   NULL, 0, NULL,
+  iter = gegl_buffer_iterator_new (data->src_buffer,
+                                   area, 0, NULL,
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
   src_roi = &iter->roi[0];
 
-  gegl_buffer_iterator_add (iter, new_buffer,
-                            NULL, 0, NULL,
+  gegl_buffer_iterator_add (iter, data->new_buffer,
+                            area, 0, NULL,
                             GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
 
-  layer_size = (gimp_item_get_width  (GIMP_ITEM (layer)) *
-                gimp_item_get_height (GIMP_ITEM (layer)));
-
   while (gegl_buffer_iterator_next (iter))
     {
       const guchar *src  = iter->data[0];
       guchar       *dest = iter->data[1];
       gint          row;
 
-      total_size += src_roi->height * src_roi->width;
-
       for (row = 0; row < src_roi->height; row++)
         {
           gint col;
@@ -3175,16 +3397,13 @@ median_cut_pass2_no_dither_rgb (QuantizeObj *quantobj,
                     }
                 }
 
-              /* get pixel value and index into the cache */
+              /* get pixel value and index into the cache, which
+               * median_cut_pass2_rgb_init() filled completely
+               */
               rgb_to_lin (src[red_pix], src[green_pix], src[blue_pix],
                           &R, &G, &B);
 
               cachep = HIST_LIN (histogram, R, G, B);
-              /* If we have not seen this color before, find nearest
-               * colormap entry and update the cache
-               */
-              if (*cachep == 0)
-                fill_inverse_cmap_rgb (quantobj, histogram, R, G, B);
 
               /* Now emit the colormap index for this cell, barfbarf */
               index_used_count[dest[INDEXED] = *cachep - 1]++;
@@ -3195,28 +3414,33 @@ median_cut_pass2_no_dither_rgb (QuantizeObj *quantobj,
               dest += dest_bpp;
             }
         }
-
-      if (quantobj->progress && (count % 16 == 0))
-         gimp_progress_set_value (quantobj->progress,
-                                  (nth_layer + ((gdouble) total_size)/
-                                   layer_size) / (gdouble) n_layers);
     }
+
+  remap_data_add_used_count (data, index_used_count);
 }
 
 static void
-median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
-                                   GimpLayer   *layer,
-                                   GeglBuffer  *new_buffer)
+median_cut_pass2_no_dither_rgb (QuantizeObj *quantobj,
+                                GimpLayer   *layer,
+                                GeglBuffer  *new_buffer)
 {
+  remap_layer_parallel (quantobj, layer, new_buffer,
+                        (GimpGeglParallelDistributeAreaFunc)
+                        median_cut_pass2_no_dither_rgb_area);
+}
+
+static void
+median_cut_pass2_fixed_dither_rgb_area (const GeglRectangle *area,
+                                        RemapData           *data)
+{
+  QuantizeObj        *quantobj  = data->quantobj;
   GeglBufferIterator *iter;
   CFHistogram         histogram = quantobj->histogram;
   ColorFreq          *cachep;
-  const Babl         *src_format;
-  const Babl         *dest_format;
   GeglRectangle      *src_roi;
-  gint                src_bpp;
-  gint                dest_bpp;
-  gint                has_alpha;
+  gint                src_bpp          = data->src_bpp;
+  gint                dest_bpp         = data->dest_bpp;
+  gint                has_alpha        = data->has_alpha;
   gint                pixval1 = 0;
   gint                pixval2 = 0;
   Color              *color1;
@@ -3224,58 +3448,30 @@ median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
   gint                R, G, B;
   gint                err1;
   gint                err2;
-  gint                red_pix          = RED;
-  gint                green_pix        = GREEN;
-  gint                blue_pix         = BLUE;
-  gint                alpha_pix        = ALPHA;
+  gint                red_pix          = data->red_pix;
+  gint                green_pix        = data->green_pix;
+  gint                blue_pix         = data->blue_pix;
+  gint                alpha_pix        = data->alpha_pix;
   gboolean            dither_alpha     = quantobj->want_dither_alpha;
-  gint                offsetx, offsety;
-  gulong             *index_used_count = quantobj->index_used_count;
-  glong               total_size       = 0;
-  glong               layer_size;
-  gint                count            = 0;
-  gint                nth_layer        = quantobj->nth_layer;
-  gint                n_layers         = quantobj->n_layers;
-
-  gimp_item_get_offset (GIMP_ITEM (layer), &offsetx, &offsety);
-
-  src_format  = gimp_drawable_get_format (GIMP_DRAWABLE (layer));
-  dest_format = gegl_buffer_get_format (new_buffer);
-
-  src_bpp  = babl_format_get_bytes_per_pixel (src_format);
-  dest_bpp = babl_format_get_bytes_per_pixel (dest_format);
-
-  has_alpha = babl_format_has_alpha (src_format);
-
-  /*  In the case of web/mono palettes, we actually force
-   *   grayscale drawables through the rgb pass2 functions
-   */
-  if (gimp_drawable_is_gray (GIMP_DRAWABLE (layer)))
-    {
-      red_pix = green_pix = blue_pix = GRAY;
-      alpha_pix = ALPHA_G;
-    }
+  gint                offsetx          = data->offsetx;
+  gint                offsety          = data->offsety;
+  gulong              index_used_count[256] = { 0, };
 
-  iter = gegl_buffer_iterator_new (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
-                                   NULL, 0, NULL,
+  iter = gegl_buffer_iterator_new (data->src_buffer,
+                                   area, 0, NULL,
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
   src_roi = &iter->roi[0];
 
-  gegl_buffer_iterator_add (iter, new_buffer,
-                            NULL, 0, NULL,
+  gegl_buffer_iterator_add (iter, data->new_buffer,
+                            area, 0, NULL,
                             GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
 
-  layer_size = (gimp_item_get_width  (GIMP_ITEM (layer)) *
-                gimp_item_get_height (GIMP_ITEM (layer)));
-
   while (gegl_buffer_iterator_next (iter))
     {
       const guchar *src  = iter->data[0];
       guchar       *dest = iter->data[1];
       gint          row;
 
-      total_size += src_roi->height * src_roi->width;
-
       for (row = 0; row < src_roi->height; row++)
         {
           gint col;
@@ -3312,16 +3508,13 @@ median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
                     }
                 }
 
-              /* get pixel value and index into the cache */
+              /* get pixel value and index into the cache, which
+               * median_cut_pass2_rgb_init() filled completely
+               */
               rgb_to_lin (src[red_pix], src[green_pix], src[blue_pix],
                           &R, &G, &B);
 
               cachep = HIST_LIN (histogram, R, G, B);
-              /* If we have not seen this color before, find nearest
-               * colormap entry and update the cache
-               */
-              if (*cachep == 0)
-                fill_inverse_cmap_rgb (quantobj, histogram, R, G, B);
 
               /* We now try to find a color which, when mixed in some
                * fashion with the closest match, yields something
@@ -3352,11 +3545,6 @@ median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
                                   &R, &G, &B);
 
                       cachep = HIST_LIN (histogram, R, G, B);
-                      /* If we have not seen this color before, find
-                       * nearest colormap entry and update the cache
-                       */
-                      if (*cachep == 0)
-                        fill_inverse_cmap_rgb (quantobj, histogram, R, G, B);
 
                       pixval2 = *cachep - 1;
                       RV += re;  GV += ge;  BV += be;
@@ -3430,12 +3618,19 @@ median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
               dest += dest_bpp;
             }
         }
-
-      if (quantobj->progress && (count % 16 == 0))
-        gimp_progress_set_value (quantobj->progress,
-                                 (nth_layer + ((gdouble) total_size)/
-                                  layer_size) / (gdouble) n_layers);
     }
+
+  remap_data_add_used_count (data, index_used_count);
+}
+
+static void
+median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
+                                   GimpLayer   *layer,
+                                   GeglBuffer  *new_buffer)
+{
+  remap_layer_parallel (quantobj, layer, new_buffer,
+                        (GimpGeglParallelDistributeAreaFunc)
+                        median_cut_pass2_fixed_dither_rgb_area);
 }
 
 static void
@@ -3893,15 +4088,29 @@ median_cut_pass2_rgb_init (QuantizeObj *quantobj)
                             &quantobj->clin[i].green,
                             &quantobj->clin[i].blue);
     }
+
+  /* Fill the whole inverse colormap up front, so the remappers can
+   * run in parallel without filling cells on demand
+   */
+  gimp_gegl_parallel_distribute_range (HIST_R_ELEMS >> BOX_R_LOG, 1,
+                                       (GimpGeglParallelDistributeRangeFunc)
+                                       fill_inverse_cmap_rgb_range,
+                                       quantobj);
 }
 
 static void
 median_cut_pass2_gray_init (QuantizeObj *quantobj)
 {
+  gint i;
+
   zero_histogram_gray (quantobj->histogram);
 
   /* Mark all indices as currently unused */
   memset (quantobj->index_used_count, 0, 256 * sizeof (gulong));
+
+  /* Fill the whole inverse colormap up front */
+  for (i = 0; i < 256; i++)
+    fill_inverse_cmap_gray (quantobj, quantobj->histogram, i);
 }
 
 static void
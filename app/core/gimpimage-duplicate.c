@@ -26,6 +26,8 @@
 
 #include "gimp.h"
 #include "gimpchannel.h"
+#include "gimpchannel-boundary.h"
+#include "gimpchannel-summary.h"
 #include "gimpguide.h"
 #include "gimpimage.h"
 #include "gimpimage-color-profile.h"
@@ -404,6 +406,10 @@ gimp_image_duplicate_mask (GimpImage *image,
 
   GIMP_CHANNEL (new_mask)->bounds_known   = FALSE;
   GIMP_CHANNEL (new_mask)->boundary_known = FALSE;
+
+  /*  the buffer was written without an update  */
+  gimp_channel_boundary_tiles_invalidate (GIMP_CHANNEL (new_mask), NULL);
+  gimp_channel_summary_invalidate (GIMP_CHANNEL (new_mask), NULL);
 }
 
 static void
@@ -59,6 +59,7 @@ enum
 
 
 typedef struct _GimpImagefilePrivate GimpImagefilePrivate;
+typedef struct _ThumbnailJob         ThumbnailJob;
 
 struct _GimpImagefilePrivate
 {
@@ -71,6 +72,19 @@ struct _GimpImagefilePrivate
 
   gchar         *description;
   gboolean       static_desc;
+
+  ThumbnailJob  *thumb_job;
+};
+
+struct _ThumbnailJob
+{
+  GimpImagefile *imagefile;
+  GimpContext   *context;
+  GFile         *file;
+  gint           size;
+  gboolean       replace;
+
+  GList         *link;   /* the job's link in thumb_queue while queued */
 };
 
 #define GET_PRIVATE(imagefile) G_TYPE_INSTANCE_GET_PRIVATE (imagefile, \
@@ -107,6 +121,29 @@ static gboolean    gimp_imagefile_save_thumb       (GimpImagefile  *imagefile,
                                                     gboolean        replace,
                                                     GError        **error);
 
+static gboolean    gimp_imagefile_can_create_thumbnail
+                                                   (GimpImagefile  *imagefile);
+
+static void        gimp_imagefile_thumb_queue_run  (void);
+static gboolean    gimp_imagefile_thumb_queue_idle (gpointer        data);
+static void        gimp_imagefile_thumb_job_start  (ThumbnailJob   *job);
+static void        gimp_imagefile_thumb_job_thumb_loaded
+                                                   (GimpImage      *image,
+                                                    const gchar    *mime_type,
+                                                    gint            width,
+                                                    gint            height,
+                                                    const Babl     *format,
+                                                    gint            num_layers,
+                                                    gpointer        data);
+static void        gimp_imagefile_thumb_job_image_loaded
+                                                   (GimpImage      *image,
+                                                    const gchar    *mime_type,
+                                                    gpointer        data);
+static void        gimp_imagefile_thumb_job_finish (ThumbnailJob   *job,
+                                                    GimpImage      *image);
+static void        gimp_imagefile_thumb_job_done   (ThumbnailJob   *job);
+static void        gimp_imagefile_thumb_job_free   (ThumbnailJob   *job);
+
 static void     gimp_thumbnail_set_info_from_image (GimpThumbnail  *thumbnail,
                                                     const gchar    *mime_type,
                                                     GimpImage      *image);
@@ -124,6 +161,13 @@ G_DEFINE_TYPE (GimpImagefile, gimp_imagefile, GIMP_TYPE_VIEWABLE)
 
 static guint gimp_imagefile_signals[LAST_SIGNAL] = { 0 };
 
+/*  thumbnails queued by gimp_imagefile_queue_thumbnail(), and the
+ *  number of them currently being created
+ */
+static GQueue thumb_queue     = G_QUEUE_INIT;
+static gint   thumb_n_running = 0;
+static guint  thumb_idle_id   = 0;
+
 
 static void
 gimp_imagefile_class_init (GimpImagefileClass *klass)
@@ -217,6 +261,8 @@ gimp_imagefile_name_changed (GimpObject *object)
   if (GIMP_OBJECT_CLASS (parent_class)->name_changed)
     GIMP_OBJECT_CLASS (parent_class)->name_changed (object);
 
+  gimp_imagefile_cancel_thumbnail (GIMP_IMAGEFILE (object));
+
   gimp_thumbnail_set_uri (private->thumbnail, gimp_object_get_name (object));
 
   g_clear_object (&private->file);
@@ -414,7 +460,6 @@ gimp_imagefile_create_thumbnail (GimpImagefile  *imagefile,
 {
   GimpImagefilePrivate *private;
   GimpThumbnail        *thumbnail;
-  GimpThumbState        image_state;
 
   g_return_val_if_fail (GIMP_IS_IMAGEFILE (imagefile), FALSE);
   g_return_val_if_fail (GIMP_IS_CONTEXT (context), FALSE);
@@ -429,13 +474,7 @@ gimp_imagefile_create_thumbnail (GimpImagefile  *imagefile,
 
   thumbnail = private->thumbnail;
 
-  gimp_thumbnail_set_uri (thumbnail,
-                          gimp_object_get_name (imagefile));
-
-  image_state = gimp_thumbnail_peek_image (thumbnail);
-
-  if (image_state == GIMP_THUMB_STATE_REMOTE ||
-      image_state >= GIMP_THUMB_STATE_EXISTS)
+  if (gimp_imagefile_can_create_thumbnail (imagefile))
     {
       GimpImage     *image;
       gboolean       success;
@@ -445,29 +484,6 @@ gimp_imagefile_create_thumbnail (GimpImagefile  *imagefile,
       const Babl    *format     = NULL;
       gint           num_layers = -1;
 
-      /*  we only want to attempt thumbnailing on readable, regular files  */
-      if (g_file_is_native (private->file))
-        {
-          GFileInfo *file_info;
-          gboolean   regular;
-          gboolean   readable;
-
-          file_info = g_file_query_info (private->file,
-                                         G_FILE_ATTRIBUTE_STANDARD_TYPE ","
-                                         G_FILE_ATTRIBUTE_ACCESS_CAN_READ,
-                                         G_FILE_QUERY_INFO_NONE,
-                                         NULL, NULL);
-
-          regular  = (g_file_info_get_file_type (file_info) == G_FILE_TYPE_REGULAR);
-          readable = g_file_info_get_attribute_boolean (file_info,
-                                                        G_FILE_ATTRIBUTE_ACCESS_CAN_READ);
-
-          g_object_unref (file_info);
-
-          if (! (regular && readable))
-            return TRUE;
-        }
-
       g_object_ref (imagefile);
 
       /* don't pass the error, we're only interested in errors from
@@ -646,6 +662,103 @@ gimp_imagefile_save_thumbnail (GimpImagefile  *imagefile,
   return success;
 }
 
+/**
+ * gimp_imagefile_queue_thumbnail:
+ * @imagefile: a #GimpImagefile
+ * @context:   a #GimpContext
+ * @size:      the thumbnail size
+ * @replace:   whether to delete thumbnails of other sizes
+ *
+ * Queues the creation of @imagefile's thumbnail, like
+ * gimp_imagefile_create_thumbnail() but without blocking. Queued
+ * thumbnails are created by as many loader plug-ins at once as
+ * there are processors configured, preferring the file format's
+ * thumbnail loader over loading the whole image.
+ *
+ * The imagefile is kept alive until its thumbnail is done.
+ **/
+void
+gimp_imagefile_queue_thumbnail (GimpImagefile *imagefile,
+                                GimpContext   *context,
+                                gint           size,
+                                gboolean       replace)
+{
+  GimpImagefilePrivate *private;
+  ThumbnailJob         *job;
+
+  g_return_if_fail (GIMP_IS_IMAGEFILE (imagefile));
+  g_return_if_fail (GIMP_IS_CONTEXT (context));
+
+  private = GET_PRIVATE (imagefile);
+
+  if (size < 1 || ! private->file || private->thumb_job)
+    return;
+
+  job = g_slice_new0 (ThumbnailJob);
+
+  job->imagefile = g_object_ref (imagefile);
+  job->context   = g_object_ref (context);
+  job->size      = size;
+  job->replace   = replace;
+
+  g_queue_push_tail (&thumb_queue, job);
+  job->link = thumb_queue.tail;
+
+  private->thumb_job = job;
+
+  if (! thumb_idle_id)
+    thumb_idle_id = g_idle_add_full (G_PRIORITY_LOW,
+                                     gimp_imagefile_thumb_queue_idle,
+                                     NULL, NULL);
+}
+
+/*  moves a queued thumbnail to the front of the queue, for imagefiles
+ *  which are currently visible
+ */
+void
+gimp_imagefile_prioritize_thumbnail (GimpImagefile *imagefile)
+{
+  ThumbnailJob *job;
+
+  g_return_if_fail (GIMP_IS_IMAGEFILE (imagefile));
+
+  job = GET_PRIVATE (imagefile)->thumb_job;
+
+  if (job && job->link && job->link != thumb_queue.head)
+    {
+      g_queue_unlink (&thumb_queue, job->link);
+      g_queue_push_head_link (&thumb_queue, job->link);
+    }
+}
+
+/*  removes a thumbnail from the queue, thumbnails which are already
+ *  being created are finished regardless
+ */
+void
+gimp_imagefile_cancel_thumbnail (GimpImagefile *imagefile)
+{
+  ThumbnailJob *job;
+
+  g_return_if_fail (GIMP_IS_IMAGEFILE (imagefile));
+
+  job = GET_PRIVATE (imagefile)->thumb_job;
+
+  if (job && job->link)
+    {
+      g_queue_delete_link (&thumb_queue, job->link);
+
+      gimp_imagefile_thumb_job_free (job);
+    }
+}
+
+gboolean
+gimp_imagefile_is_thumbnail_queued (GimpImagefile *imagefile)
+{
+  g_return_val_if_fail (GIMP_IS_IMAGEFILE (imagefile), FALSE);
+
+  return GET_PRIVATE (imagefile)->thumb_job != NULL;
+}
+
 
 /*  private functions  */
 
@@ -867,6 +980,235 @@ gimp_imagefile_get_desc_string (GimpImagefile *imagefile)
   return (const gchar *) private->description;
 }
 
+static gboolean
+gimp_imagefile_can_create_thumbnail (GimpImagefile *imagefile)
+{
+  GimpImagefilePrivate *private = GET_PRIVATE (imagefile);
+  GimpThumbState        image_state;
+
+  gimp_thumbnail_set_uri (private->thumbnail,
+                          gimp_object_get_name (imagefile));
+
+  image_state = gimp_thumbnail_peek_image (private->thumbnail);
+
+  if (image_state != GIMP_THUMB_STATE_REMOTE &&
+      image_state <  GIMP_THUMB_STATE_EXISTS)
+    return FALSE;
+
+  /*  we only want to attempt thumbnailing on readable, regular files  */
+  if (g_file_is_native (private->file))
+    {
+      GFileInfo *file_info;
+      gboolean   regular;
+      gboolean   readable;
+
+      file_info = g_file_query_info (private->file,
+                                     G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+                                     G_FILE_ATTRIBUTE_ACCESS_CAN_READ,
+                                     G_FILE_QUERY_INFO_NONE,
+                                     NULL, NULL);
+
+      regular  = (g_file_info_get_file_type (file_info) == G_FILE_TYPE_REGULAR);
+      readable = g_file_info_get_attribute_boolean (file_info,
+                                                    G_FILE_ATTRIBUTE_ACCESS_CAN_READ);
+
+      g_object_unref (file_info);
+
+      if (! (regular && readable))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+gimp_imagefile_thumb_queue_run (void)
+{
+  while (! g_queue_is_empty (&thumb_queue))
+    {
+      ThumbnailJob         *job     = g_queue_peek_head (&thumb_queue);
+      GimpImagefilePrivate *private = GET_PRIVATE (job->imagefile);
+      gint                  max_running;
+
+      max_running = MAX (GIMP_GEGL_CONFIG (private->gimp->config)->num_processors,
+                         1);
+
+      if (thumb_n_running >= max_running)
+        break;
+
+      g_queue_pop_head (&thumb_queue);
+      job->link = NULL;
+
+      gimp_imagefile_thumb_job_start (job);
+    }
+}
+
+static gboolean
+gimp_imagefile_thumb_queue_idle (gpointer data)
+{
+  thumb_idle_id = 0;
+
+  gimp_imagefile_thumb_queue_run ();
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gimp_imagefile_thumb_job_start (ThumbnailJob *job)
+{
+  GimpImagefilePrivate *private = GET_PRIVATE (job->imagefile);
+
+  thumb_n_running++;
+
+  if (! gimp_imagefile_can_create_thumbnail (job->imagefile))
+    {
+      gimp_imagefile_thumb_job_done (job);
+      return;
+    }
+
+  job->file = g_object_ref (private->file);
+
+  /*  prefer the format's thumbnail loader, which usually only decodes
+   *  an embedded preview or a downscaled version of the image, and
+   *  fall back to loading the whole image
+   */
+  if (file_open_thumbnail_async (private->gimp, job->context, job->file,
+                                 job->size,
+                                 gimp_imagefile_thumb_job_thumb_loaded,
+                                 job) ||
+      file_open_image_async (private->gimp, job->context, job->file,
+                             gimp_imagefile_thumb_job_image_loaded,
+                             job))
+    {
+      return;
+    }
+
+  /*  remote files need to be downloaded first, which can only be done
+   *  synchronously
+   */
+  gimp_imagefile_create_thumbnail (job->imagefile, job->context, NULL,
+                                   job->size, job->replace, NULL);
+
+  gimp_imagefile_thumb_job_done (job);
+}
+
+static void
+gimp_imagefile_thumb_job_thumb_loaded (GimpImage   *image,
+                                       const gchar *mime_type,
+                                       gint         width,
+                                       gint         height,
+                                       const Babl  *format,
+                                       gint         num_layers,
+                                       gpointer     data)
+{
+  ThumbnailJob         *job     = data;
+  GimpImagefilePrivate *private = GET_PRIVATE (job->imagefile);
+
+  if (image)
+    {
+      gimp_thumbnail_set_info (private->thumbnail,
+                               mime_type, width, height,
+                               format, num_layers);
+
+      gimp_imagefile_thumb_job_finish (job, image);
+    }
+  else if (! file_open_image_async (private->gimp, job->context, job->file,
+                                    gimp_imagefile_thumb_job_image_loaded,
+                                    job))
+    {
+      gimp_imagefile_thumb_job_finish (job, NULL);
+    }
+}
+
+static void
+gimp_imagefile_thumb_job_image_loaded (GimpImage   *image,
+                                       const gchar *mime_type,
+                                       gpointer     data)
+{
+  ThumbnailJob         *job     = data;
+  GimpImagefilePrivate *private = GET_PRIVATE (job->imagefile);
+
+  if (image)
+    gimp_thumbnail_set_info_from_image (private->thumbnail,
+                                        mime_type, image);
+
+  gimp_imagefile_thumb_job_finish (job, image);
+}
+
+static void
+gimp_imagefile_thumb_job_finish (ThumbnailJob *job,
+                                 GimpImage    *image)
+{
+  GimpImagefilePrivate *private = GET_PRIVATE (job->imagefile);
+  gboolean              success = TRUE;
+  GError               *error   = NULL;
+
+  /*  the imagefile was pointed to another file meanwhile  */
+  if (! private->file || ! g_file_equal (private->file, job->file))
+    {
+      if (image)
+        g_object_unref (image);
+    }
+  else if (image)
+    {
+      success = gimp_imagefile_save_thumb (job->imagefile,
+                                           image, job->size, job->replace,
+                                           &error);
+
+      g_object_unref (image);
+    }
+  else
+    {
+      success = gimp_thumbnail_save_failure (private->thumbnail,
+                                             "GIMP " GIMP_VERSION,
+                                             &error);
+      gimp_imagefile_update (job->imagefile);
+    }
+
+  if (! success)
+    {
+      g_object_set (private->thumbnail,
+                    "thumb-state", GIMP_THUMB_STATE_FAILED,
+                    NULL);
+
+      if (error)
+        {
+          gimp_message_literal (private->gimp,
+                                NULL, GIMP_MESSAGE_ERROR,
+                                error->message);
+          g_clear_error (&error);
+        }
+    }
+
+  gimp_imagefile_thumb_job_done (job);
+}
+
+static void
+gimp_imagefile_thumb_job_done (ThumbnailJob *job)
+{
+  gimp_imagefile_thumb_job_free (job);
+
+  thumb_n_running--;
+
+  if (! g_queue_is_empty (&thumb_queue) && ! thumb_idle_id)
+    thumb_idle_id = g_idle_add_full (G_PRIORITY_LOW,
+                                     gimp_imagefile_thumb_queue_idle,
+                                     NULL, NULL);
+}
+
+static void
+gimp_imagefile_thumb_job_free (ThumbnailJob *job)
+{
+  GET_PRIVATE (job->imagefile)->thumb_job = NULL;
+
+  g_object_unref (job->imagefile);
+  g_object_unref (job->context);
+  if (job->file)
+    g_object_unref (job->file);
+
+  g_slice_free (ThumbnailJob, job);
+}
+
 static GdkPixbuf *
 gimp_imagefile_load_thumb (GimpImagefile *imagefile,
                            gint           width,
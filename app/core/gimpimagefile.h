@@ -79,6 +79,13 @@ void            gimp_imagefile_create_thumbnail_weak (GimpImagefile  *imagefile,
                                                       GimpProgress   *progress,
                                                       gint            size,
                                                       gboolean        replace);
+void            gimp_imagefile_queue_thumbnail       (GimpImagefile  *imagefile,
+                                                      GimpContext    *context,
+                                                      gint            size,
+                                                      gboolean        replace);
+void            gimp_imagefile_prioritize_thumbnail  (GimpImagefile  *imagefile);
+void            gimp_imagefile_cancel_thumbnail      (GimpImagefile  *imagefile);
+gboolean        gimp_imagefile_is_thumbnail_queued   (GimpImagefile  *imagefile);
 gboolean        gimp_imagefile_check_thumbnail       (GimpImagefile  *imagefile);
 gboolean        gimp_imagefile_save_thumbnail        (GimpImagefile  *imagefile,
                                                       const gchar    *mime_type,
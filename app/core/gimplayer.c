@@ -1819,8 +1819,6 @@ gimp_layer_create_mask (GimpLayer       *layer,
                               GEGL_RECTANGLE (copy_x - offset_x,
                                               copy_y - offset_y,
                                               0, 0));
-
-            GIMP_CHANNEL (mask)->bounds_known = FALSE;
           }
       }
       break;
@@ -1872,11 +1870,16 @@ gimp_layer_create_mask (GimpLayer       *layer,
 
         g_object_unref (src_buffer);
       }
-
-      GIMP_CHANNEL (mask)->bounds_known = FALSE;
       break;
     }
 
+  /*  the mask's buffer was written to directly, which leaves its
+   *  bounds and per-tile summaries stale
+   */
+  GIMP_CHANNEL (mask)->bounds_known = FALSE;
+
+  gimp_drawable_update (GIMP_DRAWABLE (mask), 0, 0, -1, -1);
+
   return mask;
 }
 
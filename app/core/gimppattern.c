@@ -26,6 +26,7 @@
 
 #include "core-types.h"
 
+#include "gimp-memsize.h"
 #include "gimppattern.h"
 #include "gimppattern-load.h"
 #include "gimptagged.h"
@@ -34,6 +35,12 @@
 #include "gimp-intl.h"
 
 
+/*  patterns up to this size are cached completely, of larger ones the
+ *  data cache keeps the top left corner as preview
+ */
+#define GIMP_PATTERN_CACHE_PREVIEW_SIZE 64
+
+
 static void          gimp_pattern_tagged_iface_init (GimpTaggedInterface  *iface);
 static void          gimp_pattern_finalize          (GObject              *object);
 
@@ -52,9 +59,14 @@ static gchar       * gimp_pattern_get_description   (GimpViewable         *viewa
 
 static const gchar * gimp_pattern_get_extension     (GimpData             *data);
 static GimpData    * gimp_pattern_duplicate         (GimpData             *data);
+static GVariant    * gimp_pattern_get_cache_state   (GimpData             *data);
+static gboolean      gimp_pattern_set_cache_state   (GimpData             *data,
+                                                     GVariant             *state);
 
 static gchar       * gimp_pattern_get_checksum      (GimpTagged           *tagged);
 
+static void          gimp_pattern_load_mask         (GimpPattern          *pattern);
+
 
 G_DEFINE_TYPE_WITH_CODE (GimpPattern, gimp_pattern, GIMP_TYPE_DATA,
                          G_IMPLEMENT_INTERFACE (GIMP_TYPE_TAGGED,
@@ -82,6 +94,8 @@ gimp_pattern_class_init (GimpPatternClass *klass)
 
   data_class->get_extension         = gimp_pattern_get_extension;
   data_class->duplicate             = gimp_pattern_duplicate;
+  data_class->get_cache_state       = gimp_pattern_get_cache_state;
+  data_class->set_cache_state       = gimp_pattern_set_cache_state;
 }
 
 static void
@@ -93,7 +107,11 @@ gimp_pattern_tagged_iface_init (GimpTaggedInterface *iface)
 static void
 gimp_pattern_init (GimpPattern *pattern)
 {
-  pattern->mask = NULL;
+  pattern->mask     = NULL;
+  pattern->width    = 0;
+  pattern->height   = 0;
+  pattern->preview  = NULL;
+  pattern->checksum = NULL;
 }
 
 static void
@@ -101,7 +119,9 @@ gimp_pattern_finalize (GObject *object)
 {
   GimpPattern *pattern = GIMP_PATTERN (object);
 
-  g_clear_pointer (&pattern->mask, gimp_temp_buf_unref);
+  g_clear_pointer (&pattern->mask,     gimp_temp_buf_unref);
+  g_clear_pointer (&pattern->preview,  gimp_temp_buf_unref);
+  g_clear_pointer (&pattern->checksum, g_free);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -114,6 +134,8 @@ gimp_pattern_get_memsize (GimpObject *object,
   gint64       memsize = 0;
 
   memsize += gimp_temp_buf_get_memsize (pattern->mask);
+  memsize += gimp_temp_buf_get_memsize (pattern->preview);
+  memsize += gimp_string_get_memsize (pattern->checksum);
 
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
@@ -126,8 +148,16 @@ gimp_pattern_get_size (GimpViewable *viewable,
 {
   GimpPattern *pattern = GIMP_PATTERN (viewable);
 
-  *width  = gimp_temp_buf_get_width  (pattern->mask);
-  *height = gimp_temp_buf_get_height (pattern->mask);
+  if (pattern->mask)
+    {
+      *width  = gimp_temp_buf_get_width  (pattern->mask);
+      *height = gimp_temp_buf_get_height (pattern->mask);
+    }
+  else
+    {
+      *width  = pattern->width;
+      *height = pattern->height;
+    }
 
   return TRUE;
 }
@@ -139,19 +169,36 @@ gimp_pattern_get_new_preview (GimpViewable *viewable,
                               gint          height)
 {
   GimpPattern *pattern = GIMP_PATTERN (viewable);
+  GimpTempBuf *src;
   GimpTempBuf *temp_buf;
   GeglBuffer  *src_buffer;
   GeglBuffer  *dest_buffer;
+  gint         pattern_width;
+  gint         pattern_height;
   gint         copy_width;
   gint         copy_height;
 
-  copy_width  = MIN (width,  gimp_temp_buf_get_width  (pattern->mask));
-  copy_height = MIN (height, gimp_temp_buf_get_height (pattern->mask));
+  gimp_pattern_get_size (viewable, &pattern_width, &pattern_height);
+
+  copy_width  = MIN (width,  pattern_width);
+  copy_height = MIN (height, pattern_height);
+
+  /*  only load the pixels if the cached preview is too small  */
+  if (! pattern->mask                                             &&
+      copy_width  <= gimp_temp_buf_get_width  (pattern->preview) &&
+      copy_height <= gimp_temp_buf_get_height (pattern->preview))
+    {
+      src = pattern->preview;
+    }
+  else
+    {
+      src = gimp_pattern_get_mask (pattern);
+    }
 
   temp_buf = gimp_temp_buf_new (copy_width, copy_height,
-                                gimp_temp_buf_get_format (pattern->mask));
+                                gimp_temp_buf_get_format (src));
 
-  src_buffer  = gimp_temp_buf_create_buffer (pattern->mask);
+  src_buffer  = gimp_temp_buf_create_buffer (src);
   dest_buffer = gimp_temp_buf_create_buffer (temp_buf);
 
   gegl_buffer_copy (src_buffer,  GEGL_RECTANGLE (0, 0, copy_width, copy_height),
@@ -169,11 +216,14 @@ gimp_pattern_get_description (GimpViewable  *viewable,
                               gchar        **tooltip)
 {
   GimpPattern *pattern = GIMP_PATTERN (viewable);
+  gint         width;
+  gint         height;
+
+  gimp_pattern_get_size (viewable, &width, &height);
 
   return g_strdup_printf ("%s (%d × %d)",
                           gimp_object_get_name (pattern),
-                          gimp_temp_buf_get_width  (pattern->mask),
-                          gimp_temp_buf_get_height (pattern->mask));
+                          width, height);
 }
 
 static const gchar *
@@ -187,11 +237,125 @@ gimp_pattern_duplicate (GimpData *data)
 {
   GimpPattern *pattern = g_object_new (GIMP_TYPE_PATTERN, NULL);
 
-  pattern->mask = gimp_temp_buf_copy (GIMP_PATTERN (data)->mask);
+  pattern->mask = gimp_temp_buf_copy (gimp_pattern_get_mask (GIMP_PATTERN (data)));
 
   return GIMP_DATA (pattern);
 }
 
+static GVariant *
+gimp_pattern_get_cache_state (GimpData *data)
+{
+  GimpPattern *pattern = GIMP_PATTERN (data);
+  GimpTempBuf *preview;
+  GVariant    *state;
+  gchar       *checksum;
+  gint         width;
+  gint         height;
+
+  if (! pattern->mask && ! pattern->preview)
+    return NULL;
+
+  gimp_pattern_get_size (GIMP_VIEWABLE (pattern), &width, &height);
+
+  if (! pattern->mask)
+    {
+      preview = gimp_temp_buf_ref (pattern->preview);
+    }
+  else if (width  <= GIMP_PATTERN_CACHE_PREVIEW_SIZE &&
+           height <= GIMP_PATTERN_CACHE_PREVIEW_SIZE)
+    {
+      preview = gimp_temp_buf_ref (pattern->mask);
+    }
+  else
+    {
+      preview = gimp_pattern_get_new_preview (GIMP_VIEWABLE (pattern), NULL,
+                                              GIMP_PATTERN_CACHE_PREVIEW_SIZE,
+                                              GIMP_PATTERN_CACHE_PREVIEW_SIZE);
+    }
+
+  checksum = gimp_pattern_get_checksum (GIMP_TAGGED (pattern));
+
+  state = g_variant_new ("(iissii@ay)",
+                         width, height,
+                         babl_get_name (gimp_temp_buf_get_format (preview)),
+                         checksum ? checksum : "",
+                         gimp_temp_buf_get_width  (preview),
+                         gimp_temp_buf_get_height (preview),
+                         g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
+                                                    gimp_temp_buf_get_data (preview),
+                                                    gimp_temp_buf_get_data_size (preview),
+                                                    1));
+
+  g_free (checksum);
+  gimp_temp_buf_unref (preview);
+
+  return state;
+}
+
+static gboolean
+gimp_pattern_set_cache_state (GimpData *data,
+                              GVariant *state)
+{
+  GimpPattern  *pattern = GIMP_PATTERN (data);
+  GimpTempBuf  *preview;
+  GVariant     *pixels;
+  const Babl   *format  = NULL;
+  const gchar  *format_name;
+  const gchar  *checksum;
+  gconstpointer bytes;
+  gsize         n_bytes;
+  gint          width;
+  gint          height;
+  gint          preview_width;
+  gint          preview_height;
+
+  if (! g_variant_is_of_type (state, G_VARIANT_TYPE ("(iissiiay)")))
+    return FALSE;
+
+  g_variant_get (state, "(ii&s&sii@ay)",
+                 &width, &height,
+                 &format_name,
+                 &checksum,
+                 &preview_width, &preview_height,
+                 &pixels);
+
+  if (babl_format_exists (format_name))
+    format = babl_format (format_name);
+
+  bytes = g_variant_get_fixed_array (pixels, &n_bytes, 1);
+
+  if (! format                                          ||
+      preview_width  < 1 || preview_width  > width      ||
+      preview_height < 1 || preview_height > height     ||
+      n_bytes != ((gsize) preview_width * preview_height *
+                  babl_format_get_bytes_per_pixel (format)))
+    {
+      g_variant_unref (pixels);
+
+      return FALSE;
+    }
+
+  preview = gimp_temp_buf_new (preview_width, preview_height, format);
+
+  memcpy (gimp_temp_buf_get_data (preview), bytes, n_bytes);
+
+  g_variant_unref (pixels);
+
+  if (preview_width == width && preview_height == height)
+    {
+      pattern->mask = preview;
+    }
+  else
+    {
+      pattern->width    = width;
+      pattern->height   = height;
+      pattern->preview  = preview;
+      pattern->checksum = g_strdup (checksum);
+    }
+
+  return TRUE;
+}
+
 static gchar *
 gimp_pattern_get_checksum (GimpTagged *tagged)
 {
@@ -209,6 +373,10 @@ gimp_pattern_get_checksum (GimpTagged *tagged)
 
       g_checksum_free (checksum);
     }
+  else if (pattern->checksum)
+    {
+      checksum_string = g_strdup (pattern->checksum);
+    }
 
   return checksum_string;
 }
@@ -266,6 +434,9 @@ gimp_pattern_get_mask (GimpPattern *pattern)
 {
   g_return_val_if_fail (GIMP_IS_PATTERN (pattern), NULL);
 
+  if (G_UNLIKELY (! g_atomic_pointer_get (&pattern->mask)))
+    gimp_pattern_load_mask (pattern);
+
   return pattern->mask;
 }
 
@@ -274,5 +445,79 @@ gimp_pattern_create_buffer (GimpPattern *pattern)
 {
   g_return_val_if_fail (GIMP_IS_PATTERN (pattern), NULL);
 
-  return gimp_temp_buf_create_buffer (pattern->mask);
+  return gimp_temp_buf_create_buffer (gimp_pattern_get_mask (pattern));
+}
+
+
+/*  private functions  */
+
+/*  loads the pixels of a pattern which was restored from the data
+ *  cache with only a preview
+ */
+static void
+gimp_pattern_load_mask (GimpPattern *pattern)
+{
+  static GMutex  mutex;
+  GFile         *file;
+  GInputStream  *input = NULL;
+  GimpTempBuf   *mask  = NULL;
+  GList         *list  = NULL;
+  GError        *error = NULL;
+
+  /*  only patterns restored from the data cache have a preview
+   *  instead of a mask
+   */
+  if (! pattern->preview)
+    return;
+
+  g_mutex_lock (&mutex);
+
+  if (pattern->mask)
+    {
+      g_mutex_unlock (&mutex);
+      return;
+    }
+
+  file = gimp_data_get_file (GIMP_DATA (pattern));
+
+  if (file)
+    input = G_INPUT_STREAM (g_file_read (file, NULL, &error));
+
+  if (input)
+    {
+      if (gimp_file_has_extension (file, GIMP_PATTERN_FILE_EXTENSION))
+        list = gimp_pattern_load (NULL, file, input, &error);
+      else
+        list = gimp_pattern_load_pixbuf (NULL, file, input, &error);
+
+      g_object_unref (input);
+    }
+
+  if (list)
+    {
+      GimpPattern *loaded = list->data;
+
+      mask = loaded->mask;
+      loaded->mask = NULL;
+
+      g_list_free_full (list, (GDestroyNotify) g_object_unref);
+    }
+
+  if (! mask)
+    {
+      /*  the file was changed or removed after it was cached, keep
+       *  using the preview rather than crashing in the callers
+       */
+      g_printerr ("Error loading the pixels of pattern '%s': %s\n",
+                  gimp_object_get_name (pattern),
+                  error ? error->message : "no pattern found");
+
+      mask = gimp_temp_buf_copy (pattern->preview);
+    }
+
+  g_clear_error (&error);
+
+  g_atomic_pointer_set (&pattern->mask, mask);
+
+  g_mutex_unlock (&mutex);
 }
@@ -37,6 +37,12 @@ struct _GimpPattern
   GimpData     parent_instance;
 
   GimpTempBuf *mask;
+
+  /*  restored from the data cache, the mask is loaded on first use  */
+  gint         width;
+  gint         height;
+  GimpTempBuf *preview;
+  gchar       *checksum;
 };
 
 struct _GimpPatternClass
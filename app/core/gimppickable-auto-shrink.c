@@ -22,9 +22,12 @@
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
 
+#include "libgimpbase/gimpbase.h"
+
 #include "core-types.h"
 
 #include "gimp.h"
+#include "gimpchannel.h"
 #include "gimpimage.h"
 #include "gimppickable.h"
 #include "gimppickable-auto-shrink.h"
@@ -125,6 +128,30 @@ gimp_pickable_auto_shrink (GimpPickable *pickable,
       break;
     }
 
+  /*  a channel is black outside of its bounds, which are known without
+   *  looking at every pixel
+   */
+  if (GIMP_IS_CHANNEL (pickable) &&
+      colors_equal_func == gimp_pickable_colors_equal &&
+      bgcolor[RED] == 0 && bgcolor[GREEN] == 0 && bgcolor[BLUE] == 0)
+    {
+      gint bx, by, bw, bh;
+
+      if (! gimp_item_bounds (GIMP_ITEM (pickable), &bx, &by, &bw, &bh) ||
+          ! gimp_rectangle_intersect (x1, y1, x2 - x1, y2 - y1,
+                                      bx, by, bw, bh,
+                                      &bx, &by, &bw, &bh))
+        {
+          retval = GIMP_AUTO_SHRINK_EMPTY;
+          goto FINISH;
+        }
+
+      x1 = bx;
+      y1 = by;
+      x2 = bx + bw;
+      y2 = by + bh;
+    }
+
   width  = x2 - x1;
   height = y2 - y1;
 
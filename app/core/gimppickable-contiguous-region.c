@@ -18,6 +18,7 @@
 #include "config.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <cairo.h>
 #include <gegl.h>
@@ -29,69 +30,105 @@
 #include "core-types.h"
 
 #include "gegl/gimp-babl.h"
+#include "gegl/gimp-gegl-parallel.h"
 
 #include "gimp-utils.h" /* GIMP_TIMER */
 #include "gimppickable.h"
 #include "gimppickable-contiguous-region.h"
 
 
+#define CHUNK_ROWS       64         /* rows labeled at once                */
+#define MAX_CACHED_RUNS  (1 << 21)  /* runs kept before chunks are flushed */
+
+
+typedef struct
+{
+  gfloat               col[MAX_CHANNELS];
+  gint                 n_components;
+  gboolean             has_alpha;
+  gboolean             select_transparent;
+  GimpSelectCriterion  select_criterion;
+  gboolean             antialias;
+  gfloat               threshold;
+} DifferenceParams;
+
+/*  a horizontal run of pixels which differ less than the threshold  */
+typedef struct
+{
+  gint start;
+  gint end;
+} Run;
+
+/*  a run of the region which still has to be spread to its neighbors  */
+typedef struct
+{
+  gint y;
+  gint start;
+  gint end;
+} Span;
+
+/*  CHUNK_ROWS rows, whose runs are collected when the flood first
+ *  reaches them
+ */
+typedef struct
+{
+  Run      *runs;                      /* the runs of all rows, or NULL  */
+  guint8   *filled;                    /* per run, if it is selected     */
+  gint      row_runs[CHUNK_ROWS + 1];  /* first run of each row, + total */
+  gboolean  flushed;                   /* if it was written to the mask  */
+} Chunk;
+
+typedef struct
+{
+  GeglBuffer             *src_buffer;
+  GeglBuffer             *mask_buffer;
+  const Babl             *format;
+  GeglRectangle           extent;
+  const DifferenceParams *params;
+
+  Chunk                  *chunks;
+  gint                    n_chunks;
+  gint                    n_cached_runs;
+  gfloat                 *src;       /* one chunk of source pixels       */
+  gfloat                 *diff;      /* one chunk of differences         */
+  gint                   *flush;     /* the chunks flushed in parallel   */
+  gint                    n_flush;
+} RegionData;
+
+
 /*  local function prototypes  */
 
-static const Babl * choose_format         (GeglBuffer          *buffer,
-                                           GimpSelectCriterion  select_criterion,
-                                           gint                *n_components,
-                                           gboolean            *has_alpha);
-static gfloat   pixel_difference          (const gfloat        *col1,
-                                           const gfloat        *col2,
-                                           gboolean             antialias,
-                                           gfloat               threshold,
-                                           gint                 n_components,
-                                           gboolean             has_alpha,
-                                           gboolean             select_transparent,
-                                           GimpSelectCriterion  select_criterion);
-static void     push_segment              (GQueue              *segment_queue,
-                                           gint                 y,
-                                           gint                 old_y,
-                                           gint                 start,
-                                           gint                 end,
-                                           gint                 new_y,
-                                           gint                 new_start,
-                                           gint                 new_end);
-static void     pop_segment               (GQueue              *segment_queue,
-                                           gint                *y,
-                                           gint                *old_y,
-                                           gint                *start,
-                                           gint                *end);
-static gboolean find_contiguous_segment   (const gfloat        *col,
-                                           GeglBuffer          *src_buffer,
-                                           GeglBuffer          *mask_buffer,
-                                           const Babl          *src_format,
-                                           const Babl          *mask_format,
-                                           gint                 n_components,
-                                           gboolean             has_alpha,
-                                           gint                 width,
-                                           gboolean             select_transparent,
-                                           GimpSelectCriterion  select_criterion,
-                                           gboolean             antialias,
-                                           gfloat               threshold,
-                                           gint                 initial_x,
-                                           gint                 initial_y,
-                                           gint                *start,
-                                           gint                *end,
-                                           gfloat              *row);
-static void     find_contiguous_region    (GeglBuffer          *src_buffer,
-                                           GeglBuffer          *mask_buffer,
-                                           const Babl          *format,
-                                           gint                 n_components,
-                                           gboolean             has_alpha,
-                                           gboolean             select_transparent,
-                                           GimpSelectCriterion  select_criterion,
-                                           gboolean             antialias,
-                                           gfloat               threshold,
-                                           gboolean             diagonal_neighbors,
-                                           gint                 x,
-                                           gint                 y,
-                                           const gfloat        *col);
+static const Babl * choose_format         (GeglBuffer             *buffer,
+                                           GimpSelectCriterion     select_criterion,
+                                           gint                   *n_components,
+                                           gboolean               *has_alpha);
+static void     pixel_difference_row      (const DifferenceParams *params,
+                                           const gfloat           *src,
+                                           gfloat                 *dest,
+                                           gint                    n_pixels);
+static void     by_color_area             (const GeglRectangle    *area,
+                                           RegionData             *data);
+static void     difference_rows           (gsize                   offset,
+                                           gsize                   size,
+                                           RegionData             *data);
+static void     load_chunk                (RegionData             *data,
+                                           gint                    c);
+static void     flush_chunk               (RegionData             *data,
+                                           gint                    c);
+static void     flush_chunks              (gint                    i,
+                                           gint                    n,
+                                           RegionData             *data);
+static const Run * get_row_runs           (RegionData             *data,
+                                           gint                    y,
+                                           gint                   *n_runs,
+                                           guint8                **filled);
+static void     find_contiguous_region    (GeglBuffer             *src_buffer,
+                                           GeglBuffer             *mask_buffer,
+                                           const Babl             *format,
+                                           const DifferenceParams *params,
+                                           gboolean                diagonal_neighbors,
+                                           gint                    x,
+                                           gint                    y);
 
 
 /*  public functions  */
@@ -106,13 +143,11 @@ gimp_pickable_contiguous_region_by_seed (GimpPickable        *pickable,
                                          gint                 x,
                                          gint                 y)
 {
-  GeglBuffer    *src_buffer;
-  GeglBuffer    *mask_buffer;
-  const Babl    *format;
-  GeglRectangle  extent;
-  gint           n_components;
-  gboolean       has_alpha;
-  gfloat         start_col[MAX_CHANNELS];
+  GeglBuffer       *src_buffer;
+  GeglBuffer       *mask_buffer;
+  const Babl       *format;
+  GeglRectangle     extent;
+  DifferenceParams  params;
 
   g_return_val_if_fail (GIMP_IS_PICKABLE (pickable), NULL);
 
@@ -121,19 +156,19 @@ gimp_pickable_contiguous_region_by_seed (GimpPickable        *pickable,
   src_buffer = gimp_pickable_get_buffer (pickable);
 
   format = choose_format (src_buffer, select_criterion,
-                          &n_components, &has_alpha);
+                          &params.n_components, &params.has_alpha);
 
-  gegl_buffer_sample (src_buffer, x, y, NULL, start_col, format,
+  gegl_buffer_sample (src_buffer, x, y, NULL, params.col, format,
                       GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
 
-  if (has_alpha)
+  if (params.has_alpha)
     {
       if (select_transparent)
         {
           /*  don't select transparent regions if the start pixel isn't
            *  fully transparent
            */
-          if (start_col[n_components - 1] > 0)
+          if (params.col[params.n_components - 1] > 0)
             select_transparent = FALSE;
         }
     }
@@ -142,6 +177,11 @@ gimp_pickable_contiguous_region_by_seed (GimpPickable        *pickable,
       select_transparent = FALSE;
     }
 
+  params.select_transparent = select_transparent;
+  params.select_criterion   = select_criterion;
+  params.antialias          = antialias;
+  params.threshold          = threshold;
+
   extent = *gegl_buffer_get_extent (src_buffer);
 
   mask_buffer = gegl_buffer_new (&extent, babl_format ("Y float"));
@@ -151,11 +191,8 @@ gimp_pickable_contiguous_region_by_seed (GimpPickable        *pickable,
     {
       GIMP_TIMER_START();
 
-      find_contiguous_region (src_buffer, mask_buffer,
-                              format, n_components, has_alpha,
-                              select_transparent, select_criterion,
-                              antialias, threshold, diagonal_neighbors,
-                              x, y, start_col);
+      find_contiguous_region (src_buffer, mask_buffer, format, &params,
+                              diagonal_neighbors, x, y);
 
       GIMP_TIMER_END("foo");
     }
@@ -177,13 +214,10 @@ gimp_pickable_contiguous_region_by_color (GimpPickable        *pickable,
    *  fuzzy_select.  Modify the pickable's mask to reflect the
    *  additional selection
    */
-  GeglBufferIterator *iter;
-  GeglBuffer         *src_buffer;
-  GeglBuffer         *mask_buffer;
-  const Babl         *format;
-  gint                n_components;
-  gboolean            has_alpha;
-  gfloat              start_col[MAX_CHANNELS];
+  GeglBuffer       *src_buffer;
+  GeglBuffer       *mask_buffer;
+  DifferenceParams  params;
+  RegionData        data = { 0, };
 
   g_return_val_if_fail (GIMP_IS_PICKABLE (pickable), NULL);
   g_return_val_if_fail (color != NULL, NULL);
@@ -192,18 +226,18 @@ gimp_pickable_contiguous_region_by_color (GimpPickable        *pickable,
 
   src_buffer = gimp_pickable_get_buffer (pickable);
 
-  format = choose_format (src_buffer, select_criterion,
-                          &n_components, &has_alpha);
+  data.format = choose_format (src_buffer, select_criterion,
+                               &params.n_components, &params.has_alpha);
 
-  gimp_rgba_get_pixel (color, format, start_col);
+  gimp_rgba_get_pixel (color, data.format, params.col);
 
-  if (has_alpha)
+  if (params.has_alpha)
     {
       if (select_transparent)
         {
           /*  don't select transparancy if "color" isn't fully transparent
            */
-          if (start_col[n_components - 1] > 0.0)
+          if (params.col[params.n_components - 1] > 0.0)
             select_transparent = FALSE;
         }
     }
@@ -212,38 +246,24 @@ gimp_pickable_contiguous_region_by_color (GimpPickable        *pickable,
       select_transparent = FALSE;
     }
 
+  params.select_transparent = select_transparent;
+  params.select_criterion   = select_criterion;
+  params.antialias          = antialias;
+  params.threshold          = threshold;
+
   mask_buffer = gegl_buffer_new (gegl_buffer_get_extent (src_buffer),
                                  babl_format ("Y float"));
 
-  iter = gegl_buffer_iterator_new (src_buffer,
-                                   NULL, 0, format,
-                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
-
-  gegl_buffer_iterator_add (iter, mask_buffer,
-                            NULL, 0, babl_format ("Y float"),
-                            GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
-
-  while (gegl_buffer_iterator_next (iter))
-    {
-      const gfloat *src   = iter->data[0];
-      gfloat       *dest  = iter->data[1];
-      gint          count = iter->length;
+  data.src_buffer  = src_buffer;
+  data.mask_buffer = mask_buffer;
+  data.extent      = *gegl_buffer_get_extent (src_buffer);
+  data.params      = &params;
 
-      while (count--)
-        {
-          /*  Find how closely the colors match  */
-          *dest = pixel_difference (start_col, src,
-                                    antialias,
-                                    threshold,
-                                    n_components,
-                                    has_alpha,
-                                    select_transparent,
-                                    select_criterion);
-
-          src  += n_components;
-          dest += 1;
-        }
-    }
+  /*  every pixel only depends on itself  */
+  gimp_gegl_parallel_distribute_area (&data.extent, 64 * 64,
+                                      (GimpGeglParallelDistributeAreaFunc)
+                                      by_color_area,
+                                      &data);
 
   return mask_buffer;
 }
@@ -304,384 +324,506 @@ choose_format (GeglBuffer          *buffer,
   return format;
 }
 
-static gfloat
-pixel_difference (const gfloat        *col1,
-                  const gfloat        *col2,
-                  gboolean             antialias,
-                  gfloat               threshold,
-                  gint                 n_components,
-                  gboolean             has_alpha,
-                  gboolean             select_transparent,
-                  GimpSelectCriterion  select_criterion)
+/*  computes how closely each of n_pixels pixels in src matches
+ *  params->col.  The criterion is only looked at once per row, so
+ *  the inner loops are simple enough for the compiler to vectorize.
+ */
+static void
+pixel_difference_row (const DifferenceParams *params,
+                      const gfloat           *src,
+                      gfloat                 *dest,
+                      gint                    n_pixels)
 {
-  gfloat max = 0.0;
-
-  /*  if there is an alpha channel, never select transparent regions  */
-  if (! select_transparent && has_alpha && col2[n_components - 1] == 0.0)
-    return 0.0;
-
-  if (select_transparent && has_alpha)
+  const gfloat *col          = params->col;
+  gint          n_components = params->n_components;
+  gint          alpha        = n_components - 1;
+  gint          component    = 0;
+  gfloat        scale        = 1.0;
+  gboolean      wrap         = FALSE;
+  gint          i;
+
+  /*  first the distance of each pixel...  */
+  if (params->select_transparent && params->has_alpha)
     {
-      max = fabs (col1[n_components - 1] - col2[n_components - 1]);
+      for (i = 0; i < n_pixels; i++)
+        dest[i] = fabs (col[alpha] - src[i * n_components + alpha]);
     }
-  else
+  else if (params->select_criterion == GIMP_SELECT_CRITERION_COMPOSITE)
     {
-      gfloat diff;
-      gint   b;
+      gint n_colors = params->has_alpha ? n_components - 1 : n_components;
 
-      if (has_alpha)
-        n_components--;
-
-      switch (select_criterion)
+      for (i = 0; i < n_pixels; i++)
         {
-        case GIMP_SELECT_CRITERION_COMPOSITE:
-          for (b = 0; b < n_components; b++)
+          const gfloat *s   = src + i * n_components;
+          gfloat        max = 0.0;
+          gint          b;
+
+          for (b = 0; b < n_colors; b++)
             {
-              diff = fabs (col1[b] - col2[b]);
+              gfloat diff = fabs (col[b] - s[b]);
+
               if (diff > max)
                 max = diff;
             }
-          break;
 
+          dest[i] = max;
+        }
+    }
+  else
+    {
+      switch (params->select_criterion)
+        {
         case GIMP_SELECT_CRITERION_R:
-          max = fabs (col1[0] - col2[0]);
+        case GIMP_SELECT_CRITERION_LCH_L:
+          component = 0;
           break;
 
         case GIMP_SELECT_CRITERION_G:
-          max = fabs (col1[1] - col2[1]);
+        case GIMP_SELECT_CRITERION_S:
+        case GIMP_SELECT_CRITERION_LCH_C:
+          component = 1;
           break;
 
         case GIMP_SELECT_CRITERION_B:
-          max = fabs (col1[2] - col2[2]);
+        case GIMP_SELECT_CRITERION_V:
+        case GIMP_SELECT_CRITERION_LCH_H:
+          component = 2;
           break;
 
         case GIMP_SELECT_CRITERION_A:
-          max = fabs (col1[3] - col2[3]);
+          component = 3;
           break;
 
         case GIMP_SELECT_CRITERION_H:
-          max = fabs (col1[0] - col2[0]);
-          max = MIN (max, 1.0 - max);
+          component = 0;
+          wrap      = TRUE;
           break;
 
-        case GIMP_SELECT_CRITERION_S:
-          max = fabs (col1[1] - col2[1]);
+        default:
           break;
+        }
 
-        case GIMP_SELECT_CRITERION_V:
-          max = fabs (col1[2] - col2[2]);
-          break;
+      if (params->select_criterion == GIMP_SELECT_CRITERION_LCH_L ||
+          params->select_criterion == GIMP_SELECT_CRITERION_LCH_C)
+        {
+          scale = 100.0;
+        }
+      else if (params->select_criterion == GIMP_SELECT_CRITERION_LCH_H)
+        {
+          scale = 360.0;
+          wrap  = TRUE;
+        }
 
-        case GIMP_SELECT_CRITERION_LCH_L:
-          max = fabs (col1[0] - col2[0]) / 100.0;
-          break;
+      for (i = 0; i < n_pixels; i++)
+        dest[i] = fabs (col[component] - src[i * n_components + component]);
 
-        case GIMP_SELECT_CRITERION_LCH_C:
-          max = fabs (col1[1] - col2[1]) / 100.0;
-          break;
+      if (scale != 1.0)
+        {
+          for (i = 0; i < n_pixels; i++)
+            dest[i] = dest[i] / scale;
+        }
 
-        case GIMP_SELECT_CRITERION_LCH_H:
-          max = fabs (col1[2] - col2[2]) / 360.0;
-          max = MIN (max, 1.0 - max);
-          break;
+      if (wrap)
+        {
+          for (i = 0; i < n_pixels; i++)
+            dest[i] = MIN (dest[i], 1.0 - dest[i]);
         }
     }
 
-  if (antialias && threshold > 0.0)
+  /*  ...then map the distances to selection values  */
+  if (params->antialias && params->threshold > 0.0)
     {
-      gfloat aa = 1.5 - (max / threshold);
-
-      if (aa <= 0.0)
-        return 0.0;
-      else if (aa < 0.5)
-        return aa * 2.0;
-      else
-        return 1.0;
+      for (i = 0; i < n_pixels; i++)
+        {
+          gfloat aa = 1.5 - (dest[i] / params->threshold);
+
+          if (aa <= 0.0)
+            dest[i] = 0.0;
+          else if (aa < 0.5)
+            dest[i] = aa * 2.0;
+          else
+            dest[i] = 1.0;
+        }
     }
   else
     {
-      if (max > threshold)
-        return 0.0;
-      else
-        return 1.0;
+      for (i = 0; i < n_pixels; i++)
+        dest[i] = dest[i] > params->threshold ? 0.0 : 1.0;
+    }
+
+  /*  if there is an alpha channel, never select transparent regions  */
+  if (! params->select_transparent && params->has_alpha)
+    {
+      for (i = 0; i < n_pixels; i++)
+        {
+          if (src[i * n_components + alpha] == 0.0)
+            dest[i] = 0.0;
+        }
     }
 }
 
 static void
-push_segment (GQueue *segment_queue,
-              gint    y,
-              gint    old_y,
-              gint    start,
-              gint    end,
-              gint    new_y,
-              gint    new_start,
-              gint    new_end)
+by_color_area (const GeglRectangle *area,
+               RegionData          *data)
 {
-  /* To avoid excessive memory allocation (y, old_y, start, end) tuples are
-   * stored in interleaved format:
-   *
-   * [y1] [old_y1] [start1] [end1] [y2] [old_y2] [start2] [end2]
-   */
+  GeglBufferIterator *iter;
+
+  iter = gegl_buffer_iterator_new (data->src_buffer,
+                                   area, 0, data->format,
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
 
-  if (new_y != old_y)
+  gegl_buffer_iterator_add (iter, data->mask_buffer,
+                            area, 0, babl_format ("Y float"),
+                            GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+
+  while (gegl_buffer_iterator_next (iter))
     {
-      /* If the new segment's y-coordinate is different than the old (source)
-       * segment's y-coordinate, push the entire segment.
-       */
-      g_queue_push_tail (segment_queue, GINT_TO_POINTER (new_y));
-      g_queue_push_tail (segment_queue, GINT_TO_POINTER (y));
-      g_queue_push_tail (segment_queue, GINT_TO_POINTER (new_start));
-      g_queue_push_tail (segment_queue, GINT_TO_POINTER (new_end));
+      /*  Find how closely the colors match  */
+      pixel_difference_row (data->params,
+                            iter->data[0], iter->data[1], iter->length);
     }
-  else
+}
+
+/*  computes the differences of the rows [offset, offset + size) of
+ *  the chunk in data->src
+ */
+static void
+difference_rows (gsize       offset,
+                 gsize       size,
+                 RegionData *data)
+{
+  const DifferenceParams *params = data->params;
+  gint                    width  = data->extent.width;
+  gsize                   row;
+
+  for (row = offset; row < offset + size; row++)
     {
-      /* Otherwise, only push the set-difference between the new segment and
-       * the source segment (since we've already scanned the source segment.)
-       * Note that the `+ 1` and `- 1` terms of the end/start coordinates below
-       * are only necessary when `diagonal_neighbors` is on (and otherwise make
-       * the segments slightly larger than necessary), but, meh...
-       */
-      if (new_start < start)
+      pixel_difference_row (params,
+                            data->src + row * width * params->n_components,
+                            data->diff + row * width,
+                            width);
+    }
+}
+
+/*  collects the runs of a chunk.  If the chunk was flushed before,
+ *  the runs which were selected back then are read from the mask.
+ */
+static void
+load_chunk (RegionData *data,
+            gint        c)
+{
+  Chunk  *chunk  = &data->chunks[c];
+  gint    width  = data->extent.width;
+  gint    y1     = c * CHUNK_ROWS;
+  gint    n_rows = MIN (CHUNK_ROWS, data->extent.height - y1);
+  GArray *runs;
+  gint    row;
+  gint    r;
+
+  gegl_buffer_get (data->src_buffer,
+                   GEGL_RECTANGLE (data->extent.x, data->extent.y + y1,
+                                   width, n_rows),
+                   1.0, data->format, data->src,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  /*  every row only depends on itself  */
+  gimp_gegl_parallel_distribute_range (n_rows, MAX (4096 / width, 1),
+                                       (GimpGeglParallelDistributeRangeFunc)
+                                       difference_rows,
+                                       data);
+
+  runs = g_array_new (FALSE, FALSE, sizeof (Run));
+
+  for (row = 0; row < n_rows; row++)
+    {
+      const gfloat *diff = data->diff + row * width;
+      gint          x    = 0;
+
+      chunk->row_runs[row] = runs->len;
+
+      while (x < width)
         {
-          g_queue_push_tail (segment_queue, GINT_TO_POINTER (new_y));
-          g_queue_push_tail (segment_queue, GINT_TO_POINTER (y));
-          g_queue_push_tail (segment_queue, GINT_TO_POINTER (new_start));
-          g_queue_push_tail (segment_queue, GINT_TO_POINTER (start + 1));
+          Run run;
+
+          while (x < width && diff[x] == 0.0)
+            x++;
+
+          if (x == width)
+            break;
+
+          run.start = x;
+
+          while (x < width && diff[x] != 0.0)
+            x++;
+
+          run.end = x;
+
+          g_array_append_val (runs, run);
         }
+    }
 
-      if (new_end > end)
+  for (; row <= CHUNK_ROWS; row++)
+    chunk->row_runs[row] = runs->len;
+
+  chunk->filled = g_new0 (guint8, MAX (runs->len, 1));
+
+  if (chunk->flushed)
+    {
+      /*  runs are selected as a whole, so their first pixel tells  */
+      gegl_buffer_get (data->mask_buffer,
+                       GEGL_RECTANGLE (data->extent.x, data->extent.y + y1,
+                                       width, n_rows),
+                       1.0, babl_format ("Y float"), data->diff,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      for (row = 0; row < n_rows; row++)
         {
-          g_queue_push_tail (segment_queue, GINT_TO_POINTER (new_y));
-          g_queue_push_tail (segment_queue, GINT_TO_POINTER (y));
-          g_queue_push_tail (segment_queue, GINT_TO_POINTER (end - 1));
-          g_queue_push_tail (segment_queue, GINT_TO_POINTER (new_end));
+          for (r = chunk->row_runs[row]; r < chunk->row_runs[row + 1]; r++)
+            {
+              const Run *run = &g_array_index (runs, Run, r);
+
+              chunk->filled[r] = (data->diff[row * width + run->start] != 0.0);
+            }
         }
     }
+
+  data->n_cached_runs += runs->len;
+
+  chunk->runs = (Run *) g_array_free (runs, FALSE);
 }
 
+/*  writes the selected runs of a chunk to the mask and drops its runs  */
 static void
-pop_segment (GQueue *segment_queue,
-             gint   *y,
-             gint   *old_y,
-             gint   *start,
-             gint   *end)
+flush_chunk (RegionData *data,
+             gint        c)
 {
-  *y     = GPOINTER_TO_INT (g_queue_pop_head (segment_queue));
-  *old_y = GPOINTER_TO_INT (g_queue_pop_head (segment_queue));
-  *start = GPOINTER_TO_INT (g_queue_pop_head (segment_queue));
-  *end   = GPOINTER_TO_INT (g_queue_pop_head (segment_queue));
-}
+  const DifferenceParams *params = data->params;
+  Chunk                  *chunk  = &data->chunks[c];
+  gint                    width  = data->extent.width;
+  gint                    y1     = c * CHUNK_ROWS;
+  gint                    n_rows = MIN (CHUNK_ROWS, data->extent.height - y1);
+  gboolean                any    = FALSE;
+  gint                    r;
+
+  for (r = 0; r < chunk->row_runs[CHUNK_ROWS] && ! any; r++)
+    any = chunk->filled[r];
+
+  if (any)
+    {
+      gfloat *src;
+      gfloat *mask;
+      gint    row;
 
-/* #define FETCH_ROW 1 */
-
-static gboolean
-find_contiguous_segment (const gfloat        *col,
-                         GeglBuffer          *src_buffer,
-                         GeglBuffer          *mask_buffer,
-                         const Babl          *src_format,
-                         const Babl          *mask_format,
-                         gint                 n_components,
-                         gboolean             has_alpha,
-                         gint                 width,
-                         gboolean             select_transparent,
-                         GimpSelectCriterion  select_criterion,
-                         gboolean             antialias,
-                         gfloat               threshold,
-                         gint                 initial_x,
-                         gint                 initial_y,
-                         gint                *start,
-                         gint                *end,
-                         gfloat              *row)
-{
-  gfloat *s;
-  gfloat  mask_row[width];
-  gfloat  diff;
-
-#ifdef FETCH_ROW
-  gegl_buffer_get (src_buffer, GEGL_RECTANGLE (0, initial_y, width, 1), 1.0,
-                   src_format,
-                   row, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
-  s = row + initial_x * n_components;
-#else
-  s = g_alloca (n_components * sizeof (gfloat));
-
-  gegl_buffer_sample (src_buffer, initial_x, initial_y, NULL, s, src_format,
-                      GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
-#endif
+      src  = g_new (gfloat, width * n_rows * params->n_components);
+      mask = g_new0 (gfloat, width * n_rows);
 
-  diff = pixel_difference (col, s, antialias, threshold,
-                           n_components, has_alpha, select_transparent,
-                           select_criterion);
+      gegl_buffer_get (data->src_buffer,
+                       GEGL_RECTANGLE (data->extent.x, data->extent.y + y1,
+                                       width, n_rows),
+                       1.0, data->format, src,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
-  /* check the starting pixel */
-  if (! diff)
-    return FALSE;
+      for (row = 0; row < n_rows; row++)
+        {
+          for (r = chunk->row_runs[row]; r < chunk->row_runs[row + 1]; r++)
+            {
+              const Run *run = &chunk->runs[r];
+
+              if (chunk->filled[r])
+                {
+                  pixel_difference_row (params,
+                                        src + (row * width + run->start) *
+                                              params->n_components,
+                                        mask + row * width + run->start,
+                                        run->end - run->start);
+                }
+            }
+        }
 
-  mask_row[initial_x] = diff;
+      gegl_buffer_set (data->mask_buffer,
+                       GEGL_RECTANGLE (data->extent.x, data->extent.y + y1,
+                                       width, n_rows),
+                       0, babl_format ("Y float"), mask,
+                       GEGL_AUTO_ROWSTRIDE);
 
-  *start = initial_x - 1;
-#ifdef FETCH_ROW
-  s = row + *start * n_components;
-#endif
+      g_free (mask);
+      g_free (src);
 
-  while (*start >= 0)
-    {
-#ifndef FETCH_ROW
-      gegl_buffer_sample (src_buffer, *start, initial_y, NULL, s, src_format,
-                          GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
-#endif
-
-      diff = pixel_difference (col, s, antialias, threshold,
-                               n_components, has_alpha, select_transparent,
-                               select_criterion);
-      if (diff == 0.0)
-        break;
-
-      mask_row[*start] = diff;
-
-      (*start)--;
-#ifdef FETCH_ROW
-      s -= n_components;
-#endif
+      chunk->flushed = TRUE;
     }
 
-  *end = initial_x + 1;
-#ifdef FETCH_ROW
-  s = row + *end * n_components;
-#endif
+  g_clear_pointer (&chunk->runs,   g_free);
+  g_clear_pointer (&chunk->filled, g_free);
+}
+
+static void
+flush_chunks (gint        i,
+              gint        n,
+              RegionData *data)
+{
+  gint f;
+
+  for (f = i; f < data->n_flush; f += n)
+    flush_chunk (data, data->flush[f]);
+}
+
+/*  returns the runs of row y, collecting them first if needed.  Once
+ *  too many runs are kept, all other chunks are flushed to the mask,
+ *  which bounds the memory used by large regions.
+ */
+static const Run *
+get_row_runs (RegionData  *data,
+              gint         y,
+              gint        *n_runs,
+              guint8     **filled)
+{
+  gint   c     = y / CHUNK_ROWS;
+  gint   row   = y % CHUNK_ROWS;
+  Chunk *chunk = &data->chunks[c];
 
-  while (*end < width)
+  if (! chunk->runs)
     {
-#ifndef FETCH_ROW
-      gegl_buffer_sample (src_buffer, *end, initial_y, NULL, s, src_format,
-                          GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
-#endif
-
-      diff = pixel_difference (col, s, antialias, threshold,
-                               n_components, has_alpha, select_transparent,
-                               select_criterion);
-      if (diff == 0.0)
-        break;
-
-      mask_row[*end] = diff;
-
-      (*end)++;
-#ifdef FETCH_ROW
-      s += n_components;
-#endif
+      if (data->n_cached_runs > MAX_CACHED_RUNS)
+        {
+          gint i;
+
+          for (i = 0; i < data->n_chunks; i++)
+            {
+              if (data->chunks[i].runs)
+                flush_chunk (data, i);
+            }
+
+          data->n_cached_runs = 0;
+        }
+
+      load_chunk (data, c);
     }
 
-  gegl_buffer_set (mask_buffer, GEGL_RECTANGLE (*start + 1, initial_y,
-                                                *end - *start - 1, 1),
-                   0, mask_format, &mask_row[*start + 1],
-                   GEGL_AUTO_ROWSTRIDE);
+  *n_runs = chunk->row_runs[row + 1] - chunk->row_runs[row];
+  *filled = chunk->filled + chunk->row_runs[row];
 
-  return TRUE;
+  return chunk->runs + chunk->row_runs[row];
 }
 
+/*  Floods the runs of matching pixels from the run containing (x, y).
+ *  The runs are only collected for the chunks of rows the flood
+ *  reaches, and the selected runs are written to the mask at the end,
+ *  in parallel.
+ */
 static void
-find_contiguous_region (GeglBuffer          *src_buffer,
-                        GeglBuffer          *mask_buffer,
-                        const Babl          *format,
-                        gint                 n_components,
-                        gboolean             has_alpha,
-                        gboolean             select_transparent,
-                        GimpSelectCriterion  select_criterion,
-                        gboolean             antialias,
-                        gfloat               threshold,
-                        gboolean             diagonal_neighbors,
-                        gint                 x,
-                        gint                 y,
-                        const gfloat        *col)
+find_contiguous_region (GeglBuffer             *src_buffer,
+                        GeglBuffer             *mask_buffer,
+                        const Babl             *format,
+                        const DifferenceParams *params,
+                        gboolean                diagonal_neighbors,
+                        gint                    x,
+                        gint                    y)
 {
-  const Babl *mask_format = babl_format ("Y float");
-  gint        old_y;
-  gint        start, end;
-  gint        new_start, new_end;
-  GQueue     *segment_queue;
-  gfloat     *row = NULL;
+  RegionData   data = { 0, };
+  GArray      *stack;
+  const Run   *runs;
+  guint8      *filled;
+  gint         n_runs;
+  gint         d = diagonal_neighbors ? 1 : 0;
+  gint         c;
+  gint         r;
 
-#ifdef FETCH_ROW
-  row = g_new (gfloat, gegl_buffer_get_width (src_buffer) * n_components);
-#endif
+  data.src_buffer  = src_buffer;
+  data.mask_buffer = mask_buffer;
+  data.format      = format;
+  data.extent      = *gegl_buffer_get_extent (src_buffer);
+  data.params      = params;
 
-  segment_queue = g_queue_new ();
+  x -= data.extent.x;
+  y -= data.extent.y;
 
-  push_segment (segment_queue,
-                y, /* dummy values: */ -1, 0, 0,
-                y, x - 1, x + 1);
+  data.n_chunks = (data.extent.height + CHUNK_ROWS - 1) / CHUNK_ROWS;
+  data.chunks   = g_new0 (Chunk, data.n_chunks);
 
-  do
-    {
-      pop_segment (segment_queue,
-                   &y, &old_y, &start, &end);
+  data.src  = g_new (gfloat, (gsize) data.extent.width * CHUNK_ROWS *
+                             params->n_components);
+  data.diff = g_new (gfloat, (gsize) data.extent.width * CHUNK_ROWS);
+
+  stack = g_array_new (FALSE, FALSE, sizeof (Span));
 
-      for (x = start + 1; x < end; x++)
+  /*  find the run containing the seed  */
+  runs = get_row_runs (&data, y, &n_runs, &filled);
+
+  for (r = 0; r < n_runs; r++)
+    {
+      if (x >= runs[r].start && x < runs[r].end)
         {
-          gfloat val;
+          Span span = { y, runs[r].start, runs[r].end };
 
-          gegl_buffer_sample (mask_buffer, x, y, NULL, &val,
-                              mask_format,
-                              GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
-          if (val != 0.0)
-            {
-              /* If the current pixel is selected, then we've already visited
-               * the next pixel.  (Note that we assume that the maximal image
-               * width is sufficiently low that `x` won't overflow.)
-               */
-              x++;
-              continue;
-            }
+          filled[r] = TRUE;
 
-          if (! find_contiguous_segment (col, src_buffer, mask_buffer,
-                                         format, mask_format,
-                                         n_components,
-                                         has_alpha,
-                                         gegl_buffer_get_width (src_buffer),
-                                         select_transparent, select_criterion,
-                                         antialias, threshold, x, y,
-                                         &new_start, &new_end,
-                                         row))
+          g_array_append_val (stack, span);
+          break;
+        }
+    }
+
+  while (stack->len > 0)
+    {
+      Span span = g_array_index (stack, Span, stack->len - 1);
+      gint ny;
+
+      g_array_set_size (stack, stack->len - 1);
+
+      for (ny = span.y - 1; ny <= span.y + 1; ny += 2)
+        {
+          gint lo, hi;
+
+          if (ny < 0 || ny >= data.extent.height)
             continue;
 
-          /* We can skip directly to `new_end + 1` on the next iteration, since
-           * we've just selected all pixels in the range `[x, new_end)`, and
-           * the pixel at `new_end` is above threshold.  (Note that we assume
-           * that the maximal image width is sufficiently low that `x` won't
-           * overflow.)
-           */
-          x = new_end;
+          runs = get_row_runs (&data, ny, &n_runs, &filled);
+
+          /*  skip to the first run which can touch the span  */
+          lo = 0;
+          hi = n_runs;
 
-          if (diagonal_neighbors)
+          while (lo < hi)
             {
-              if (new_start >= 0)
-                new_start--;
+              gint mid = (lo + hi) / 2;
 
-              if (new_end < gegl_buffer_get_width (src_buffer))
-                new_end++;
+              if (runs[mid].end + d <= span.start)
+                lo = mid + 1;
+              else
+                hi = mid;
             }
 
-          if (y + 1 < gegl_buffer_get_height (src_buffer))
+          for (r = lo; r < n_runs && runs[r].start < span.end + d; r++)
             {
-              push_segment (segment_queue,
-                            y, old_y, start, end,
-                            y + 1, new_start, new_end);
-            }
+              if (! filled[r])
+                {
+                  Span next = { ny, runs[r].start, runs[r].end };
 
-          if (y - 1 >= 0)
-            {
-              push_segment (segment_queue,
-                            y, old_y, start, end,
-                            y - 1, new_start, new_end);
-            }
+                  filled[r] = TRUE;
 
+                  g_array_append_val (stack, next);
+                }
+            }
         }
     }
-  while (! g_queue_is_empty (segment_queue));
 
-  g_queue_free (segment_queue);
+  g_array_free (stack, TRUE);
+
+  g_free (data.diff);
+  g_free (data.src);
+
+  data.flush = g_new (gint, data.n_chunks);
+
+  for (c = 0; c < data.n_chunks; c++)
+    {
+      if (data.chunks[c].runs)
+        data.flush[data.n_flush++] = c;
+    }
+
+  gimp_gegl_parallel_distribute (data.n_flush,
+                                 (GimpGeglParallelDistributeFunc)
+                                 flush_chunks,
+                                 &data);
 
-#ifdef FETCH_ROW
-  g_free (row);
-#endif
+  g_free (data.flush);
+  g_free (data.chunks);
 }
@@ -29,6 +29,8 @@
 
 #include "core-types.h"
 
+#include "gegl/gimp-gegl-parallel.h"
+
 #include "gimpboundary.h"
 #include "gimpbezierdesc.h"
 #include "gimpscanconvert.h"
@@ -56,6 +58,46 @@ struct _GimpScanConvert
   GArray         *path_data;
 };
 
+/*  a subpath of path_data, with its bounding box in buffer coordinates  */
+typedef struct
+{
+  gint     start;
+  gint     num_data;
+  gdouble  x1, y1;
+  gdouble  x2, y2;
+} SubPath;
+
+typedef struct
+{
+  GimpScanConvert *sc;
+  GeglBuffer      *buffer;
+  gint             off_x;
+  gint             off_y;
+  gboolean         replace;
+  gboolean         antialias;
+  gdouble          value;
+  GArray          *subpaths;
+} RenderData;
+
+
+#define RENDER_MIN_SUB_AREA (128 * 128)
+
+#define SUBPATH_INTERSECTS(subpath, rect)              \
+  ((subpath)->x1 < (rect)->x + (rect)->width  &&       \
+   (subpath)->x2 > (rect)->x                  &&       \
+   (subpath)->y1 < (rect)->y + (rect)->height &&       \
+   (subpath)->y2 > (rect)->y)
+
+
+/*  local function prototypes  */
+
+static GArray * gimp_scan_convert_get_subpaths (GimpScanConvert     *sc,
+                                                gint                 off_x,
+                                                gint                 off_y,
+                                                GeglRectangle       *bounds);
+static void     gimp_scan_convert_render_area  (const GeglRectangle *area,
+                                                RenderData          *data);
+
 
 /*  public functions  */
 
@@ -496,15 +538,10 @@ gimp_scan_convert_render_full (GimpScanConvert *sc,
                                gboolean         antialias,
                                gdouble          value)
 {
-  const Babl         *format;
-  GeglBufferIterator *iter;
-  GeglRectangle      *roi;
-  cairo_t            *cr;
-  cairo_surface_t    *surface;
-  cairo_path_t        path;
-  gint                bpp;
-  gint                x, y;
-  gint                width, height;
+  RenderData     data;
+  GeglRectangle  render_rect;
+  gint           x, y;
+  gint           width, height;
 
   g_return_if_fail (sc != NULL);
   g_return_if_fail (GEGL_IS_BUFFER (buffer));
@@ -520,23 +557,164 @@ gimp_scan_convert_render_full (GimpScanConvert *sc,
                                               &x, &y, &width, &height))
     return;
 
-  path.status   = CAIRO_STATUS_SUCCESS;
-  path.data     = (cairo_path_data_t *) sc->path_data->data;
-  path.num_data = sc->path_data->len;
+  if (replace)
+    gegl_buffer_clear (buffer, NULL);
+
+  data.sc        = sc;
+  data.buffer    = buffer;
+  data.off_x     = off_x;
+  data.off_y     = off_y;
+  data.replace   = replace;
+  data.antialias = antialias;
+  data.value     = value;
+  data.subpaths  = gimp_scan_convert_get_subpaths (sc, off_x, off_y,
+                                                   &render_rect);
+
+  /*  only the tiles touched by the path need to be rendered  */
+  if (gegl_rectangle_intersect (&render_rect, &render_rect,
+                                GEGL_RECTANGLE (x, y, width, height)))
+    {
+      gimp_gegl_parallel_distribute_area (&render_rect, RENDER_MIN_SUB_AREA,
+                                          (GimpGeglParallelDistributeAreaFunc)
+                                          gimp_scan_convert_render_area,
+                                          &data);
+    }
+
+  g_array_free (data.subpaths, TRUE);
+}
+
+
+/*  private functions  */
+
+/*  splits the path into its subpaths, together with their bounding
+ *  boxes in buffer coordinates, and returns the union of the boxes
+ */
+static GArray *
+gimp_scan_convert_get_subpaths (GimpScanConvert *sc,
+                                gint             off_x,
+                                gint             off_y,
+                                GeglRectangle   *bounds)
+{
+  const cairo_path_data_t *data     = (cairo_path_data_t *) sc->path_data->data;
+  gint                     num_data = sc->path_data->len;
+  GArray                  *subpaths;
+  SubPath                  subpath  = { 0, };
+  gdouble                  margin;
+  gdouble                  x1 = G_MAXDOUBLE, y1 = G_MAXDOUBLE;
+  gdouble                  x2 = -G_MAXDOUBLE, y2 = -G_MAXDOUBLE;
+  gint                     i;
+
+  subpaths = g_array_new (FALSE, FALSE, sizeof (SubPath));
+
+  /*  how far the rendering can reach beyond the path's points: the
+   *  miter or square cap of the pen, plus a pixel for antialiasing
+   */
+  margin = 1.0;
+
+  if (sc->do_stroke)
+    margin += (sc->width / 2.0 *
+               MAX (sc->miter, G_SQRT2) *
+               MAX (sc->ratio_xy, 1.0));
+
+  for (i = 0; i <= num_data; i += data[i].header.length)
+    {
+      gint j;
+
+      if (i == num_data || data[i].header.type == CAIRO_PATH_MOVE_TO)
+        {
+          if (i > subpath.start)
+            {
+              subpath.num_data = i - subpath.start;
+
+              subpath.x1 -= margin;
+              subpath.y1 -= margin;
+              subpath.x2 += margin;
+              subpath.y2 += margin;
+
+              x1 = MIN (x1, subpath.x1);
+              y1 = MIN (y1, subpath.y1);
+              x2 = MAX (x2, subpath.x2);
+              y2 = MAX (y2, subpath.y2);
 
-  format = babl_format ("Y u8");
-  bpp    = babl_format_get_bytes_per_pixel (format);
+              g_array_append_val (subpaths, subpath);
+            }
+
+          if (i == num_data)
+            break;
+
+          subpath.start = i;
+          subpath.x1    = G_MAXDOUBLE;
+          subpath.y1    = G_MAXDOUBLE;
+          subpath.x2    = -G_MAXDOUBLE;
+          subpath.y2    = -G_MAXDOUBLE;
+        }
+
+      /*  the control points of curves contain the curve  */
+      for (j = 1; j < data[i].header.length; j++)
+        {
+          gdouble px = data[i + j].point.x - off_x;
+          gdouble py = data[i + j].point.y - off_y;
+
+          subpath.x1 = MIN (subpath.x1, px);
+          subpath.y1 = MIN (subpath.y1, py);
+          subpath.x2 = MAX (subpath.x2, px);
+          subpath.y2 = MAX (subpath.y2, py);
+        }
+    }
 
-  iter = gegl_buffer_iterator_new (buffer, NULL, 0, format,
+  if (x1 <= x2 && y1 <= y2)
+    {
+      bounds->x      = floor (x1);
+      bounds->y      = floor (y1);
+      bounds->width  = ceil (x2) - bounds->x;
+      bounds->height = ceil (y2) - bounds->y;
+    }
+  else
+    {
+      bounds->x      = 0;
+      bounds->y      = 0;
+      bounds->width  = 0;
+      bounds->height = 0;
+    }
+
+  return subpaths;
+}
+
+static void
+gimp_scan_convert_render_area (const GeglRectangle *area,
+                               RenderData          *data)
+{
+  GimpScanConvert    *sc     = data->sc;
+  const Babl         *format = babl_format ("Y u8");
+  const SubPath      *subpaths;
+  GeglBufferIterator *iter;
+  GeglRectangle      *roi;
+  cairo_t            *cr;
+  cairo_surface_t    *surface;
+  gint                bpp;
+
+  bpp      = babl_format_get_bytes_per_pixel (format);
+  subpaths = (const SubPath *) data->subpaths->data;
+
+  iter = gegl_buffer_iterator_new (data->buffer, area, 0, format,
                                    GEGL_ACCESS_READWRITE, GEGL_ABYSS_NONE);
   roi = &iter->roi[0];
 
   while (gegl_buffer_iterator_next (iter))
     {
-      guchar     *data    = iter->data[0];
-      guchar     *tmp_buf = NULL;
-      const gint  stride  = cairo_format_stride_for_width (CAIRO_FORMAT_A8,
-                                                           roi->width);
+      guchar     *data_ptr = iter->data[0];
+      guchar     *tmp_buf  = NULL;
+      const gint  stride   = cairo_format_stride_for_width (CAIRO_FORMAT_A8,
+                                                            roi->width);
+      gboolean    empty    = TRUE;
+      gint        i;
+
+      /*  cull the subpaths which don't touch this tile  */
+      for (i = 0; i < data->subpaths->len && empty; i++)
+        empty = ! SUBPATH_INTERSECTS (&subpaths[i], roi);
+
+      if (empty)
+        continue;
 
       /*  cairo rowstrides are always multiples of 4, whereas
        *  maskPR.rowstride can be anything, so to be able to create an
@@ -547,11 +725,10 @@ gimp_scan_convert_render_full (GimpScanConvert *sc,
         {
           tmp_buf = g_alloca (stride * roi->height);
 
-          if (! replace)
+          if (! data->replace)
             {
-              const guchar *src  = data;
+              const guchar *src  = data_ptr;
               guchar       *dest = tmp_buf;
-              gint          i;
 
               for (i = 0; i < roi->height; i++)
                 {
@@ -564,27 +741,41 @@ gimp_scan_convert_render_full (GimpScanConvert *sc,
         }
 
       surface = cairo_image_surface_create_for_data (tmp_buf ?
-                                                     tmp_buf : data,
+                                                     tmp_buf : data_ptr,
                                                      CAIRO_FORMAT_A8,
                                                      roi->width, roi->height,
                                                      stride);
 
       cairo_surface_set_device_offset (surface,
-                                       -off_x - roi->x,
-                                       -off_y - roi->y);
+                                       -data->off_x - roi->x,
+                                       -data->off_y - roi->y);
       cr = cairo_create (surface);
       cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
 
-      if (replace)
+      if (data->replace)
         {
           cairo_set_source_rgba (cr, 0, 0, 0, 0);
           cairo_paint (cr);
         }
 
-      cairo_set_source_rgba (cr, 0, 0, 0, value);
-      cairo_append_path (cr, &path);
+      cairo_set_source_rgba (cr, 0, 0, 0, data->value);
+
+      for (i = 0; i < data->subpaths->len; i++)
+        {
+          if (SUBPATH_INTERSECTS (&subpaths[i], roi))
+            {
+              cairo_path_t path;
+
+              path.status   = CAIRO_STATUS_SUCCESS;
+              path.data     = ((cairo_path_data_t *) sc->path_data->data +
+                               subpaths[i].start);
+              path.num_data = subpaths[i].num_data;
+
+              cairo_append_path (cr, &path);
+            }
+        }
 
-      cairo_set_antialias (cr, antialias ?
+      cairo_set_antialias (cr, data->antialias ?
                            CAIRO_ANTIALIAS_GRAY : CAIRO_ANTIALIAS_NONE);
       cairo_set_miter_limit (cr, sc->miter);
 
@@ -622,8 +813,7 @@ gimp_scan_convert_render_full (GimpScanConvert *sc,
       if (tmp_buf)
         {
           const guchar *src  = tmp_buf;
-          guchar       *dest = data;
-          gint          i;
+          guchar       *dest = data_ptr;
 
           for (i = 0; i < roi->height; i++)
             {
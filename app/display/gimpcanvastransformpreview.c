@@ -35,18 +35,27 @@
 #include "core/gimp-transform-utils.h"
 #include "core/gimp-utils.h"
 
+#include "gegl/gimp-gegl-parallel.h"
+
 #include "gimpcanvas.h"
 #include "gimpcanvastransformpreview.h"
 #include "gimpdisplayshell.h"
 
 
 #define INT_MULT(a,b,t)    ((t) = (a) * (b) + 0x80, ((((t) >> 8) + (t)) >> 8))
-#define INT_MULT3(a,b,c,t) ((t) = (a) * (b) * (c) + 0x7F5B, \
-                           ((((t) >> 7) + (t)) >> 16))
 
 #define MAX_SUB_COLS       6 /* number of columns and  */
 #define MAX_SUB_ROWS       6 /* rows to use in perspective preview subdivision */
 
+#define TEXTURE_TILE_SHIFT 6
+#define TEXTURE_TILE_SIZE  (1 << TEXTURE_TILE_SHIFT)
+#define TEXTURE_MAX_LEVEL  8
+#define TEXTURE_TIMEOUT    3  /* seconds an unused texture is kept around */
+#define TEXTURE_KEY        "gimp-canvas-transform-preview-texture"
+#define MASK_KEY           "gimp-canvas-transform-preview-mask"
+
+#define MIN_SUB_ROWS       32 /* minimum number of rows rendered per thread */
+
 
 enum
 {
@@ -80,6 +89,53 @@ struct _GimpCanvasTransformPreviewPrivate
                                      GimpCanvasTransformPreviewPrivate)
 
 
+/*  a downscaled copy of a drawable, made of tiles which are fetched
+ *  when first needed. It is attached to the drawable, so it survives
+ *  the preview items which are recreated on every motion event.
+ */
+typedef struct
+{
+  GimpDrawable  *drawable;
+  const gchar   *key;
+  GeglBuffer    *buffer;
+  const Babl    *format;
+  gint           bpp;
+  gint           level;    /* the texture is scaled by 1 / 2^level */
+  gint           width;
+  gint           height;
+  gint           n_cols;
+  gint           n_rows;
+  guchar       **tiles;
+  gboolean       used;
+  guint          timeout_id;
+} PreviewTexture;
+
+/*  a pixel run (x1, y) to (x2 - 1, y) on screen, starting at (u, v)
+ *  in the drawable
+ */
+typedef struct
+{
+  gint    y;
+  gint    x1, x2;
+  gfloat  u, v;
+  gfloat  du, dv;
+} PreviewSpan;
+
+typedef struct
+{
+  GArray         *spans;
+  PreviewTexture *texture;
+  PreviewTexture *mask;
+  gint            mask_offx;
+  gint            mask_offy;
+  guchar         *area_data;
+  gint            area_stride;
+  gint            area_offx;
+  gint            area_offy;
+  guchar          opacity;
+} RenderData;
+
+
 /*  local function prototypes  */
 
 static void             gimp_canvas_transform_preview_set_property (GObject        *object,
@@ -95,64 +151,55 @@ static void             gimp_canvas_transform_preview_draw         (GimpCanvasIt
                                                                     cairo_t        *cr);
 static cairo_region_t * gimp_canvas_transform_preview_get_extents  (GimpCanvasItem *item);
 
-static void   gimp_canvas_transform_preview_draw_quad         (GimpDrawable    *texture,
+static void   gimp_canvas_transform_preview_add_quad          (GArray          *spans,
                                                                cairo_t         *cr,
-                                                               GimpChannel     *mask,
-                                                               gint             mask_offx,
-                                                               gint             mask_offy,
                                                                gint            *x,
                                                                gint            *y,
                                                                gfloat          *u,
-                                                               gfloat          *v,
-                                                               guchar           opacity);
-static void   gimp_canvas_transform_preview_draw_tri          (GimpDrawable    *texture,
+                                                               gfloat          *v);
+static void   gimp_canvas_transform_preview_add_tri           (GArray          *spans,
                                                                cairo_t         *cr,
-                                                               cairo_surface_t *area,
-                                                               gint             area_offx,
-                                                               gint             area_offy,
-                                                               GimpChannel     *mask,
-                                                               gint             mask_offx,
-                                                               gint             mask_offy,
                                                                gint            *x,
                                                                gint            *y,
                                                                gfloat          *u,
-                                                               gfloat          *v,
-                                                               guchar           opacity);
-static void   gimp_canvas_transform_preview_draw_tri_row      (GimpDrawable    *texture,
-                                                               cairo_t         *cr,
-                                                               cairo_surface_t *area,
-                                                               gint             area_offx,
-                                                               gint             area_offy,
+                                                               gfloat          *v);
+static void   gimp_canvas_transform_preview_add_span          (GArray          *spans,
+                                                               gdouble          clip_x1,
+                                                               gdouble          clip_x2,
                                                                gint             x1,
                                                                gfloat           u1,
                                                                gfloat           v1,
                                                                gint             x2,
                                                                gfloat           u2,
                                                                gfloat           v2,
-                                                               gint             y,
-                                                               guchar           opacity);
-static void   gimp_canvas_transform_preview_draw_tri_row_mask (GimpDrawable    *texture,
-                                                               cairo_t         *cr,
-                                                               cairo_surface_t *area,
-                                                               gint             area_offx,
-                                                               gint             area_offy,
-                                                               GimpChannel     *mask,
-                                                               gint             mask_offx,
-                                                               gint             mask_offy,
-                                                               gint             x1,
-                                                               gfloat           u1,
-                                                               gfloat           v1,
-                                                               gint             x2,
-                                                               gfloat           u2,
-                                                               gfloat           v2,
-                                                               gint             y,
-                                                               guchar           opacity);
+                                                               gint             y);
+static void   gimp_canvas_transform_preview_render_rows       (gsize            offset,
+                                                               gsize            size,
+                                                               RenderData      *data);
 static void   gimp_canvas_transform_preview_trace_tri_edge    (gint            *dest,
                                                                gint             x1,
                                                                gint             y1,
                                                                gint             x2,
                                                                gint             y2);
 
+static PreviewTexture * preview_texture_get     (GimpDrawable   *drawable,
+                                                 const gchar    *key,
+                                                 const Babl     *format,
+                                                 gint            level);
+static void             preview_texture_free    (PreviewTexture *texture);
+static void             preview_texture_update  (GimpDrawable   *drawable,
+                                                 gint            x,
+                                                 gint            y,
+                                                 gint            width,
+                                                 gint            height,
+                                                 PreviewTexture *texture);
+static gboolean         preview_texture_timeout (PreviewTexture *texture);
+static void             preview_texture_load    (PreviewTexture *texture,
+                                                 gfloat          u1,
+                                                 gfloat          v1,
+                                                 gfloat          u2,
+                                                 gfloat          v2);
+
 
 G_DEFINE_TYPE (GimpCanvasTransformPreview, gimp_canvas_transform_preview,
                GIMP_TYPE_CANVAS_ITEM)
@@ -422,6 +469,14 @@ gimp_canvas_transform_preview_draw (GimpCanvasItem *item,
   gfloat                             u[MAX_SUB_COLS * MAX_SUB_ROWS][4];
   gfloat                             v[MAX_SUB_COLS * MAX_SUB_ROWS][4];
   guchar                             opacity;
+  GArray                            *spans;
+  RenderData                         data;
+  cairo_surface_t                   *area;
+  gdouble                            min_step;
+  gint                               level;
+  gint                               area_x1, area_y1;
+  gint                               area_x2, area_y2;
+  gfloat                             u1, v1, u2, v2;
 
   opacity = private->opacity * 255.999;
 
@@ -549,12 +604,117 @@ gimp_canvas_transform_preview_draw (GimpCanvasItem *item,
 #undef CALC_VERTEX
 #undef COPY_VERTEX
 
+  /*  pick the texture level from the most magnified subdivision,
+   *  so that it has about one texture pixel per screen pixel there
+   */
+  min_step = G_MAXDOUBLE;
+
   k = columns * rows;
   for (j = 0; j < k; j++)
-    gimp_canvas_transform_preview_draw_quad (private->drawable, cr,
-                                             mask, mask_offx, mask_offy,
-                                             x[j], y[j], u[j], v[j],
-                                             opacity);
+    {
+      gdouble screen_area;
+      gdouble texture_area;
+
+      screen_area = fabs ((x[j][0] * y[j][1] - x[j][1] * y[j][0]) +
+                          (x[j][1] * y[j][3] - x[j][3] * y[j][1]) +
+                          (x[j][3] * y[j][2] - x[j][2] * y[j][3]) +
+                          (x[j][2] * y[j][0] - x[j][0] * y[j][2]));
+      texture_area = fabs ((u[j][0] * v[j][1] - u[j][1] * v[j][0]) +
+                           (u[j][1] * v[j][3] - u[j][3] * v[j][1]) +
+                           (u[j][3] * v[j][2] - u[j][2] * v[j][3]) +
+                           (u[j][2] * v[j][0] - u[j][0] * v[j][2]));
+
+      if (screen_area > 0.0)
+        min_step = MIN (min_step, sqrt (texture_area / screen_area));
+    }
+
+  level = 0;
+
+  while (level < TEXTURE_MAX_LEVEL && (1 << (level + 1)) <= min_step)
+    level++;
+
+  /*  collect the pixel runs of all subdivisions  */
+  spans = g_array_new (FALSE, FALSE, sizeof (PreviewSpan));
+
+  for (j = 0; j < k; j++)
+    gimp_canvas_transform_preview_add_quad (spans, cr,
+                                            x[j], y[j], u[j], v[j]);
+
+  if (spans->len == 0)
+    {
+      g_array_free (spans, TRUE);
+      return;
+    }
+
+  area_x1 = area_y1 = G_MAXINT;
+  area_x2 = area_y2 = G_MININT;
+  u1 = v1 = G_MAXFLOAT;
+  u2 = v2 = -G_MAXFLOAT;
+
+  for (j = 0; j < spans->len; j++)
+    {
+      const PreviewSpan *span = &g_array_index (spans, PreviewSpan, j);
+      gint               n    = span->x2 - span->x1 - 1;
+
+      area_x1 = MIN (area_x1, span->x1);
+      area_x2 = MAX (area_x2, span->x2);
+      area_y1 = MIN (area_y1, span->y);
+      area_y2 = MAX (area_y2, span->y + 1);
+
+      u1 = MIN (u1, MIN (span->u, span->u + span->du * n));
+      u2 = MAX (u2, MAX (span->u, span->u + span->du * n));
+      v1 = MIN (v1, MIN (span->v, span->v + span->dv * n));
+      v2 = MAX (v2, MAX (span->v, span->v + span->dv * n));
+    }
+
+  /*  fetch the parts of the textures the runs are going to sample,
+   *  so the rendering threads only have to read them
+   */
+  data.spans     = spans;
+  data.texture   = preview_texture_get (private->drawable, TEXTURE_KEY,
+                                        babl_format ("cairo-ARGB32"),
+                                        level);
+  data.mask      = NULL;
+  data.mask_offx = mask_offx;
+  data.mask_offy = mask_offy;
+  data.opacity   = opacity;
+
+  preview_texture_load (data.texture, u1, v1, u2, v2);
+
+  if (mask)
+    {
+      data.mask = preview_texture_get (GIMP_DRAWABLE (mask), MASK_KEY,
+                                       babl_format ("Y u8"),
+                                       level);
+
+      preview_texture_load (data.mask,
+                            u1 + mask_offx, v1 + mask_offy,
+                            u2 + mask_offx, v2 + mask_offy);
+    }
+
+  area = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                     area_x2 - area_x1,
+                                     area_y2 - area_y1);
+
+  cairo_surface_flush (area);
+
+  data.area_data   = cairo_image_surface_get_data (area);
+  data.area_stride = cairo_image_surface_get_stride (area);
+  data.area_offx   = area_x1;
+  data.area_offy   = area_y1;
+
+  gimp_gegl_parallel_distribute_range (area_y2 - area_y1, MIN_SUB_ROWS,
+                                       (GimpGeglParallelDistributeRangeFunc)
+                                       gimp_canvas_transform_preview_render_rows,
+                                       &data);
+
+  cairo_surface_mark_dirty (area);
+
+  cairo_set_source_surface (cr, area, area_x1, area_y1);
+  cairo_paint (cr);
+
+  cairo_surface_destroy (area);
+  g_array_free (spans, TRUE);
 }
 
 static cairo_region_t *
@@ -598,110 +758,60 @@ gimp_canvas_transform_preview_new (GimpDisplayShell  *shell,
 /*  private functions  */
 
 /**
- * gimp_canvas_transform_preview_draw_quad:
- * @texture:   the #GimpDrawable to be previewed
- * @cr:        the #cairo_t to draw to
- * @mask:      a #GimpChannel
- * @opacity:   the opacity of the preview
+ * gimp_canvas_transform_preview_add_quad:
+ * @spans: the #GArray of #PreviewSpan to add to
+ * @cr:    the #cairo_t which is going to be drawn to
  *
- * Take a quadrilateral, divide it into two triangles, and draw those
- * with gimp_canvas_transform_preview_draw_tri().
+ * Take a quadrilateral, divide it into two triangles, and add the
+ * pixel runs of those with gimp_canvas_transform_preview_add_tri().
  **/
 static void
-gimp_canvas_transform_preview_draw_quad (GimpDrawable *texture,
-                                         cairo_t      *cr,
-                                         GimpChannel  *mask,
-                                         gint          mask_offx,
-                                         gint          mask_offy,
-                                         gint         *x,
-                                         gint         *y,
-                                         gfloat       *u,
-                                         gfloat       *v,
-                                         guchar        opacity)
+gimp_canvas_transform_preview_add_quad (GArray  *spans,
+                                        cairo_t *cr,
+                                        gint    *x,
+                                        gint    *y,
+                                        gfloat  *u,
+                                        gfloat  *v)
 {
+  gint    x1[3], y1[3];
+  gfloat  u1[3], v1[3];
   gint    x2[3], y2[3];
   gfloat  u2[3], v2[3];
-  gint    minx, maxx, miny, maxy; /* screen bounds of the quad        */
-  gdouble clip_x1, clip_y1, clip_x2, clip_y2;
   gint    c;
 
-  x2[0] = x[3];  y2[0] = y[3];  u2[0] = u[3];  v2[0] = v[3];
-  x2[1] = x[2];  y2[1] = y[2];  u2[1] = u[2];  v2[1] = v[2];
-  x2[2] = x[1];  y2[2] = y[1];  u2[2] = u[1];  v2[2] = v[1];
-
-   /* Allocate a box around the quad to compute preview data into
-    * and fill it with the original window contents.
-    */
-
-  cairo_clip_extents (cr, &clip_x1, &clip_y1, &clip_x2, &clip_y2);
-
-  /* find bounds of quad in order to only grab as much of dest as needed */
-
-  minx = maxx = x[0];
-  miny = maxy = y[0];
-  for (c = 1; c < 4; c++)
+  /*  add_tri() sorts the vertices, so pass it copies  */
+  for (c = 0; c < 3; c++)
     {
-      if (x[c] < minx) minx = x[c];
-      else if (x[c] > maxx) maxx = x[c];
-
-      if (y[c] < miny) miny = y[c];
-      else if (y[c] > maxy) maxy = y[c];
+      x1[c] = x[c];  y1[c] = y[c];  u1[c] = u[c];  v1[c] = v[c];
     }
-  if (minx < clip_x1) minx = clip_x1;
-  if (miny < clip_y1) miny = clip_y1;
-  if (maxx > clip_x2) maxx = clip_x2;
-  if (maxy > clip_y2) maxy = clip_y2;
-
-  if (minx <= maxx && miny <= maxy)
-    {
-      cairo_surface_t *area;
 
-      area = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
-                                         maxx - minx + 1,
-                                         maxy - miny + 1);
-
-      g_return_if_fail (area != NULL);
-
-      gimp_canvas_transform_preview_draw_tri (texture, cr, area, minx, miny,
-                                              mask, mask_offx, mask_offy,
-                                              x, y, u, v, opacity);
-      gimp_canvas_transform_preview_draw_tri (texture, cr, area, minx, miny,
-                                              mask, mask_offx, mask_offy,
-                                              x2, y2, u2, v2, opacity);
+  x2[0] = x[3];  y2[0] = y[3];  u2[0] = u[3];  v2[0] = v[3];
+  x2[1] = x[2];  y2[1] = y[2];  u2[1] = u[2];  v2[1] = v[2];
+  x2[2] = x[1];  y2[2] = y[1];  u2[2] = u[1];  v2[2] = v[1];
 
-      cairo_surface_destroy (area);
-    }
+  gimp_canvas_transform_preview_add_tri (spans, cr, x1, y1, u1, v1);
+  gimp_canvas_transform_preview_add_tri (spans, cr, x2, y2, u2, v2);
 }
 
 /**
- * gimp_canvas_transform_preview_draw_tri:
- * @texture:   the thing being transformed
- * @cr:        the #cairo_t to draw to
- * @area:      has prefetched pixel data of dest
- * @area_offx: x coordinate of area in dest
- * @area_offy: y coordinate of area in dest
- * @x:         Array of the three x coords of triangle
- * @y:         Array of the three y coords of triangle
+ * gimp_canvas_transform_preview_add_tri:
+ * @spans: the #GArray of #PreviewSpan to add to
+ * @cr:    the #cairo_t which is going to be drawn to
+ * @x:     Array of the three x coords of triangle
+ * @y:     Array of the three y coords of triangle
+ * @u:     Array of the three texture x coords of triangle
+ * @v:     Array of the three texture y coords of triangle
  *
- * This draws a triangle onto dest by breaking it down into pixel
- * rows, and then calling gimp_canvas_transform_preview_draw_tri_row()
- * and gimp_canvas_transform_preview_draw_tri_row_mask() to do the
- * actual pixel changing.
+ * This breaks a triangle down into pixel rows, and adds the visible
+ * part of each row to @spans.
  **/
 static void
-gimp_canvas_transform_preview_draw_tri (GimpDrawable    *texture,
-                                        cairo_t         *cr,
-                                        cairo_surface_t *area,
-                                        gint             area_offx,
-                                        gint             area_offy,
-                                        GimpChannel     *mask,
-                                        gint             mask_offx,
-                                        gint             mask_offy,
-                                        gint            *x,
-                                        gint            *y,
-                                        gfloat          *u, /* texture coords */
-                                        gfloat          *v, /* 0.0 ... tex width, height */
-                                        guchar           opacity)
+gimp_canvas_transform_preview_add_tri (GArray  *spans,
+                                       cairo_t *cr,
+                                       gint    *x,
+                                       gint    *y,
+                                       gfloat  *u, /* texture coords */
+                                       gfloat  *v) /* 0.0 ... tex width, height */
 {
   gdouble      clip_x1, clip_y1, clip_x2, clip_y2;
   gint         j, k;
@@ -711,9 +821,6 @@ gimp_canvas_transform_preview_draw_tri (GimpDrawable    *texture,
   gfloat       dul, dvl, dur, dvr; /* left and right texture coord deltas  */
   gfloat       u_l, v_l, u_r, v_r; /* left and right texture coord pairs  */
 
-  g_return_if_fail (GIMP_IS_DRAWABLE (texture));
-  g_return_if_fail (area != NULL);
-
   g_return_if_fail (x != NULL && y != NULL && u != NULL && v != NULL);
 
   cairo_clip_extents (cr, &clip_x1, &clip_y1, &clip_x2, &clip_y2);
@@ -739,8 +846,6 @@ gimp_canvas_transform_preview_draw_tri (GimpDrawable    *texture,
   l_edge = g_new (gint, y[2] - y[0]);
   r_edge = g_new (gint, y[2] - y[0]);
 
-  /* draw the triangle */
-
   gimp_canvas_transform_preview_trace_tri_edge (l_edge, x[0], y[0], x[2], y[2]);
 
   left = l_edge;
@@ -759,35 +864,17 @@ gimp_canvas_transform_preview_draw_tri (GimpDrawable    *texture,
       u_r   = u[0];
       v_r   = v[0];
 
-      if (mask)
-        for (ry = y[0]; ry < y[1]; ry++)
-          {
-            if (ry >= clip_y1 && ry < clip_y2)
-              gimp_canvas_transform_preview_draw_tri_row_mask (texture, cr,
-                                                               area, area_offx, area_offy,
-                                                               mask, mask_offx, mask_offy,
-                                                               *left, u_l, v_l,
-                                                               *right, u_r, v_r,
-                                                               ry,
-                                                               opacity);
-            left ++;      right ++;
-            u_l += dul;   v_l += dvl;
-            u_r += dur;   v_r += dvr;
-          }
-      else
-        for (ry = y[0]; ry < y[1]; ry++)
-          {
-            if (ry >= clip_y1 && ry < clip_y2)
-              gimp_canvas_transform_preview_draw_tri_row (texture, cr,
-                                                          area, area_offx, area_offy,
-                                                          *left, u_l, v_l,
-                                                          *right, u_r, v_r,
-                                                          ry,
-                                                          opacity);
-            left ++;      right ++;
-            u_l += dul;   v_l += dvl;
-            u_r += dur;   v_r += dvr;
-          }
+      for (ry = y[0]; ry < y[1]; ry++)
+        {
+          if (ry >= clip_y1 && ry < clip_y2)
+            gimp_canvas_transform_preview_add_span (spans, clip_x1, clip_x2,
+                                                    *left,  u_l, v_l,
+                                                    *right, u_r, v_r,
+                                                    ry);
+          left ++;      right ++;
+          u_l += dul;   v_l += dvl;
+          u_r += dur;   v_r += dvr;
+        }
     }
 
   if (y[1] != y[2])
@@ -800,35 +887,17 @@ gimp_canvas_transform_preview_draw_tri (GimpDrawable    *texture,
       u_r   = u[1];
       v_r   = v[1];
 
-      if (mask)
-        for (ry = y[1]; ry < y[2]; ry++)
-          {
-            if (ry >= clip_y1 && ry < clip_y2)
-              gimp_canvas_transform_preview_draw_tri_row_mask (texture, cr,
-                                                               area, area_offx, area_offy,
-                                                               mask, mask_offx, mask_offy,
-                                                               *left,  u_l, v_l,
-                                                               *right, u_r, v_r,
-                                                               ry,
-                                                               opacity);
-            left ++;      right ++;
-            u_l += dul;   v_l += dvl;
-            u_r += dur;   v_r += dvr;
-          }
-      else
-        for (ry = y[1]; ry < y[2]; ry++)
-          {
-            if (ry >= clip_y1 && ry < clip_y2)
-              gimp_canvas_transform_preview_draw_tri_row (texture, cr,
-                                                          area, area_offx, area_offy,
-                                                          *left,  u_l, v_l,
-                                                          *right, u_r, v_r,
-                                                          ry,
-                                                          opacity);
-            left ++;      right ++;
-            u_l += dul;   v_l += dvl;
-            u_r += dur;   v_r += dvr;
-          }
+      for (ry = y[1]; ry < y[2]; ry++)
+        {
+          if (ry >= clip_y1 && ry < clip_y2)
+            gimp_canvas_transform_preview_add_span (spans, clip_x1, clip_x2,
+                                                    *left,  u_l, v_l,
+                                                    *right, u_r, v_r,
+                                                    ry);
+          left ++;      right ++;
+          u_l += dul;   v_l += dvl;
+          u_r += dur;   v_r += dvr;
+        }
     }
 
   g_free (l_edge);
@@ -836,49 +905,31 @@ gimp_canvas_transform_preview_draw_tri (GimpDrawable    *texture,
 }
 
 /**
- * gimp_canvas_transform_preview_draw_tri_row:
- * @texture: the thing being transformed
- * @cr:      the #cairo_t to draw to
- * @area:    has prefetched pixel data of dest
+ * gimp_canvas_transform_preview_add_span:
+ * @spans: the #GArray of #PreviewSpan to add to
  *
- * Called from gimp_canvas_transform_preview_draw_tri(), this draws a
- * single row of a triangle onto dest when there is not a mask. The
- * run (x1,y) to (x2,y) in dest corresponds to the run (u1,v1) to
- * (u2,v2) in texture.
+ * Called from gimp_canvas_transform_preview_add_tri(), this adds the
+ * visible part of a single row of a triangle. The run (x1,y) to
+ * (x2,y) on screen corresponds to the run (u1,v1) to (u2,v2) in the
+ * texture.
  **/
 static void
-gimp_canvas_transform_preview_draw_tri_row (GimpDrawable    *texture,
-                                            cairo_t         *cr,
-                                            cairo_surface_t *area,
-                                            gint             area_offx,
-                                            gint             area_offy,
-                                            gint             x1,
-                                            gfloat           u1,
-                                            gfloat           v1,
-                                            gint             x2,
-                                            gfloat           u2,
-                                            gfloat           v2,
-                                            gint             y,
-                                            guchar           opacity)
+gimp_canvas_transform_preview_add_span (GArray  *spans,
+                                        gdouble  clip_x1,
+                                        gdouble  clip_x2,
+                                        gint     x1,
+                                        gfloat   u1,
+                                        gfloat   v1,
+                                        gint     x2,
+                                        gfloat   u2,
+                                        gfloat   v2,
+                                        gint     y)
 {
-  GeglBuffer *buffer;
-  const Babl *format;
-  guchar     *buf;
-  guchar     *b;
-  guchar     *pptr;      /* points into the pixels of a row of area */
-  gint        bpp;
-  gfloat      u, v;
-  gfloat      du, dv;
-  gint        dx;
-  gint        samples;
+  PreviewSpan span;
 
   if (x2 == x1)
     return;
 
-  g_return_if_fail (GIMP_IS_DRAWABLE (texture));
-  g_return_if_fail (area != NULL);
-  g_return_if_fail (cairo_image_surface_get_format (area) == CAIRO_FORMAT_ARGB32);
-
   /* make sure the pixel run goes in the positive direction */
   if (x1 > x2)
     {
@@ -890,268 +941,148 @@ gimp_canvas_transform_preview_draw_tri_row (GimpDrawable    *texture,
       ftmp = v2;  v2 = v1;  v1 = ftmp;
     }
 
-  u = u1;
-  v = v1;
-  du = (u2 - u1) / (x2 - x1);
-  dv = (v2 - v1) / (x2 - x1);
+  span.y  = y;
+  span.u  = u1;
+  span.v  = v1;
+  span.du = (u2 - u1) / (x2 - x1);
+  span.dv = (v2 - v1) / (x2 - x1);
 
   /* don't calculate unseen pixels */
-  if (x1 < area_offx)
+  if (x1 < floor (clip_x1))
     {
-      u += du * (area_offx - x1);
-      v += dv * (area_offx - x1);
-      x1 = area_offx;
-    }
-  else if (x1 > area_offx + cairo_image_surface_get_width (area) - 1)
-    {
-      return;
-    }
+      gint skip = floor (clip_x1) - x1;
 
-  if (x2 < area_offx)
-    {
-      return;
+      span.u += span.du * skip;
+      span.v += span.dv * skip;
+      x1 += skip;
     }
-  else if (x2 > area_offx + cairo_image_surface_get_width (area) - 1)
-    {
-      x2 = area_offx + cairo_image_surface_get_width (area) - 1;
-    }
-
-  dx = x2 - x1;
-  if (! dx)
-    return;
-
-  cairo_surface_flush (area);
-  pptr = (cairo_image_surface_get_data (area)
-          + (y - area_offy) * cairo_image_surface_get_stride (area)
-          + (x1 - area_offx) * 4);
-
-  buffer = gimp_drawable_get_buffer (texture);
-
-  format = gegl_buffer_get_format (buffer);
-  bpp    = babl_format_get_bytes_per_pixel (format);
-  buf    = g_alloca (bpp * dx);
-
-  samples = dx;
-  b       = buf;
-
-  while (samples--)
-    {
-      gegl_buffer_sample (buffer, (gint) u, (gint) v, NULL, b,
-                          format,
-                          GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
-
-      b += bpp;
 
-      u += du;
-      v += dv;
-    }
+  x2 = MIN (x2, ceil (clip_x2));
 
-  if (opacity < 255)
-    {
-      guchar *u8_buffer = g_alloca (4 * dx);
-      guchar *u8_b;
+  if (x2 <= x1)
+    return;
 
-      babl_process (babl_fish (format,
-                               babl_format ("R'G'B'A u8")),
-                    buf, u8_buffer, dx);
+  span.x1 = x1;
+  span.x2 = x2;
 
-      samples = dx;
-      u8_b    = u8_buffer;
+  g_array_append_val (spans, span);
+}
 
-      while (samples--)
-        {
-          register gulong tmp;
+static inline const guchar *
+preview_texture_get_pixel (PreviewTexture *texture,
+                           gint            x,
+                           gint            y)
+{
+  const guchar *tile;
 
-          u8_b[3] = INT_MULT (opacity, u8_b[3], tmp);
+  if (x < 0 || x >= texture->width ||
+      y < 0 || y >= texture->height)
+    return NULL;
 
-          u8_b += 4;
-        }
+  tile = texture->tiles[(y >> TEXTURE_TILE_SHIFT) * texture->n_cols +
+                        (x >> TEXTURE_TILE_SHIFT)];
 
-      babl_process (babl_fish (babl_format ("R'G'B'A u8"),
-                               babl_format ("cairo-ARGB32")),
-                    u8_buffer, pptr, dx);
-    }
-  else
-    {
-      babl_process (babl_fish (format,
-                               babl_format ("cairo-ARGB32")),
-                    buf, pptr, dx);
-    }
+  if (! tile)
+    return NULL;
 
-  cairo_surface_mark_dirty (area);
-
-  cairo_set_source_surface (cr, area, area_offx, area_offy);
-  cairo_rectangle (cr, x1, y, x2 - x1, 1);
-  cairo_fill (cr);
+  return tile + (((y & (TEXTURE_TILE_SIZE - 1)) * TEXTURE_TILE_SIZE +
+                  (x & (TEXTURE_TILE_SIZE - 1))) * texture->bpp);
 }
 
 /**
- * gimp_canvas_transform_preview_draw_tri_row_mask:
+ * gimp_canvas_transform_preview_render_rows:
  *
- * Called from gimp_canvas_transform_preview_draw_tri(), this draws a
- * single row of a triangle onto dest, when there is a mask.
+ * Renders the runs which fall into the rows @offset to
+ * @offset + @size - 1 of the area, sampling the texture, and the
+ * mask if there is one, with nearest neighbour sampling. Runs
+ * through gimp_gegl_parallel_distribute_range(), so it only reads
+ * from the textures.
  **/
 static void
-gimp_canvas_transform_preview_draw_tri_row_mask (GimpDrawable    *texture,
-                                                 cairo_t         *cr,
-                                                 cairo_surface_t *area,
-                                                 gint             area_offx,
-                                                 gint             area_offy,
-                                                 GimpChannel     *mask,
-                                                 gint             mask_offx,
-                                                 gint             mask_offy,
-                                                 gint             x1,
-                                                 gfloat           u1,
-                                                 gfloat           v1,
-                                                 gint             x2,
-                                                 gfloat           u2,
-                                                 gfloat           v2,
-                                                 gint             y,
-                                                 guchar           opacity)
+gimp_canvas_transform_preview_render_rows (gsize       offset,
+                                           gsize       size,
+                                           RenderData *data)
 {
-  GeglBuffer *buffer;
-  GeglBuffer *mask_buffer;
-  const Babl *format;
-  const Babl *mask_format;
-  guchar     *buf;
-  guchar     *mask_buf;
-  guchar     *b;
-  guchar     *mask_b;
-  guchar     *pptr;              /* points into the pixels of area        */
-  gint        bpp;
-  gint        mask_bpp;
-  gfloat      u, v;
-  gfloat      mu, mv;
-  gfloat      du, dv;
-  gint        dx;
-  gint        samples;
+  const gint  y1    = data->area_offy + offset;
+  const gint  y2    = y1 + size;
+  gfloat      scale = 1.0 / (1 << data->texture->level);
+  gint        i;
 
-  if (x2 == x1)
-    return;
-
-  g_return_if_fail (GIMP_IS_DRAWABLE (texture));
-  g_return_if_fail (GIMP_IS_CHANNEL (mask));
-  g_return_if_fail (area != NULL);
-  g_return_if_fail (cairo_image_surface_get_format (area) == CAIRO_FORMAT_ARGB32);
-
-  /* make sure the pixel run goes in the positive direction */
-  if (x1 > x2)
+  for (i = 0; i < data->spans->len; i++)
     {
-      gint   tmp;
-      gfloat ftmp;
-
-      tmp  = x2;  x2 = x1;  x1 = tmp;
-      ftmp = u2;  u2 = u1;  u1 = ftmp;
-      ftmp = v2;  v2 = v1;  v1 = ftmp;
-    }
+      const PreviewSpan *span = &g_array_index (data->spans, PreviewSpan, i);
+      guchar            *dest;
+      gfloat             u, v;
+      gint               x;
 
-  u = u1;
-  v = v1;
-  du = (u2 - u1) / (x2 - x1);
-  dv = (v2 - v1) / (x2 - x1);
+      if (span->y < y1 || span->y >= y2)
+        continue;
 
-  /* don't calculate unseen pixels */
-  if (x1 < area_offx)
-    {
-      u += du * (area_offx - x1);
-      v += dv * (area_offx - x1);
-      x1 = area_offx;
-    }
-  else if (x1 > area_offx + cairo_image_surface_get_width (area) - 1)
-    {
-      return;
-    }
+      dest = (data->area_data +
+              (span->y  - data->area_offy) * data->area_stride +
+              (span->x1 - data->area_offx) * 4);
 
-  if (x2 < area_offx)
-    {
-      return;
-    }
-  else if (x2 > area_offx + cairo_image_surface_get_width (area) - 1)
-    {
-      x2 = area_offx + cairo_image_surface_get_width (area) - 1;
-    }
+      u = span->u;
+      v = span->v;
 
-  dx = x2 - x1;
-  if (! dx)
-    return;
+      for (x = span->x1; x < span->x2; x++)
+        {
+          const guchar *src;
+          guint         factor = data->opacity;
 
-  mu = u + mask_offx;
-  mv = v + mask_offy;
+          src = preview_texture_get_pixel (data->texture,
+                                           (gint) (u * scale),
+                                           (gint) (v * scale));
 
-  cairo_surface_flush (area);
-  pptr = (cairo_image_surface_get_data (area)
-          + (y - area_offy) * cairo_image_surface_get_stride (area)
-          + (x1 - area_offx) * 4);
+          if (src && data->mask)
+            {
+              const guchar *mask;
+
+              mask = preview_texture_get_pixel (data->mask,
+                                                (gint) ((u + data->mask_offx) *
+                                                        scale),
+                                                (gint) ((v + data->mask_offy) *
+                                                        scale));
+
+              if (mask)
+                {
+                  register gulong tmp;
+
+                  factor = INT_MULT (factor, *mask, tmp);
+                }
+              else
+                {
+                  factor = 0;
+                }
+            }
 
-  buffer      = gimp_drawable_get_buffer (texture);
-  mask_buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (mask));
+          /*  the pixels are premultiplied, so apply the opacity to
+           *  all channels; untouched pixels of the area stay
+           *  transparent
+           */
+          if (src && factor == 255)
+            {
+              dest[0] = src[0];
+              dest[1] = src[1];
+              dest[2] = src[2];
+              dest[3] = src[3];
+            }
+          else if (src && factor)
+            {
+              register gulong tmp;
 
-  format      = gegl_buffer_get_format (buffer);
-  mask_format = gegl_buffer_get_format (mask_buffer);
-  bpp         = babl_format_get_bytes_per_pixel (format);
-  mask_bpp    = babl_format_get_bytes_per_pixel (mask_format);
-  buf         = g_alloca (bpp * dx);
-  mask_buf    = g_alloca (mask_bpp * dx);
+              dest[0] = INT_MULT (src[0], factor, tmp);
+              dest[1] = INT_MULT (src[1], factor, tmp);
+              dest[2] = INT_MULT (src[2], factor, tmp);
+              dest[3] = INT_MULT (src[3], factor, tmp);
+            }
 
-  samples = dx;
-  b       = buf;
-  mask_b  = mask_buf;
+          dest += 4;
 
-  while (samples--)
-    {
-      gegl_buffer_sample (buffer, (gint) u, (gint) v, NULL, b,
-                          format,
-                          GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
-      gegl_buffer_sample (mask_buffer, (gint) mu, (gint) mv, NULL, mask_b,
-                          mask_format,
-                          GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
-
-      b      += bpp;
-      mask_b += mask_bpp;
-
-      u += du;
-      v += dv;
-      mu += du;
-      mv += dv;
+          u += span->du;
+          v += span->dv;
+        }
     }
-
-  {
-    guchar *u8_buffer      = g_alloca (4 * dx);
-    guchar *u8_mask_buffer = g_alloca (dx);
-    guchar *u8_b;
-    guchar *u8_mask_b;
-
-    babl_process (babl_fish (format,
-                             babl_format ("R'G'B'A u8")),
-                  buf, u8_buffer, dx);
-    babl_process (babl_fish (mask_format,
-                             babl_format ("Y u8")),
-                  mask_buf, u8_mask_buffer, dx);
-
-    samples   = dx;
-    u8_b      = u8_buffer;
-    u8_mask_b = u8_mask_buffer;
-
-    while (samples--)
-      {
-        register gulong tmp;
-
-        u8_b[3] = INT_MULT3 (opacity, *u8_mask_b, u8_b[3], tmp);
-
-        u8_b      += 4;
-        u8_mask_b += 1;
-      }
-
-    babl_process (babl_fish (babl_format ("R'G'B'A u8"),
-                             babl_format ("cairo-ARGB32")),
-                  u8_buffer, pptr, dx);
-  }
-
-  cairo_surface_mark_dirty (area);
-
-  cairo_set_source_surface (cr, area, area_offx, area_offy);
-  cairo_rectangle (cr, x1, y, x2 - x1, 1);
-  cairo_fill (cr);
 }
 
 /**
@@ -1216,3 +1147,184 @@ gimp_canvas_transform_preview_trace_tri_edge (gint *dest,
         }
     }
 }
+
+/*  returns the texture of @drawable at @level, reusing the one made
+ *  for previous previews if it is still valid
+ */
+static PreviewTexture *
+preview_texture_get (GimpDrawable *drawable,
+                     const gchar  *key,
+                     const Babl   *format,
+                     gint          level)
+{
+  PreviewTexture *texture;
+  GeglBuffer     *buffer = gimp_drawable_get_buffer (drawable);
+
+  texture = g_object_get_data (G_OBJECT (drawable), key);
+
+  if (texture &&
+      (texture->level  != level  ||
+       texture->buffer != buffer ||
+       texture->format != format))
+    {
+      g_object_set_data (G_OBJECT (drawable), key, NULL);
+      texture = NULL;
+    }
+
+  if (! texture)
+    {
+      texture = g_slice_new0 (PreviewTexture);
+
+      texture->drawable = drawable;
+      texture->key      = key;
+      texture->buffer   = g_object_ref (buffer);
+      texture->format   = format;
+      texture->bpp      = babl_format_get_bytes_per_pixel (format);
+      texture->level    = level;
+      texture->width    = ((gegl_buffer_get_width (buffer) +
+                            (1 << level) - 1) >> level);
+      texture->height   = ((gegl_buffer_get_height (buffer) +
+                            (1 << level) - 1) >> level);
+      texture->n_cols   = ((texture->width + TEXTURE_TILE_SIZE - 1) >>
+                           TEXTURE_TILE_SHIFT);
+      texture->n_rows   = ((texture->height + TEXTURE_TILE_SIZE - 1) >>
+                           TEXTURE_TILE_SHIFT);
+      texture->tiles    = g_new0 (guchar *, texture->n_cols * texture->n_rows);
+
+      g_signal_connect (drawable, "update",
+                        G_CALLBACK (preview_texture_update),
+                        texture);
+
+      texture->timeout_id =
+        g_timeout_add_seconds (TEXTURE_TIMEOUT,
+                               (GSourceFunc) preview_texture_timeout,
+                               texture);
+
+      g_object_set_data_full (G_OBJECT (drawable), key, texture,
+                              (GDestroyNotify) preview_texture_free);
+    }
+
+  texture->used = TRUE;
+
+  return texture;
+}
+
+static void
+preview_texture_free (PreviewTexture *texture)
+{
+  gint i;
+
+  if (texture->timeout_id)
+    g_source_remove (texture->timeout_id);
+
+  g_signal_handlers_disconnect_by_func (texture->drawable,
+                                        preview_texture_update,
+                                        texture);
+
+  for (i = 0; i < texture->n_cols * texture->n_rows; i++)
+    g_free (texture->tiles[i]);
+
+  g_free (texture->tiles);
+  g_object_unref (texture->buffer);
+
+  g_slice_free (PreviewTexture, texture);
+}
+
+static void
+preview_texture_update (GimpDrawable   *drawable,
+                        gint            x,
+                        gint            y,
+                        gint            width,
+                        gint            height,
+                        PreviewTexture *texture)
+{
+  gint col1, row1;
+  gint col2, row2;
+  gint row, col;
+
+  if (width <= 0 || height <= 0)
+    return;
+
+  /*  forget the tiles which show the changed area  */
+  col1 = MAX (x >> texture->level, 0) >> TEXTURE_TILE_SHIFT;
+  row1 = MAX (y >> texture->level, 0) >> TEXTURE_TILE_SHIFT;
+  col2 = MIN (((x + width  - 1) >> texture->level) >> TEXTURE_TILE_SHIFT,
+              texture->n_cols - 1);
+  row2 = MIN (((y + height - 1) >> texture->level) >> TEXTURE_TILE_SHIFT,
+              texture->n_rows - 1);
+
+  for (row = row1; row <= row2; row++)
+    for (col = col1; col <= col2; col++)
+      {
+        gint i = row * texture->n_cols + col;
+
+        g_free (texture->tiles[i]);
+        texture->tiles[i] = NULL;
+      }
+}
+
+static gboolean
+preview_texture_timeout (PreviewTexture *texture)
+{
+  if (texture->used)
+    {
+      texture->used = FALSE;
+
+      return G_SOURCE_CONTINUE;
+    }
+
+  /*  nobody drew a preview from the texture for a while, drop it  */
+  texture->timeout_id = 0;
+
+  g_object_set_data (G_OBJECT (texture->drawable), texture->key, NULL);
+
+  return G_SOURCE_REMOVE;
+}
+
+/*  makes sure the tiles covering the drawable area from (@u1, @v1)
+ *  to (@u2, @v2) are fetched
+ */
+static void
+preview_texture_load (PreviewTexture *texture,
+                      gfloat          u1,
+                      gfloat          v1,
+                      gfloat          u2,
+                      gfloat          v2)
+{
+  gdouble scale = 1.0 / (1 << texture->level);
+  gint    col1, row1;
+  gint    col2, row2;
+  gint    row, col;
+
+  col1 = CLAMP ((gint) floor (u1 * scale), 0, texture->width  - 1);
+  row1 = CLAMP ((gint) floor (v1 * scale), 0, texture->height - 1);
+  col2 = CLAMP ((gint) floor (u2 * scale), 0, texture->width  - 1);
+  row2 = CLAMP ((gint) floor (v2 * scale), 0, texture->height - 1);
+
+  col1 >>= TEXTURE_TILE_SHIFT;
+  row1 >>= TEXTURE_TILE_SHIFT;
+  col2 >>= TEXTURE_TILE_SHIFT;
+  row2 >>= TEXTURE_TILE_SHIFT;
+
+  for (row = row1; row <= row2; row++)
+    for (col = col1; col <= col2; col++)
+      {
+        guchar        **tile = &texture->tiles[row * texture->n_cols + col];
+        GeglRectangle   rect;
+
+        if (*tile)
+          continue;
+
+        rect.x      = col << TEXTURE_TILE_SHIFT;
+        rect.y      = row << TEXTURE_TILE_SHIFT;
+        rect.width  = MIN (TEXTURE_TILE_SIZE, texture->width  - rect.x);
+        rect.height = MIN (TEXTURE_TILE_SIZE, texture->height - rect.y);
+
+        *tile = g_malloc0 (TEXTURE_TILE_SIZE * TEXTURE_TILE_SIZE *
+                           texture->bpp);
+
+        gegl_buffer_get (texture->buffer, &rect, scale, texture->format,
+                         *tile, TEXTURE_TILE_SIZE * texture->bpp,
+                         GEGL_ABYSS_NONE);
+      }
+}
@@ -68,7 +68,7 @@ static void      selection_undraw         (Selection          *selection);
 
 static void      selection_render_mask    (Selection          *selection);
 
-static void      selection_zoom_segs      (Selection          *selection,
+static gint      selection_zoom_segs      (Selection          *selection,
                                            const GimpBoundSeg *src_segs,
                                            GimpSegment        *dest_segs,
                                            gint                n_segs);
@@ -310,7 +310,11 @@ selection_render_mask (Selection *selection)
   cairo_surface_destroy (surface);
 }
 
-static void
+/*  transforms the segments to display coordinates, and drops the
+ *  ones outside the display unless it is rotated.  Returns the number
+ *  of segments left in dest_segs.
+ */
+static gint
 selection_zoom_segs (Selection          *selection,
                      const GimpBoundSeg *src_segs,
                      GimpSegment        *dest_segs,
@@ -318,6 +322,7 @@ selection_zoom_segs (Selection          *selection,
 {
   const gint xclamp = selection->shell->disp_width + 1;
   const gint yclamp = selection->shell->disp_height + 1;
+  gint       n      = 0;
   gint       i;
 
   gimp_display_shell_zoom_segments (selection->shell,
@@ -326,13 +331,22 @@ selection_zoom_segs (Selection          *selection,
 
   for (i = 0; i < n_segs; i++)
     {
+      GimpSegment seg = dest_segs[i];
+
       if (! selection->shell->rotate_transform)
         {
-          dest_segs[i].x1 = CLAMP (dest_segs[i].x1, -1, xclamp);
-          dest_segs[i].y1 = CLAMP (dest_segs[i].y1, -1, yclamp);
-
-          dest_segs[i].x2 = CLAMP (dest_segs[i].x2, -1, xclamp);
-          dest_segs[i].y2 = CLAMP (dest_segs[i].y2, -1, yclamp);
+          seg.x1 = CLAMP (seg.x1, -1, xclamp);
+          seg.y1 = CLAMP (seg.y1, -1, yclamp);
+
+          seg.x2 = CLAMP (seg.x2, -1, xclamp);
+          seg.y2 = CLAMP (seg.y2, -1, yclamp);
+
+          /*  skip segments which are entirely off the display  */
+          if ((seg.x1 < 0       && seg.x2 < 0)       ||
+              (seg.y1 < 0       && seg.y2 < 0)       ||
+              (seg.x1 >= xclamp && seg.x2 >= xclamp) ||
+              (seg.y1 >= yclamp && seg.y2 >= yclamp))
+            continue;
         }
 
       /*  If this segment is a closing segment && the segments lie inside
@@ -343,18 +357,22 @@ selection_zoom_segs (Selection          *selection,
       if (! src_segs[i].open)
         {
           /*  If it is vertical  */
-          if (dest_segs[i].x1 == dest_segs[i].x2)
+          if (seg.x1 == seg.x2)
             {
-              dest_segs[i].x1 -= 1;
-              dest_segs[i].x2 -= 1;
+              seg.x1 -= 1;
+              seg.x2 -= 1;
             }
           else
             {
-              dest_segs[i].y1 -= 1;
-              dest_segs[i].y2 -= 1;
+              seg.y1 -= 1;
+              seg.y2 -= 1;
             }
         }
+
+      dest_segs[n++] = seg;
     }
+
+  return n;
 }
 
 static void
@@ -372,29 +390,36 @@ selection_generate_segs (Selection *selection)
                          &selection->n_segs_in, &selection->n_segs_out,
                          0, 0, 0, 0);
 
+  selection->segs_in = NULL;
+
   if (selection->n_segs_in)
     {
       selection->segs_in = g_new (GimpSegment, selection->n_segs_in);
-      selection_zoom_segs (selection, segs_in,
-                           selection->segs_in, selection->n_segs_in);
+      selection->n_segs_in = selection_zoom_segs (selection, segs_in,
+                                                  selection->segs_in,
+                                                  selection->n_segs_in);
 
-      selection_render_mask (selection);
-    }
-  else
-    {
-      selection->segs_in = NULL;
+      /*  all segments can be off the display, the drawing code
+       *  relies on segs_in being NULL then
+       */
+      if (selection->n_segs_in)
+        selection_render_mask (selection);
+      else
+        g_clear_pointer (&selection->segs_in, g_free);
     }
 
+  selection->segs_out = NULL;
+
   /*  Possible secondary boundary representation  */
   if (selection->n_segs_out)
     {
       selection->segs_out = g_new (GimpSegment, selection->n_segs_out);
-      selection_zoom_segs (selection, segs_out,
-                           selection->segs_out, selection->n_segs_out);
-    }
-  else
-    {
-      selection->segs_out = NULL;
+      selection->n_segs_out = selection_zoom_segs (selection, segs_out,
+                                                   selection->segs_out,
+                                                   selection->n_segs_out);
+
+      if (! selection->n_segs_out)
+        g_clear_pointer (&selection->segs_out, g_free);
     }
 }
 
@@ -405,7 +430,7 @@ selection_free_segs (Selection *selection)
   selection->n_segs_in = 0;
 
   g_clear_pointer (&selection->segs_out, g_free);
-  selection->segs_out = NULL;
+  selection->n_segs_out = 0;
 
   g_clear_pointer (&selection->segs_in_mask, cairo_pattern_destroy);
 }
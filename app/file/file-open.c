@@ -53,15 +53,60 @@
 #include "gimp-intl.h"
 
 
-static void     file_open_sanitize_image       (GimpImage           *image,
-                                                gboolean             as_new);
-static void     file_open_convert_items        (GimpImage           *dest_image,
-                                                const gchar         *basename,
-                                                GList               *items);
-static GList *  file_open_get_layers           (GimpImage           *image,
-                                                gboolean             merge_visible,
-                                                gint                *n_visible);
-static gboolean file_open_file_proc_is_import  (GimpPlugInProcedure *file_proc);
+typedef struct
+{
+  Gimp                      *gimp;
+  GimpContext               *context;
+  GFile                     *file;
+  GimpPlugInProcedure       *file_proc;
+
+  FileOpenImageCallback      image_callback;
+  FileOpenThumbnailCallback  thumbnail_callback;
+  gpointer                   user_data;
+} FileOpenAsync;
+
+
+static void            file_open_sanitize_image         (GimpImage           *image,
+                                                         gboolean             as_new);
+static void            file_open_convert_items          (GimpImage           *dest_image,
+                                                         const gchar         *basename,
+                                                         GList               *items);
+static GList *         file_open_get_layers             (GimpImage           *image,
+                                                         gboolean             merge_visible,
+                                                         gint                *n_visible);
+static gboolean        file_open_file_proc_is_import    (GimpPlugInProcedure *file_proc);
+
+static GimpImage *     file_open_image_get_result       (Gimp                *gimp,
+                                                         GimpPlugInProcedure *file_proc,
+                                                         GimpValueArray      *return_vals,
+                                                         GimpPDBStatusType   *status,
+                                                         const gchar        **mime_type,
+                                                         GError             **error);
+static void            file_open_image_prepare          (GimpImage           *image,
+                                                         GimpContext         *context,
+                                                         GimpProgress        *progress,
+                                                         GFile               *file,
+                                                         gboolean             as_new,
+                                                         gboolean             interactive);
+static GimpImage *     file_open_thumbnail_get_result   (Gimp                *gimp,
+                                                         GimpPlugInProcedure *file_proc,
+                                                         GimpValueArray      *return_vals,
+                                                         const gchar        **mime_type,
+                                                         gint                *image_width,
+                                                         gint                *image_height,
+                                                         const Babl         **format,
+                                                         gint                *num_layers);
+
+static FileOpenAsync * file_open_async_new              (Gimp                *gimp,
+                                                         GimpContext         *context,
+                                                         GFile               *file,
+                                                         GimpPlugInProcedure *file_proc,
+                                                         gpointer             user_data);
+static void            file_open_async_free             (FileOpenAsync       *async);
+static void            file_open_image_async_return     (GimpValueArray      *return_vals,
+                                                         gpointer             data);
+static void            file_open_thumbnail_async_return (GimpValueArray      *return_vals,
+                                                         gpointer             data);
 
 
 /*  public functions  */
@@ -222,11 +267,8 @@ file_open_image (Gimp                *gimp,
   g_free (path);
   g_free (entered_uri);
 
-  *status = g_value_get_enum (gimp_value_array_index (return_vals, 0));
-
-  if (*status == GIMP_PDB_SUCCESS)
-    image = gimp_value_get_image (gimp_value_array_index (return_vals, 1),
-                                  gimp);
+  image = file_open_image_get_result (gimp, file_proc, return_vals,
+                                      status, mime_type, error);
 
   if (local_file)
     {
@@ -237,54 +279,11 @@ file_open_image (Gimp                *gimp,
       g_object_unref (local_file);
     }
 
-  if (*status == GIMP_PDB_SUCCESS)
-    {
-      if (image)
-        {
-          /* Only set the load procedure if it hasn't already been set. */
-          if (! gimp_image_get_load_proc (image))
-            gimp_image_set_load_proc (image, file_proc);
-
-          file_proc = gimp_image_get_load_proc (image);
-
-          if (mime_type)
-            *mime_type = g_slist_nth_data (file_proc->mime_types_list, 0);
-        }
-      else
-        {
-          if (error && ! *error)
-            g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
-                         _("%s plug-in returned SUCCESS but did not "
-                           "return an image"),
-                         gimp_procedure_get_label (GIMP_PROCEDURE (file_proc)));
-
-          *status = GIMP_PDB_EXECUTION_ERROR;
-        }
-    }
-  else if (*status != GIMP_PDB_CANCEL)
-    {
-      if (error && ! *error)
-        g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
-                     _("%s plug-In could not open image"),
-                     gimp_procedure_get_label (GIMP_PROCEDURE (file_proc)));
-    }
-
   gimp_value_array_unref (return_vals);
 
   if (image)
-    {
-      gimp_image_undo_disable (image);
-
-      if (file_open_file_proc_is_import (file_proc))
-        {
-          file_import_image (image, context, file,
-                             run_mode == GIMP_RUN_INTERACTIVE,
-                             progress);
-        }
-
-      /* Enables undo again */
-      file_open_sanitize_image (image, as_new);
-    }
+    file_open_image_prepare (image, context, progress, file, as_new,
+                             run_mode == GIMP_RUN_INTERACTIVE);
 
   return image;
 }
@@ -372,104 +371,167 @@ file_open_thumbnail (Gimp           *gimp,
 
       g_free (path);
 
-      status = g_value_get_enum (gimp_value_array_index (return_vals, 0));
+      image = file_open_thumbnail_get_result (gimp, file_proc, return_vals,
+                                              mime_type,
+                                              image_width, image_height,
+                                              format, num_layers);
 
-      if (status == GIMP_PDB_SUCCESS &&
-          GIMP_VALUE_HOLDS_IMAGE_ID (gimp_value_array_index (return_vals, 1)))
-        {
-          image = gimp_value_get_image (gimp_value_array_index (return_vals, 1),
-                                        gimp);
+      gimp_value_array_unref (return_vals);
 
-          if (gimp_value_array_length (return_vals) >= 3 &&
-              G_VALUE_HOLDS_INT (gimp_value_array_index (return_vals, 2)) &&
-              G_VALUE_HOLDS_INT (gimp_value_array_index (return_vals, 3)))
-            {
-              *image_width =
-                MAX (0, g_value_get_int (gimp_value_array_index (return_vals, 2)));
+      return image;
+    }
 
-              *image_height =
-                MAX (0, g_value_get_int (gimp_value_array_index (return_vals, 3)));
+  return NULL;
+}
 
-              if (gimp_value_array_length (return_vals) >= 5 &&
-                  G_VALUE_HOLDS_INT (gimp_value_array_index (return_vals, 4)))
-                {
-                  gint value = g_value_get_int (gimp_value_array_index (return_vals, 4));
-
-                  switch (value)
-                    {
-                    case GIMP_RGB_IMAGE:
-                      *format = gimp_babl_format (GIMP_RGB,
-                                                  GIMP_PRECISION_U8_GAMMA,
-                                                  FALSE);
-                      break;
-
-                    case GIMP_RGBA_IMAGE:
-                      *format = gimp_babl_format (GIMP_RGB,
-                                                  GIMP_PRECISION_U8_GAMMA,
-                                                  TRUE);
-                      break;
-
-                    case GIMP_GRAY_IMAGE:
-                      *format = gimp_babl_format (GIMP_GRAY,
-                                                  GIMP_PRECISION_U8_GAMMA,
-                                                  FALSE);
-                      break;
-
-                    case GIMP_GRAYA_IMAGE:
-                      *format = gimp_babl_format (GIMP_GRAY,
-                                                  GIMP_PRECISION_U8_GAMMA,
-                                                  TRUE);
-                      break;
-
-                    case GIMP_INDEXED_IMAGE:
-                    case GIMP_INDEXEDA_IMAGE:
-                      {
-                        const Babl *rgb;
-                        const Babl *rgba;
-
-                        babl_new_palette ("-gimp-indexed-format-dummy",
-                                          &rgb, &rgba);
-
-                        if (value == GIMP_INDEXED_IMAGE)
-                          *format = rgb;
-                        else
-                          *format = rgba;
-                      }
-                      break;
-
-                    default:
-                      break;
-                    }
-                }
+/**
+ * file_open_thumbnail_async:
+ * @gimp:
+ * @context:
+ * @file:      an image file
+ * @size:      requested size of the thumbnail
+ * @callback:  called with the thumbnail image
+ * @user_data: user data for @callback
+ *
+ * Like file_open_thumbnail(), but doesn't wait for the thumbnail
+ * loader to finish, so that several thumbnails can be loaded at
+ * the same time. @callback owns the image it gets passed, which is
+ * %NULL if loading failed.
+ *
+ * Return value: %FALSE if there is no thumbnail loader for @file,
+ *               @callback is not called in that case.
+ */
+gboolean
+file_open_thumbnail_async (Gimp                      *gimp,
+                           GimpContext               *context,
+                           GFile                     *file,
+                           gint                       size,
+                           FileOpenThumbnailCallback  callback,
+                           gpointer                   user_data)
+{
+  GimpPlugInProcedure *file_proc;
+  GimpProcedure       *procedure;
+  GimpValueArray      *args;
+  FileOpenAsync       *async;
+  gchar               *path = NULL;
 
-              if (gimp_value_array_length (return_vals) >= 6 &&
-                  G_VALUE_HOLDS_INT (gimp_value_array_index (return_vals, 5)))
-                {
-                  *num_layers =
-                    MAX (0, g_value_get_int (gimp_value_array_index (return_vals, 5)));
-                }
-            }
+  g_return_val_if_fail (GIMP_IS_GIMP (gimp), FALSE);
+  g_return_val_if_fail (GIMP_IS_CONTEXT (context), FALSE);
+  g_return_val_if_fail (G_IS_FILE (file), FALSE);
+  g_return_val_if_fail (callback != NULL, FALSE);
 
-          if (image)
-            {
-              file_open_sanitize_image (image, FALSE);
+  file_proc = gimp_plug_in_manager_file_procedure_find (gimp->plug_in_manager,
+                                                        GIMP_FILE_PROCEDURE_GROUP_OPEN,
+                                                        file, NULL);
 
-              *mime_type = g_slist_nth_data (file_proc->mime_types_list, 0);
+  if (! file_proc || ! file_proc->thumb_loader)
+    return FALSE;
 
-#ifdef GIMP_UNSTABLE
-              g_printerr ("opened thumbnail at %d x %d\n",
-                          gimp_image_get_width  (image),
-                          gimp_image_get_height (image));
-#endif
-            }
-        }
+  procedure = gimp_pdb_lookup_procedure (gimp->pdb, file_proc->thumb_loader);
 
-      gimp_value_array_unref (return_vals);
+  if (! GIMP_IS_PLUG_IN_PROCEDURE (procedure) ||
+      procedure->num_args   < 2               ||
+      procedure->num_values < 1)
+    return FALSE;
 
-      return image;
-    }
+  if (! file_proc->handles_uri)
+    path = g_file_get_path (file);
 
-  return NULL;
+  if (! path)
+    path = g_file_get_uri (file);
+
+  args = gimp_procedure_get_arguments (procedure);
+
+  g_value_take_string (gimp_value_array_index (args, 0), path);
+  g_value_set_int     (gimp_value_array_index (args, 1), size);
+
+  async = file_open_async_new (gimp, context, file, file_proc, user_data);
+  async->thumbnail_callback = callback;
+
+  gimp_plug_in_procedure_run_async (GIMP_PLUG_IN_PROCEDURE (procedure),
+                                    gimp, context, NULL, args,
+                                    file_open_thumbnail_async_return,
+                                    async);
+
+  gimp_value_array_unref (args);
+
+  return TRUE;
+}
+
+/**
+ * file_open_image_async:
+ * @gimp:
+ * @context:
+ * @file:      an image file
+ * @callback:  called with the loaded image
+ * @user_data: user data for @callback
+ *
+ * Loads @file non-interactively without waiting for the load
+ * procedure to finish. @callback owns the image it gets passed,
+ * which is %NULL if loading failed.
+ *
+ * Only local files are handled, remote files need to be downloaded
+ * first and have to go through file_open_image().
+ *
+ * Return value: %FALSE if @file can't be loaded asynchronously,
+ *               @callback is not called in that case.
+ */
+gboolean
+file_open_image_async (Gimp                  *gimp,
+                       GimpContext           *context,
+                       GFile                 *file,
+                       FileOpenImageCallback  callback,
+                       gpointer               user_data)
+{
+  GimpPlugInProcedure *file_proc;
+  GimpProcedure       *procedure;
+  GimpValueArray      *args;
+  FileOpenAsync       *async;
+  gchar               *path = NULL;
+
+  g_return_val_if_fail (GIMP_IS_GIMP (gimp), FALSE);
+  g_return_val_if_fail (GIMP_IS_CONTEXT (context), FALSE);
+  g_return_val_if_fail (G_IS_FILE (file), FALSE);
+  g_return_val_if_fail (callback != NULL, FALSE);
+
+  if (! g_file_is_native (file))
+    return FALSE;
+
+  file_proc = gimp_plug_in_manager_file_procedure_find (gimp->plug_in_manager,
+                                                        GIMP_FILE_PROCEDURE_GROUP_OPEN,
+                                                        file, NULL);
+
+  if (! file_proc)
+    return FALSE;
+
+  procedure = GIMP_PROCEDURE (file_proc);
+
+  if (procedure->num_args < 3)
+    return FALSE;
+
+  if (! file_proc->handles_uri)
+    path = g_file_get_path (file);
+
+  if (! path)
+    path = g_file_get_uri (file);
+
+  args = gimp_procedure_get_arguments (procedure);
+
+  g_value_set_int     (gimp_value_array_index (args, 0), GIMP_RUN_NONINTERACTIVE);
+  g_value_take_string (gimp_value_array_index (args, 1), path);
+  g_value_take_string (gimp_value_array_index (args, 2), g_file_get_uri (file));
+
+  async = file_open_async_new (gimp, context, file, file_proc, user_data);
+  async->image_callback = callback;
+
+  gimp_plug_in_procedure_run_async (file_proc,
+                                    gimp, context, NULL, args,
+                                    file_open_image_async_return,
+                                    async);
+
+  gimp_value_array_unref (args);
+
+  return TRUE;
 }
 
 GimpImage *
@@ -728,6 +790,258 @@ file_open_from_command_line (Gimp     *gimp,
 
 /*  private functions  */
 
+static GimpImage *
+file_open_image_get_result (Gimp                 *gimp,
+                            GimpPlugInProcedure  *file_proc,
+                            GimpValueArray       *return_vals,
+                            GimpPDBStatusType    *status,
+                            const gchar         **mime_type,
+                            GError              **error)
+{
+  GimpImage *image = NULL;
+
+  *status = g_value_get_enum (gimp_value_array_index (return_vals, 0));
+
+  if (*status == GIMP_PDB_SUCCESS)
+    image = gimp_value_get_image (gimp_value_array_index (return_vals, 1),
+                                  gimp);
+
+  if (*status == GIMP_PDB_SUCCESS)
+    {
+      if (image)
+        {
+          /* Only set the load procedure if it hasn't already been set. */
+          if (! gimp_image_get_load_proc (image))
+            gimp_image_set_load_proc (image, file_proc);
+
+          file_proc = gimp_image_get_load_proc (image);
+
+          if (mime_type)
+            *mime_type = g_slist_nth_data (file_proc->mime_types_list, 0);
+        }
+      else
+        {
+          if (error && ! *error)
+            g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                         _("%s plug-in returned SUCCESS but did not "
+                           "return an image"),
+                         gimp_procedure_get_label (GIMP_PROCEDURE (file_proc)));
+
+          *status = GIMP_PDB_EXECUTION_ERROR;
+        }
+    }
+  else if (*status != GIMP_PDB_CANCEL)
+    {
+      if (error && ! *error)
+        g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                     _("%s plug-In could not open image"),
+                     gimp_procedure_get_label (GIMP_PROCEDURE (file_proc)));
+    }
+
+  return image;
+}
+
+static void
+file_open_image_prepare (GimpImage    *image,
+                         GimpContext  *context,
+                         GimpProgress *progress,
+                         GFile        *file,
+                         gboolean      as_new,
+                         gboolean      interactive)
+{
+  gimp_image_undo_disable (image);
+
+  if (file_open_file_proc_is_import (gimp_image_get_load_proc (image)))
+    {
+      file_import_image (image, context, file, interactive, progress);
+    }
+
+  /* Enables undo again */
+  file_open_sanitize_image (image, as_new);
+}
+
+static GimpImage *
+file_open_thumbnail_get_result (Gimp                 *gimp,
+                                GimpPlugInProcedure  *file_proc,
+                                GimpValueArray       *return_vals,
+                                const gchar         **mime_type,
+                                gint                 *image_width,
+                                gint                 *image_height,
+                                const Babl          **format,
+                                gint                 *num_layers)
+{
+  GimpPDBStatusType  status;
+  GimpImage         *image = NULL;
+
+  status = g_value_get_enum (gimp_value_array_index (return_vals, 0));
+
+  if (status == GIMP_PDB_SUCCESS &&
+      GIMP_VALUE_HOLDS_IMAGE_ID (gimp_value_array_index (return_vals, 1)))
+    {
+      image = gimp_value_get_image (gimp_value_array_index (return_vals, 1),
+                                    gimp);
+
+      if (gimp_value_array_length (return_vals) >= 3 &&
+          G_VALUE_HOLDS_INT (gimp_value_array_index (return_vals, 2)) &&
+          G_VALUE_HOLDS_INT (gimp_value_array_index (return_vals, 3)))
+        {
+          *image_width =
+            MAX (0, g_value_get_int (gimp_value_array_index (return_vals, 2)));
+
+          *image_height =
+            MAX (0, g_value_get_int (gimp_value_array_index (return_vals, 3)));
+
+          if (gimp_value_array_length (return_vals) >= 5 &&
+              G_VALUE_HOLDS_INT (gimp_value_array_index (return_vals, 4)))
+            {
+              gint value = g_value_get_int (gimp_value_array_index (return_vals, 4));
+
+              switch (value)
+                {
+                case GIMP_RGB_IMAGE:
+                  *format = gimp_babl_format (GIMP_RGB,
+                                              GIMP_PRECISION_U8_GAMMA,
+                                              FALSE);
+                  break;
+
+                case GIMP_RGBA_IMAGE:
+                  *format = gimp_babl_format (GIMP_RGB,
+                                              GIMP_PRECISION_U8_GAMMA,
+                                              TRUE);
+                  break;
+
+                case GIMP_GRAY_IMAGE:
+                  *format = gimp_babl_format (GIMP_GRAY,
+                                              GIMP_PRECISION_U8_GAMMA,
+                                              FALSE);
+                  break;
+
+                case GIMP_GRAYA_IMAGE:
+                  *format = gimp_babl_format (GIMP_GRAY,
+                                              GIMP_PRECISION_U8_GAMMA,
+                                              TRUE);
+                  break;
+
+                case GIMP_INDEXED_IMAGE:
+                case GIMP_INDEXEDA_IMAGE:
+                  {
+                    const Babl *rgb;
+                    const Babl *rgba;
+
+                    babl_new_palette ("-gimp-indexed-format-dummy",
+                                      &rgb, &rgba);
+
+                    if (value == GIMP_INDEXED_IMAGE)
+                      *format = rgb;
+                    else
+                      *format = rgba;
+                  }
+                  break;
+
+                default:
+                  break;
+                }
+            }
+
+          if (gimp_value_array_length (return_vals) >= 6 &&
+              G_VALUE_HOLDS_INT (gimp_value_array_index (return_vals, 5)))
+            {
+              *num_layers =
+                MAX (0, g_value_get_int (gimp_value_array_index (return_vals, 5)));
+            }
+        }
+
+      if (image)
+        {
+          file_open_sanitize_image (image, FALSE);
+
+          *mime_type = g_slist_nth_data (file_proc->mime_types_list, 0);
+
+#ifdef GIMP_UNSTABLE
+          g_printerr ("opened thumbnail at %d x %d\n",
+                      gimp_image_get_width  (image),
+                      gimp_image_get_height (image));
+#endif
+        }
+    }
+
+  return image;
+}
+
+static FileOpenAsync *
+file_open_async_new (Gimp                *gimp,
+                     GimpContext         *context,
+                     GFile               *file,
+                     GimpPlugInProcedure *file_proc,
+                     gpointer             user_data)
+{
+  FileOpenAsync *async = g_slice_new0 (FileOpenAsync);
+
+  async->gimp      = gimp;
+  async->context   = g_object_ref (context);
+  async->file      = g_object_ref (file);
+  async->file_proc = file_proc;
+  async->user_data = user_data;
+
+  return async;
+}
+
+static void
+file_open_async_free (FileOpenAsync *async)
+{
+  g_object_unref (async->context);
+  g_object_unref (async->file);
+
+  g_slice_free (FileOpenAsync, async);
+}
+
+static void
+file_open_image_async_return (GimpValueArray *return_vals,
+                              gpointer        data)
+{
+  FileOpenAsync     *async     = data;
+  GimpImage         *image;
+  GimpPDBStatusType  status;
+  const gchar       *mime_type = NULL;
+
+  image = file_open_image_get_result (async->gimp, async->file_proc,
+                                      return_vals, &status, &mime_type,
+                                      NULL);
+
+  if (image)
+    file_open_image_prepare (image, async->context, NULL, async->file,
+                             FALSE, FALSE);
+
+  async->image_callback (image, mime_type, async->user_data);
+
+  file_open_async_free (async);
+}
+
+static void
+file_open_thumbnail_async_return (GimpValueArray *return_vals,
+                                  gpointer        data)
+{
+  FileOpenAsync *async        = data;
+  GimpImage     *image;
+  const gchar   *mime_type    = NULL;
+  gint           image_width  = 0;
+  gint           image_height = 0;
+  const Babl    *format       = NULL;
+  gint           num_layers   = -1;
+
+  image = file_open_thumbnail_get_result (async->gimp, async->file_proc,
+                                          return_vals, &mime_type,
+                                          &image_width, &image_height,
+                                          &format, &num_layers);
+
+  async->thumbnail_callback (image, mime_type,
+                             image_width, image_height,
+                             format, num_layers,
+                             async->user_data);
+
+  file_open_async_free (async);
+}
+
 static void
 file_open_sanitize_image (GimpImage *image,
                           gboolean   as_new)
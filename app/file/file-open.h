@@ -21,67 +21,91 @@
 #define __FILE_OPEN_H__
 
 
-GimpImage * file_open_image                 (Gimp                *gimp,
-                                             GimpContext         *context,
-                                             GimpProgress        *progress,
-                                             GFile               *file,
-                                             GFile               *entered_file,
-                                             gboolean             as_new,
-                                             GimpPlugInProcedure *file_proc,
-                                             GimpRunMode          run_mode,
-                                             GimpPDBStatusType   *status,
-                                             const gchar        **mime_type,
-                                             GError             **error);
+typedef void (* FileOpenImageCallback)     (GimpImage   *image,
+                                            const gchar *mime_type,
+                                            gpointer     user_data);
+typedef void (* FileOpenThumbnailCallback) (GimpImage   *image,
+                                            const gchar *mime_type,
+                                            gint         image_width,
+                                            gint         image_height,
+                                            const Babl  *format,
+                                            gint         num_layers,
+                                            gpointer     user_data);
 
-GimpImage * file_open_thumbnail             (Gimp                *gimp,
-                                             GimpContext         *context,
-                                             GimpProgress        *progress,
-                                             GFile               *file,
-                                             gint                 size,
-                                             const gchar        **mime_type,
-                                             gint                *image_width,
-                                             gint                *image_height,
-                                             const Babl         **format,
-                                             gint                *num_layers,
-                                             GError             **error);
-GimpImage * file_open_with_display          (Gimp                *gimp,
-                                             GimpContext         *context,
-                                             GimpProgress        *progress,
-                                             GFile               *file,
-                                             gboolean             as_new,
-                                             GObject             *screen,
-                                             gint                 monitor,
-                                             GimpPDBStatusType   *status,
-                                             GError             **error);
 
-GimpImage * file_open_with_proc_and_display (Gimp                *gimp,
-                                             GimpContext         *context,
-                                             GimpProgress        *progress,
-                                             GFile               *file,
-                                             GFile               *entered_file,
-                                             gboolean             as_new,
-                                             GimpPlugInProcedure *file_proc,
-                                             GObject             *screen,
-                                             gint                 monitor,
-                                             GimpPDBStatusType   *status,
-                                             GError             **error);
+GimpImage * file_open_image                 (Gimp                     *gimp,
+                                             GimpContext              *context,
+                                             GimpProgress             *progress,
+                                             GFile                    *file,
+                                             GFile                    *entered_file,
+                                             gboolean                  as_new,
+                                             GimpPlugInProcedure      *file_proc,
+                                             GimpRunMode               run_mode,
+                                             GimpPDBStatusType        *status,
+                                             const gchar             **mime_type,
+                                             GError                  **error);
 
-GList     * file_open_layers                (Gimp                *gimp,
-                                             GimpContext         *context,
-                                             GimpProgress        *progress,
-                                             GimpImage           *dest_image,
-                                             gboolean             merge_visible,
-                                             GFile               *file,
-                                             GimpRunMode          run_mode,
-                                             GimpPlugInProcedure *file_proc,
-                                             GimpPDBStatusType   *status,
-                                             GError             **error);
+GimpImage * file_open_thumbnail             (Gimp                     *gimp,
+                                             GimpContext              *context,
+                                             GimpProgress             *progress,
+                                             GFile                    *file,
+                                             gint                      size,
+                                             const gchar             **mime_type,
+                                             gint                     *image_width,
+                                             gint                     *image_height,
+                                             const Babl              **format,
+                                             gint                     *num_layers,
+                                             GError                  **error);
+gboolean    file_open_thumbnail_async       (Gimp                     *gimp,
+                                             GimpContext              *context,
+                                             GFile                    *file,
+                                             gint                      size,
+                                             FileOpenThumbnailCallback callback,
+                                             gpointer                  user_data);
+gboolean    file_open_image_async           (Gimp                     *gimp,
+                                             GimpContext              *context,
+                                             GFile                    *file,
+                                             FileOpenImageCallback     callback,
+                                             gpointer                  user_data);
 
-gboolean    file_open_from_command_line     (Gimp                *gimp,
-                                             GFile               *file,
-                                             gboolean             as_new,
-                                             GObject             *screen,
-                                             gint                 monitor);
+GimpImage * file_open_with_display          (Gimp                     *gimp,
+                                             GimpContext              *context,
+                                             GimpProgress             *progress,
+                                             GFile                    *file,
+                                             gboolean                  as_new,
+                                             GObject                  *screen,
+                                             gint                      monitor,
+                                             GimpPDBStatusType        *status,
+                                             GError                  **error);
+
+GimpImage * file_open_with_proc_and_display (Gimp                     *gimp,
+                                             GimpContext              *context,
+                                             GimpProgress             *progress,
+                                             GFile                    *file,
+                                             GFile                    *entered_file,
+                                             gboolean                  as_new,
+                                             GimpPlugInProcedure      *file_proc,
+                                             GObject                  *screen,
+                                             gint                      monitor,
+                                             GimpPDBStatusType        *status,
+                                             GError                  **error);
+
+GList     * file_open_layers                (Gimp                     *gimp,
+                                             GimpContext              *context,
+                                             GimpProgress             *progress,
+                                             GimpImage                *dest_image,
+                                             gboolean                  merge_visible,
+                                             GFile                    *file,
+                                             GimpRunMode               run_mode,
+                                             GimpPlugInProcedure      *file_proc,
+                                             GimpPDBStatusType        *status,
+                                             GError                  **error);
+
+gboolean    file_open_from_command_line     (Gimp                     *gimp,
+                                             GFile                    *file,
+                                             gboolean                  as_new,
+                                             GObject                  *screen,
+                                             gint                      monitor);
 
 
 #endif /* __FILE_OPEN_H__ */
@@ -32,10 +32,14 @@
 #include "core/gimpprogress.h"
 
 #include "gimp-gegl-apply-operation.h"
+#include "gimp-gegl-loops.h"
 #include "gimp-gegl-nodes.h"
 #include "gegl/gimp-gegl-utils.h"
 
 
+#define TRANSFORM_PROGRESS_ROWS 256
+
+
 void
 gimp_gegl_apply_operation (GeglBuffer          *src_buffer,
                            GimpProgress        *progress,
@@ -690,24 +694,56 @@ gimp_gegl_apply_transform (GeglBuffer            *src_buffer,
                            GimpTransformResize    clip_result,
                            GimpMatrix3           *transform)
 {
-  GeglNode *node;
-  gboolean  clip_to_input;
+  GeglRectangle rect;
+  gboolean      progress_started = FALSE;
+  gint          y;
 
   g_return_if_fail (GEGL_IS_BUFFER (src_buffer));
   g_return_if_fail (progress == NULL || GIMP_IS_PROGRESS (progress));
   g_return_if_fail (GEGL_IS_BUFFER (dest_buffer));
 
-  clip_to_input = (clip_result == GIMP_TRANSFORM_RESIZE_CLIP);
+  /*  clip_result is already reflected by dest_buffer's extent, which
+   *  is all gegl:transform's "clip-to-input" used to decide
+   */
+  rect = *gegl_buffer_get_extent (dest_buffer);
 
-  node = gegl_node_new_child (NULL,
-                              "operation",     "gegl:transform",
-                              "sampler",       interpolation_type,
-                              "clip-to-input", clip_to_input,
-                              NULL);
+  if (! progress)
+    {
+      gimp_gegl_transform (src_buffer, dest_buffer, &rect,
+                           transform, interpolation_type);
+      return;
+    }
+
+  if (gimp_progress_is_active (progress))
+    {
+      if (undo_desc)
+        gimp_progress_set_text_literal (progress, undo_desc);
+    }
+  else
+    {
+      gimp_progress_start (progress, FALSE, "%s", undo_desc);
 
-  gimp_gegl_node_set_matrix (node, transform);
+      progress_started = TRUE;
+    }
 
-  gimp_gegl_apply_operation (src_buffer, progress, undo_desc,
-                             node, dest_buffer, NULL);
-  g_object_unref (node);
+  /*  render in bands of rows, so the progress can be updated  */
+  for (y = 0; y < rect.height; y += TRANSFORM_PROGRESS_ROWS)
+    {
+      GeglRectangle band;
+
+      band.x      = rect.x;
+      band.y      = rect.y + y;
+      band.width  = rect.width;
+      band.height = MIN (TRANSFORM_PROGRESS_ROWS, rect.height - y);
+
+      gimp_gegl_transform (src_buffer, dest_buffer, &band,
+                           transform, interpolation_type);
+
+      gimp_progress_set_value (progress,
+                               (gdouble) (y + band.height) /
+                               (gdouble) rect.height);
+    }
+
+  if (progress_started)
+    gimp_progress_end (progress);
 }
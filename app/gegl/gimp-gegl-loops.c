@@ -38,10 +38,27 @@
 
 #include "gimp-babl.h"
 #include "gimp-gegl-loops.h"
+#include "gimp-gegl-parallel.h"
 
 #include "core/gimpprogress.h"
 
 
+#define TRANSFORM_EPSILON      1e-6
+#define TRANSFORM_MIN_SUB_AREA (64 * 64)
+
+
+typedef struct
+{
+  GeglBuffer            *src_buffer;
+  GeglBuffer            *dest_buffer;
+  const Babl            *format;
+  gint                   bpp;
+  GimpMatrix3            inverse;
+  GimpInterpolationType  interpolation_type;
+  gboolean               swap_axes;
+} TransformData;
+
+
 void
 gimp_gegl_convolve (GeglBuffer          *src_buffer,
                     const GeglRectangle *src_rect,
@@ -828,3 +845,382 @@ gimp_gegl_convert_color_profile (GeglBuffer               *src_buffer,
         gimp_progress_set_value (progress, 1.0);
     }
 }
+
+
+/*  gimp_gegl_transform() helpers  */
+
+static gboolean
+gimp_gegl_transform_is_integer (gdouble value)
+{
+  return fabs (value - RINT (value)) < TRANSFORM_EPSILON;
+}
+
+/*  returns TRUE if @matrix maps every destination pixel back to exactly
+ *  one source pixel, so the result can be copied instead of resampled:
+ *  translations by whole pixels, and flips and rotations by multiples
+ *  of 90 degrees. With nearest neighbour interpolation, this also holds
+ *  for axis-aligned scales. Only enlarging scales are copied though,
+ *  since a reduced area would fetch most of the source to use a few of
+ *  its pixels, which the sampler does better.
+ */
+static gboolean
+gimp_gegl_transform_is_exact (const GimpMatrix3     *matrix,
+                              GimpInterpolationType  interpolation_type,
+                              gboolean              *swap_axes)
+{
+  const gdouble (*m)[3] = matrix->coeff;
+
+  if (! gimp_matrix3_is_affine (matrix))
+    return FALSE;
+
+  if (fabs (m[0][1]) < TRANSFORM_EPSILON &&
+      fabs (m[1][0]) < TRANSFORM_EPSILON)
+    {
+      *swap_axes = FALSE;
+
+      if (interpolation_type == GIMP_INTERPOLATION_NONE)
+        return (fabs (m[0][0]) > 1.0 - TRANSFORM_EPSILON &&
+                fabs (m[1][1]) > 1.0 - TRANSFORM_EPSILON);
+
+      return (fabs (fabs (m[0][0]) - 1.0) < TRANSFORM_EPSILON &&
+              fabs (fabs (m[1][1]) - 1.0) < TRANSFORM_EPSILON &&
+              gimp_gegl_transform_is_integer (m[0][2])        &&
+              gimp_gegl_transform_is_integer (m[1][2]));
+    }
+  else if (fabs (m[0][0]) < TRANSFORM_EPSILON &&
+           fabs (m[1][1]) < TRANSFORM_EPSILON)
+    {
+      *swap_axes = TRUE;
+
+      if (interpolation_type == GIMP_INTERPOLATION_NONE)
+        return (fabs (m[0][1]) > 1.0 - TRANSFORM_EPSILON &&
+                fabs (m[1][0]) > 1.0 - TRANSFORM_EPSILON);
+
+      return (fabs (fabs (m[0][1]) - 1.0) < TRANSFORM_EPSILON &&
+              fabs (fabs (m[1][0]) - 1.0) < TRANSFORM_EPSILON &&
+              gimp_gegl_transform_is_integer (m[0][2])        &&
+              gimp_gegl_transform_is_integer (m[1][2]));
+    }
+
+  return FALSE;
+}
+
+static void
+gimp_gegl_transform_exact_area (const GeglRectangle *area,
+                                TransformData       *data)
+{
+  gdouble             (*inv)[3] = data->inverse.coeff;
+  const GeglRectangle *src_extent;
+  GeglRectangle        src_rect;
+  gssize              *col_src;
+  gssize              *row_src;
+  gint                 src_x1, src_y1;
+  gint                 src_x2, src_y2;
+  guchar              *src;
+  guchar              *dest;
+  guchar              *d;
+  gsize                src_stride;
+  gsize                dest_stride;
+  gint                 x, y;
+
+  /*  the source coordinate each destination column and row maps to;
+   *  without swapped axes the columns give x and the rows give y,
+   *  with swapped axes it's the other way round
+   */
+  col_src = g_new (gssize, area->width);
+  row_src = g_new (gssize, area->height);
+
+  for (x = 0; x < area->width; x++)
+    {
+      gdouble c = area->x + x + 0.5;
+
+      col_src[x] = floor (data->swap_axes ?
+                          inv[1][0] * c + inv[1][2] :
+                          inv[0][0] * c + inv[0][2]);
+    }
+
+  for (y = 0; y < area->height; y++)
+    {
+      gdouble r = area->y + y + 0.5;
+
+      row_src[y] = floor (data->swap_axes ?
+                          inv[0][1] * r + inv[0][2] :
+                          inv[1][1] * r + inv[1][2]);
+    }
+
+  src_x1 = src_y1 = G_MAXINT;
+  src_x2 = src_y2 = G_MININT;
+
+  for (x = 0; x < area->width; x++)
+    {
+      if (data->swap_axes)
+        {
+          src_y1 = MIN (src_y1, col_src[x]);
+          src_y2 = MAX (src_y2, col_src[x] + 1);
+        }
+      else
+        {
+          src_x1 = MIN (src_x1, col_src[x]);
+          src_x2 = MAX (src_x2, col_src[x] + 1);
+        }
+    }
+
+  for (y = 0; y < area->height; y++)
+    {
+      if (data->swap_axes)
+        {
+          src_x1 = MIN (src_x1, row_src[y]);
+          src_x2 = MAX (src_x2, row_src[y] + 1);
+        }
+      else
+        {
+          src_y1 = MIN (src_y1, row_src[y]);
+          src_y2 = MAX (src_y2, row_src[y] + 1);
+        }
+    }
+
+  src_extent = gegl_buffer_get_extent (data->src_buffer);
+
+  if (! gegl_rectangle_intersect (&src_rect,
+                                  GEGL_RECTANGLE (src_x1, src_y1,
+                                                  src_x2 - src_x1,
+                                                  src_y2 - src_y1),
+                                  src_extent))
+    {
+      gegl_buffer_clear (data->dest_buffer, area);
+
+      g_free (col_src);
+      g_free (row_src);
+
+      return;
+    }
+
+  src_stride  = (gsize) src_rect.width * data->bpp;
+  dest_stride = (gsize) area->width    * data->bpp;
+
+  src  = g_malloc (src_stride * src_rect.height);
+  dest = g_malloc0 (dest_stride * area->height);
+
+  gegl_buffer_get (data->src_buffer, &src_rect, 1.0, data->format,
+                   src, src_stride, GEGL_ABYSS_NONE);
+
+  /*  turn the coordinates into byte offsets into the source, or -1 for
+   *  pixels outside of it, so the loop below is just lookups and copies
+   */
+  for (x = 0; x < area->width; x++)
+    {
+      if (data->swap_axes)
+        {
+          if (col_src[x] < src_rect.y ||
+              col_src[x] >= src_rect.y + src_rect.height)
+            col_src[x] = -1;
+          else
+            col_src[x] = (gsize) (col_src[x] - src_rect.y) * src_stride;
+        }
+      else
+        {
+          if (col_src[x] < src_rect.x ||
+              col_src[x] >= src_rect.x + src_rect.width)
+            col_src[x] = -1;
+          else
+            col_src[x] = (gsize) (col_src[x] - src_rect.x) * data->bpp;
+        }
+    }
+
+  for (y = 0; y < area->height; y++)
+    {
+      if (data->swap_axes)
+        {
+          if (row_src[y] < src_rect.x ||
+              row_src[y] >= src_rect.x + src_rect.width)
+            row_src[y] = -1;
+          else
+            row_src[y] = (gsize) (row_src[y] - src_rect.x) * data->bpp;
+        }
+      else
+        {
+          if (row_src[y] < src_rect.y ||
+              row_src[y] >= src_rect.y + src_rect.height)
+            row_src[y] = -1;
+          else
+            row_src[y] = (gsize) (row_src[y] - src_rect.y) * src_stride;
+        }
+    }
+
+  d = dest;
+
+  for (y = 0; y < area->height; y++)
+    {
+      const guchar *s = src + row_src[y];
+
+      if (row_src[y] < 0)
+        {
+          d += dest_stride;
+          continue;
+        }
+
+      for (x = 0; x < area->width; x++)
+        {
+          if (col_src[x] >= 0)
+            memcpy (d, s + col_src[x], data->bpp);
+
+          d += data->bpp;
+        }
+    }
+
+  gegl_buffer_set (data->dest_buffer, area, 0, data->format,
+                   dest, GEGL_AUTO_ROWSTRIDE);
+
+  g_free (dest);
+  g_free (src);
+  g_free (col_src);
+  g_free (row_src);
+}
+
+static void
+gimp_gegl_transform_sample_area (const GeglRectangle *area,
+                                 TransformData       *data)
+{
+  gdouble             (*inv)[3] = data->inverse.coeff;
+  GeglSampler         *sampler;
+  GeglBufferIterator  *iter;
+  const GeglRectangle *roi;
+
+  /*  samplers keep state, so every thread gets its own  */
+  sampler = gegl_buffer_sampler_new_at_level (data->src_buffer,
+                                              data->format,
+                                              (GeglSamplerType)
+                                              data->interpolation_type,
+                                              0);
+
+  iter = gegl_buffer_iterator_new (data->dest_buffer, area, 0,
+                                   data->format,
+                                   GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+  roi = &iter->roi[0];
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      guchar *dest = iter->data[0];
+      gint    x, y;
+
+      for (y = roi->y; y < roi->y + roi->height; y++)
+        {
+          gdouble dx = roi->x + 0.5;
+          gdouble dy = y + 0.5;
+          gdouble u  = inv[0][0] * dx + inv[0][1] * dy + inv[0][2];
+          gdouble v  = inv[1][0] * dx + inv[1][1] * dy + inv[1][2];
+          gdouble w  = inv[2][0] * dx + inv[2][1] * dy + inv[2][2];
+
+          for (x = 0; x < roi->width; x++)
+            {
+              if (w > TRANSFORM_EPSILON)
+                {
+                  GeglMatrix2 jacobian;
+                  gdouble     su = u / w;
+                  gdouble     sv = v / w;
+
+                  jacobian.coeff[0][0] = (inv[0][0] - su * inv[2][0]) / w;
+                  jacobian.coeff[0][1] = (inv[0][1] - su * inv[2][1]) / w;
+                  jacobian.coeff[1][0] = (inv[1][0] - sv * inv[2][0]) / w;
+                  jacobian.coeff[1][1] = (inv[1][1] - sv * inv[2][1]) / w;
+
+                  gegl_sampler_get (sampler, su, sv, &jacobian,
+                                    dest, GEGL_ABYSS_NONE);
+                }
+              else
+                {
+                  memset (dest, 0, data->bpp);
+                }
+
+              dest += data->bpp;
+
+              u += inv[0][0];
+              v += inv[1][0];
+              w += inv[2][0];
+            }
+        }
+    }
+
+  g_object_unref (sampler);
+}
+
+/**
+ * gimp_gegl_transform:
+ * @src_buffer:         the buffer to transform
+ * @dest_buffer:        the buffer to render the result to
+ * @dest_rect:          the area of @dest_buffer to render
+ * @transform:          maps @src_buffer's to @dest_buffer's coordinates
+ * @interpolation_type: the interpolation to use
+ *
+ * Renders @dest_rect of the transformed @src_buffer, what gegl:transform
+ * would render. Transforms which only move whole pixels around, like
+ * whole-pixel translations and rotations by multiples of 90 degrees,
+ * are copied exactly without any resampling; all others are resampled
+ * in parallel, with a sampler per thread.
+ **/
+void
+gimp_gegl_transform (GeglBuffer            *src_buffer,
+                     GeglBuffer            *dest_buffer,
+                     const GeglRectangle   *dest_rect,
+                     const GimpMatrix3     *transform,
+                     GimpInterpolationType  interpolation_type)
+{
+  TransformData data;
+
+  g_return_if_fail (GEGL_IS_BUFFER (src_buffer));
+  g_return_if_fail (GEGL_IS_BUFFER (dest_buffer));
+  g_return_if_fail (transform != NULL);
+
+  if (! dest_rect)
+    dest_rect = gegl_buffer_get_extent (dest_buffer);
+
+  if (dest_rect->width < 1 || dest_rect->height < 1)
+    return;
+
+  data.src_buffer         = src_buffer;
+  data.dest_buffer        = dest_buffer;
+  data.format             = gegl_buffer_get_format (dest_buffer);
+  data.bpp                = babl_format_get_bytes_per_pixel (data.format);
+  data.inverse            = *transform;
+  data.interpolation_type = interpolation_type;
+  data.swap_axes          = FALSE;
+
+  gimp_matrix3_invert (&data.inverse);
+
+  if (gimp_gegl_transform_is_exact (transform, interpolation_type,
+                                    &data.swap_axes))
+    {
+      const gdouble (*m)[3] = transform->coeff;
+
+      if (! data.swap_axes &&
+          fabs (m[0][0] - 1.0) < TRANSFORM_EPSILON &&
+          fabs (m[1][1] - 1.0) < TRANSFORM_EPSILON &&
+          gimp_gegl_transform_is_integer (m[0][2]) &&
+          gimp_gegl_transform_is_integer (m[1][2]))
+        {
+          /*  a plain translation, let GEGL copy (and share) the tiles  */
+          GeglRectangle src_rect = *dest_rect;
+
+          src_rect.x -= RINT (m[0][2]);
+          src_rect.y -= RINT (m[1][2]);
+
+          gegl_buffer_copy (src_buffer,  &src_rect, GEGL_ABYSS_NONE,
+                            dest_buffer, dest_rect);
+        }
+      else
+        {
+          gimp_gegl_parallel_distribute_area (dest_rect,
+                                              TRANSFORM_MIN_SUB_AREA,
+                                              (GimpGeglParallelDistributeAreaFunc)
+                                              gimp_gegl_transform_exact_area,
+                                              &data);
+        }
+    }
+  else
+    {
+      gimp_gegl_parallel_distribute_area (dest_rect, TRANSFORM_MIN_SUB_AREA,
+                                          (GimpGeglParallelDistributeAreaFunc)
+                                          gimp_gegl_transform_sample_area,
+                                          &data);
+    }
+}
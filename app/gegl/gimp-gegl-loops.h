@@ -100,5 +100,11 @@ void   gimp_gegl_convert_color_profile (GeglBuffer               *src_buffer,
                                         gboolean                  bpc,
                                         GimpProgress             *progress);
 
+void   gimp_gegl_transform             (GeglBuffer               *src_buffer,
+                                        GeglBuffer               *dest_buffer,
+                                        const GeglRectangle      *dest_rect,
+                                        const GimpMatrix3        *transform,
+                                        GimpInterpolationType     interpolation_type);
+
 
 #endif /* __GIMP_GEGL_LOOPS_H__ */
@@ -374,16 +374,19 @@ gimp_gegl_mask_combine_buffer (GeglBuffer     *mask,
                                gint            off_x,
                                gint            off_y)
 {
-  GeglBufferIterator *iter;
-  GeglRectangle       rect;
-  gint                x, y, w, h;
+  GeglBufferIterator  *iter;
+  const GeglRectangle *extent;
+  GeglRectangle        rect;
+  gint                 x, y, w, h;
 
   g_return_val_if_fail (GEGL_IS_BUFFER (mask), FALSE);
   g_return_val_if_fail (GEGL_IS_BUFFER (add_on), FALSE);
 
-  if (! gimp_rectangle_intersect (off_x, off_y,
-                                  gegl_buffer_get_width  (add_on),
-                                  gegl_buffer_get_height (add_on),
+  /*  add_on may be a sub-buffer which doesn't start at 0, 0  */
+  extent = gegl_buffer_get_extent (add_on);
+
+  if (! gimp_rectangle_intersect (off_x + extent->x, off_y + extent->y,
+                                  extent->width, extent->height,
                                   0, 0,
                                   gegl_buffer_get_width  (mask),
                                   gegl_buffer_get_height (mask),
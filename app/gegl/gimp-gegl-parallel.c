@@ -0,0 +1,352 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimp-gegl-parallel.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gegl.h>
+
+#include "gimp-gegl-types.h"
+
+#include "gimp-gegl-parallel.h"
+
+
+#define GIMP_GEGL_PARALLEL_MAX_THREADS 64
+
+
+typedef struct
+{
+  GimpGeglParallelDistributeFunc  func;
+  gpointer                        user_data;
+  gint                            n;
+  gint                            remaining;
+  GMutex                          mutex;
+  GCond                           cond;
+} GimpGeglParallelTask;
+
+typedef struct
+{
+  GimpGeglParallelTask *task;
+  gint                  i;
+} GimpGeglParallelItem;
+
+typedef struct
+{
+  gsize                                size;
+  GimpGeglParallelDistributeRangeFunc  func;
+  gpointer                             user_data;
+} GimpGeglParallelRangeData;
+
+typedef struct
+{
+  const GeglRectangle                 *area;
+  gboolean                             vertical;
+  GimpGeglParallelDistributeAreaFunc   func;
+  gpointer                             user_data;
+} GimpGeglParallelAreaData;
+
+typedef struct
+{
+  GimpGeglParallelRunAsyncFunc  func;
+  GimpGeglParallelRunAsyncFunc  done;
+  gint                          priority;
+  gpointer                      user_data;
+} GimpGeglParallelAsync;
+
+
+/*  local function prototypes  */
+
+static void   gimp_gegl_parallel_worker     (GimpGeglParallelItem      *item,
+                                             gpointer                   data);
+static void   gimp_gegl_parallel_range_func (gint                       i,
+                                             gint                       n,
+                                             GimpGeglParallelRangeData *data);
+static void   gimp_gegl_parallel_area_func  (gint                       i,
+                                             gint                       n,
+                                             GimpGeglParallelAreaData  *data);
+
+static void   gimp_gegl_parallel_async_worker (GimpGeglParallelAsync   *async,
+                                               gpointer                 data);
+static gboolean
+              gimp_gegl_parallel_async_done   (GimpGeglParallelAsync   *async);
+
+
+/*  private variables  */
+
+static GThreadPool *worker_pool = NULL;
+static GThreadPool *async_pool  = NULL;
+
+
+/*  public functions  */
+
+gint
+gimp_gegl_parallel_get_n_threads (void)
+{
+  gint n_threads = 1;
+
+  g_object_get (gegl_config (),
+                "threads", &n_threads,
+                NULL);
+
+  return CLAMP (n_threads, 1, GIMP_GEGL_PARALLEL_MAX_THREADS);
+}
+
+void
+gimp_gegl_parallel_distribute (gint                           max_n,
+                               GimpGeglParallelDistributeFunc func,
+                               gpointer                       user_data)
+{
+  GimpGeglParallelTask task;
+  GimpGeglParallelItem items[GIMP_GEGL_PARALLEL_MAX_THREADS];
+  gint                 n;
+  gint                 i;
+
+  g_return_if_fail (func != NULL);
+
+  if (max_n == 0)
+    return;
+
+  n = gimp_gegl_parallel_get_n_threads ();
+
+  if (max_n > 0)
+    n = MIN (n, max_n);
+
+  if (n == 1)
+    {
+      func (0, 1, user_data);
+
+      return;
+    }
+
+  if (g_once_init_enter (&worker_pool))
+    {
+      GThreadPool *pool;
+
+      /*  a shared pool, so nested calls from worker threads can't
+       *  starve each other
+       */
+      pool = g_thread_pool_new ((GFunc) gimp_gegl_parallel_worker, NULL,
+                                -1, FALSE, NULL);
+
+      g_once_init_leave (&worker_pool, pool);
+    }
+
+  task.func      = func;
+  task.user_data = user_data;
+  task.n         = n;
+  task.remaining = n - 1;
+
+  g_mutex_init (&task.mutex);
+  g_cond_init (&task.cond);
+
+  for (i = 1; i < n; i++)
+    {
+      items[i].task = &task;
+      items[i].i    = i;
+
+      g_thread_pool_push (worker_pool, &items[i], NULL);
+    }
+
+  func (0, n, user_data);
+
+  g_mutex_lock (&task.mutex);
+
+  while (task.remaining > 0)
+    g_cond_wait (&task.cond, &task.mutex);
+
+  g_mutex_unlock (&task.mutex);
+
+  g_cond_clear (&task.cond);
+  g_mutex_clear (&task.mutex);
+}
+
+void
+gimp_gegl_parallel_distribute_range (gsize                               size,
+                                     gsize                               min_sub_size,
+                                     GimpGeglParallelDistributeRangeFunc func,
+                                     gpointer                            user_data)
+{
+  GimpGeglParallelRangeData data;
+  gint                      max_n;
+
+  g_return_if_fail (func != NULL);
+
+  if (size == 0)
+    return;
+
+  min_sub_size = MAX (min_sub_size, 1);
+
+  max_n = MIN (size / min_sub_size, G_MAXINT);
+  max_n = MAX (max_n, 1);
+
+  data.size      = size;
+  data.func      = func;
+  data.user_data = user_data;
+
+  gimp_gegl_parallel_distribute (max_n,
+                                 (GimpGeglParallelDistributeFunc)
+                                 gimp_gegl_parallel_range_func,
+                                 &data);
+}
+
+void
+gimp_gegl_parallel_distribute_area (const GeglRectangle                *area,
+                                    gsize                               min_sub_area,
+                                    GimpGeglParallelDistributeAreaFunc  func,
+                                    gpointer                            user_data)
+{
+  GimpGeglParallelAreaData data;
+  gsize                    size;
+  gint                     max_n;
+
+  g_return_if_fail (area != NULL);
+  g_return_if_fail (func != NULL);
+
+  if (area->width <= 0 || area->height <= 0)
+    return;
+
+  size = (gsize) area->width * area->height;
+
+  min_sub_area = MAX (min_sub_area, 1);
+
+  data.area      = area;
+  data.vertical  = area->height >= area->width;
+  data.func      = func;
+  data.user_data = user_data;
+
+  max_n = MIN (size / min_sub_area, G_MAXINT);
+  max_n = MIN (max_n, data.vertical ? area->height : area->width);
+  max_n = MAX (max_n, 1);
+
+  gimp_gegl_parallel_distribute (max_n,
+                                 (GimpGeglParallelDistributeFunc)
+                                 gimp_gegl_parallel_area_func,
+                                 &data);
+}
+
+void
+gimp_gegl_parallel_run_async (GimpGeglParallelRunAsyncFunc func,
+                              GimpGeglParallelRunAsyncFunc done,
+                              gint                         priority,
+                              gpointer                     user_data)
+{
+  GimpGeglParallelAsync *async;
+
+  g_return_if_fail (func != NULL);
+
+  if (g_once_init_enter (&async_pool))
+    {
+      GThreadPool *pool;
+
+      /*  a pool of its own, so long running jobs never delay the
+       *  synchronous distribute functions above
+       */
+      pool = g_thread_pool_new ((GFunc) gimp_gegl_parallel_async_worker, NULL,
+                                gimp_gegl_parallel_get_n_threads (),
+                                FALSE, NULL);
+
+      g_once_init_leave (&async_pool, pool);
+    }
+
+  async = g_slice_new (GimpGeglParallelAsync);
+
+  async->func      = func;
+  async->done      = done;
+  async->priority  = priority;
+  async->user_data = user_data;
+
+  g_thread_pool_push (async_pool, async, NULL);
+}
+
+
+/*  private functions  */
+
+static void
+gimp_gegl_parallel_worker (GimpGeglParallelItem *item,
+                           gpointer              data)
+{
+  GimpGeglParallelTask *task = item->task;
+
+  task->func (item->i, task->n, task->user_data);
+
+  g_mutex_lock (&task->mutex);
+
+  if (--task->remaining == 0)
+    g_cond_signal (&task->cond);
+
+  g_mutex_unlock (&task->mutex);
+}
+
+static void
+gimp_gegl_parallel_range_func (gint                       i,
+                               gint                       n,
+                               GimpGeglParallelRangeData *data)
+{
+  gsize offset;
+  gsize size;
+
+  offset = (2 * i       * data->size + n) / (2 * n);
+  size   = (2 * (i + 1) * data->size + n) / (2 * n) - offset;
+
+  data->func (offset, size, data->user_data);
+}
+
+static void
+gimp_gegl_parallel_area_func (gint                      i,
+                              gint                      n,
+                              GimpGeglParallelAreaData *data)
+{
+  GeglRectangle area = *data->area;
+
+  if (data->vertical)
+    {
+      area.y      = data->area->y + (2 * i       * data->area->height + n) / (2 * n);
+      area.height = data->area->y + (2 * (i + 1) * data->area->height + n) / (2 * n) -
+                    area.y;
+    }
+  else
+    {
+      area.x     = data->area->x + (2 * i       * data->area->width + n) / (2 * n);
+      area.width = data->area->x + (2 * (i + 1) * data->area->width + n) / (2 * n) -
+                   area.x;
+    }
+
+  data->func (&area, data->user_data);
+}
+
+static void
+gimp_gegl_parallel_async_worker (GimpGeglParallelAsync *async,
+                                 gpointer               data)
+{
+  async->func (async->user_data);
+
+  g_idle_add_full (async->priority,
+                   (GSourceFunc) gimp_gegl_parallel_async_done,
+                   async, NULL);
+}
+
+static gboolean
+gimp_gegl_parallel_async_done (GimpGeglParallelAsync *async)
+{
+  if (async->done)
+    async->done (async->user_data);
+
+  g_slice_free (GimpGeglParallelAsync, async);
+
+  return G_SOURCE_REMOVE;
+}
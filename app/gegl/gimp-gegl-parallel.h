@@ -0,0 +1,72 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimp-gegl-parallel.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_GEGL_PARALLEL_H__
+#define __GIMP_GEGL_PARALLEL_H__
+
+
+typedef void (* GimpGeglParallelDistributeFunc)      (gint                 i,
+                                                      gint                 n,
+                                                      gpointer             user_data);
+typedef void (* GimpGeglParallelDistributeRangeFunc) (gsize                offset,
+                                                      gsize                size,
+                                                      gpointer             user_data);
+typedef void (* GimpGeglParallelDistributeAreaFunc)  (const GeglRectangle *area,
+                                                      gpointer             user_data);
+typedef void (* GimpGeglParallelRunAsyncFunc)        (gpointer             user_data);
+
+
+/*  the number of threads GEGL is configured to use, at least 1  */
+gint   gimp_gegl_parallel_get_n_threads    (void);
+
+/*  calls func (i, n, user_data) for every i in [0, n), with n being
+ *  at most max_n, on n threads at once, and returns when all calls
+ *  finished.  The calling thread runs one of the calls itself.
+ */
+void   gimp_gegl_parallel_distribute       (gint                                 max_n,
+                                            GimpGeglParallelDistributeFunc       func,
+                                            gpointer                             user_data);
+
+/*  splits [0, size) into consecutive sub-ranges of at least
+ *  min_sub_size elements and processes them in parallel
+ */
+void   gimp_gegl_parallel_distribute_range (gsize                                size,
+                                            gsize                                min_sub_size,
+                                            GimpGeglParallelDistributeRangeFunc  func,
+                                            gpointer                             user_data);
+
+/*  splits area into bands of at least min_sub_area pixels and
+ *  processes them in parallel
+ */
+void   gimp_gegl_parallel_distribute_area  (const GeglRectangle                 *area,
+                                            gsize                                min_sub_area,
+                                            GimpGeglParallelDistributeAreaFunc   func,
+                                            gpointer                             user_data);
+
+/*  calls func (user_data) on a worker thread and returns immediately.
+ *  When func returned, done (user_data) is called from the main loop
+ *  as an idle of the given priority.
+ */
+void   gimp_gegl_parallel_run_async        (GimpGeglParallelRunAsyncFunc         func,
+                                            GimpGeglParallelRunAsyncFunc         done,
+                                            gint                                 priority,
+                                            gpointer                             user_data);
+
+
+#endif /* __GIMP_GEGL_PARALLEL_H__ */
@@ -345,7 +345,7 @@ gimp_dbus_service_process_idle (GimpDBusService *service)
           const gchar *commands[2] = {data->command, 0};
 
           gimp_batch_run (service->gimp, data->interpreter,
-                          commands);
+                          commands, NULL, 1, 0);
         }
 
       gimp_dbus_service_idle_data_free (data);
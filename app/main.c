@@ -125,6 +125,9 @@ static const gchar        *user_gimprc       = NULL;
 static const gchar        *session_name      = NULL;
 static const gchar        *batch_interpreter = NULL;
 static const gchar       **batch_commands    = NULL;
+static const gchar        *batch_file        = NULL;
+static gint                batch_jobs        = 1;
+static gint                batch_timeout     = 0;
 static const gchar       **filenames         = NULL;
 static gboolean            as_new            = FALSE;
 static gboolean            no_interface      = FALSE;
@@ -234,6 +237,21 @@ static const GOptionEntry main_entries[] =
     G_OPTION_ARG_STRING, &batch_interpreter,
     N_("The procedure to process batch commands with"), "<proc>"
   },
+  {
+    "batch-file", 0, 0,
+    G_OPTION_ARG_FILENAME, &batch_file,
+    N_("File with batch commands to run, one per line"), "<filename>"
+  },
+  {
+    "batch-jobs", 0, 0,
+    G_OPTION_ARG_INT, &batch_jobs,
+    N_("Number of batch commands to run at once"), "<n>"
+  },
+  {
+    "batch-timeout", 0, 0,
+    G_OPTION_ARG_INT, &batch_timeout,
+    N_("Abort batch commands running longer than this"), "<seconds>"
+  },
   {
     "console-messages", 'c', 0,
     G_OPTION_ARG_NONE, &console_messages,
@@ -514,7 +532,8 @@ main (int    argc,
       app_exit (EXIT_FAILURE);
     }
 
-  if (no_interface || be_verbose || console_messages || batch_commands != NULL)
+  if (no_interface || be_verbose || console_messages ||
+      batch_commands != NULL || batch_file != NULL)
     gimp_open_console_window ();
 
   if (no_interface)
@@ -555,6 +574,9 @@ main (int    argc,
            session_name,
            batch_interpreter,
            batch_commands,
+           batch_file,
+           batch_jobs,
+           batch_timeout,
            as_new,
            no_interface,
            no_data,
@@ -0,0 +1,706 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimp-operation-morphology.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <cairo.h>
+#include <gegl.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include "libgimpcolor/gimpcolor.h"
+#include "libgimpmath/gimpmath.h"
+
+#include "operations-types.h"
+
+#include "gegl/gimp-gegl-parallel.h"
+
+#include "gimp-operation-morphology.h"
+
+
+/*  Erosion is done by dilating the negated values, so everything
+ *  below only computes maxima.
+ *
+ *  Dilation commutes with thresholding, so masks with only a few
+ *  distinct values (which is what selections usually are) are dilated
+ *  one level at a time: for every column, the vertical distance to
+ *  the nearest pixel at or above the level is tracked incrementally,
+ *  and a pixel is covered if any column within radius_x has that
+ *  distance inside the ellipse at its offset.  Two sweeps over the
+ *  row find the covered pixels, so the cost per pixel and level does
+ *  not depend on the radius at all.
+ *
+ *  Masks with many distinct values use the sliding column maximum of
+ *  the old implementation, which is exact for any input.
+ *
+ *  Both variants work on bands of rows in parallel, each band starts
+ *  radius_y rows early to set up its state.
+ */
+
+
+#define MAX_LEVELS    64
+#define MIN_BAND_ROWS 32
+
+
+typedef struct
+{
+  GeglBuffer          *input;
+  GeglBuffer          *output;
+  const GeglRectangle *roi;
+  gint                 radius_x;
+  gint                 radius_y;
+  gfloat               sign;
+  gboolean             edge_lock;
+
+  const gint16        *circ;            /* indexed [-radius_x, radius_x] */
+  gint                *reach;           /* indexed [0, radius_y]         */
+
+  gfloat               levels[MAX_LEVELS];
+  gint                 n_levels;
+  gint                 outside_level;   /* index of 0.0, or -1           */
+  gint                 too_many_levels;
+  GMutex               mutex;
+} Morphology;
+
+
+/*  local function prototypes  */
+
+static gint     morphology_find_level      (const gfloat *levels,
+                                            gint          n_levels,
+                                            gfloat        value);
+static gboolean morphology_add_level       (gfloat       *levels,
+                                            gint         *n_levels,
+                                            gfloat        value);
+
+static void     morphology_read_row        (Morphology   *morphology,
+                                            gint          row,
+                                            gfloat       *dest,
+                                            gfloat        pad);
+static void     morphology_read_levels     (Morphology   *morphology,
+                                            gint          row,
+                                            gfloat       *buf,
+                                            guint8       *dest);
+static void     morphology_write_row       (Morphology   *morphology,
+                                            gint          row,
+                                            gfloat       *src);
+
+static void     morphology_collect_levels  (const GeglRectangle *area,
+                                            Morphology   *morphology);
+static void     morphology_levels_band     (gsize         offset,
+                                            gsize         size,
+                                            Morphology   *morphology);
+static void     morphology_sliding_band    (gsize         offset,
+                                            gsize         size,
+                                            Morphology   *morphology);
+
+
+/*  public functions  */
+
+void
+gimp_operation_morphology_compute_border (gint16 *circ,
+                                          gint    radius_x,
+                                          gint    radius_y)
+{
+  gint32  i;
+  gint32  diameter = radius_x * 2 + 1;
+  gdouble tmp;
+
+  for (i = 0; i < diameter; i++)
+    {
+      if (i > radius_x)
+        tmp = (i - radius_x) - 0.5;
+      else if (i < radius_x)
+        tmp = (radius_x - i) - 0.5;
+      else
+        tmp = 0.0;
+
+      circ[i] = RINT (radius_y /
+                      (gdouble) radius_x * sqrt (SQR (radius_x) - SQR (tmp)));
+    }
+}
+
+gboolean
+gimp_operation_morphology_process (GeglBuffer          *input,
+                                   GeglBuffer          *output,
+                                   const GeglRectangle *roi,
+                                   gint                 radius_x,
+                                   gint                 radius_y,
+                                   gboolean             erode,
+                                   gboolean             edge_lock)
+{
+  Morphology  morphology;
+  gint16     *circ;
+  gint       *reach;
+  gsize       band_rows;
+  gint        n_steps;
+  gint        i, d;
+
+  g_return_val_if_fail (GEGL_IS_BUFFER (input), FALSE);
+  g_return_val_if_fail (GEGL_IS_BUFFER (output), FALSE);
+  g_return_val_if_fail (roi != NULL, FALSE);
+  g_return_val_if_fail (radius_x > 0 && radius_y > 0, FALSE);
+
+  if (roi->width < 1 || roi->height < 1)
+    return TRUE;
+
+  circ = g_new (gint16, 2 * radius_x + 1);
+  gimp_operation_morphology_compute_border (circ, radius_x, radius_y);
+
+  /*  the largest column offset whose part of the ellipse still
+   *  reaches d rows up or down
+   */
+  reach = g_new (gint, radius_y + 1);
+
+  for (d = 0, i = radius_x; d <= radius_y; d++)
+    {
+      while (i >= 0 && circ[radius_x + i] < d)
+        i--;
+
+      reach[d] = i;
+    }
+
+  morphology.input           = input;
+  morphology.output          = output;
+  morphology.roi             = roi;
+  morphology.radius_x        = radius_x;
+  morphology.radius_y        = radius_y;
+  morphology.sign            = erode ? -1.0 : 1.0;
+  morphology.edge_lock       = edge_lock;
+  morphology.circ            = circ + radius_x;
+  morphology.reach           = reach;
+  morphology.n_levels        = 0;
+  morphology.outside_level   = -1;
+  morphology.too_many_levels = FALSE;
+
+  g_mutex_init (&morphology.mutex);
+
+  /*  pixels outside roi count as 0.0 without edge lock  */
+  if (! edge_lock)
+    morphology_add_level (morphology.levels, &morphology.n_levels, 0.0);
+
+  gimp_gegl_parallel_distribute_area (roi, MIN_BAND_ROWS * roi->width,
+                                      (GimpGeglParallelDistributeAreaFunc)
+                                      morphology_collect_levels,
+                                      &morphology);
+
+  /*  bands need to be a few times radius_y high, or setting up their
+   *  state costs more than it saves
+   */
+  band_rows = MAX (MIN_BAND_ROWS, 4 * radius_y);
+
+  /*  the lowest level needs no pass, every pixel is covered by it  */
+  n_steps = morphology.n_levels - 1;
+
+  if (! morphology.too_many_levels &&
+      n_steps <= MAX (2, (radius_x + radius_y) / 4))
+    {
+      if (! edge_lock)
+        morphology.outside_level = morphology_find_level (morphology.levels,
+                                                          morphology.n_levels,
+                                                          0.0);
+
+      gimp_gegl_parallel_distribute_range (roi->height, band_rows,
+                                           (GimpGeglParallelDistributeRangeFunc)
+                                           morphology_levels_band,
+                                           &morphology);
+    }
+  else
+    {
+      gimp_gegl_parallel_distribute_range (roi->height, band_rows,
+                                           (GimpGeglParallelDistributeRangeFunc)
+                                           morphology_sliding_band,
+                                           &morphology);
+    }
+
+  g_mutex_clear (&morphology.mutex);
+
+  g_free (reach);
+  g_free (circ);
+
+  return TRUE;
+}
+
+
+/*  private functions  */
+
+/*  returns the index of the first level not below value  */
+static gint
+morphology_find_level (const gfloat *levels,
+                       gint          n_levels,
+                       gfloat        value)
+{
+  gint lo = 0;
+  gint hi = n_levels;
+
+  while (lo < hi)
+    {
+      gint mid = (lo + hi) / 2;
+
+      if (levels[mid] < value)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lo;
+}
+
+static gboolean
+morphology_add_level (gfloat *levels,
+                      gint   *n_levels,
+                      gfloat  value)
+{
+  gint i = morphology_find_level (levels, *n_levels, value);
+
+  if (i < *n_levels && levels[i] == value)
+    return TRUE;
+
+  if (*n_levels == MAX_LEVELS)
+    return FALSE;
+
+  memmove (&levels[i + 1], &levels[i], (*n_levels - i) * sizeof (gfloat));
+
+  levels[i] = value;
+  (*n_levels)++;
+
+  return TRUE;
+}
+
+static void
+morphology_read_row (Morphology *morphology,
+                     gint        row,
+                     gfloat     *dest,
+                     gfloat      pad)
+{
+  const GeglRectangle *roi = morphology->roi;
+  gint                 x;
+
+  if (row < 0 || row >= roi->height)
+    {
+      for (x = 0; x < roi->width; x++)
+        dest[x] = pad;
+
+      return;
+    }
+
+  gegl_buffer_get (morphology->input,
+                   GEGL_RECTANGLE (roi->x, roi->y + row,
+                                   roi->width, 1),
+                   1.0, babl_format ("Y float"), dest,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  if (morphology->sign < 0.0)
+    {
+      for (x = 0; x < roi->width; x++)
+        dest[x] = -dest[x];
+    }
+}
+
+static void
+morphology_read_levels (Morphology *morphology,
+                        gint        row,
+                        gfloat     *buf,
+                        guint8     *dest)
+{
+  gint x;
+
+  morphology_read_row (morphology, row, buf, 0.0);
+
+  for (x = 0; x < morphology->roi->width; x++)
+    {
+      if (x > 0 && buf[x] == buf[x - 1])
+        dest[x] = dest[x - 1];
+      else
+        dest[x] = morphology_find_level (morphology->levels,
+                                         morphology->n_levels,
+                                         buf[x]);
+    }
+}
+
+static void
+morphology_write_row (Morphology *morphology,
+                      gint        row,
+                      gfloat     *src)
+{
+  const GeglRectangle *roi = morphology->roi;
+  gint                 x;
+
+  /*  adding 0.0 turns the -0.0 of negated zeros back into 0.0  */
+  for (x = 0; x < roi->width; x++)
+    src[x] = morphology->sign * src[x] + 0.0f;
+
+  gegl_buffer_set (morphology->output,
+                   GEGL_RECTANGLE (roi->x, roi->y + row,
+                                   roi->width, 1),
+                   0, babl_format ("Y float"), src,
+                   GEGL_AUTO_ROWSTRIDE);
+}
+
+static void
+morphology_collect_levels (const GeglRectangle *area,
+                           Morphology          *morphology)
+{
+  gfloat   levels[MAX_LEVELS];
+  gint     n_levels = 0;
+  gfloat  *row;
+  gboolean success  = TRUE;
+  gint     x, y;
+
+  row = g_new (gfloat, area->width);
+
+  for (y = 0; y < area->height && success; y++)
+    {
+      if (g_atomic_int_get (&morphology->too_many_levels))
+        {
+          success = FALSE;
+          break;
+        }
+
+      gegl_buffer_get (morphology->input,
+                       GEGL_RECTANGLE (area->x, area->y + y,
+                                       area->width, 1),
+                       1.0, babl_format ("Y float"), row,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      for (x = 0; x < area->width; x++)
+        {
+          if (x > 0 && row[x] == row[x - 1])
+            continue;
+
+          if (! morphology_add_level (levels, &n_levels,
+                                      morphology->sign * row[x]))
+            {
+              success = FALSE;
+              break;
+            }
+        }
+    }
+
+  g_free (row);
+
+  g_mutex_lock (&morphology->mutex);
+
+  for (x = 0; x < n_levels && success; x++)
+    success = morphology_add_level (morphology->levels, &morphology->n_levels,
+                                    levels[x]);
+
+  if (! success)
+    g_atomic_int_set (&morphology->too_many_levels, TRUE);
+
+  g_mutex_unlock (&morphology->mutex);
+}
+
+static inline void
+morphology_update_last (const guint8 *index,
+                        gint          row,
+                        gint         *last,
+                        gint          width)
+{
+  gint x, k;
+
+  /*  a pixel at level i is at or above the levels 1 to i  */
+  for (x = 0; x < width; x++)
+    for (k = 0; k < index[x]; k++)
+      last[k * width + x] = row;
+}
+
+static void
+morphology_levels_band (gsize       offset,
+                        gsize       size,
+                        Morphology *morphology)
+{
+  const gint   width    = morphology->roi->width;
+  const gint   height   = morphology->roi->height;
+  const gint   radius_x = morphology->radius_x;
+  const gint   radius_y = morphology->radius_y;
+  const gint   n_steps  = morphology->n_levels - 1;
+  const gint   y0       = offset;
+  const gint   y1       = offset + size;
+  gfloat      *buf;
+  guint8     **ring;    /* level indices of rows y to y + radius_y */
+  gint        *last;    /* last row at or above the level, per step */
+  gint        *next;    /* scan position for the next such row      */
+  gint        *span;
+  gboolean    *covered;
+  gfloat      *out;
+  gint         x, y, k, r;
+
+  buf     = g_new (gfloat, width);
+  ring    = g_new (guint8 *, radius_y + 1);
+  last    = g_new (gint, MAX (n_steps, 1) * width);
+  next    = g_new (gint, MAX (n_steps, 1) * width);
+  span    = g_new (gint, width);
+  covered = g_new (gboolean, width);
+  out     = g_new (gfloat, width);
+
+  for (r = 0; r < radius_y + 1; r++)
+    ring[r] = g_new (guint8, width);
+
+  for (k = 0; k < n_steps; k++)
+    {
+      /*  the row above roi is set if 0.0 is at or above the level  */
+      gint none = (morphology->outside_level > k) ? -1 : -(radius_y + 2);
+
+      for (x = 0; x < width; x++)
+        {
+          last[k * width + x] = none;
+          next[k * width + x] = y0;
+        }
+    }
+
+  for (r = MAX (y0 - radius_y, 0); r < y0; r++)
+    {
+      morphology_read_levels (morphology, r, buf, ring[0]);
+      morphology_update_last (ring[0], r, last, width);
+    }
+
+  for (r = y0; r <= MIN (y0 + radius_y, height - 1); r++)
+    morphology_read_levels (morphology, r, buf, ring[r % (radius_y + 1)]);
+
+  for (y = y0; y < y1; y++)
+    {
+      const gint lim = MIN (y + radius_y, height - 1);
+
+      morphology_update_last (ring[y % (radius_y + 1)], y, last, width);
+
+      for (x = 0; x < width; x++)
+        out[x] = morphology->levels[0];
+
+      for (k = 0; k < n_steps; k++)
+        {
+          const gint      level   = k + 1;
+          const gboolean  outside = (morphology->outside_level > k);
+          gint           *l       = last + k * width;
+          gint           *n       = next + k * width;
+          gint            s;
+
+          for (x = 0; x < width; x++)
+            {
+              gint d = y - l[x];
+
+              if (d > 0)
+                {
+                  gint p = MAX (n[x], y);
+
+                  while (p <= lim && ring[p % (radius_y + 1)][x] < level)
+                    p++;
+
+                  n[x] = p;
+
+                  if (p <= lim)
+                    d = MIN (d, p - y);
+                  else if (outside && p >= height)
+                    d = MIN (d, height - y);
+                }
+
+              span[x] = (d <= radius_y) ? morphology->reach[d] : -1;
+            }
+
+          /*  the columns left and right of roi are set entirely if
+           *  0.0 is at or above the level
+           */
+          s = outside ? radius_x - 1 : -1;
+
+          for (x = 0; x < width; x++)
+            {
+              s = MAX (s, x + span[x]);
+
+              covered[x] = (s >= x);
+            }
+
+          s = outside ? width - radius_x : width;
+
+          for (x = width - 1; x >= 0; x--)
+            {
+              s = MIN (s, x - span[x]);
+
+              if (covered[x] || s <= x)
+                out[x] = morphology->levels[level];
+            }
+        }
+
+      morphology_write_row (morphology, y, out);
+
+      if (y + radius_y + 1 < height)
+        morphology_read_levels (morphology, y + radius_y + 1, buf,
+                                ring[y % (radius_y + 1)]);
+    }
+
+  for (r = 0; r < radius_y + 1; r++)
+    g_free (ring[r]);
+
+  g_free (out);
+  g_free (covered);
+  g_free (span);
+  g_free (next);
+  g_free (last);
+  g_free (ring);
+  g_free (buf);
+}
+
+static inline void
+rotate_pointers (gfloat  **p,
+                 guint32   n)
+{
+  guint32  i;
+  gfloat  *tmp;
+
+  tmp = p[0];
+
+  for (i = 0; i < n - 1; i++)
+    p[i] = p[i + 1];
+
+  p[i] = tmp;
+}
+
+static void
+morphology_sliding_band (gsize       offset,
+                         gsize       size,
+                         Morphology *morphology)
+{
+  /* Any bugs in this fuction are probably also in thin_region.
+   * Blame all bugs in this function on jaycox@gimp.org
+   */
+  const gint    width    = morphology->roi->width;
+  const gint    radius_x = morphology->radius_x;
+  const gint    radius_y = morphology->radius_y;
+  const gint16 *circ     = morphology->circ;
+  const gint    y0       = offset;
+  const gint    y1       = offset + size;
+  /*  pixels outside are ignored with edge lock, and 0.0 otherwise  */
+  const gfloat  pad      = morphology->edge_lock ? -G_MAXFLOAT : 0.0;
+  /*  the largest value a mask can have, after negation  */
+  const gfloat  sat      = morphology->sign > 0.0 ? 1.0 : 0.0;
+  gfloat      **buf;  /* caches the region's pixel data */
+  gfloat       *out;  /* holds the new scan line we are computing */
+  gfloat      **max;  /* caches the largest values for each column */
+  gfloat       *buffer;
+  gfloat        last_max = 0.0;
+  gint          last_index;
+  gint          i, x, y;
+
+  buf = g_new (gfloat *, radius_y + 1);
+
+  for (i = 0; i < radius_y + 1; i++)
+    buf[i] = g_new (gfloat, width);
+
+  /*  one more column, which all columns outside roi share  */
+  buffer = g_new (gfloat, (width + 1) * (radius_y + 1));
+
+  for (i = 0; i < (width + 1) * (radius_y + 1); i++)
+    buffer[i] = pad;
+
+  max = g_new (gfloat *, width + 2 * radius_x);
+
+  for (i = 0; i < width + 2 * radius_x; i++)
+    {
+      if (i < radius_x || i >= width + radius_x)
+        max[i] = &buffer[(radius_y + 1) * width];
+      else
+        max[i] = &buffer[(radius_y + 1) * (i - radius_x)];
+    }
+
+  /* offset the max pointer by radius_x so the range of the
+   * array is [-radius_x] to [width + radius_x]
+   */
+  max += radius_x;
+
+  out = g_new (gfloat, width);
+
+  /*  max[x][i] is valid once i rows went through it, so start
+   *  radius_y rows above the band
+   */
+  for (i = 0; i < radius_y; i++)
+    morphology_read_row (morphology, y0 - radius_y + i, buf[i + 1], pad);
+
+  for (y = y0 - radius_y; y < y1; y++)
+    {
+      rotate_pointers (buf, radius_y + 1);
+
+      morphology_read_row (morphology, y + radius_y, buf[radius_y], pad);
+
+      for (x = 0; x < width; x++) /* update max array */
+        {
+          for (i = radius_y; i > 0; i--)
+            max[x][i] = MAX (MAX (max[x][i - 1], buf[i - 1][x]), buf[i][x]);
+
+          max[x][0] = buf[0][x];
+        }
+
+      if (y < y0)
+        continue;
+
+      last_index = 0;
+
+      for (x = 0; x < width; x++) /* render scan line */
+        {
+          last_index--;
+
+          if (last_index >= 0)
+            {
+              if (last_max >= sat)
+                {
+                  out[x] = sat;
+                }
+              else
+                {
+                  last_max = sat - 1.0;
+
+                  for (i = radius_x; i >= 0; i--)
+                    if (last_max < max[x + i][circ[i]])
+                      {
+                        last_max = max[x + i][circ[i]];
+                        last_index = i;
+                      }
+
+                  out[x] = last_max;
+                }
+            }
+          else
+            {
+              last_index = radius_x;
+              last_max = max[x + radius_x][circ[radius_x]];
+
+              for (i = radius_x - 1; i >= -radius_x; i--)
+                if (last_max < max[x + i][circ[i]])
+                  {
+                    last_max = max[x + i][circ[i]];
+                    last_index = i;
+                  }
+
+              out[x] = last_max;
+            }
+        }
+
+      morphology_write_row (morphology, y, out);
+    }
+
+  /* undo the offsets to the pointers so we can free the malloced memmory */
+  max -= radius_x;
+
+  g_free (buffer);
+  g_free (max);
+
+  for (i = 0; i < radius_y + 1; i++)
+    g_free (buf[i]);
+
+  g_free (buf);
+  g_free (out);
+}
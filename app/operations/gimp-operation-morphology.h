@@ -0,0 +1,45 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimp-operation-morphology.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_OPERATION_MORPHOLOGY_H__
+#define __GIMP_OPERATION_MORPHOLOGY_H__
+
+
+/*  the vertical half-extent of the elliptic structuring element used
+ *  by grow and shrink, for every column offset in [-radius_x, radius_x]
+ */
+void       gimp_operation_morphology_compute_border (gint16              *circ,
+                                                     gint                 radius_x,
+                                                     gint                 radius_y);
+
+/*  replaces every pixel of roi by the maximum (or, with erode, the
+ *  minimum) of the pixels within the ellipse of radius_x * radius_y
+ *  around it.  With edge_lock, pixels outside roi are ignored,
+ *  otherwise they count as 0.0.
+ */
+gboolean   gimp_operation_morphology_process        (GeglBuffer          *input,
+                                                     GeglBuffer          *output,
+                                                     const GeglRectangle *roi,
+                                                     gint                 radius_x,
+                                                     gint                 radius_y,
+                                                     gboolean             erode,
+                                                     gboolean             edge_lock);
+
+
+#endif /* __GIMP_OPERATION_MORPHOLOGY_H__ */
@@ -0,0 +1,227 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpcolorchainconfig.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <cairo.h>
+#include <gegl.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include "libgimpconfig/gimpconfig.h"
+
+#include "operations-types.h"
+
+#include "gimpcolorchainconfig.h"
+
+#include "gimp-intl.h"
+
+
+typedef struct
+{
+  const gchar *operation;
+  gboolean     separable;
+} GimpColorChainOperation;
+
+
+/*  the operations which can be compiled into a chain, together with
+ *  whether each output channel only depends on the same input channel
+ */
+static const GimpColorChainOperation chain_operations[] =
+{
+  { "gimp:brightness-contrast", TRUE  },
+  { "gimp:color-balance",       FALSE },
+  { "gimp:colorize",            FALSE },
+  { "gimp:curves",              TRUE  },
+  { "gimp:hue-saturation",      FALSE },
+  { "gimp:levels",              TRUE  }
+};
+
+
+static void   gimp_color_chain_config_finalize (GObject *object);
+
+static const GimpColorChainOperation *
+              gimp_color_chain_config_lookup   (const gchar *operation);
+
+
+G_DEFINE_TYPE (GimpColorChainConfig, gimp_color_chain_config,
+               GIMP_TYPE_SETTINGS)
+
+#define parent_class gimp_color_chain_config_parent_class
+
+
+static void
+gimp_color_chain_config_class_init (GimpColorChainConfigClass *klass)
+{
+  GObjectClass      *object_class   = G_OBJECT_CLASS (klass);
+  GimpViewableClass *viewable_class = GIMP_VIEWABLE_CLASS (klass);
+
+  object_class->finalize            = gimp_color_chain_config_finalize;
+
+  viewable_class->default_icon_name = "gimp-tool-curves";
+}
+
+static void
+gimp_color_chain_config_init (GimpColorChainConfig *self)
+{
+  self->operations = g_ptr_array_new_with_free_func (g_free);
+  self->configs    = g_ptr_array_new_with_free_func (g_object_unref);
+}
+
+static void
+gimp_color_chain_config_finalize (GObject *object)
+{
+  GimpColorChainConfig *self = GIMP_COLOR_CHAIN_CONFIG (object);
+
+  g_ptr_array_free (self->operations, TRUE);
+  g_ptr_array_free (self->configs,    TRUE);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+
+/*  public functions  */
+
+GObject *
+gimp_color_chain_config_new (void)
+{
+  return g_object_new (GIMP_TYPE_COLOR_CHAIN_CONFIG, NULL);
+}
+
+gboolean
+gimp_color_chain_config_is_supported (const gchar *operation)
+{
+  g_return_val_if_fail (operation != NULL, FALSE);
+
+  return gimp_color_chain_config_lookup (operation) != NULL;
+}
+
+/**
+ * gimp_color_chain_config_add:
+ * @config:    a #GimpColorChainConfig
+ * @operation: the name of a color operation, like "gimp:curves"
+ * @op_config: the config object of @operation
+ *
+ * Appends a step to the chain. @op_config is duplicated, so later
+ * changes to it do not affect the chain.
+ *
+ * Return value: %FALSE if @operation can't be part of a chain.
+ **/
+gboolean
+gimp_color_chain_config_add (GimpColorChainConfig *config,
+                             const gchar          *operation,
+                             GObject              *op_config)
+{
+  g_return_val_if_fail (GIMP_IS_COLOR_CHAIN_CONFIG (config), FALSE);
+  g_return_val_if_fail (operation != NULL, FALSE);
+  g_return_val_if_fail (GIMP_IS_CONFIG (op_config), FALSE);
+
+  if (! gimp_color_chain_config_lookup (operation))
+    return FALSE;
+
+  g_ptr_array_add (config->operations, g_strdup (operation));
+  g_ptr_array_add (config->configs,
+                   gimp_config_duplicate (GIMP_CONFIG (op_config)));
+
+  config->serial++;
+
+  return TRUE;
+}
+
+void
+gimp_color_chain_config_clear (GimpColorChainConfig *config)
+{
+  g_return_if_fail (GIMP_IS_COLOR_CHAIN_CONFIG (config));
+
+  g_ptr_array_set_size (config->operations, 0);
+  g_ptr_array_set_size (config->configs,    0);
+
+  config->serial++;
+}
+
+gint
+gimp_color_chain_config_get_n_steps (GimpColorChainConfig *config)
+{
+  g_return_val_if_fail (GIMP_IS_COLOR_CHAIN_CONFIG (config), 0);
+
+  return config->operations->len;
+}
+
+void
+gimp_color_chain_config_get_step (GimpColorChainConfig  *config,
+                                  gint                   index,
+                                  const gchar          **operation,
+                                  GObject              **op_config)
+{
+  g_return_if_fail (GIMP_IS_COLOR_CHAIN_CONFIG (config));
+  g_return_if_fail (index >= 0 && index < config->operations->len);
+
+  if (operation)
+    *operation = g_ptr_array_index (config->operations, index);
+
+  if (op_config)
+    *op_config = g_ptr_array_index (config->configs, index);
+}
+
+/**
+ * gimp_color_chain_config_is_separable:
+ * @config: a #GimpColorChainConfig
+ *
+ * Return value: %TRUE if every step maps each channel independently,
+ *               so the whole chain can be described by one curve per
+ *               channel.
+ **/
+gboolean
+gimp_color_chain_config_is_separable (GimpColorChainConfig *config)
+{
+  gint i;
+
+  g_return_val_if_fail (GIMP_IS_COLOR_CHAIN_CONFIG (config), FALSE);
+
+  for (i = 0; i < config->operations->len; i++)
+    {
+      const GimpColorChainOperation *op;
+
+      op = gimp_color_chain_config_lookup (g_ptr_array_index (config->operations,
+                                                              i));
+
+      if (! op->separable)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+
+/*  private functions  */
+
+static const GimpColorChainOperation *
+gimp_color_chain_config_lookup (const gchar *operation)
+{
+  gint i;
+
+  for (i = 0; i < G_N_ELEMENTS (chain_operations); i++)
+    {
+      if (! strcmp (chain_operations[i].operation, operation))
+        return &chain_operations[i];
+    }
+
+  return NULL;
+}
@@ -0,0 +1,71 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpcolorchainconfig.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_COLOR_CHAIN_CONFIG_H__
+#define __GIMP_COLOR_CHAIN_CONFIG_H__
+
+
+#include "core/gimpsettings.h"
+
+
+#define GIMP_TYPE_COLOR_CHAIN_CONFIG            (gimp_color_chain_config_get_type ())
+#define GIMP_COLOR_CHAIN_CONFIG(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GIMP_TYPE_COLOR_CHAIN_CONFIG, GimpColorChainConfig))
+#define GIMP_COLOR_CHAIN_CONFIG_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  GIMP_TYPE_COLOR_CHAIN_CONFIG, GimpColorChainConfigClass))
+#define GIMP_IS_COLOR_CHAIN_CONFIG(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GIMP_TYPE_COLOR_CHAIN_CONFIG))
+#define GIMP_IS_COLOR_CHAIN_CONFIG_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  GIMP_TYPE_COLOR_CHAIN_CONFIG))
+#define GIMP_COLOR_CHAIN_CONFIG_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  GIMP_TYPE_COLOR_CHAIN_CONFIG, GimpColorChainConfigClass))
+
+
+typedef struct _GimpColorChainConfigClass GimpColorChainConfigClass;
+
+struct _GimpColorChainConfig
+{
+  GimpSettings  parent_instance;
+
+  GPtrArray    *operations;  /* operation names               */
+  GPtrArray    *configs;     /* private copies of the configs */
+  guint         serial;      /* bumped whenever the chain changes */
+};
+
+struct _GimpColorChainConfigClass
+{
+  GimpSettingsClass  parent_class;
+};
+
+
+GType      gimp_color_chain_config_get_type        (void) G_GNUC_CONST;
+
+GObject  * gimp_color_chain_config_new             (void);
+
+gboolean   gimp_color_chain_config_is_supported    (const gchar          *operation);
+
+gboolean   gimp_color_chain_config_add             (GimpColorChainConfig *config,
+                                                    const gchar          *operation,
+                                                    GObject              *op_config);
+void       gimp_color_chain_config_clear           (GimpColorChainConfig *config);
+
+gint       gimp_color_chain_config_get_n_steps     (GimpColorChainConfig *config);
+void       gimp_color_chain_config_get_step        (GimpColorChainConfig *config,
+                                                    gint                  index,
+                                                    const gchar         **operation,
+                                                    GObject             **op_config);
+gboolean   gimp_color_chain_config_is_separable    (GimpColorChainConfig *config);
+
+
+#endif /* __GIMP_COLOR_CHAIN_CONFIG_H__ */
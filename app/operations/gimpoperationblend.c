@@ -33,12 +33,18 @@
 
 #include "core/gimpgradient.h"
 
+#include "gegl/gimp-gegl-parallel.h"
+
 #include "gimpoperationblend.h"
 
 #include "gimp-intl.h"
 
 
-//#define USE_GRADIENT_CACHE 1
+/*  the gradient is sampled at least twice per pixel along it  */
+#define GRADIENT_CACHE_MIN_SIZE 4096
+#define GRADIENT_CACHE_MAX_SIZE (1 << 18)
+
+#define BLEND_MIN_SUB_AREA      (128 * 128)
 
 enum
 {
@@ -61,19 +67,14 @@ enum
 
 typedef struct
 {
-  GimpGradient     *gradient;
-  gboolean          reverse;
-#ifdef USE_GRADIENT_CACHE
-  GimpRGB          *gradient_cache;
+  const gfloat     *gradient_cache;
   gint              gradient_cache_size;
-#endif
   gdouble           offset;
   gdouble           sx, sy;
   GimpGradientType  gradient_type;
   gdouble           dist;
   gdouble           vec[2];
   GimpRepeatMode    repeat;
-  GRand            *seed;
   GeglBuffer       *dist_buffer;
 } RenderBlendData;
 
@@ -88,9 +89,18 @@ typedef struct
 } PutPixelData;
 
 
+typedef struct
+{
+  GimpOperationBlend *blend;
+  RenderBlendData    *rbd;
+  GeglBuffer         *output;
+} BlendArea;
+
+
 /*  local function prototypes  */
 
 static void     gimp_operation_blend_dispose      (GObject      *gobject);
+static void     gimp_operation_blend_finalize     (GObject      *gobject);
 static void     gimp_operation_blend_get_property (GObject      *object,
                                                    guint         property_id,
                                                    GValue       *value,
@@ -139,31 +149,43 @@ static gdouble  gradient_calc_spiral_factor       (gdouble   dist,
                                                    gdouble   y,
                                                    gboolean  clockwise);
 
-static gdouble  gradient_calc_shapeburst_angular_factor   (GeglBuffer *dist_buffer,
-                                                           gdouble     x,
-                                                           gdouble     y);
-static gdouble  gradient_calc_shapeburst_spherical_factor (GeglBuffer *dist_buffer,
-                                                           gdouble     x,
-                                                           gdouble     y);
-static gdouble  gradient_calc_shapeburst_dimpled_factor   (GeglBuffer *dist_buffer,
-                                                           gdouble     x,
-                                                           gdouble     y);
-
-static void     gradient_render_pixel        (gdouble             x,
-                                              gdouble             y,
-                                              GimpRGB            *color,
-                                              gpointer            render_data);
-
-static void     gradient_put_pixel           (gint                x,
-                                              gint                y,
-                                              GimpRGB            *color,
-                                              gpointer            put_pixel_data);
-
-static gboolean gimp_operation_blend_process (GeglOperation       *operation,
-                                              GeglBuffer          *input,
-                                              GeglBuffer          *output,
-                                              const GeglRectangle *result,
-                                              gint                 level);
+static gdouble  gradient_calc_shapeburst_angular_factor   (gdouble    value);
+static gdouble  gradient_calc_shapeburst_spherical_factor (gdouble    value);
+static gdouble  gradient_calc_shapeburst_dimpled_factor   (gdouble    value);
+
+static void     gradient_calc_factors        (RenderBlendData     *rbd,
+                                              gdouble              x,
+                                              gdouble              y,
+                                              gint                 n,
+                                              gfloat              *dist_row,
+                                              gdouble             *factors);
+static void     gradient_repeat_factors      (GimpRepeatMode       repeat,
+                                              gint                 n,
+                                              gdouble             *factors);
+static void     gradient_lookup_color        (RenderBlendData     *rbd,
+                                              gdouble              factor,
+                                              gfloat              *dest);
+static void     gradient_dither_pixel        (GRand               *dither_rand,
+                                              gfloat              *dest);
+
+static void     gradient_render_pixel        (gdouble              x,
+                                              gdouble              y,
+                                              GimpRGB             *color,
+                                              gpointer             render_data);
+
+static void     gradient_put_pixel           (gint                 x,
+                                              gint                 y,
+                                              GimpRGB             *color,
+                                              gpointer             put_pixel_data);
+
+static void     gimp_operation_blend_update_cache  (GimpOperationBlend  *self);
+static void     gimp_operation_blend_process_area  (const GeglRectangle *area,
+                                                    BlendArea           *blend_area);
+static gboolean gimp_operation_blend_process       (GeglOperation       *operation,
+                                                    GeglBuffer          *input,
+                                                    GeglBuffer          *output,
+                                                    const GeglRectangle *result,
+                                                    gint                 level);
 
 
 G_DEFINE_TYPE (GimpOperationBlend, gimp_operation_blend,
@@ -180,6 +202,7 @@ gimp_operation_blend_class_init (GimpOperationBlendClass *klass)
   GeglOperationFilterClass *filter_class    = GEGL_OPERATION_FILTER_CLASS (klass);
 
   object_class->dispose             = gimp_operation_blend_dispose;
+  object_class->finalize            = gimp_operation_blend_finalize;
   object_class->set_property        = gimp_operation_blend_set_property;
   object_class->get_property        = gimp_operation_blend_get_property;
 
@@ -188,6 +211,9 @@ gimp_operation_blend_class_init (GimpOperationBlendClass *klass)
 
   filter_class->process             = gimp_operation_blend_process;
 
+  /*  the operation distributes its areas among threads itself  */
+  operation_class->threaded         = FALSE;
+
   gegl_operation_class_set_keys (operation_class,
                                  "name",        "gimp:blend",
                                  "categories",  "gimp",
@@ -326,6 +352,16 @@ gimp_operation_blend_dispose (GObject *object)
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
 
+static void
+gimp_operation_blend_finalize (GObject *object)
+{
+  GimpOperationBlend *self = GIMP_OPERATION_BLEND (object);
+
+  g_clear_pointer (&self->gradient_cache, g_free);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gimp_operation_blend_get_property (GObject    *object,
                                    guint       property_id,
@@ -406,6 +442,11 @@ gimp_operation_blend_set_property (GObject      *object,
 {
   GimpOperationBlend *self = GIMP_OPERATION_BLEND (object);
 
+  /*  the cached gradient depends on most of the properties, and
+   *  setting the gradient again is how a change of it is signaled
+   */
+  g_clear_pointer (&self->gradient_cache, g_free);
+
   switch (property_id)
     {
     case PROP_CONTEXT:
@@ -749,185 +790,240 @@ gradient_calc_spiral_factor (gdouble   dist,
 }
 
 static gdouble
-gradient_calc_shapeburst_angular_factor (GeglBuffer *dist_buffer,
-                                         gdouble     x,
-                                         gdouble     y)
+gradient_calc_shapeburst_angular_factor (gdouble value)
 {
-  gfloat value;
-
-  gegl_buffer_get (dist_buffer, GEGL_RECTANGLE (x, y, 1, 1), 1.0,
-                   NULL, &value,
-                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
-
-  value = 1.0 - value;
-
-  return value;
+  return 1.0 - value;
 }
 
-
 static gdouble
-gradient_calc_shapeburst_spherical_factor (GeglBuffer *dist_buffer,
-                                           gdouble     x,
-                                           gdouble     y)
+gradient_calc_shapeburst_spherical_factor (gdouble value)
 {
-  gfloat value;
-
-  gegl_buffer_get (dist_buffer, GEGL_RECTANGLE (x, y, 1, 1), 1.0,
-                   NULL, &value,
-                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
-
-  value = 1.0 - sin (0.5 * G_PI * value);
-
-  return value;
+  return 1.0 - sin (0.5 * G_PI * value);
 }
 
-
 static gdouble
-gradient_calc_shapeburst_dimpled_factor (GeglBuffer *dist_buffer,
-                                         gdouble     x,
-                                         gdouble     y)
+gradient_calc_shapeburst_dimpled_factor (gdouble value)
 {
-  gfloat value;
-
-  gegl_buffer_get (dist_buffer, GEGL_RECTANGLE (x, y, 1, 1), 1.0,
-                   NULL, &value,
-                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
-
-  value = cos (0.5 * G_PI * value);
-
-  return value;
+  return cos (0.5 * G_PI * value);
 }
 
+/*  calculates the blending factors of the n samples at (x, y),
+ *  (x + 1, y), ..., the loops are kept per gradient type so the
+ *  compiler can vectorize them
+ */
 static void
-gradient_render_pixel (gdouble   x,
-                       gdouble   y,
-                       GimpRGB  *color,
-                       gpointer  render_data)
+gradient_calc_factors (RenderBlendData *rbd,
+                       gdouble          x,
+                       gdouble          y,
+                       gint             n,
+                       gfloat          *dist_row,
+                       gdouble         *factors)
 {
-  RenderBlendData *rbd = render_data;
-  gdouble          factor;
+  const gdouble dx = x - rbd->sx;
+  const gdouble dy = y - rbd->sy;
+  gint          i;
 
-  /*  we want to calculate the color at the pixel's center  */
-  x += 0.5;
-  y += 0.5;
+  switch (rbd->gradient_type)
+    {
+    case GIMP_GRADIENT_SHAPEBURST_ANGULAR:
+    case GIMP_GRADIENT_SHAPEBURST_SPHERICAL:
+    case GIMP_GRADIENT_SHAPEBURST_DIMPLED:
+      gegl_buffer_get (rbd->dist_buffer, GEGL_RECTANGLE (x, y, n, 1), 1.0,
+                       babl_format ("Y float"), dist_row,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+      break;
+
+    default:
+      if (rbd->dist == 0.0)
+        {
+          for (i = 0; i < n; i++)
+            factors[i] = 0.0;
 
-  /* Calculate blending factor */
+          return;
+        }
+      break;
+    }
 
   switch (rbd->gradient_type)
     {
     case GIMP_GRADIENT_LINEAR:
-      factor = gradient_calc_linear_factor (rbd->dist,
-                                            rbd->vec, rbd->offset,
-                                            x - rbd->sx, y - rbd->sy);
+      for (i = 0; i < n; i++)
+        factors[i] = gradient_calc_linear_factor (rbd->dist,
+                                                  rbd->vec, rbd->offset,
+                                                  dx + i, dy);
       break;
 
     case GIMP_GRADIENT_BILINEAR:
-      factor = gradient_calc_bilinear_factor (rbd->dist,
-                                              rbd->vec, rbd->offset,
-                                              x - rbd->sx, y - rbd->sy);
+      for (i = 0; i < n; i++)
+        factors[i] = gradient_calc_bilinear_factor (rbd->dist,
+                                                    rbd->vec, rbd->offset,
+                                                    dx + i, dy);
       break;
 
     case GIMP_GRADIENT_RADIAL:
-      factor = gradient_calc_radial_factor (rbd->dist,
-                                            rbd->offset,
-                                            x - rbd->sx, y - rbd->sy);
+      for (i = 0; i < n; i++)
+        factors[i] = gradient_calc_radial_factor (rbd->dist,
+                                                  rbd->offset,
+                                                  dx + i, dy);
       break;
 
     case GIMP_GRADIENT_SQUARE:
-      factor = gradient_calc_square_factor (rbd->dist, rbd->offset,
-                                            x - rbd->sx, y - rbd->sy);
+      for (i = 0; i < n; i++)
+        factors[i] = gradient_calc_square_factor (rbd->dist,
+                                                  rbd->offset,
+                                                  dx + i, dy);
       break;
 
     case GIMP_GRADIENT_CONICAL_SYMMETRIC:
-      factor = gradient_calc_conical_sym_factor (rbd->dist,
-                                                 rbd->vec, rbd->offset,
-                                                 x - rbd->sx, y - rbd->sy);
+      for (i = 0; i < n; i++)
+        factors[i] = gradient_calc_conical_sym_factor (rbd->dist,
+                                                       rbd->vec, rbd->offset,
+                                                       dx + i, dy);
       break;
 
     case GIMP_GRADIENT_CONICAL_ASYMMETRIC:
-      factor = gradient_calc_conical_asym_factor (rbd->dist,
-                                                  rbd->vec, rbd->offset,
-                                                  x - rbd->sx, y - rbd->sy);
+      for (i = 0; i < n; i++)
+        factors[i] = gradient_calc_conical_asym_factor (rbd->dist,
+                                                        rbd->vec, rbd->offset,
+                                                        dx + i, dy);
       break;
 
     case GIMP_GRADIENT_SHAPEBURST_ANGULAR:
-      factor = gradient_calc_shapeburst_angular_factor (rbd->dist_buffer, x, y);
+      for (i = 0; i < n; i++)
+        factors[i] = gradient_calc_shapeburst_angular_factor (dist_row[i]);
       break;
 
     case GIMP_GRADIENT_SHAPEBURST_SPHERICAL:
-      factor = gradient_calc_shapeburst_spherical_factor (rbd->dist_buffer, x, y);
+      for (i = 0; i < n; i++)
+        factors[i] = gradient_calc_shapeburst_spherical_factor (dist_row[i]);
       break;
 
     case GIMP_GRADIENT_SHAPEBURST_DIMPLED:
-      factor = gradient_calc_shapeburst_dimpled_factor (rbd->dist_buffer, x, y);
+      for (i = 0; i < n; i++)
+        factors[i] = gradient_calc_shapeburst_dimpled_factor (dist_row[i]);
       break;
 
     case GIMP_GRADIENT_SPIRAL_CLOCKWISE:
-      factor = gradient_calc_spiral_factor (rbd->dist,
-                                            rbd->vec, rbd->offset,
-                                            x - rbd->sx, y - rbd->sy, TRUE);
+      for (i = 0; i < n; i++)
+        factors[i] = gradient_calc_spiral_factor (rbd->dist,
+                                                  rbd->vec, rbd->offset,
+                                                  dx + i, dy, TRUE);
       break;
 
     case GIMP_GRADIENT_SPIRAL_ANTICLOCKWISE:
-      factor = gradient_calc_spiral_factor (rbd->dist,
-                                            rbd->vec, rbd->offset,
-                                            x - rbd->sx, y - rbd->sy, FALSE);
+      for (i = 0; i < n; i++)
+        factors[i] = gradient_calc_spiral_factor (rbd->dist,
+                                                  rbd->vec, rbd->offset,
+                                                  dx + i, dy, FALSE);
       break;
 
     default:
       g_return_if_reached ();
       break;
     }
+}
 
-  /* Adjust for repeat */
+static void
+gradient_repeat_factors (GimpRepeatMode  repeat,
+                         gint            n,
+                         gdouble        *factors)
+{
+  gint i;
 
-  switch (rbd->repeat)
+  switch (repeat)
     {
     case GIMP_REPEAT_TRUNCATE:
       break;
 
     case GIMP_REPEAT_NONE:
-      factor = CLAMP (factor, 0.0, 1.0);
+      for (i = 0; i < n; i++)
+        factors[i] = CLAMP (factors[i], 0.0, 1.0);
       break;
 
     case GIMP_REPEAT_SAWTOOTH:
-      factor = factor - floor (factor);
+      for (i = 0; i < n; i++)
+        factors[i] = factors[i] - floor (factors[i]);
       break;
 
     case GIMP_REPEAT_TRIANGULAR:
-      {
-        guint ifactor;
+      for (i = 0; i < n; i++)
+        {
+          gdouble factor = fabs (factors[i]);
+          guint   ifactor;
 
-        if (factor < 0.0)
-          factor = -factor;
+          ifactor = (guint) factor;
+          factor  = factor - floor (factor);
 
-        ifactor = (guint) factor;
-        factor = factor - floor (factor);
+          if (ifactor & 1)
+            factor = 1.0 - factor;
 
-        if (ifactor & 1)
-          factor = 1.0 - factor;
-      }
+          factors[i] = factor;
+        }
       break;
     }
+}
 
-  /* Blend the colors */
-
-  if (factor < 0.0 || factor > 1.0)
+static void
+gradient_lookup_color (RenderBlendData *rbd,
+                       gdouble          factor,
+                       gfloat          *dest)
+{
+  if (factor >= 0.0 && factor <= 1.0)
     {
-      color->r = color->g = color->b = 0;
-      color->a = GIMP_OPACITY_TRANSPARENT;
+      const gint     last  = rbd->gradient_cache_size - 1;
+      const gdouble  pos   = factor * last;
+      const gint     index = MIN ((gint) pos, last - 1);
+      const gfloat   t     = pos - index;
+      const gfloat  *color = rbd->gradient_cache + 4 * index;
+
+      /*  interpolate between the two closest samples  */
+      dest[0] = color[0] + t * (color[4] - color[0]);
+      dest[1] = color[1] + t * (color[5] - color[1]);
+      dest[2] = color[2] + t * (color[6] - color[2]);
+      dest[3] = color[3] + t * (color[7] - color[3]);
     }
   else
     {
-#ifdef USE_GRADIENT_CACHE
-      *color = rbd->gradient_cache[(gint) (factor * (rbd->gradient_cache_size - 1))];
-#else
-      gimp_gradient_get_color_at (rbd->gradient, NULL, NULL,
-                                  factor, rbd->reverse, color);
-#endif
+      dest[0] = dest[1] = dest[2] = 0.0;
+      dest[3] = GIMP_OPACITY_TRANSPARENT;
     }
 }
 
+static void
+gradient_dither_pixel (GRand  *dither_rand,
+                       gfloat *dest)
+{
+  gint i = g_rand_int (dither_rand);
+
+  dest[0] = MAX (dest[0] + (gdouble) (i & 0xff) / 256.0 / 256.0, 0.0); i >>= 8;
+  dest[1] = MAX (dest[1] + (gdouble) (i & 0xff) / 256.0 / 256.0, 0.0); i >>= 8;
+  dest[2] = MAX (dest[2] + (gdouble) (i & 0xff) / 256.0 / 256.0, 0.0); i >>= 8;
+
+  if (dest[3] > 0.0 && dest[3] < 1.0)
+    dest[3] += (gdouble) (i & 0xff) / 256.0 / 256.0;
+
+  dest[3] = MAX (dest[3], 0.0);
+}
+
+static void
+gradient_render_pixel (gdouble   x,
+                       gdouble   y,
+                       GimpRGB  *color,
+                       gpointer  render_data)
+{
+  RenderBlendData *rbd = render_data;
+  gfloat           dist_value;
+  gdouble          factor;
+  gfloat           rgba[4];
+
+  /*  we want to calculate the color at the pixel's center  */
+  gradient_calc_factors (rbd, x + 0.5, y + 0.5, 1, &dist_value, &factor);
+  gradient_repeat_factors (rbd->repeat, 1, &factor);
+  gradient_lookup_color (rbd, factor, rgba);
+
+  gimp_rgba_set (color, rgba[0], rgba[1], rgba[2], rgba[3]);
+}
+
 static void
 gradient_put_pixel (gint      x,
                     gint      y,
@@ -938,38 +1034,143 @@ gradient_put_pixel (gint      x,
   const gint    index = x - ppd->roi_x;
   gfloat       *dest  = ppd->row_data + 4 * index;
 
+  dest[0] = color->r;
+  dest[1] = color->g;
+  dest[2] = color->b;
+  dest[3] = color->a;
+
   if (ppd->dither_rand)
+    gradient_dither_pixel (ppd->dither_rand, dest);
+
+  /* Paint whole row if we are on the rightmost pixel */
+  if (index == (ppd->width - 1))
+    gegl_buffer_set (ppd->buffer, GEGL_RECTANGLE (ppd->roi_x, y, ppd->width, 1),
+                     0, babl_format ("R'G'B'A float"), ppd->row_data,
+                     GEGL_AUTO_ROWSTRIDE);
+}
+
+/*  samples the gradient into a table which is linearly interpolated
+ *  while rendering, so gimp_gradient_get_color_at() isn't called for
+ *  every pixel
+ */
+static void
+gimp_operation_blend_update_cache (GimpOperationBlend *self)
+{
+  GimpGradient        *gradient;
+  GimpGradientSegment *seg = NULL;
+  gdouble              dist;
+  gint                 size;
+  gint                 i;
+
+  if (self->gradient)
+    gradient = g_object_ref (self->gradient);
+  else
+    gradient = GIMP_GRADIENT (gimp_gradient_new (NULL, "Blend-Temp"));
+
+  dist = sqrt (SQR (self->end_x - self->start_x) +
+               SQR (self->end_y - self->start_y));
+
+  size = CLAMP (2.0 * ceil (dist),
+                GRADIENT_CACHE_MIN_SIZE, GRADIENT_CACHE_MAX_SIZE);
+
+  g_free (self->gradient_cache);
+
+  self->gradient_cache      = g_new (gfloat, 4 * size);
+  self->gradient_cache_size = size;
+
+  for (i = 0; i < size; i++)
     {
-      gfloat r, g, b, a;
-      gint   i = g_rand_int (ppd->dither_rand);
+      gfloat  *dest = self->gradient_cache + 4 * i;
+      GimpRGB  color;
 
-      r = color->r + (gdouble) (i & 0xff) / 256.0 / 256.0; i >>= 8;
-      g = color->g + (gdouble) (i & 0xff) / 256.0 / 256.0; i >>= 8;
-      b = color->b + (gdouble) (i & 0xff) / 256.0 / 256.0; i >>= 8;
+      seg = gimp_gradient_get_color_at (gradient, NULL, seg,
+                                        (gdouble) i / (gdouble) (size - 1),
+                                        self->gradient_reverse, &color);
 
-      if (color->a > 0.0 && color->a < 1.0)
-        a = color->a + (gdouble) (i & 0xff) / 256.0 / 256.0;
-      else
-        a = color->a;
+      dest[0] = color.r;
+      dest[1] = color.g;
+      dest[2] = color.b;
+      dest[3] = color.a;
+    }
+
+  g_object_unref (gradient);
+}
+
+static void
+gimp_operation_blend_process_area (const GeglRectangle *area,
+                                   BlendArea           *blend_area)
+{
+  GimpOperationBlend *self = blend_area->blend;
+  RenderBlendData    *rbd  = blend_area->rbd;
+  GRand              *dither_rand = NULL;
 
-      *dest++ = MAX (r, 0.0);
-      *dest++ = MAX (g, 0.0);
-      *dest++ = MAX (b, 0.0);
-      *dest++ = MAX (a, 0.0);
+  if (self->dither)
+    dither_rand = g_rand_new ();
+
+  if (self->supersample)
+    {
+      PutPixelData ppd = { 0, };
+
+      ppd.buffer      = blend_area->output;
+      ppd.row_data    = g_new (gfloat, 4 * area->width);
+      ppd.roi_x       = area->x;
+      ppd.width       = area->width;
+      ppd.dither_rand = dither_rand;
+
+      gimp_adaptive_supersample_area (area->x, area->y,
+                                      area->x + area->width  - 1,
+                                      area->y + area->height - 1,
+                                      self->supersample_depth,
+                                      self->supersample_threshold,
+                                      gradient_render_pixel, rbd,
+                                      gradient_put_pixel, &ppd,
+                                      NULL,
+                                      NULL);
+
+      g_free (ppd.row_data);
     }
   else
     {
-      *dest++ = color->r;
-      *dest++ = color->g;
-      *dest++ = color->b;
-      *dest++ = color->a;
+      GeglBufferIterator *iter;
+      GeglRectangle      *roi;
+      gdouble            *factors;
+      gfloat             *dist_row;
+
+      factors  = g_new (gdouble, area->width);
+      dist_row = g_new (gfloat,  area->width);
+
+      iter = gegl_buffer_iterator_new (blend_area->output, area, 0,
+                                       babl_format ("R'G'B'A float"),
+                                       GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+      roi = &iter->roi[0];
+
+      while (gegl_buffer_iterator_next (iter))
+        {
+          gfloat *dest = iter->data[0];
+          gint    x, y;
+
+          for (y = roi->y; y < roi->y + roi->height; y++)
+            {
+              gradient_calc_factors (rbd, roi->x + 0.5, y + 0.5, roi->width,
+                                     dist_row, factors);
+              gradient_repeat_factors (rbd->repeat, roi->width, factors);
+
+              for (x = 0; x < roi->width; x++, dest += 4)
+                {
+                  gradient_lookup_color (rbd, factors[x], dest);
+
+                  if (dither_rand)
+                    gradient_dither_pixel (dither_rand, dest);
+                }
+            }
+        }
+
+      g_free (dist_row);
+      g_free (factors);
     }
 
-  /* Paint whole row if we are on the rightmost pixel */
-  if (index == (ppd->width - 1))
-    gegl_buffer_set (ppd->buffer, GEGL_RECTANGLE (ppd->roi_x, y, ppd->width, 1),
-                     0, babl_format ("R'G'B'A float"), ppd->row_data,
-                     GEGL_AUTO_ROWSTRIDE);
+  if (dither_rand)
+    g_rand_free (dither_rand);
 }
 
 static gboolean
@@ -986,33 +1187,14 @@ gimp_operation_blend_process (GeglOperation       *operation,
   const gdouble ex = self->end_x;
   const gdouble ey = self->end_y;
 
-  RenderBlendData rbd = { 0, };
+  RenderBlendData rbd        = { 0, };
+  BlendArea       blend_area = { 0, };
 
-  rbd.gradient = NULL;
-  rbd.reverse  = self->gradient_reverse;
+  if (! self->gradient_cache)
+    gimp_operation_blend_update_cache (self);
 
-  if (self->gradient)
-    rbd.gradient = g_object_ref (self->gradient);
-  else
-    rbd.gradient = GIMP_GRADIENT (gimp_gradient_new (NULL, "Blend-Temp"));
-
-#ifdef USE_GRADIENT_CACHE
-  {
-    gint i;
-
-    rbd.gradient_cache_size = ceil (sqrt (SQR (sx - ex) + SQR (sy - ey)));
-    rbd.gradient_cache      = g_new0 (GimpRGB, rbd.gradient_cache_size);
-
-    for (i = 0; i < rbd.gradient_cache_size; i++)
-      {
-        gdouble factor = (gdouble) i / (gdouble) (rbd.gradient_cache_size - 1);
-
-        gimp_gradient_get_color_at (rbd.gradient, NULL, NULL,
-                                    factor, rbd.reverse,
-                                    rbd.gradient_cache + i);
-      }
-  }
-#endif
+  rbd.gradient_cache      = self->gradient_cache;
+  rbd.gradient_cache_size = self->gradient_cache_size;
 
   /* Calculate type-specific parameters */
 
@@ -1064,107 +1246,14 @@ gimp_operation_blend_process (GeglOperation       *operation,
 
   /* Render the gradient! */
 
-  if (self->supersample)
-    {
-      PutPixelData  ppd = { 0, };
-
-      ppd.buffer      = output;
-      ppd.row_data    = g_malloc (sizeof (float) * 4 * result->width);
-      ppd.roi_x       = result->x;
-      ppd.width       = result->width;
-      if (self->dither)
-        ppd.dither_rand = g_rand_new ();
-
-      gimp_adaptive_supersample_area (result->x, result->y,
-                                      result->x + result->width  - 1,
-                                      result->y + result->height - 1,
-                                      self->supersample_depth,
-                                      self->supersample_threshold,
-                                      gradient_render_pixel, &rbd,
-                                      gradient_put_pixel, &ppd,
-                                      NULL,
-                                      NULL);
-
-      if (self->dither)
-        g_rand_free (ppd.dither_rand);
-      g_free (ppd.row_data);
-    }
-  else
-    {
-      GeglBufferIterator *iter;
-      GeglRectangle      *roi;
-
-      iter = gegl_buffer_iterator_new (output, result, 0,
-                                       babl_format ("R'G'B'A float"),
-                                       GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
-      roi = &iter->roi[0];
-
-      if (self->dither)
-        rbd.seed = g_rand_new ();
-
-      while (gegl_buffer_iterator_next (iter))
-        {
-          gfloat *dest = iter->data[0];
-          gint    endx = roi->x + roi->width;
-          gint    endy = roi->y + roi->height;
-          gint    x, y;
-
-          if (rbd.seed)
-            {
-              GRand *dither_rand = g_rand_new_with_seed (g_rand_int (rbd.seed));
-
-              for (y = roi->y; y < endy; y++)
-                for (x = roi->x; x < endx; x++)
-                  {
-                    GimpRGB  color = { 0.0, 0.0, 0.0, 1.0 };
-                    gfloat   r, g, b, a;
-                    gint     i = g_rand_int (dither_rand);
-
-                    gradient_render_pixel (x, y, &color, &rbd);
-
-                    r = color.r + (gdouble) (i & 0xff) / 256.0 / 256.0; i >>= 8;
-                    g = color.g + (gdouble) (i & 0xff) / 256.0 / 256.0; i >>= 8;
-                    b = color.b + (gdouble) (i & 0xff) / 256.0 / 256.0; i >>= 8;
-
-                    if (color.a > 0.0 && color.a < 1.0)
-                      a = color.a + (gdouble) (i & 0xff) / 256.0 / 256.0;
-                    else
-                      a = color.a;
-
-                    *dest++ = MAX (r, 0.0);
-                    *dest++ = MAX (g, 0.0);
-                    *dest++ = MAX (b, 0.0);
-                    *dest++ = MAX (a, 0.0);
-                  }
-
-              g_rand_free (dither_rand);
-            }
-          else
-            {
-              for (y = roi->y; y < endy; y++)
-                for (x = roi->x; x < endx; x++)
-                  {
-                    GimpRGB  color = { 0.0, 0.0, 0.0, 1.0 };
-
-                    gradient_render_pixel (x, y, &color, &rbd);
-
-                    *dest++ = color.r;
-                    *dest++ = color.g;
-                    *dest++ = color.b;
-                    *dest++ = color.a;
-                  }
-            }
-        }
-
-      if (self->dither)
-        g_rand_free (rbd.seed);
-    }
-
-#ifdef USE_GRADIENT_CACHE
-  g_free (rbd.gradient_cache);
-#endif
+  blend_area.blend  = self;
+  blend_area.rbd    = &rbd;
+  blend_area.output = output;
 
-  g_object_unref (rbd.gradient);
+  gimp_gegl_parallel_distribute_area (result, BLEND_MIN_SUB_AREA,
+                                      (GimpGeglParallelDistributeAreaFunc)
+                                      gimp_operation_blend_process_area,
+                                      &blend_area);
 
   return TRUE;
 }
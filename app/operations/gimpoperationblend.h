@@ -54,6 +54,9 @@ struct _GimpOperationBlend
   gdouble              supersample_threshold;
 
   gboolean             dither;
+
+  gfloat              *gradient_cache;
+  gint                 gradient_cache_size;
 };
 
 struct _GimpOperationBlendClass
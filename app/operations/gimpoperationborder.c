@@ -29,9 +29,14 @@
 
 #include "operations-types.h"
 
+#include "gegl/gimp-gegl-parallel.h"
+
 #include "gimpoperationborder.h"
 
 
+#define BORDER_MIN_BAND_ROWS 32
+
+
 enum
 {
   PROP_0,
@@ -42,6 +47,27 @@ enum
 };
 
 
+typedef struct
+{
+  GimpOperationBorder *self;
+  GeglBuffer          *input;
+  GeglBuffer          *output;
+  const GeglRectangle *roi;
+  gdouble             *dist_x;
+  gdouble             *dist_y;
+  gint                *reach;
+} Border;
+
+typedef struct
+{
+  Border *border;
+  gfloat *buf[3];
+  gfloat *transition;
+  guint8 *second_last;
+  gint    row;
+} BorderRows;
+
+
 static void     gimp_operation_border_get_property (GObject      *object,
                                                     guint         property_id,
                                                     GValue       *value,
@@ -65,6 +91,16 @@ static gboolean gimp_operation_border_process (GeglOperation       *operation,
                                                const GeglRectangle *roi,
                                                gint                 level);
 
+static void     border_rows_init              (BorderRows          *rows,
+                                               Border              *border,
+                                               gint                 row);
+static void     border_rows_next              (BorderRows          *rows,
+                                               guint8              *dest);
+static void     border_rows_clear             (BorderRows          *rows);
+static void     border_band                   (gsize                offset,
+                                               gsize                size,
+                                               Border              *border);
+
 
 G_DEFINE_TYPE (GimpOperationBorder, gimp_operation_border,
                GEGL_TYPE_OPERATION_FILTER)
@@ -341,28 +377,8 @@ gimp_operation_border_process (GeglOperation       *operation,
   const Babl          *input_format  = babl_format ("Y float");
   const Babl          *output_format = babl_format ("Y float");
 
-  gint32 i, j, x, y;
-
-  /* A cache used in the algorithm as it works its way down. `buf[1]' is the
-     current row. Thus, at algorithm initialization, `buf[0]' represents the
-     row 'above' the first row of the region. */
-  gfloat  *buf[3];
-
-  /* The resulting selection is calculated row by row, and this buffer holds the
-     output for each individual row, on each iteration. */
-  gfloat  *out;
-
-  /* Keeps track of transitional pixels (pixels that are selected and have
-     unselected neighbouring pixels). */
-  gfloat **transition;
-
-  /* TODO: Figure out role clearly in algorithm. */
-  gint16  *max;
-
-  /* TODO: Figure out role clearly in algorithm. */
-  gfloat **density;
-
-  gint16   last_index;
+  Border               border;
+  gint32               i, j, y;
 
   /* optimize this case specifically */
   if (self->radius_x == 1 && self->radius_y == 1)
@@ -455,293 +471,377 @@ gimp_operation_border_process (GeglOperation       *operation,
       return TRUE;
     }
 
-  max = g_new (gint16, roi->width + 2 * self->radius_x);
+  border.self   = self;
+  border.input  = input;
+  border.output = output;
+  border.roi    = roi;
+  border.dist_x = g_new (gdouble, roi->width);
+  border.dist_y = g_new (gdouble, self->radius_y + 1);
+  border.reach  = g_new (gint, self->radius_y + 1);
+
+  /*  the elliptic distance of a pixel i columns and d rows away from a
+   *  transition is dist_x[i] + dist_y[d], the pixel is part of the
+   *  border if that is below 1.0
+   */
+  for (i = 0; i < roi->width; i++)
+    {
+      gdouble tmpx = i > 0 ? i - 0.5 : 0.0;
 
-  for (i = 0; i < (roi->width + 2 * self->radius_x); i++)
-    max[i] = self->radius_y + 2;
+      border.dist_x[i] = (tmpx * tmpx) / (self->radius_x * self->radius_x);
+    }
 
-  max += self->radius_x;
+  for (i = 0; i < self->radius_y + 1; i++)
+    {
+      gdouble tmpy = i > 0 ? i - 0.5 : 0.0;
 
-  for (i = 0; i < 3; i++)
-    buf[i] = g_new (gfloat, roi->width);
+      border.dist_y[i] = (tmpy * tmpy) / (self->radius_y * self->radius_y);
 
-  transition = g_new (gfloat *, self->radius_y + 1);
+      /*  the number of columns a transition d rows away covers to
+       *  each side, or -1 if it doesn't cover any
+       */
+      border.reach[i] = -1;
 
-  for (i = 0; i < self->radius_y + 1; i++)
-    {
-      transition[i] = g_new (gfloat, roi->width + 2 * self->radius_x);
-      memset (transition[i], 0,
-              (roi->width + 2 * self->radius_x) * sizeof (gfloat));
-      transition[i] += self->radius_x;
+      for (j = 0; j <= self->radius_x; j++)
+        {
+          gdouble dist_x = ((j - 0.5) * (j - 0.5) /
+                            (self->radius_x * self->radius_x));
+
+          if (border.dist_y[i] + (j > 0 ? dist_x : 0.0) >= 1.0)
+            break;
+
+          border.reach[i] = j;
+        }
     }
 
-  out = g_new (gfloat, roi->width);
+  gimp_gegl_parallel_distribute_range (roi->height,
+                                       MAX (BORDER_MIN_BAND_ROWS,
+                                            4 * self->radius_y),
+                                       (GimpGeglParallelDistributeRangeFunc)
+                                       border_band,
+                                       &border);
+
+  g_free (border.dist_x);
+  g_free (border.dist_y);
+  g_free (border.reach);
+
+  return TRUE;
+}
+
 
-  density = g_new (gfloat *, 2 * self->radius_x + 1);
-  density += self->radius_x;
+/*  reads row of the input, rows outside of roi are selected with edge
+ *  lock and unselected otherwise
+ */
+static void
+border_read_row (Border *border,
+                 gint    row,
+                 gfloat *dest)
+{
+  const GeglRectangle *roi = border->roi;
 
-  /* allocate density[][] */
-  for (x = 0; x < (self->radius_x + 1); x++)
+  if (row < 0 || row >= roi->height)
     {
-      density[ x]  = g_new (gfloat, 2 * self->radius_y + 1);
-      density[ x] += self->radius_y;
-      density[-x]  = density[x];
-    }
+      gfloat value = border->self->edge_lock ? 1.0 : 0.0;
+      gint   x;
 
-  /* compute density[][] */
-  for (x = 0; x < (self->radius_x + 1); x++)
+      for (x = 0; x < roi->width; x++)
+        dest[x] = value;
+    }
+  else
     {
-      gdouble tmpx, tmpy, dist;
-      gfloat  a;
+      gegl_buffer_get (border->input,
+                       GEGL_RECTANGLE (roi->x, roi->y + row,
+                                       roi->width, 1),
+                       1.0, babl_format ("Y float"), dest,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+    }
+}
 
-      if (x > 0)
-        tmpx = x - 0.5;
-      else if (x < 0)
-        tmpx = x + 0.5;
-      else
-        tmpx = 0.0;
+/*  prepares rows for returning the transitions of row and the rows
+ *  below it, one at a time
+ */
+static void
+border_rows_init (BorderRows *rows,
+                  Border     *border,
+                  gint        row)
+{
+  gint width = border->roi->width;
+  gint i;
 
-      for (y = 0; y < (self->radius_y + 1); y++)
-        {
-          if (y > 0)
-            tmpy = y - 0.5;
-          else if (y < 0)
-            tmpy = y + 0.5;
-          else
-            tmpy = 0.0;
+  rows->border = border;
+  rows->row    = row;
 
-          dist = ((tmpy * tmpy) / (self->radius_y * self->radius_y) +
-                  (tmpx * tmpx) / (self->radius_x * self->radius_x));
+  for (i = 0; i < 3; i++)
+    rows->buf[i] = g_new (gfloat, width);
 
-          if (dist < 1.0)
-            {
-              if (self->feather)
-                a = 1.0 - sqrt (dist);
-              else
-                a = 1.0;
-            }
-          else
-            {
-              a = 0.0;
-            }
+  rows->transition  = g_new (gfloat, width);
+  rows->second_last = g_new0 (guint8, width);
 
-          density[ x][ y] = a;
-          density[ x][-y] = a;
-          density[-x][ y] = a;
-          density[-x][-y] = a;
-        }
-    }
+  border_read_row (border, row - 1, rows->buf[0]);
+  border_read_row (border, row,     rows->buf[1]);
 
-  /* Since the algorithm considerers `buf[0]' to be 'over' the row
-   * currently calculated, we must start with `buf[0]' as non-selected
-   * if there is no `self->edge_lock. If there is an
-   * 'self->edge_lock', initialize the first row to 'selected'. Refer
-   * to bug #350009.
-   */
-  if (self->edge_lock)
+  if (border->roi->height == 1)
+    memcpy (rows->buf[2], rows->buf[1], width * sizeof (gfloat));
+  else
+    border_read_row (border, row + 1, rows->buf[2]);
+}
+
+static void
+border_rows_next (BorderRows *rows,
+                  guint8     *dest)
+{
+  Border              *border = rows->border;
+  GimpOperationBorder *self   = border->self;
+  gint                 width  = border->roi->width;
+  gint                 height = border->roi->height;
+  gint                 x;
+
+  if (self->edge_lock && height > self->radius_y && rows->row >= height - 1)
     {
-      for (i = 0; i < roi->width; i++)
-        buf[0][i] = 1.0;
+      /*  with edge lock, the border always repeated the transitions of
+       *  the second last row for the last row and below the image
+       */
+      memcpy (dest, rows->second_last, width);
+    }
+  else if (rows->row >= height)
+    {
+      memset (dest, 0, width);
     }
   else
     {
-      memset (buf[0], 0, roi->width * sizeof (gfloat));
+      compute_transition (rows->transition, rows->buf, width,
+                          self->edge_lock);
+
+      for (x = 0; x < width; x++)
+        dest[x] = (rows->transition[x] != 0.0);
+
+      if (rows->row == height - 2)
+        memcpy (rows->second_last, dest, width);
+    }
+
+  rows->row++;
+
+  rotate_pointers (rows->buf, 3);
+  border_read_row (border, rows->row + 1, rows->buf[2]);
+}
+
+static void
+border_rows_clear (BorderRows *rows)
+{
+  gint i;
+
+  for (i = 0; i < 3; i++)
+    g_free (rows->buf[i]);
+
+  g_free (rows->transition);
+  g_free (rows->second_last);
+}
+
+/*  the feathered border of a row is, for every pixel, the minimum
+ *  elliptic distance to any of the n candidate transitions, whose
+ *  columns are given in cols and vertical distances in cost.  The
+ *  best candidate column grows monotonically with the pixel's column,
+ *  so divide and conquer finds all minima in O(width * log (n)).
+ */
+static void
+border_feather_span (Border        *border,
+                     const gint    *cols,
+                     const gdouble *cost,
+                     gint           x0,
+                     gint           x1,
+                     gint           c0,
+                     gint           c1,
+                     gfloat        *out)
+{
+  gdouble best_dist = G_MAXDOUBLE;
+  gint    best      = c0;
+  gint    x;
+  gint    c;
+
+  if (x0 > x1)
+    return;
+
+  x = (x0 + x1) / 2;
+
+  for (c = c0; c <= c1; c++)
+    {
+      gdouble dist = cost[c] + border->dist_x[ABS (x - cols[c])];
+
+      if (dist < best_dist)
+        {
+          best_dist = dist;
+          best      = c;
+        }
     }
 
-  gegl_buffer_get (input,
-                   GEGL_RECTANGLE (roi->x, roi->y + 0,
-                                   roi->width, 1),
-                   1.0, input_format, buf[1],
-                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
-
-  if (roi->height > 1)
-    gegl_buffer_get (input,
-                     GEGL_RECTANGLE (roi->x, roi->y + 1,
-                                     roi->width, 1),
-                     1.0, input_format, buf[2],
-                     GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  if (best_dist < 1.0)
+    out[x] = 1.0 - sqrt (best_dist);
   else
-    memcpy (buf[2], buf[1], roi->width * sizeof (gfloat));
+    out[x] = 0.0;
 
-  compute_transition (transition[1], buf, roi->width, self->edge_lock);
+  border_feather_span (border, cols, cost, x0, x - 1, c0, best, out);
+  border_feather_span (border, cols, cost, x + 1, x1, best, c1, out);
+}
 
-   /* set up top of image */
-  for (y = 1; y < self->radius_y && y + 1 < roi->height; y++)
+/*  renders the rows [offset, offset + size) of the border.  For every
+ *  column, only the nearest transition above or below matters, it is
+ *  tracked incrementally while a ring of radius_y + 1 rows of
+ *  transitions moves down the band.
+ */
+static void
+border_band (gsize   offset,
+             gsize   size,
+             Border *border)
+{
+  GimpOperationBorder *self     = border->self;
+  const GeglRectangle *roi      = border->roi;
+  const gint           width    = roi->width;
+  const gint           radius_y = self->radius_y;
+  const gint           n_ring   = radius_y + 1;
+  const gint           y0       = offset;
+  const gint           y1       = offset + size;
+  BorderRows           rows;
+  guint8             **ring;
+  gint                *last;
+  gint                *next;
+  gint                *dist;
+  gint                *cols;
+  gdouble             *cost;
+  gfloat              *out;
+  gint                 x, y;
+  gint                 r;
+
+  ring = g_new (guint8 *, n_ring);
+
+  for (r = 0; r < n_ring; r++)
+    ring[r] = g_new (guint8, width);
+
+  last = g_new (gint, width);
+  next = g_new (gint, width);
+  dist = g_new (gint, width);
+  cols = g_new (gint, width);
+  cost = g_new (gdouble, width);
+  out  = g_new (gfloat, width);
+
+  for (x = 0; x < width; x++)
     {
-      rotate_pointers (buf, 3);
-      gegl_buffer_get (input,
-                       GEGL_RECTANGLE (roi->x, roi->y + y + 1,
-                                       roi->width, 1),
-                       1.0, input_format, buf[2],
-                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
-      compute_transition (transition[y + 1], buf, roi->width, self->edge_lock);
+      last[x] = y0 - radius_y - 1;
+      next[x] = y0;
     }
 
-  /* set up max[] for top of image */
-  for (x = 0; x < roi->width; x++)
+  border_rows_init (&rows, border, MAX (y0 - radius_y, 0));
+
+  /*  of the rows above the band, only the last transition counts  */
+  while (rows.row < y0)
     {
-      max[x] = -(self->radius_y + 7);
+      r = rows.row;
 
-      for (j = 1; j < self->radius_y + 1; j++)
-        if (transition[j][x])
-          {
-            max[x] = j;
-            break;
-          }
+      border_rows_next (&rows, ring[0]);
+
+      for (x = 0; x < width; x++)
+        if (ring[0][x])
+          last[x] = r;
     }
 
-  /* main calculation loop */
-  for (y = 0; y < roi->height; y++)
+  /*  ring[r % n_ring] holds the transitions of rows y to y + radius_y  */
+  while (rows.row <= y0 + radius_y)
     {
-      rotate_pointers (buf, 3);
-      rotate_pointers (transition, self->radius_y + 1);
+      r = rows.row;
 
-      if (y < roi->height - (self->radius_y + 1))
-        {
-          gegl_buffer_get (input,
-                           GEGL_RECTANGLE (roi->x,
-                                           roi->y + y + self->radius_y + 1,
-                                           roi->width, 1),
-                           1.0, input_format, buf[2],
-                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
-          compute_transition (transition[self->radius_y], buf, roi->width, self->edge_lock);
-        }
-      else
+      border_rows_next (&rows, ring[r % n_ring]);
+    }
+
+  for (y = y0; y < y1; y++)
+    {
+      guint8 *current = ring[y % n_ring];
+
+      for (x = 0; x < width; x++)
         {
-          if (self->edge_lock)
-            {
-              memcpy (transition[self->radius_y], transition[self->radius_y - 1], roi->width * sizeof (gfloat));
-            }
-          else
+          gint d;
+
+          if (current[x])
+            last[x] = y;
+
+          d = y - last[x];
+
+          if (d > 0)
             {
-              /* No edge lock, set everything 'below canvas' as seen
-               * from the algorithm as unselected.
-               */
-              memset (buf[2], 0, roi->width * sizeof (gfloat));
-              compute_transition (transition[self->radius_y], buf, roi->width, self->edge_lock);
+              gint p = MAX (next[x], y + 1);
+
+              while (p <= y + radius_y && ! ring[p % n_ring][x])
+                p++;
+
+              next[x] = p;
+
+              d = MIN (d, p - y);
             }
+
+          dist[x] = d;
         }
 
-      /* update max array */
-      for (x = 0; x < roi->width; x++)
+      if (self->feather)
         {
-          if (max[x] < 1)
+          gint n = 0;
+
+          for (x = 0; x < width; x++)
             {
-              if (max[x] <= -self->radius_y)
-                {
-                  if (transition[self->radius_y][x])
-                    max[x] = self->radius_y;
-                  else
-                    max[x]--;
-                }
-              else
+              if (dist[x] <= radius_y)
                 {
-                  if (transition[-max[x]][x])
-                    max[x] = -max[x];
-                  else if (transition[-max[x] + 1][x])
-                    max[x] = -max[x] + 1;
-                  else
-                    max[x]--;
+                  cols[n] = x;
+                  cost[n] = border->dist_y[dist[x]];
+                  n++;
                 }
             }
-          else
-            {
-              max[x]--;
-            }
 
-          if (max[x] < -self->radius_y - 1)
-            max[x] = -self->radius_y - 1;
+          if (n > 0)
+            border_feather_span (border, cols, cost, 0, width - 1, 0, n - 1,
+                                 out);
+          else
+            memset (out, 0, width * sizeof (gfloat));
         }
-
-      last_index = 1;
-
-       /* render scan line */
-      for (x = 0 ; x < roi->width; x++)
+      else
         {
-          gfloat last_max;
-
-          last_index--;
+          gint s = -1;
 
-          if (last_index >= 0)
+          for (x = 0; x < width; x++)
             {
-              last_max = 0.0;
+              if (dist[x] <= radius_y)
+                s = MAX (s, x + border->reach[dist[x]]);
 
-              for (i = self->radius_x; i >= 0; i--)
-                if (max[x + i] <= self->radius_y && max[x + i] >= -self->radius_y &&
-                    density[i][max[x+i]] > last_max)
-                  {
-                    last_max = density[i][max[x + i]];
-                    last_index = i;
-                  }
-
-              out[x] = last_max;
+              out[x] = (s >= x) ? 1.0 : 0.0;
             }
-          else
-            {
-              last_max = 0.0;
 
-              for (i = self->radius_x; i >= -self->radius_x; i--)
-                if (max[x + i] <= self->radius_y && max[x + i] >= -self->radius_y &&
-                    density[i][max[x + i]] > last_max)
-                  {
-                    last_max = density[i][max[x + i]];
-                    last_index = i;
-                  }
-
-              out[x] = last_max;
-            }
+          s = width;
 
-          if (last_max <= 0.0)
+          for (x = width - 1; x >= 0; x--)
             {
-              for (i = x + 1; i < roi->width; i++)
-                {
-                  if (max[i] >= -self->radius_y)
-                    break;
-                }
-
-              if (i - x > self->radius_x)
-                {
-                  for (; x < i - self->radius_x; x++)
-                    out[x] = 0;
-
-                  x--;
-                }
+              if (dist[x] <= radius_y)
+                s = MIN (s, x - border->reach[dist[x]]);
 
-              last_index = self->radius_x;
+              if (s <= x)
+                out[x] = 1.0;
             }
         }
 
-      gegl_buffer_set (output,
+      gegl_buffer_set (border->output,
                        GEGL_RECTANGLE (roi->x, roi->y + y,
                                        roi->width, 1),
-                       0, output_format, out,
+                       0, babl_format ("Y float"), out,
                        GEGL_AUTO_ROWSTRIDE);
-    }
-
-  g_free (out);
 
-  for (i = 0; i < 3; i++)
-    g_free (buf[i]);
-
-  max -= self->radius_x;
-  g_free (max);
-
-  for (i = 0; i < self->radius_y + 1; i++)
-    {
-      transition[i] -= self->radius_x;
-      g_free (transition[i]);
+      /*  row y + radius_y + 1 takes the place of row y  */
+      border_rows_next (&rows, current);
     }
 
-  g_free (transition);
+  border_rows_clear (&rows);
 
-  for (i = 0; i < self->radius_x + 1 ; i++)
-    {
-      density[i] -= self->radius_y;
-      g_free (density[i]);
-    }
-
-  density -= self->radius_x;
-  g_free (density);
+  for (r = 0; r < n_ring; r++)
+    g_free (ring[r]);
 
-  return TRUE;
+  g_free (ring);
+  g_free (last);
+  g_free (next);
+  g_free (dist);
+  g_free (cols);
+  g_free (cost);
+  g_free (out);
 }
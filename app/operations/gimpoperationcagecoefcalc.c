@@ -19,6 +19,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
 
@@ -26,12 +28,40 @@
 
 #include "operations-types.h"
 
+#include "gegl/gimp-gegl-parallel.h"
+
 #include "gimpoperationcagecoefcalc.h"
 #include "gimpcageconfig.h"
 
 #include "gimp-intl.h"
 
 
+#define GRID_STEP    8          /* pixels between the coarse grid points */
+#define MIN_SUB_AREA (64 * 64)  /* minimum area computed per thread      */
+
+
+/*  the parts of the coefficient formulas which only depend on the
+ *  cage edge, from the edge's first vertex v1 along a
+ */
+typedef struct
+{
+  GimpVector2 v1;
+  GimpVector2 a;
+  gdouble     Q;
+  gdouble     absa;
+} CageEdge;
+
+typedef struct
+{
+  GimpCageConfig *config;
+  CageEdge       *edges;
+  gint            n_vertices;
+  gdouble         max_error;
+  GeglBuffer     *output;
+  const Babl     *format;
+} CoefCalcData;
+
+
 static void           gimp_operation_cage_coef_calc_finalize         (GObject              *object);
 static void           gimp_operation_cage_coef_calc_get_property     (GObject              *object,
                                                                       guint                 property_id,
@@ -49,6 +79,13 @@ static gboolean       gimp_operation_cage_coef_calc_process          (GeglOperat
                                                                       const GeglRectangle  *roi,
                                                                       gint                  level);
 
+static void           gimp_operation_cage_coef_calc_process_area     (const GeglRectangle  *area,
+                                                                      CoefCalcData         *data);
+static gboolean       gimp_operation_cage_coef_calc_point            (CoefCalcData         *data,
+                                                                      gint                  x,
+                                                                      gint                  y,
+                                                                      gfloat               *coef);
+
 
 G_DEFINE_TYPE (GimpOperationCageCoefCalc, gimp_operation_cage_coef_calc,
                GEGL_TYPE_OPERATION_SOURCE)
@@ -88,6 +125,15 @@ gimp_operation_cage_coef_calc_class_init (GimpOperationCageCoefCalcClass *klass)
                                                         GIMP_TYPE_CAGE_CONFIG,
                                                         G_PARAM_READWRITE |
                                                         G_PARAM_CONSTRUCT));
+
+  g_object_class_install_property (object_class,
+                                   GIMP_OPERATION_CAGE_COEF_CALC_PROP_MAX_ERROR,
+                                   g_param_spec_double ("max-error",
+                                                        "Max Error",
+                                                        "If not 0.0, coefficients are interpolated from a coarse grid wherever that stays within this error",
+                                                        0.0, 1.0, 0.0,
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_CONSTRUCT));
 }
 
 static void
@@ -118,6 +164,9 @@ gimp_operation_cage_coef_calc_get_property (GObject    *object,
     case GIMP_OPERATION_CAGE_COEF_CALC_PROP_CONFIG:
       g_value_set_object (value, self->config);
       break;
+    case GIMP_OPERATION_CAGE_COEF_CALC_PROP_MAX_ERROR:
+      g_value_set_double (value, self->max_error);
+      break;
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -140,6 +189,9 @@ gimp_operation_cage_coef_calc_set_property (GObject      *object,
         g_object_unref (self->config);
       self->config = g_value_dup_object (value);
       break;
+    case GIMP_OPERATION_CAGE_COEF_CALC_PROP_MAX_ERROR:
+      self->max_error = g_value_get_double (value);
+      break;
 
    default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -147,27 +199,6 @@ gimp_operation_cage_coef_calc_set_property (GObject      *object,
     }
 }
 
-static gboolean
-gimp_operation_cage_coef_calc_is_on_straight (GimpVector2 *d1,
-                                              GimpVector2 *d2,
-                                              GimpVector2 *p)
-{
-  GimpVector2 v1, v2;
-  gfloat      deter;
-
-  v1.x = p->x - d1->x;
-  v1.y = p->y - d1->y;
-  v2.x = d2->x - d1->x;
-  v2.y = d2->y - d1->y;
-
-  gimp_vector2_normalize (&v1);
-  gimp_vector2_normalize (&v2);
-
-  deter = v1.x * v2.y - v2.x * v1.y;
-
-  return (deter < 0.000000001) && (deter > -0.000000001);
-}
-
 static void
 gimp_operation_cage_coef_calc_prepare (GeglOperation *operation)
 {
@@ -197,96 +228,257 @@ gimp_operation_cage_coef_calc_process (GeglOperation       *operation,
 {
   GimpOperationCageCoefCalc *occc   = GIMP_OPERATION_CAGE_COEF_CALC (operation);
   GimpCageConfig            *config = GIMP_CAGE_CONFIG (occc->config);
-
-  const Babl *format;
-
-  GeglBufferIterator *it;
-  guint               n_cage_vertices;
-  GimpCagePoint      *current, *last;
+  CoefCalcData               data;
+  GimpCagePoint             *current, *last;
+  gint                       j;
 
   if (! config)
     return FALSE;
 
-  format = babl_format_n (babl_type ("float"), 2 * gimp_cage_config_get_n_points (config));
+  data.config     = config;
+  data.n_vertices = gimp_cage_config_get_n_points (config);
+  data.max_error  = occc->max_error;
+  data.output     = output;
+  data.format     = babl_format_n (babl_type ("float"), 2 * data.n_vertices);
+  data.edges      = g_new (CageEdge, data.n_vertices);
 
-  n_cage_vertices   = gimp_cage_config_get_n_points (config);
+  last = &(g_array_index (config->cage_points, GimpCagePoint, 0));
 
-  it = gegl_buffer_iterator_new (output, roi, 0, format,
-                                 GEGL_ACCESS_READWRITE, GEGL_ABYSS_NONE);
+  for (j = 0; j < data.n_vertices; j++)
+    {
+      CageEdge *edge = &data.edges[j];
+
+      current = &(g_array_index (config->cage_points, GimpCagePoint, (j+1) % data.n_vertices));
+
+      edge->v1   = last->src_point;
+      edge->a.x  = current->src_point.x - last->src_point.x;
+      edge->a.y  = current->src_point.y - last->src_point.y;
+      edge->Q    = edge->a.x * edge->a.x + edge->a.y * edge->a.y;
+      edge->absa = sqrt (edge->Q);
+
+      last = current;
+    }
+
+  gimp_gegl_parallel_distribute_area (roi, MIN_SUB_AREA,
+                                      (GimpGeglParallelDistributeAreaFunc)
+                                      gimp_operation_cage_coef_calc_process_area,
+                                      &data);
+
+  g_free (data.edges);
+
+  return TRUE;
+}
+
+static void
+gimp_operation_cage_coef_calc_process_area (const GeglRectangle *area,
+                                            CoefCalcData        *data)
+{
+  GeglBufferIterator *it;
+  const gint          n_coefs = 2 * data->n_vertices;
+  gfloat             *grid    = NULL;
+  gboolean           *inside  = NULL;
+  gfloat             *center  = NULL;
+
+  it = gegl_buffer_iterator_new (data->output, area, 0, data->format,
+                                 GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+
+  if (data->max_error > 0.0)
+    center = g_new (gfloat, n_coefs);
 
   while (gegl_buffer_iterator_next (it))
     {
-      /* iterate inside the roi */
-      gint  n_pixels = it->length;
-      gint  x = it->roi->x; /* initial x                   */
-      gint  y = it->roi->y; /*           and y coordinates */
-      gint  j;
+      const GeglRectangle *roi  = &it->roi[0];
+      gfloat              *coef = it->data[0];
+      gint                 n_cols, n_rows;
+      gint                 col, row;
+      gint                 x, y;
 
-      gfloat      *coef = it->data[0];
+      if (data->max_error <= 0.0 || roi->width < 2 || roi->height < 2)
+        {
+          for (y = roi->y; y < roi->y + roi->height; y++)
+            for (x = roi->x; x < roi->x + roi->width; x++)
+              {
+                gimp_operation_cage_coef_calc_point (data, x, y, coef);
+
+                coef += n_coefs;
+              }
+
+          continue;
+        }
+
+      /*  compute the coefficients exactly on a coarse grid, whose last
+       *  column and row are on the roi's border
+       */
+      n_cols = (roi->width  - 2) / GRID_STEP + 2;
+      n_rows = (roi->height - 2) / GRID_STEP + 2;
+
+#define GRID_X(col) (roi->x + MIN ((col) * GRID_STEP, roi->width  - 1))
+#define GRID_Y(row) (roi->y + MIN ((row) * GRID_STEP, roi->height - 1))
+#define GRID(col, row) (grid + ((row) * n_cols + (col)) * n_coefs)
+
+      grid   = g_renew (gfloat,   grid,   n_cols * n_rows * n_coefs);
+      inside = g_renew (gboolean, inside, n_cols * n_rows);
+
+      for (row = 0; row < n_rows; row++)
+        for (col = 0; col < n_cols; col++)
+          {
+            inside[row * n_cols + col] =
+              gimp_operation_cage_coef_calc_point (data,
+                                                   GRID_X (col), GRID_Y (row),
+                                                   GRID (col, row));
+          }
+
+      /*  then interpolate every cell which is inside the cage, and where
+       *  the interpolation is close enough to the exact value in the
+       *  middle of the cell; compute all other cells exactly
+       */
+      for (row = 0; row < n_rows - 1; row++)
+        for (col = 0; col < n_cols - 1; col++)
+          {
+            const gfloat *c00 = GRID (col,     row);
+            const gfloat *c10 = GRID (col + 1, row);
+            const gfloat *c01 = GRID (col,     row + 1);
+            const gfloat *c11 = GRID (col + 1, row + 1);
+            gint          x1  = GRID_X (col);
+            gint          y1  = GRID_Y (row);
+            gint          x2  = GRID_X (col + 1);
+            gint          y2  = GRID_Y (row + 1);
+            gboolean      interpolate;
+            gint          i;
+
+            /*  cells own their left and top border, the last ones also
+             *  the right and bottom border of the roi
+             */
+            if (col == n_cols - 2)
+              x2++;
+
+            if (row == n_rows - 2)
+              y2++;
+
+            interpolate = (inside[row       * n_cols + col]     &&
+                           inside[row       * n_cols + col + 1] &&
+                           inside[(row + 1) * n_cols + col]     &&
+                           inside[(row + 1) * n_cols + col + 1]);
+
+            if (interpolate)
+              {
+                gint cx = (GRID_X (col) + GRID_X (col + 1)) / 2;
+                gint cy = (GRID_Y (row) + GRID_Y (row + 1)) / 2;
+
+                interpolate = gimp_operation_cage_coef_calc_point (data,
+                                                                   cx, cy,
+                                                                   center);
+
+                for (i = 0; interpolate && i < n_coefs; i++)
+                  {
+                    gfloat value = (c00[i] + c10[i] + c01[i] + c11[i]) / 4.0;
+
+                    if (fabs (value - center[i]) > data->max_error)
+                      interpolate = FALSE;
+                  }
+              }
+
+            for (y = y1; y < y2; y++)
+              {
+                gfloat *dest = coef + (((y - roi->y) * roi->width +
+                                        (x1 - roi->x)) * n_coefs);
+
+                for (x = x1; x < x2; x++)
+                  {
+                    if (! interpolate)
+                      {
+                        gimp_operation_cage_coef_calc_point (data, x, y, dest);
+                      }
+                    else if (gimp_cage_config_point_inside (data->config,
+                                                            x, y))
+                      {
+                        gfloat fx = (gfloat) (x - GRID_X (col)) /
+                                    (GRID_X (col + 1) - GRID_X (col));
+                        gfloat fy = (gfloat) (y - GRID_Y (row)) /
+                                    (GRID_Y (row + 1) - GRID_Y (row));
+
+                        for (i = 0; i < n_coefs; i++)
+                          {
+                            gfloat top    = c00[i] + fx * (c10[i] - c00[i]);
+                            gfloat bottom = c01[i] + fx * (c11[i] - c01[i]);
+
+                            dest[i] = top + fy * (bottom - top);
+                          }
+                      }
+                    else
+                      {
+                        memset (dest, 0, n_coefs * sizeof (gfloat));
+                      }
+
+                    dest += n_coefs;
+                  }
+              }
+          }
+
+#undef GRID_X
+#undef GRID_Y
+#undef GRID
+    }
+
+  g_free (grid);
+  g_free (inside);
+  g_free (center);
+}
+
+/*  computes the coefficients of the pixel at (x, y), all zero if it is
+ *  outside of the cage, and returns whether it is inside
+ */
+static gboolean
+gimp_operation_cage_coef_calc_point (CoefCalcData *data,
+                                     gint          x,
+                                     gint          y,
+                                     gfloat       *coef)
+{
+  const gint n_cage_vertices = data->n_vertices;
+  gint       j;
+
+  memset (coef, 0, 2 * n_cage_vertices * sizeof (gfloat));
+
+  if (! gimp_cage_config_point_inside (data->config, x, y))
+    return FALSE;
+
+  for (j = 0; j < n_cage_vertices; j++)
+    {
+      const CageEdge *edge = &data->edges[j];
+      const gdouble   Q    = edge->Q;
+      gdouble         bx, by;
+      gdouble         BA, SRT, L0, L1, A0, A1, A10, L10, S, R;
+
+      bx  = edge->v1.x - x;
+      by  = edge->v1.y - y;
+      S   = bx * bx + by * by;
+      R   = 2.0 * (edge->a.x * bx + edge->a.y * by);
+      BA  = bx * edge->a.y - by * edge->a.x;
+      SRT = sqrt (4.0 * S * Q - R * R);
+
+      L0  = log (S);
+      L1  = log (S + Q + R);
+      A0  = atan2 (R, SRT) / SRT;
+      A1  = atan2 (2.0 * Q + R, SRT) / SRT;
+      A10 = A1 - A0;
+      L10 = L1 - L0;
+
+      /* edge coef */
+      coef[j + n_cage_vertices] = (-edge->absa / (4.0 * G_PI)) * ((4.0*S-(R*R)/Q) * A10 + (R / (2.0 * Q)) * L10 + L1 - 2.0);
+
+      if (isnan (coef[j + n_cage_vertices]))
+        {
+          coef[j + n_cage_vertices] = 0.0;
+        }
 
-      while(n_pixels--)
+      /* vertice coef, unless the point is on the edge's straight;
+       * BA is the cross product of the edge and the direction to the
+       * point, so this is the same as a zero sine of their angle
+       */
+      if (fabs (BA) > 0.000000001 * sqrt (S) * edge->absa)
         {
-          if (gimp_cage_config_point_inside(config, x, y))
-            {
-              last = &(g_array_index (config->cage_points, GimpCagePoint, 0));
-
-              for( j = 0; j < n_cage_vertices; j++)
-                {
-                  GimpVector2 v1,v2,a,b,p;
-                  gdouble BA,SRT,L0,L1,A0,A1,A10,L10, Q,S,R, absa;
-
-                  current = &(g_array_index (config->cage_points, GimpCagePoint, (j+1) % n_cage_vertices));
-                  v1 = last->src_point;
-                  v2 = current->src_point;
-                  p.x = x;
-                  p.y = y;
-                  a.x = v2.x - v1.x;
-                  a.y = v2.y - v1.y;
-                  absa = gimp_vector2_length (&a);
-
-                  b.x = v1.x - x;
-                  b.y = v1.y - y;
-                  Q = a.x * a.x + a.y * a.y;
-                  S = b.x * b.x + b.y * b.y;
-                  R = 2.0 * (a.x * b.x + a.y * b.y);
-                  BA = b.x * a.y - b.y * a.x;
-                  SRT = sqrt(4.0 * S * Q - R * R);
-
-                  L0 = log(S);
-                  L1 = log(S + Q + R);
-                  A0 = atan2(R, SRT) / SRT;
-                  A1 = atan2(2.0 * Q + R, SRT) / SRT;
-                  A10 = A1 - A0;
-                  L10 = L1 - L0;
-
-                  /* edge coef */
-                  coef[j + n_cage_vertices] = (-absa / (4.0 * G_PI)) * ((4.0*S-(R*R)/Q) * A10 + (R / (2.0 * Q)) * L10 + L1 - 2.0);
-
-                  if (isnan(coef[j + n_cage_vertices]))
-                    {
-                      coef[j + n_cage_vertices] = 0.0;
-                    }
-
-                  /* vertice coef */
-                  if (!gimp_operation_cage_coef_calc_is_on_straight (&v1, &v2, &p))
-                    {
-                      coef[j] += (BA / (2.0 * G_PI)) * (L10 /(2.0*Q) - A10 * (2.0 + R / Q));
-                      coef[(j+1)%n_cage_vertices] -= (BA / (2.0 * G_PI)) * (L10 / (2.0 * Q) - A10 * (R / Q));
-                    }
-
-                  last = current;
-                }
-            }
-
-          coef += 2 * n_cage_vertices;
-
-          /* update x and y coordinates */
-          x++;
-          if (x >= (it->roi->x + it->roi->width))
-            {
-              x = it->roi->x;
-              y++;
-            }
+          coef[j] += (BA / (2.0 * G_PI)) * (L10 /(2.0*Q) - A10 * (2.0 + R / Q));
+          coef[(j+1) % n_cage_vertices] -= (BA / (2.0 * G_PI)) * (L10 / (2.0 * Q) - A10 * (R / Q));
         }
     }
 
@@ -28,7 +28,8 @@
 enum
 {
   GIMP_OPERATION_CAGE_COEF_CALC_PROP_0,
-  GIMP_OPERATION_CAGE_COEF_CALC_PROP_CONFIG
+  GIMP_OPERATION_CAGE_COEF_CALC_PROP_CONFIG,
+  GIMP_OPERATION_CAGE_COEF_CALC_PROP_MAX_ERROR
 };
 
 
@@ -48,6 +49,7 @@ struct _GimpOperationCageCoefCalc
   GeglOperationSource  parent_instance;
 
   GimpCageConfig      *config;
+  gdouble              max_error;
 };
 
 struct _GimpOperationCageCoefCalcClass
@@ -0,0 +1,449 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpoperationcolorchain.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <cairo.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gegl.h>
+
+#include "operations-types.h"
+
+#include "gegl/gimp-gegl-parallel.h"
+
+#include "gimpcolorchainconfig.h"
+#include "gimpoperationcolorchain.h"
+
+
+/*  separable chains are sampled into one curve per channel, all other
+ *  chains into a CUBE_SIZE^3 RGB lattice which is interpolated
+ *  tetrahedrally.  pixels outside [0, 1] run through the steps
+ *  themselves.
+ */
+#define CURVE_SIZE         (1 << 16)
+#define CUBE_SIZE          65
+#define CUBE_INDEX(r,g,b)  ((((r) * CUBE_SIZE + (g)) * CUBE_SIZE + (b)) * 3)
+
+
+static void     gimp_operation_color_chain_finalize     (GObject                 *object);
+static void     gimp_operation_color_chain_set_property (GObject                 *object,
+                                                         guint                    property_id,
+                                                         const GValue            *value,
+                                                         GParamSpec              *pspec);
+
+static void     gimp_operation_color_chain_prepare      (GeglOperation           *operation);
+static gboolean gimp_operation_color_chain_process      (GeglOperation           *operation,
+                                                         void                    *in_buf,
+                                                         void                    *out_buf,
+                                                         glong                    samples,
+                                                         const GeglRectangle     *roi,
+                                                         gint                     level);
+
+static void     gimp_operation_color_chain_clear        (GimpOperationColorChain *chain);
+static void     gimp_operation_color_chain_compile      (GimpOperationColorChain *chain,
+                                                         GimpColorChainConfig    *config);
+static void     gimp_operation_color_chain_run          (GimpOperationColorChain *chain,
+                                                         gfloat                  *buf,
+                                                         glong                    samples);
+
+
+G_DEFINE_TYPE (GimpOperationColorChain, gimp_operation_color_chain,
+               GIMP_TYPE_OPERATION_POINT_FILTER)
+
+#define parent_class gimp_operation_color_chain_parent_class
+
+
+static void
+gimp_operation_color_chain_class_init (GimpOperationColorChainClass *klass)
+{
+  GObjectClass                  *object_class    = G_OBJECT_CLASS (klass);
+  GeglOperationClass            *operation_class = GEGL_OPERATION_CLASS (klass);
+  GeglOperationPointFilterClass *point_class     = GEGL_OPERATION_POINT_FILTER_CLASS (klass);
+
+  object_class->finalize       = gimp_operation_color_chain_finalize;
+  object_class->set_property   = gimp_operation_color_chain_set_property;
+  object_class->get_property   = gimp_operation_point_filter_get_property;
+
+  operation_class->prepare     = gimp_operation_color_chain_prepare;
+
+  gegl_operation_class_set_keys (operation_class,
+                                 "name",        "gimp:color-chain",
+                                 "categories",  "color",
+                                 "description", "GIMP chain of color operations applied in one pass",
+                                 NULL);
+
+  point_class->process = gimp_operation_color_chain_process;
+
+  g_object_class_install_property (object_class,
+                                   GIMP_OPERATION_POINT_FILTER_PROP_CONFIG,
+                                   g_param_spec_object ("config",
+                                                        "Config",
+                                                        "The config object",
+                                                        GIMP_TYPE_COLOR_CHAIN_CONFIG,
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_CONSTRUCT));
+}
+
+static void
+gimp_operation_color_chain_init (GimpOperationColorChain *self)
+{
+}
+
+static void
+gimp_operation_color_chain_finalize (GObject *object)
+{
+  gimp_operation_color_chain_clear (GIMP_OPERATION_COLOR_CHAIN (object));
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gimp_operation_color_chain_set_property (GObject      *object,
+                                         guint         property_id,
+                                         const GValue *value,
+                                         GParamSpec   *pspec)
+{
+  GimpOperationColorChain *chain = GIMP_OPERATION_COLOR_CHAIN (object);
+
+  if (property_id == GIMP_OPERATION_POINT_FILTER_PROP_CONFIG)
+    chain->valid = FALSE;
+
+  gimp_operation_point_filter_set_property (object, property_id, value, pspec);
+}
+
+static void
+gimp_operation_color_chain_prepare (GeglOperation *operation)
+{
+  GimpOperationColorChain  *chain = GIMP_OPERATION_COLOR_CHAIN (operation);
+  GimpOperationPointFilter *point = GIMP_OPERATION_POINT_FILTER (operation);
+  GimpColorChainConfig     *config;
+
+  GEGL_OPERATION_CLASS (parent_class)->prepare (operation);
+
+  config = GIMP_COLOR_CHAIN_CONFIG (point->config);
+
+  if (! config)
+    return;
+
+  if (! chain->valid || chain->serial != config->serial)
+    gimp_operation_color_chain_compile (chain, config);
+}
+
+static inline gboolean
+pixel_in_range (const gfloat *pixel)
+{
+  /*  written so that NaNs fail the test  */
+  return (pixel[RED]   >= 0.0f && pixel[RED]   <= 1.0f &&
+          pixel[GREEN] >= 0.0f && pixel[GREEN] <= 1.0f &&
+          pixel[BLUE]  >= 0.0f && pixel[BLUE]  <= 1.0f &&
+          pixel[ALPHA] >= 0.0f && pixel[ALPHA] <= 1.0f);
+}
+
+static inline gfloat
+curve_map (const gfloat *curves,
+           gint          channel,
+           gfloat        value)
+{
+  gfloat pos = value * (CURVE_SIZE - 1);
+  gint   index;
+  gfloat frac;
+
+  index = MIN ((gint) pos, CURVE_SIZE - 2);
+  frac  = pos - index;
+
+  curves += index * 4 + channel;
+
+  return curves[0] + (curves[4] - curves[0]) * frac;
+}
+
+static inline void
+cube_map (const gfloat *cube,
+          const gfloat *src,
+          gfloat       *dest)
+{
+  gfloat        r = src[RED]   * (CUBE_SIZE - 1);
+  gfloat        g = src[GREEN] * (CUBE_SIZE - 1);
+  gfloat        b = src[BLUE]  * (CUBE_SIZE - 1);
+  gint          ir, ig, ib;
+  gfloat        dr, dg, db;
+  const gfloat *c000;
+  const gfloat *c1;
+  const gfloat *c2;
+  const gfloat *c111;
+  gfloat        w1, w2, w3;
+  gint          c;
+
+  ir = MIN ((gint) r, CUBE_SIZE - 2);
+  ig = MIN ((gint) g, CUBE_SIZE - 2);
+  ib = MIN ((gint) b, CUBE_SIZE - 2);
+
+  dr = r - ir;
+  dg = g - ig;
+  db = b - ib;
+
+  c000 = cube + CUBE_INDEX (ir,     ig,     ib);
+  c111 = cube + CUBE_INDEX (ir + 1, ig + 1, ib + 1);
+
+  /*  pick the tetrahedron of the lattice cell containing the pixel,
+   *  walking from c000 to c111 along the largest fractions first
+   */
+  if (dr >= dg)
+    {
+      if (dg >= db)
+        {
+          c1 = cube + CUBE_INDEX (ir + 1, ig,     ib);
+          c2 = cube + CUBE_INDEX (ir + 1, ig + 1, ib);
+          w1 = dr; w2 = dg; w3 = db;
+        }
+      else if (dr >= db)
+        {
+          c1 = cube + CUBE_INDEX (ir + 1, ig,     ib);
+          c2 = cube + CUBE_INDEX (ir + 1, ig,     ib + 1);
+          w1 = dr; w2 = db; w3 = dg;
+        }
+      else
+        {
+          c1 = cube + CUBE_INDEX (ir,     ig,     ib + 1);
+          c2 = cube + CUBE_INDEX (ir + 1, ig,     ib + 1);
+          w1 = db; w2 = dr; w3 = dg;
+        }
+    }
+  else
+    {
+      if (db >= dg)
+        {
+          c1 = cube + CUBE_INDEX (ir,     ig,     ib + 1);
+          c2 = cube + CUBE_INDEX (ir,     ig + 1, ib + 1);
+          w1 = db; w2 = dg; w3 = dr;
+        }
+      else if (db >= dr)
+        {
+          c1 = cube + CUBE_INDEX (ir,     ig + 1, ib);
+          c2 = cube + CUBE_INDEX (ir,     ig + 1, ib + 1);
+          w1 = dg; w2 = db; w3 = dr;
+        }
+      else
+        {
+          c1 = cube + CUBE_INDEX (ir,     ig + 1, ib);
+          c2 = cube + CUBE_INDEX (ir + 1, ig + 1, ib);
+          w1 = dg; w2 = dr; w3 = db;
+        }
+    }
+
+  for (c = 0; c < 3; c++)
+    {
+      dest[c] = (c000[c]                 +
+                 w1 * (c1[c]   - c000[c]) +
+                 w2 * (c2[c]   - c1[c])   +
+                 w3 * (c111[c] - c2[c]));
+    }
+}
+
+static gboolean
+gimp_operation_color_chain_process (GeglOperation       *operation,
+                                    void                *in_buf,
+                                    void                *out_buf,
+                                    glong                samples,
+                                    const GeglRectangle *roi,
+                                    gint                 level)
+{
+  GimpOperationColorChain  *chain  = GIMP_OPERATION_COLOR_CHAIN (operation);
+  GimpOperationPointFilter *point  = GIMP_OPERATION_POINT_FILTER (operation);
+  const gfloat             *curves = chain->curves;
+  const gfloat             *cube   = chain->cube;
+  gfloat                   *src    = in_buf;
+  gfloat                   *dest   = out_buf;
+
+  if (! point->config || ! chain->valid)
+    return FALSE;
+
+  if (chain->n_steps == 0)
+    {
+      if (src != dest)
+        memcpy (dest, src, samples * 4 * sizeof (gfloat));
+
+      return TRUE;
+    }
+
+  while (samples--)
+    {
+      if (G_UNLIKELY (! pixel_in_range (src)))
+        {
+          memmove (dest, src, 4 * sizeof (gfloat));
+
+          gimp_operation_color_chain_run (chain, dest, 1);
+        }
+      else if (cube)
+        {
+          gfloat alpha = src[ALPHA];
+
+          cube_map (cube, src, dest);
+
+          dest[ALPHA] = curve_map (curves, ALPHA, alpha);
+        }
+      else
+        {
+          dest[RED]   = curve_map (curves, RED,   src[RED]);
+          dest[GREEN] = curve_map (curves, GREEN, src[GREEN]);
+          dest[BLUE]  = curve_map (curves, BLUE,  src[BLUE]);
+          dest[ALPHA] = curve_map (curves, ALPHA, src[ALPHA]);
+        }
+
+      src  += 4;
+      dest += 4;
+    }
+
+  return TRUE;
+}
+
+
+/*  private functions  */
+
+static void
+gimp_operation_color_chain_clear (GimpOperationColorChain *chain)
+{
+  gint i;
+
+  for (i = 0; i < chain->n_steps; i++)
+    g_object_unref (chain->steps[i]);
+
+  g_clear_pointer (&chain->steps,  g_free);
+  g_clear_pointer (&chain->curves, g_free);
+  g_clear_pointer (&chain->cube,   g_free);
+
+  chain->n_steps = 0;
+  chain->valid   = FALSE;
+}
+
+static void
+gimp_operation_color_chain_compile_slices (gsize                    offset,
+                                           gsize                    size,
+                                           GimpOperationColorChain *chain)
+{
+  gfloat *buf;
+  gint    r;
+
+  buf = g_new (gfloat, CUBE_SIZE * CUBE_SIZE * 4);
+
+  for (r = offset; r < offset + size; r++)
+    {
+      gfloat *cube = chain->cube + CUBE_INDEX (r, 0, 0);
+      gfloat *p    = buf;
+      gint    g, b;
+      gint    i;
+
+      for (g = 0; g < CUBE_SIZE; g++)
+        for (b = 0; b < CUBE_SIZE; b++)
+          {
+            p[RED]   = (gfloat) r / (CUBE_SIZE - 1);
+            p[GREEN] = (gfloat) g / (CUBE_SIZE - 1);
+            p[BLUE]  = (gfloat) b / (CUBE_SIZE - 1);
+            p[ALPHA] = 1.0f;
+
+            p += 4;
+          }
+
+      gimp_operation_color_chain_run (chain, buf, CUBE_SIZE * CUBE_SIZE);
+
+      for (i = 0; i < CUBE_SIZE * CUBE_SIZE; i++)
+        {
+          cube[i * 3 + RED]   = buf[i * 4 + RED];
+          cube[i * 3 + GREEN] = buf[i * 4 + GREEN];
+          cube[i * 3 + BLUE]  = buf[i * 4 + BLUE];
+        }
+    }
+
+  g_free (buf);
+}
+
+static void
+gimp_operation_color_chain_compile (GimpOperationColorChain *chain,
+                                    GimpColorChainConfig    *config)
+{
+  gint i;
+
+  gimp_operation_color_chain_clear (chain);
+
+  chain->n_steps = gimp_color_chain_config_get_n_steps (config);
+  chain->steps   = g_new0 (GeglOperation *, chain->n_steps);
+
+  for (i = 0; i < chain->n_steps; i++)
+    {
+      const gchar *name;
+      GObject     *op_config;
+
+      gimp_color_chain_config_get_step (config, i, &name, &op_config);
+
+      chain->steps[i] = g_object_new (gegl_operation_gtype_from_name (name),
+                                      "config", op_config,
+                                      NULL);
+    }
+
+  /*  the alpha curve is needed in either case, the color operations
+   *  never mix alpha into the color channels or vice versa
+   */
+  chain->curves = g_new (gfloat, CURVE_SIZE * 4);
+
+  for (i = 0; i < CURVE_SIZE; i++)
+    {
+      gfloat value = (gfloat) i / (CURVE_SIZE - 1);
+
+      chain->curves[i * 4 + RED]   = value;
+      chain->curves[i * 4 + GREEN] = value;
+      chain->curves[i * 4 + BLUE]  = value;
+      chain->curves[i * 4 + ALPHA] = value;
+    }
+
+  gimp_operation_color_chain_run (chain, chain->curves, CURVE_SIZE);
+
+  if (! gimp_color_chain_config_is_separable (config))
+    {
+      chain->cube = g_new (gfloat, CUBE_SIZE * CUBE_SIZE * CUBE_SIZE * 3);
+
+      gimp_gegl_parallel_distribute_range (CUBE_SIZE, 1,
+                                           (GimpGeglParallelDistributeRangeFunc)
+                                           gimp_operation_color_chain_compile_slices,
+                                           chain);
+    }
+
+  chain->serial = config->serial;
+  chain->valid  = TRUE;
+}
+
+/*  runs the steps one after the other on buf, in place  */
+static void
+gimp_operation_color_chain_run (GimpOperationColorChain *chain,
+                                gfloat                  *buf,
+                                glong                    samples)
+{
+  GeglRectangle roi = { 0, 0, samples, 1 };
+  gint          i;
+
+  for (i = 0; i < chain->n_steps; i++)
+    {
+      GeglOperation                 *step = chain->steps[i];
+      GeglOperationPointFilterClass *step_class;
+
+      step_class = GEGL_OPERATION_POINT_FILTER_GET_CLASS (step);
+
+      step_class->process (step, buf, buf, samples, &roi, 0);
+    }
+}
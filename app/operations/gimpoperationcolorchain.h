@@ -0,0 +1,62 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpoperationcolorchain.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_OPERATION_COLOR_CHAIN_H__
+#define __GIMP_OPERATION_COLOR_CHAIN_H__
+
+
+#include "gimpoperationpointfilter.h"
+
+
+#define GIMP_TYPE_OPERATION_COLOR_CHAIN            (gimp_operation_color_chain_get_type ())
+#define GIMP_OPERATION_COLOR_CHAIN(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GIMP_TYPE_OPERATION_COLOR_CHAIN, GimpOperationColorChain))
+#define GIMP_OPERATION_COLOR_CHAIN_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  GIMP_TYPE_OPERATION_COLOR_CHAIN, GimpOperationColorChainClass))
+#define GIMP_IS_OPERATION_COLOR_CHAIN(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GIMP_TYPE_OPERATION_COLOR_CHAIN))
+#define GIMP_IS_OPERATION_COLOR_CHAIN_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  GIMP_TYPE_OPERATION_COLOR_CHAIN))
+#define GIMP_OPERATION_COLOR_CHAIN_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  GIMP_TYPE_OPERATION_COLOR_CHAIN, GimpOperationColorChainClass))
+
+
+typedef struct _GimpOperationColorChain      GimpOperationColorChain;
+typedef struct _GimpOperationColorChainClass GimpOperationColorChainClass;
+
+struct _GimpOperationColorChain
+{
+  GimpOperationPointFilter   parent_instance;
+
+  /*  the compiled chain, rebuilt whenever the config's serial changes  */
+  gboolean                   valid;
+  guint                      serial;
+
+  GeglOperation            **steps;
+  gint                       n_steps;
+
+  gfloat                    *curves;  /* per-channel RGBA curves        */
+  gfloat                    *cube;    /* RGB lattice, NULL if separable */
+};
+
+struct _GimpOperationColorChainClass
+{
+  GimpOperationPointFilterClass  parent_class;
+};
+
+
+GType   gimp_operation_color_chain_get_type (void) G_GNUC_CONST;
+
+
+#endif /* __GIMP_OPERATION_COLOR_CHAIN_H__ */
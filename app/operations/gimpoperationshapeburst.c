@@ -20,6 +20,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <cairo.h>
 #include <gegl.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
@@ -29,16 +31,41 @@
 
 #include "operations-types.h"
 
+#include "gegl/gimp-gegl-parallel.h"
+
 #include "gimpoperationshapeburst.h"
 
 
+/*  pixels below this are background  */
+#define SHAPEBURST_EPSILON      0.0001
+
+/*  the number of pixels processed at once, and the least number of
+ *  pixels of a strip's rows or columns given to one thread
+ */
+#define SHAPEBURST_STRIP_SIZE   (1 << 18)
+#define SHAPEBURST_MIN_SUB_SIZE 16384
+
+
 enum
 {
   PROP_0,
   PROP_NORMALIZE,
+  PROP_CHAMFER
 };
 
 
+typedef struct
+{
+  gint          width;
+  gint          height;
+  const gfloat *src;
+  gfloat       *dist;
+  gfloat       *edge;
+  gfloat        max_dist;
+  GMutex        mutex;
+} Shapeburst;
+
+
 static void     gimp_operation_shapeburst_get_property (GObject      *object,
                                                         guint         property_id,
                                                         GValue       *value,
@@ -62,6 +89,24 @@ static gboolean gimp_operation_shapeburst_process (GeglOperation       *operatio
                                                    const GeglRectangle *roi,
                                                    gint                 level);
 
+static void     shapeburst_columns_down           (gsize                offset,
+                                                   gsize                size,
+                                                   Shapeburst          *shapeburst);
+static void     shapeburst_columns_up             (gsize                offset,
+                                                   gsize                size,
+                                                   Shapeburst          *shapeburst);
+static void     shapeburst_rows                   (gsize                offset,
+                                                   gsize                size,
+                                                   Shapeburst          *shapeburst);
+static void     shapeburst_chamfer_down           (const gfloat        *src,
+                                                   gfloat              *dist,
+                                                   gfloat              *edge,
+                                                   gint                 width,
+                                                   gint                 height);
+static void     shapeburst_chamfer_up             (Shapeburst          *shapeburst,
+                                                   gfloat              *edge,
+                                                   gint                 height);
+
 
 G_DEFINE_TYPE (GimpOperationShapeburst, gimp_operation_shapeburst,
                GEGL_TYPE_OPERATION_FILTER)
@@ -88,6 +133,7 @@ gimp_operation_shapeburst_class_init (GimpOperationShapeburstClass *klass)
   operation_class->prepare                 = gimp_operation_shapeburst_prepare;
   operation_class->get_required_for_output = gimp_operation_shapeburst_get_required_for_output;
   operation_class->get_cached_region       = gimp_operation_shapeburst_get_cached_region;
+  operation_class->threaded                = FALSE;
 
   filter_class->process                    = gimp_operation_shapeburst_process;
 
@@ -97,6 +143,13 @@ gimp_operation_shapeburst_class_init (GimpOperationShapeburstClass *klass)
                                                          "Normalize",
                                                          FALSE,
                                                          G_PARAM_READWRITE));
+
+  g_object_class_install_property (object_class, PROP_CHAMFER,
+                                   g_param_spec_boolean ("chamfer",
+                                                         "Chamfer",
+                                                         "Use the faster, approximate chamfer distance",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE));
 }
 
 static void
@@ -118,6 +171,10 @@ gimp_operation_shapeburst_get_property (GObject    *object,
       g_value_set_boolean (value, self->normalize);
       break;
 
+    case PROP_CHAMFER:
+      g_value_set_boolean (value, self->chamfer);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -138,6 +195,10 @@ gimp_operation_shapeburst_set_property (GObject      *object,
       self->normalize = g_value_get_boolean (value);
       break;
 
+    case PROP_CHAMFER:
+      self->chamfer = g_value_get_boolean (value);
+      break;
+
    default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -166,6 +227,20 @@ gimp_operation_shapeburst_get_cached_region (GeglOperation       *self,
   return *gegl_operation_source_get_bounding_box (self, "input");
 }
 
+/*  The output is the Euclidean distance of every selected pixel to
+ *  the nearest unselected one, minus one plus the pixel's coverage,
+ *  and 0.0 for unselected pixels.  This differs from the old diagonal
+ *  scan, which measured the chessboard distance plus one and gave
+ *  unselected pixels 1.0, so normalized values along straight edges
+ *  are about 1.0 / max_dist lower, and lower still towards corners.
+ *
+ *  Both passes walk over the roi in strips, keeping only the row next
+ *  to the strip: the first one stores the vertical (or forward
+ *  chamfer) distances in the output, the second one finishes them
+ *  from the bottom up and computes the final values.  Within a strip,
+ *  the column passes are split into ranges of columns and the row
+ *  pass into ranges of rows, which run on all threads.
+ */
 static gboolean
 gimp_operation_shapeburst_process (GeglOperation       *operation,
                                    GeglBuffer          *input,
@@ -173,137 +248,117 @@ gimp_operation_shapeburst_process (GeglOperation       *operation,
                                    const GeglRectangle *roi,
                                    gint                 level)
 {
-  const Babl *input_format   = babl_format ("Y float");
-  const Babl *output_format  = babl_format ("Y float");
-  gfloat      max_dist = 0.0;
-  gfloat     *distbuf;
-  gint        x, y;
+  GimpOperationShapeburst *self   = GIMP_OPERATION_SHAPEBURST (operation);
+  const Babl              *format = babl_format ("Y float");
+  Shapeburst               shapeburst;
+  GeglRectangle            strip;
+  gfloat                  *src;
+  gint                     strip_rows;
+  gint                     y;
+
+  if (roi->width < 1 || roi->height < 1)
+    return TRUE;
+
+  strip_rows = CLAMP (SHAPEBURST_STRIP_SIZE / roi->width, 1, roi->height);
+
+  src = g_new (gfloat, (gsize) roi->width * strip_rows);
+
+  shapeburst.width    = roi->width;
+  shapeburst.src      = src;
+  shapeburst.dist     = g_new (gfloat, (gsize) roi->width * strip_rows);
+  shapeburst.edge     = g_new0 (gfloat, roi->width);
+  shapeburst.max_dist = 0.0;
 
-  distbuf = g_new0 (gfloat, (roi->width + 1) * 2);
+  g_mutex_init (&shapeburst.mutex);
 
-  for (y = 0; y < roi->height; y++)
+  strip.x     = roi->x;
+  strip.width = roi->width;
+
+  /*  everything outside roi counts as background, so edge starts out
+   *  as 0.0 above the first and below the last row
+   */
+  for (y = 0; y < roi->height; y += strip.height)
     {
-      gfloat *distbuf_cur;
-      gfloat *distbuf_prev;
-      gfloat  src = 0.0;
+      strip.y      = roi->y + y;
+      strip.height = MIN (strip_rows, roi->height - y);
 
-      /* toggling distance buffers for the current and previous row.
-       * with one spare zero element on the left side */
-      if (y % 2)
-        {
-          distbuf_prev = distbuf + 1;
-          distbuf_cur  = distbuf + 1 + roi->width + 1;
-        }
-      else
-        {
-          distbuf_prev = distbuf + 1 + roi->width + 1;
-          distbuf_cur  = distbuf + 1;
-        }
+      shapeburst.height = strip.height;
 
-      /*  clear the current rows distbuffer */
-      memset (distbuf_cur, 0, sizeof (gfloat) * roi->width);
+      gegl_buffer_get (input, &strip, 1.0, format, src,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
-      for (x = 0; x < roi->width; x++)
-        {
-          gfloat dist_nw = MIN (distbuf_cur[x-1], distbuf_prev[x]);
-          gfloat dist_se = MIN ((roi->width - x - 1), (roi->height - y - 1));
-          gfloat dist    = MIN (dist_se, dist_nw);
-          gfloat frac    = 1.0;
-          gint   k;
-
-#define EPSILON 0.0001
-
-          /*  This loop used to start at "k = (dist) ? (dist - 1) : 0"
-           *  and this comment suggested it might have to be changed to
-           *  "k = 0", but "k = 0" increases processing time significantly.
-           *
-           *  When porting this to float, i noticed that starting at
-           *  "dist - 2" gets rid of a lot of 8-bit artifacts, while starting
-           *  at "dist - 3" or smaller would introduce different artifacts.
-           *
-           *  Note that I didn't really understand the entire algorithm,
-           *  I just "blindly" ported it to float :) --mitch
-           */
-
-          /* the idea here is to check the south-eastern "thick" diagonal
-           * along the already established accumulated minimum distance.
-           *
-           * it is easy to understand why it is sufficient to check
-           * the triangle to this diagonal (k=0), but in fact we can
-           * omit that, since this check has already been incorporated
-           * in the accumulated minimum distance of the previous pixels.
-           *
-           * Not sure however if this is implemented properly.
-           *      -- simon
-           */
-
-          for (k = MAX (dist - 2, 0); k <= dist; k++)
-            {
-              gint x1  = x;
-              gint y1  = y + k;
-
-              while (y1 >= y)
-                {
-                  /* FIXME: this should be much faster, it converts to
-                   * 32 bit rgba intermediately, bah...
-                   */
-                  gegl_buffer_sample (input, x1 + roi->x, y1 + roi->y,
-                                      NULL, &src, input_format,
-                                      GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
-
-                  if (src < EPSILON)
-                    {
-                      dist = k;
-                      break;
-                    }
-
-                  frac = MIN (frac, src);
-
-                  x1++;
-                  y1--;
-                }
-            }
+      if (self->chamfer)
+        shapeburst_chamfer_down (src, shapeburst.dist, shapeburst.edge,
+                                 strip.width, strip.height);
+      else
+        gimp_gegl_parallel_distribute_range (strip.width,
+                                             MAX (1, SHAPEBURST_MIN_SUB_SIZE /
+                                                     strip.height),
+                                             (GimpGeglParallelDistributeRangeFunc)
+                                             shapeburst_columns_down,
+                                             &shapeburst);
+
+      gegl_buffer_set (output, &strip, 0, format, shapeburst.dist,
+                       GEGL_AUTO_ROWSTRIDE);
 
-          if (src > EPSILON)
-            {
-              /*  If dist_se != dist_nw use the previous frac
-               *   if it is less than the one found
-               */
-              if (dist_se != dist)
-                {
-                  gfloat prev_frac = dist_nw - dist;
+      gegl_operation_progress (operation,
+                               0.5 * (y + strip.height) / roi->height, "");
+    }
 
-                  if (ABS (prev_frac - 1.0) < EPSILON)
-                    prev_frac = 0.0;
+  memset (shapeburst.edge, 0, roi->width * sizeof (gfloat));
 
-                  frac = MIN (frac, prev_frac);
-                }
+  for (y = roi->height; y > 0; y -= strip.height)
+    {
+      strip.height = MIN (strip_rows, y);
+      strip.y      = roi->y + y - strip.height;
 
-              dist += 1.0;
-            }
+      shapeburst.height = strip.height;
 
-          distbuf_cur[x] = dist + frac;
+      gegl_buffer_get (input, &strip, 1.0, format, src,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+      gegl_buffer_get (output, &strip, 1.0, format, shapeburst.dist,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
-          max_dist = MAX (max_dist, distbuf_cur[x]);
+      if (self->chamfer)
+        {
+          shapeburst_chamfer_up (&shapeburst, shapeburst.edge, strip.height);
+        }
+      else
+        {
+          gimp_gegl_parallel_distribute_range (strip.width,
+                                               MAX (1, SHAPEBURST_MIN_SUB_SIZE /
+                                                       strip.height),
+                                               (GimpGeglParallelDistributeRangeFunc)
+                                               shapeburst_columns_up,
+                                               &shapeburst);
+
+          gimp_gegl_parallel_distribute_range (strip.height,
+                                               MAX (1, SHAPEBURST_MIN_SUB_SIZE /
+                                                       strip.width),
+                                               (GimpGeglParallelDistributeRangeFunc)
+                                               shapeburst_rows,
+                                               &shapeburst);
         }
 
-      /*  set the dist row  */
-      gegl_buffer_set (output,
-                       GEGL_RECTANGLE (roi->x, roi->y + y,
-                                       roi->width, 1),
-                       0, output_format, distbuf_cur,
+      gegl_buffer_set (output, &strip, 0, format, shapeburst.dist,
                        GEGL_AUTO_ROWSTRIDE);
 
-      gegl_operation_progress (operation, (gdouble) y / roi->height, "");
+      gegl_operation_progress (operation,
+                               1.0 - 0.5 * (y - strip.height) / roi->height,
+                               "");
     }
 
-  g_free (distbuf);
+  g_mutex_clear (&shapeburst.mutex);
 
-  if (GIMP_OPERATION_SHAPEBURST (operation)->normalize && max_dist > 0.0)
+  g_free (shapeburst.dist);
+  g_free (shapeburst.edge);
+  g_free (src);
+
+  if (self->normalize && shapeburst.max_dist > 0.0)
     {
       GeglBufferIterator *iter;
 
-      iter = gegl_buffer_iterator_new (output, NULL, 0, NULL,
+      iter = gegl_buffer_iterator_new (output, roi, 0, format,
                                        GEGL_ACCESS_READWRITE, GEGL_ABYSS_NONE);
 
       while (gegl_buffer_iterator_next (iter))
@@ -312,7 +367,7 @@ gimp_operation_shapeburst_process (GeglOperation       *operation,
           gfloat *data  = iter->data[0];
 
           while (count--)
-            *data++ /= max_dist;
+            *data++ /= shapeburst.max_dist;
         }
     }
 
@@ -320,3 +375,272 @@ gimp_operation_shapeburst_process (GeglOperation       *operation,
 
   return TRUE;
 }
+
+/*  the distance of a foreground pixel to the nearest background pixel
+ *  is at least 1.0, pull it towards 0.0 by the pixel's coverage so
+ *  that antialiased selection edges stay smooth
+ */
+static inline gfloat
+shapeburst_value (gfloat  src,
+                  gdouble dist)
+{
+  if (src < SHAPEBURST_EPSILON)
+    return 0.0;
+
+  return dist - 1.0 + src;
+}
+
+static void
+shapeburst_update_max (Shapeburst *shapeburst,
+                       gfloat      max_dist)
+{
+  g_mutex_lock (&shapeburst->mutex);
+
+  shapeburst->max_dist = MAX (shapeburst->max_dist, max_dist);
+
+  g_mutex_unlock (&shapeburst->mutex);
+}
+
+/*  first pass of the exact Euclidean distance transform: for every
+ *  pixel, the distance to the nearest background pixel above it in
+ *  its column.  edge holds the distances of the row above the strip.
+ *  The columns are independent, each call does the columns offset to
+ *  offset + size - 1.
+ */
+static void
+shapeburst_columns_down (gsize       offset,
+                         gsize       size,
+                         Shapeburst *shapeburst)
+{
+  const gint  width  = shapeburst->width;
+  gfloat     *edge   = shapeburst->edge;
+  gint        x0     = offset;
+  gint        x1     = offset + size;
+  gint        x, y;
+
+  for (y = 0; y < shapeburst->height; y++)
+    {
+      const gfloat *s = shapeburst->src  + (gsize) y * width;
+      gfloat       *d = shapeburst->dist + (gsize) y * width;
+
+      for (x = x0; x < x1; x++)
+        {
+          if (s[x] < SHAPEBURST_EPSILON)
+            edge[x] = 0.0;
+          else
+            edge[x] += 1.0;
+
+          d[x] = edge[x];
+        }
+    }
+}
+
+/*  ... and the distance to the nearest background pixel in its
+ *  column, from the bottom up.  edge holds the distances of the row
+ *  below the strip.
+ */
+static void
+shapeburst_columns_up (gsize       offset,
+                       gsize       size,
+                       Shapeburst *shapeburst)
+{
+  const gint  width  = shapeburst->width;
+  gfloat     *edge   = shapeburst->edge;
+  gint        x0     = offset;
+  gint        x1     = offset + size;
+  gint        x, y;
+
+  for (y = shapeburst->height - 1; y >= 0; y--)
+    {
+      gfloat *d = shapeburst->dist + (gsize) y * width;
+
+      for (x = x0; x < x1; x++)
+        {
+          edge[x] = MIN (d[x], edge[x] + 1.0);
+          d[x]    = edge[x];
+        }
+    }
+}
+
+/*  the column where the parabolas of q and p intersect  */
+static inline gdouble
+shapeburst_intersect (const gdouble *f,
+                      gint           q,
+                      gint           p)
+{
+  return (((f[q] + (gdouble) q * q) - (f[p] + (gdouble) p * p)) /
+          (2.0 * (q - p)));
+}
+
+/*  second pass: the lower envelope of the parabolas
+ *  (x - q)^2 + dist_y(q)^2 along every row, after Felzenszwalb and
+ *  Huttenlocher.  The columns -1 and width are background.
+ */
+static void
+shapeburst_rows (gsize       offset,
+                 gsize       size,
+                 Shapeburst *shapeburst)
+{
+  const gint  width    = shapeburst->width;
+  const gint  n        = width + 2;
+  gdouble    *f        = g_new (gdouble, n);
+  gdouble    *z        = g_new (gdouble, n + 1);
+  gint       *v        = g_new (gint, n);
+  gint        y0       = offset;
+  gint        y1       = offset + size;
+  gfloat      max_dist = 0.0;
+  gint        y;
+
+  for (y = y0; y < y1; y++)
+    {
+      const gfloat *src = shapeburst->src  + (gsize) y * width;
+      gfloat       *row = shapeburst->dist + (gsize) y * width;
+      gint          k;
+      gint          q;
+
+      f[0]     = 0.0;
+      f[n - 1] = 0.0;
+
+      for (q = 1; q < n - 1; q++)
+        f[q] = (gdouble) row[q - 1] * row[q - 1];
+
+      k    = 0;
+      v[0] = 0;
+      z[0] = -G_MAXDOUBLE;
+      z[1] = G_MAXDOUBLE;
+
+      for (q = 1; q < n; q++)
+        {
+          gdouble s = shapeburst_intersect (f, q, v[k]);
+
+          while (s <= z[k])
+            {
+              k--;
+              s = shapeburst_intersect (f, q, v[k]);
+            }
+
+          k++;
+          v[k]     = q;
+          z[k]     = s;
+          z[k + 1] = G_MAXDOUBLE;
+        }
+
+      for (q = 1, k = 0; q < n - 1; q++)
+        {
+          gdouble dist;
+          gint    p;
+
+          while (z[k + 1] < q)
+            k++;
+
+          p    = v[k];
+          dist = (gdouble) (q - p) * (q - p) + f[p];
+
+          row[q - 1] = shapeburst_value (src[q - 1], sqrt (dist));
+          max_dist   = MAX (max_dist, row[q - 1]);
+        }
+    }
+
+  shapeburst_update_max (shapeburst, max_dist);
+
+  g_free (f);
+  g_free (z);
+  g_free (v);
+}
+
+/*  the approximate 3-4 chamfer distance in two sequential raster
+ *  scans, cheaper than the exact transform but not parallel.  The
+ *  forward scan goes top down, with edge holding the row above the
+ *  strip.
+ */
+static void
+shapeburst_chamfer_down (const gfloat *src,
+                         gfloat       *dist,
+                         gfloat       *edge,
+                         gint          width,
+                         gint          height)
+{
+  gint x, y;
+
+  for (y = 0; y < height; y++)
+    {
+      const gfloat *s     = src  + (gsize) y * width;
+      gfloat       *d     = dist + (gsize) y * width;
+      const gfloat *above = y > 0 ? d - width : edge;
+
+      for (x = 0; x < width; x++)
+        {
+          gfloat value;
+
+          if (s[x] < SHAPEBURST_EPSILON)
+            {
+              d[x] = 0.0;
+              continue;
+            }
+
+          /*  columns outside roi are background  */
+          value = MIN ((x > 0 ? d[x - 1] : 0.0) + 3.0,
+                       above[x] + 3.0);
+          value = MIN (value, (x > 0         ? above[x - 1] : 0.0) + 4.0);
+          value = MIN (value, (x < width - 1 ? above[x + 1] : 0.0) + 4.0);
+
+          d[x] = value;
+        }
+    }
+
+  memcpy (edge, dist + (gsize) (height - 1) * width, width * sizeof (gfloat));
+}
+
+/*  the backward scan goes bottom up, with edge holding the row below
+ *  the strip, and computes the final values
+ */
+static void
+shapeburst_chamfer_up (Shapeburst *shapeburst,
+                       gfloat     *edge,
+                       gint        height)
+{
+  const gint  width    = shapeburst->width;
+  gfloat      max_dist = 0.0;
+  gint        x, y;
+
+  for (y = height - 1; y >= 0; y--)
+    {
+      const gfloat *s     = shapeburst->src  + (gsize) y * width;
+      gfloat       *d     = shapeburst->dist + (gsize) y * width;
+      gfloat       *below = y < height - 1 ? d + width : edge;
+
+      for (x = width - 1; x >= 0; x--)
+        {
+          gfloat value = d[x];
+
+          value = MIN (value, (x < width - 1 ? d[x + 1] : 0.0) + 3.0);
+          value = MIN (value, below[x] + 3.0);
+          value = MIN (value, (x < width - 1 ? below[x + 1] : 0.0) + 4.0);
+          value = MIN (value, (x > 0         ? below[x - 1] : 0.0) + 4.0);
+
+          d[x] = value;
+        }
+
+      /*  the row below is done with, turn it into values  */
+      if (y < height - 1)
+        {
+          for (x = 0; x < width; x++)
+            {
+              below[x] = shapeburst_value (s[x + width], below[x] / 3.0);
+              max_dist = MAX (max_dist, below[x]);
+            }
+        }
+    }
+
+  memcpy (edge, shapeburst->dist, width * sizeof (gfloat));
+
+  for (x = 0; x < width; x++)
+    {
+      gfloat *d = shapeburst->dist;
+
+      d[x]     = shapeburst_value (shapeburst->src[x], d[x] / 3.0);
+      max_dist = MAX (max_dist, d[x]);
+    }
+
+  shapeburst->max_dist = MAX (shapeburst->max_dist, max_dist);
+}
@@ -41,6 +41,7 @@ struct _GimpOperationShapeburst
   GeglOperationFilter  parent_instance;
 
   gboolean             normalize;
+  gboolean             chamfer;
 };
 
 struct _GimpOperationShapeburstClass
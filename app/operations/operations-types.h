@@ -39,6 +39,7 @@ typedef struct _GimpOperationLayerMode          GimpOperationLayerMode;
 typedef struct _GimpBrightnessContrastConfig    GimpBrightnessContrastConfig;
 typedef struct _GimpCageConfig                  GimpCageConfig;
 typedef struct _GimpColorBalanceConfig          GimpColorBalanceConfig;
+typedef struct _GimpColorChainConfig            GimpColorChainConfig;
 typedef struct _GimpColorizeConfig              GimpColorizeConfig;
 typedef struct _GimpCurvesConfig                GimpCurvesConfig;
 typedef struct _GimpDesaturateConfig            GimpDesaturateConfig;
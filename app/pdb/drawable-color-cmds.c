@@ -23,6 +23,7 @@
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
 
+#include "libgimpconfig/gimpconfig.h"
 #include "libgimpmath/gimpmath.h"
 
 #include "libgimpbase/gimpbase.h"
@@ -37,8 +38,10 @@
 #include "core/gimpdrawable.h"
 #include "core/gimphistogram.h"
 #include "core/gimpparamspecs.h"
+#include "operations/gimp-operation-config.h"
 #include "operations/gimpbrightnesscontrastconfig.h"
 #include "operations/gimpcolorbalanceconfig.h"
+#include "operations/gimpcolorchainconfig.h"
 #include "operations/gimpcolorizeconfig.h"
 #include "operations/gimpcurvesconfig.h"
 #include "operations/gimphuesaturationconfig.h"
@@ -47,6 +50,7 @@
 #include "plug-in/gimppluginmanager.h"
 
 #include "gimppdb.h"
+#include "gimppdberror.h"
 #include "gimppdb-utils.h"
 #include "gimpprocedure.h"
 #include "internal-procs.h"
@@ -150,6 +154,87 @@ drawable_color_balance_invoker (GimpProcedure         *procedure,
                                            error ? *error : NULL);
 }
 
+static GimpValueArray *
+drawable_color_chain_invoker (GimpProcedure         *procedure,
+                              Gimp                  *gimp,
+                              GimpContext           *context,
+                              GimpProgress          *progress,
+                              const GimpValueArray  *args,
+                              GError               **error)
+{
+  gboolean success = TRUE;
+  GimpDrawable *drawable;
+  gint32 num_steps;
+  const gchar **steps;
+
+  drawable = gimp_value_get_drawable (gimp_value_array_index (args, 0), gimp);
+  num_steps = g_value_get_int (gimp_value_array_index (args, 1));
+  steps = gimp_value_get_stringarray (gimp_value_array_index (args, 2));
+
+  if (success)
+    {
+      if (num_steps & 1)
+        {
+          g_set_error_literal (error, GIMP_PDB_ERROR,
+                               GIMP_PDB_ERROR_INVALID_ARGUMENT,
+                               _("The steps of a color chain must be pairs "
+                                 "of an operation name and its settings."));
+          success = FALSE;
+        }
+      else if (gimp_pdb_item_is_attached (GIMP_ITEM (drawable), NULL,
+                                          GIMP_PDB_ITEM_CONTENT, error) &&
+               gimp_pdb_item_is_not_group (GIMP_ITEM (drawable), error))
+        {
+          GObject *config = gimp_color_chain_config_new ();
+          gint     i;
+
+          for (i = 0; success && i < num_steps; i += 2)
+            {
+              const gchar *operation = steps[i];
+              GObject     *step;
+
+              if (! gimp_color_chain_config_is_supported (operation))
+                {
+                  g_set_error (error, GIMP_PDB_ERROR,
+                               GIMP_PDB_ERROR_INVALID_ARGUMENT,
+                               _("Operation '%s' cannot be part of "
+                                 "a color chain."), operation);
+                  success = FALSE;
+                  break;
+                }
+
+              step = g_object_new (gimp_operation_config_get_type (gimp,
+                                                                   operation,
+                                                                   NULL,
+                                                                   GIMP_TYPE_SETTINGS),
+                                   NULL);
+
+              if (gimp_config_deserialize_string (GIMP_CONFIG (step),
+                                                  steps[i + 1], -1,
+                                                  NULL, error))
+                gimp_color_chain_config_add (GIMP_COLOR_CHAIN_CONFIG (config),
+                                             operation, step);
+              else
+                success = FALSE;
+
+              g_object_unref (step);
+            }
+
+          if (success)
+            gimp_drawable_apply_operation_by_name (drawable, progress,
+                                                   C_("undo-type", "Color Chain"),
+                                                   "gimp:color-chain",
+                                                   config);
+          g_object_unref (config);
+        }
+      else
+        success = FALSE;
+    }
+
+  return gimp_procedure_get_return_values (procedure, success,
+                                           error ? *error : NULL);
+}
+
 static GimpValueArray *
 drawable_colorize_hsl_invoker (GimpProcedure         *procedure,
                                Gimp                  *gimp,
@@ -819,6 +904,40 @@ register_drawable_color_procs (GimpPDB *pdb)
   gimp_pdb_register_procedure (pdb, procedure);
   g_object_unref (procedure);
 
+  /*
+   * gimp-drawable-color-chain
+   */
+  procedure = gimp_procedure_new (drawable_color_chain_invoker);
+  gimp_object_set_static_name (GIMP_OBJECT (procedure),
+                               "gimp-drawable-color-chain");
+  gimp_procedure_set_static_strings (procedure,
+                                     "gimp-drawable-color-chain",
+                                     "Applies a chain of color adjustments to the specified drawable in one pass.",
+                                     "This procedure applies a sequence of color adjustments to the specified drawable. The 'steps' parameter is an array of strings which holds pairs of an operation name and its settings, serialized the way they are stored in the tools' settings files, like { \"gimp:levels\", \"(gamma 1.2)\", \"gimp:curves\", \"...\", ... }. Supported operations are gimp:brightness-contrast, gimp:color-balance, gimp:colorize, gimp:curves, gimp:hue-saturation and gimp:levels. The chain is compiled into lookup tables and applied in a single pass over the drawable, giving the same result as applying the adjustments one by one within the precision of the tables.",
+                                     "The GIMP Team",
+                                     "The GIMP Team",
+                                     "2026",
+                                     NULL);
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_drawable_id ("drawable",
+                                                            "drawable",
+                                                            "The drawable",
+                                                            pdb->gimp, FALSE,
+                                                            GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_int32 ("num-steps",
+                                                      "num steps",
+                                                      "The number of strings in the steps array",
+                                                      0, G_MAXINT32, 0,
+                                                      GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_string_array ("steps",
+                                                             "steps",
+                                                             "The chain: { operation1, settings1, operation2, settings2, ... }",
+                                                             GIMP_PARAM_READWRITE));
+  gimp_pdb_register_procedure (pdb, procedure);
+  g_object_unref (procedure);
+
   /*
    * gimp-drawable-colorize-hsl
    */
@@ -19,6 +19,8 @@
 
 #include "config.h"
 
+#include <cairo.h>
+
 #include <gegl.h>
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
@@ -36,7 +38,9 @@
 #include "core/gimpchannel.h"
 #include "core/gimpdrawable-blend.h"
 #include "core/gimpdrawable-bucket-fill.h"
+#include "core/gimpdrawable-stroke.h"
 #include "core/gimpdrawable.h"
+#include "core/gimpimage-undo.h"
 #include "core/gimpimage.h"
 #include "core/gimplayer.h"
 #include "core/gimpparamspecs.h"
@@ -927,6 +931,108 @@ edit_stroke_vectors_invoker (GimpProcedure         *procedure,
                                            error ? *error : NULL);
 }
 
+static GimpValueArray *
+edit_stroke_visible_vectors_invoker (GimpProcedure         *procedure,
+                                     Gimp                  *gimp,
+                                     GimpContext           *context,
+                                     GimpProgress          *progress,
+                                     const GimpValueArray  *args,
+                                     GError               **error)
+{
+  gboolean success = TRUE;
+  GimpDrawable *drawable;
+
+  drawable = gimp_value_get_drawable (gimp_value_array_index (args, 0), gimp);
+
+  if (success)
+    {
+      if (gimp_pdb_item_is_attached (GIMP_ITEM (drawable), NULL,
+                                     GIMP_PDB_ITEM_CONTENT, error) &&
+          gimp_pdb_item_is_not_group (GIMP_ITEM (drawable), error))
+        {
+          GimpImage         *image = gimp_item_get_image (GIMP_ITEM (drawable));
+          GimpStrokeOptions *options;
+          GimpPaintOptions  *paint_options;
+          GList             *all_vectors;
+          GList             *visible = NULL;
+          GList             *list;
+
+          all_vectors = gimp_image_get_vectors_list (image);
+
+          for (list = all_vectors; list; list = g_list_next (list))
+            {
+              const GimpBezierDesc *bezier;
+
+              if (gimp_viewable_get_children (list->data) ||
+                  ! gimp_item_is_visible (list->data))
+                continue;
+
+              /*  skip the paths which have too few points to be stroked,
+               *  like gimp_drawable_stroke_vectors_list() does
+               */
+              bezier = gimp_vectors_get_bezier (list->data);
+
+              if (bezier && bezier->num_data >= 2)
+                visible = g_list_prepend (visible, list->data);
+            }
+
+          g_list_free (all_vectors);
+
+          visible = g_list_reverse (visible);
+
+          options = gimp_pdb_context_get_stroke_options (GIMP_PDB_CONTEXT (context));
+
+          paint_options =
+            gimp_pdb_context_get_paint_options (GIMP_PDB_CONTEXT (context), NULL);
+          paint_options = gimp_config_duplicate (GIMP_CONFIG (paint_options));
+
+          if (! visible)
+            {
+              /*  nothing to do  */
+            }
+          else if (gimp_stroke_options_get_method (options) == GIMP_STROKE_LINE)
+            {
+              /*  all paths go into one scan conversion, so overlapping
+               *  strokes are rendered and pushed to the undo stack once
+               */
+              gimp_stroke_options_prepare (options, context, paint_options);
+
+              gimp_image_undo_group_start (image, GIMP_UNDO_GROUP_PAINT,
+                                           C_("undo-type", "Stroke Path"));
+
+              success = gimp_drawable_stroke_vectors_list (drawable, options,
+                                                           visible, TRUE,
+                                                           error);
+
+              gimp_image_undo_group_end (image);
+
+              gimp_stroke_options_finish (options);
+            }
+          else
+            {
+              gimp_image_undo_group_start (image, GIMP_UNDO_GROUP_PAINT,
+                                           C_("undo-type", "Stroke Path"));
+
+              for (list = visible; list && success; list = g_list_next (list))
+                success = gimp_item_stroke (list->data,
+                                            drawable, context,
+                                            options, paint_options,
+                                            TRUE, progress, error);
+
+              gimp_image_undo_group_end (image);
+            }
+
+          g_list_free (visible);
+          g_object_unref (paint_options);
+        }
+      else
+        success = FALSE;
+    }
+
+  return gimp_procedure_get_return_values (procedure, success,
+                                           error ? *error : NULL);
+}
+
 void
 register_edit_procs (GimpPDB *pdb)
 {
@@ -1628,4 +1734,27 @@ register_edit_procs (GimpPDB *pdb)
                                                            GIMP_PARAM_READWRITE));
   gimp_pdb_register_procedure (pdb, procedure);
   g_object_unref (procedure);
+
+  /*
+   * gimp-edit-stroke-visible-vectors
+   */
+  procedure = gimp_procedure_new (edit_stroke_visible_vectors_invoker);
+  gimp_object_set_static_name (GIMP_OBJECT (procedure),
+                               "gimp-edit-stroke-visible-vectors");
+  gimp_procedure_set_static_strings (procedure,
+                                     "gimp-edit-stroke-visible-vectors",
+                                     "Stroke all visible vectors objects",
+                                     "This procedure strokes all visible vectors objects of the drawable's image in one step. When stroking with a line, all paths are rendered together, so overlapping strokes are painted only once. Paths without enough points to stroke are skipped.",
+                                     "The GIMP Team",
+                                     "The GIMP Team",
+                                     "2026",
+                                     NULL);
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_drawable_id ("drawable",
+                                                            "drawable",
+                                                            "The drawable to stroke to",
+                                                            pdb->gimp, FALSE,
+                                                            GIMP_PARAM_READWRITE));
+  gimp_pdb_register_procedure (pdb, procedure);
+  g_object_unref (procedure);
 }
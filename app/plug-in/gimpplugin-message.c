@@ -46,6 +46,7 @@
 #include "gimpplugin-cleanup.h"
 #include "gimpplugin-message.h"
 #include "gimppluginmanager.h"
+#include "gimppluginmanager-pool.h"
 #include "gimpplugindef.h"
 #include "gimppluginshm.h"
 #include "gimptemporaryprocedure.h"
@@ -63,6 +64,10 @@ static void gimp_plug_in_handle_tile_put         (GimpPlugIn      *plug_in,
                                                   GPTileReq       *request);
 static void gimp_plug_in_handle_tile_get         (GimpPlugIn      *plug_in,
                                                   GPTileReq       *request);
+static void gimp_plug_in_handle_region_request   (GimpPlugIn      *plug_in,
+                                                  GPRegionReq     *request);
+static void gimp_plug_in_handle_region_data      (GimpPlugIn      *plug_in,
+                                                  GPRegionData    *region_data);
 static void gimp_plug_in_handle_proc_run         (GimpPlugIn      *plug_in,
                                                   GPProcRun       *proc_run);
 static void gimp_plug_in_handle_proc_return      (GimpPlugIn      *plug_in,
@@ -160,6 +165,14 @@ gimp_plug_in_handle_message (GimpPlugIn      *plug_in,
     case GP_HAS_INIT:
       gimp_plug_in_handle_has_init (plug_in);
       break;
+
+    case GP_REGION_REQ:
+      gimp_plug_in_handle_region_request (plug_in, msg->data);
+      break;
+
+    case GP_REGION_DATA:
+      gimp_plug_in_handle_region_data (plug_in, msg->data);
+      break;
     }
 }
 
@@ -469,6 +482,198 @@ gimp_plug_in_handle_tile_get (GimpPlugIn *plug_in,
   gimp_wire_destroy (&msg);
 }
 
+/*  looks up the buffer a region message refers to, doing the same
+ *  checks as the tile requests do, and closes the plug-in if they fail
+ */
+static GeglBuffer *
+gimp_plug_in_get_region_buffer (GimpPlugIn           *plug_in,
+                                gint32                drawable_ID,
+                                gboolean              shadow,
+                                gboolean              write,
+                                const GeglRectangle  *rect,
+                                const Babl          **format)
+{
+  GimpDrawable *drawable;
+  GeglBuffer   *buffer;
+
+  drawable = (GimpDrawable *) gimp_item_get_by_ID (plug_in->manager->gimp,
+                                                   drawable_ID);
+
+  if (! GIMP_IS_DRAWABLE (drawable))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "tried accessing invalid drawable %d (killing)",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file),
+                    drawable_ID);
+      gimp_plug_in_close (plug_in, TRUE);
+      return NULL;
+    }
+  else if (gimp_item_is_removed (GIMP_ITEM (drawable)))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "tried accessing drawable %d which was removed "
+                    "from the image (killing)",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file),
+                    drawable_ID);
+      gimp_plug_in_close (plug_in, TRUE);
+      return NULL;
+    }
+
+  if (shadow)
+    {
+      buffer = gimp_drawable_get_shadow_buffer (drawable);
+
+      gimp_plug_in_cleanup_add_shadow (plug_in, drawable);
+    }
+  else
+    {
+      if (write && gimp_item_is_content_locked (GIMP_ITEM (drawable)))
+        {
+          gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                        "Plug-in \"%s\"\n(%s)\n\n"
+                        "tried writing to a locked drawable %d (killing)",
+                        gimp_object_get_name (plug_in),
+                        gimp_file_get_utf8_name (plug_in->file),
+                        drawable_ID);
+          gimp_plug_in_close (plug_in, TRUE);
+          return NULL;
+        }
+      else if (write && gimp_viewable_get_children (GIMP_VIEWABLE (drawable)))
+        {
+          gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                        "Plug-in \"%s\"\n(%s)\n\n"
+                        "tried writing to a group layer %d (killing)",
+                        gimp_object_get_name (plug_in),
+                        gimp_file_get_utf8_name (plug_in->file),
+                        drawable_ID);
+          gimp_plug_in_close (plug_in, TRUE);
+          return NULL;
+        }
+
+      buffer = gimp_drawable_get_buffer (drawable);
+    }
+
+  if (rect->width  <= 0 || rect->height <= 0 ||
+      rect->x < 0 || rect->x + rect->width  > gegl_buffer_get_width  (buffer) ||
+      rect->y < 0 || rect->y + rect->height > gegl_buffer_get_height (buffer))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "requested invalid region (killing)",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file));
+      gimp_plug_in_close (plug_in, TRUE);
+      return NULL;
+    }
+
+  *format = gegl_buffer_get_format (buffer);
+
+  if (! gimp_plug_in_precision_enabled (plug_in))
+    {
+      *format = gimp_babl_compat_u8_format (*format);
+    }
+
+  return buffer;
+}
+
+static void
+gimp_plug_in_handle_region_request (GimpPlugIn  *plug_in,
+                                    GPRegionReq *request)
+{
+  GPRegionData   region_data;
+  GeglBuffer    *buffer;
+  const Babl    *format;
+  GeglRectangle  rect;
+
+  g_return_if_fail (request != NULL);
+
+  rect.x      = request->x;
+  rect.y      = request->y;
+  rect.width  = request->width;
+  rect.height = request->height;
+
+  buffer = gimp_plug_in_get_region_buffer (plug_in,
+                                           request->drawable_ID,
+                                           request->shadow, FALSE,
+                                           &rect, &format);
+  if (! buffer)
+    return;
+
+  region_data.drawable_ID = request->drawable_ID;
+  region_data.shadow      = request->shadow;
+  region_data.x           = rect.x;
+  region_data.y           = rect.y;
+  region_data.width       = rect.width;
+  region_data.height      = rect.height;
+  region_data.bpp         = babl_format_get_bytes_per_pixel (format);
+  region_data.data        = g_malloc ((gsize) region_data.bpp *
+                                      rect.width * rect.height);
+
+  gegl_buffer_get (buffer, &rect, 1.0, format,
+                   region_data.data,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  if (! gp_region_data_write (plug_in->my_write, &region_data, plug_in))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "%s: ERROR", G_STRFUNC);
+      gimp_plug_in_close (plug_in, TRUE);
+    }
+
+  g_free (region_data.data);
+}
+
+static void
+gimp_plug_in_handle_region_data (GimpPlugIn   *plug_in,
+                                 GPRegionData *region_data)
+{
+  GeglBuffer    *buffer;
+  const Babl    *format;
+  GeglRectangle  rect;
+
+  g_return_if_fail (region_data != NULL);
+
+  rect.x      = region_data->x;
+  rect.y      = region_data->y;
+  rect.width  = region_data->width;
+  rect.height = region_data->height;
+
+  buffer = gimp_plug_in_get_region_buffer (plug_in,
+                                           region_data->drawable_ID,
+                                           region_data->shadow, TRUE,
+                                           &rect, &format);
+  if (! buffer)
+    return;
+
+  if (region_data->bpp != babl_format_get_bytes_per_pixel (format) ||
+      ! region_data->data)
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "sent region data in the wrong format (killing)",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file));
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  gegl_buffer_set (buffer, &rect, 0, format,
+                   region_data->data,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  if (! gp_tile_ack_write (plug_in->my_write, plug_in))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "%s: ERROR", G_STRFUNC);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+}
+
 static void
 gimp_plug_in_handle_proc_error (GimpPlugIn          *plug_in,
                                 GimpPlugInProcFrame *proc_frame,
@@ -655,6 +860,19 @@ gimp_plug_in_handle_proc_return (GimpPlugIn   *plug_in,
     {
       g_main_loop_quit (proc_frame->main_loop);
     }
+  else if (proc_frame->return_func)
+    {
+      GimpPlugInReturnFunc  return_func = proc_frame->return_func;
+      GimpValueArray       *return_vals;
+
+      proc_frame->return_func = NULL;
+
+      return_vals = gimp_plug_in_proc_frame_get_return_values (proc_frame);
+
+      return_func (return_vals, proc_frame->return_data);
+
+      gimp_value_array_unref (return_vals);
+    }
   else
     {
       /*  the plug-in is run asynchronously, so display its error
@@ -666,7 +884,17 @@ gimp_plug_in_handle_proc_return (GimpPlugIn   *plug_in,
                                                    proc_frame->return_vals);
     }
 
-  gimp_plug_in_close (plug_in, FALSE);
+  if (! plug_in->persistent)
+    {
+      gimp_plug_in_close (plug_in, FALSE);
+    }
+  else if (! proc_frame->main_loop)
+    {
+      /*  a synchronous caller returns the plug-in to the pool itself,
+       *  after it fetched the return values from the proc frame
+       */
+      gimp_plug_in_manager_pool_release (plug_in->manager, plug_in);
+    }
 }
 
 static void
@@ -89,6 +89,7 @@
 #include "gimppluginmanager.h"
 #include "gimppluginmanager-help-domain.h"
 #include "gimppluginmanager-locale-domain.h"
+#include "gimppluginmanager-pool.h"
 #include "gimptemporaryprocedure.h"
 #include "plug-in-params.h"
 
@@ -161,6 +162,8 @@ gimp_plug_in_init (GimpPlugIn *plug_in)
   plug_in->temp_proc_frames   = NULL;
 
   plug_in->plug_in_def        = NULL;
+
+  plug_in->idle_time          = 0;
 }
 
 static void
@@ -552,6 +555,27 @@ gimp_plug_in_close (GimpPlugIn *plug_in,
       g_main_loop_quit (plug_in->main_proc_frame.main_loop);
     }
 
+  if (plug_in->main_proc_frame.return_func)
+    {
+      GimpPlugInProcFrame  *proc_frame  = &plug_in->main_proc_frame;
+      GimpPlugInReturnFunc  return_func = proc_frame->return_func;
+      GimpValueArray       *return_vals;
+
+#ifdef GIMP_UNSTABLE
+      g_printerr ("plug-in '%s' aborted before sending its "
+                  "procedure return values\n",
+                  gimp_object_get_name (plug_in));
+#endif
+
+      proc_frame->return_func = NULL;
+
+      return_vals = gimp_plug_in_proc_frame_get_return_values (proc_frame);
+
+      return_func (return_vals, proc_frame->return_data);
+
+      gimp_value_array_unref (return_vals);
+    }
+
   if (plug_in->ext_main_loop &&
       g_main_loop_is_running (plug_in->ext_main_loop))
     {
@@ -568,6 +592,7 @@ gimp_plug_in_close (GimpPlugIn *plug_in,
   while (plug_in->temp_procedures)
     gimp_plug_in_remove_temp_proc (plug_in, plug_in->temp_procedures->data);
 
+  gimp_plug_in_manager_pool_remove (plug_in->manager, plug_in);
   gimp_plug_in_manager_remove_open_plug_in (plug_in->manager, plug_in);
 }
 
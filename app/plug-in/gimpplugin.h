@@ -48,6 +48,7 @@ struct _GimpPlugIn
   guint                open : 1;        /*  Is the plug-in open?              */
   guint                hup : 1;         /*  Did we receive a G_IO_HUP         */
   guint                precision : 1;   /*  True drawable precision enabled   */
+  guint                persistent : 1;  /*  Stays alive after its run         */
   GPid                 pid;             /*  Plug-in's process id              */
 
   GIOChannel          *my_read;         /*  App's read and write channels     */
@@ -69,6 +70,8 @@ struct _GimpPlugIn
   GList               *temp_proc_frames;
 
   GimpPlugInDef       *plug_in_def;     /*  Valid during query() and init()   */
+
+  gint64               idle_time;       /*  When it was put into the pool     */
 };
 
 struct _GimpPlugInClass
@@ -46,6 +46,7 @@
 #include "gimppluginmanager.h"
 #define __YES_I_NEED_GIMP_PLUG_IN_MANAGER_CALL__
 #include "gimppluginmanager-call.h"
+#include "gimppluginmanager-pool.h"
 #include "gimppluginshm.h"
 #include "gimptemporaryprocedure.h"
 #include "plug-in-params.h"
@@ -53,6 +54,18 @@
 #include "gimp-intl.h"
 
 
+static GimpValueArray *
+gimp_plug_in_manager_call_run_internal (GimpPlugInManager    *manager,
+                                        GimpContext          *context,
+                                        GimpProgress         *progress,
+                                        GimpPlugInProcedure  *procedure,
+                                        GimpValueArray       *args,
+                                        gboolean              synchronous,
+                                        GimpObject           *display,
+                                        GimpPlugInReturnFunc  return_func,
+                                        gpointer              return_data);
+
+
 static void
 gimp_allow_set_foreground_window (GimpPlugIn *plug_in)
 {
@@ -63,16 +76,19 @@ gimp_allow_set_foreground_window (GimpPlugIn *plug_in)
 
 /*  public functions  */
 
-void
-gimp_plug_in_manager_call_query (GimpPlugInManager *manager,
-                                 GimpContext       *context,
-                                 GimpPlugInDef     *plug_in_def)
+GimpPlugIn *
+gimp_plug_in_manager_call_start (GimpPlugInManager  *manager,
+                                 GimpContext        *context,
+                                 GimpPlugInDef      *plug_in_def,
+                                 GimpPlugInCallMode  call_mode)
 {
   GimpPlugIn *plug_in;
 
-  g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
-  g_return_if_fail (GIMP_IS_PDB_CONTEXT (context));
-  g_return_if_fail (GIMP_IS_PLUG_IN_DEF (plug_in_def));
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager), NULL);
+  g_return_val_if_fail (GIMP_IS_PDB_CONTEXT (context), NULL);
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_DEF (plug_in_def), NULL);
+  g_return_val_if_fail (call_mode == GIMP_PLUG_IN_CALL_QUERY ||
+                        call_mode == GIMP_PLUG_IN_CALL_INIT, NULL);
 
   plug_in = gimp_plug_in_new (manager, context, NULL,
                               NULL, plug_in_def->file);
@@ -81,66 +97,36 @@ gimp_plug_in_manager_call_query (GimpPlugInManager *manager,
     {
       plug_in->plug_in_def = plug_in_def;
 
-      if (gimp_plug_in_open (plug_in, GIMP_PLUG_IN_CALL_QUERY, TRUE))
-        {
-          while (plug_in->open)
-            {
-              GimpWireMessage msg;
-
-              if (! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
-                {
-                  gimp_plug_in_close (plug_in, TRUE);
-                }
-              else
-                {
-                  gimp_plug_in_handle_message (plug_in, &msg);
-                  gimp_wire_destroy (&msg);
-                }
-            }
-        }
-
-      g_object_unref (plug_in);
+      if (! gimp_plug_in_open (plug_in, call_mode, TRUE))
+        g_clear_object (&plug_in);
     }
+
+  return plug_in;
 }
 
-void
-gimp_plug_in_manager_call_init (GimpPlugInManager *manager,
-                                GimpContext       *context,
-                                GimpPlugInDef     *plug_in_def)
+gboolean
+gimp_plug_in_manager_call_dispatch (GimpPlugInManager *manager,
+                                    GimpPlugIn        *plug_in)
 {
-  GimpPlugIn *plug_in;
+  GimpWireMessage msg;
 
-  g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
-  g_return_if_fail (GIMP_IS_PDB_CONTEXT (context));
-  g_return_if_fail (GIMP_IS_PLUG_IN_DEF (plug_in_def));
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager), FALSE);
+  g_return_val_if_fail (GIMP_IS_PLUG_IN (plug_in), FALSE);
 
-  plug_in = gimp_plug_in_new (manager, context, NULL,
-                              NULL, plug_in_def->file);
+  if (! plug_in->open)
+    return FALSE;
 
-  if (plug_in)
+  if (! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
     {
-      plug_in->plug_in_def = plug_in_def;
-
-      if (gimp_plug_in_open (plug_in, GIMP_PLUG_IN_CALL_INIT, TRUE))
-        {
-          while (plug_in->open)
-            {
-              GimpWireMessage msg;
-
-              if (! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
-                {
-                  gimp_plug_in_close (plug_in, TRUE);
-                }
-              else
-                {
-                  gimp_plug_in_handle_message (plug_in, &msg);
-                  gimp_wire_destroy (&msg);
-                }
-            }
-        }
-
-      g_object_unref (plug_in);
+      gimp_plug_in_close (plug_in, TRUE);
+    }
+  else
+    {
+      gimp_plug_in_handle_message (plug_in, &msg);
+      gimp_wire_destroy (&msg);
     }
+
+  return plug_in->open;
 }
 
 GimpValueArray *
@@ -151,6 +137,48 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
                                GimpValueArray      *args,
                                gboolean             synchronous,
                                GimpObject          *display)
+{
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager), NULL);
+  g_return_val_if_fail (GIMP_IS_PDB_CONTEXT (context), NULL);
+  g_return_val_if_fail (progress == NULL || GIMP_IS_PROGRESS (progress), NULL);
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_PROCEDURE (procedure), NULL);
+  g_return_val_if_fail (args != NULL, NULL);
+  g_return_val_if_fail (display == NULL || GIMP_IS_OBJECT (display), NULL);
+
+  return gimp_plug_in_manager_call_run_internal (manager, context, progress,
+                                                 procedure, args,
+                                                 synchronous, display,
+                                                 NULL, NULL);
+}
+
+GimpValueArray *
+gimp_plug_in_manager_call_run_async (GimpPlugInManager    *manager,
+                                     GimpContext          *context,
+                                     GimpProgress         *progress,
+                                     GimpPlugInProcedure  *procedure,
+                                     GimpValueArray       *args,
+                                     GimpPlugInReturnFunc  return_func,
+                                     gpointer              return_data)
+{
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager), NULL);
+  g_return_val_if_fail (GIMP_IS_PDB_CONTEXT (context), NULL);
+  g_return_val_if_fail (progress == NULL || GIMP_IS_PROGRESS (progress), NULL);
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_PROCEDURE (procedure), NULL);
+  g_return_val_if_fail (args != NULL, NULL);
+  g_return_val_if_fail (return_func != NULL, NULL);
+
+  return gimp_plug_in_manager_call_run_internal (manager, context, progress,
+                                                 procedure, args,
+                                                 FALSE, NULL,
+                                                 return_func, return_data);
+}
+
+GimpValueArray *
+gimp_plug_in_manager_call_run_temp (GimpPlugInManager      *manager,
+                                    GimpContext            *context,
+                                    GimpProgress           *progress,
+                                    GimpTemporaryProcedure *procedure,
+                                    GimpValueArray         *args)
 {
   GimpValueArray *return_vals = NULL;
   GimpPlugIn     *plug_in;
@@ -158,11 +186,89 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
   g_return_val_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager), NULL);
   g_return_val_if_fail (GIMP_IS_PDB_CONTEXT (context), NULL);
   g_return_val_if_fail (progress == NULL || GIMP_IS_PROGRESS (progress), NULL);
-  g_return_val_if_fail (GIMP_IS_PLUG_IN_PROCEDURE (procedure), NULL);
+  g_return_val_if_fail (GIMP_IS_TEMPORARY_PROCEDURE (procedure), NULL);
   g_return_val_if_fail (args != NULL, NULL);
-  g_return_val_if_fail (display == NULL || GIMP_IS_OBJECT (display), NULL);
 
-  plug_in = gimp_plug_in_new (manager, context, progress, procedure, NULL);
+  plug_in = procedure->plug_in;
+
+  if (plug_in)
+    {
+      GimpPlugInProcFrame *proc_frame;
+      GPProcRun            proc_run;
+
+      proc_frame = gimp_plug_in_proc_frame_push (plug_in, context, progress,
+                                                 procedure);
+
+      proc_run.name    = GIMP_PROCEDURE (procedure)->original_name;
+      proc_run.nparams = gimp_value_array_length (args);
+      proc_run.params  = plug_in_args_to_params (args, FALSE);
+
+      if (! gp_temp_proc_run_write (plug_in->my_write, &proc_run, plug_in) ||
+          ! gimp_wire_flush (plug_in->my_write, plug_in))
+        {
+          const gchar *name  = gimp_object_get_name (plug_in);
+          GError      *error = g_error_new (GIMP_PLUG_IN_ERROR,
+                                            GIMP_PLUG_IN_EXECUTION_FAILED,
+                                            _("Failed to run plug-in \"%s\""),
+                                            name);
+
+          g_free (proc_run.params);
+          gimp_plug_in_proc_frame_pop (plug_in);
+
+          return_vals = gimp_procedure_get_return_values (GIMP_PROCEDURE (procedure),
+                                                          FALSE, error);
+          g_error_free (error);
+
+          return return_vals;
+        }
+      gimp_allow_set_foreground_window (plug_in);
+
+      g_free (proc_run.params);
+
+      g_object_ref (plug_in);
+      gimp_plug_in_proc_frame_ref (proc_frame);
+
+      gimp_plug_in_main_loop (plug_in);
+
+      /*  main_loop is quit and proc_frame is popped in
+       *  gimp_plug_in_handle_temp_proc_return()
+       */
+
+      return_vals = gimp_plug_in_proc_frame_get_return_values (proc_frame);
+
+      gimp_plug_in_proc_frame_unref (proc_frame, plug_in);
+      g_object_unref (plug_in);
+    }
+
+  return return_vals;
+}
+
+
+/*  private functions  */
+
+static GimpValueArray *
+gimp_plug_in_manager_call_run_internal (GimpPlugInManager    *manager,
+                                        GimpContext          *context,
+                                        GimpProgress         *progress,
+                                        GimpPlugInProcedure  *procedure,
+                                        GimpValueArray       *args,
+                                        gboolean              synchronous,
+                                        GimpObject           *display,
+                                        GimpPlugInReturnFunc  return_func,
+                                        gpointer              return_data)
+{
+  GimpValueArray *return_vals = NULL;
+  GimpPlugIn     *plug_in     = NULL;
+  gboolean        persistent;
+
+  persistent = gimp_plug_in_manager_pool_can_run (manager, procedure, args);
+
+  if (persistent)
+    plug_in = gimp_plug_in_manager_pool_acquire (manager, context, progress,
+                                                 procedure);
+
+  if (! plug_in)
+    plug_in = gimp_plug_in_new (manager, context, progress, procedure, NULL);
 
   if (plug_in)
     {
@@ -176,7 +282,8 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
       GObject           *screen;
       gint               monitor;
 
-      if (! gimp_plug_in_open (plug_in, GIMP_PLUG_IN_CALL_RUN, FALSE))
+      if (! plug_in->open &&
+          ! gimp_plug_in_open (plug_in, GIMP_PLUG_IN_CALL_RUN, FALSE))
         {
           const gchar *name  = gimp_object_get_name (plug_in);
           GError      *error = g_error_new (GIMP_PLUG_IN_ERROR,
@@ -206,7 +313,7 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
                                  gui_config->show_help_button);
       config.use_cpu_accel    = manager->gimp->use_cpu_accel;
       config.use_opencl       = gegl_config->use_opencl;
-      config.gimp_reserved_6  = 0;
+      config.persistent       = persistent;
       config.gimp_reserved_7  = 0;
       config.gimp_reserved_8  = 0;
       config.install_cmap     = FALSE;
@@ -221,6 +328,8 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
       config.monitor_number   = monitor;
       config.timestamp        = gimp_get_user_time (manager->gimp);
 
+      plug_in->persistent = persistent;
+
       proc_run.name    = GIMP_PROCEDURE (procedure)->original_name;
       proc_run.nparams = gimp_value_array_length (args);
       proc_run.params  = plug_in_args_to_params (args, FALSE);
@@ -238,6 +347,9 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
           g_free (config.display_name);
           g_free (proc_run.params);
 
+          if (plug_in->open)
+            gimp_plug_in_close (plug_in, TRUE);
+
           g_object_unref (plug_in);
 
           return_vals = gimp_procedure_get_return_values (GIMP_PROCEDURE (procedure),
@@ -250,6 +362,13 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
       g_free (config.display_name);
       g_free (proc_run.params);
 
+      /*  from now on, the plug-in owes us its return values, which
+       *  gimp_plug_in_handle_proc_return() or gimp_plug_in_close()
+       *  pass on to return_func
+       */
+      plug_in->main_proc_frame.return_func = return_func;
+      plug_in->main_proc_frame.return_data = return_data;
+
       /* If this is an extension,
        * wait for an installation-confirmation message
        */
@@ -284,79 +403,18 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
           g_clear_pointer (&proc_frame->main_loop, g_main_loop_unref);
 
           return_vals = gimp_plug_in_proc_frame_get_return_values (proc_frame);
+
+          if (plug_in->persistent)
+            gimp_plug_in_manager_pool_release (manager, plug_in);
         }
 
       g_object_unref (plug_in);
     }
-
-  return return_vals;
-}
-
-GimpValueArray *
-gimp_plug_in_manager_call_run_temp (GimpPlugInManager      *manager,
-                                    GimpContext            *context,
-                                    GimpProgress           *progress,
-                                    GimpTemporaryProcedure *procedure,
-                                    GimpValueArray         *args)
-{
-  GimpValueArray *return_vals = NULL;
-  GimpPlugIn     *plug_in;
-
-  g_return_val_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager), NULL);
-  g_return_val_if_fail (GIMP_IS_PDB_CONTEXT (context), NULL);
-  g_return_val_if_fail (progress == NULL || GIMP_IS_PROGRESS (progress), NULL);
-  g_return_val_if_fail (GIMP_IS_TEMPORARY_PROCEDURE (procedure), NULL);
-  g_return_val_if_fail (args != NULL, NULL);
-
-  plug_in = procedure->plug_in;
-
-  if (plug_in)
+  else if (return_func)
     {
-      GimpPlugInProcFrame *proc_frame;
-      GPProcRun            proc_run;
-
-      proc_frame = gimp_plug_in_proc_frame_push (plug_in, context, progress,
-                                                 procedure);
-
-      proc_run.name    = GIMP_PROCEDURE (procedure)->original_name;
-      proc_run.nparams = gimp_value_array_length (args);
-      proc_run.params  = plug_in_args_to_params (args, FALSE);
-
-      if (! gp_temp_proc_run_write (plug_in->my_write, &proc_run, plug_in) ||
-          ! gimp_wire_flush (plug_in->my_write, plug_in))
-        {
-          const gchar *name  = gimp_object_get_name (plug_in);
-          GError      *error = g_error_new (GIMP_PLUG_IN_ERROR,
-                                            GIMP_PLUG_IN_EXECUTION_FAILED,
-                                            _("Failed to run plug-in \"%s\""),
-                                            name);
-
-          g_free (proc_run.params);
-          gimp_plug_in_proc_frame_pop (plug_in);
-
-          return_vals = gimp_procedure_get_return_values (GIMP_PROCEDURE (procedure),
-                                                          FALSE, error);
-          g_error_free (error);
-
-          return return_vals;
-        }
-      gimp_allow_set_foreground_window (plug_in);
-
-      g_free (proc_run.params);
-
-      g_object_ref (plug_in);
-      gimp_plug_in_proc_frame_ref (proc_frame);
-
-      gimp_plug_in_main_loop (plug_in);
-
-      /*  main_loop is quit and proc_frame is popped in
-       *  gimp_plug_in_handle_temp_proc_return()
-       */
-
-      return_vals = gimp_plug_in_proc_frame_get_return_values (proc_frame);
-
-      gimp_plug_in_proc_frame_unref (proc_frame, plug_in);
-      g_object_unref (plug_in);
+      /*  an asynchronous caller needs to know it won't get called  */
+      return_vals = gimp_procedure_get_return_values (GIMP_PROCEDURE (procedure),
+                                                      FALSE, NULL);
     }
 
   return return_vals;
@@ -25,35 +25,50 @@
 #endif
 
 
-/*  Call the plug-in's query() function
+/*  Start a plug-in's query() or init() function without waiting for
+ *  it, returns the open plug-in or NULL
  */
-void             gimp_plug_in_manager_call_query    (GimpPlugInManager      *manager,
-                                                     GimpContext            *context,
-                                                     GimpPlugInDef          *plug_in_def);
+GimpPlugIn     * gimp_plug_in_manager_call_start     (GimpPlugInManager      *manager,
+                                                      GimpContext            *context,
+                                                      GimpPlugInDef          *plug_in_def,
+                                                      GimpPlugInCallMode      call_mode);
 
-/*  Call the plug-in's init() function
+/*  Read and handle one message of a plug-in opened with
+ *  gimp_plug_in_manager_call_start(), returns FALSE once it is closed
  */
-void             gimp_plug_in_manager_call_init     (GimpPlugInManager      *manager,
-                                                     GimpContext            *context,
-                                                     GimpPlugInDef          *plug_in_def);
+gboolean         gimp_plug_in_manager_call_dispatch  (GimpPlugInManager      *manager,
+                                                      GimpPlugIn             *plug_in);
 
 /*  Run a plug-in as if it were a procedure database procedure
  */
-GimpValueArray * gimp_plug_in_manager_call_run      (GimpPlugInManager      *manager,
-                                                     GimpContext            *context,
-                                                     GimpProgress           *progress,
-                                                     GimpPlugInProcedure    *procedure,
-                                                     GimpValueArray         *args,
-                                                     gboolean                synchronous,
-                                                     GimpObject             *display);
+GimpValueArray * gimp_plug_in_manager_call_run       (GimpPlugInManager      *manager,
+                                                      GimpContext            *context,
+                                                      GimpProgress           *progress,
+                                                      GimpPlugInProcedure    *procedure,
+                                                      GimpValueArray         *args,
+                                                      gboolean                synchronous,
+                                                      GimpObject             *display);
+
+/*  Run a plug-in without waiting for it, and call return_func with
+ *  its return values once it finished. Returns the return values
+ *  right away, without calling return_func, if the plug-in could not
+ *  be started.
+ */
+GimpValueArray * gimp_plug_in_manager_call_run_async (GimpPlugInManager      *manager,
+                                                      GimpContext            *context,
+                                                      GimpProgress           *progress,
+                                                      GimpPlugInProcedure    *procedure,
+                                                      GimpValueArray         *args,
+                                                      GimpPlugInReturnFunc    return_func,
+                                                      gpointer                return_data);
 
 /*  Run a temp plug-in proc as if it were a procedure database procedure
  */
-GimpValueArray * gimp_plug_in_manager_call_run_temp (GimpPlugInManager      *manager,
-                                                     GimpContext            *context,
-                                                     GimpProgress           *progress,
-                                                     GimpTemporaryProcedure *procedure,
-                                                     GimpValueArray         *args);
+GimpValueArray * gimp_plug_in_manager_call_run_temp  (GimpPlugInManager      *manager,
+                                                      GimpContext            *context,
+                                                      GimpProgress           *progress,
+                                                      GimpTemporaryProcedure *procedure,
+                                                      GimpValueArray         *args);
 
 
 #endif /* __GIMP_PLUG_IN_MANAGER_CALL_H__ */
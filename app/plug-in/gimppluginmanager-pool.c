@@ -0,0 +1,293 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimppluginmanager-pool.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gegl.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "plug-in-types.h"
+
+#include "config/gimpcoreconfig.h"
+
+#include "core/gimp.h"
+#include "core/gimpprogress.h"
+
+#include "pdb/gimppdbcontext.h"
+
+#include "gimpplugin.h"
+#include "gimppluginmanager.h"
+#include "gimppluginmanager-pool.h"
+#include "gimppluginprocedure.h"
+
+
+/*  The plug-in pool keeps plug-in processes which finished a
+ *  non-interactive run alive, so that the next call of a procedure
+ *  in the same binary can skip process startup and libgimp/GEGL
+ *  initialization.  manager->plug_in_pool is ordered from most to
+ *  least recently used; when the pool is full the least recently
+ *  used process is terminated, and processes which stayed idle for
+ *  longer than "plug-in-pool-timeout" seconds are terminated too.
+ */
+
+
+static void       gimp_plug_in_manager_pool_evict    (GimpPlugInManager *manager,
+                                                      GimpPlugIn        *plug_in);
+static void       gimp_plug_in_manager_pool_schedule (GimpPlugInManager *manager);
+static gboolean   gimp_plug_in_manager_pool_timeout  (GimpPlugInManager *manager);
+
+
+/*  public functions  */
+
+void
+gimp_plug_in_manager_pool_exit (GimpPlugInManager *manager)
+{
+  g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
+
+  if (manager->plug_in_pool_timeout_id)
+    {
+      g_source_remove (manager->plug_in_pool_timeout_id);
+      manager->plug_in_pool_timeout_id = 0;
+    }
+
+  while (manager->plug_in_pool)
+    gimp_plug_in_manager_pool_evict (manager, manager->plug_in_pool->data);
+}
+
+gboolean
+gimp_plug_in_manager_pool_can_run (GimpPlugInManager   *manager,
+                                   GimpPlugInProcedure *procedure,
+                                   GimpValueArray      *args)
+{
+  GimpProcedure *proc;
+  GParamSpec    *pspec;
+
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager), FALSE);
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_PROCEDURE (procedure), FALSE);
+  g_return_val_if_fail (args != NULL, FALSE);
+
+  if (manager->gimp->config->plug_in_pool_size < 1)
+    return FALSE;
+
+  proc = GIMP_PROCEDURE (procedure);
+
+  /*  extensions are long-running anyway  */
+  if (proc->proc_type != GIMP_PLUGIN)
+    return FALSE;
+
+  /*  only reuse processes for non-interactive calls, interactive runs
+   *  may leave dialog and GTK+ state behind in the plug-in process
+   */
+  if (proc->num_args < 1 || gimp_value_array_length (args) < 1)
+    return FALSE;
+
+  pspec = proc->args[0];
+
+  if (! G_IS_PARAM_SPEC_INT (pspec) ||
+      strcmp (g_param_spec_get_name (pspec), "run-mode"))
+    return FALSE;
+
+  return (g_value_get_int (gimp_value_array_index (args, 0)) ==
+          GIMP_RUN_NONINTERACTIVE);
+}
+
+GimpPlugIn *
+gimp_plug_in_manager_pool_acquire (GimpPlugInManager   *manager,
+                                   GimpContext         *context,
+                                   GimpProgress        *progress,
+                                   GimpPlugInProcedure *procedure)
+{
+  GFile *file;
+  GList *list;
+
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager), NULL);
+  g_return_val_if_fail (GIMP_IS_PDB_CONTEXT (context), NULL);
+  g_return_val_if_fail (progress == NULL || GIMP_IS_PROGRESS (progress), NULL);
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_PROCEDURE (procedure), NULL);
+
+  file = gimp_plug_in_procedure_get_file (procedure);
+
+  for (list = manager->plug_in_pool; list; list = g_list_next (list))
+    {
+      GimpPlugIn *plug_in = list->data;
+
+      if (plug_in->open && g_file_equal (plug_in->file, file))
+        {
+          /*  the pool's reference is passed on to the caller  */
+          manager->plug_in_pool = g_list_delete_link (manager->plug_in_pool,
+                                                      list);
+
+          gimp_plug_in_proc_frame_init (&plug_in->main_proc_frame,
+                                        context, progress, procedure);
+
+          plug_in->precision = FALSE;
+
+          return plug_in;
+        }
+    }
+
+  return NULL;
+}
+
+void
+gimp_plug_in_manager_pool_release (GimpPlugInManager *manager,
+                                   GimpPlugIn        *plug_in)
+{
+  GimpCoreConfig *config;
+
+  g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
+  g_return_if_fail (GIMP_IS_PLUG_IN (plug_in));
+
+  if (! plug_in->open)
+    return;
+
+  config = manager->gimp->config;
+
+  /*  a plug-in which still has temporary procedures installed is
+   *  still in use, don't hand it out to somebody else
+   */
+  if (config->plug_in_pool_size < 1 ||
+      plug_in->temp_procedures      ||
+      plug_in->temp_proc_frames)
+    {
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  /*  finish the run, this also cleans up undo groups and progress
+   *  the plug-in may have left behind
+   */
+  gimp_plug_in_proc_frame_dispose (&plug_in->main_proc_frame, plug_in);
+
+  plug_in->idle_time = g_get_monotonic_time ();
+
+  manager->plug_in_pool = g_list_prepend (manager->plug_in_pool,
+                                          g_object_ref (plug_in));
+
+  while (g_list_length (manager->plug_in_pool) > config->plug_in_pool_size)
+    {
+      GList *last = g_list_last (manager->plug_in_pool);
+
+      gimp_plug_in_manager_pool_evict (manager, last->data);
+    }
+
+  gimp_plug_in_manager_pool_schedule (manager);
+}
+
+void
+gimp_plug_in_manager_pool_remove (GimpPlugInManager *manager,
+                                  GimpPlugIn        *plug_in)
+{
+  GList *link;
+
+  g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
+  g_return_if_fail (GIMP_IS_PLUG_IN (plug_in));
+
+  link = g_list_find (manager->plug_in_pool, plug_in);
+
+  if (link)
+    {
+      manager->plug_in_pool = g_list_delete_link (manager->plug_in_pool,
+                                                  link);
+      g_object_unref (plug_in);
+    }
+}
+
+
+/*  private functions  */
+
+static void
+gimp_plug_in_manager_pool_evict (GimpPlugInManager *manager,
+                                 GimpPlugIn        *plug_in)
+{
+  g_object_ref (plug_in);
+
+  gimp_plug_in_manager_pool_remove (manager, plug_in);
+
+  if (plug_in->open)
+    {
+      if (manager->gimp->be_verbose)
+        g_print ("Evicting idle plug-in: '%s'\n",
+                 gimp_file_get_utf8_name (plug_in->file));
+
+      gimp_plug_in_close (plug_in, TRUE);
+    }
+
+  g_object_unref (plug_in);
+}
+
+static void
+gimp_plug_in_manager_pool_schedule (GimpPlugInManager *manager)
+{
+  GimpPlugIn *oldest;
+  gint64      timeout;
+  gint64      remaining;
+
+  if (manager->plug_in_pool_timeout_id)
+    {
+      g_source_remove (manager->plug_in_pool_timeout_id);
+      manager->plug_in_pool_timeout_id = 0;
+    }
+
+  if (! manager->plug_in_pool)
+    return;
+
+  oldest  = g_list_last (manager->plug_in_pool)->data;
+  timeout = ((gint64) manager->gimp->config->plug_in_pool_timeout *
+             G_TIME_SPAN_SECOND);
+
+  remaining = oldest->idle_time + timeout - g_get_monotonic_time ();
+  remaining = MAX (remaining, 0);
+
+  manager->plug_in_pool_timeout_id =
+    g_timeout_add (remaining / G_TIME_SPAN_MILLISECOND + 1,
+                   (GSourceFunc) gimp_plug_in_manager_pool_timeout,
+                   manager);
+}
+
+static gboolean
+gimp_plug_in_manager_pool_timeout (GimpPlugInManager *manager)
+{
+  gint64 timeout;
+  gint64 now;
+
+  manager->plug_in_pool_timeout_id = 0;
+
+  timeout = ((gint64) manager->gimp->config->plug_in_pool_timeout *
+             G_TIME_SPAN_SECOND);
+  now     = g_get_monotonic_time ();
+
+  while (manager->plug_in_pool)
+    {
+      GimpPlugIn *oldest = g_list_last (manager->plug_in_pool)->data;
+
+      if (now - oldest->idle_time < timeout)
+        break;
+
+      gimp_plug_in_manager_pool_evict (manager, oldest);
+    }
+
+  gimp_plug_in_manager_pool_schedule (manager);
+
+  return G_SOURCE_REMOVE;
+}
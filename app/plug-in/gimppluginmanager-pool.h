@@ -0,0 +1,46 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimppluginmanager-pool.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_PLUG_IN_MANAGER_POOL_H__
+#define __GIMP_PLUG_IN_MANAGER_POOL_H__
+
+
+void         gimp_plug_in_manager_pool_exit    (GimpPlugInManager   *manager);
+
+/* Whether a run of @procedure with @args may reuse a pooled process */
+gboolean     gimp_plug_in_manager_pool_can_run (GimpPlugInManager   *manager,
+                                                GimpPlugInProcedure *procedure,
+                                                GimpValueArray      *args);
+
+/* Take an idle plug-in process out of the pool, or return NULL */
+GimpPlugIn * gimp_plug_in_manager_pool_acquire (GimpPlugInManager   *manager,
+                                                GimpContext         *context,
+                                                GimpProgress        *progress,
+                                                GimpPlugInProcedure *procedure);
+
+/* Put a plug-in which finished its run into the pool, or close it */
+void         gimp_plug_in_manager_pool_release (GimpPlugInManager   *manager,
+                                                GimpPlugIn          *plug_in);
+
+/* Forget about a pooled plug-in, called when it is closed */
+void         gimp_plug_in_manager_pool_remove  (GimpPlugInManager   *manager,
+                                                GimpPlugIn          *plug_in);
+
+
+#endif /* __GIMP_PLUG_IN_MANAGER_POOL_H__ */
@@ -47,24 +47,48 @@
 #include "gimppluginmanager-restore.h"
 #include "gimppluginprocedure.h"
 #include "plug-in-rc.h"
+#include "plug-in-rc-cache.h"
 
 #include "gimp-intl.h"
 
 
+/*  upper limit for the number of plug-ins queried at the same time  */
+#define MAX_PARALLEL_PLUG_INS 16
+
+
+typedef struct
+{
+  GimpPlugInManager *manager;
+  GHashTable        *ondisk_defs;
+} PluginrcCacheFilter;
+
+
 static void    gimp_plug_in_manager_search            (GimpPlugInManager    *manager,
                                                        GimpInitStatusFunc    status_callback);
 static void    gimp_plug_in_manager_search_directory  (GimpPlugInManager    *manager,
                                                        GFile                *directory);
 static GFile * gimp_plug_in_manager_get_pluginrc      (GimpPlugInManager    *manager);
+static GFile * gimp_plug_in_manager_get_pluginrc_cache
+                                                      (GFile                *pluginrc);
 static void    gimp_plug_in_manager_read_pluginrc     (GimpPlugInManager    *manager,
                                                        GFile                *file,
+                                                       GFile                *cache,
                                                        GimpInitStatusFunc    status_callback);
+static gboolean gimp_plug_in_manager_pluginrc_cache_filter
+                                                      (GFile                *file,
+                                                       gint64                mtime,
+                                                       PluginrcCacheFilter  *data);
 static void    gimp_plug_in_manager_query_new         (GimpPlugInManager    *manager,
                                                        GimpContext          *context,
                                                        GimpInitStatusFunc    status_callback);
 static void    gimp_plug_in_manager_init_plug_ins     (GimpPlugInManager    *manager,
                                                        GimpContext          *context,
                                                        GimpInitStatusFunc    status_callback);
+static void    gimp_plug_in_manager_call_parallel     (GimpPlugInManager    *manager,
+                                                       GimpContext          *context,
+                                                       GSList               *plug_in_defs,
+                                                       GimpPlugInCallMode    call_mode,
+                                                       GimpInitStatusFunc    status_callback);
 static void    gimp_plug_in_manager_run_extensions    (GimpPlugInManager    *manager,
                                                        GimpContext          *context,
                                                        GimpInitStatusFunc    status_callback);
@@ -91,6 +115,7 @@ gimp_plug_in_manager_restore (GimpPlugInManager  *manager,
 {
   Gimp   *gimp;
   GFile  *pluginrc;
+  GFile  *pluginrc_cache;
   GSList *list;
   GError *error = NULL;
 
@@ -107,9 +132,11 @@ gimp_plug_in_manager_restore (GimpPlugInManager  *manager,
   gimp_plug_in_manager_search (manager, status_callback);
 
   /* read the pluginrc file for cached data */
-  pluginrc = gimp_plug_in_manager_get_pluginrc (manager);
+  pluginrc       = gimp_plug_in_manager_get_pluginrc (manager);
+  pluginrc_cache = gimp_plug_in_manager_get_pluginrc_cache (pluginrc);
 
-  gimp_plug_in_manager_read_pluginrc (manager, pluginrc, status_callback);
+  gimp_plug_in_manager_read_pluginrc (manager, pluginrc, pluginrc_cache,
+                                      status_callback);
 
   /* query any plug-ins that changed since we last wrote out pluginrc */
   gimp_plug_in_manager_query_new (manager, context, status_callback);
@@ -142,9 +169,18 @@ gimp_plug_in_manager_restore (GimpPlugInManager  *manager,
           g_clear_error (&error);
         }
 
+      if (! plug_in_rc_cache_write (manager->plug_in_defs, pluginrc_cache,
+                                    &error))
+        {
+          gimp_message_literal (gimp,
+                                NULL, GIMP_MESSAGE_ERROR, error->message);
+          g_clear_error (&error);
+        }
+
       manager->write_pluginrc = FALSE;
     }
 
+  g_object_unref (pluginrc_cache);
   g_object_unref (pluginrc);
 
   /* create locale and help domain lists */
@@ -383,27 +419,93 @@ gimp_plug_in_manager_get_pluginrc (GimpPlugInManager *manager)
   return pluginrc;
 }
 
+/* the binary copy of pluginrc lives next to it */
+static GFile *
+gimp_plug_in_manager_get_pluginrc_cache (GFile *pluginrc)
+{
+  GFile *parent;
+  GFile *cache;
+  gchar *basename;
+  gchar *cache_name;
+
+  parent     = g_file_get_parent (pluginrc);
+  basename   = g_file_get_basename (pluginrc);
+  cache_name = g_strconcat (basename, ".cache", NULL);
+
+  cache = g_file_get_child (parent, cache_name);
+
+  g_free (cache_name);
+  g_free (basename);
+  g_object_unref (parent);
+
+  return cache;
+}
+
 /* read the pluginrc file for cached data */
 static void
 gimp_plug_in_manager_read_pluginrc (GimpPlugInManager  *manager,
                                     GFile              *pluginrc,
+                                    GFile              *cache,
                                     GimpInitStatusFunc  status_callback)
 {
-  GSList *rc_defs;
-  GError *error = NULL;
+  PluginrcCacheFilter  filter;
+  GSList              *rc_defs;
+  GSList              *list;
+  GError              *error = NULL;
 
   status_callback (_("Resource configuration"),
                    gimp_file_get_utf8_name (pluginrc), 0.0);
 
+  /*  try the binary cache first, it only decodes the entries of
+   *  plug-ins which didn't change on disk
+   */
+  filter.manager     = manager;
+  filter.ondisk_defs = g_hash_table_new ((GHashFunc) g_file_hash,
+                                         (GEqualFunc) g_file_equal);
+
+  for (list = manager->plug_in_defs; list; list = g_slist_next (list))
+    {
+      GimpPlugInDef *plug_in_def = list->data;
+
+      g_hash_table_insert (filter.ondisk_defs, plug_in_def->file, plug_in_def);
+    }
+
   if (manager->gimp->be_verbose)
-    g_print ("Parsing '%s'\n", gimp_file_get_utf8_name (pluginrc));
+    g_print ("Parsing '%s'\n", gimp_file_get_utf8_name (cache));
 
-  rc_defs = plug_in_rc_parse (manager->gimp, pluginrc, &error);
+  rc_defs = plug_in_rc_cache_parse (manager->gimp, cache,
+                                    (PlugInRcCacheFilter)
+                                    gimp_plug_in_manager_pluginrc_cache_filter,
+                                    &filter, &error);
 
-  if (rc_defs)
+  g_hash_table_destroy (filter.ondisk_defs);
+
+  if (! error)
+    {
+      /*  regenerate pluginrc if it has been removed  */
+      if (! g_file_query_exists (pluginrc, NULL))
+        manager->write_pluginrc = TRUE;
+    }
+  else
     {
-      GSList *list;
+      if (manager->gimp->be_verbose &&
+          error->code != GIMP_CONFIG_ERROR_OPEN_ENOENT)
+        g_printerr ("%s\n", error->message);
+
+      g_clear_error (&error);
 
+      if (manager->gimp->be_verbose)
+        g_print ("Parsing '%s'\n", gimp_file_get_utf8_name (pluginrc));
+
+      rc_defs = plug_in_rc_parse (manager->gimp, pluginrc, &error);
+
+      /*  the cache is missing or outdated, write a new one  */
+      if (rc_defs)
+        manager->write_pluginrc = TRUE;
+    }
+
+  if (rc_defs)
+    {
       for (list = rc_defs; list; list = g_slist_next (list))
         gimp_plug_in_manager_add_from_rc (manager, list->data); /* consumes list->data */
 
@@ -419,52 +521,58 @@ gimp_plug_in_manager_read_pluginrc (GimpPlugInManager  *manager,
     }
 }
 
+static gboolean
+gimp_plug_in_manager_pluginrc_cache_filter (GFile               *file,
+                                            gint64               mtime,
+                                            PluginrcCacheFilter *data)
+{
+  GimpPlugInDef *ondisk_plug_in_def;
+
+  ondisk_plug_in_def = g_hash_table_lookup (data->ondisk_defs, file);
+
+  if (ondisk_plug_in_def && ondisk_plug_in_def->mtime == mtime)
+    return TRUE;
+
+  /*  the plug-in changed or is gone, either way pluginrc is stale  */
+  data->manager->write_pluginrc = TRUE;
+
+  if (! ondisk_plug_in_def && data->manager->gimp->be_verbose)
+    g_printerr ("pluginrc lists '%s', but it wasn't found\n",
+                gimp_file_get_utf8_name (file));
+
+  return FALSE;
+}
+
 /* query any plug-ins that changed since we last wrote out pluginrc */
 static void
 gimp_plug_in_manager_query_new (GimpPlugInManager  *manager,
                                 GimpContext        *context,
                                 GimpInitStatusFunc  status_callback)
 {
+  GSList *plug_in_defs = NULL;
   GSList *list;
-  gint    n_plugins;
 
   status_callback (_("Querying new Plug-ins"), "", 0.0);
 
-  for (list = manager->plug_in_defs, n_plugins = 0; list; list = list->next)
+  for (list = manager->plug_in_defs; list; list = list->next)
     {
       GimpPlugInDef *plug_in_def = list->data;
 
       if (plug_in_def->needs_query)
-        n_plugins++;
+        plug_in_defs = g_slist_prepend (plug_in_defs, plug_in_def);
     }
 
-  if (n_plugins)
+  if (plug_in_defs)
     {
-      gint nth;
-
       manager->write_pluginrc = TRUE;
 
-      for (list = manager->plug_in_defs, nth = 0; list; list = list->next)
-        {
-          GimpPlugInDef *plug_in_def = list->data;
-
-          if (plug_in_def->needs_query)
-            {
-              gchar *basename;
-
-              basename =
-                g_path_get_basename (gimp_file_get_utf8_name (plug_in_def->file));
-              status_callback (NULL, basename,
-                               (gdouble) nth++ / (gdouble) n_plugins);
-              g_free (basename);
+      plug_in_defs = g_slist_reverse (plug_in_defs);
 
-              if (manager->gimp->be_verbose)
-                g_print ("Querying plug-in: '%s'\n",
-                         gimp_file_get_utf8_name (plug_in_def->file));
+      gimp_plug_in_manager_call_parallel (manager, context, plug_in_defs,
+                                          GIMP_PLUG_IN_CALL_QUERY,
+                                          status_callback);
 
-              gimp_plug_in_manager_call_query (manager, context, plug_in_def);
-            }
-        }
+      g_slist_free (plug_in_defs);
     }
 
   status_callback (NULL, "", 1.0);
@@ -476,47 +584,138 @@ gimp_plug_in_manager_init_plug_ins (GimpPlugInManager  *manager,
                                     GimpContext        *context,
                                     GimpInitStatusFunc  status_callback)
 {
+  GSList *plug_in_defs = NULL;
   GSList *list;
-  gint    n_plugins;
 
   status_callback (_("Initializing Plug-ins"), "", 0.0);
 
-  for (list = manager->plug_in_defs, n_plugins = 0; list; list = list->next)
+  for (list = manager->plug_in_defs; list; list = list->next)
     {
       GimpPlugInDef *plug_in_def = list->data;
 
       if (plug_in_def->has_init)
-        n_plugins++;
+        plug_in_defs = g_slist_prepend (plug_in_defs, plug_in_def);
     }
 
-  if (n_plugins)
+  if (plug_in_defs)
+    {
+      plug_in_defs = g_slist_reverse (plug_in_defs);
+
+      gimp_plug_in_manager_call_parallel (manager, context, plug_in_defs,
+                                          GIMP_PLUG_IN_CALL_INIT,
+                                          status_callback);
+
+      g_slist_free (plug_in_defs);
+    }
+
+  status_callback (NULL, "", 1.0);
+}
+
+/* run the query() or init() functions of @plug_in_defs, keeping up
+ * to one plug-in process per processor running at the same time.
+ * Messages are handled in the main thread as they arrive, since every
+ * plug-in only registers into its own GimpPlugInDef the result does
+ * not depend on the order in which the plug-ins finish.
+ */
+static void
+gimp_plug_in_manager_call_parallel (GimpPlugInManager  *manager,
+                                    GimpContext        *context,
+                                    GSList             *plug_in_defs,
+                                    GimpPlugInCallMode  call_mode,
+                                    GimpInitStatusFunc  status_callback)
+{
+  GimpPlugIn **running;
+  GPollFD     *fds;
+  GSList      *pending;
+  gint         n_plugins;
+  gint         max_running;
+  gint         n_running = 0;
+  gint         nth       = 0;
+
+  n_plugins = g_slist_length (plug_in_defs);
+
+#ifdef G_OS_WIN32
+  /*  g_poll() can't wait on the plug-in pipes' file descriptors  */
+  max_running = 1;
+#else
+  max_running = CLAMP (GIMP_GEGL_CONFIG (manager->gimp->config)->num_processors,
+                       1, MAX_PARALLEL_PLUG_INS);
+#endif
+
+  running = g_new0 (GimpPlugIn *, max_running);
+  fds     = g_new0 (GPollFD, max_running);
+
+  pending = plug_in_defs;
+
+  while (pending || n_running > 0)
     {
-      gint nth;
+      gboolean poll_failed = FALSE;
+      gint     i;
 
-      for (list = manager->plug_in_defs, nth = 0; list; list = list->next)
+      while (pending && n_running < max_running)
         {
-          GimpPlugInDef *plug_in_def = list->data;
+          GimpPlugInDef *plug_in_def = pending->data;
+          GimpPlugIn    *plug_in;
+          gchar         *basename;
 
-          if (plug_in_def->has_init)
-            {
-              gchar *basename;
+          pending = g_slist_next (pending);
+
+          basename =
+            g_path_get_basename (gimp_file_get_utf8_name (plug_in_def->file));
+          status_callback (NULL, basename,
+                           (gdouble) nth++ / (gdouble) n_plugins);
+          g_free (basename);
+
+          if (manager->gimp->be_verbose)
+            g_print (call_mode == GIMP_PLUG_IN_CALL_QUERY ?
+                     "Querying plug-in: '%s'\n" :
+                     "Initializing plug-in: '%s'\n",
+                     gimp_file_get_utf8_name (plug_in_def->file));
 
-              basename =
-                g_path_get_basename (gimp_file_get_utf8_name (plug_in_def->file));
-              status_callback (NULL, basename,
-                               (gdouble) nth++ / (gdouble) n_plugins);
-              g_free (basename);
+          plug_in = gimp_plug_in_manager_call_start (manager, context,
+                                                     plug_in_def, call_mode);
 
-              if (manager->gimp->be_verbose)
-                g_print ("Initializing plug-in: '%s'\n",
-                         gimp_file_get_utf8_name (plug_in_def->file));
+          if (plug_in)
+            running[n_running++] = plug_in;
+        }
+
+      if (n_running == 0)
+        continue;
+
+#ifndef G_OS_WIN32
+      for (i = 0; i < n_running; i++)
+        {
+          fds[i].fd      = g_io_channel_unix_get_fd (running[i]->my_read);
+          fds[i].events  = G_IO_IN | G_IO_PRI | G_IO_ERR | G_IO_HUP;
+          fds[i].revents = 0;
+        }
+
+      if (g_poll (fds, n_running, -1) < 0)
+        poll_failed = TRUE;
+#else
+      poll_failed = TRUE;
+#endif
+
+      /*  walk backwards, so finished plug-ins can be replaced by the
+       *  last running one, which has already been handled
+       */
+      for (i = n_running - 1; i >= 0; i--)
+        {
+          if (! poll_failed && ! fds[i].revents)
+            continue;
 
-              gimp_plug_in_manager_call_init (manager, context, plug_in_def);
+          if (! gimp_plug_in_manager_call_dispatch (manager, running[i]))
+            {
+              g_object_unref (running[i]);
+
+              running[i] = running[--n_running];
+              fds[i]     = fds[n_running];
             }
         }
     }
 
-  status_callback (NULL, "", 1.0);
+  g_free (fds);
+  g_free (running);
 }
 
 /* run automatically started extensions */
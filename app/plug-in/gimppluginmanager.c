@@ -48,6 +48,7 @@
 #include "gimppluginmanager-help-domain.h"
 #include "gimppluginmanager-locale-domain.h"
 #include "gimppluginmanager-menu-branch.h"
+#include "gimppluginmanager-pool.h"
 #include "gimppluginshm.h"
 #include "gimptemporaryprocedure.h"
 
@@ -190,6 +191,7 @@ gimp_plug_in_manager_get_memsize (GimpObject *object,
                                                gimp_object_get_memsize,
                                                gui_size);
   memsize += gimp_g_slist_get_memsize (manager->plug_in_stack, 0);
+  memsize += gimp_g_list_get_memsize (manager->plug_in_pool, 0);
 
   memsize += 0; /* FIXME manager->shm */
   memsize += gimp_object_get_memsize (GIMP_OBJECT (manager->interpreter_db),
@@ -256,6 +258,8 @@ gimp_plug_in_manager_exit (GimpPlugInManager *manager)
 {
   g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
 
+  gimp_plug_in_manager_pool_exit (manager);
+
   while (manager->open_plug_ins)
     gimp_plug_in_close (manager->open_plug_ins->data, TRUE);
 
@@ -411,3 +415,33 @@ gimp_plug_in_manager_plug_in_pop (GimpPlugInManager *manager)
   else
     manager->current_plug_in = NULL;
 }
+
+/*  kills the plug-in which runs an asynchronous call reporting to
+ *  return_func and return_data, return_func is then called with an
+ *  execution error
+ */
+gboolean
+gimp_plug_in_manager_abort_async (GimpPlugInManager    *manager,
+                                  GimpPlugInReturnFunc  return_func,
+                                  gpointer              return_data)
+{
+  GSList *list;
+
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager), FALSE);
+  g_return_val_if_fail (return_func != NULL, FALSE);
+
+  for (list = manager->open_plug_ins; list; list = g_slist_next (list))
+    {
+      GimpPlugIn *plug_in = list->data;
+
+      if (plug_in->main_proc_frame.return_func == return_func &&
+          plug_in->main_proc_frame.return_data == return_data)
+        {
+          gimp_plug_in_close (plug_in, TRUE);
+
+          return TRUE;
+        }
+    }
+
+  return FALSE;
+}
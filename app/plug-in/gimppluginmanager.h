@@ -56,6 +56,8 @@ struct _GimpPlugInManager
   GimpPlugIn        *current_plug_in;
   GSList            *open_plug_ins;
   GSList            *plug_in_stack;
+  GList             *plug_in_pool;
+  guint              plug_in_pool_timeout_id;
 
   GimpPlugInShm     *shm;
   GimpInterpreterDB *interpreter_db;
@@ -109,5 +111,9 @@ void    gimp_plug_in_manager_plug_in_push         (GimpPlugInManager   *manager,
                                                    GimpPlugIn          *plug_in);
 void    gimp_plug_in_manager_plug_in_pop          (GimpPlugInManager   *manager);
 
+gboolean gimp_plug_in_manager_abort_async         (GimpPlugInManager   *manager,
+                                                   GimpPlugInReturnFunc return_func,
+                                                   gpointer             return_data);
+
 
 #endif  /* __GIMP_PLUG_IN_MANAGER_H__ */
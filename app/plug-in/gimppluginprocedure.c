@@ -35,9 +35,12 @@
 #include "core/gimpdrawable.h"
 #include "core/gimpmarshal.h"
 #include "core/gimpparamspecs.h"
+#include "core/gimpprogress.h"
 
 #include "file/file-utils.h"
 
+#include "pdb/gimppdbcontext.h"
+
 #define __YES_I_NEED_GIMP_PLUG_IN_MANAGER_CALL__
 #include "gimppluginmanager-call.h"
 
@@ -1189,3 +1192,75 @@ gimp_plug_in_procedure_handle_return_values (GimpPlugInProcedure *proc,
       break;
     }
 }
+
+/**
+ * gimp_plug_in_procedure_run_async:
+ * @proc:        a #GimpPlugInProcedure
+ * @gimp:        a #Gimp
+ * @context:     the context to run @proc in
+ * @progress:    a #GimpProgress, or %NULL
+ * @args:        the arguments of @proc
+ * @return_func: called with the return values
+ * @return_data: user data for @return_func
+ *
+ * Runs @proc without waiting for it, like gimp_procedure_execute_async(),
+ * but hands its return values to @return_func instead of displaying
+ * its errors. This allows for running several plug-ins at once.
+ *
+ * @return_func is always called exactly once, directly from this
+ * function if @proc can't be started or is run by the core itself.
+ **/
+void
+gimp_plug_in_procedure_run_async (GimpPlugInProcedure  *proc,
+                                  Gimp                 *gimp,
+                                  GimpContext          *context,
+                                  GimpProgress         *progress,
+                                  GimpValueArray       *args,
+                                  GimpPlugInReturnFunc  return_func,
+                                  gpointer              return_data)
+{
+  GimpProcedure  *procedure   = GIMP_PROCEDURE (proc);
+  GimpValueArray *return_vals = NULL;
+  GError         *error       = NULL;
+
+  g_return_if_fail (GIMP_IS_PLUG_IN_PROCEDURE (proc));
+  g_return_if_fail (GIMP_IS_GIMP (gimp));
+  g_return_if_fail (GIMP_IS_CONTEXT (context));
+  g_return_if_fail (progress == NULL || GIMP_IS_PROGRESS (progress));
+  g_return_if_fail (args != NULL);
+  g_return_if_fail (return_func != NULL);
+
+  if (! gimp_plug_in_procedure_validate_args (proc, gimp, args, &error))
+    {
+      return_vals = gimp_procedure_get_return_values (procedure, FALSE, error);
+      g_error_free (error);
+    }
+  else if (procedure->proc_type == GIMP_INTERNAL)
+    {
+      return_vals = gimp_procedure_execute (procedure, gimp,
+                                            context, progress,
+                                            args, NULL);
+    }
+  else
+    {
+      if (GIMP_IS_PDB_CONTEXT (context))
+        context = g_object_ref (context);
+      else
+        context = gimp_pdb_context_new (gimp, context, TRUE);
+
+      return_vals = gimp_plug_in_manager_call_run_async (gimp->plug_in_manager,
+                                                         context, progress,
+                                                         proc, args,
+                                                         return_func,
+                                                         return_data);
+
+      g_object_unref (context);
+    }
+
+  if (return_vals)
+    {
+      return_func (return_vals, return_data);
+
+      gimp_value_array_unref (return_vals);
+    }
+}
@@ -80,6 +80,8 @@ gimp_plug_in_proc_frame_init (GimpPlugInProcFrame *proc_frame,
   proc_frame->procedure          = procedure ? g_object_ref (procedure) : NULL;
   proc_frame->main_loop          = NULL;
   proc_frame->return_vals        = NULL;
+  proc_frame->return_func        = NULL;
+  proc_frame->return_data        = NULL;
   proc_frame->progress           = progress ? g_object_ref (progress) : NULL;
   proc_frame->progress_created   = FALSE;
   proc_frame->progress_cancel_id = 0;
@@ -0,0 +1,769 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * plug-in-rc-cache.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gegl.h>
+
+#include "libgimpbase/gimpbase.h"
+#include "libgimpbase/gimpprotocol.h"
+#include "libgimpconfig/gimpconfig.h"
+
+#include "plug-in-types.h"
+
+#include "core/gimp.h"
+
+#include "pdb/gimp-pdb-compat.h"
+
+#include "gimpplugindef.h"
+#include "gimppluginprocedure.h"
+#include "plug-in-rc-cache.h"
+
+#include "gimp-intl.h"
+
+
+/*  The pluginrc cache holds the same information as pluginrc, but in
+ *  a binary form which is mapped into memory instead of tokenized.
+ *
+ *  It starts with a header and an index which lists the config path
+ *  and mtime of every plug-in together with the location of its
+ *  record.  A record is only decoded if the caller accepts the index
+ *  entry, plug-ins which changed or vanished since the cache was
+ *  written are skipped without looking at their procedures.
+ *
+ *  Numbers are stored in host byte order, a cache written on a
+ *  machine with different byte order is rejected like one with a
+ *  different version.
+ */
+
+#define PLUG_IN_RC_CACHE_MAGIC      "GIMPPRC"
+#define PLUG_IN_RC_CACHE_VERSION    1
+#define PLUG_IN_RC_CACHE_BYTE_ORDER 0x01020304
+
+/*  location of the entry count, right after magic, byte order,
+ *  cache version and protocol version
+ */
+#define PLUG_IN_RC_CACHE_N_ENTRIES_OFFSET (sizeof (PLUG_IN_RC_CACHE_MAGIC) + \
+                                           3 * sizeof (guint32))
+
+/*  string length marking a NULL string  */
+#define PLUG_IN_RC_CACHE_NULL       G_MAXUINT32
+
+
+typedef struct
+{
+  const guint8 *data;
+  gsize         size;
+  gsize         offset;
+  gboolean      error;
+} CacheReader;
+
+
+static GimpPlugInDef       * plug_in_rc_cache_read_def       (Gimp          *gimp,
+                                                              CacheReader   *reader,
+                                                              GFile         *file,
+                                                              gint64         mtime);
+static GimpPlugInProcedure * plug_in_rc_cache_read_procedure (Gimp          *gimp,
+                                                              CacheReader   *reader,
+                                                              GFile         *file);
+static gboolean              plug_in_rc_cache_read_arg       (Gimp          *gimp,
+                                                              CacheReader   *reader,
+                                                              GimpProcedure *procedure,
+                                                              gboolean       return_value);
+
+static void            plug_in_rc_cache_write_def  (GByteArray          *array,
+                                                    GimpPlugInDef       *plug_in_def);
+static void            plug_in_rc_cache_write_procedure
+                                                   (GByteArray          *array,
+                                                    GimpPlugInProcedure *proc);
+static void            plug_in_rc_cache_write_arg  (GByteArray          *array,
+                                                    GParamSpec          *pspec);
+
+static const guint8  * cache_reader_data           (CacheReader         *reader,
+                                                    gsize                length);
+static guint32         cache_reader_uint32         (CacheReader         *reader);
+static gint64          cache_reader_int64          (CacheReader         *reader);
+static const gchar   * cache_reader_string         (CacheReader         *reader);
+static gchar         * cache_reader_dup_string     (CacheReader         *reader);
+
+static void            cache_write_uint32          (GByteArray          *array,
+                                                    guint32              value);
+static void            cache_write_int64           (GByteArray          *array,
+                                                    gint64               value);
+static void            cache_write_string          (GByteArray          *array,
+                                                    const gchar         *string);
+
+
+GSList *
+plug_in_rc_cache_parse (Gimp                 *gimp,
+                        GFile                *file,
+                        PlugInRcCacheFilter   filter,
+                        gpointer              user_data,
+                        GError              **error)
+{
+  GMappedFile  *mapped;
+  GEnumClass   *enum_class;
+  CacheReader   reader  = { 0, };
+  CacheReader   index;
+  GSList       *plug_in_defs = NULL;
+  const guint8 *magic;
+  gchar        *path;
+  gsize         records;
+  guint32       n_entries;
+  guint32       i;
+
+  g_return_val_if_fail (GIMP_IS_GIMP (gimp), NULL);
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  path = g_file_get_path (file);
+
+  if (! path)
+    {
+      g_set_error (error, GIMP_CONFIG_ERROR, GIMP_CONFIG_ERROR_OPEN,
+                   _("Could not open '%s' for reading"),
+                   gimp_file_get_utf8_name (file));
+      return NULL;
+    }
+
+  mapped = g_mapped_file_new (path, FALSE, NULL);
+  g_free (path);
+
+  if (! mapped)
+    {
+      g_set_error (error, GIMP_CONFIG_ERROR, GIMP_CONFIG_ERROR_OPEN_ENOENT,
+                   _("Could not open '%s' for reading"),
+                   gimp_file_get_utf8_name (file));
+      return NULL;
+    }
+
+  reader.data = (const guint8 *) g_mapped_file_get_contents (mapped);
+  reader.size = g_mapped_file_get_length (mapped);
+
+  magic = cache_reader_data (&reader, sizeof (PLUG_IN_RC_CACHE_MAGIC));
+
+  if (! magic ||
+      memcmp (magic, PLUG_IN_RC_CACHE_MAGIC, sizeof (PLUG_IN_RC_CACHE_MAGIC)) ||
+      cache_reader_uint32 (&reader) != PLUG_IN_RC_CACHE_BYTE_ORDER ||
+      cache_reader_uint32 (&reader) != PLUG_IN_RC_CACHE_VERSION    ||
+      cache_reader_uint32 (&reader) != GIMP_PROTOCOL_VERSION)
+    {
+      g_set_error (error, GIMP_CONFIG_ERROR, GIMP_CONFIG_ERROR_VERSION,
+                   _("Skipping '%s': wrong pluginrc cache version."),
+                   gimp_file_get_utf8_name (file));
+      g_mapped_file_unref (mapped);
+      return NULL;
+    }
+
+  n_entries = cache_reader_uint32 (&reader);
+  records   = cache_reader_uint32 (&reader);
+
+  enum_class = g_type_class_ref (GIMP_TYPE_ICON_TYPE);
+
+  /*  the index starts right after the header, the records start at
+   *  offset "records", record offsets are relative to that
+   */
+  index = reader;
+
+  for (i = 0; i < n_entries && ! index.error; i++)
+    {
+      const gchar *config_path;
+      gint64       mtime;
+      guint32      offset;
+      guint32      length;
+      GFile       *plug_in_file;
+
+      config_path = cache_reader_string (&index);
+      mtime       = cache_reader_int64 (&index);
+      offset      = cache_reader_uint32 (&index);
+      length      = cache_reader_uint32 (&index);
+
+      if (index.error || ! config_path)
+        {
+          index.error = TRUE;
+          break;
+        }
+
+      plug_in_file = gimp_file_new_for_config_path (config_path, NULL);
+
+      if (plug_in_file && (! filter || filter (plug_in_file, mtime, user_data)))
+        {
+          CacheReader    record = { 0, };
+          GimpPlugInDef *plug_in_def;
+
+          if (records > reader.size                  ||
+              offset  > reader.size - records        ||
+              length  > reader.size - records - offset)
+            {
+              g_object_unref (plug_in_file);
+              index.error = TRUE;
+              break;
+            }
+
+          record.data = reader.data + records + offset;
+          record.size = length;
+
+          plug_in_def = plug_in_rc_cache_read_def (gimp, &record,
+                                                   plug_in_file, mtime);
+
+          if (! plug_in_def)
+            {
+              g_object_unref (plug_in_file);
+              index.error = TRUE;
+              break;
+            }
+
+          plug_in_defs = g_slist_prepend (plug_in_defs, plug_in_def);
+        }
+
+      if (plug_in_file)
+        g_object_unref (plug_in_file);
+    }
+
+  g_type_class_unref (enum_class);
+
+  g_mapped_file_unref (mapped);
+
+  if (index.error)
+    {
+      g_set_error (error, GIMP_CONFIG_ERROR, GIMP_CONFIG_ERROR_PARSE,
+                   _("Skipping '%s': pluginrc cache is corrupt."),
+                   gimp_file_get_utf8_name (file));
+
+      g_slist_free_full (plug_in_defs, (GDestroyNotify) g_object_unref);
+
+      return NULL;
+    }
+
+  return g_slist_reverse (plug_in_defs);
+}
+
+gboolean
+plug_in_rc_cache_write (GSList  *plug_in_defs,
+                        GFile   *file,
+                        GError **error)
+{
+  GByteArray *header;
+  GByteArray *records;
+  GSList     *list;
+  guint32     n_entries = 0;
+  guint32     records_offset;
+  gboolean    success;
+
+  g_return_val_if_fail (G_IS_FILE (file), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  header  = g_byte_array_new ();
+  records = g_byte_array_new ();
+
+  g_byte_array_append (header,
+                       (const guint8 *) PLUG_IN_RC_CACHE_MAGIC,
+                       sizeof (PLUG_IN_RC_CACHE_MAGIC));
+  cache_write_uint32 (header, PLUG_IN_RC_CACHE_BYTE_ORDER);
+  cache_write_uint32 (header, PLUG_IN_RC_CACHE_VERSION);
+  cache_write_uint32 (header, GIMP_PROTOCOL_VERSION);
+
+  /*  placeholders for the number of entries and the offset of the
+   *  records, both are patched below
+   */
+  cache_write_uint32 (header, 0);
+  cache_write_uint32 (header, 0);
+
+  for (list = plug_in_defs; list; list = list->next)
+    {
+      GimpPlugInDef *plug_in_def = list->data;
+      gchar         *path;
+      guint32        offset;
+
+      if (! plug_in_def->procedures)
+        continue;
+
+      path = gimp_file_get_config_path (plug_in_def->file, NULL);
+      if (! path)
+        continue;
+
+      offset = records->len;
+
+      plug_in_rc_cache_write_def (records, plug_in_def);
+
+      cache_write_string (header, path);
+      cache_write_int64  (header, plug_in_def->mtime);
+      cache_write_uint32 (header, offset);
+      cache_write_uint32 (header, records->len - offset);
+
+      g_free (path);
+
+      n_entries++;
+    }
+
+  records_offset = header->len;
+
+  memcpy (header->data + PLUG_IN_RC_CACHE_N_ENTRIES_OFFSET,
+          &n_entries, sizeof (guint32));
+  memcpy (header->data + PLUG_IN_RC_CACHE_N_ENTRIES_OFFSET + sizeof (guint32),
+          &records_offset, sizeof (guint32));
+
+  g_byte_array_append (header, records->data, records->len);
+  g_byte_array_free (records, TRUE);
+
+  success = g_file_replace_contents (file,
+                                     (const gchar *) header->data, header->len,
+                                     NULL, FALSE, G_FILE_CREATE_NONE,
+                                     NULL, NULL, error);
+
+  g_byte_array_free (header, TRUE);
+
+  return success;
+}
+
+
+/*  private functions  */
+
+static GimpPlugInDef *
+plug_in_rc_cache_read_def (Gimp        *gimp,
+                           CacheReader *reader,
+                           GFile       *file,
+                           gint64       mtime)
+{
+  GimpPlugInDef *plug_in_def;
+  const gchar   *domain_name;
+  const gchar   *domain_path;
+  guint32        n_procedures;
+  guint32        i;
+
+  plug_in_def = gimp_plug_in_def_new (file);
+
+  plug_in_def->mtime = mtime;
+
+  domain_name = cache_reader_string (reader);
+  domain_path = cache_reader_string (reader);
+
+  if (domain_name)
+    gimp_plug_in_def_set_locale_domain (plug_in_def, domain_name, domain_path);
+
+  domain_name = cache_reader_string (reader);
+  domain_path = cache_reader_string (reader);
+
+  if (domain_name)
+    gimp_plug_in_def_set_help_domain (plug_in_def, domain_name, domain_path);
+
+  if (cache_reader_uint32 (reader))
+    gimp_plug_in_def_set_has_init (plug_in_def, TRUE);
+
+  n_procedures = cache_reader_uint32 (reader);
+
+  for (i = 0; i < n_procedures && ! reader->error; i++)
+    {
+      GimpPlugInProcedure *proc;
+
+      proc = plug_in_rc_cache_read_procedure (gimp, reader, plug_in_def->file);
+
+      if (proc)
+        {
+          if (! reader->error)
+            gimp_plug_in_def_add_procedure (plug_in_def, proc);
+
+          g_object_unref (proc);
+        }
+    }
+
+  if (reader->error)
+    {
+      g_object_unref (plug_in_def);
+      return NULL;
+    }
+
+  return plug_in_def;
+}
+
+static GimpPlugInProcedure *
+plug_in_rc_cache_read_procedure (Gimp        *gimp,
+                                 CacheReader *reader,
+                                 GFile       *file)
+{
+  GimpProcedure       *procedure;
+  GimpPlugInProcedure *proc;
+  GEnumClass          *enum_class;
+  const gchar         *name;
+  guint32              proc_type;
+  guint32              n_menu_paths;
+  guint32              icon_type;
+  gint32               icon_data_length;
+  guint32              n_args;
+  guint32              n_return_vals;
+  guint32              i;
+
+  name      = cache_reader_string (reader);
+  proc_type = cache_reader_uint32 (reader);
+
+  if (! name || proc_type > GIMP_TEMPORARY)
+    {
+      reader->error = TRUE;
+      return NULL;
+    }
+
+  procedure = gimp_plug_in_procedure_new (proc_type, file);
+  proc      = GIMP_PLUG_IN_PROCEDURE (procedure);
+
+  gimp_object_take_name (GIMP_OBJECT (procedure),
+                         gimp_canonicalize_identifier (name));
+
+  procedure->original_name = g_strdup (name);
+
+  procedure->blurb     = cache_reader_dup_string (reader);
+  procedure->help      = cache_reader_dup_string (reader);
+  procedure->author    = cache_reader_dup_string (reader);
+  procedure->copyright = cache_reader_dup_string (reader);
+  procedure->date      = cache_reader_dup_string (reader);
+  proc->menu_label     = cache_reader_dup_string (reader);
+
+  n_menu_paths = cache_reader_uint32 (reader);
+
+  for (i = 0; i < n_menu_paths && ! reader->error; i++)
+    {
+      gchar *menu_path = cache_reader_dup_string (reader);
+
+      if (menu_path)
+        proc->menu_paths = g_list_append (proc->menu_paths, menu_path);
+    }
+
+  icon_type        = cache_reader_uint32 (reader);
+  icon_data_length = (gint32) cache_reader_uint32 (reader);
+
+  enum_class = g_type_class_peek (GIMP_TYPE_ICON_TYPE);
+
+  if (reader->error || ! g_enum_get_value (enum_class, icon_type))
+    {
+      reader->error = TRUE;
+      return proc;
+    }
+
+  switch (icon_type)
+    {
+    case GIMP_ICON_TYPE_ICON_NAME:
+    case GIMP_ICON_TYPE_IMAGE_FILE:
+      gimp_plug_in_procedure_set_icon (proc, icon_type,
+                                       (const guint8 *)
+                                       cache_reader_string (reader),
+                                       -1);
+      break;
+
+    case GIMP_ICON_TYPE_INLINE_PIXBUF:
+      {
+        const guint8 *icon_data = NULL;
+
+        if (icon_data_length > 0)
+          icon_data = cache_reader_data (reader, icon_data_length);
+
+        if (! icon_data)
+          {
+            reader->error = TRUE;
+            return proc;
+          }
+
+        gimp_plug_in_procedure_set_icon (proc, icon_type,
+                                         icon_data, icon_data_length);
+      }
+      break;
+    }
+
+  if (cache_reader_uint32 (reader))
+    {
+      const gchar *value;
+
+      proc->file_proc = TRUE;
+
+      g_free (proc->extensions);
+      proc->extensions = cache_reader_dup_string (reader);
+
+      g_free (proc->prefixes);
+      proc->prefixes = cache_reader_dup_string (reader);
+
+      g_free (proc->magics);
+      proc->magics = cache_reader_dup_string (reader);
+
+      value = cache_reader_string (reader);
+      if (value)
+        gimp_plug_in_procedure_set_mime_types (proc, value);
+
+      if (cache_reader_uint32 (reader))
+        gimp_plug_in_procedure_set_handles_uri (proc);
+
+      if (cache_reader_uint32 (reader))
+        gimp_plug_in_procedure_set_handles_raw (proc);
+
+      value = cache_reader_string (reader);
+      if (value)
+        gimp_plug_in_procedure_set_thumb_loader (proc, value);
+    }
+
+  gimp_plug_in_procedure_set_image_types (proc, cache_reader_string (reader));
+
+  n_args        = cache_reader_uint32 (reader);
+  n_return_vals = cache_reader_uint32 (reader);
+
+  for (i = 0; i < n_args && ! reader->error; i++)
+    if (! plug_in_rc_cache_read_arg (gimp, reader, procedure, FALSE))
+      reader->error = TRUE;
+
+  for (i = 0; i < n_return_vals && ! reader->error; i++)
+    if (! plug_in_rc_cache_read_arg (gimp, reader, procedure, TRUE))
+      reader->error = TRUE;
+
+  return proc;
+}
+
+static gboolean
+plug_in_rc_cache_read_arg (Gimp          *gimp,
+                           CacheReader   *reader,
+                           GimpProcedure *procedure,
+                           gboolean       return_value)
+{
+  guint32      arg_type;
+  const gchar *name;
+  const gchar *desc;
+  GParamSpec  *pspec;
+
+  arg_type = cache_reader_uint32 (reader);
+  name     = cache_reader_string (reader);
+  desc     = cache_reader_string (reader);
+
+  if (reader->error || ! name || arg_type >= GIMP_PDB_END)
+    return FALSE;
+
+  pspec = gimp_pdb_compat_param_spec (gimp, arg_type, name, desc);
+
+  if (return_value)
+    gimp_procedure_add_return_value (procedure, pspec);
+  else
+    gimp_procedure_add_argument (procedure, pspec);
+
+  return TRUE;
+}
+
+static void
+plug_in_rc_cache_write_def (GByteArray    *array,
+                            GimpPlugInDef *plug_in_def)
+{
+  GSList  *list;
+  guint32  n_procedures = 0;
+
+  cache_write_string (array, plug_in_def->locale_domain_name);
+  cache_write_string (array, plug_in_def->locale_domain_path);
+  cache_write_string (array, plug_in_def->help_domain_name);
+  cache_write_string (array, plug_in_def->help_domain_uri);
+  cache_write_uint32 (array, plug_in_def->has_init ? 1 : 0);
+
+  for (list = plug_in_def->procedures; list; list = list->next)
+    {
+      GimpPlugInProcedure *proc = list->data;
+
+      if (! proc->installed_during_init)
+        n_procedures++;
+    }
+
+  cache_write_uint32 (array, n_procedures);
+
+  for (list = plug_in_def->procedures; list; list = list->next)
+    {
+      GimpPlugInProcedure *proc = list->data;
+
+      if (! proc->installed_during_init)
+        plug_in_rc_cache_write_procedure (array, proc);
+    }
+}
+
+static void
+plug_in_rc_cache_write_procedure (GByteArray          *array,
+                                  GimpPlugInProcedure *proc)
+{
+  GimpProcedure *procedure = GIMP_PROCEDURE (proc);
+  GList         *list;
+  gint           i;
+
+  cache_write_string (array, procedure->original_name);
+  cache_write_uint32 (array, procedure->proc_type);
+  cache_write_string (array, procedure->blurb);
+  cache_write_string (array, procedure->help);
+  cache_write_string (array, procedure->author);
+  cache_write_string (array, procedure->copyright);
+  cache_write_string (array, procedure->date);
+  cache_write_string (array, proc->menu_label);
+
+  cache_write_uint32 (array, g_list_length (proc->menu_paths));
+  for (list = proc->menu_paths; list; list = list->next)
+    cache_write_string (array, list->data);
+
+  cache_write_uint32 (array, proc->icon_type);
+  cache_write_uint32 (array, (guint32) proc->icon_data_length);
+
+  switch (proc->icon_type)
+    {
+    case GIMP_ICON_TYPE_ICON_NAME:
+    case GIMP_ICON_TYPE_IMAGE_FILE:
+      cache_write_string (array, (const gchar *) proc->icon_data);
+      break;
+
+    case GIMP_ICON_TYPE_INLINE_PIXBUF:
+      g_byte_array_append (array, proc->icon_data, proc->icon_data_length);
+      break;
+    }
+
+  cache_write_uint32 (array, proc->file_proc ? 1 : 0);
+
+  if (proc->file_proc)
+    {
+      cache_write_string (array, proc->extensions);
+      cache_write_string (array, proc->prefixes);
+      cache_write_string (array, proc->magics);
+      cache_write_string (array, proc->mime_types);
+      cache_write_uint32 (array, proc->handles_uri ? 1 : 0);
+      cache_write_uint32 (array,
+                          proc->handles_raw && ! proc->image_types ? 1 : 0);
+      cache_write_string (array, proc->thumb_loader);
+    }
+
+  cache_write_string (array, proc->image_types);
+
+  cache_write_uint32 (array, procedure->num_args);
+  cache_write_uint32 (array, procedure->num_values);
+
+  for (i = 0; i < procedure->num_args; i++)
+    plug_in_rc_cache_write_arg (array, procedure->args[i]);
+
+  for (i = 0; i < procedure->num_values; i++)
+    plug_in_rc_cache_write_arg (array, procedure->values[i]);
+}
+
+static void
+plug_in_rc_cache_write_arg (GByteArray *array,
+                            GParamSpec *pspec)
+{
+  GType type = G_PARAM_SPEC_VALUE_TYPE (pspec);
+
+  cache_write_uint32 (array, gimp_pdb_compat_arg_type_from_gtype (type));
+  cache_write_string (array, g_param_spec_get_name (pspec));
+  cache_write_string (array, g_param_spec_get_blurb (pspec));
+}
+
+static const guint8 *
+cache_reader_data (CacheReader *reader,
+                   gsize        length)
+{
+  const guint8 *data;
+
+  if (reader->error || length > reader->size - reader->offset)
+    {
+      reader->error = TRUE;
+      return NULL;
+    }
+
+  data = reader->data + reader->offset;
+
+  reader->offset += length;
+
+  return data;
+}
+
+static guint32
+cache_reader_uint32 (CacheReader *reader)
+{
+  const guint8 *data  = cache_reader_data (reader, sizeof (guint32));
+  guint32       value = 0;
+
+  /*  the mapped data is not necessarily aligned  */
+  if (data)
+    memcpy (&value, data, sizeof (guint32));
+
+  return value;
+}
+
+static gint64
+cache_reader_int64 (CacheReader *reader)
+{
+  const guint8 *data  = cache_reader_data (reader, sizeof (gint64));
+  gint64        value = 0;
+
+  if (data)
+    memcpy (&value, data, sizeof (gint64));
+
+  return value;
+}
+
+static const gchar *
+cache_reader_string (CacheReader *reader)
+{
+  const guint8 *data;
+  guint32       length;
+
+  length = cache_reader_uint32 (reader);
+
+  if (reader->error || length == PLUG_IN_RC_CACHE_NULL)
+    return NULL;
+
+  data = cache_reader_data (reader, (gsize) length + 1);
+
+  if (! data || data[length] != '\0')
+    {
+      reader->error = TRUE;
+      return NULL;
+    }
+
+  return (const gchar *) data;
+}
+
+static gchar *
+cache_reader_dup_string (CacheReader *reader)
+{
+  return g_strdup (cache_reader_string (reader));
+}
+
+static void
+cache_write_uint32 (GByteArray *array,
+                    guint32     value)
+{
+  g_byte_array_append (array, (const guint8 *) &value, sizeof (guint32));
+}
+
+static void
+cache_write_int64 (GByteArray *array,
+                   gint64      value)
+{
+  g_byte_array_append (array, (const guint8 *) &value, sizeof (gint64));
+}
+
+static void
+cache_write_string (GByteArray  *array,
+                    const gchar *string)
+{
+  if (string)
+    {
+      guint32 length = strlen (string);
+
+      cache_write_uint32 (array, length);
+      g_byte_array_append (array, (const guint8 *) string, length + 1);
+    }
+  else
+    {
+      cache_write_uint32 (array, PLUG_IN_RC_CACHE_NULL);
+    }
+}
@@ -37,4 +37,8 @@ typedef struct _GimpPlugInProcFrame  GimpPlugInProcFrame;
 typedef struct _GimpPlugInShm        GimpPlugInShm;
 
 
+typedef void (* GimpPlugInReturnFunc) (GimpValueArray *return_vals,
+                                       gpointer        user_data);
+
+
 #endif /* __PLUG_IN_TYPES_H__ */
@@ -0,0 +1,1426 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 2009 Martin Nordholts
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include <cairo.h>
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "libgimpmath/gimpmath.h"
+
+#include "widgets/widgets-types.h"
+
+#include "widgets/gimpuimanager.h"
+
+#include "core/gimp.h"
+#include "core/gimpchannel.h"
+#include "core/gimpchannel-select.h"
+#include "core/gimpcontext.h"
+#include "core/gimphistogram.h"
+#include "core/gimpimage.h"
+#include "core/gimplayer.h"
+#include "core/gimplayer-new.h"
+#include "core/gimplayermask.h"
+#include "core/gimpscanconvert.h"
+
+#include "gegl/gimp-gegl-apply-operation.h"
+#include "gegl/gimp-gegl-loops.h"
+#include "gegl/gimp-gegl-nodes.h"
+
+#include "operations/gimpbrightnesscontrastconfig.h"
+#include "operations/gimpcolorbalanceconfig.h"
+#include "operations/gimpcolorchainconfig.h"
+#include "operations/gimpcurvesconfig.h"
+#include "operations/gimphuesaturationconfig.h"
+#include "operations/gimplevelsconfig.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+#define GIMP_TEST_IMAGE_SIZE 100
+#define GIMP_TEST_CHAIN_SIZE 64
+#define GIMP_TEST_HISTOGRAM_WIDTH  600
+#define GIMP_TEST_HISTOGRAM_HEIGHT 400
+#define GIMP_TEST_MORPHOLOGY_RADIUS 24
+#define GIMP_TEST_SHAPEBURST_WIDTH  600
+#define GIMP_TEST_SHAPEBURST_HEIGHT 500
+#define GIMP_TEST_SCAN_CONVERT_WIDTH  700
+#define GIMP_TEST_SCAN_CONVERT_HEIGHT 500
+#define GIMP_TEST_TRANSFORM_WIDTH  97
+#define GIMP_TEST_TRANSFORM_HEIGHT 71
+
+#define ADD_IMAGE_TEST(function) \
+  g_test_add ("/gimp-core/" #function, \
+              GimpTestFixture, \
+              gimp, \
+              gimp_test_image_setup, \
+              function, \
+              gimp_test_image_teardown);
+
+#define ADD_TEST(function) \
+  g_test_add ("/gimp-core/" #function, \
+              GimpTestFixture, \
+              gimp, \
+              NULL, \
+              function, \
+              NULL);
+
+
+typedef struct
+{
+  gint        n_points;
+  GimpVector2 points[4];
+  gboolean    closed;
+} TestPolyline;
+
+typedef struct
+{
+  GimpImage *image;
+} GimpTestFixture;
+
+
+static void gimp_test_image_setup    (GimpTestFixture *fixture,
+                                      gconstpointer    data);
+static void gimp_test_image_teardown (GimpTestFixture *fixture,
+                                      gconstpointer    data);
+
+
+/**
+ * gimp_test_image_setup:
+ * @fixture:
+ * @data:
+ *
+ * Test fixture setup for a single image.
+ **/
+static void
+gimp_test_image_setup (GimpTestFixture *fixture,
+                       gconstpointer    data)
+{
+  Gimp *gimp = GIMP (data);
+
+  fixture->image = gimp_image_new (gimp,
+                                   GIMP_TEST_IMAGE_SIZE,
+                                   GIMP_TEST_IMAGE_SIZE,
+                                   GIMP_RGB,
+                                   GIMP_PRECISION_FLOAT_LINEAR);
+}
+
+/**
+ * gimp_test_image_teardown:
+ * @fixture:
+ * @data:
+ *
+ * Test fixture teardown for a single image.
+ **/
+static void
+gimp_test_image_teardown (GimpTestFixture *fixture,
+                          gconstpointer    data)
+{
+  g_object_unref (fixture->image);
+}
+
+/**
+ * rotate_non_overlapping:
+ * @fixture:
+ * @data:
+ *
+ * Super basic test that makes sure we can add a layer
+ * and call gimp_item_rotate with center at (0, -10)
+ * without triggering a failed assertion .
+ **/
+static void
+rotate_non_overlapping (GimpTestFixture *fixture,
+                        gconstpointer    data)
+{
+  Gimp        *gimp    = GIMP (data);
+  GimpImage   *image   = fixture->image;
+  GimpLayer   *layer;
+  GimpContext *context = gimp_context_new (gimp, "Test", NULL /*template*/);
+  gboolean     result;
+
+  g_assert_cmpint (gimp_image_get_n_layers (image), ==, 0);
+
+  layer = gimp_layer_new (image,
+                          GIMP_TEST_IMAGE_SIZE,
+                          GIMP_TEST_IMAGE_SIZE,
+                          babl_format ("R'G'B'A u8"),
+                          "Test Layer",
+                          GIMP_OPACITY_OPAQUE,
+                          GIMP_LAYER_MODE_NORMAL_LEGACY);
+
+  g_assert_cmpint (GIMP_IS_LAYER (layer), ==, TRUE);
+
+  result = gimp_image_add_layer (image,
+                                 layer,
+                                 GIMP_IMAGE_ACTIVE_PARENT,
+                                 0,
+                                 FALSE);
+
+  gimp_item_rotate (GIMP_ITEM (layer), context, GIMP_ROTATE_90, 0., -10., TRUE);
+
+  g_assert_cmpint (result, ==, TRUE);
+  g_assert_cmpint (gimp_image_get_n_layers (image), ==, 1);
+  g_object_unref (context);
+}
+
+/**
+ * add_layer:
+ * @fixture:
+ * @data:
+ *
+ * Super basic test that makes sure we can add a layer.
+ **/
+static void
+add_layer (GimpTestFixture *fixture,
+           gconstpointer    data)
+{
+  GimpImage *image = fixture->image;
+  GimpLayer *layer;
+  gboolean   result;
+
+  g_assert_cmpint (gimp_image_get_n_layers (image), ==, 0);
+
+  layer = gimp_layer_new (image,
+                          GIMP_TEST_IMAGE_SIZE,
+                          GIMP_TEST_IMAGE_SIZE,
+                          babl_format ("R'G'B'A u8"),
+                          "Test Layer",
+                          GIMP_OPACITY_OPAQUE,
+                          GIMP_LAYER_MODE_NORMAL_LEGACY);
+
+  g_assert_cmpint (GIMP_IS_LAYER (layer), ==, TRUE);
+
+  result = gimp_image_add_layer (image,
+                                 layer,
+                                 GIMP_IMAGE_ACTIVE_PARENT,
+                                 0,
+                                 FALSE);
+
+  g_assert_cmpint (result, ==, TRUE);
+  g_assert_cmpint (gimp_image_get_n_layers (image), ==, 1);
+}
+
+/**
+ * remove_layer:
+ * @fixture:
+ * @data:
+ *
+ * Super basic test that makes sure we can remove a layer.
+ **/
+static void
+remove_layer (GimpTestFixture *fixture,
+              gconstpointer    data)
+{
+  GimpImage *image = fixture->image;
+  GimpLayer *layer;
+  gboolean   result;
+
+  g_assert_cmpint (gimp_image_get_n_layers (image), ==, 0);
+
+  layer = gimp_layer_new (image,
+                          GIMP_TEST_IMAGE_SIZE,
+                          GIMP_TEST_IMAGE_SIZE,
+                          babl_format ("R'G'B'A u8"),
+                          "Test Layer",
+                          GIMP_OPACITY_OPAQUE,
+                          GIMP_LAYER_MODE_NORMAL_LEGACY);
+
+  g_assert_cmpint (GIMP_IS_LAYER (layer), ==, TRUE);
+
+  result = gimp_image_add_layer (image,
+                                 layer,
+                                 GIMP_IMAGE_ACTIVE_PARENT,
+                                 0,
+                                 FALSE);
+
+  g_assert_cmpint (result, ==, TRUE);
+  g_assert_cmpint (gimp_image_get_n_layers (image), ==, 1);
+
+  gimp_image_remove_layer (image,
+                           layer,
+                           FALSE,
+                           NULL);
+
+  g_assert_cmpint (gimp_image_get_n_layers (image), ==, 0);
+}
+
+/**
+ * white_graypoint_in_red_levels:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure the levels algorithm can handle when the graypoint is
+ * white. It's easy to get a divide by zero problem when trying to
+ * calculate what gamma will give a white graypoint.
+ **/
+static void
+white_graypoint_in_red_levels (GimpTestFixture *fixture,
+                               gconstpointer    data)
+{
+  GimpRGB              black   = { 0, 0, 0, 0 };
+  GimpRGB              gray    = { 1, 1, 1, 1 };
+  GimpRGB              white   = { 1, 1, 1, 1 };
+  GimpHistogramChannel channel = GIMP_HISTOGRAM_RED;
+  GimpLevelsConfig    *config;
+
+  config = g_object_new (GIMP_TYPE_LEVELS_CONFIG, NULL);
+
+  gimp_levels_config_adjust_by_colors (config,
+                                       channel,
+                                       &black,
+                                       &gray,
+                                       &white);
+
+  /* Make sure we didn't end up with an invalid gamma value */
+  g_object_set (config,
+                "gamma", config->gamma[channel],
+                NULL);
+}
+
+static void
+apply_color_step (GeglBuffer  *src_buffer,
+                  GeglBuffer  *dest_buffer,
+                  const gchar *operation,
+                  GObject     *config)
+{
+  GeglNode *node;
+
+  node = g_object_new (GEGL_TYPE_NODE,
+                       "operation", operation,
+                       NULL);
+  gegl_node_set (node,
+                 "config", config,
+                 NULL);
+
+  gimp_gegl_apply_operation (src_buffer, NULL, NULL,
+                             node, dest_buffer, NULL);
+
+  g_object_unref (node);
+}
+
+static gdouble
+apply_color_chain (GeglBuffer  *src_buffer,
+                   gint         n_steps,
+                   const gchar *operations[],
+                   GObject     *configs[])
+{
+  GeglRectangle  rect   = { 0, 0, GIMP_TEST_CHAIN_SIZE, GIMP_TEST_CHAIN_SIZE };
+  const Babl    *format = babl_format ("R'G'B'A float");
+  GeglBuffer    *buffer;
+  GeglBuffer    *chain_buffer;
+  GObject       *chain;
+  gfloat        *expected;
+  gfloat        *result;
+  gdouble        max_error = 0.0;
+  gboolean       added;
+  gint           i;
+
+  buffer       = gegl_buffer_dup (src_buffer);
+  chain_buffer = gegl_buffer_new (&rect, format);
+  chain        = gimp_color_chain_config_new ();
+
+  for (i = 0; i < n_steps; i++)
+    {
+      GeglBuffer *step_buffer = gegl_buffer_new (&rect, format);
+
+      apply_color_step (buffer, step_buffer, operations[i], configs[i]);
+
+      g_object_unref (buffer);
+      buffer = step_buffer;
+
+      added = gimp_color_chain_config_add (GIMP_COLOR_CHAIN_CONFIG (chain),
+                                           operations[i], configs[i]);
+      g_assert (added);
+    }
+
+  apply_color_step (src_buffer, chain_buffer, "gimp:color-chain", chain);
+
+  expected = g_new (gfloat, rect.width * rect.height * 4);
+  result   = g_new (gfloat, rect.width * rect.height * 4);
+
+  gegl_buffer_get (buffer, &rect, 1.0, format, expected,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  gegl_buffer_get (chain_buffer, &rect, 1.0, format, result,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (i = 0; i < rect.width * rect.height * 4; i++)
+    max_error = MAX (max_error, fabs (expected[i] - result[i]));
+
+  g_free (expected);
+  g_free (result);
+
+  g_object_unref (chain);
+  g_object_unref (chain_buffer);
+  g_object_unref (buffer);
+
+  return max_error;
+}
+
+/**
+ * color_chain_matches_sequential:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure that applying a chain of color operations in one pass
+ * through "gimp:color-chain" gives the same result as applying them
+ * one after the other, within the precision of its lookup tables.
+ **/
+static void
+color_chain_matches_sequential (GimpTestFixture *fixture,
+                                gconstpointer    data)
+{
+  GeglRectangle  rect   = { 0, 0, GIMP_TEST_CHAIN_SIZE, GIMP_TEST_CHAIN_SIZE };
+  const Babl    *format = babl_format ("R'G'B'A float");
+  const gdouble  points[] = { 0.0, 0.0, 0.4, 0.55, 1.0, 1.0 };
+  const gchar   *operations[5];
+  GObject       *configs[5];
+  GeglBuffer    *buffer;
+  gfloat        *pixels;
+  gint           i;
+
+  buffer = gegl_buffer_new (&rect, format);
+  pixels = g_new (gfloat, rect.width * rect.height * 4);
+
+  for (i = 0; i < rect.width * rect.height * 4; i++)
+    pixels[i] = g_test_rand_double_range (0.0, 1.0);
+
+  /*  a few pixels outside [0, 1], which bypass the lookup tables  */
+  pixels[0] = 1.5;
+  pixels[1] = 1.2;
+  pixels[6] = 1.25;
+
+  gegl_buffer_set (buffer, &rect, 0, format, pixels, GEGL_AUTO_ROWSTRIDE);
+  g_free (pixels);
+
+  operations[0] = "gimp:levels";
+  configs[0]    = g_object_new (GIMP_TYPE_LEVELS_CONFIG,
+                                "gamma",     1.4,
+                                "low-input", 0.05,
+                                NULL);
+
+  operations[1] = "gimp:curves";
+  configs[1]    = gimp_curves_config_new_spline (GIMP_HISTOGRAM_VALUE,
+                                                 points,
+                                                 G_N_ELEMENTS (points) / 2);
+
+  operations[2] = "gimp:brightness-contrast";
+  configs[2]    = g_object_new (GIMP_TYPE_BRIGHTNESS_CONTRAST_CONFIG,
+                                "brightness", 0.1,
+                                "contrast",   0.2,
+                                NULL);
+
+  /*  separable chains use one curve per channel  */
+  g_assert_cmpfloat (apply_color_chain (buffer, 3, operations, configs),
+                     <, 1e-3);
+
+  operations[3] = "gimp:hue-saturation";
+  configs[3]    = g_object_new (GIMP_TYPE_HUE_SATURATION_CONFIG,
+                                "hue",        0.1,
+                                "saturation", 0.2,
+                                NULL);
+
+  operations[4] = "gimp:color-balance";
+  configs[4]    = g_object_new (GIMP_TYPE_COLOR_BALANCE_CONFIG,
+                                "cyan-red",            0.2,
+                                "yellow-blue",         -0.1,
+                                "preserve-luminosity", TRUE,
+                                NULL);
+
+  /*  all other chains use an interpolated RGB lattice  */
+  g_assert_cmpfloat (apply_color_chain (buffer, 5, operations, configs),
+                     <, 2e-2);
+
+  for (i = 0; i < G_N_ELEMENTS (configs); i++)
+    g_object_unref (configs[i]);
+
+  g_object_unref (buffer);
+}
+
+static void
+fill_random_u16 (GeglBuffer          *buffer,
+                 const GeglRectangle *rect)
+{
+  const Babl *format = gegl_buffer_get_format (buffer);
+  guint16    *pixels;
+  gint        i;
+
+  pixels = g_new (guint16, rect->width * rect->height * 4);
+
+  for (i = 0; i < rect->width * rect->height * 4; i++)
+    pixels[i] = g_test_rand_int_range (0, 65536);
+
+  gegl_buffer_set (buffer, rect, 0, format, pixels, GEGL_AUTO_ROWSTRIDE);
+  g_free (pixels);
+}
+
+static GimpHistogram *
+calculate_histogram (GeglBuffer    *buffer,
+                     GimpHistogram *histogram)
+{
+  if (! histogram)
+    histogram = gimp_histogram_new (FALSE);
+
+  gimp_histogram_calculate (histogram, buffer,
+                            gegl_buffer_get_extent (buffer),
+                            NULL, NULL);
+
+  return histogram;
+}
+
+static void
+assert_histograms_equal (GimpHistogram *a,
+                         GimpHistogram *b,
+                         gdouble        max_difference)
+{
+  gint channel;
+  gint bin;
+
+  g_assert_cmpint (gimp_histogram_n_channels (a), ==,
+                   gimp_histogram_n_channels (b));
+  g_assert_cmpint (gimp_histogram_n_bins (a), ==,
+                   gimp_histogram_n_bins (b));
+
+  for (channel = GIMP_HISTOGRAM_VALUE;
+       channel <= GIMP_HISTOGRAM_LUMINANCE;
+       channel++)
+    {
+      gdouble difference = 0.0;
+
+      for (bin = 0; bin < gimp_histogram_n_bins (a); bin++)
+        {
+          difference += fabs (gimp_histogram_get_value (a, channel, bin) -
+                              gimp_histogram_get_value (b, channel, bin));
+        }
+
+      g_assert_cmpfloat (difference, <=, max_difference);
+    }
+}
+
+/**
+ * histogram_paths_match:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure that binning u16 pixels directly gives the same
+ * histogram as binning them converted to float, and that an
+ * incremental histogram matches a full recalculation after part of
+ * the buffer changed.
+ **/
+static void
+histogram_paths_match (GimpTestFixture *fixture,
+                       gconstpointer    data)
+{
+  GeglRectangle  rect = { 0, 0,
+                          GIMP_TEST_HISTOGRAM_WIDTH,
+                          GIMP_TEST_HISTOGRAM_HEIGHT };
+  GeglRectangle  dirty = { 100, 300, 200, 50 };
+  GeglBuffer    *buffer;
+  GeglBuffer    *float_buffer;
+  GimpHistogram *integer_histogram;
+  GimpHistogram *float_histogram;
+  GimpHistogram *incremental;
+
+  buffer = gegl_buffer_new (&rect, babl_format ("R'G'B'A u16"));
+  fill_random_u16 (buffer, &rect);
+
+  float_buffer = gegl_buffer_new (&rect, babl_format ("R'G'B'A float"));
+  gegl_buffer_copy (buffer, NULL, GEGL_ABYSS_NONE, float_buffer, NULL);
+
+  integer_histogram = calculate_histogram (buffer,       NULL);
+  float_histogram   = calculate_histogram (float_buffer, NULL);
+
+  /*  allow for a few values rounded into the neighbouring bin  */
+  assert_histograms_equal (integer_histogram, float_histogram,
+                           rect.width * rect.height * 1e-4);
+
+  incremental = gimp_histogram_new (FALSE);
+  gimp_histogram_set_incremental (incremental, TRUE);
+
+  calculate_histogram (buffer, incremental);
+
+  fill_random_u16 (buffer, &dirty);
+  gimp_histogram_invalidate (incremental, &dirty);
+
+  calculate_histogram (buffer, incremental);
+  calculate_histogram (buffer, integer_histogram);
+
+  assert_histograms_equal (incremental, integer_histogram, 1e-6);
+
+  g_object_unref (incremental);
+  g_object_unref (float_histogram);
+  g_object_unref (integer_histogram);
+  g_object_unref (float_buffer);
+  g_object_unref (buffer);
+}
+
+/*  reference implementations of grow, shrink and border, giving the
+ *  same results as the original per-pixel algorithms
+ */
+static gint
+reference_reach (gint radius_x,
+                 gint radius_y,
+                 gint dx)
+{
+  gdouble tmp = dx ? ABS (dx) - 0.5 : 0.0;
+
+  return RINT (radius_y / (gdouble) radius_x *
+               sqrt (SQR (radius_x) - SQR (tmp)));
+}
+
+/*  the maximum (or, with erode, minimum) within the ellipse around
+ *  every pixel, pixels outside count as 0.0 unless edge_lock is set
+ */
+static void
+reference_morphology (const gfloat *src,
+                      gfloat       *dest,
+                      gint          width,
+                      gint          height,
+                      gint          radius_x,
+                      gint          radius_y,
+                      gboolean      erode,
+                      gboolean      edge_lock)
+{
+  gint x, y, dx, dy;
+
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      {
+        gfloat value = src[y * width + x];
+
+        for (dx = -radius_x; dx <= radius_x; dx++)
+          {
+            gint reach = reference_reach (radius_x, radius_y, dx);
+
+            for (dy = -reach; dy <= reach; dy++)
+              {
+                gint   sx = x + dx;
+                gint   sy = y + dy;
+                gfloat s;
+
+                if (sx >= 0 && sx < width && sy >= 0 && sy < height)
+                  s = src[sy * width + sx];
+                else if (edge_lock)
+                  continue;
+                else
+                  s = 0.0;
+
+                value = erode ? MIN (value, s) : MAX (value, s);
+              }
+          }
+
+        dest[y * width + x] = value;
+      }
+}
+
+static gboolean
+reference_selected (const gfloat *src,
+                    gint          width,
+                    gint          height,
+                    gint          x,
+                    gint          y,
+                    gboolean      edge_lock)
+{
+  if (x < 0 || x >= width || y < 0 || y >= height)
+    return edge_lock;
+
+  return src[y * width + x] >= 0.5;
+}
+
+/*  the border operation's transitions: selected pixels with an
+ *  unselected neighbour
+ */
+static gboolean
+reference_transition (const gfloat *src,
+                      gint          width,
+                      gint          height,
+                      gint          x,
+                      gint          y,
+                      gboolean      edge_lock)
+{
+  gint dx, dy;
+
+  if (! reference_selected (src, width, height, x, y, FALSE))
+    return FALSE;
+
+  for (dy = -1; dy <= 1; dy++)
+    for (dx = -1; dx <= 1; dx++)
+      if (! reference_selected (src, width, height, x + dx, y + dy, edge_lock))
+        return TRUE;
+
+  return FALSE;
+}
+
+static void
+reference_border (const gfloat *src,
+                  gfloat       *dest,
+                  gint          width,
+                  gint          height,
+                  gint          radius_x,
+                  gint          radius_y,
+                  gboolean      feather,
+                  gboolean      edge_lock)
+{
+  gint x, y, dx, dy;
+
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      {
+        gfloat value = 0.0;
+
+        if (radius_x == 1 && radius_y == 1)
+          {
+            dest[y * width + x] = reference_transition (src, width, height,
+                                                        x, y, edge_lock);
+            continue;
+          }
+
+        for (dy = -radius_y; dy <= radius_y; dy++)
+          for (dx = -radius_x; dx <= radius_x; dx++)
+            {
+              gint    tx = x + dx;
+              gint    ty = y + dy;
+              gdouble fx = dx ? ABS (dx) - 0.5 : 0.0;
+              gdouble fy = dy ? ABS (dy) - 0.5 : 0.0;
+              gdouble dist;
+
+              if (tx < 0 || tx >= width || ty < 0)
+                continue;
+
+              /*  with edge lock, the last row and the rows below it
+               *  repeat the transitions of the row above the last one
+               */
+              if (ty >= height)
+                {
+                  if (! edge_lock)
+                    continue;
+
+                  ty = height - 1;
+                }
+
+              if (edge_lock && ty == height - 1)
+                ty = height - 2;
+
+              if (! reference_transition (src, width, height,
+                                          tx, ty, edge_lock))
+                continue;
+
+              dist = (SQR (fx) / SQR (radius_x) +
+                      SQR (fy) / SQR (radius_y));
+
+              if (dist < 1.0)
+                value = MAX (value, feather ? 1.0 - sqrt (dist) : 1.0);
+            }
+
+        dest[y * width + x] = value;
+      }
+}
+
+static void
+get_selection (GimpImage *image,
+               gfloat    *pixels)
+{
+  GimpChannel *mask = gimp_image_get_mask (image);
+
+  gegl_buffer_get (gimp_drawable_get_buffer (GIMP_DRAWABLE (mask)),
+                   GEGL_RECTANGLE (0, 0,
+                                   GIMP_TEST_IMAGE_SIZE,
+                                   GIMP_TEST_IMAGE_SIZE),
+                   1.0, babl_format ("Y float"), pixels,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+}
+
+static void
+set_selection (GimpImage    *image,
+               const gfloat *pixels)
+{
+  GimpChannel *mask = gimp_image_get_mask (image);
+  GeglBuffer  *buffer;
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0,
+                                            GIMP_TEST_IMAGE_SIZE,
+                                            GIMP_TEST_IMAGE_SIZE),
+                            babl_format ("Y float"));
+
+  gegl_buffer_set (buffer, NULL, 0, babl_format ("Y float"), pixels,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  gimp_drawable_set_buffer (GIMP_DRAWABLE (mask), FALSE, NULL, buffer);
+  g_object_unref (buffer);
+}
+
+static void
+assert_selection_equals (GimpImage    *image,
+                         const gfloat *expected)
+{
+  gint    n_pixels = SQR (GIMP_TEST_IMAGE_SIZE);
+  gfloat *result   = g_new (gfloat, n_pixels);
+  gint    i;
+
+  get_selection (image, result);
+
+  for (i = 0; i < n_pixels; i++)
+    g_assert_cmpfloat (fabs (result[i] - expected[i]), <, 1e-6);
+
+  g_free (result);
+}
+
+/*  grows, shrinks and borders the selection with all radii, with and
+ *  without edge lock, and compares the result against the reference
+ *  implementations
+ */
+static void
+check_selection_morphology (GimpImage    *image,
+                            const gfloat *selection)
+{
+  const gint   radii[][2] = { { 0, 0 },
+                              { 1, 1 },
+                              { GIMP_TEST_MORPHOLOGY_RADIUS,
+                                GIMP_TEST_MORPHOLOGY_RADIUS },
+                              { GIMP_TEST_MORPHOLOGY_RADIUS, 9 } };
+  GimpChannel *mask     = gimp_image_get_mask (image);
+  gint         n_pixels = SQR (GIMP_TEST_IMAGE_SIZE);
+  gfloat      *expected = g_new (gfloat, n_pixels);
+  gint         i;
+
+  for (i = 0; i < G_N_ELEMENTS (radii); i++)
+    {
+      gint     radius_x = radii[i][0];
+      gint     radius_y = radii[i][1];
+      gboolean edge_lock;
+
+      set_selection (image, selection);
+      gimp_channel_grow (mask, radius_x, radius_y, FALSE);
+
+      if (radius_x > 0)
+        reference_morphology (selection, expected,
+                              GIMP_TEST_IMAGE_SIZE, GIMP_TEST_IMAGE_SIZE,
+                              radius_x, radius_y, FALSE, FALSE);
+      else
+        memcpy (expected, selection, n_pixels * sizeof (gfloat));
+
+      assert_selection_equals (image, expected);
+
+      for (edge_lock = FALSE; edge_lock <= TRUE; edge_lock++)
+        {
+          gboolean feather;
+
+          set_selection (image, selection);
+          gimp_channel_shrink (mask, radius_x, radius_y, edge_lock, FALSE);
+
+          if (radius_x > 0)
+            reference_morphology (selection, expected,
+                                  GIMP_TEST_IMAGE_SIZE, GIMP_TEST_IMAGE_SIZE,
+                                  radius_x, radius_y, TRUE, edge_lock);
+          else
+            memcpy (expected, selection, n_pixels * sizeof (gfloat));
+
+          assert_selection_equals (image, expected);
+
+          for (feather = FALSE; feather <= TRUE; feather++)
+            {
+              set_selection (image, selection);
+              gimp_channel_border (mask, radius_x, radius_y,
+                                   feather ?
+                                   GIMP_CHANNEL_BORDER_STYLE_FEATHERED :
+                                   GIMP_CHANNEL_BORDER_STYLE_HARD,
+                                   edge_lock, FALSE);
+
+              /*  a border of radius 0 clears the selection  */
+              if (radius_x > 0)
+                reference_border (selection, expected,
+                                  GIMP_TEST_IMAGE_SIZE, GIMP_TEST_IMAGE_SIZE,
+                                  radius_x, radius_y, feather, edge_lock);
+              else
+                memset (expected, 0, n_pixels * sizeof (gfloat));
+
+              assert_selection_equals (image, expected);
+            }
+        }
+    }
+
+  g_free (expected);
+}
+
+/**
+ * selection_morphology_matches_reference:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure that growing, shrinking and bordering a selection which
+ * touches the image edges gives the same result as the original
+ * algorithms, with and without edge lock, for radius 0, radius 1 and
+ * large radii. The feathered selection has too many distinct values
+ * for the per-level passes and goes through the sliding window, the
+ * hard and the three-level selections go through the per-level
+ * passes at every radius.
+ **/
+static void
+selection_morphology_matches_reference (GimpTestFixture *fixture,
+                                        gconstpointer    data)
+{
+  GimpImage *image     = fixture->image;
+  gint       n_pixels  = SQR (GIMP_TEST_IMAGE_SIZE);
+  gfloat    *feathered = g_new (gfloat, n_pixels);
+  gfloat    *hard      = g_new (gfloat, n_pixels);
+  gfloat    *levels    = g_new (gfloat, n_pixels);
+  GRand     *rand      = g_rand_new_with_seed (42);
+  gint       x, y;
+
+  /*  a feathered ellipse cut off by the left edge, and a rectangle in
+   *  the bottom right corner
+   */
+  for (y = 0; y < GIMP_TEST_IMAGE_SIZE; y++)
+    for (x = 0; x < GIMP_TEST_IMAGE_SIZE; x++)
+      {
+        gint    i     = y * GIMP_TEST_IMAGE_SIZE + x;
+        gdouble dx    = (x - 30) / 45.0;
+        gdouble dy    = (y - 55) / 30.0;
+        gfloat  value = CLAMP (3.0 * (1.0 - sqrt (SQR (dx) + SQR (dy))),
+                               0.0, 1.0);
+
+        if (x >= 70 && y >= 80)
+          value = 1.0;
+
+        feathered[i] = value;
+
+        /*  the same shapes with hard edges, and noise of single
+         *  pixels and holes
+         */
+        hard[i] = value >= 0.5;
+
+        if (g_rand_int_range (rand, 0, 50) == 0)
+          hard[i] = ! hard[i];
+
+        /*  the same shapes with only the levels 0, 0.5 and 1  */
+        levels[i] = RINT (2.0 * value) / 2.0;
+      }
+
+  check_selection_morphology (image, feathered);
+  check_selection_morphology (image, hard);
+  check_selection_morphology (image, levels);
+
+  g_rand_free (rand);
+  g_free (levels);
+  g_free (hard);
+  g_free (feathered);
+}
+
+static gfloat *
+apply_shapeburst (GeglBuffer *buffer,
+                  gboolean    normalize,
+                  gboolean    chamfer)
+{
+  const GeglRectangle *rect = gegl_buffer_get_extent (buffer);
+  GeglBuffer          *dest_buffer;
+  GeglNode            *node;
+  gfloat              *result;
+
+  dest_buffer = gegl_buffer_new (rect, babl_format ("Y float"));
+
+  node = gegl_node_new_child (NULL,
+                              "operation", "gimp:shapeburst",
+                              "normalize", normalize,
+                              "chamfer",   chamfer,
+                              NULL);
+
+  gimp_gegl_apply_operation (buffer, NULL, NULL,
+                             node, dest_buffer, NULL);
+
+  result = g_new (gfloat, rect->width * rect->height);
+
+  gegl_buffer_get (dest_buffer, rect, 1.0, babl_format ("Y float"), result,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  g_object_unref (node);
+  g_object_unref (dest_buffer);
+
+  return result;
+}
+
+/**
+ * shapeburst_matches_distance:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure that gimp:shapeburst gives every selected pixel its
+ * Euclidean distance to the nearest unselected pixel, minus one plus
+ * its coverage, that the chamfer approximation stays close to it,
+ * and that both hold across the strips the operation works in.
+ **/
+static void
+shapeburst_matches_distance (GimpTestFixture *fixture,
+                             gconstpointer    data)
+{
+  const gint     width    = GIMP_TEST_SHAPEBURST_WIDTH;
+  const gint     height   = GIMP_TEST_SHAPEBURST_HEIGHT;
+  const gint     hole_x   = 230;
+  const gint     hole_y   = 310;
+  GeglRectangle  rect     = { 0, 0, width, height };
+  GeglBuffer    *buffer;
+  gfloat        *selection;
+  gfloat        *exact;
+  gfloat        *chamfer;
+  gfloat        *normalized;
+  gfloat         max_dist = 0.0;
+  gint           x, y;
+
+  /*  everything is selected, except for one pixel, and outside of the
+   *  buffer, which counts as unselected
+   */
+  selection = g_new (gfloat, width * height);
+
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      selection[y * width + x] = 1.0;
+
+  selection[hole_y * width + hole_x]       = 0.0;
+  selection[hole_y * width + hole_x + 100] = 0.25;
+
+  buffer = gegl_buffer_new (&rect, babl_format ("Y float"));
+  gegl_buffer_set (buffer, NULL, 0, babl_format ("Y float"), selection,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  exact      = apply_shapeburst (buffer, FALSE, FALSE);
+  chamfer    = apply_shapeburst (buffer, FALSE, TRUE);
+  normalized = apply_shapeburst (buffer, TRUE,  FALSE);
+
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      {
+        gint    i    = y * width + x;
+        gdouble dist = MIN (MIN (x + 1, width - x), MIN (y + 1, height - y));
+
+        dist = MIN (dist, sqrt (SQR (x - hole_x) + SQR (y - hole_y)));
+
+        if (selection[i] > 0.0)
+          dist += selection[i] - 1.0;
+
+        g_assert_cmpfloat (fabs (exact[i] - dist), <, 1e-4);
+
+        /*  the 3-4 chamfer distance is within 6% of the exact one  */
+        g_assert_cmpfloat (fabs (chamfer[i] - dist), <=, 0.06 * dist + 1e-4);
+
+        max_dist = MAX (max_dist, exact[i]);
+      }
+
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      {
+        gint i = y * width + x;
+
+        g_assert_cmpfloat (fabs (normalized[i] - exact[i] / max_dist),
+                           <, 1e-6);
+      }
+
+  g_free (normalized);
+  g_free (chamfer);
+  g_free (exact);
+  g_free (selection);
+
+  g_object_unref (buffer);
+}
+
+/**
+ * layer_mask_from_channel:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure that a layer mask created from a channel, for a layer
+ * partly outside of the image, isn't considered empty because it was
+ * cleared before the channel was copied into it.
+ **/
+static void
+layer_mask_from_channel (GimpTestFixture *fixture,
+                         gconstpointer    data)
+{
+  GimpImage     *image = fixture->image;
+  GimpRGB        black = { 0.0, 0.0, 0.0, GIMP_OPACITY_OPAQUE };
+  GimpLayer     *layer;
+  GimpChannel   *channel;
+  GimpLayerMask *mask;
+  gboolean       result;
+  gint           x, y, width, height;
+
+  layer = gimp_layer_new (image,
+                          GIMP_TEST_IMAGE_SIZE,
+                          GIMP_TEST_IMAGE_SIZE,
+                          babl_format ("R'G'B'A u8"),
+                          "Test Layer",
+                          GIMP_OPACITY_OPAQUE,
+                          GIMP_LAYER_MODE_NORMAL_LEGACY);
+  gimp_item_set_offset (GIMP_ITEM (layer), -20, -10);
+
+  channel = gimp_channel_new (image,
+                              GIMP_TEST_IMAGE_SIZE,
+                              GIMP_TEST_IMAGE_SIZE,
+                              "Test Channel", &black);
+  gimp_channel_select_rectangle (channel, 30, 40, 20, 25,
+                                 GIMP_CHANNEL_OP_REPLACE,
+                                 FALSE, 0.0, 0.0, FALSE);
+
+  mask = gimp_layer_create_mask (layer, GIMP_ADD_MASK_CHANNEL, channel);
+
+  g_assert (! gimp_channel_is_empty (GIMP_CHANNEL (mask)));
+
+  result = gimp_item_bounds (GIMP_ITEM (mask), &x, &y, &width, &height);
+
+  g_assert_cmpint (result, ==, TRUE);
+
+  g_assert_cmpint (x,      ==, 50);
+  g_assert_cmpint (y,      ==, 50);
+  g_assert_cmpint (width,  ==, 20);
+  g_assert_cmpint (height, ==, 25);
+
+  g_object_unref (mask);
+  g_object_unref (channel);
+  g_object_unref (layer);
+}
+
+static const TestPolyline test_polylines[] =
+{
+  /*  a triangle inside a square, which even-odd filling turns into a
+   *  square with a hole
+   */
+  { 3, { { 10.0, 10.0 }, { 60.5, 14.0 }, { 30.0, 45.0 } }, TRUE },
+  { 4, { { 5.0, 5.0 }, { 80.0, 5.0 }, { 80.0, 80.0 }, { 5.0, 80.0 } }, TRUE },
+
+  /*  an open polyline far away from the others  */
+  { 3, { { 600.0, 400.0 }, { 650.3, 480.2 }, { 690.0, 410.0 } }, FALSE },
+
+  /*  a line crossing most of the tiles  */
+  { 2, { { 20.0, 470.0 }, { 680.0, 30.0 } }, FALSE }
+};
+
+/*  renders test_polylines the way gimp_scan_convert_render() did before
+ *  it culled subpaths, with one cairo context for the whole buffer
+ */
+static guchar *
+render_polylines_reference (gboolean stroke,
+                            gint     off_x,
+                            gint     off_y)
+{
+  const gint       width  = GIMP_TEST_SCAN_CONVERT_WIDTH;
+  const gint       height = GIMP_TEST_SCAN_CONVERT_HEIGHT;
+  cairo_surface_t *surface;
+  cairo_t         *cr;
+  guchar          *pixels;
+  gint             i, j;
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_A8, width, height);
+  cairo_surface_set_device_offset (surface, -off_x, -off_y);
+
+  cr = cairo_create (surface);
+  cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+  cairo_set_source_rgba (cr, 0, 0, 0, 1.0);
+
+  for (i = 0; i < G_N_ELEMENTS (test_polylines); i++)
+    {
+      const TestPolyline *polyline = &test_polylines[i];
+
+      cairo_move_to (cr, polyline->points[0].x, polyline->points[0].y);
+
+      for (j = 1; j < polyline->n_points; j++)
+        cairo_line_to (cr, polyline->points[j].x, polyline->points[j].y);
+
+      if (polyline->closed)
+        cairo_close_path (cr);
+    }
+
+  cairo_set_antialias (cr, CAIRO_ANTIALIAS_GRAY);
+  cairo_set_miter_limit (cr, 10.0);
+
+  if (stroke)
+    {
+      cairo_set_line_cap (cr, CAIRO_LINE_CAP_SQUARE);
+      cairo_set_line_join (cr, CAIRO_LINE_JOIN_MITER);
+      cairo_set_line_width (cr, 9.0);
+      cairo_stroke (cr);
+    }
+  else
+    {
+      cairo_set_fill_rule (cr, CAIRO_FILL_RULE_EVEN_ODD);
+      cairo_fill (cr);
+    }
+
+  cairo_destroy (cr);
+  cairo_surface_flush (surface);
+
+  pixels = g_new (guchar, width * height);
+
+  for (i = 0; i < height; i++)
+    memcpy (pixels + i * width,
+            cairo_image_surface_get_data (surface) +
+            i * cairo_image_surface_get_stride (surface),
+            width);
+
+  cairo_surface_destroy (surface);
+
+  return pixels;
+}
+
+/**
+ * scan_convert_matches_full_render:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure that rendering a scan conversion only where its subpaths
+ * are, on several threads, gives the same pixels as rendering all of
+ * it at once, when stroking and when filling, with and without an
+ * offset.
+ **/
+static void
+scan_convert_matches_full_render (GimpTestFixture *fixture,
+                                  gconstpointer    data)
+{
+  const gint     width   = GIMP_TEST_SCAN_CONVERT_WIDTH;
+  const gint     height  = GIMP_TEST_SCAN_CONVERT_HEIGHT;
+  GeglRectangle  rect    = { 0, 0, width, height };
+  GeglColor     *white;
+  gint           n_threads;
+  gint           pass;
+
+  /*  make sure the render is split up  */
+  g_object_get (gegl_config (), "threads", &n_threads, NULL);
+  g_object_set (gegl_config (), "threads", 4, NULL);
+
+  white = gegl_color_new ("white");
+
+  for (pass = 0; pass < 4; pass++)
+    {
+      gboolean         stroke = pass & 1;
+      gint             off_x  = (pass & 2) ? 13 : 0;
+      gint             off_y  = (pass & 2) ? -9 : 0;
+      GimpScanConvert *sc;
+      GeglBuffer      *buffer;
+      guchar          *expected;
+      guchar          *pixels;
+      gint             n_set = 0;
+      gint             i;
+
+      sc = gimp_scan_convert_new ();
+
+      for (i = 0; i < G_N_ELEMENTS (test_polylines); i++)
+        gimp_scan_convert_add_polyline (sc,
+                                        test_polylines[i].n_points,
+                                        test_polylines[i].points,
+                                        test_polylines[i].closed);
+
+      if (stroke)
+        gimp_scan_convert_stroke (sc, 9.0,
+                                  GIMP_JOIN_MITER, GIMP_CAP_SQUARE, 10.0,
+                                  0.0, NULL);
+
+      buffer = gegl_buffer_new (&rect, babl_format ("Y u8"));
+
+      /*  the render must replace what is outside of the culled area  */
+      gegl_buffer_set_color (buffer, NULL, white);
+
+      gimp_scan_convert_render (sc, buffer, off_x, off_y, TRUE);
+
+      pixels = g_new (guchar, width * height);
+      gegl_buffer_get (buffer, NULL, 1.0, babl_format ("Y u8"), pixels,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      expected = render_polylines_reference (stroke, off_x, off_y);
+
+      for (i = 0; i < width * height; i++)
+        {
+          /*  allow for rounding in cairo's rasterizer  */
+          g_assert_cmpint (ABS (pixels[i] - expected[i]), <=, 1);
+
+          if (expected[i])
+            n_set++;
+        }
+
+      g_assert_cmpint (n_set, >, 0);
+
+      g_free (expected);
+      g_free (pixels);
+      g_object_unref (buffer);
+      gimp_scan_convert_free (sc);
+    }
+
+  g_object_unref (white);
+
+  g_object_set (gegl_config (), "threads", n_threads, NULL);
+}
+
+/**
+ * transform_matches_gegl_transform:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure that gimp_gegl_transform() renders what gegl:transform
+ * renders, both for the transforms it copies pixel by pixel (the
+ * identity, enlarging, flips and rotations by 90 degrees) and for the
+ * reductions it resamples.
+ **/
+static void
+transform_matches_gegl_transform (GimpTestFixture *fixture,
+                                  gconstpointer    data)
+{
+  static const struct
+  {
+    gdouble               coeff[2][3];
+    GimpInterpolationType interpolation;
+  }
+  transforms[] =
+  {
+    /*  identity  */
+    { { { 1.0, 0.0,  0.0 }, { 0.0, 1.0,  0.0 } }, GIMP_INTERPOLATION_NONE   },
+    { { { 1.0, 0.0,  0.0 }, { 0.0, 1.0,  0.0 } }, GIMP_INTERPOLATION_LINEAR },
+
+    /*  integer enlarging, with a translation  */
+    { { { 3.0, 0.0,  5.0 }, { 0.0, 2.0, -4.0 } }, GIMP_INTERPOLATION_NONE   },
+
+    /*  reduction  */
+    { { { 0.5, 0.0,  3.0 }, { 0.0, 0.25, 1.0 } }, GIMP_INTERPOLATION_NONE   },
+
+    /*  horizontal flip  */
+    { { { -1.0, 0.0, GIMP_TEST_TRANSFORM_WIDTH }, { 0.0, 1.0, 0.0 } },
+      GIMP_INTERPOLATION_LINEAR },
+
+    /*  rotation by 90 degrees  */
+    { { { 0.0, -1.0, GIMP_TEST_TRANSFORM_HEIGHT }, { 1.0, 0.0, 0.0 } },
+      GIMP_INTERPOLATION_NONE }
+  };
+
+  const gint     width     = GIMP_TEST_TRANSFORM_WIDTH;
+  const gint     height    = GIMP_TEST_TRANSFORM_HEIGHT;
+  const Babl    *format    = babl_format ("R'G'B'A float");
+  GeglRectangle  src_rect  = { 0, 0, width, height };
+  GeglRectangle  dest_rect = { -40, -40, 400, 220 };
+  GeglBuffer    *src_buffer;
+  gfloat        *src;
+  gfloat        *result;
+  gfloat        *expected;
+  gint           n_pixels  = dest_rect.width * dest_rect.height;
+  gint           t;
+  gint           x, y;
+
+  src = g_new (gfloat, width * height * 4);
+
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      {
+        gfloat *p = src + (y * width + x) * 4;
+
+        p[0] = (gfloat) x / width;
+        p[1] = (gfloat) y / height;
+        p[2] = ((x * 7 + y * 13) % 17) / 16.0;
+        p[3] = ((x + y) % 3) ? 1.0 : 0.5;
+      }
+
+  src_buffer = gegl_buffer_new (&src_rect, format);
+  gegl_buffer_set (src_buffer, NULL, 0, format, src, GEGL_AUTO_ROWSTRIDE);
+
+  result   = g_new (gfloat, n_pixels * 4);
+  expected = g_new (gfloat, n_pixels * 4);
+
+  for (t = 0; t < G_N_ELEMENTS (transforms); t++)
+    {
+      GimpMatrix3  matrix;
+      GeglBuffer  *dest_buffer;
+      GeglBuffer  *ref_buffer;
+      GeglNode    *node;
+      gint         i;
+
+      gimp_matrix3_identity (&matrix);
+
+      for (i = 0; i < 2; i++)
+        for (x = 0; x < 3; x++)
+          matrix.coeff[i][x] = transforms[t].coeff[i][x];
+
+      dest_buffer = gegl_buffer_new (&dest_rect, format);
+      ref_buffer  = gegl_buffer_new (&dest_rect, format);
+
+      gimp_gegl_transform (src_buffer, dest_buffer, &dest_rect,
+                           &matrix, transforms[t].interpolation);
+
+      node = gegl_node_new_child (NULL,
+                                  "operation", "gegl:transform",
+                                  "sampler",   transforms[t].interpolation,
+                                  NULL);
+      gimp_gegl_node_set_matrix (node, &matrix);
+
+      gimp_gegl_apply_operation (src_buffer, NULL, NULL,
+                                 node, ref_buffer, &dest_rect);
+
+      g_object_unref (node);
+
+      gegl_buffer_get (dest_buffer, &dest_rect, 1.0, format, result,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+      gegl_buffer_get (ref_buffer, &dest_rect, 1.0, format, expected,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      for (i = 0; i < n_pixels * 4; i++)
+        g_assert_cmpfloat (fabs (result[i] - expected[i]), <, 1e-5);
+
+      g_object_unref (ref_buffer);
+      g_object_unref (dest_buffer);
+    }
+
+  g_free (expected);
+  g_free (result);
+  g_free (src);
+
+  g_object_unref (src_buffer);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp *gimp;
+  int   result;
+
+  g_test_init (&argc, &argv, NULL);
+
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  /* We share the same application instance across all tests */
+  gimp = gimp_init_for_testing ();
+
+  /* Add tests */
+  ADD_IMAGE_TEST (add_layer);
+  ADD_IMAGE_TEST (remove_layer);
+  ADD_IMAGE_TEST (rotate_non_overlapping);
+  ADD_TEST (white_graypoint_in_red_levels);
+  ADD_TEST (color_chain_matches_sequential);
+  ADD_TEST (histogram_paths_match);
+  ADD_IMAGE_TEST (selection_morphology_matches_reference);
+  ADD_TEST (shapeburst_matches_distance);
+  ADD_IMAGE_TEST (layer_mask_from_channel);
+  ADD_TEST (scan_convert_matches_full_render);
+  ADD_TEST (transform_matches_gegl_transform);
+
+  /* Run the tests */
+  result = g_test_run ();
+
+  /* Don't write files to the source dir */
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
+                                       "app/tests/gimpdir-output");
+
+  /* Exit so we don't break script-fu plug-in wire */
+  gimp_exit (gimp, TRUE);
+
+  return result;
+}
@@ -37,7 +37,8 @@ enum
 {
   PROP_0,
   PROP_CAGE_MODE,
-  PROP_FILL_PLAIN_COLOR
+  PROP_FILL_PLAIN_COLOR,
+  PROP_PREVIEW_MAX_ERROR
 };
 
 
@@ -79,6 +80,15 @@ gimp_cage_options_class_init (GimpCageOptionsClass *klass)
                             NULL,
                             FALSE,
                             GIMP_PARAM_STATIC_STRINGS);
+
+  GIMP_CONFIG_PROP_DOUBLE (object_class, PROP_PREVIEW_MAX_ERROR,
+                           "preview-max-error",
+                           _("Preview error"),
+                           _("How far the coefficients used for the preview "
+                             "may be off, in exchange for speed. The final "
+                             "transform is always exact."),
+                           0.0, 0.1, 0.001,
+                           GIMP_PARAM_STATIC_STRINGS);
 }
 
 static void
@@ -102,6 +112,9 @@ gimp_cage_options_set_property (GObject      *object,
     case PROP_FILL_PLAIN_COLOR:
       options->fill_plain_color = g_value_get_boolean (value);
       break;
+    case PROP_PREVIEW_MAX_ERROR:
+      options->preview_max_error = g_value_get_double (value);
+      break;
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -125,6 +138,9 @@ gimp_cage_options_get_property (GObject    *object,
     case PROP_FILL_PLAIN_COLOR:
       g_value_set_boolean (value, options->fill_plain_color);
       break;
+    case PROP_PREVIEW_MAX_ERROR:
+      g_value_set_double (value, options->preview_max_error);
+      break;
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -139,6 +155,7 @@ gimp_cage_options_gui (GimpToolOptions *tool_options)
   GtkWidget *vbox   = gimp_tool_options_gui (tool_options);
   GtkWidget *mode;
   GtkWidget *button;
+  GtkWidget *scale;
 
   mode = gimp_prop_enum_radio_box_new (config, "cage-mode", 0, 0);
   gtk_box_pack_start (GTK_BOX (vbox), mode, FALSE, FALSE, 0);
@@ -148,5 +165,10 @@ gimp_cage_options_gui (GimpToolOptions *tool_options)
   gtk_box_pack_start (GTK_BOX (vbox),  button, FALSE, FALSE, 0);
   gtk_widget_show (button);
 
+  scale = gimp_prop_spin_scale_new (config, "preview-max-error", NULL,
+                                    0.0001, 0.001, 4);
+  gtk_box_pack_start (GTK_BOX (vbox), scale, FALSE, FALSE, 0);
+  gtk_widget_show (scale);
+
   return vbox;
 }
@@ -41,6 +41,7 @@ struct _GimpCageOptions
 
   GimpCageMode     cage_mode;
   gboolean         fill_plain_color;
+  gdouble          preview_max_error;
 };
 
 struct _GimpCageOptionsClass
@@ -131,7 +131,8 @@ static gint       gimp_cage_tool_is_on_edge         (GimpCageTool          *ct,
 
 static gboolean   gimp_cage_tool_is_complete        (GimpCageTool          *ct);
 static void       gimp_cage_tool_remove_last_handle (GimpCageTool          *ct);
-static void       gimp_cage_tool_compute_coef       (GimpCageTool          *ct);
+static void       gimp_cage_tool_compute_coef       (GimpCageTool          *ct,
+                                                     gdouble                max_error);
 static void       gimp_cage_tool_create_filter      (GimpCageTool          *ct);
 static void       gimp_cage_tool_filter_flush       (GimpDrawableFilter    *filter,
                                                      GimpTool              *tool);
@@ -565,7 +566,8 @@ gimp_cage_tool_key_press (GimpTool    *tool,
                           GdkEventKey *kevent,
                           GimpDisplay *display)
 {
-  GimpCageTool *ct = GIMP_CAGE_TOOL (tool);
+  GimpCageTool    *ct      = GIMP_CAGE_TOOL (tool);
+  GimpCageOptions *options = GIMP_CAGE_TOOL_GET_OPTIONS (ct);
 
   if (! ct->config)
     return FALSE;
@@ -588,7 +590,7 @@ gimp_cage_tool_key_press (GimpTool    *tool,
               ct->tool_state = CAGE_STATE_WAIT;
             }
 
-          gimp_cage_tool_compute_coef (ct);
+          gimp_cage_tool_compute_coef (ct, options->preview_max_error);
           gimp_cage_tool_render_node_update (ct);
         }
       return TRUE;
@@ -739,7 +741,8 @@ gimp_cage_tool_options_notify (GimpTool         *tool,
 
               if (ct->dirty_coef)
                 {
-                  gimp_cage_tool_compute_coef (ct);
+                  gimp_cage_tool_compute_coef (ct,
+                                               GIMP_CAGE_OPTIONS (options)->preview_max_error);
                   gimp_cage_tool_render_node_update (ct);
                 }
 
@@ -991,6 +994,14 @@ gimp_cage_tool_commit (GimpCageTool *ct)
     {
       GimpTool *tool = GIMP_TOOL (ct);
 
+      /*  the preview may have used approximated coefficients  */
+      if (ct->coef_error > 0.0)
+        {
+          gimp_cage_tool_compute_coef (ct, 0.0);
+          gimp_cage_tool_render_node_update (ct);
+          gimp_cage_tool_filter_update (ct);
+        }
+
       gimp_tool_control_push_preserve (tool->control, TRUE);
 
       gimp_drawable_filter_commit (ct->filter, GIMP_PROGRESS (tool), FALSE);
@@ -1117,7 +1128,8 @@ gimp_cage_tool_remove_last_handle (GimpCageTool *ct)
 }
 
 static void
-gimp_cage_tool_compute_coef (GimpCageTool *ct)
+gimp_cage_tool_compute_coef (GimpCageTool *ct,
+                             gdouble       max_error)
 {
   GimpCageConfig *config = ct->config;
   GimpProgress   *progress;
@@ -1143,6 +1155,7 @@ gimp_cage_tool_compute_coef (GimpCageTool *ct)
   input = gegl_node_new_child (gegl,
                                "operation", "gimp:cage-coef-calc",
                                "config",    ct->config,
+                               "max-error", max_error,
                                NULL);
 
   output = gegl_node_new_child (gegl,
@@ -1171,6 +1184,7 @@ gimp_cage_tool_compute_coef (GimpCageTool *ct)
   g_object_unref (gegl);
 
   ct->dirty_coef = FALSE;
+  ct->coef_error = max_error;
 }
 
 static void
@@ -71,6 +71,12 @@ static void     gimp_histogram_editor_frozen_update (GimpHistogramEditor *editor
                                                      const GParamSpec    *pspec);
 static void     gimp_histogram_editor_buffer_update (GimpHistogramEditor *editor,
                                                      const GParamSpec    *pspec);
+static void     gimp_histogram_editor_area_update   (GimpDrawable        *drawable,
+                                                     gint                 x,
+                                                     gint                 y,
+                                                     gint                 width,
+                                                     gint                 height,
+                                                     GimpHistogramEditor *editor);
 static void     gimp_histogram_editor_update        (GimpHistogramEditor *editor);
 
 static gboolean gimp_histogram_editor_idle_update   (GimpHistogramEditor *editor);
@@ -413,7 +419,7 @@ gimp_histogram_editor_layer_changed (GimpImage           *image,
                                             gimp_histogram_editor_menu_update,
                                             editor);
       g_signal_handlers_disconnect_by_func (editor->drawable,
-                                            gimp_histogram_editor_update,
+                                            gimp_histogram_editor_area_update,
                                             editor);
       g_signal_handlers_disconnect_by_func (editor->drawable,
                                             gimp_histogram_editor_buffer_update,
@@ -438,8 +444,8 @@ gimp_histogram_editor_layer_changed (GimpImage           *image,
                                G_CALLBACK (gimp_histogram_editor_buffer_update),
                                editor, G_CONNECT_SWAPPED);
       g_signal_connect_object (editor->drawable, "update",
-                               G_CALLBACK (gimp_histogram_editor_update),
-                               editor, G_CONNECT_SWAPPED);
+                               G_CALLBACK (gimp_histogram_editor_area_update),
+                               editor, 0);
       g_signal_connect_object (editor->drawable, "alpha-changed",
                                G_CALLBACK (gimp_histogram_editor_menu_update),
                                editor, G_CONNECT_SWAPPED);
@@ -472,6 +478,9 @@ gimp_histogram_editor_validate (GimpHistogramEditor *editor)
 
               editor->histogram = gimp_histogram_new (editor->linear);
 
+              /*  only recalculate what changed while painting  */
+              gimp_histogram_set_incremental (editor->histogram, TRUE);
+
               gimp_histogram_view_set_histogram (view, editor->histogram);
             }
 
@@ -533,6 +542,21 @@ gimp_histogram_editor_buffer_update (GimpHistogramEditor *editor,
                 NULL);
 }
 
+static void
+gimp_histogram_editor_area_update (GimpDrawable        *drawable,
+                                   gint                 x,
+                                   gint                 y,
+                                   gint                 width,
+                                   gint                 height,
+                                   GimpHistogramEditor *editor)
+{
+  if (editor->histogram)
+    gimp_histogram_invalidate (editor->histogram,
+                               GEGL_RECTANGLE (x, y, width, height));
+
+  gimp_histogram_editor_update (editor);
+}
+
 static void
 gimp_histogram_editor_update (GimpHistogramEditor *editor)
 {
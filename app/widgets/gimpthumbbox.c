@@ -557,13 +557,13 @@ static void
 gimp_thumb_box_create_thumbnails (GimpThumbBox *box,
                                   gboolean      force)
 {
-  Gimp           *gimp     = box->context->gimp;
-  GimpProgress   *progress = GIMP_PROGRESS (box);
-  GimpFileDialog *dialog   = NULL;
+  Gimp           *gimp       = box->context->gimp;
+  GimpProgress   *progress   = GIMP_PROGRESS (box);
+  GimpFileDialog *dialog     = NULL;
+  GList          *imagefiles = NULL;
   GtkWidget      *toplevel;
   GSList         *list;
   gint            n_files;
-  gint            i;
 
   if (gimp->config->thumbnail_size == GIMP_THUMBNAIL_SIZE_NONE)
     return;
@@ -590,44 +590,64 @@ gimp_thumb_box_create_thumbnails (GimpThumbBox *box,
 
   if (n_files > 1)
     {
-      gchar *str;
+      GList *iter;
+      gint   n_pending;
 
       gimp_progress_start (GIMP_PROGRESS (box), TRUE, "%s", "");
 
       progress = gimp_sub_progress_new (GIMP_PROGRESS (box));
 
-      gimp_sub_progress_set_step (GIMP_SUB_PROGRESS (progress), 0, n_files);
+      /*  queue all but the current file, they are created in parallel
+       *  by as many plug-ins as there are processors
+       */
+      for (list = box->files->next; list; list = g_slist_next (list))
+        {
+          GimpImagefile *imagefile = gimp_imagefile_new (gimp, list->data);
+          GimpThumbnail *thumb     = gimp_imagefile_get_thumbnail (imagefile);
+          GimpThumbSize  size      = gimp->config->thumbnail_size;
+
+          if (force ||
+              (gimp_thumbnail_peek_thumb (thumb, size) < GIMP_THUMB_STATE_FAILED &&
+               ! gimp_thumbnail_has_failed (thumb)))
+            {
+              gimp_imagefile_queue_thumbnail (imagefile, box->context,
+                                              gimp->config->thumbnail_size,
+                                              ! force);
+            }
 
-      for (list = box->files->next, i = 1;
-           list;
-           list = g_slist_next (list), i++)
+          imagefiles = g_list_prepend (imagefiles, imagefile);
+        }
+
+      do
         {
-          str = g_strdup_printf (_("Thumbnail %d of %d"), i, n_files);
+          gchar *str;
+
+          n_pending = 0;
+
+          for (iter = imagefiles; iter; iter = g_list_next (iter))
+            if (gimp_imagefile_is_thumbnail_queued (iter->data))
+              n_pending++;
+
+          str = g_strdup_printf (_("Thumbnail %d of %d"),
+                                 n_files - n_pending, n_files);
           gtk_progress_bar_set_text (GTK_PROGRESS_BAR (box->progress), str);
           g_free (str);
 
+          gimp_sub_progress_set_step (GIMP_SUB_PROGRESS (progress),
+                                      n_files - 1 - n_pending, n_files);
           gimp_progress_set_value (progress, 0.0);
 
-          while (gtk_events_pending ())
+          if (n_pending > 0)
             gtk_main_iteration ();
 
-          gimp_thumb_box_create_thumbnail (box,
-                                           list->data,
-                                           gimp->config->thumbnail_size,
-                                           force,
-                                           progress);
-
           if (dialog && dialog->canceled)
-            goto canceled;
-
-          gimp_sub_progress_set_step (GIMP_SUB_PROGRESS (progress), i, n_files);
+            {
+              g_list_foreach (imagefiles,
+                              (GFunc) gimp_imagefile_cancel_thumbnail, NULL);
+              goto canceled;
+            }
         }
-
-      str = g_strdup_printf (_("Thumbnail %d of %d"), n_files, n_files);
-      gtk_progress_bar_set_text (GTK_PROGRESS_BAR (box->progress), str);
-      g_free (str);
-
-      gimp_progress_set_value (progress, 0.0);
+      while (n_pending > 0);
 
       while (gtk_events_pending ())
         gtk_main_iteration ();
@@ -648,6 +668,8 @@ gimp_thumb_box_create_thumbnails (GimpThumbBox *box,
 
   if (n_files > 1)
     {
+      g_list_free_full (imagefiles, (GDestroyNotify) g_object_unref);
+
       g_object_unref (progress);
 
       gimp_progress_end (GIMP_PROGRESS (box));
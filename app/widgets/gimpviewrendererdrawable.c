@@ -35,9 +35,28 @@
 
 #include "gimpviewrendererdrawable.h"
 
+#include "gimp-priorities.h"
 
-static void   gimp_view_renderer_drawable_render (GimpViewRenderer *renderer,
-                                                  GtkWidget        *widget);
+
+typedef struct
+{
+  GimpViewRendererDrawable *renderer;
+  gint                      render_buf_x;
+  gint                      render_buf_y;
+} RenderPreviewData;
+
+
+static void   gimp_view_renderer_drawable_finalize       (GObject           *object);
+
+static void   gimp_view_renderer_drawable_invalidate     (GimpViewRenderer  *renderer);
+static void   gimp_view_renderer_drawable_render         (GimpViewRenderer  *renderer,
+                                                          GtkWidget         *widget);
+
+static void   gimp_view_renderer_drawable_render_preview (GimpViewRenderer  *renderer,
+                                                          GtkWidget         *widget);
+static void   gimp_view_renderer_drawable_preview_done   (GimpDrawable      *drawable,
+                                                          GimpTempBuf       *preview,
+                                                          RenderPreviewData *data);
 
 
 G_DEFINE_TYPE (GimpViewRendererDrawable, gimp_view_renderer_drawable,
@@ -49,33 +68,94 @@ G_DEFINE_TYPE (GimpViewRendererDrawable, gimp_view_renderer_drawable,
 static void
 gimp_view_renderer_drawable_class_init (GimpViewRendererDrawableClass *klass)
 {
+  GObjectClass          *object_class   = G_OBJECT_CLASS (klass);
   GimpViewRendererClass *renderer_class = GIMP_VIEW_RENDERER_CLASS (klass);
 
-  renderer_class->render = gimp_view_renderer_drawable_render;
+  object_class->finalize     = gimp_view_renderer_drawable_finalize;
+
+  renderer_class->invalidate = gimp_view_renderer_drawable_invalidate;
+  renderer_class->render     = gimp_view_renderer_drawable_render;
 }
 
 static void
 gimp_view_renderer_drawable_init (GimpViewRendererDrawable *renderer)
 {
+  renderer->needs_preview = TRUE;
+}
+
+static void
+gimp_view_renderer_drawable_finalize (GObject *object)
+{
+  GimpViewRendererDrawable *renderer = GIMP_VIEW_RENDERER_DRAWABLE (object);
+
+  g_clear_pointer (&renderer->render_buf, gimp_temp_buf_unref);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gimp_view_renderer_drawable_invalidate (GimpViewRenderer *renderer)
+{
+  GIMP_VIEW_RENDERER_DRAWABLE (renderer)->needs_preview = TRUE;
+
+  GIMP_VIEW_RENDERER_CLASS (parent_class)->invalidate (renderer);
 }
 
 static void
 gimp_view_renderer_drawable_render (GimpViewRenderer *renderer,
                                     GtkWidget        *widget)
 {
-  GimpDrawable *drawable;
-  GimpItem     *item;
-  GimpImage    *image;
-  gint          offset_x;
-  gint          offset_y;
-  gint          width;
-  gint          height;
-  gint          view_width;
-  gint          view_height;
-  gdouble       xres       = 1.0;
-  gdouble       yres       = 1.0;
-  gboolean      scaling_up;
-  GimpTempBuf  *render_buf = NULL;
+  GimpViewRendererDrawable *rd = GIMP_VIEW_RENDERER_DRAWABLE (renderer);
+
+  if (rd->render_buf)
+    {
+      gimp_view_renderer_render_temp_buf (renderer, widget, rd->render_buf,
+                                          rd->render_buf_x, rd->render_buf_y,
+                                          -1,
+                                          GIMP_VIEW_BG_CHECKS,
+                                          GIMP_VIEW_BG_CHECKS);
+
+      g_clear_pointer (&rd->render_buf, gimp_temp_buf_unref);
+    }
+
+  /*  while a preview is being rendered, further requests are merged
+   *  into a single one that is made when it arrives
+   */
+  if (rd->needs_preview && ! rd->render_pending)
+    {
+      rd->needs_preview = FALSE;
+
+      gimp_view_renderer_drawable_render_preview (renderer, widget);
+    }
+}
+
+static void
+gimp_view_renderer_drawable_render_preview (GimpViewRenderer *renderer,
+                                            GtkWidget        *widget)
+{
+  GimpViewRendererDrawable *rd = GIMP_VIEW_RENDERER_DRAWABLE (renderer);
+  GimpDrawable             *drawable;
+  GimpItem                 *item;
+  GimpImage                *image;
+  gint                      offset_x;
+  gint                      offset_y;
+  gint                      width;
+  gint                      height;
+  gint                      view_width;
+  gint                      view_height;
+  gint                      src_x;
+  gint                      src_y;
+  gint                      src_width;
+  gint                      src_height;
+  gint                      dest_width;
+  gint                      dest_height;
+  gint                      render_buf_x = 0;
+  gint                      render_buf_y = 0;
+  gdouble                   xres         = 1.0;
+  gdouble                   yres         = 1.0;
+  gboolean                  scaling_up;
+  GimpTempBuf              *render_buf   = NULL;
+  RenderPreviewData        *data;
 
   drawable = GIMP_DRAWABLE (renderer->viewable);
   item     = GIMP_ITEM (drawable);
@@ -97,137 +177,123 @@ gimp_view_renderer_drawable_render (GimpViewRenderer *renderer,
       height = MAX (1, ROUND ((((gdouble) height /
                                 (gdouble) gimp_image_get_height (image)) *
                                (gdouble) gimp_item_get_height (item))));
-
-      gimp_viewable_calc_preview_size (gimp_item_get_width  (item),
-                                       gimp_item_get_height (item),
-                                       width,
-                                       height,
-                                       renderer->dot_for_dot,
-                                       xres,
-                                       yres,
-                                       &view_width,
-                                       &view_height,
-                                       &scaling_up);
-    }
-  else
-    {
-      gimp_viewable_calc_preview_size (gimp_item_get_width  (item),
-                                       gimp_item_get_height (item),
-                                       width,
-                                       height,
-                                       renderer->dot_for_dot,
-                                       xres,
-                                       yres,
-                                       &view_width,
-                                       &view_height,
-                                       &scaling_up);
     }
 
+  gimp_viewable_calc_preview_size (gimp_item_get_width  (item),
+                                   gimp_item_get_height (item),
+                                   width,
+                                   height,
+                                   renderer->dot_for_dot,
+                                   xres,
+                                   yres,
+                                   &view_width,
+                                   &view_height,
+                                   &scaling_up);
+
   if ((view_width * view_height) <
       (gimp_item_get_width (item) * gimp_item_get_height (item) * 4))
     scaling_up = FALSE;
 
-  if (scaling_up)
+  src_x       = 0;
+  src_y       = 0;
+  src_width   = gimp_item_get_width  (item);
+  src_height  = gimp_item_get_height (item);
+  dest_width  = view_width;
+  dest_height = view_height;
+
+  if (scaling_up && image && ! renderer->is_popup)
     {
-      if (image && ! renderer->is_popup)
+      if (gimp_rectangle_intersect (0, 0,
+                                    gimp_item_get_width  (item),
+                                    gimp_item_get_height (item),
+                                    -offset_x, -offset_y,
+                                    gimp_image_get_width  (image),
+                                    gimp_image_get_height (image),
+                                    &src_x, &src_y,
+                                    &src_width, &src_height))
         {
-          gint src_x, src_y;
-          gint src_width, src_height;
-
-          if (gimp_rectangle_intersect (0, 0,
-                                        gimp_item_get_width  (item),
-                                        gimp_item_get_height (item),
-                                        -offset_x, -offset_y,
-                                        gimp_image_get_width  (image),
-                                        gimp_image_get_height (image),
-                                        &src_x, &src_y,
-                                        &src_width, &src_height))
-            {
-              gint dest_width;
-              gint dest_height;
-
-              dest_width  = ROUND (((gdouble) renderer->width /
-                                    (gdouble) gimp_image_get_width (image)) *
-                                   (gdouble) src_width);
-              dest_height = ROUND (((gdouble) renderer->height /
-                                    (gdouble) gimp_image_get_height (image)) *
-                                   (gdouble) src_height);
-
-              if (dest_width  < 1) dest_width  = 1;
-              if (dest_height < 1) dest_height = 1;
-
-              render_buf = gimp_drawable_get_sub_preview (drawable,
-                                                          src_x, src_y,
-                                                          src_width, src_height,
-                                                          dest_width, dest_height);
-            }
-          else
-            {
-              const Babl *format = gimp_drawable_get_preview_format (drawable);
-
-              render_buf = gimp_temp_buf_new (1, 1, format);
-              gimp_temp_buf_data_clear (render_buf);
-            }
+          dest_width  = ROUND (((gdouble) renderer->width /
+                                (gdouble) gimp_image_get_width (image)) *
+                               (gdouble) src_width);
+          dest_height = ROUND (((gdouble) renderer->height /
+                                (gdouble) gimp_image_get_height (image)) *
+                               (gdouble) src_height);
+
+          if (dest_width  < 1) dest_width  = 1;
+          if (dest_height < 1) dest_height = 1;
         }
       else
         {
-          GimpTempBuf *temp_buf;
-
-          temp_buf = gimp_viewable_get_new_preview (renderer->viewable,
-                                                    renderer->context,
-                                                    gimp_item_get_width  (item),
-                                                    gimp_item_get_height (item));
-
-          if (temp_buf)
-            {
-              render_buf = gimp_temp_buf_scale (temp_buf,
-                                                view_width, view_height);
-              gimp_temp_buf_unref (temp_buf);
-            }
+          const Babl *format = gimp_drawable_get_preview_format (drawable);
+
+          render_buf = gimp_temp_buf_new (1, 1, format);
+          gimp_temp_buf_data_clear (render_buf);
+        }
+    }
+
+  if (image && ! renderer->is_popup)
+    {
+      if (offset_x != 0)
+        render_buf_x =
+          ROUND ((((gdouble) renderer->width /
+                   (gdouble) gimp_image_get_width (image)) *
+                  (gdouble) offset_x));
+
+      if (offset_y != 0)
+        render_buf_y =
+          ROUND ((((gdouble) renderer->height /
+                   (gdouble) gimp_image_get_height (image)) *
+                  (gdouble) offset_y));
+
+      if (scaling_up)
+        {
+          if (render_buf_x < 0) render_buf_x = 0;
+          if (render_buf_y < 0) render_buf_y = 0;
         }
     }
   else
     {
-      render_buf = gimp_viewable_get_new_preview (renderer->viewable,
-                                                  renderer->context,
-                                                  view_width,
-                                                  view_height);
+      if (view_width < width)
+        render_buf_x = (width - view_width) / 2;
+
+      if (view_height < height)
+        render_buf_y = (height - view_height) / 2;
     }
 
-  if (render_buf)
+  if (! render_buf)
     {
-      gint render_buf_x = 0;
-      gint render_buf_y = 0;
-
-      if (image && ! renderer->is_popup)
+      data = g_slice_new (RenderPreviewData);
+
+      data->renderer     = g_object_ref (rd);
+      data->render_buf_x = render_buf_x;
+      data->render_buf_y = render_buf_y;
+
+      if (gimp_drawable_get_sub_preview_async (drawable,
+                                               src_x, src_y,
+                                               src_width, src_height,
+                                               dest_width, dest_height,
+                                               GIMP_PRIORITY_VIEWABLE_IDLE,
+                                               (GimpDrawablePreviewCallback)
+                                               gimp_view_renderer_drawable_preview_done,
+                                               data))
         {
-          if (offset_x != 0)
-            render_buf_x =
-              ROUND ((((gdouble) renderer->width /
-                       (gdouble) gimp_image_get_width (image)) *
-                      (gdouble) offset_x));
-
-          if (offset_y != 0)
-            render_buf_y =
-              ROUND ((((gdouble) renderer->height /
-                       (gdouble) gimp_image_get_height (image)) *
-                      (gdouble) offset_y));
-
-          if (scaling_up)
-            {
-              if (render_buf_x < 0) render_buf_x = 0;
-              if (render_buf_y < 0) render_buf_y = 0;
-            }
-        }
-      else
-        {
-          if (view_width < width)
-            render_buf_x = (width - view_width) / 2;
+          /*  keep showing the old preview until the new one is ready  */
+          rd->render_pending = TRUE;
 
-          if (view_height < height)
-            render_buf_y = (height - view_height) / 2;
+          return;
         }
 
+      g_object_unref (rd);
+      g_slice_free (RenderPreviewData, data);
+
+      render_buf = gimp_drawable_get_sub_preview (drawable,
+                                                  src_x, src_y,
+                                                  src_width, src_height,
+                                                  dest_width, dest_height);
+    }
+
+  if (render_buf)
+    {
       gimp_view_renderer_render_temp_buf (renderer, widget, render_buf,
                                           render_buf_x, render_buf_y,
                                           -1,
@@ -244,3 +310,39 @@ gimp_view_renderer_drawable_render (GimpViewRenderer *renderer,
       gimp_view_renderer_render_icon (renderer, widget, icon_name);
     }
 }
+
+static void
+gimp_view_renderer_drawable_preview_done (GimpDrawable      *drawable,
+                                          GimpTempBuf       *preview,
+                                          RenderPreviewData *data)
+{
+  GimpViewRendererDrawable *rd       = data->renderer;
+  GimpViewRenderer         *renderer = GIMP_VIEW_RENDERER (rd);
+
+  rd->render_pending = FALSE;
+
+  if (renderer->viewable == GIMP_VIEWABLE (drawable))
+    {
+      if (rd->render_buf)
+        gimp_temp_buf_unref (rd->render_buf);
+
+      rd->render_buf   = gimp_temp_buf_ref (preview);
+      rd->render_buf_x = data->render_buf_x;
+      rd->render_buf_y = data->render_buf_y;
+    }
+
+  if (rd->render_buf || rd->needs_preview)
+    {
+      gboolean needs_preview = rd->needs_preview;
+
+      /*  redraw, but only ask for another preview if the drawable
+       *  changed while this one was being rendered
+       */
+      gimp_view_renderer_invalidate (renderer);
+
+      rd->needs_preview = needs_preview;
+    }
+
+  g_object_unref (rd);
+  g_slice_free (RenderPreviewData, data);
+}
@@ -36,6 +36,16 @@ typedef struct _GimpViewRendererDrawableClass  GimpViewRendererDrawableClass;
 struct _GimpViewRendererDrawable
 {
   GimpViewRenderer  parent_instance;
+
+  /* the preview is rendered on a worker thread, the old one stays
+   * visible until the new one arrives
+   */
+  gboolean          needs_preview;
+  gboolean          render_pending;
+
+  GimpTempBuf      *render_buf;
+  gint              render_buf_x;
+  gint              render_buf_y;
 };
 
 struct _GimpViewRendererDrawableClass
@@ -72,6 +72,9 @@ gimp_view_renderer_imagefile_render (GimpViewRenderer *renderer,
                                                            renderer->width,
                                                            renderer->height);
 
+  /*  visible thumbnails are created first  */
+  gimp_imagefile_prioritize_thumbnail (GIMP_IMAGEFILE (renderer->viewable));
+
   if (! pixbuf)
     {
       GimpImagefile *imagefile = GIMP_IMAGEFILE (renderer->viewable);
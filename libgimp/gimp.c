@@ -203,6 +203,7 @@ static gchar         *_wm_class          = NULL;
 static gchar         *_display_name      = NULL;
 static gint           _monitor_number    = 0;
 static guint32        _timestamp         = 0;
+static gboolean       _persistent        = FALSE;
 static const gchar   *progname           = NULL;
 
 static gchar          write_buffer[WRITE_BUFFER_SIZE];
@@ -1988,11 +1989,20 @@ gimp_loop (void)
         case GP_TILE_REQ:
         case GP_TILE_ACK:
         case GP_TILE_DATA:
+        case GP_REGION_REQ:
+        case GP_REGION_DATA:
           g_warning ("unexpected tile message received (should not happen)");
           break;
 
         case GP_PROC_RUN:
           gimp_proc_run (msg.data);
+
+          /*  if the core asked us to stay around, wait for the next
+           *  GP_CONFIG/GP_PROC_RUN pair instead of exiting
+           */
+          if (_persistent)
+            break;
+
           gimp_wire_destroy (&msg);
           gimp_close ();
           return;
@@ -2025,6 +2035,8 @@ gimp_loop (void)
 static void
 gimp_config (GPConfig *config)
 {
+  gboolean shm_attached = FALSE;
+
   if (config->version < GIMP_PROTOCOL_VERSION)
     {
       g_message ("Could not execute plug-in \"%s\"\n(%s)\n"
@@ -2044,6 +2056,12 @@ gimp_config (GPConfig *config)
       gimp_quit ();
     }
 
+  /*  a persistent plug-in receives a config message for each run,
+   *  the shared memory segment only needs to be attached once
+   */
+  if (_shm_addr && _shm_ID == config->shm_ID)
+    shm_attached = TRUE;
+
   _tile_width       = config->tile_width;
   _tile_height      = config->tile_height;
   _shm_ID           = config->shm_ID;
@@ -2054,10 +2072,15 @@ gimp_config (GPConfig *config)
   _show_help_button = config->show_help_button ? TRUE : FALSE;
   _min_colors       = config->min_colors;
   _gdisp_ID         = config->gdisp_ID;
-  _wm_class         = g_strdup (config->wm_class);
-  _display_name     = g_strdup (config->display_name);
   _monitor_number   = config->monitor_number;
   _timestamp        = config->timestamp;
+  _persistent       = config->persistent ? TRUE : FALSE;
+
+  g_free (_wm_class);
+  g_free (_display_name);
+
+  _wm_class         = g_strdup (config->wm_class);
+  _display_name     = g_strdup (config->display_name);
 
   if (config->app_name)
     g_set_application_name (config->app_name);
@@ -2069,7 +2092,7 @@ gimp_config (GPConfig *config)
                 "application-license", "GPL3",
                 NULL);
 
-  if (_shm_ID != -1)
+  if (_shm_ID != -1 && ! shm_attached)
     {
 #if defined(USE_SYSV_SHM)
 
@@ -2224,6 +2247,8 @@ gimp_process_message (GimpWireMessage *msg)
     case GP_TILE_REQ:
     case GP_TILE_ACK:
     case GP_TILE_DATA:
+    case GP_REGION_REQ:
+    case GP_REGION_DATA:
       g_warning ("unexpected tile message received (should not happen)");
       break;
     case GP_PROC_RUN:
@@ -74,6 +74,8 @@ gimp_drawable_get (gint32 drawable_ID)
   drawable->ntile_rows   = (height + TILE_HEIGHT - 1) / TILE_HEIGHT;
   drawable->ntile_cols   = (width  + TILE_WIDTH  - 1) / TILE_WIDTH;
 
+  _gimp_tile_cache_size_default (drawable);
+
   return drawable;
 }
 
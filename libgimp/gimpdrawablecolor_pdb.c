@@ -127,6 +127,54 @@ gimp_drawable_color_balance (gint32           drawable_ID,
   return success;
 }
 
+/**
+ * gimp_drawable_color_chain:
+ * @drawable_ID: The drawable.
+ * @num_steps: The number of strings in the steps array.
+ * @steps: The chain: { operation1, settings1, operation2, settings2, ... }.
+ *
+ * Applies a chain of color adjustments to the specified drawable in
+ * one pass.
+ *
+ * This procedure applies a sequence of color adjustments to the
+ * specified drawable. The 'steps' parameter is an array of strings
+ * which holds pairs of an operation name and its settings, serialized
+ * the way they are stored in the tools' settings files, like {
+ * \"gimp:levels\", \"(gamma 1.2)\", \"gimp:curves\", \"...\", ... }.
+ * Supported operations are gimp:brightness-contrast,
+ * gimp:color-balance, gimp:colorize, gimp:curves, gimp:hue-saturation
+ * and gimp:levels. The chain is compiled into lookup tables and
+ * applied in a single pass over the drawable, giving the same result
+ * as applying the adjustments one by one within the precision of the
+ * tables.
+ *
+ * Returns: TRUE on success.
+ *
+ * Since: 2.10
+ **/
+gboolean
+gimp_drawable_color_chain (gint32        drawable_ID,
+                           gint          num_steps,
+                           const gchar **steps)
+{
+  GimpParam *return_vals;
+  gint nreturn_vals;
+  gboolean success = TRUE;
+
+  return_vals = gimp_run_procedure ("gimp-drawable-color-chain",
+                                    &nreturn_vals,
+                                    GIMP_PDB_DRAWABLE, drawable_ID,
+                                    GIMP_PDB_INT32, num_steps,
+                                    GIMP_PDB_STRINGARRAY, steps,
+                                    GIMP_PDB_END);
+
+  success = return_vals[0].data.d_status == GIMP_PDB_SUCCESS;
+
+  gimp_destroy_params (return_vals, nreturn_vals);
+
+  return success;
+}
+
 /**
  * gimp_drawable_colorize_hsl:
  * @drawable_ID: The drawable.
@@ -763,3 +763,37 @@ gimp_edit_stroke_vectors (gint32 drawable_ID,
 
   return success;
 }
+
+/**
+ * gimp_edit_stroke_visible_vectors:
+ * @drawable_ID: The drawable to stroke to.
+ *
+ * Stroke all visible vectors objects
+ *
+ * This procedure strokes all visible vectors objects of the drawable's
+ * image in one step. When stroking with a line, all paths are rendered
+ * together, so overlapping strokes are painted only once. Paths
+ * without enough points to stroke are skipped.
+ *
+ * Returns: TRUE on success.
+ *
+ * Since: 2.10
+ **/
+gboolean
+gimp_edit_stroke_visible_vectors (gint32 drawable_ID)
+{
+  GimpParam *return_vals;
+  gint nreturn_vals;
+  gboolean success = TRUE;
+
+  return_vals = gimp_run_procedure ("gimp-edit-stroke-visible-vectors",
+                                    &nreturn_vals,
+                                    GIMP_PDB_DRAWABLE, drawable_ID,
+                                    GIMP_PDB_END);
+
+  success = return_vals[0].data.d_status == GIMP_PDB_SUCCESS;
+
+  gimp_destroy_params (return_vals, nreturn_vals);
+
+  return success;
+}
@@ -88,6 +88,7 @@ gboolean gimp_edit_blend                    (gint32               drawable_ID,
 gboolean gimp_edit_stroke                   (gint32               drawable_ID);
 gboolean gimp_edit_stroke_vectors           (gint32               drawable_ID,
                                              gint32               vectors_ID);
+gboolean gimp_edit_stroke_visible_vectors   (gint32               drawable_ID);
 
 
 G_END_DECLS
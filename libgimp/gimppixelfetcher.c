@@ -324,6 +324,16 @@ gimp_pixel_fetcher_provide_tile (GimpPixelFetcher *pf,
 
       pf->tile = gimp_drawable_get_tile (pf->drawable, pf->shadow, row, col);
       pf->tile_dirty = FALSE;
+
+      /*  neighbourhoods are mostly walked row by row, so fetch the
+       *  selection's whole row of tiles at once
+       */
+      if (pf->tile->ref_count == 0)
+        _gimp_tile_cache_prefetch (pf->drawable, pf->shadow, row,
+                                   MIN (col, pf->sel_x1 / pf->tile_width),
+                                   MAX (col, (pf->sel_x2 - 1) /
+                                        pf->tile_width));
+
       gimp_tile_ref (pf->tile);
 
       pf->col = col;
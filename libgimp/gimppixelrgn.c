@@ -70,6 +70,11 @@ static gint     gimp_get_portion_height   (GimpPixelRgnIterator *pri);
 static gpointer gimp_pixel_rgns_configure (GimpPixelRgnIterator *pri);
 static void     gimp_pixel_rgn_configure  (GimpPixelRgnHolder   *prh,
                                            GimpPixelRgnIterator *pri);
+static gboolean gimp_pixel_rgn_use_rect   (GimpPixelRgn         *pr,
+                                           gint                  x,
+                                           gint                  y,
+                                           gint                  width,
+                                           gint                  height);
 
 /**
  * gimp_pixel_rgn_init:
@@ -367,6 +372,13 @@ gimp_pixel_rgn_get_rect (GimpPixelRgn *pr,
   g_return_if_fail (width >= 0);
   g_return_if_fail (height >= 0);
 
+  if (gimp_pixel_rgn_use_rect (pr, x, y, width, height))
+    {
+      _gimp_tile_get_rect (pr->drawable, pr->shadow,
+                           x, y, width, height, buf);
+      return;
+    }
+
   bpp = pr->bpp;
   bufstride = bpp * width;
 
@@ -601,6 +613,13 @@ gimp_pixel_rgn_set_rect (GimpPixelRgn *pr,
   g_return_if_fail (width >= 0);
   g_return_if_fail (height >= 0);
 
+  if (gimp_pixel_rgn_use_rect (pr, x, y, width, height))
+    {
+      _gimp_tile_set_rect (pr->drawable, pr->shadow,
+                           x, y, width, height, buf);
+      return;
+    }
+
   bpp = pr->bpp;
   bufstride = bpp * width;
 
@@ -940,6 +959,15 @@ gimp_pixel_rgn_configure (GimpPixelRgnHolder   *prh,
       gint      offx;
       gint      offy;
 
+      /*  at the start of each row of tiles, fetch the whole row at once  */
+      if (prh->pr->x == prh->startx)
+        _gimp_tile_cache_prefetch (prh->pr->drawable,
+                                   prh->pr->shadow,
+                                   prh->pr->y / TILE_HEIGHT,
+                                   prh->startx / TILE_WIDTH,
+                                   (prh->startx + pri->region_width - 1) /
+                                   TILE_WIDTH);
+
       tile = gimp_drawable_get_tile2 (prh->pr->drawable,
                                       prh->pr->shadow,
                                       prh->pr->x,
@@ -963,3 +991,35 @@ gimp_pixel_rgn_configure (GimpPixelRgnHolder   *prh,
   prh->pr->w = pri->portion_width;
   prh->pr->h = pri->portion_height;
 }
+
+/*  whether a rectangle should be transferred in one piece instead of
+ *  tile by tile, which is the case if it needs more than one tile
+ *  that isn't held by the plug-in yet
+ */
+static gboolean
+gimp_pixel_rgn_use_rect (GimpPixelRgn *pr,
+                         gint          x,
+                         gint          y,
+                         gint          width,
+                         gint          height)
+{
+  gint n_missing = 0;
+  gint row, col;
+
+  if (width == 0 || height == 0)
+    return FALSE;
+
+  for (row = y / TILE_HEIGHT; row <= (y + height - 1) / TILE_HEIGHT; row++)
+    {
+      for (col = x / TILE_WIDTH; col <= (x + width - 1) / TILE_WIDTH; col++)
+        {
+          GimpTile *tile = gimp_drawable_get_tile (pr->drawable, pr->shadow,
+                                                   row, col);
+
+          if (tile->ref_count == 0 && ++n_missing > 1)
+            return TRUE;
+        }
+    }
+
+  return FALSE;
+}
@@ -48,6 +48,14 @@
  */
 #define FREE_QUANTUM 0.1
 
+/*  The largest amount of pixel data sent in one region message.
+ */
+#define MAX_REGION_SIZE (16 * 1024 * 1024)
+
+/*  The most memory the default tile cache will use, in kilobytes.
+ */
+#define MAX_DEFAULT_CACHE_SIZE (64 * 1024)
+
 
 void         gimp_read_expect_msg   (GimpWireMessage *msg,
                                      gint             type);
@@ -57,6 +65,21 @@ static void  gimp_tile_put          (GimpTile        *tile);
 static void  gimp_tile_cache_insert (GimpTile        *tile);
 static void  gimp_tile_cache_flush  (GimpTile        *tile);
 
+static void  gimp_tile_get_region   (GimpDrawable    *drawable,
+                                     gboolean         shadow,
+                                     gint             x,
+                                     gint             y,
+                                     gint             width,
+                                     gint             height,
+                                     guchar          *dest);
+static void  gimp_tile_put_region   (GimpDrawable    *drawable,
+                                     gboolean         shadow,
+                                     gint             x,
+                                     gint             y,
+                                     gint             width,
+                                     gint             height,
+                                     const guchar    *src);
+
 
 /*  private variables  */
 
@@ -66,6 +89,7 @@ static GList      * tile_list_tail  = NULL;
 static gulong       max_tile_size   = 0;
 static gulong       cur_cache_size  = 0;
 static gulong       max_cache_size  = 0;
+static gboolean     cache_size_set  = FALSE;
 
 
 /*  public functions  */
@@ -141,6 +165,7 @@ void
 gimp_tile_cache_size (gulong kilobytes)
 {
   max_cache_size = kilobytes * 1024;
+  cache_size_set = TRUE;
 }
 
 /**
@@ -184,6 +209,245 @@ _gimp_tile_cache_flush_drawable (GimpDrawable *drawable)
     }
 }
 
+/*  Makes the cache large enough for two rows of tiles of @drawable,
+ *  and of its shadow tiles, unless the plug-in chose a cache size
+ *  itself. This is what most pixel region loops need to never fetch
+ *  a tile twice.
+ */
+void
+_gimp_tile_cache_size_default (GimpDrawable *drawable)
+{
+  gulong kilobytes;
+
+  g_return_if_fail (drawable != NULL);
+
+  if (cache_size_set)
+    return;
+
+  kilobytes = ((gulong) drawable->ntile_cols * 2 * 2 *
+               gimp_tile_width () * gimp_tile_height () * 4 + 1023) / 1024;
+  kilobytes = MIN (kilobytes, MAX_DEFAULT_CACHE_SIZE);
+
+  max_cache_size = MAX (max_cache_size, kilobytes * 1024);
+}
+
+/*  Reads the rectangle from (@x, @y) to (@x+@width-1, @y+@height-1)
+ *  into @dest, using as few messages as possible. Local changes to
+ *  tiles in the rectangle are sent to the core first.
+ */
+void
+_gimp_tile_get_rect (GimpDrawable *drawable,
+                     gboolean      shadow,
+                     gint          x,
+                     gint          y,
+                     gint          width,
+                     gint          height,
+                     guchar       *dest)
+{
+  gsize rowstride;
+  gint  band_height;
+  gint  row, col;
+
+  g_return_if_fail (drawable != NULL);
+  g_return_if_fail (dest != NULL);
+
+  for (row = y / gimp_tile_height ();
+       row <= (y + height - 1) / gimp_tile_height ();
+       row++)
+    {
+      for (col = x / gimp_tile_width ();
+           col <= (x + width - 1) / gimp_tile_width ();
+           col++)
+        {
+          GimpTile *tile = gimp_drawable_get_tile (drawable, shadow, row, col);
+
+          if (tile->data && tile->dirty)
+            gimp_tile_flush (tile);
+        }
+    }
+
+  rowstride   = (gsize) width * drawable->bpp;
+  band_height = MAX (1, MAX_REGION_SIZE / rowstride);
+
+  while (height > 0)
+    {
+      gint h = MIN (height, band_height);
+
+      gimp_tile_get_region (drawable, shadow, x, y, width, h, dest);
+
+      dest   += h * rowstride;
+      y      += h;
+      height -= h;
+    }
+}
+
+/*  Writes @src to the rectangle from (@x, @y) to
+ *  (@x+@width-1, @y+@height-1) using as few messages as possible.
+ *  Tiles in the rectangle which are held locally are updated too.
+ */
+void
+_gimp_tile_set_rect (GimpDrawable *drawable,
+                     gboolean      shadow,
+                     gint          x,
+                     gint          y,
+                     gint          width,
+                     gint          height,
+                     const guchar *src)
+{
+  const guchar *band_src  = src;
+  gint          band_y    = y;
+  gint          band_left = height;
+  gsize         rowstride;
+  gint          band_height;
+  gint          bpp;
+  gint          row, col;
+
+  g_return_if_fail (drawable != NULL);
+  g_return_if_fail (src != NULL);
+
+  bpp         = drawable->bpp;
+  rowstride   = (gsize) width * bpp;
+  band_height = MAX (1, MAX_REGION_SIZE / rowstride);
+
+  while (band_left > 0)
+    {
+      gint h = MIN (band_left, band_height);
+
+      gimp_tile_put_region (drawable, shadow, x, band_y, width, h, band_src);
+
+      band_src  += h * rowstride;
+      band_y    += h;
+      band_left -= h;
+    }
+
+  for (row = y / gimp_tile_height ();
+       row <= (y + height - 1) / gimp_tile_height ();
+       row++)
+    {
+      for (col = x / gimp_tile_width ();
+           col <= (x + width - 1) / gimp_tile_width ();
+           col++)
+        {
+          GimpTile *tile = gimp_drawable_get_tile (drawable, shadow, row, col);
+          gint      tile_x = col * gimp_tile_width ();
+          gint      tile_y = row * gimp_tile_height ();
+          gint      x1, y1, x2, y2;
+          gint      ty;
+
+          if (! tile->data)
+            continue;
+
+          x1 = MAX (x, tile_x);
+          y1 = MAX (y, tile_y);
+          x2 = MIN (x + width,  tile_x + tile->ewidth);
+          y2 = MIN (y + height, tile_y + tile->eheight);
+
+          for (ty = y1; ty < y2; ty++)
+            {
+              memcpy (tile->data + bpp * (tile->ewidth * (ty - tile_y) +
+                                          (x1 - tile_x)),
+                      src + rowstride * (ty - y) + bpp * (x1 - x),
+                      (x2 - x1) * bpp);
+            }
+        }
+    }
+}
+
+/*  Fetches the tiles @col1 to @col2 of @row with a single message and
+ *  puts them into the cache, so the next gimp_tile_ref() calls on them
+ *  don't need to talk to the core. Does nothing if the cache is too
+ *  small to hold them.
+ */
+void
+_gimp_tile_cache_prefetch (GimpDrawable *drawable,
+                           gboolean      shadow,
+                           gint          row,
+                           gint          col1,
+                           gint          col2)
+{
+  GimpTile *first = NULL;
+  GimpTile *last  = NULL;
+  guchar   *buf;
+  gint      n_missing = 0;
+  gint      x, width, height;
+  gint      col;
+
+  g_return_if_fail (drawable != NULL);
+
+  col1 = MAX (col1, 0);
+  col2 = MIN (col2, (gint) drawable->ntile_cols - 1);
+
+  if (row < 0 || row >= (gint) drawable->ntile_rows || col1 >= col2)
+    return;
+
+  if (! tile_hash_table)
+    max_tile_size = gimp_tile_width () * gimp_tile_height () * 4;
+
+  /*  leave room for the tiles the plug-in is holding besides these  */
+  if ((gulong) (col2 - col1 + 1) * max_tile_size * 2 > max_cache_size)
+    return;
+
+  for (col = col1; col <= col2; col++)
+    {
+      GimpTile *tile = gimp_drawable_get_tile (drawable, shadow, row, col);
+
+      if (tile->ref_count == 0)
+        {
+          if (! first)
+            first = tile;
+
+          last = tile;
+          n_missing++;
+        }
+    }
+
+  /*  a single tile is fetched just as fast by gimp_tile_ref()  */
+  if (n_missing < 2)
+    return;
+
+  x      = (first->tile_num % drawable->ntile_cols) * gimp_tile_width ();
+  width  = ((last->tile_num % drawable->ntile_cols) * gimp_tile_width () +
+            last->ewidth - x);
+  height = first->eheight;
+
+  buf = g_malloc ((gsize) width * height * drawable->bpp);
+
+  _gimp_tile_get_rect (drawable, shadow,
+                       x, row * gimp_tile_height (), width, height, buf);
+
+  for (col = first->tile_num % drawable->ntile_cols;
+       col <= last->tile_num % drawable->ntile_cols;
+       col++)
+    {
+      GimpTile *tile = gimp_drawable_get_tile (drawable, shadow, row, col);
+      gint      tile_x = col * gimp_tile_width () - x;
+      gint      ty;
+
+      if (tile->ref_count > 0)
+        continue;
+
+      tile->data = g_new (guchar, tile->ewidth * tile->eheight * tile->bpp);
+
+      for (ty = 0; ty < tile->eheight; ty++)
+        {
+          memcpy (tile->data + ty * tile->ewidth * tile->bpp,
+                  buf + ((gsize) ty * width + tile_x) * tile->bpp,
+                  tile->ewidth * tile->bpp);
+        }
+
+      /*  hand the tile over to the cache, which frees it again if
+       *  there is no room after all
+       */
+      tile->ref_count++;
+      tile->dirty = FALSE;
+
+      gimp_tile_cache_insert (tile);
+      gimp_tile_unref (tile, FALSE);
+    }
+
+  g_free (buf);
+}
+
 
 /*  private functions  */
 
@@ -283,6 +547,81 @@ gimp_tile_put (GimpTile *tile)
   gimp_wire_destroy (&msg);
 }
 
+static void
+gimp_tile_get_region (GimpDrawable *drawable,
+                      gboolean      shadow,
+                      gint          x,
+                      gint          y,
+                      gint          width,
+                      gint          height,
+                      guchar       *dest)
+{
+  extern GIOChannel *_writechannel;
+
+  GPRegionReq      region_req;
+  GPRegionData    *region_data;
+  GimpWireMessage  msg;
+
+  region_req.drawable_ID = drawable->drawable_id;
+  region_req.shadow      = shadow ? TRUE : FALSE;
+  region_req.x           = x;
+  region_req.y           = y;
+  region_req.width       = width;
+  region_req.height      = height;
+
+  if (! gp_region_req_write (_writechannel, &region_req, NULL))
+    gimp_quit ();
+
+  gimp_read_expect_msg (&msg, GP_REGION_DATA);
+
+  region_data = msg.data;
+  if (region_data->drawable_ID != region_req.drawable_ID ||
+      region_data->shadow      != region_req.shadow      ||
+      region_data->x           != region_req.x           ||
+      region_data->y           != region_req.y           ||
+      region_data->width       != region_req.width       ||
+      region_data->height      != region_req.height      ||
+      region_data->bpp         != drawable->bpp)
+    {
+      g_message ("received region info did not match requested region info");
+      gimp_quit ();
+    }
+
+  memcpy (dest, region_data->data, (gsize) width * height * drawable->bpp);
+
+  gimp_wire_destroy (&msg);
+}
+
+static void
+gimp_tile_put_region (GimpDrawable *drawable,
+                      gboolean      shadow,
+                      gint          x,
+                      gint          y,
+                      gint          width,
+                      gint          height,
+                      const guchar *src)
+{
+  extern GIOChannel *_writechannel;
+
+  GPRegionData     region_data;
+  GimpWireMessage  msg;
+
+  region_data.drawable_ID = drawable->drawable_id;
+  region_data.shadow      = shadow ? TRUE : FALSE;
+  region_data.x           = x;
+  region_data.y           = y;
+  region_data.width       = width;
+  region_data.height      = height;
+  region_data.bpp         = drawable->bpp;
+  region_data.data        = (guchar *) src;
+
+  if (! gp_region_data_write (_writechannel, &region_data, NULL))
+    gimp_quit ();
+
+  gimp_read_expect_msg (&msg, GP_TILE_ACK);
+  gimp_wire_destroy (&msg);
+}
+
 /* This function is nearly identical to the function 'tile_cache_insert'
  *  in the file 'tile_cache.c' which is part of the main gimp application.
  */
@@ -60,9 +60,30 @@ GIMP_DEPRECATED
 void    gimp_tile_cache_ntiles (gulong     ntiles);
 
 
-/*  private function  */
+/*  private functions  */
 
 G_GNUC_INTERNAL void _gimp_tile_cache_flush_drawable (GimpDrawable *drawable);
+G_GNUC_INTERNAL void _gimp_tile_cache_size_default   (GimpDrawable *drawable);
+G_GNUC_INTERNAL void _gimp_tile_cache_prefetch       (GimpDrawable *drawable,
+                                                      gboolean      shadow,
+                                                      gint          row,
+                                                      gint          col1,
+                                                      gint          col2);
+
+G_GNUC_INTERNAL void _gimp_tile_get_rect             (GimpDrawable *drawable,
+                                                      gboolean      shadow,
+                                                      gint          x,
+                                                      gint          y,
+                                                      gint          width,
+                                                      gint          height,
+                                                      guchar       *dest);
+G_GNUC_INTERNAL void _gimp_tile_set_rect             (GimpDrawable *drawable,
+                                                      gboolean      shadow,
+                                                      gint          x,
+                                                      gint          y,
+                                                      gint          width,
+                                                      gint          height,
+                                                      const guchar *src);
 
 
 G_END_DECLS
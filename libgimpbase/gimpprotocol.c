@@ -140,6 +140,22 @@ static void _gp_has_init_write           (GIOChannel       *channel,
                                           gpointer          user_data);
 static void _gp_has_init_destroy         (GimpWireMessage  *msg);
 
+static void _gp_region_req_read          (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_region_req_write         (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_region_req_destroy       (GimpWireMessage  *msg);
+
+static void _gp_region_data_read         (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_region_data_write        (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_region_data_destroy      (GimpWireMessage  *msg);
+
 
 
 void
@@ -197,6 +213,14 @@ gp_init (void)
                       _gp_has_init_read,
                       _gp_has_init_write,
                       _gp_has_init_destroy);
+  gimp_wire_register (GP_REGION_REQ,
+                      _gp_region_req_read,
+                      _gp_region_req_write,
+                      _gp_region_req_destroy);
+  gimp_wire_register (GP_REGION_DATA,
+                      _gp_region_data_read,
+                      _gp_region_data_write,
+                      _gp_region_data_destroy);
 }
 
 gboolean
@@ -442,6 +466,44 @@ gp_has_init_write (GIOChannel *channel,
   return TRUE;
 }
 
+gboolean
+gp_region_req_write (GIOChannel  *channel,
+                     GPRegionReq *region_req,
+                     gpointer     user_data)
+{
+  GimpWireMessage msg;
+
+  msg.type = GP_REGION_REQ;
+  msg.data = region_req;
+
+  if (! gimp_wire_write_msg (channel, &msg, user_data))
+    return FALSE;
+
+  if (! gimp_wire_flush (channel, user_data))
+    return FALSE;
+
+  return TRUE;
+}
+
+gboolean
+gp_region_data_write (GIOChannel   *channel,
+                      GPRegionData *region_data,
+                      gpointer      user_data)
+{
+  GimpWireMessage msg;
+
+  msg.type = GP_REGION_DATA;
+  msg.data = region_data;
+
+  if (! gimp_wire_write_msg (channel, &msg, user_data))
+    return FALSE;
+
+  if (! gimp_wire_flush (channel, user_data))
+    return FALSE;
+
+  return TRUE;
+}
+
 /*  quit  */
 
 static void
@@ -503,7 +565,7 @@ _gp_config_read (GIOChannel      *channel,
                               user_data))
     goto cleanup;
   if (! _gimp_wire_read_int8 (channel,
-                              (guint8 *) &config->gimp_reserved_6, 1,
+                              (guint8 *) &config->persistent, 1,
                               user_data))
     goto cleanup;
   if (! _gimp_wire_read_int8 (channel,
@@ -595,7 +657,7 @@ _gp_config_write (GIOChannel      *channel,
                                user_data))
     return;
   if (! _gimp_wire_write_int8 (channel,
-                               (const guint8 *) &config->gimp_reserved_6, 1,
+                               (const guint8 *) &config->persistent, 1,
                                user_data))
     return;
   if (! _gimp_wire_write_int8 (channel,
@@ -1868,3 +1930,190 @@ static void
 _gp_has_init_destroy (GimpWireMessage *msg)
 {
 }
+
+/*  region_req  */
+
+static void
+_gp_region_req_read (GIOChannel      *channel,
+                     GimpWireMessage *msg,
+                     gpointer         user_data)
+{
+  GPRegionReq *region_req = g_slice_new0 (GPRegionReq);
+
+  if (! _gimp_wire_read_int32 (channel,
+                               (guint32 *) &region_req->drawable_ID, 1,
+                               user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &region_req->shadow, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &region_req->x, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &region_req->y, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &region_req->width, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &region_req->height, 1, user_data))
+    goto cleanup;
+
+  msg->data = region_req;
+  return;
+
+ cleanup:
+  g_slice_free (GPRegionReq, region_req);
+  msg->data = NULL;
+}
+
+static void
+_gp_region_req_write (GIOChannel      *channel,
+                      GimpWireMessage *msg,
+                      gpointer         user_data)
+{
+  GPRegionReq *region_req = msg->data;
+
+  if (! _gimp_wire_write_int32 (channel,
+                                (const guint32 *) &region_req->drawable_ID, 1,
+                                user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &region_req->shadow, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &region_req->x, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &region_req->y, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &region_req->width, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &region_req->height, 1, user_data))
+    return;
+}
+
+static void
+_gp_region_req_destroy (GimpWireMessage *msg)
+{
+  GPRegionReq *region_req = msg->data;
+
+  if (region_req)
+    g_slice_free (GPRegionReq, region_req);
+}
+
+/*  region_data  */
+
+static void
+_gp_region_data_read (GIOChannel      *channel,
+                      GimpWireMessage *msg,
+                      gpointer         user_data)
+{
+  GPRegionData *region_data = g_slice_new0 (GPRegionData);
+  gsize         length;
+
+  if (! _gimp_wire_read_int32 (channel,
+                               (guint32 *) &region_data->drawable_ID, 1,
+                               user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &region_data->shadow, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &region_data->x, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &region_data->y, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &region_data->width, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &region_data->height, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &region_data->bpp, 1, user_data))
+    goto cleanup;
+
+  length = ((gsize) region_data->width *
+            (gsize) region_data->height * region_data->bpp);
+
+  if (length > 0)
+    {
+      region_data->data = g_try_malloc (length);
+
+      if (! region_data->data)
+        goto cleanup;
+
+      if (! _gimp_wire_read_int8 (channel,
+                                  (guint8 *) region_data->data, length,
+                                  user_data))
+        goto cleanup;
+    }
+
+  msg->data = region_data;
+  return;
+
+ cleanup:
+  g_free (region_data->data);
+  g_slice_free (GPRegionData, region_data);
+  msg->data = NULL;
+}
+
+static void
+_gp_region_data_write (GIOChannel      *channel,
+                       GimpWireMessage *msg,
+                       gpointer         user_data)
+{
+  GPRegionData *region_data = msg->data;
+  gsize         length;
+
+  if (! _gimp_wire_write_int32 (channel,
+                                (const guint32 *) &region_data->drawable_ID, 1,
+                                user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &region_data->shadow, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &region_data->x, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &region_data->y, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &region_data->width, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &region_data->height, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &region_data->bpp, 1, user_data))
+    return;
+
+  length = ((gsize) region_data->width *
+            (gsize) region_data->height * region_data->bpp);
+
+  if (length > 0)
+    {
+      if (! _gimp_wire_write_int8 (channel,
+                                   (const guint8 *) region_data->data, length,
+                                   user_data))
+        return;
+    }
+}
+
+static void
+_gp_region_data_destroy (GimpWireMessage *msg)
+{
+  GPRegionData *region_data = msg->data;
+
+  if (region_data)
+    {
+      g_free (region_data->data);
+      g_slice_free (GPRegionData, region_data);
+    }
+}
@@ -26,7 +26,7 @@ G_BEGIN_DECLS
 
 /* Increment every time the protocol changes
  */
-#define GIMP_PROTOCOL_VERSION  0x0015
+#define GIMP_PROTOCOL_VERSION  0x0017
 
 
 enum
@@ -43,7 +43,9 @@ enum
   GP_PROC_INSTALL,
   GP_PROC_UNINSTALL,
   GP_EXTENSION_ACK,
-  GP_HAS_INIT
+  GP_HAS_INIT,
+  GP_REGION_REQ,
+  GP_REGION_DATA
 };
 
 
@@ -57,6 +59,8 @@ typedef struct _GPProcRun       GPProcRun;
 typedef struct _GPProcReturn    GPProcReturn;
 typedef struct _GPProcInstall   GPProcInstall;
 typedef struct _GPProcUninstall GPProcUninstall;
+typedef struct _GPRegionReq     GPRegionReq;
+typedef struct _GPRegionData    GPRegionData;
 
 
 struct _GPConfig
@@ -70,7 +74,7 @@ struct _GPConfig
   gint8    show_help_button;
   gint8    use_cpu_accel;
   gint8    use_opencl;
-  gint8    gimp_reserved_6;
+  gint8    persistent;
   gint8    gimp_reserved_7;
   gint8    gimp_reserved_8;
   gint8    install_cmap;
@@ -103,6 +107,32 @@ struct _GPTileData
   guchar  *data;
 };
 
+/*  a rectangle of pixels, transferred in a single message instead of
+ *  tile by tile; the data is always sent through the pipe, because it
+ *  doesn't fit the shared memory segment
+ */
+struct _GPRegionReq
+{
+  gint32   drawable_ID;
+  guint32  shadow;
+  guint32  x;
+  guint32  y;
+  guint32  width;
+  guint32  height;
+};
+
+struct _GPRegionData
+{
+  gint32   drawable_ID;
+  guint32  shadow;
+  guint32  x;
+  guint32  y;
+  guint32  width;
+  guint32  height;
+  guint32  bpp;
+  guchar  *data;
+};
+
 struct _GPParam
 {
   guint32 type;
@@ -224,6 +254,12 @@ gboolean  gp_extension_ack_write    (GIOChannel      *channel,
                                      gpointer         user_data);
 gboolean  gp_has_init_write         (GIOChannel      *channel,
                                      gpointer         user_data);
+gboolean  gp_region_req_write       (GIOChannel      *channel,
+                                     GPRegionReq     *region_req,
+                                     gpointer         user_data);
+gboolean  gp_region_data_write      (GIOChannel      *channel,
+                                     GPRegionData    *region_data,
+                                     gpointer         user_data);
 
 void      gp_params_destroy         (GPParam         *params,
                                      gint             nparams);
@@ -58,6 +58,7 @@
  */
 
 #define LOAD_PROC              "file-png-load"
+#define LOAD_THUMB_PROC        "file-png-load-thumb"
 #define SAVE_PROC              "file-png-save"
 #define SAVE2_PROC             "file-png-save2"
 #define SAVE_DEFAULTS_PROC     "file-png-save-defaults"
@@ -157,6 +158,12 @@ static gint32    load_image                (const gchar      *filename,
                                             gboolean          interactive,
                                             gboolean         *resolution_loaded,
                                             GError          **error);
+static gint32    load_thumbnail_image      (const gchar      *filename,
+                                            gint              size,
+                                            gint             *width,
+                                            gint             *height,
+                                            GimpImageType    *type,
+                                            GError          **error);
 static gboolean  save_image                (const gchar      *filename,
                                             gint32            image_ID,
                                             gint32            drawable_ID,
@@ -248,6 +255,18 @@ query (void)
     { GIMP_PDB_IMAGE, "image", "Output image" }
   };
 
+  static const GimpParamDef thumb_args[] =
+  {
+    { GIMP_PDB_STRING, "filename",     "The name of the file to load"  },
+    { GIMP_PDB_INT32,  "thumb-size",   "Preferred thumbnail size"      }
+  };
+  static const GimpParamDef thumb_return_vals[] =
+  {
+    { GIMP_PDB_IMAGE,  "image",        "Thumbnail image"               },
+    { GIMP_PDB_INT32,  "image-width",  "Width of full-sized image"     },
+    { GIMP_PDB_INT32,  "image-height", "Height of full-sized image"    }
+  };
+
 #define COMMON_SAVE_ARGS \
     { GIMP_PDB_INT32,    "run-mode",     "The run mode { RUN-INTERACTIVE (0), RUN-NONINTERACTIVE (1) }" }, \
     { GIMP_PDB_IMAGE,    "image",        "Input image"                  }, \
@@ -317,6 +336,24 @@ query (void)
   gimp_register_magic_load_handler (LOAD_PROC,
                                     "png", "", "0,string,\211PNG\r\n\032\n");
 
+  gimp_install_procedure (LOAD_THUMB_PROC,
+                          "Loads a downscaled version of a PNG image",
+                          "Reads a non-interlaced PNG image row by row and "
+                          "box-filters it down to about the requested size "
+                          "while reading, without holding the full-sized "
+                          "image in memory.",
+                          "The GIMP Team",
+                          "The GIMP Team",
+                          "2026",
+                          NULL,
+                          NULL,
+                          GIMP_PLUGIN,
+                          G_N_ELEMENTS (thumb_args),
+                          G_N_ELEMENTS (thumb_return_vals),
+                          thumb_args, thumb_return_vals);
+
+  gimp_register_thumbnail_loader (LOAD_PROC, LOAD_THUMB_PROC);
+
   gimp_install_procedure (SAVE_PROC,
                           "Exports files in PNG file format",
                           "This plug-in exports Portable Network Graphics "
@@ -500,6 +537,43 @@ run (const gchar      *name,
           status = GIMP_PDB_EXECUTION_ERROR;
         }
     }
+  else if (strcmp (name, LOAD_THUMB_PROC) == 0)
+    {
+      if (nparams < 2)
+        {
+          status = GIMP_PDB_CALLING_ERROR;
+        }
+      else
+        {
+          gint          width  = 0;
+          gint          height = 0;
+          GimpImageType type   = -1;
+
+          image_ID = load_thumbnail_image (param[0].data.d_string,
+                                           param[1].data.d_int32,
+                                           &width, &height, &type,
+                                           &error);
+
+          if (image_ID != -1)
+            {
+              *nreturn_vals = 6;
+              values[1].type         = GIMP_PDB_IMAGE;
+              values[1].data.d_image = image_ID;
+              values[2].type         = GIMP_PDB_INT32;
+              values[2].data.d_int32 = width;
+              values[3].type         = GIMP_PDB_INT32;
+              values[3].data.d_int32 = height;
+              values[4].type         = GIMP_PDB_INT32;
+              values[4].data.d_int32 = type;
+              values[5].type         = GIMP_PDB_INT32;
+              values[5].data.d_int32 = 1; /* num_layers */
+            }
+          else
+            {
+              status = GIMP_PDB_EXECUTION_ERROR;
+            }
+        }
+    }
   else if (strcmp (name, SAVE_PROC)  == 0 ||
            strcmp (name, SAVE2_PROC) == 0 ||
            strcmp (name, SAVE_DEFAULTS_PROC) == 0)
@@ -1369,6 +1443,254 @@ load_image (const gchar  *filename,
   return image;
 }
 
+/*
+ * 'load_thumbnail_image()' - Load a PNG image downscaled by an integer
+ *                            factor, so that it is still at least @size
+ *                            pixels large.  Rows are box-filtered into
+ *                            the result as they are read.
+ */
+static gint32
+load_thumbnail_image (const gchar   *filename,
+                      gint           size,
+                      gint          *width,
+                      gint          *height,
+                      GimpImageType *type,
+                      GError       **error)
+{
+  FILE              *fp;
+  png_structp        pp;
+  png_infop          info;
+  gint32             image;
+  gint32             layer;
+  GeglBuffer        *buffer;
+  gchar             *profile_name = NULL;
+  gint               channels;
+  gboolean           has_alpha;
+  gint               factor;
+  gint               thumb_width;
+  gint               thumb_height;
+  gint               y;
+  guchar           *volatile row     = NULL;
+  guint64          *volatile sums    = NULL;
+  guchar           *volatile pixels  = NULL;
+  GimpColorProfile *volatile profile = NULL;
+
+  pp = png_create_read_struct (PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+  if (! pp)
+    {
+      g_set_error (error, 0, 0,
+                   _("Error creating PNG read struct while exporting '%s'."),
+                   gimp_filename_to_utf8 (filename));
+      return -1;
+    }
+
+  info = png_create_info_struct (pp);
+
+  fp = g_fopen (filename, "rb");
+
+  if (fp == NULL)
+    {
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                   _("Could not open '%s' for reading: %s"),
+                   gimp_filename_to_utf8 (filename), g_strerror (errno));
+      png_destroy_read_struct (&pp, &info, NULL);
+      return -1;
+    }
+
+  if (setjmp (png_jmpbuf (pp)))
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                   _("Error while reading '%s'. File corrupted?"),
+                   gimp_filename_to_utf8 (filename));
+
+      png_destroy_read_struct (&pp, &info, NULL);
+      fclose (fp);
+
+      if (profile)
+        g_object_unref (profile);
+
+      g_free (row);
+      g_free (sums);
+      g_free (pixels);
+
+      return -1;
+    }
+
+#ifdef PNG_BENIGN_ERRORS_SUPPORTED
+  png_set_benign_errors (pp, TRUE);
+  png_set_option (pp, PNG_SKIP_sRGB_CHECK_PROFILE, PNG_OPTION_ON);
+#endif
+
+  gimp_progress_init_printf (_("Opening thumbnail for '%s'"),
+                             gimp_filename_to_utf8 (filename));
+
+  png_init_io (pp, fp);
+  png_read_info (pp, info);
+
+  *width  = png_get_image_width (pp, info);
+  *height = png_get_image_height (pp, info);
+
+  /*  interlaced images can't be filtered while streaming, leave them
+   *  to the full loader
+   */
+  if (png_get_interlace_type (pp, info) != PNG_INTERLACE_NONE)
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                   "Not creating a thumbnail for interlaced '%s'",
+                   gimp_filename_to_utf8 (filename));
+
+      png_destroy_read_struct (&pp, &info, NULL);
+      fclose (fp);
+
+      return -1;
+    }
+
+  profile = load_color_profile (pp, info, &profile_name);
+  g_free (profile_name);
+
+  /*  reduce everything to 8 bit gray or RGB, with or without alpha  */
+  png_set_strip_16 (pp);
+  png_set_expand (pp);
+
+  png_read_update_info (pp, info);
+
+  channels  = png_get_channels (pp, info);
+  has_alpha = (png_get_color_type (pp, info) & PNG_COLOR_MASK_ALPHA) != 0;
+
+  switch (channels)
+    {
+    case 1: *type = GIMP_GRAY_IMAGE;  break;
+    case 2: *type = GIMP_GRAYA_IMAGE; break;
+    case 3: *type = GIMP_RGB_IMAGE;   break;
+    case 4: *type = GIMP_RGBA_IMAGE;  break;
+
+    default:
+      g_set_error (error, 0, 0,
+                   _("Unknown color model in PNG file '%s'."),
+                   gimp_filename_to_utf8 (filename));
+
+      if (profile)
+        g_object_unref (profile);
+
+      png_destroy_read_struct (&pp, &info, NULL);
+      fclose (fp);
+
+      return -1;
+    }
+
+  factor = (size > 0) ? MAX (1, MAX (*width, *height) / size) : 1;
+
+  thumb_width  = (*width  + factor - 1) / factor;
+  thumb_height = (*height + factor - 1) / factor;
+
+  row    = g_new (guchar, *width * channels);
+  sums   = g_new0 (guint64, thumb_width * channels);
+  pixels = g_new (guchar, thumb_width * thumb_height * channels);
+
+  for (y = 0; y < *height; y++)
+    {
+      gint x;
+
+      png_read_row (pp, row, NULL);
+
+      /*  accumulate the row into the sums of its output row, color is
+       *  weighted by alpha so transparent pixels don't bleed into it
+       */
+      for (x = 0; x < *width; x++)
+        {
+          const guchar *src = row + x * channels;
+          guint64      *sum = sums + (x / factor) * channels;
+          gint          c;
+
+          if (has_alpha)
+            {
+              guint32 alpha = src[channels - 1];
+
+              for (c = 0; c < channels - 1; c++)
+                sum[c] += src[c] * alpha;
+
+              sum[channels - 1] += alpha;
+            }
+          else
+            {
+              for (c = 0; c < channels; c++)
+                sum[c] += src[c];
+            }
+        }
+
+      /*  emit an output row at the end of every band of rows  */
+      if ((y + 1) % factor == 0 || y == *height - 1)
+        {
+          guchar *dest = pixels + (y / factor) * thumb_width * channels;
+          gint    rows = y % factor + 1;
+
+          for (x = 0; x < thumb_width; x++)
+            {
+              guint64 *sum   = sums + x * channels;
+              gint     cols  = MIN (factor, *width - x * factor);
+              guint64  count = rows * cols;
+              gint     c;
+
+              if (has_alpha)
+                {
+                  guint64 alpha = sum[channels - 1];
+
+                  for (c = 0; c < channels - 1; c++)
+                    dest[c] = alpha ? (sum[c] + alpha / 2) / alpha : 0;
+
+                  dest[channels - 1] = (alpha + count / 2) / count;
+                }
+              else
+                {
+                  for (c = 0; c < channels; c++)
+                    dest[c] = (sum[c] + count / 2) / count;
+                }
+
+              dest += channels;
+            }
+
+          memset (sums, 0, thumb_width * channels * sizeof (guint64));
+
+          gimp_progress_update ((gdouble) (y + 1) / (gdouble) *height);
+        }
+    }
+
+  png_read_end (pp, NULL);
+  png_destroy_read_struct (&pp, &info, NULL);
+  fclose (fp);
+
+  image = gimp_image_new_with_precision (thumb_width, thumb_height,
+                                         channels < 3 ? GIMP_GRAY : GIMP_RGB,
+                                         GIMP_PRECISION_U8_GAMMA);
+
+  if (profile)
+    {
+      gimp_image_set_color_profile (image, profile);
+      g_object_unref (profile);
+    }
+
+  layer = gimp_layer_new (image, _("Background"), thumb_width, thumb_height,
+                          *type, 100, GIMP_LAYER_MODE_NORMAL_LEGACY);
+  gimp_image_insert_layer (image, layer, -1, 0);
+
+  buffer = gimp_drawable_get_buffer (layer);
+
+  gegl_buffer_set (buffer,
+                   GEGL_RECTANGLE (0, 0, thumb_width, thumb_height), 0,
+                   gimp_drawable_get_format (layer),
+                   pixels, GEGL_AUTO_ROWSTRIDE);
+
+  g_object_unref (buffer);
+
+  g_free (row);
+  g_free (sums);
+  g_free (pixels);
+
+  gimp_progress_update (1.0);
+
+  return image;
+}
+
 /*
  * 'offsets_dialog ()' - Asks the user about offsets when loading.
  */
@@ -490,22 +490,38 @@ jpeg_load_sanitize_comment (gchar *comment)
 
 gint32
 load_thumbnail_image (GFile         *file,
+                      gint           size,
                       gint          *width,
                       gint          *height,
                       GimpImageType *type,
                       GError       **error)
 {
-  gint32 volatile               image_ID = -1;
+  gint32 volatile               image_ID       = -1;
   struct jpeg_decompress_struct cinfo;
   struct my_error_mgr           jerr;
-  FILE                         *infile   = NULL;
+  FILE                         *infile         = NULL;
+  guchar * volatile             buf            = NULL;
+  JSAMPROW * volatile           rows           = NULL;
+  gpointer volatile             cmyk_transform = NULL;
 
   gimp_progress_init_printf (_("Opening thumbnail for '%s'"),
                              g_file_get_parse_name (file));
 
-  image_ID = gimp_image_metadata_load_thumbnail (file, error);
-  if (image_ID < 1)
-    return -1;
+  image_ID = gimp_image_metadata_load_thumbnail (file, NULL);
+
+  /*  only use the Exif thumbnail if it is large enough, otherwise
+   *  decode the image itself at a reduced DCT scale
+   */
+  if (image_ID > 0 &&
+      MAX (gimp_image_width (image_ID), gimp_image_height (image_ID)) < size)
+    {
+      gimp_image_delete (image_ID);
+      image_ID = -1;
+    }
+  else if (image_ID < 1)
+    {
+      image_ID = -1;
+    }
 
   cinfo.err = jpeg_std_error (&jerr.pub);
   jerr.pub.error_exit     = my_error_exit;
@@ -532,6 +548,14 @@ load_thumbnail_image (GFile         *file,
        */
       jpeg_destroy_decompress (&cinfo);
 
+      fclose (infile);
+
+      if (cmyk_transform)
+        cmsDeleteTransform (cmyk_transform);
+
+      g_free (rows);
+      g_free (buf);
+
       if (image_ID != -1)
         gimp_image_delete (image_ID);
 
@@ -545,14 +569,38 @@ load_thumbnail_image (GFile         *file,
 
   jpeg_stdio_src (&cinfo, infile);
 
+  /* we need the ICC profile (APP2) if we decode the image ourselves */
+  if (image_ID == -1)
+    jpeg_save_markers (&cinfo, JPEG_APP0 + 2, 0xffff);
+
   /* Step 3: read file parameters with jpeg_read_header() */
 
   jpeg_read_header (&cinfo, TRUE);
 
-  jpeg_start_decompress (&cinfo);
+  *width  = cinfo.image_width;
+  *height = cinfo.image_height;
 
-  *width  = cinfo.output_width;
-  *height = cinfo.output_height;
+  if (image_ID == -1)
+    {
+      gint max_size = MAX (cinfo.image_width, cinfo.image_height);
+
+      /*  let libjpeg scale by 1/2, 1/4 or 1/8 while decoding, as long
+       *  as the result is still at least as large as requested
+       */
+      cinfo.scale_num   = 1;
+      cinfo.scale_denom = 1;
+
+      while (cinfo.scale_denom < 8 &&
+             max_size / (gint) (cinfo.scale_denom * 2) >= size)
+        {
+          cinfo.scale_denom *= 2;
+        }
+
+      cinfo.dct_method          = JDCT_IFAST;
+      cinfo.do_fancy_upsampling = FALSE;
+    }
+
+  jpeg_calc_output_dimensions (&cinfo);
 
   switch (cinfo.output_components)
     {
@@ -578,9 +626,103 @@ load_thumbnail_image (GFile         *file,
                  cinfo.output_components, cinfo.out_color_space,
                  cinfo.jpeg_color_space);
 
-      gimp_image_delete (image_ID);
-      image_ID = -1;
-      break;
+      jpeg_destroy_decompress (&cinfo);
+      fclose (infile);
+
+      if (image_ID != -1)
+        gimp_image_delete (image_ID);
+
+      return -1;
+    }
+
+  if (image_ID == -1)
+    {
+      GeglBuffer *buffer;
+      gint32      layer_ID;
+      guint8     *icc_data   = NULL;
+      guint       icc_length = 0;
+      gint        rowstride;
+      gint        i;
+
+      jpeg_start_decompress (&cinfo);
+
+      image_ID = gimp_image_new_with_precision (cinfo.output_width,
+                                                cinfo.output_height,
+                                                *type == GIMP_GRAY_IMAGE ?
+                                                GIMP_GRAY : GIMP_RGB,
+                                                GIMP_PRECISION_U8_GAMMA);
+
+      jpeg_icc_read_profile (&cinfo, &icc_data, &icc_length);
+
+      if (cinfo.out_color_space == JCS_CMYK)
+        {
+          cmyk_transform = jpeg_load_cmyk_transform (icc_data, icc_length);
+        }
+      else if (icc_data)
+        {
+          GimpColorProfile *profile;
+
+          profile = gimp_color_profile_new_from_icc_profile (icc_data,
+                                                             icc_length,
+                                                             NULL);
+          if (profile)
+            {
+              gimp_image_set_color_profile (image_ID, profile);
+              g_object_unref (profile);
+            }
+        }
+
+      g_free (icc_data);
+
+      layer_ID = gimp_layer_new (image_ID, _("Background"),
+                                 cinfo.output_width,
+                                 cinfo.output_height,
+                                 *type,
+                                 100, GIMP_LAYER_MODE_NORMAL_LEGACY);
+      gimp_image_insert_layer (image_ID, layer_ID, -1, 0);
+
+      /*  the scaled image is small, decode it in one go and let
+       *  libjpeg fill as many rows per call as it likes
+       */
+      rowstride = cinfo.output_width * cinfo.output_components;
+
+      buf  = g_new (guchar, rowstride * cinfo.output_height);
+      rows = g_new (JSAMPROW, cinfo.output_height);
+
+      for (i = 0; i < cinfo.output_height; i++)
+        rows[i] = buf + rowstride * i;
+
+      while (cinfo.output_scanline < cinfo.output_height)
+        jpeg_read_scanlines (&cinfo,
+                             rows + cinfo.output_scanline,
+                             cinfo.output_height - cinfo.output_scanline);
+
+      jpeg_finish_decompress (&cinfo);
+
+      if (cinfo.out_color_space == JCS_CMYK)
+        jpeg_load_cmyk_to_rgb (buf,
+                               cinfo.output_width * cinfo.output_height,
+                               cmyk_transform);
+
+      buffer = gimp_drawable_get_buffer (layer_ID);
+
+      gegl_buffer_set (buffer,
+                       GEGL_RECTANGLE (0, 0,
+                                       cinfo.output_width,
+                                       cinfo.output_height),
+                       0,
+                       babl_format (*type == GIMP_GRAY_IMAGE ?
+                                    "Y' u8" : "R'G'B' u8"),
+                       buf,
+                       GEGL_AUTO_ROWSTRIDE);
+
+      g_object_unref (buffer);
+
+      if (cmyk_transform)
+        cmsDeleteTransform (cmyk_transform);
+
+      g_free (rows);
+      g_free (buf);
     }
 
   /* Step 4: Release JPEG decompression object */
@@ -592,6 +734,8 @@ load_thumbnail_image (GFile         *file,
 
   fclose (infile);
 
+  gimp_progress_update (1.0);
+
   return image_ID;
 }
 
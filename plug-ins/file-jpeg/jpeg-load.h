@@ -25,6 +25,7 @@ gint32 load_image           (const gchar  *filename,
                              GError      **error);
 
 gint32 load_thumbnail_image (GFile         *file,
+                             gint           size,
                              gint          *width,
                              gint          *height,
                              GimpImageType *type,
@@ -133,7 +133,9 @@ query (void)
 
   gimp_install_procedure (LOAD_THUMB_PROC,
                           "Loads a thumbnail from a JPEG image",
-                          "Loads a thumbnail from a JPEG image (only if it exists)",
+                          "Loads the embedded thumbnail of a JPEG image, "
+                          "or decodes the image at a reduced scale if it "
+                          "has none or the embedded one is too small",
                           "Mukund Sivaraman <muks@mukund.org>, Sven Neumann <sven@gimp.org>",
                           "Mukund Sivaraman <muks@mukund.org>, Sven Neumann <sven@gimp.org>",
                           "November 15, 2004",
@@ -259,7 +261,8 @@ run (const gchar      *name,
           gint          height = 0;
           GimpImageType type   = -1;
 
-          image_ID = load_thumbnail_image (file, &width, &height, &type,
+          image_ID = load_thumbnail_image (file, param[1].data.d_int32,
+                                           &width, &height, &type,
                                            &error);
 
           g_object_unref (file);
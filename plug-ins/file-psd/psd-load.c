@@ -38,6 +38,28 @@
 
 #define COMP_MODE_SIZE sizeof(guint16)
 
+/*  Memory budget for the compressed and decoded channels of the layers
+ *  that are decoded together
+ */
+#define DECODE_BATCH_SIZE (64 * 1024 * 1024)
+
+
+/*  Compressed data of a channel, read from the file in one go so
+ *  that decoding can happen off the reading thread
+ */
+typedef struct
+{
+  PSDchannel *channel;
+  guint16     bps;
+  guint16     compression;
+  guint32     readline_len;
+  guint16    *rle_pack_len;
+  gchar      *src;
+  gsize       src_len;
+  gint        result;
+  GError     *error;
+} PSDchannelJob;
+
 
 /*  Local function prototypes  */
 static gint             read_header_block          (PSDimage     *img_a,
@@ -78,6 +100,14 @@ static gint             add_layers                 (gint32        image_id,
                                                     FILE         *f,
                                                     GError      **error);
 
+static gint             read_layer_batch           (PSDimage     *img_a,
+                                                    PSDlayer    **lyr_a,
+                                                    gint          first,
+                                                    FILE         *f,
+                                                    PSDchannel ***lyr_chns,
+                                                    gboolean     *empty_masks,
+                                                    GError      **error);
+
 static gint             add_merged_image           (gint32        image_id,
                                                     PSDimage     *img_a,
                                                     FILE         *f,
@@ -91,13 +121,18 @@ static void             psd_to_gimp_color_map      (guchar       *map256);
 static GimpImageType    get_gimp_image_type        (GimpImageBaseType image_base_type,
                                                     gboolean          alpha);
 
-static gint             read_channel_data          (PSDchannel     *channel,
+static PSDchannelJob  * read_channel_job           (PSDchannel     *channel,
                                                     guint16         bps,
                                                     guint16         compression,
                                                     const guint16  *rle_pack_len,
                                                     FILE           *f,
                                                     guint32         comp_len,
                                                     GError        **error);
+static gint             decode_channel_job         (PSDchannelJob  *job,
+                                                    GError        **error);
+static gint             decode_channel_jobs        (GPtrArray      *jobs,
+                                                    GError        **error);
+static void             free_channel_job           (PSDchannelJob  *job);
 
 static void             convert_1_bit              (const gchar *src,
                                                     gchar       *dst,
@@ -1109,6 +1144,7 @@ add_layers (gint32     image_id,
             FILE      *f,
             GError   **error)
 {
+  PSDchannel         ***lyr_chns;
   PSDchannel          **lyr_chn;
   GArray               *parent_group_stack;
   gint32                parent_group_id = -1;
@@ -1117,7 +1153,6 @@ add_layers (gint32     image_id,
   guint16               user_mask_chn;
   guint16               layer_channels;
   guint16               channel_idx[MAX_CHANNELS];
-  guint16              *rle_pack_len;
   guint16               bps;
   gint32                l_x;                   /* Layer x */
   gint32                l_y;                   /* Layer y */
@@ -1131,6 +1166,7 @@ add_layers (gint32     image_id,
   gint32                layer_id = -1;
   gint32                mask_id = -1;
   gint                  lidx;                  /* Layer index */
+  gint                  next_lidx = 0;         /* First layer not read yet */
   gint                  cidx;                  /* Channel index */
   gint                  rowi;                  /* Row index */
   gint                  coli;                  /* Column index */
@@ -1138,6 +1174,7 @@ add_layers (gint32     image_id,
   gboolean              alpha;
   gboolean              user_mask;
   gboolean              empty;
+  gboolean             *empty_masks;
   gboolean              empty_mask;
   GeglBuffer           *buffer;
   GimpImageType         image_type;
@@ -1164,28 +1201,35 @@ add_layers (gint32     image_id,
   parent_group_stack = g_array_new (FALSE, FALSE, sizeof (gint32));
   g_array_append_val (parent_group_stack, parent_group_id);
 
+  lyr_chns    = g_new0 (PSDchannel **, img_a->num_layers);
+  empty_masks = g_new0 (gboolean, img_a->num_layers);
+
   for (lidx = 0; lidx < img_a->num_layers; ++lidx)
     {
-      IFDBG(2) g_debug ("Process Layer No %d.", lidx);
-
-      if (lyr_a[lidx]->drop)
+      if (lidx == next_lidx)
         {
-          IFDBG(2) g_debug ("Drop layer %d", lidx);
-
-          /* Step past layer data */
-          for (cidx = 0; cidx < lyr_a[lidx]->num_channels; ++cidx)
+          /* Read the channels of the next layers, as many as fit into
+           * the memory budget, and decode them all at once, so that
+           * small layers keep all processors busy too
+           */
+          next_lidx = read_layer_batch (img_a, lyr_a, lidx, f,
+                                        lyr_chns, empty_masks, error);
+          if (next_lidx < 0)
             {
-              if (fseek (f, lyr_a[lidx]->chn_info[cidx].data_len, SEEK_CUR) < 0)
-                {
-                  psd_set_error (feof (f), errno, error);
-                  return -1;
-                }
+              g_free (lyr_chns);
+              g_free (empty_masks);
+              g_array_free (parent_group_stack, FALSE);
+              return -1;
             }
-          g_free (lyr_a[lidx]->chn_info);
-          g_free (lyr_a[lidx]->name);
         }
-      else
+
+      IFDBG(2) g_debug ("Process Layer No %d.", lidx);
+
+      if (! lyr_a[lidx]->drop)
         {
+          lyr_chn    = lyr_chns[lidx];
+          empty_mask = empty_masks[lidx];
+
           if (lyr_a[lidx]->group_type != 0)
             {
               if (lyr_a[lidx]->group_type == 3)
@@ -1222,136 +1266,6 @@ add_layers (gint32     image_id,
           else
               empty = FALSE;
 
-          /* Empty mask */
-          if (lyr_a[lidx]->layer_mask.bottom - lyr_a[lidx]->layer_mask.top == 0
-              || lyr_a[lidx]->layer_mask.right - lyr_a[lidx]->layer_mask.left == 0)
-              empty_mask = TRUE;
-          else
-              empty_mask = FALSE;
-
-          IFDBG(3) g_debug ("Empty mask %d, size %d %d", empty_mask,
-                            lyr_a[lidx]->layer_mask.bottom - lyr_a[lidx]->layer_mask.top,
-                            lyr_a[lidx]->layer_mask.right - lyr_a[lidx]->layer_mask.left);
-
-          /* Load layer channel data */
-          IFDBG(2) g_debug ("Number of channels: %d", lyr_a[lidx]->num_channels);
-          /* Create pointer array for the channel records */
-          lyr_chn = g_new (PSDchannel *, lyr_a[lidx]->num_channels);
-          for (cidx = 0; cidx < lyr_a[lidx]->num_channels; ++cidx)
-            {
-              guint16 comp_mode = PSD_COMP_RAW;
-
-              /* Allocate channel record */
-              lyr_chn[cidx] = g_malloc (sizeof (PSDchannel) );
-
-              lyr_chn[cidx]->id = lyr_a[lidx]->chn_info[cidx].channel_id;
-              lyr_chn[cidx]->rows = lyr_a[lidx]->bottom - lyr_a[lidx]->top;
-              lyr_chn[cidx]->columns = lyr_a[lidx]->right - lyr_a[lidx]->left;
-
-              if (lyr_chn[cidx]->id == PSD_CHANNEL_MASK)
-                {
-                  /* Works around a bug in panotools psd files where the layer mask
-                     size is given as 0 but data exists. Set mask size to layer size.
-                  */
-                  if (empty_mask && lyr_a[lidx]->chn_info[cidx].data_len - 2 > 0)
-                    {
-                      empty_mask = FALSE;
-                      if (lyr_a[lidx]->layer_mask.top == lyr_a[lidx]->layer_mask.bottom)
-                        {
-                          lyr_a[lidx]->layer_mask.top = lyr_a[lidx]->top;
-                          lyr_a[lidx]->layer_mask.bottom = lyr_a[lidx]->bottom;
-                        }
-                      if (lyr_a[lidx]->layer_mask.right == lyr_a[lidx]->layer_mask.left)
-                        {
-                          lyr_a[lidx]->layer_mask.right = lyr_a[lidx]->right;
-                          lyr_a[lidx]->layer_mask.left = lyr_a[lidx]->left;
-                        }
-                    }
-                  lyr_chn[cidx]->rows = (lyr_a[lidx]->layer_mask.bottom -
-                                        lyr_a[lidx]->layer_mask.top);
-                  lyr_chn[cidx]->columns = (lyr_a[lidx]->layer_mask.right -
-                                           lyr_a[lidx]->layer_mask.left);
-                }
-
-              IFDBG(3) g_debug ("Channel id %d, %dx%d",
-                                lyr_chn[cidx]->id,
-                                lyr_chn[cidx]->columns,
-                                lyr_chn[cidx]->rows);
-
-              /* Only read channel data if there is any channel
-               * data. Note that the channel data can contain a
-               * compression method but no actual data.
-               */
-              if (lyr_a[lidx]->chn_info[cidx].data_len >= COMP_MODE_SIZE)
-                {
-                  if (fread (&comp_mode, COMP_MODE_SIZE, 1, f) < 1)
-                    {
-                      psd_set_error (feof (f), errno, error);
-                      return -1;
-                    }
-                  comp_mode = GUINT16_FROM_BE (comp_mode);
-                  IFDBG(3) g_debug ("Compression mode: %d", comp_mode);
-                }
-              if (lyr_a[lidx]->chn_info[cidx].data_len > COMP_MODE_SIZE)
-                {
-                  switch (comp_mode)
-                    {
-                      case PSD_COMP_RAW:        /* Planar raw data */
-                        IFDBG(3) g_debug ("Raw data length: %d",
-                                          lyr_a[lidx]->chn_info[cidx].data_len - 2);
-                        if (read_channel_data (lyr_chn[cidx], img_a->bps,
-                                               PSD_COMP_RAW, NULL, f, 0,
-                                               error) < 1)
-                          return -1;
-                        break;
-
-                      case PSD_COMP_RLE:        /* Packbits */
-                        IFDBG(3) g_debug ("RLE channel length %d, RLE length data: %d, "
-                                          "RLE data block: %d",
-                                          lyr_a[lidx]->chn_info[cidx].data_len - 2,
-                                          lyr_chn[cidx]->rows * 2,
-                                          (lyr_a[lidx]->chn_info[cidx].data_len - 2 -
-                                           lyr_chn[cidx]->rows * 2));
-                        rle_pack_len = g_malloc (lyr_chn[cidx]->rows * 2);
-                        for (rowi = 0; rowi < lyr_chn[cidx]->rows; ++rowi)
-                          {
-                            if (fread (&rle_pack_len[rowi], 2, 1, f) < 1)
-                              {
-                                psd_set_error (feof (f), errno, error);
-                                g_free (rle_pack_len);
-                                return -1;
-                              }
-                            rle_pack_len[rowi] = GUINT16_FROM_BE (rle_pack_len[rowi]);
-                          }
-
-                        IFDBG(3) g_debug ("RLE decode - data");
-                        if (read_channel_data (lyr_chn[cidx], img_a->bps,
-                                               PSD_COMP_RLE, rle_pack_len, f, 0,
-                                               error) < 1)
-                          return -1;
-
-                        g_free (rle_pack_len);
-                        break;
-
-                      case PSD_COMP_ZIP:                 /* ? */
-                      case PSD_COMP_ZIP_PRED:
-                        if (read_channel_data (lyr_chn[cidx], img_a->bps,
-                                               comp_mode, NULL, f,
-                                               lyr_a[lidx]->chn_info[cidx].data_len - 2,
-                                               error) < 1)
-                          return -1;
-                        break;
-
-                      default:
-                        g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
-                                    _("Unsupported compression mode: %d"), comp_mode);
-                        return -1;
-                        break;
-                    }
-                }
-            }
-          g_free (lyr_a[lidx]->chn_info);
-
           /* Draw layer */
 
           alpha = FALSE;
@@ -1616,11 +1530,217 @@ add_layers (gint32     image_id,
       g_free (lyr_a[lidx]);
     }
   g_free (lyr_a);
+  g_free (lyr_chns);
+  g_free (empty_masks);
   g_array_free (parent_group_stack, FALSE);
 
   return 0;
 }
 
+static gint
+read_layer_batch (PSDimage     *img_a,
+                  PSDlayer    **lyr_a,
+                  gint          first,
+                  FILE         *f,
+                  PSDchannel ***lyr_chns,
+                  gboolean     *empty_masks,
+                  GError      **error)
+{
+  GPtrArray  *jobs;
+  guint16    *rle_pack_len;
+  gsize       batch_size = 0;
+  gint        lidx;                  /* Layer index */
+  gint        cidx;                  /* Channel index */
+  gint        rowi;                  /* Row index */
+
+  jobs = g_ptr_array_new_with_free_func ((GDestroyNotify) free_channel_job);
+
+  for (lidx = first;
+       lidx < img_a->num_layers && batch_size < DECODE_BATCH_SIZE;
+       ++lidx)
+    {
+      PSDchannel **lyr_chn;
+      gboolean     empty_mask;
+
+      IFDBG(2) g_debug ("Read Layer No %d.", lidx);
+
+      if (lyr_a[lidx]->drop)
+        {
+          IFDBG(2) g_debug ("Drop layer %d", lidx);
+
+          /* Step past layer data */
+          for (cidx = 0; cidx < lyr_a[lidx]->num_channels; ++cidx)
+            {
+              if (fseek (f, lyr_a[lidx]->chn_info[cidx].data_len, SEEK_CUR) < 0)
+                {
+                  psd_set_error (feof (f), errno, error);
+                  g_ptr_array_free (jobs, TRUE);
+                  return -1;
+                }
+            }
+          g_free (lyr_a[lidx]->chn_info);
+          g_free (lyr_a[lidx]->name);
+          continue;
+        }
+
+      /* Empty mask */
+      if (lyr_a[lidx]->layer_mask.bottom - lyr_a[lidx]->layer_mask.top == 0
+          || lyr_a[lidx]->layer_mask.right - lyr_a[lidx]->layer_mask.left == 0)
+          empty_mask = TRUE;
+      else
+          empty_mask = FALSE;
+
+      IFDBG(3) g_debug ("Empty mask %d, size %d %d", empty_mask,
+                        lyr_a[lidx]->layer_mask.bottom - lyr_a[lidx]->layer_mask.top,
+                        lyr_a[lidx]->layer_mask.right - lyr_a[lidx]->layer_mask.left);
+
+      /* Load layer channel data */
+      IFDBG(2) g_debug ("Number of channels: %d", lyr_a[lidx]->num_channels);
+      /* Create pointer array for the channel records */
+      lyr_chn = g_new (PSDchannel *, lyr_a[lidx]->num_channels);
+      for (cidx = 0; cidx < lyr_a[lidx]->num_channels; ++cidx)
+        {
+          guint16 comp_mode = PSD_COMP_RAW;
+
+          /* Allocate channel record */
+          lyr_chn[cidx] = g_malloc (sizeof (PSDchannel) );
+
+          lyr_chn[cidx]->id = lyr_a[lidx]->chn_info[cidx].channel_id;
+          lyr_chn[cidx]->rows = lyr_a[lidx]->bottom - lyr_a[lidx]->top;
+          lyr_chn[cidx]->columns = lyr_a[lidx]->right - lyr_a[lidx]->left;
+
+          if (lyr_chn[cidx]->id == PSD_CHANNEL_MASK)
+            {
+              /* Works around a bug in panotools psd files where the layer mask
+                 size is given as 0 but data exists. Set mask size to layer size.
+              */
+              if (empty_mask && lyr_a[lidx]->chn_info[cidx].data_len - 2 > 0)
+                {
+                  empty_mask = FALSE;
+                  if (lyr_a[lidx]->layer_mask.top == lyr_a[lidx]->layer_mask.bottom)
+                    {
+                      lyr_a[lidx]->layer_mask.top = lyr_a[lidx]->top;
+                      lyr_a[lidx]->layer_mask.bottom = lyr_a[lidx]->bottom;
+                    }
+                  if (lyr_a[lidx]->layer_mask.right == lyr_a[lidx]->layer_mask.left)
+                    {
+                      lyr_a[lidx]->layer_mask.right = lyr_a[lidx]->right;
+                      lyr_a[lidx]->layer_mask.left = lyr_a[lidx]->left;
+                    }
+                }
+              lyr_chn[cidx]->rows = (lyr_a[lidx]->layer_mask.bottom -
+                                    lyr_a[lidx]->layer_mask.top);
+              lyr_chn[cidx]->columns = (lyr_a[lidx]->layer_mask.right -
+                                       lyr_a[lidx]->layer_mask.left);
+            }
+
+          IFDBG(3) g_debug ("Channel id %d, %dx%d",
+                            lyr_chn[cidx]->id,
+                            lyr_chn[cidx]->columns,
+                            lyr_chn[cidx]->rows);
+
+          /* Only read channel data if there is any channel
+           * data. Note that the channel data can contain a
+           * compression method but no actual data.
+           */
+          if (lyr_a[lidx]->chn_info[cidx].data_len >= COMP_MODE_SIZE)
+            {
+              if (fread (&comp_mode, COMP_MODE_SIZE, 1, f) < 1)
+                {
+                  psd_set_error (feof (f), errno, error);
+                  g_ptr_array_free (jobs, TRUE);
+                  return -1;
+                }
+              comp_mode = GUINT16_FROM_BE (comp_mode);
+              IFDBG(3) g_debug ("Compression mode: %d", comp_mode);
+            }
+          if (lyr_a[lidx]->chn_info[cidx].data_len > COMP_MODE_SIZE)
+            {
+              PSDchannelJob *job = NULL;
+
+              switch (comp_mode)
+                {
+                  case PSD_COMP_RAW:        /* Planar raw data */
+                    IFDBG(3) g_debug ("Raw data length: %d",
+                                      lyr_a[lidx]->chn_info[cidx].data_len - 2);
+                    job = read_channel_job (lyr_chn[cidx], img_a->bps,
+                                            PSD_COMP_RAW, NULL, f, 0,
+                                            error);
+                    break;
+
+                  case PSD_COMP_RLE:        /* Packbits */
+                    IFDBG(3) g_debug ("RLE channel length %d, RLE length data: %d, "
+                                      "RLE data block: %d",
+                                      lyr_a[lidx]->chn_info[cidx].data_len - 2,
+                                      lyr_chn[cidx]->rows * 2,
+                                      (lyr_a[lidx]->chn_info[cidx].data_len - 2 -
+                                       lyr_chn[cidx]->rows * 2));
+                    rle_pack_len = g_malloc (lyr_chn[cidx]->rows * 2);
+                    for (rowi = 0; rowi < lyr_chn[cidx]->rows; ++rowi)
+                      {
+                        if (fread (&rle_pack_len[rowi], 2, 1, f) < 1)
+                          {
+                            psd_set_error (feof (f), errno, error);
+                            g_free (rle_pack_len);
+                            g_ptr_array_free (jobs, TRUE);
+                            return -1;
+                          }
+                        rle_pack_len[rowi] = GUINT16_FROM_BE (rle_pack_len[rowi]);
+                      }
+
+                    IFDBG(3) g_debug ("RLE read - data");
+                    job = read_channel_job (lyr_chn[cidx], img_a->bps,
+                                            PSD_COMP_RLE, rle_pack_len, f, 0,
+                                            error);
+
+                    g_free (rle_pack_len);
+                    break;
+
+                  case PSD_COMP_ZIP:                 /* ? */
+                  case PSD_COMP_ZIP_PRED:
+                    job = read_channel_job (lyr_chn[cidx], img_a->bps,
+                                            comp_mode, NULL, f,
+                                            lyr_a[lidx]->chn_info[cidx].data_len - 2,
+                                            error);
+                    break;
+
+                  default:
+                    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                                _("Unsupported compression mode: %d"), comp_mode);
+                    break;
+                }
+
+              if (! job)
+                {
+                  g_ptr_array_free (jobs, TRUE);
+                  return -1;
+                }
+
+              g_ptr_array_add (jobs, job);
+              batch_size += job->src_len +
+                            (gsize) lyr_chn[cidx]->rows * lyr_chn[cidx]->columns *
+                            MAX (img_a->bps / 8, 1);
+            }
+        }
+      g_free (lyr_a[lidx]->chn_info);
+
+      lyr_chns[lidx]    = lyr_chn;
+      empty_masks[lidx] = empty_mask;
+    }
+
+  /* Decode the channels of all layers of the batch at once */
+  IFDBG(3) g_debug ("Decode %d channels of layers %d to %d",
+                    jobs->len, first, lidx - 1);
+  if (decode_channel_jobs (jobs, error) < 1)
+    {
+      g_ptr_array_free (jobs, TRUE);
+      return -1;
+    }
+  g_ptr_array_free (jobs, TRUE);
+
+  return lidx;
+}
+
 static gint
 add_merged_image (gint32     image_id,
                   PSDimage  *img_a,
@@ -1636,6 +1756,7 @@ add_merged_image (gint32     image_id,
   guint16               total_channels;
   guint16               bps;
   guint16              *rle_pack_len[MAX_CHANNELS];
+  GPtrArray            *jobs;
   guint32               alpha_id;
   gint32                layer_size;
   gint32                layer_id = -1;
@@ -1701,18 +1822,27 @@ add_merged_image (gint32     image_id,
         }
       comp_mode = GUINT16_FROM_BE (comp_mode);
 
+      jobs = g_ptr_array_new_with_free_func ((GDestroyNotify) free_channel_job);
+
       switch (comp_mode)
         {
           case PSD_COMP_RAW:        /* Planar raw data */
             IFDBG(3) g_debug ("Raw data length: %d", block_len);
             for (cidx = 0; cidx < total_channels; ++cidx)
               {
+                PSDchannelJob *job;
+
                 chn_a[cidx].columns = img_a->columns;
                 chn_a[cidx].rows = img_a->rows;
-                if (read_channel_data (&chn_a[cidx], img_a->bps,
-                                       PSD_COMP_RAW, NULL, f, 0,
-                                       error) < 1)
-                  return -1;
+                job = read_channel_job (&chn_a[cidx], img_a->bps,
+                                        PSD_COMP_RAW, NULL, f, 0,
+                                        error);
+                if (! job)
+                  {
+                    g_ptr_array_free (jobs, TRUE);
+                    return -1;
+                  }
+                g_ptr_array_add (jobs, job);
               }
             break;
 
@@ -1732,20 +1862,28 @@ add_merged_image (gint32     image_id,
                     if (fread (&rle_pack_len[cidx][rowi], 2, 1, f) < 1)
                       {
                         psd_set_error (feof (f), errno, error);
+                        g_ptr_array_free (jobs, TRUE);
                         return -1;
                       }
                     rle_pack_len[cidx][rowi] = GUINT16_FROM_BE (rle_pack_len[cidx][rowi]);
                   }
               }
 
-            IFDBG(3) g_debug ("RLE decode - data");
+            IFDBG(3) g_debug ("RLE read - data");
             for (cidx = 0; cidx < total_channels; ++cidx)
               {
-                if (read_channel_data (&chn_a[cidx], img_a->bps,
-                                       PSD_COMP_RLE, rle_pack_len[cidx], f, 0,
-                                       error) < 1)
-                  return -1;
+                PSDchannelJob *job;
+
+                job = read_channel_job (&chn_a[cidx], img_a->bps,
+                                        PSD_COMP_RLE, rle_pack_len[cidx], f, 0,
+                                        error);
                 g_free (rle_pack_len[cidx]);
+                if (! job)
+                  {
+                    g_ptr_array_free (jobs, TRUE);
+                    return -1;
+                  }
+                g_ptr_array_add (jobs, job);
               }
             break;
 
@@ -1754,9 +1892,19 @@ add_merged_image (gint32     image_id,
           default:
             g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
                         _("Unsupported compression mode: %d"), comp_mode);
+            g_ptr_array_free (jobs, TRUE);
             return -1;
             break;
         }
+
+      /* Decode all channels at once */
+      IFDBG(3) g_debug ("Decode %d channels", jobs->len);
+      if (decode_channel_jobs (jobs, error) < 1)
+        {
+          g_ptr_array_free (jobs, TRUE);
+          return -1;
+        }
+      g_ptr_array_free (jobs, TRUE);
     }
 
   /* ----- Draw merged image ----- */
@@ -2008,20 +2156,19 @@ zzfree (voidpf opaque, voidpf address)
   g_free (address);
 }
 
-static gint
-read_channel_data (PSDchannel     *channel,
-                   guint16         bps,
-                   guint16         compression,
-                   const guint16  *rle_pack_len,
-                   FILE           *f,
-                   guint32         comp_len,
-                   GError        **error)
+static PSDchannelJob *
+read_channel_job (PSDchannel     *channel,
+                  guint16         bps,
+                  guint16         compression,
+                  const guint16  *rle_pack_len,
+                  FILE           *f,
+                  guint32         comp_len,
+                  GError        **error)
 {
-  gchar    *raw_data;
-  gchar    *src;
-  gchar    *dst;
-  guint32   readline_len;
-  gint      i, j;
+  PSDchannelJob *job;
+  guint32        readline_len;
+  gsize          src_len;
+  gint           i;
 
   if (bps == 1)
     readline_len = ((channel->columns + 7) / 8);
@@ -2037,61 +2184,105 @@ read_channel_data (PSDchannel     *channel,
     {
       g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
                    _("Unsupported or invalid channel size"));
-      return -1;
+      return NULL;
     }
 
-  raw_data = g_malloc (readline_len * channel->rows);
   switch (compression)
     {
       case PSD_COMP_RAW:
-        if (fread (raw_data, readline_len, channel->rows, f) < 1)
-          {
-            psd_set_error (feof (f), errno, error);
-            return -1;
-          }
+        src_len = (gsize) readline_len * channel->rows;
         break;
 
       case PSD_COMP_RLE:
+        src_len = 0;
         for (i = 0; i < channel->rows; ++i)
-          {
-            src = g_malloc (rle_pack_len[i]);
-            dst = g_malloc (readline_len);
+          src_len += rle_pack_len[i];
+        break;
+
+      case PSD_COMP_ZIP:
+      case PSD_COMP_ZIP_PRED:
+        src_len = comp_len;
+        break;
+
+      default:
+        g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                     _("Unsupported compression mode: %d"), compression);
+        return NULL;
+    }
+
+  job = g_slice_new0 (PSDchannelJob);
+
+  job->channel      = channel;
+  job->bps          = bps;
+  job->compression  = compression;
+  job->readline_len = readline_len;
+  job->src_len      = src_len;
+  job->src          = g_malloc (MAX (src_len, 1));
+
+  if (compression == PSD_COMP_RLE)
+    job->rle_pack_len = g_memdup (rle_pack_len,
+                                  channel->rows * sizeof (guint16));
+
 /*      FIXME check for over-run
-            if (ftell (f) + rle_pack_len[i] > block_end)
-              {
-                psd_set_error (TRUE, errno, error);
-                return -1;
-              }
+  if (ftell (f) + src_len > block_end)
+    {
+      psd_set_error (TRUE, errno, error);
+      return NULL;
+    }
 */
-            if (fread (src, rle_pack_len[i], 1, f) < 1)
-              {
-                psd_set_error (feof (f), errno, error);
-                g_free (src);
-                g_free (dst);
-                return -1;
-              }
-            /* FIXME check for errors returned from decode packbits */
-            decode_packbits (src, dst, rle_pack_len[i], readline_len);
-            g_free (src);
-            memcpy (raw_data + i * readline_len, dst, readline_len);
-            g_free (dst);
-          }
+  if (src_len > 0 && fread (job->src, src_len, 1, f) < 1)
+    {
+      psd_set_error (feof (f), errno, error);
+      free_channel_job (job);
+      return NULL;
+    }
+
+  return job;
+}
+
+static gint
+decode_channel_job (PSDchannelJob  *job,
+                    GError        **error)
+{
+  PSDchannel *channel      = job->channel;
+  guint16     bps          = job->bps;
+  guint16     compression  = job->compression;
+  guint32     readline_len = job->readline_len;
+  gchar      *raw_data;
+  gint        i, j;
+
+  switch (compression)
+    {
+      case PSD_COMP_RAW:
+        /* The blob already is the raw data */
+        raw_data = job->src;
+        job->src = NULL;
+        break;
+
+      case PSD_COMP_RLE:
+        {
+          const gchar *src = job->src;
+
+          raw_data = g_malloc (readline_len * channel->rows);
+          for (i = 0; i < channel->rows; ++i)
+            {
+              /* FIXME check for errors returned from decode packbits */
+              decode_packbits (src, raw_data + i * readline_len,
+                               job->rle_pack_len[i], readline_len);
+              src += job->rle_pack_len[i];
+            }
+        }
         break;
+
       case PSD_COMP_ZIP:
       case PSD_COMP_ZIP_PRED:
         {
           z_stream zs;
 
-          src = g_malloc (comp_len);
-          if (fread (src, comp_len, 1, f) < 1)
-            {
-              psd_set_error (feof (f), errno, error);
-              g_free (src);
-              return -1;
-            }
+          raw_data = g_malloc (readline_len * channel->rows);
 
-          zs.next_in = (guchar*) src;
-          zs.avail_in = comp_len;
+          zs.next_in = (guchar*) job->src;
+          zs.avail_in = job->src_len;
           zs.next_out = (guchar*) raw_data;
           zs.avail_out = readline_len * channel->rows;
           zs.zalloc = zzalloc;
@@ -2106,15 +2297,20 @@ read_channel_data (PSDchannel     *channel,
             {
               g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
                            _("Failed to decompress data"));
-              g_free (src);
+              g_free (raw_data);
               return -1;
             }
-
-          g_free (src);
           break;
         }
+
+      default:
+        return -1;
     }
 
+  /* The compressed data isn't needed any more */
+  g_free (job->src);
+  job->src = NULL;
+
   /* Convert channel data to GIMP format */
   switch (bps)
     {
@@ -2157,8 +2353,9 @@ read_channel_data (PSDchannel     *channel,
       }
 
       case 8:
-        channel->data = g_malloc (channel->rows * channel->columns * bps / 8 );
-        memcpy (channel->data, raw_data, (channel->rows * channel->columns * bps / 8));
+        /* Hand the raw data over instead of copying it */
+        channel->data = raw_data;
+        raw_data = NULL;
 
         if (compression == PSD_COMP_ZIP_PRED)
           {
@@ -2174,6 +2371,7 @@ read_channel_data (PSDchannel     *channel,
         break;
 
       default:
+        g_free (raw_data);
         return -1;
         break;
     }
@@ -2183,6 +2381,60 @@ read_channel_data (PSDchannel     *channel,
   return 1;
 }
 
+static void
+decode_channel_job_func (gint     index,
+                         gpointer user_data)
+{
+  GPtrArray     *jobs = user_data;
+  PSDchannelJob *job  = g_ptr_array_index (jobs, index);
+
+  job->result = decode_channel_job (job, &job->error);
+}
+
+static gint
+decode_channel_jobs (GPtrArray  *jobs,
+                     GError    **error)
+{
+  gint i;
+
+  /* The channels are independent of each other, decode them on all
+   * processors and report the first failure in channel order.
+   */
+  psd_parallel_for (jobs->len, decode_channel_job_func, jobs);
+
+  for (i = 0; i < jobs->len; ++i)
+    {
+      PSDchannelJob *job = g_ptr_array_index (jobs, i);
+
+      if (job->result < 1)
+        {
+          if (job->error)
+            {
+              g_propagate_error (error, job->error);
+              job->error = NULL;
+            }
+          else
+            {
+              g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                           _("Unsupported or invalid channel size"));
+            }
+          return -1;
+        }
+    }
+
+  return 1;
+}
+
+static void
+free_channel_job (PSDchannelJob *job)
+{
+  g_free (job->src);
+  g_free (job->rle_pack_len);
+  g_clear_error (&job->error);
+
+  g_slice_free (PSDchannelJob, job);
+}
+
 static void
 convert_1_bit (const gchar *src,
                gchar       *dst,
@@ -911,6 +911,42 @@ save_resources (FILE   *fd,
   fseek (fd, eof_pos, SEEK_SET);
 }
 
+/* Rows packed by one work item of get_compress_channel_data() */
+#define PACK_ROWS_PER_ITEM 16
+
+typedef struct
+{
+  guchar *channel_data;
+  gint32  channel_cols;
+  gint32  channel_rows;
+  gint32  stride;
+  gint32  row_size;            /* Room for the worst case packed row */
+  gint16 *LengthsTable;
+  guchar *remdata;
+} PackChannelData;
+
+static void
+pack_channel_rows (gint     index,
+                   gpointer user_data)
+{
+  PackChannelData *pack = user_data;
+  gint             first_row = index * PACK_ROWS_PER_ITEM;
+  gint             last_row;
+  gint             i;
+
+  last_row = MIN (first_row + PACK_ROWS_PER_ITEM, pack->channel_rows);
+
+  for (i = first_row; i < last_row; i++)
+    {
+      guchar *start = (pack->channel_data +
+                       (i * pack->channel_cols * pack->stride));
+
+      pack->LengthsTable[i] = pack_pb_line (start, pack->channel_cols,
+                                            pack->stride,
+                                            &pack->remdata[i * pack->row_size]);
+    }
+}
+
 static int
 get_compress_channel_data (guchar  *channel_data,
                            gint32   channel_cols,
@@ -919,20 +955,32 @@ get_compress_channel_data (guchar  *channel_data,
                            gint16  *LengthsTable,
                            guchar  *remdata)
 {
-  gint    i;
-  gint32  len;                 /* Length of compressed data */
-  guchar *start;               /* Starting position of a row in channel_data */
-
-  /* For every row in the channel */
-
+  PackChannelData pack;
+  gint            i;
+  gint32          len;                 /* Length of compressed data */
+
+  /* Rows are packed independently, each into its own slot of remdata
+   * large enough for the worst case of one header byte per 128
+   * literals.  The callers allocate (channel_cols + 10 +
+   * channel_cols / 100) bytes per row, which always is enough.
+   */
+  pack.channel_data = channel_data;
+  pack.channel_cols = channel_cols;
+  pack.channel_rows = channel_rows;
+  pack.stride       = stride;
+  pack.row_size     = channel_cols + channel_cols / 128 + 2;
+  pack.LengthsTable = LengthsTable;
+  pack.remdata      = remdata;
+
+  psd_parallel_for ((channel_rows + PACK_ROWS_PER_ITEM - 1) /
+                    PACK_ROWS_PER_ITEM,
+                    pack_channel_rows, &pack);
+
+  /* Close the gaps between the packed rows, in order */
   len = 0;
   for (i = 0; i < channel_rows; i++)
     {
-      start = channel_data + (i * channel_cols * stride);
-
-      /* Create packed data for this row */
-      LengthsTable[i] = pack_pb_line (start, channel_cols, stride,
-                                       &remdata[len]);
+      memmove (&remdata[len], &remdata[i * pack.row_size], LengthsTable[i]);
       len += LengthsTable[i];
     }
 
@@ -33,9 +33,29 @@
 
 /*  Local constants */
 #define MIN_RUN     3
+#define MAX_THREADS 16
+
+typedef struct
+{
+  gint            n_items;
+  gint            next_item;
+  PSDParallelFunc func;
+  gpointer        user_data;
+
+  GMutex          mutex;
+  GCond           cond;
+  gint            n_running;
+} PSDParallelData;
 
 /*  Local function prototypes  */
 static gchar * gimp_layer_mode_effects_name (GimpLayerMode mode);
+static gpointer psd_parallel_worker         (gpointer      data);
+static void     psd_parallel_pool_func      (gpointer      data,
+                                             gpointer      user_data);
+
+/*  Local variables  */
+static GThreadPool *parallel_pool      = NULL;
+static gint         parallel_n_threads = 0;
 
 
 /* Utility function */
@@ -1083,3 +1103,106 @@ gimp_to_psd_layer_color_tag (GimpColorTag layer_color_tag)
 
   return color_tag;
 }
+
+void
+psd_parallel_for (gint            n_items,
+                  PSDParallelFunc func,
+                  gpointer        user_data)
+{
+  PSDParallelData data;
+  gint            n_helpers;
+  gint            i;
+
+  if (n_items <= 0)
+    return;
+
+  /* The pool lives until psd_parallel_exit(), so its threads are
+   * started once per load or save and not for every call.
+   */
+  if (! parallel_n_threads)
+    {
+      parallel_n_threads = CLAMP (g_get_num_processors (), 1, MAX_THREADS);
+
+      if (parallel_n_threads > 1)
+        parallel_pool = g_thread_pool_new (psd_parallel_pool_func, NULL,
+                                           parallel_n_threads - 1, FALSE,
+                                           NULL);
+    }
+
+  data.n_items   = n_items;
+  data.next_item = 0;
+  data.func      = func;
+  data.user_data = user_data;
+  data.n_running = 0;
+
+  g_mutex_init (&data.mutex);
+  g_cond_init (&data.cond);
+
+  n_helpers = parallel_pool ? MIN (parallel_n_threads, n_items) - 1 : 0;
+
+  /* The calling thread is a worker too, if a helper can't be started
+   * the remaining ones just take over its share.
+   */
+  for (i = 0; i < n_helpers; i++)
+    {
+      g_mutex_lock (&data.mutex);
+      data.n_running++;
+      g_mutex_unlock (&data.mutex);
+
+      if (! g_thread_pool_push (parallel_pool, &data, NULL))
+        {
+          g_mutex_lock (&data.mutex);
+          data.n_running--;
+          g_mutex_unlock (&data.mutex);
+          break;
+        }
+    }
+
+  psd_parallel_worker (&data);
+
+  g_mutex_lock (&data.mutex);
+  while (data.n_running > 0)
+    g_cond_wait (&data.cond, &data.mutex);
+  g_mutex_unlock (&data.mutex);
+
+  g_cond_clear (&data.cond);
+  g_mutex_clear (&data.mutex);
+}
+
+void
+psd_parallel_exit (void)
+{
+  if (parallel_pool)
+    {
+      g_thread_pool_free (parallel_pool, FALSE, TRUE);
+      parallel_pool = NULL;
+    }
+
+  parallel_n_threads = 0;
+}
+
+static gpointer
+psd_parallel_worker (gpointer data)
+{
+  PSDParallelData *parallel = data;
+  gint             i;
+
+  while ((i = g_atomic_int_add (&parallel->next_item, 1)) < parallel->n_items)
+    parallel->func (i, parallel->user_data);
+
+  return NULL;
+}
+
+static void
+psd_parallel_pool_func (gpointer data,
+                        gpointer user_data)
+{
+  PSDParallelData *parallel = data;
+
+  psd_parallel_worker (parallel);
+
+  g_mutex_lock (&parallel->mutex);
+  if (--parallel->n_running == 0)
+    g_cond_signal (&parallel->cond);
+  g_mutex_unlock (&parallel->mutex);
+}
@@ -85,4 +85,17 @@ GimpColorTag            psd_to_gimp_layer_color_tag (guint16 layer_color_tag);
 
 guint16                 gimp_to_psd_layer_color_tag (GimpColorTag layer_color_tag);
 
+/*
+ *  Calls func for every index in [0, n_items), spreading the calls
+ *  over one thread per processor.  Returns when all calls finished.
+ *  The threads are kept in a pool until psd_parallel_exit().
+ */
+typedef void         (* PSDParallelFunc)       (gint            index,
+                                                gpointer        user_data);
+
+void                    psd_parallel_for       (gint            n_items,
+                                                PSDParallelFunc func,
+                                                gpointer        user_data);
+void                    psd_parallel_exit      (void);
+
 #endif /* __PSD_UTIL_H__ */
@@ -29,6 +29,7 @@
 #include "psd-load.h"
 #include "psd-save.h"
 #include "psd-thumb-load.h"
+#include "psd-util.h"
 
 #include "libgimp/stdplugins-intl.h"
 
@@ -344,6 +345,9 @@ run (const gchar      *name,
       status = GIMP_PDB_CALLING_ERROR;
     }
 
+  /*  Stop the worker threads of this load or save  */
+  psd_parallel_exit ();
+
   if (status != GIMP_PDB_SUCCESS && error)
     {
       *nreturn_vals = 2;
@@ -49,6 +49,17 @@
 
 #undef cons
 
+/*  The argument and return value types of a PDB procedure  */
+typedef struct
+{
+  gint          ref_count;
+  gint          n_params;
+  GimpParamDef *params;
+  gint          n_return_vals;
+  GimpParamDef *return_vals;
+} ProcSignature;
+
+
 static void     ts_init_constants                (scheme    *sc);
 static void     ts_init_enum                     (scheme    *sc,
                                                   GType      enum_type);
@@ -60,6 +71,16 @@ static pointer  script_fu_marshal_procedure_call (scheme    *sc,
 static void     script_fu_marshal_destroy_args   (GimpParam *params,
                                                   gint       n_params);
 
+static void     proc_signature_insert            (const gchar   *proc_name,
+                                                  gint           n_params,
+                                                  GimpParamDef  *params,
+                                                  gint           n_return_vals,
+                                                  GimpParamDef  *return_vals);
+static ProcSignature *
+                proc_signature_lookup            (const gchar   *proc_name,
+                                                  gboolean       refresh);
+static void     proc_signature_unref             (ProcSignature *signature);
+
 static pointer  script_fu_register_call          (scheme    *sc,
                                                   pointer    a);
 static pointer  script_fu_menu_register_call     (scheme    *sc,
@@ -128,7 +149,12 @@ static const NamedConstant script_constants[] =
 };
 
 
-static scheme sc;
+static scheme      sc;
+
+/*  PDB signatures by procedure name, so they only have to be queried
+ *  once per process instead of on every call
+ */
+static GHashTable *proc_signatures = NULL;
 
 
 void
@@ -494,8 +520,10 @@ ts_init_procedures (scheme   *sc,
           g_free (proc_copyright);
           g_free (proc_date);
 
-          gimp_destroy_paramdefs (params, n_params);
-          gimp_destroy_paramdefs (return_vals, n_return_vals);
+          /*  remember the signature for the marshaller  */
+          proc_signature_insert (proc_list[i],
+                                 n_params,      params,
+                                 n_return_vals, return_vals);
         }
     }
 
@@ -541,18 +569,12 @@ static pointer
 script_fu_marshal_procedure_call (scheme  *sc,
                                   pointer  a)
 {
-  GimpParam       *args;
-  GimpParam       *values = NULL;
-  gint             nvalues;
+  GimpParam       *args    = NULL;
+  GimpParam       *values  = NULL;
+  gint             nvalues = 0;
   gchar           *proc_name;
-  gchar           *proc_blurb;
-  gchar           *proc_help;
-  gchar           *proc_author;
-  gchar           *proc_copyright;
-  gchar           *proc_date;
-  GimpPDBProcType  proc_type;
-  gint             nparams;
-  gint             nreturn_vals;
+  ProcSignature   *signature;
+  gint             nparams = 0;
   GimpParamDef    *params;
   GimpParamDef    *return_vals;
   gchar            error_str[1024];
@@ -599,36 +621,35 @@ script_fu_marshal_procedure_call (scheme  *sc,
   /*  report the current command  */
   script_fu_interface_report_cc (proc_name);
 
-  /*  Attempt to fetch the procedure from the database  */
-  if (! gimp_procedural_db_proc_info (proc_name,
-                                      &proc_blurb,
-                                      &proc_help,
-                                      &proc_author,
-                                      &proc_copyright,
-                                      &proc_date,
-                                      &proc_type,
-                                      &nparams, &nreturn_vals,
-                                      &params, &return_vals))
+  /*  Attempt to fetch the procedure's signature  */
+  signature = proc_signature_lookup (proc_name, FALSE);
+
+  /*  The procedure may have been re-registered since it was cached  */
+  if (signature &&
+      (sc->vptr->list_length (sc, a) - 1) != signature->n_params)
+    {
+      signature = proc_signature_lookup (proc_name, TRUE);
+    }
+
+  if (! signature)
     {
 #ifdef DEBUG_MARSHALL
       g_printerr ("  Invalid procedure name\n");
 #endif
       g_snprintf (error_str, sizeof (error_str),
                   "Invalid procedure name %s specified", proc_name);
-      return foreign_error (sc, error_str, 0);
+      return_val = foreign_error (sc, error_str, 0);
+      goto out;
     }
 
-  /* Free the name and the description which are of no use here.  */
-  for (i = 0; i < nparams; i++)
-    {
-      g_free (params[i].name);
-      g_free (params[i].description);
-    }
-  for (i = 0; i < nreturn_vals; i++)
-    {
-      g_free (return_vals[i].name);
-      g_free (return_vals[i].description);
-    }
+  /*  Keep the signature alive in case a nested call drops it from
+   *  the cache
+   */
+  signature->ref_count++;
+
+  nparams     = signature->n_params;
+  params      = signature->params;
+  return_vals = signature->return_vals;
 
   /*  Check the supplied number of arguments  */
   if ((sc->vptr->list_length (sc, a) - 1) != nparams)
@@ -640,14 +661,15 @@ script_fu_marshal_procedure_call (scheme  *sc,
       g_snprintf (error_str, sizeof (error_str),
                   "Invalid number of arguments for %s (expected %d but received %d)",
                   proc_name, nparams, (sc->vptr->list_length (sc, a) - 1));
-      return foreign_error (sc, error_str, 0);
+      return_val = foreign_error (sc, error_str, 0);
+      goto out;
     }
 
-  /*  Marshall the supplied arguments  */
+  /*  Marshall the supplied arguments, a partly filled array is freed
+   *  on errors
+   */
   if (nparams)
-    args = g_new (GimpParam, nparams);
-  else
-    args = NULL;
+    args = g_new0 (GimpParam, nparams);
 
   for (i = 0; i < nparams; i++)
     {
@@ -760,7 +782,8 @@ script_fu_marshal_procedure_call (scheme  *sc,
                               "size of %ld but expected size of %d",
                               i+1, proc_name,
                               sc->vptr->vector_length (vector), n_elements);
-                  return foreign_error (sc, error_str, 0);
+                  return_val = foreign_error (sc, error_str, 0);
+                  goto out;
                 }
 
               args[i].data.d_int32array = g_new (gint32, n_elements);
@@ -775,7 +798,8 @@ script_fu_marshal_procedure_call (scheme  *sc,
                       g_snprintf (error_str, sizeof (error_str),
                                   "Item %d in vector is not a number (argument %d for function %s)",
                                   j+1, i+1, proc_name);
-                      return foreign_error (sc, error_str, vector);
+                      return_val = foreign_error (sc, error_str, vector);
+                      goto out;
                     }
 
                   args[i].data.d_int32array[j] =
@@ -812,7 +836,8 @@ script_fu_marshal_procedure_call (scheme  *sc,
                               "INT16 vector (argument %d) for function %s has "
                               "size of %ld but expected size of %d",
                               i+1, proc_name, sc->vptr->vector_length (vector), n_elements);
-                  return foreign_error (sc, error_str, 0);
+                  return_val = foreign_error (sc, error_str, 0);
+                  goto out;
                 }
 
               args[i].data.d_int16array = g_new (gint16, n_elements);
@@ -826,7 +851,8 @@ script_fu_marshal_procedure_call (scheme  *sc,
                       g_snprintf (error_str, sizeof (error_str),
                                   "Item %d in vector is not a number (argument %d for function %s)",
                                   j+1, i+1, proc_name);
-                      return foreign_error (sc, error_str, vector);
+                      return_val = foreign_error (sc, error_str, vector);
+                      goto out;
                     }
 
                   args[i].data.d_int16array[j] =
@@ -865,7 +891,8 @@ script_fu_marshal_procedure_call (scheme  *sc,
                               "size of %ld but expected size of %d",
                               i+1, proc_name,
                               sc->vptr->vector_length (vector), n_elements);
-                  return foreign_error (sc, error_str, 0);
+                  return_val = foreign_error (sc, error_str, 0);
+                  goto out;
                 }
 
               args[i].data.d_int8array = g_new (guint8, n_elements);
@@ -879,7 +906,8 @@ script_fu_marshal_procedure_call (scheme  *sc,
                       g_snprintf (error_str, sizeof (error_str),
                                   "Item %d in vector is not a number (argument %d for function %s)",
                                   j+1, i+1, proc_name);
-                      return foreign_error (sc, error_str, vector);
+                      return_val = foreign_error (sc, error_str, vector);
+                      goto out;
                     }
 
                   args[i].data.d_int8array[j] =
@@ -918,7 +946,8 @@ script_fu_marshal_procedure_call (scheme  *sc,
                               "size of %ld but expected size of %d",
                               i+1, proc_name,
                               sc->vptr->vector_length (vector), n_elements);
-                  return foreign_error (sc, error_str, 0);
+                  return_val = foreign_error (sc, error_str, 0);
+                  goto out;
                 }
 
               args[i].data.d_floatarray = g_new (gdouble, n_elements);
@@ -932,7 +961,8 @@ script_fu_marshal_procedure_call (scheme  *sc,
                       g_snprintf (error_str, sizeof (error_str),
                                   "Item %d in vector is not a number (argument %d for function %s)",
                                   j+1, i+1, proc_name);
-                      return foreign_error (sc, error_str, vector);
+                      return_val = foreign_error (sc, error_str, vector);
+                      goto out;
                     }
 
                   args[i].data.d_floatarray[j] =
@@ -971,7 +1001,8 @@ script_fu_marshal_procedure_call (scheme  *sc,
                               "length of %d but expected length of %d",
                               i+1, proc_name,
                               sc->vptr->list_length (sc, vector), n_elements);
-                  return foreign_error (sc, error_str, 0);
+                  return_val = foreign_error (sc, error_str, 0);
+                  goto out;
                 }
 
               args[i].data.d_stringarray = g_new (gchar *, n_elements);
@@ -985,7 +1016,8 @@ script_fu_marshal_procedure_call (scheme  *sc,
                       g_snprintf (error_str, sizeof (error_str),
                                   "Item %d in vector is not a string (argument %d for function %s)",
                                   j+1, i+1, proc_name);
-                      return foreign_error (sc, error_str, vector);
+                      return_val = foreign_error (sc, error_str, vector);
+                      goto out;
                     }
 
                   args[i].data.d_stringarray[j] =
@@ -1082,7 +1114,8 @@ script_fu_marshal_procedure_call (scheme  *sc,
                               "size of %ld but expected size of %d",
                               i+1, proc_name,
                               sc->vptr->vector_length (vector), n_elements);
-                  return foreign_error (sc, error_str, 0);
+                  return_val = foreign_error (sc, error_str, 0);
+                  goto out;
                 }
 
               args[i].data.d_colorarray = g_new (GimpRGB, n_elements);
@@ -1102,7 +1135,8 @@ script_fu_marshal_procedure_call (scheme  *sc,
                                   "Item %d in vector is not a color "
                                   "(argument %d for function %s)",
                                   j+1, i+1, proc_name);
-                      return foreign_error (sc, error_str, vector);
+                      return_val = foreign_error (sc, error_str, vector);
+                      goto out;
                     }
 
                   color_list = sc->vptr->pair_car (v_element);
@@ -1186,16 +1220,18 @@ script_fu_marshal_procedure_call (scheme  *sc,
           break;
 
         case GIMP_PDB_STATUS:
-          return foreign_error (sc,
-                                "Status is for return types, not arguments",
-                                sc->vptr->pair_car (a));
+          return_val = foreign_error (sc,
+                                      "Status is for return types, not arguments",
+                                      sc->vptr->pair_car (a));
+          goto out;
           break;
 
         default:
           g_snprintf (error_str, sizeof (error_str),
                       "Argument %d for %s is an unknown type",
                       i+1, proc_name);
-          return foreign_error (sc, error_str, 0);
+          return_val = foreign_error (sc, error_str, 0);
+          goto out;
         }
 
       /* Break out of loop before i gets updated when error was detected */
@@ -1227,7 +1263,8 @@ script_fu_marshal_procedure_call (scheme  *sc,
       g_snprintf (error_str, sizeof (error_str),
                   "Invalid type for argument %d to %s",
                   i+1, proc_name);
-      return foreign_error (sc, error_str, 0);
+      return_val = foreign_error (sc, error_str, 0);
+      goto out;
     }
 
   /*  Check the return status  */
@@ -1240,7 +1277,8 @@ script_fu_marshal_procedure_call (scheme  *sc,
                   "Procedure execution of %s did not return a status",
                   proc_name);
 
-      return foreign_error (sc, error_str, 0);
+      return_val = foreign_error (sc, error_str, 0);
+      goto out;
     }
 
 #if DEBUG_MARSHALL
@@ -1269,10 +1307,14 @@ script_fu_marshal_procedure_call (scheme  *sc,
                       "Procedure execution of %s failed",
                       proc_name);
         }
-      return foreign_error (sc, error_str, 0);
+      return_val = foreign_error (sc, error_str, 0);
+      goto out;
       break;
 
     case GIMP_PDB_CALLING_ERROR:
+      /*  look the signature up again the next time, it might be stale  */
+      g_hash_table_remove (proc_signatures, proc_name);
+
       if (nvalues > 1 && values[1].type == GIMP_PDB_STRING)
         {
           g_snprintf (error_str, sizeof (error_str),
@@ -1285,7 +1327,8 @@ script_fu_marshal_procedure_call (scheme  *sc,
                       "Procedure execution of %s failed on invalid input arguments",
                       proc_name);
         }
-      return foreign_error (sc, error_str, 0);
+      return_val = foreign_error (sc, error_str, 0);
+      goto out;
       break;
 
     case GIMP_PDB_SUCCESS:
@@ -1532,11 +1575,13 @@ script_fu_marshal_procedure_call (scheme  *sc,
               break;
 
             case GIMP_PDB_STATUS:
-              return foreign_error (sc, "Procedure execution returned multiple status values", 0);
+              return_val = foreign_error (sc, "Procedure execution returned multiple status values", 0);
+              goto out;
               break;
 
             default:
-              return foreign_error (sc, "Unknown return type", 0);
+              return_val = foreign_error (sc, "Unknown return type", 0);
+              goto out;
             }
         }
 
@@ -1556,27 +1601,25 @@ script_fu_marshal_procedure_call (scheme  *sc,
         return_val = sc->vptr->cons (sc, sc->F, sc->NIL);
     }
 
+ out:
   /*  free the proc name  */
   g_free (proc_name);
 
   /*  free up the executed procedure return values  */
-  gimp_destroy_params (values, nvalues);
+  if (values)
+    gimp_destroy_params (values, nvalues);
 
   /*  free up arguments and values  */
   script_fu_marshal_destroy_args (args, nparams);
 
-  /*  free the query information  */
-  g_free (proc_blurb);
-  g_free (proc_help);
-  g_free (proc_author);
-  g_free (proc_copyright);
-  g_free (proc_date);
-  g_free (params);
-  g_free (return_vals);
+  if (signature)
+    proc_signature_unref (signature);
 
-  /*  if we're in server mode, listen for additional commands for 10 ms  */
+  /*  if we're in server mode, pick up additional commands, so they are
+   *  queued and stats requests are answered during long-running ones
+   */
   if (script_fu_server_get_mode ())
-    script_fu_server_listen (10);
+    script_fu_server_listen (0);
 
 #ifdef GDK_WINDOWING_WIN32
   /* This seems to help a lot on Windoze. */
@@ -1647,6 +1690,116 @@ script_fu_marshal_destroy_args (GimpParam *params,
   g_free (params);
 }
 
+static void
+proc_signature_insert (const gchar  *proc_name,
+                       gint          n_params,
+                       GimpParamDef *params,
+                       gint          n_return_vals,
+                       GimpParamDef *return_vals)
+{
+  ProcSignature *signature;
+  gint           i;
+
+  if (! proc_signatures)
+    proc_signatures = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                             g_free,
+                                             (GDestroyNotify) proc_signature_unref);
+
+  /*  Free the names and the descriptions which are of no use here  */
+  for (i = 0; i < n_params; i++)
+    {
+      g_free (params[i].name);
+      g_free (params[i].description);
+
+      params[i].name        = NULL;
+      params[i].description = NULL;
+    }
+
+  for (i = 0; i < n_return_vals; i++)
+    {
+      g_free (return_vals[i].name);
+      g_free (return_vals[i].description);
+
+      return_vals[i].name        = NULL;
+      return_vals[i].description = NULL;
+    }
+
+  signature = g_slice_new (ProcSignature);
+
+  signature->ref_count     = 1;
+  signature->n_params      = n_params;
+  signature->params        = params;
+  signature->n_return_vals = n_return_vals;
+  signature->return_vals   = return_vals;
+
+  g_hash_table_replace (proc_signatures, g_strdup (proc_name), signature);
+}
+
+static ProcSignature *
+proc_signature_lookup (const gchar *proc_name,
+                       gboolean     refresh)
+{
+  ProcSignature   *signature = NULL;
+  gchar           *proc_blurb;
+  gchar           *proc_help;
+  gchar           *proc_author;
+  gchar           *proc_copyright;
+  gchar           *proc_date;
+  GimpPDBProcType  proc_type;
+  gint             n_params;
+  gint             n_return_vals;
+  GimpParamDef    *params;
+  GimpParamDef    *return_vals;
+
+  if (proc_signatures)
+    {
+      if (refresh)
+        g_hash_table_remove (proc_signatures, proc_name);
+      else
+        signature = g_hash_table_lookup (proc_signatures, proc_name);
+    }
+
+  if (signature)
+    return signature;
+
+  if (! gimp_procedural_db_proc_info (proc_name,
+                                      &proc_blurb,
+                                      &proc_help,
+                                      &proc_author,
+                                      &proc_copyright,
+                                      &proc_date,
+                                      &proc_type,
+                                      &n_params, &n_return_vals,
+                                      &params, &return_vals))
+    {
+      return NULL;
+    }
+
+  g_free (proc_blurb);
+  g_free (proc_help);
+  g_free (proc_author);
+  g_free (proc_copyright);
+  g_free (proc_date);
+
+  proc_signature_insert (proc_name,
+                         n_params,      params,
+                         n_return_vals, return_vals);
+
+  return g_hash_table_lookup (proc_signatures, proc_name);
+}
+
+static void
+proc_signature_unref (ProcSignature *signature)
+{
+  if (--signature->ref_count == 0)
+    {
+      g_free (signature->params);
+      g_free (signature->return_vals);
+
+      g_slice_free (ProcSignature, signature);
+    }
+}
+
 static pointer
 script_fu_register_call (scheme  *sc,
                          pointer  a)
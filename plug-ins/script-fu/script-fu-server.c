@@ -81,6 +81,7 @@ typedef short sa_family_t;	/* Not defined by winsock */
 #define COMMAND_HEADER  3
 #define RESPONSE_HEADER 4
 #define MAGIC           'G'
+#define STATS_MAGIC     'S'
 
 #ifndef HAVE_DIFFTIME
 #define difftime(a,b) (((gdouble)(a)) - ((gdouble)(b)))
@@ -112,6 +113,30 @@ typedef short sa_family_t;	/* Not defined by winsock */
  *           MAGIC      ERROR?     RSP_LEN_H  RSP_LEN_L
  */
 
+/*  The length fields limit commands and response frames to 65535
+ *  bytes. Longer responses are split into several frames, each with
+ *  its own header: all but the last one have RSP_CONTINUED set in the
+ *  ERROR? byte, and RSP_ERROR is set in all of them if the command
+ *  failed. Clients which read a single frame get responses of up to
+ *  65535 bytes exactly as before.
+ */
+
+/*  A command header starting with STATS_MAGIC instead of MAGIC asks
+ *  for the server's queue and latency statistics. It is answered right
+ *  away, without waiting in the request queue; the command text is
+ *  ignored.
+ */
+
+/*  A server started with interpreter processes runs each of them as a
+ *  headless GIMP calling plug-in-script-fu-server-worker, which connects
+ *  back to a private port on 127.0.0.1 and identifies itself by sending
+ *  the server's token in a command frame. After that the server sends
+ *  the commands to the worker in command frames and the worker answers
+ *  in response frames, which the server passes on to the client. The
+ *  worker sets RSP_QUIT in the last frame of a command which called
+ *  script-fu-quit; the flag is not passed on.
+ */
+
 #define MAGIC_BYTE      0
 
 #define CMD_LEN_H_BYTE  1
@@ -121,26 +146,63 @@ typedef short sa_family_t;	/* Not defined by winsock */
 #define RSP_LEN_H_BYTE  2
 #define RSP_LEN_L_BYTE  3
 
+#define RSP_ERROR       0x01
+#define RSP_CONTINUED   0x02
+#define RSP_QUIT        0x04
+
+#define MAX_WORKERS     64
+
 /*
  *  Local Types
  */
 
 typedef struct
 {
-  gchar *command;
-  gint   filedes;
-  gint   request_no;
+  gint      filedes;   /*  -1 once the client disconnected        */
+  gchar    *name;
+  GQueue    commands;  /*  the client's pending requests          */
+  gboolean  ready;     /*  whether the client is in ready_clients */
+  gboolean  running;   /*  whether one of its requests is running */
+} SFClient;
+
+typedef struct
+{
+  gchar    *command;
+  SFClient *client;
+  gint      request_no;
+  gint64    received;
+  gint64    started;
 } SFCommand;
 
+typedef struct
+{
+  gint       index;
+  gint       filedes;  /*  -1 while the process is starting       */
+  SFCommand *cmd;      /*  the request it runs, NULL when idle    */
+} SFWorker;
+
+typedef struct
+{
+  gint      n_processed;
+  gint      n_errors;
+  gint      max_queue_length;
+  gdouble   total_wait;
+  gdouble   max_wait;
+  gdouble   total_time;
+  gdouble   max_time;
+} SFStats;
+
 typedef struct
 {
   GtkWidget *ip_entry;
   GtkWidget *port_entry;
   GtkWidget *log_entry;
+  GtkObject *workers_adj;
 
   gchar     *listen_ip;
   gint       port;
   gchar     *logfile;
+  gint       n_workers;
 
   gboolean   run;
 } ServerInterface;
@@ -160,9 +222,41 @@ typedef union
 
 static void      server_start       (const gchar *listen_ip,
                                      gint         port,
-                                     const gchar *logfile);
-static gboolean  execute_command    (SFCommand   *cmd);
-static gint      read_from_client   (gint         filedes);
+                                     const gchar *logfile,
+                                     gint         n);
+static void      run_command        (SFCommand   *cmd);
+static void      command_finished   (SFCommand   *cmd,
+                                     gboolean     error);
+static gboolean  execute_command    (const gchar *command,
+                                     GString     *response);
+static gboolean  workers_start      (gint         n);
+static void      worker_spawn       (SFWorker    *worker);
+static void      worker_accept      (void);
+static void      worker_read        (SFWorker    *worker);
+static void      worker_lost        (SFWorker    *worker);
+static void      dispatch_commands  (void);
+static gint      worker_connect     (gint         port);
+static gint      read_from_client   (SFClient    *client);
+static gboolean  read_message       (gint         filedes,
+                                     guchar      *magic,
+                                     gchar      **message);
+static gboolean  read_bytes         (gint         filedes,
+                                     gpointer     buffer,
+                                     gsize        len);
+static gboolean  send_message       (gint         filedes,
+                                     guchar       magic,
+                                     const gchar *message);
+static gboolean  send_response      (gint         filedes,
+                                     guchar       flags,
+                                     const gchar *response,
+                                     gsize        len);
+static gboolean  send_frame         (gint         filedes,
+                                     guchar       flags,
+                                     const gchar *data,
+                                     gsize        len);
+static gchar   * get_stats          (void);
+static void      client_free        (SFClient    *client);
+static gboolean  init_sockets       (void);
 static gint      make_socket        (const struct addrinfo
                                                  *ai);
 static void      server_log         (const gchar *format,
@@ -182,9 +276,17 @@ static gint         server_socks[2],
                     server_socks_used = 0;
 static const gint   server_socks_len = sizeof (server_socks) /
                                        sizeof (server_socks[0]);
-static GList       *command_queue   = NULL;
+static GQueue       ready_clients   = G_QUEUE_INIT;
 static gint         queue_length    = 0;
+static SFWorker    *workers         = NULL;
+static gint         n_workers       = 0;
+static GQueue       idle_workers    = G_QUEUE_INIT;
+static gint         worker_sock     = -1;
+static gint         worker_port     = 0;
+static gchar       *worker_token    = NULL;
+static gchar       *worker_program  = NULL;
 static gint         request_no      = 0;
+static SFStats      stats           = { 0, };
 static FILE        *server_log_file = NULL;
 static GHashTable  *clients         = NULL;
 static gboolean     script_fu_done  = FALSE;
@@ -195,10 +297,12 @@ static ServerInterface sint =
   NULL,  /*  port entry widget    */
   NULL,  /*  log entry widget     */
   NULL,  /*  ip entry widget      */
+  NULL,  /*  interpreters adj     */
 
   NULL,  /*  ip to bind to        */
   10008, /*  default port number  */
   NULL,  /*  use stdout           */
+  0,     /*  run in this process  */
 
   FALSE  /*  run                  */
 };
@@ -243,7 +347,8 @@ script_fu_server_run (const gchar      *name,
           server_mode = TRUE;
 
           /*  Start the server  */
-          server_start (sint.listen_ip, sint.port, sint.logfile);
+          server_start (sint.listen_ip, sint.port, sint.logfile,
+                        sint.n_workers);
         }
       break;
 
@@ -251,12 +356,15 @@ script_fu_server_run (const gchar      *name,
       /*  Set server_mode to TRUE  */
       server_mode = TRUE;
 
-      /*  Start the server  */
+      /*  Start the server, plug-in-script-fu-server-pool has the
+       *  number of interpreter processes as an extra argument
+       */
       server_start ((params[1].data.d_string &&
                      strlen (params[1].data.d_string)) ?
                     params[1].data.d_string : "127.0.0.1",
                     params[2].data.d_int32,
-                    params[3].data.d_string);
+                    params[3].data.d_string,
+                    nparams > 4 ? params[4].data.d_int32 : 0);
       break;
 
     case GIMP_RUN_WITH_LAST_VALS:
@@ -287,27 +395,25 @@ script_fu_server_read_fd (gpointer key,
                           gpointer value,
                           gpointer data)
 {
-  gint fd = GPOINTER_TO_INT (key);
+  SFClient *client = value;
+  gint      fd     = GPOINTER_TO_INT (key);
 
   if (FD_ISSET (fd, (SELECT_MASK *) data))
     {
-      if (read_from_client (fd) < 0)
+      if (read_from_client (client) < 0)
         {
-          GList *list;
-
-          server_log ("Server: disconnect from host %s.\n", (gchar *) value);
+          server_log ("Server: disconnect from host %s.\n", client->name);
 
           CLOSESOCKET (fd);
 
-          /*  Invalidate the file descriptor for pending commands
-              from the disconnected client.  */
-          for (list = command_queue; list; list = list->next)
-            {
-              SFCommand *cmd = (SFCommand *) command_queue->data;
+          /*  Pending commands from the disconnected client are still
+           *  run, but their results are dropped. The client is freed
+           *  once the last of them is done.
+           */
+          client->filedes = -1;
 
-              if (cmd->filedes == fd)
-                cmd->filedes = -1;
-            }
+          if (! client->ready && ! client->running)
+            client_free (client);
 
           return TRUE;  /*  remove this client from the hash table  */
         }
@@ -316,6 +422,10 @@ script_fu_server_read_fd (gpointer key,
   return FALSE;
 }
 
+/*  Services the server and client sockets. @timeout is in milliseconds;
+ *  0 only picks up what is already pending, a negative value blocks
+ *  until there is some input.
+ */
 void
 script_fu_server_listen (gint timeout)
 {
@@ -323,12 +433,13 @@ script_fu_server_listen (gint timeout)
   struct timeval *tvp = NULL;
   SELECT_MASK     fds;
   gint            sockno;
+  gint            i;
 
   /*  Set time struct  */
-  if (timeout)
+  if (timeout >= 0)
     {
       tv.tv_sec  = timeout / 1000;
-      tv.tv_usec = timeout % 1000;
+      tv.tv_usec = (timeout % 1000) * 1000;
       tvp = &tv;
     }
 
@@ -339,13 +450,32 @@ script_fu_server_listen (gint timeout)
     }
   g_hash_table_foreach (clients, script_fu_server_add_fd, &fds);
 
+  if (worker_sock >= 0)
+    FD_SET (worker_sock, &fds);
+
+  for (i = 0; i < n_workers; i++)
+    {
+      if (workers[i].filedes >= 0)
+        FD_SET (workers[i].filedes, &fds);
+    }
+
   /* Block until input arrives on one or more active sockets
      or timeout occurs. */
 
-  if (select (FD_SETSIZE, &fds, NULL, NULL, tvp) < 0)
+  switch (select (FD_SETSIZE, &fds, NULL, NULL, tvp))
     {
-      print_socket_api_error ("select");
+    case -1:
+#ifndef G_OS_WIN32
+      if (errno != EINTR)
+#endif
+        print_socket_api_error ("select");
       return;
+
+    case 0:
+      return;  /*  timeout, nothing pending  */
+
+    default:
+      break;
     }
 
   /* Service the server sockets if any has input pending. */
@@ -353,6 +483,7 @@ script_fu_server_listen (gint timeout)
     {
       sa_union                 client;
       gchar                    clientname[NI_MAXHOST];
+      SFClient                *sf_client;
 
       /* Connection request on original socket. */
       guint                    size = sizeof (client);
@@ -381,8 +512,13 @@ script_fu_server_listen (gint timeout)
       (void) getnameinfo (&(client.sa), size, clientname, sizeof (clientname),
                           NULL, 0, NI_NUMERICHOST);
 
-      g_hash_table_insert (clients, GINT_TO_POINTER (new),
-                           g_strdup (clientname));
+      sf_client = g_slice_new0 (SFClient);
+
+      sf_client->filedes = new;
+      sf_client->name    = g_strdup (clientname);
+      g_queue_init (&sf_client->commands);
+
+      g_hash_table_insert (clients, GINT_TO_POINTER (new), sf_client);
 
       /* Determine port number */
       switch (client.family)
@@ -403,6 +539,16 @@ script_fu_server_listen (gint timeout)
 
   /* Service the client sockets. */
   g_hash_table_foreach_remove (clients, script_fu_server_read_fd, &fds);
+
+  /* Service the interpreter processes. */
+  for (i = 0; i < n_workers; i++)
+    {
+      if (workers[i].filedes >= 0 && FD_ISSET (workers[i].filedes, &fds))
+        worker_read (&workers[i]);
+    }
+
+  if (worker_sock >= 0 && FD_ISSET (worker_sock, &fds))
+    worker_accept ();
 }
 
 static void
@@ -456,10 +602,78 @@ server_progress_uninstall (const gchar *progress)
   gimp_progress_uninstall (progress);
 }
 
+void
+script_fu_server_worker_run (const gchar      *name,
+                             gint              nparams,
+                             const GimpParam  *params,
+                             gint             *nreturn_vals,
+                             GimpParam       **return_vals)
+{
+  static GimpParam   values[1];
+  GimpPDBStatusType  status = GIMP_PDB_EXECUTION_ERROR;
+  const gchar       *token;
+  gint               filedes;
+
+  ts_set_run_mode (GIMP_RUN_NONINTERACTIVE);
+  ts_set_print_flag (1);
+
+  /*  Our own few messages go to the server's terminal  */
+  server_log_file = stderr;
+
+  token   = params[2].data.d_string ? params[2].data.d_string : "";
+  filedes = worker_connect (params[1].data.d_int32);
+
+  /*  Introduce ourselves to the server, then run its commands until
+   *  it closes the connection
+   */
+  if (filedes >= 0 && send_message (filedes, MAGIC, token))
+    {
+      const gchar *progress = server_progress_install ();
+      guchar       magic;
+      gchar       *command;
+
+      while (! script_fu_done && read_message (filedes, &magic, &command))
+        {
+          GString  *response = g_string_new (NULL);
+          guchar    flags    = 0;
+          gboolean  success;
+
+          if (! execute_command (command, response))
+            flags |= RSP_ERROR;
+
+          if (script_fu_done)
+            flags |= RSP_QUIT;
+
+          success = send_response (filedes, flags,
+                                   response->str, response->len);
+
+          g_string_free (response, TRUE);
+          g_free (command);
+
+          if (! success)
+            break;
+        }
+
+      server_progress_uninstall (progress);
+
+      status = GIMP_PDB_SUCCESS;
+    }
+
+  if (filedes >= 0)
+    CLOSESOCKET (filedes);
+
+  *nreturn_vals = 1;
+  *return_vals = values;
+
+  values[0].type = GIMP_PDB_STATUS;
+  values[0].data.d_status = status;
+}
+
 static void
 server_start (const gchar *listen_ip,
               gint         port,
-              const gchar *logfile)
+              const gchar *logfile,
+              gint         n)
 {
   struct addrinfo *ai;
   struct addrinfo *ai_curr;
@@ -509,34 +723,52 @@ server_start (const gchar *listen_ip,
   if (! server_log_file)
     server_log_file = stdout;
 
-  /*  Set up the clientname hash table  */
-  clients = g_hash_table_new_full (g_direct_hash, NULL,
-                                   NULL, (GDestroyNotify) g_free);
+  /*  Set up the client table, clients are freed separately since
+   *  their commands can outlive the connection
+   */
+  clients = g_hash_table_new (g_direct_hash, NULL);
 
   progress = server_progress_install ();
 
+  if (n > 0 && ! workers_start (MIN (n, MAX_WORKERS)))
+    server_log ("Server: can't start interpreter processes, "
+                "running the commands in this process.\n");
+
   server_log ("Script-Fu server initialized and listening...\n");
 
   /*  Loop until the server is finished  */
   while (! script_fu_done)
     {
-      script_fu_server_listen (0);
+      /*  Block while there is nothing to do. When this process runs the
+       *  commands itself, only pick up new requests between them, so
+       *  they take part in the round-robin below
+       */
+      if (n_workers == 0 && ! g_queue_is_empty (&ready_clients))
+        script_fu_server_listen (0);
+      else
+        script_fu_server_listen (-1);
 
-      while (command_queue)
+      if (n_workers > 0)
+        {
+          dispatch_commands ();
+        }
+      else if (! g_queue_is_empty (&ready_clients))
         {
-          SFCommand *cmd = (SFCommand *) command_queue->data;
+          SFClient  *client;
+          SFCommand *cmd;
 
-          /*  Process the command  */
-          execute_command (cmd);
+          /*  Run one command of each client in turn, so a client
+           *  sending many requests can't starve the others
+           */
+          client = g_queue_pop_head (&ready_clients);
+          client->ready   = FALSE;
+          client->running = TRUE;
 
-          /*  Remove the command from the list  */
-          command_queue = g_list_remove (command_queue, cmd);
+          cmd = g_queue_pop_head (&client->commands);
           queue_length--;
 
-          /*  Free the request  */
-          g_free (cmd->command);
-          g_free (cmd);
-      }
+          run_command (cmd);
+        }
     }
 
   server_progress_uninstall (progress);
@@ -544,86 +776,467 @@ server_start (const gchar *listen_ip,
   server_quit ();
 }
 
-static gboolean
-execute_command (SFCommand *cmd)
+/*  Runs @cmd in this process  */
+static void
+run_command (SFCommand *cmd)
 {
-  guchar      buffer[RESPONSE_HEADER];
-  GString    *response;
-  time_t      clocknow;
-  gboolean    error;
-  gint        i;
-  gdouble     total_time;
-  GTimer     *timer;
+  GString  *response;
+  gboolean  error;
 
-  server_log ("Processing request #%d\n", cmd->request_no);
-  timer = g_timer_new ();
+  cmd->started = g_get_monotonic_time ();
+
+  server_log ("Processing request #%d after waiting %.3f seconds\n",
+              cmd->request_no,
+              (cmd->started - cmd->received) / 1000000.0);
 
   response = g_string_new (NULL);
+
+  error = ! execute_command (cmd->command, response);
+
+  if (error)
+    server_log ("%s\n", response->str);
+
+  /*  Write the response to the client  */
+  send_response (cmd->client->filedes, error ? RSP_ERROR : 0,
+                 response->str, response->len);
+
+  g_string_free (response, TRUE);
+
+  command_finished (cmd, error);
+}
+
+/*  Updates the statistics for @cmd, whose response has been sent, puts
+ *  its client back into the queue if it has more requests, and frees
+ *  @cmd
+ */
+static void
+command_finished (SFCommand *cmd,
+                  gboolean   error)
+{
+  SFClient *client = cmd->client;
+  time_t    clocknow;
+  gdouble   wait_time;
+  gdouble   total_time;
+
+  wait_time  = (cmd->started - cmd->received) / 1000000.0;
+  total_time = (g_get_monotonic_time () - cmd->started) / 1000000.0;
+
+  if (! error)
+    {
+      time (&clocknow);
+      server_log ("Request #%d processed in %.3f seconds, finishing on %s",
+                  cmd->request_no, total_time, ctime (&clocknow));
+    }
+
+  stats.n_processed++;
+  stats.total_wait += wait_time;
+  stats.max_wait    = MAX (stats.max_wait, wait_time);
+  stats.total_time += total_time;
+  stats.max_time    = MAX (stats.max_time, total_time);
+
+  if (error)
+    stats.n_errors++;
+
+  g_free (cmd->command);
+  g_free (cmd);
+
+  client->running = FALSE;
+
+  if (! g_queue_is_empty (&client->commands))
+    {
+      g_queue_push_tail (&ready_clients, client);
+      client->ready = TRUE;
+    }
+  else if (client->filedes < 0)
+    {
+      client_free (client);
+    }
+}
+
+/*  Interprets @command, appending its output or error message to
+ *  @response. Returns FALSE if the command failed.
+ */
+static gboolean
+execute_command (const gchar *command,
+                 GString     *response)
+{
+  gboolean success = TRUE;
+
   ts_register_output_func (ts_gstring_output_func, response);
 
   /*  run the command  */
-  if (ts_interpret_string (cmd->command) != 0)
+  if (ts_interpret_string (command) != 0)
+    success = FALSE;
+  else if (response->len == 0)
+    g_string_assign (response, ts_get_success_msg ());
+
+  return success;
+}
+
+/*  Returns the GIMP executable to run the interpreter processes with,
+ *  preferring the one without user interface
+ */
+static gchar *
+worker_get_program (void)
+{
+  const gchar *names[] = { "gimp-console-" GIMP_APP_VERSION,
+                           "gimp-" GIMP_APP_VERSION };
+  gint         i;
+
+  for (i = 0; i < G_N_ELEMENTS (names); i++)
+    {
+      gchar *program;
+      gchar *basename;
+
+#ifdef G_OS_WIN32
+      gchar *dir;
+
+      basename = g_strconcat (names[i], ".exe", NULL);
+
+      dir     = g_build_filename (gimp_installation_directory (), "bin", NULL);
+      program = g_build_filename (dir, basename, NULL);
+      g_free (dir);
+#else
+      basename = g_strdup (names[i]);
+      program  = g_build_filename (BINDIR, basename, NULL);
+#endif
+
+      if (! g_file_test (program, G_FILE_TEST_IS_EXECUTABLE))
+        {
+          g_free (program);
+          program = g_find_program_in_path (basename);
+        }
+
+      g_free (basename);
+
+      if (program)
+        return program;
+    }
+
+  return NULL;
+}
+
+/*  Sets up the private port the interpreter processes connect to and
+ *  starts @n of them
+ */
+static gboolean
+workers_start (gint n)
+{
+  struct addrinfo  *ai;
+  struct addrinfo   hints;
+  sa_union          addr;
+  socklen_t         size = sizeof (addr);
+  gint              i;
+
+  worker_program = worker_get_program ();
+
+  if (! worker_program)
+    return FALSE;
+
+  memset (&hints, 0, sizeof (hints));
+  hints.ai_flags    = AI_PASSIVE | AI_NUMERICHOST;
+  hints.ai_socktype = SOCK_STREAM;
+
+  if (getaddrinfo ("127.0.0.1", "0", &hints, &ai) != 0)
+    return FALSE;
+
+  worker_sock = make_socket (ai);
+  freeaddrinfo (ai);
+
+  if (listen (worker_sock, n) < 0 ||
+      getsockname (worker_sock, &addr.sa, &size) < 0)
+    {
+      print_socket_api_error ("listen");
+      CLOSESOCKET (worker_sock);
+      worker_sock = -1;
+
+      return FALSE;
+    }
+
+  worker_port  = g_ntohs (addr.sa_in.sin_port);
+  worker_token = g_strdup_printf ("%08x%08x%08x%08x",
+                                  g_random_int (), g_random_int (),
+                                  g_random_int (), g_random_int ());
+
+  n_workers = n;
+  workers   = g_new0 (SFWorker, n_workers);
+
+  for (i = 0; i < n_workers; i++)
     {
-      error = TRUE;
+      workers[i].index   = i;
+      workers[i].filedes = -1;
 
-      server_log ("%s\n", response->str);
+      worker_spawn (&workers[i]);
+    }
+
+  return TRUE;
+}
+
+/*  Starts a headless GIMP which runs plug-in-script-fu-server-worker
+ *  for @worker. It connects to worker_sock once it is up.
+ */
+static void
+worker_spawn (SFWorker *worker)
+{
+  gchar  *command;
+  gchar  *argv[9];
+  GError *error = NULL;
+
+  command = g_strdup_printf ("(plug-in-script-fu-server-worker %d %d \"%s\")",
+                             GIMP_RUN_NONINTERACTIVE,
+                             worker_port, worker_token);
+
+  argv[0] = worker_program;
+  argv[1] = "--no-interface";
+  argv[2] = "--batch-interpreter";
+  argv[3] = "plug-in-script-fu-eval";
+  argv[4] = "--batch";
+  argv[5] = command;
+  argv[6] = "--batch";
+  argv[7] = "(gimp-quit 0)";
+  argv[8] = NULL;
+
+  if (g_spawn_async (NULL, argv, NULL, G_SPAWN_STDOUT_TO_DEV_NULL,
+                     NULL, NULL, NULL, &error))
+    {
+      server_log ("Server: starting interpreter %d.\n", worker->index);
     }
   else
     {
-      error = FALSE;
+      server_log ("Server: can't start interpreter %d: %s\n",
+                  worker->index, error->message);
+      g_clear_error (&error);
+    }
 
-      if (response->len == 0)
-        g_string_assign (response, ts_get_success_msg ());
+  g_free (command);
+}
 
-      total_time = g_timer_elapsed (timer, NULL);
-      time (&clocknow);
-      server_log ("Request #%d processed in %.3f seconds, finishing on %s",
-                  cmd->request_no, total_time, ctime (&clocknow));
+/*  Accepts the connection of a starting interpreter process  */
+static void
+worker_accept (void)
+{
+  guchar  magic;
+  gchar  *token;
+  gint    filedes;
+  gint    i;
+
+  filedes = accept (worker_sock, NULL, NULL);
+
+  if (filedes < 0)
+    {
+      print_socket_api_error ("accept");
+      return;
     }
-  g_timer_destroy (timer);
 
-  buffer[MAGIC_BYTE]     = MAGIC;
-  buffer[ERROR_BYTE]     = error ? TRUE : FALSE;
-  buffer[RSP_LEN_H_BYTE] = (guchar) (response->len >> 8);
-  buffer[RSP_LEN_L_BYTE] = (guchar) (response->len & 0xFF);
+  /*  Only our own processes know the token  */
+  if (read_message (filedes, &magic, &token))
+    {
+      gboolean valid = (magic == MAGIC && ! strcmp (token, worker_token));
 
-  /*  Write the response to the client  */
-  for (i = 0; i < RESPONSE_HEADER; i++)
-    if (cmd->filedes > 0 && send (cmd->filedes, buffer + i, 1, 0) < 0)
-      {
-        /*  Write error  */
-        print_socket_api_error ("send");
-        return FALSE;
-      }
+      g_free (token);
 
-  for (i = 0; i < response->len; i++)
-    if (cmd->filedes > 0 && send (cmd->filedes, response->str + i, 1, 0) < 0)
-      {
-        /*  Write error  */
-        print_socket_api_error ("send");
-        return FALSE;
-      }
+      for (i = 0; valid && i < n_workers; i++)
+        {
+          if (workers[i].filedes < 0)
+            {
+              workers[i].filedes = filedes;
+              g_queue_push_tail (&idle_workers, &workers[i]);
 
-  g_string_free (response, TRUE);
+              server_log ("Server: interpreter %d ready.\n", i);
 
-  return FALSE;
+              return;
+            }
+        }
+    }
+
+  server_log ("Server: rejected an interpreter connection.\n");
+
+  CLOSESOCKET (filedes);
 }
 
+/*  Reads a response frame of @worker and passes it on to the client  */
+static void
+worker_read (SFWorker *worker)
+{
+  SFCommand *cmd = worker->cmd;
+  guchar     header[RESPONSE_HEADER];
+  gchar     *data;
+  guchar     flags;
+  gsize      len;
+
+  if (! read_bytes (worker->filedes, header, RESPONSE_HEADER) ||
+      header[MAGIC_BYTE] != MAGIC || ! cmd)
+    {
+      worker_lost (worker);
+      return;
+    }
+
+  flags = header[ERROR_BYTE];
+  len   = (header[RSP_LEN_H_BYTE] << 8) | header[RSP_LEN_L_BYTE];
+  data  = g_new (gchar, len + 1);
+
+  if (! read_bytes (worker->filedes, data, len))
+    {
+      g_free (data);
+      worker_lost (worker);
+      return;
+    }
+
+  data[len] = '\0';
+
+  if (flags & RSP_ERROR)
+    server_log ("%s\n", data);
+
+  if (cmd->client->filedes >= 0)
+    send_frame (cmd->client->filedes, flags & (RSP_ERROR | RSP_CONTINUED),
+                data, len);
+
+  g_free (data);
+
+  if (! (flags & RSP_CONTINUED))
+    {
+      worker->cmd = NULL;
+      g_queue_push_tail (&idle_workers, worker);
+
+      command_finished (cmd, (flags & RSP_ERROR) != 0);
+
+      if (flags & RSP_QUIT)
+        script_fu_done = TRUE;
+    }
+}
+
+/*  Called when the connection to @worker broke, fails its request and
+ *  starts a new process in its place
+ */
+static void
+worker_lost (SFWorker *worker)
+{
+  server_log ("Server: interpreter %d exited.\n", worker->index);
+
+  CLOSESOCKET (worker->filedes);
+  worker->filedes = -1;
+
+  g_queue_remove (&idle_workers, worker);
+
+  if (worker->cmd)
+    {
+      const gchar *message = "Script-Fu interpreter process exited";
+      SFCommand   *cmd     = worker->cmd;
+
+      worker->cmd = NULL;
+
+      send_response (cmd->client->filedes, RSP_ERROR,
+                     message, strlen (message));
+
+      command_finished (cmd, TRUE);
+    }
+
+  if (! script_fu_done)
+    worker_spawn (worker);
+}
+
+/*  Hands the next request of each ready client in turn to an idle
+ *  interpreter process. A client has at most one request running, so
+ *  its responses arrive in order and a client sending many requests
+ *  can't take all interpreters.
+ */
+static void
+dispatch_commands (void)
+{
+  while (! g_queue_is_empty (&ready_clients) &&
+         ! g_queue_is_empty (&idle_workers))
+    {
+      SFClient  *client = g_queue_pop_head (&ready_clients);
+      SFWorker  *worker = g_queue_pop_head (&idle_workers);
+      SFCommand *cmd;
+
+      client->ready   = FALSE;
+      client->running = TRUE;
+
+      cmd = g_queue_pop_head (&client->commands);
+      queue_length--;
+
+      cmd->started = g_get_monotonic_time ();
+      worker->cmd  = cmd;
+
+      server_log ("Processing request #%d in interpreter %d "
+                  "after waiting %.3f seconds\n",
+                  cmd->request_no, worker->index,
+                  (cmd->started - cmd->received) / 1000000.0);
+
+      if (! send_message (worker->filedes, MAGIC, cmd->command))
+        worker_lost (worker);
+    }
+}
+
+/*  Connects an interpreter process to the server's private port  */
 static gint
-read_from_client (gint filedes)
+worker_connect (gint port)
 {
-  SFCommand *cmd;
-  guchar     buffer[COMMAND_HEADER];
-  gchar     *command;
-  gchar     *clientaddr;
-  time_t     clock;
-  gint       command_len;
-  gint       nbytes;
-  gint       i;
+  struct addrinfo *ai;
+  struct addrinfo  hints;
+  gchar           *port_s;
+  gint             sock;
+  gint             e;
+
+  if (! init_sockets ())
+    return -1;
+
+  memset (&hints, 0, sizeof (hints));
+  hints.ai_flags    = AI_NUMERICHOST;
+  hints.ai_socktype = SOCK_STREAM;
+
+  port_s = g_strdup_printf ("%d", port);
+  e = getaddrinfo ("127.0.0.1", port_s, &hints, &ai);
+  g_free (port_s);
+
+  if (e != 0)
+    {
+      g_printerr ("getaddrinfo: %s\n", gai_strerror (e));
+      return -1;
+    }
 
-  for (i = 0; i < COMMAND_HEADER;)
+  sock = socket (ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+
+  if (sock < 0 || connect (sock, ai->ai_addr, ai->ai_addrlen) < 0)
     {
-      nbytes = recv (filedes, buffer + i, COMMAND_HEADER - i, 0);
+      print_socket_api_error ("connect");
+
+      if (sock >= 0)
+        CLOSESOCKET (sock);
+
+      sock = -1;
+    }
+
+  freeaddrinfo (ai);
+
+  return sock;
+}
+
+/*  Sends a command frame with @message  */
+static gboolean
+send_message (gint         filedes,
+              guchar       magic,
+              const gchar *message)
+{
+  guchar buffer[COMMAND_HEADER];
+  gsize  len = MIN (strlen (message), G_MAXUINT16);
+  gsize  i;
+
+  buffer[MAGIC_BYTE]     = magic;
+  buffer[CMD_LEN_H_BYTE] = (guchar) (len >> 8);
+  buffer[CMD_LEN_L_BYTE] = (guchar) (len & 0xFF);
+
+  for (i = 0; i < COMMAND_HEADER + len;)
+    {
+      gint nbytes;
+
+      if (i < COMMAND_HEADER)
+        nbytes = send (filedes, (const gchar *) buffer + i,
+                       COMMAND_HEADER - i, 0);
+      else
+        nbytes = send (filedes, message + i - COMMAND_HEADER,
+                       COMMAND_HEADER + len - i, 0);
 
       if (nbytes < 0)
         {
@@ -631,73 +1244,269 @@ read_from_client (gint filedes)
           if (errno == EINTR)
             continue;
 #endif
-          server_log ("Error reading command header.\n");
-          return -1;
+          /*  Write error  */
+          print_socket_api_error ("send");
+          return FALSE;
         }
 
-      if (nbytes == 0)
-        return -1;  /* EOF */
-
       i += nbytes;
     }
 
-  if (buffer[MAGIC_BYTE] != MAGIC)
+  return TRUE;
+}
+
+/*  Sends @response in frames, @flags is 0 or RSP_ERROR, plus RSP_QUIT
+ *  for the last frame when an interpreter process sends it
+ */
+static gboolean
+send_response (gint         filedes,
+               guchar       flags,
+               const gchar *response,
+               gsize        len)
+{
+  /*  The client is gone, drop the response  */
+  if (filedes < 0)
+    return TRUE;
+
+  /*  The length field only has 16 bits, send longer responses in
+   *  several frames
+   */
+  do
     {
-      server_log ("Error in script-fu command transmission.\n");
-      return -1;
+      gsize  frame_len   = MIN (len, G_MAXUINT16);
+      guchar frame_flags = flags;
+
+      if (frame_len < len)
+        frame_flags = (flags & RSP_ERROR) | RSP_CONTINUED;
+
+      if (! send_frame (filedes, frame_flags, response, frame_len))
+        return FALSE;
+
+      response += frame_len;
+      len      -= frame_len;
     }
+  while (len > 0);
 
-  command_len = (buffer [CMD_LEN_H_BYTE] << 8) | buffer [CMD_LEN_L_BYTE];
-  command = g_new (gchar, command_len + 1);
+  return TRUE;
+}
 
-  for (i = 0; i < command_len;)
+static gboolean
+send_frame (gint         filedes,
+            guchar       flags,
+            const gchar *data,
+            gsize        len)
+{
+  guchar buffer[RESPONSE_HEADER];
+  gsize  i;
+
+  buffer[MAGIC_BYTE]     = MAGIC;
+  buffer[ERROR_BYTE]     = flags;
+  buffer[RSP_LEN_H_BYTE] = (guchar) (len >> 8);
+  buffer[RSP_LEN_L_BYTE] = (guchar) (len & 0xFF);
+
+  for (i = 0; i < RESPONSE_HEADER + len;)
     {
-      nbytes = recv (filedes, command + i, command_len - i, 0);
+      gint nbytes;
+
+      if (i < RESPONSE_HEADER)
+        nbytes = send (filedes, (const gchar *) buffer + i,
+                       RESPONSE_HEADER - i, 0);
+      else
+        nbytes = send (filedes, data + i - RESPONSE_HEADER,
+                       RESPONSE_HEADER + len - i, 0);
 
-      if (nbytes <= 0)
+      if (nbytes < 0)
         {
 #ifndef G_OS_WIN32
-          if (nbytes < 0 && errno == EINTR)
+          if (errno == EINTR)
             continue;
 #endif
-           server_log ("Error reading command.  Read %d out of %d bytes.\n",
-                       i, command_len);
-           g_free (command);
-           return -1;
+          /*  Write error  */
+          print_socket_api_error ("send");
+          return FALSE;
         }
 
       i += nbytes;
     }
 
-  command[command_len] = '\0';
-  cmd = g_new (SFCommand, 1);
+  return TRUE;
+}
+
+static gchar *
+get_stats (void)
+{
+  gdouble n      = MAX (stats.n_processed, 1);
+  gint    n_busy = 0;
+  gint    i;
+
+  for (i = 0; i < n_workers; i++)
+    {
+      if (workers[i].cmd)
+        n_busy++;
+    }
+
+  return g_strdup_printf ("workers %d\n"
+                          "idle-workers %d\n"
+                          "busy-workers %d\n"
+                          "queue-length %d\n"
+                          "max-queue-length %d\n"
+                          "processed %d\n"
+                          "errors %d\n"
+                          "mean-wait %.3f\n"
+                          "max-wait %.3f\n"
+                          "mean-time %.3f\n"
+                          "max-time %.3f\n",
+                          n_workers,
+                          g_queue_get_length (&idle_workers),
+                          n_busy,
+                          queue_length,
+                          stats.max_queue_length,
+                          stats.n_processed,
+                          stats.n_errors,
+                          stats.total_wait / n,
+                          stats.max_wait,
+                          stats.total_time / n,
+                          stats.max_time);
+}
+
+static gint
+read_from_client (SFClient *client)
+{
+  SFCommand *cmd;
+  guchar     magic;
+  gchar     *command;
+  time_t     clock;
+  gint       filedes = client->filedes;
+
+  if (! read_message (filedes, &magic, &command))
+    return -1;
+
+  if (magic == STATS_MAGIC)
+    {
+      gchar    *str = get_stats ();
+      gboolean  success;
+
+      g_free (command);
+
+      success = send_response (filedes, 0, str, strlen (str));
+      g_free (str);
+
+      return success ? 0 : -1;
+    }
+
+  cmd = g_new0 (SFCommand, 1);
 
-  cmd->filedes    = filedes;
+  cmd->client     = client;
   cmd->command    = command;
   cmd->request_no = request_no ++;
+  cmd->received   = g_get_monotonic_time ();
 
-  /*  Add the command to the queue  */
-  command_queue = g_list_append (command_queue, cmd);
+  /*  Add the command to the client's queue  */
+  g_queue_push_tail (&client->commands, cmd);
   queue_length ++;
 
-  /*  Get the client address from the address/socket table  */
-  clientaddr = g_hash_table_lookup (clients, GINT_TO_POINTER (cmd->filedes));
+  stats.max_queue_length = MAX (stats.max_queue_length, queue_length);
+
+  if (! client->ready && ! client->running)
+    {
+      g_queue_push_tail (&ready_clients, client);
+      client->ready = TRUE;
+    }
+
   time (&clock);
   server_log ("Received request #%d from IP address %s: %s on %s,"
               "[Request queue length: %d]",
               cmd->request_no,
-                  clientaddr ? clientaddr : "<invalid>",
+                  client->name,
                       cmd->command, ctime (&clock), queue_length);
 
   return 0;
 }
 
-static gint
-make_socket (const struct addrinfo *ai)
+/*  Reads a command frame, @message is nul-terminated  */
+static gboolean
+read_message (gint     filedes,
+              guchar  *magic,
+              gchar  **message)
 {
-  gint                    sock;
-  gint                    v = 1;
+  guchar buffer[COMMAND_HEADER];
+  gint   len;
+
+  if (! read_bytes (filedes, buffer, COMMAND_HEADER))
+    return FALSE;
+
+  if (buffer[MAGIC_BYTE] != MAGIC &&
+      buffer[MAGIC_BYTE] != STATS_MAGIC)
+    {
+      server_log ("Error in script-fu command transmission.\n");
+      return FALSE;
+    }
+
+  len = (buffer [CMD_LEN_H_BYTE] << 8) | buffer [CMD_LEN_L_BYTE];
+  *message = g_new (gchar, len + 1);
+
+  if (! read_bytes (filedes, *message, len))
+    {
+      server_log ("Error reading command.\n");
+      g_free (*message);
+      return FALSE;
+    }
+
+  (*message)[len] = '\0';
+  *magic          = buffer[MAGIC_BYTE];
+
+  return TRUE;
+}
+
+/*  Reads exactly @len bytes, returns FALSE on errors and EOF  */
+static gboolean
+read_bytes (gint     filedes,
+            gpointer buffer,
+            gsize    len)
+{
+  gsize i;
+
+  for (i = 0; i < len;)
+    {
+      gint nbytes = recv (filedes, (gchar *) buffer + i, len - i, 0);
+
+      if (nbytes < 0)
+        {
+#ifndef G_OS_WIN32
+          if (errno == EINTR)
+            continue;
+#endif
+          return FALSE;
+        }
+
+      if (nbytes == 0)
+        return FALSE;  /* EOF */
+
+      i += nbytes;
+    }
+
+  return TRUE;
+}
+
+static void
+client_free (SFClient *client)
+{
+  SFCommand *cmd;
+
+  while ((cmd = g_queue_pop_head (&client->commands)))
+    {
+      g_free (cmd->command);
+      g_free (cmd);
+    }
+
+  g_free (client->name);
 
+  g_slice_free (SFClient, client);
+}
+
+static gboolean
+init_sockets (void)
+{
   /*  Win32 needs the winsock library initialized.  */
 #ifdef G_OS_WIN32
   static gboolean    winsock_initialized = FALSE;
@@ -714,11 +1523,23 @@ make_socket (const struct addrinfo *ai)
       else
         {
           print_socket_api_error ("WSAStartup");
-          gimp_quit ();
+          return FALSE;
         }
     }
 #endif
 
+  return TRUE;
+}
+
+static gint
+make_socket (const struct addrinfo *ai)
+{
+  gint                    sock;
+  gint                    v = 1;
+
+  if (! init_sockets ())
+    gimp_quit ();
+
   /* Create the socket. */
   sock = socket (ai->ai_family, ai->ai_socktype, ai->ai_protocol);
   if (sock < 0)
@@ -774,19 +1595,64 @@ script_fu_server_shutdown_fd (gpointer key,
                               gpointer value,
                               gpointer data)
 {
+  SFClient *client = value;
+
   shutdown (GPOINTER_TO_INT (key), 2);
+
+  client->filedes = -1;
+
+  if (! client->ready && ! client->running)
+    client_free (client);
 }
 
 static void
 server_quit (void)
 {
   gint sockno;
+  gint i;
 
   for (sockno = 0; sockno < server_socks_used; sockno++)
     {
       CLOSESOCKET (server_socks[sockno]);
     }
 
+  /*  The interpreter processes quit when their connection closes,
+   *  the requests they were still running are dropped
+   */
+  for (i = 0; i < n_workers; i++)
+    {
+      SFCommand *cmd = workers[i].cmd;
+
+      if (workers[i].filedes >= 0)
+        CLOSESOCKET (workers[i].filedes);
+
+      if (cmd)
+        {
+          cmd->client->running = FALSE;
+
+          if (cmd->client->filedes < 0 && ! cmd->client->ready)
+            client_free (cmd->client);
+
+          g_free (cmd->command);
+          g_free (cmd);
+        }
+    }
+
+  if (worker_sock >= 0)
+    CLOSESOCKET (worker_sock);
+
+  g_queue_clear (&idle_workers);
+
+  g_free (workers);
+  g_free (worker_token);
+  g_free (worker_program);
+
+  workers        = NULL;
+  worker_token   = NULL;
+  worker_program = NULL;
+  worker_sock    = -1;
+  n_workers      = 0;
+
   if (clients)
     {
       g_hash_table_foreach (clients, script_fu_server_shutdown_fd, NULL);
@@ -794,17 +1660,13 @@ server_quit (void)
       clients = NULL;
     }
 
-  while (command_queue)
-    {
-      SFCommand *cmd = command_queue->data;
-
-      g_free (cmd->command);
-      g_free (cmd);
-    }
+  /*  Free the disconnected clients with pending commands, and the
+   *  connected ones which were still in the queue
+   */
+  while (! g_queue_is_empty (&ready_clients))
+    client_free (g_queue_pop_head (&ready_clients));
 
-  g_list_free (command_queue);
-  command_queue = NULL;
-  queue_length  = 0;
+  queue_length = 0;
 
   /*  Close the server log file  */
   if (server_log_file != stdout)
@@ -822,6 +1684,7 @@ server_interface (void)
   GtkWidget *hbox;
   GtkWidget *image;
   GtkWidget *label;
+  GtkWidget *spinbutton;
 
   INIT_I18N();
 
@@ -854,8 +1717,8 @@ server_interface (void)
                       main_vbox, TRUE, TRUE, 0);
   gtk_widget_show (main_vbox);
 
-  /*  The table to hold port, logfile and listen-to entries  */
-  table = gtk_table_new (3, 2, FALSE);
+  /*  The table to hold port, logfile, listen-to and interpreter entries  */
+  table = gtk_table_new (4, 2, FALSE);
   gtk_table_set_col_spacings (GTK_TABLE (table), 6);
   gtk_table_set_row_spacings (GTK_TABLE (table), 6);
   gtk_box_pack_start (GTK_BOX (main_vbox), table, FALSE, FALSE, 0);
@@ -881,6 +1744,20 @@ server_interface (void)
                              _("Server logfile:"), 0.0, 0.5,
                              sint.log_entry, 1, FALSE);
 
+  /*  The number of interpreter processes, 0 runs the commands in this
+   *  GIMP, where they can use its images
+   */
+  spinbutton = gimp_spin_button_new (&sint.workers_adj, sint.n_workers,
+                                     0, MAX_WORKERS, 1, 4, 0, 1, 0);
+  gimp_help_set_help_data (spinbutton,
+                           _("Number of GIMP processes running the commands "
+                             "in parallel. With 0 the commands run one at a "
+                             "time in this GIMP and can use its images."),
+                           NULL);
+  gimp_table_attach_aligned (GTK_TABLE (table), 0, 3,
+                             _("Interpreter processes:"), 0.0, 0.5,
+                             spinbutton, 1, TRUE);
+
   /* Warning */
   hbox = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 6);
   gtk_box_pack_start (GTK_BOX (main_vbox), hbox, FALSE, FALSE, 0);
@@ -922,6 +1799,8 @@ response_callback (GtkWidget *widget,
       sint.port      = atoi (gtk_entry_get_text (GTK_ENTRY (sint.port_entry)));
       sint.logfile   = g_strdup (gtk_entry_get_text (GTK_ENTRY (sint.log_entry)));
       sint.listen_ip = g_strdup (gtk_entry_get_text (GTK_ENTRY (sint.ip_entry)));
+      sint.n_workers =
+        RINT (gtk_adjustment_get_value (GTK_ADJUSTMENT (sint.workers_adj)));
       sint.run       = TRUE;
     }
 
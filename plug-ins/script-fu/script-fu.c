@@ -94,6 +94,22 @@ script_fu_query (void)
     { GIMP_PDB_STRING, "logfile",  "The file to log server activity to"       }
   };
 
+  static const GimpParamDef server_pool_args[] =
+  {
+    { GIMP_PDB_INT32,  "run-mode", "The run mode { RUN-NONINTERACTIVE (1) }"  },
+    { GIMP_PDB_STRING, "ip",       "The ip on which to listen for requests"   },
+    { GIMP_PDB_INT32,  "port",     "The port on which to listen for requests" },
+    { GIMP_PDB_STRING, "logfile",  "The file to log server activity to"       },
+    { GIMP_PDB_INT32,  "workers",  "The number of interpreter processes (0 <= workers <= 64)" }
+  };
+
+  static const GimpParamDef server_worker_args[] =
+  {
+    { GIMP_PDB_INT32,  "run-mode", "The run mode { RUN-NONINTERACTIVE (1) }"  },
+    { GIMP_PDB_INT32,  "port",     "The server's port for its interpreters"   },
+    { GIMP_PDB_STRING, "token",    "The server's token for its interpreters"  }
+  };
+
   gimp_plugin_domain_register (GETTEXT_PACKAGE "-script-fu", NULL);
 
   gimp_install_procedure ("extension-script-fu",
@@ -144,7 +160,14 @@ script_fu_query (void)
                           "API was changed in an incompatible way since "
                           "GIMP 2.8.12. You now have to pass the IP to listen "
                           "on as first parameter. Calling this procedure with "
-                          "the old API will fail on purpose.",
+                          "the old API will fail on purpose. "
+                          "The commands run one at a time in the GIMP which "
+                          "started the server, use "
+                          "plug-in-script-fu-server-pool to run them in "
+                          "parallel. "
+                          "Commands are limited to 65535 bytes, longer "
+                          "responses are sent in several frames, all but "
+                          "the last with 0x02 set in the error byte.",
                           "Spencer Kimball & Peter Mattis",
                           "Spencer Kimball & Peter Mattis",
                           "1997",
@@ -157,6 +180,41 @@ script_fu_query (void)
   gimp_plugin_menu_register ("plug-in-script-fu-server",
                              "<Image>/Filters/Languages/Script-Fu");
 
+  gimp_install_procedure ("plug-in-script-fu-server-pool",
+                          "Server for remote Script-Fu operation with "
+                          "several interpreters",
+                          "Like plug-in-script-fu-server, but the server "
+                          "starts 'workers' headless GIMP processes and "
+                          "hands each request to whichever of them is idle, "
+                          "taking the clients in turn. A client has at most "
+                          "one request running at a time, so it gets its "
+                          "responses in order, but consecutive requests can "
+                          "run in different processes and don't share "
+                          "images. The statistics cover all processes. "
+                          "With 0 workers this is plug-in-script-fu-server.",
+                          "Spencer Kimball & Peter Mattis",
+                          "Spencer Kimball & Peter Mattis",
+                          "1997",
+                          NULL,
+                          NULL,
+                          GIMP_PLUGIN,
+                          G_N_ELEMENTS (server_pool_args), 0,
+                          server_pool_args, NULL);
+
+  gimp_install_procedure ("plug-in-script-fu-server-worker",
+                          "Interpreter process of a Script-Fu server",
+                          "Runs the commands of the Script-Fu server "
+                          "listening for its interpreters on 'port'. "
+                          "Only the server calls this procedure.",
+                          "Spencer Kimball & Peter Mattis",
+                          "Spencer Kimball & Peter Mattis",
+                          "1997",
+                          NULL,
+                          NULL,
+                          GIMP_PLUGIN,
+                          G_N_ELEMENTS (server_worker_args), 0,
+                          server_worker_args, NULL);
+
   gimp_install_procedure ("plug-in-script-fu-eval",
                           "Evaluate scheme code",
                           "Evaluate the code under the scheme interpreter "
@@ -249,7 +307,8 @@ script_fu_run (const gchar      *name,
       script_fu_console_run (name, nparams, param,
                              nreturn_vals, return_vals);
     }
-  else if (strcmp (name, "plug-in-script-fu-server") == 0)
+  else if (strcmp (name, "plug-in-script-fu-server") == 0 ||
+           strcmp (name, "plug-in-script-fu-server-pool") == 0)
     {
       /*
        *  The script-fu server for remote operation
@@ -258,6 +317,15 @@ script_fu_run (const gchar      *name,
       script_fu_server_run (name, nparams, param,
                             nreturn_vals, return_vals);
     }
+  else if (strcmp (name, "plug-in-script-fu-server-worker") == 0)
+    {
+      /*
+       *  An interpreter process of the script-fu server
+       */
+
+      script_fu_server_worker_run (name, nparams, param,
+                                   nreturn_vals, return_vals);
+    }
   else if (strcmp (name, "plug-in-script-fu-eval") == 0)
     {
       /*
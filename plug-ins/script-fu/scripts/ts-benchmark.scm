@@ -0,0 +1,160 @@
+; GIMP - The GNU Image Manipulation Program
+; Copyright (C) 1995 Spencer Kimball and Peter Mattis
+;
+; This program is free software: you can redistribute it and/or modify
+; it under the terms of the GNU General Public License as published by
+; the Free Software Foundation; either version 3 of the License, or
+; (at your option) any later version.
+;
+; This program is distributed in the hope that it will be useful,
+; but WITHOUT ANY WARRANTY; without even the implied warranty of
+; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+; GNU General Public License for more details.
+;
+; You should have received a copy of the GNU General Public License
+; along with this program.  If not, see <http://www.gnu.org/licenses/>.
+;
+;
+; Script-Fu Benchmarks
+;
+; A set of small benchmarks for the TinyScheme interpreter and for the
+; marshalling of PDB calls. Each benchmark only stresses one part, so
+; timings taken before and after a change show where it made a
+; difference.
+;
+; ts-benchmark-run measures the wall-clock time of each benchmark and
+; prints it. Run them from the Script-Fu console, e.g.
+; (ts-benchmark-run "all" 10), in batch mode:
+;
+;   gimp -i -b '(ts-benchmark-run "gc" 10)' -b '(gimp-quit 0)'
+;
+; or through the Script-Fu server, which also logs the time spent on
+; each request and reports it with "servertest.py -s".
+
+
+; Function calls and arithmetic
+(define (ts-benchmark-fib n)
+  (if (< n 2)
+      n
+      (+ (ts-benchmark-fib (- n 1)) (ts-benchmark-fib (- n 2)))
+  )
+)
+
+(define (ts-benchmark-eval)
+  (ts-benchmark-fib 20)
+)
+
+; Lookups of global variables from nested frames
+(define (ts-benchmark-lookup)
+  (let loop ((i 0)
+             (sum 0))
+    (if (< i 20000)
+        (let* ((a (abs (- i)))
+               (b (max a 1))
+               (c (min b 100))
+               (d (quotient c 3))
+               (e (remainder d 7)))
+          (loop (+ i 1)
+                (if (and (even? e) (not (zero? e))) (+ sum e) sum)))
+        sum
+    )
+  )
+)
+
+; Allocation with a large working set, which keeps the collector busy
+(define (ts-benchmark-gc)
+  (let ((keep (make-vector 1000 '())))
+    (let loop ((i 0))
+      (if (< i 5000)
+          (begin
+            (vector-set! keep (modulo i 1000)
+                         (let build ((j 0)
+                                     (lst '()))
+                           (if (< j 100)
+                               (build (+ j 1) (cons j lst))
+                               lst)))
+            (loop (+ i 1)))
+      )
+    )
+  )
+)
+
+; Calls of a cheap PDB procedure
+(define (ts-benchmark-pdb)
+  (let loop ((i 0))
+    (if (< i 2000)
+        (begin
+          (gimp-context-get-opacity)
+          (loop (+ i 1)))
+    )
+  )
+)
+
+(define ts-benchmarks
+  (list (cons "eval"   ts-benchmark-eval)
+        (cons "lookup" ts-benchmark-lookup)
+        (cons "gc"     ts-benchmark-gc)
+        (cons "pdb"    ts-benchmark-pdb)))
+
+; Wall-clock time in seconds
+(define (ts-benchmark-time)
+  (let ((now (gettimeofday)))
+    (+ (car now) (/ (cadr now) 1000000.0))
+  )
+)
+
+; Runs the benchmark called name, or all of them, iterations times
+; each, prints the time each one took and returns the report
+(define (ts-benchmark-run name iterations)
+  (let ((report ""))
+    (for-each
+      (lambda (benchmark)
+        (if (or (string=? name "all")
+                (string=? name (car benchmark)))
+            (let ((start (ts-benchmark-time)))
+              (let loop ((i 0))
+                (if (< i iterations)
+                    (begin
+                      ((cdr benchmark))
+                      (loop (+ i 1)))
+                )
+              )
+              (let* ((time (- (ts-benchmark-time) start))
+                     (ms   (inexact->exact (round (* time 1000))))
+                     (line (string-append (car benchmark) ": "
+                                          (number->string iterations)
+                                          " iterations in "
+                                          (number->string ms) " ms\n")))
+                (display line)
+                (set! report (string-append report line))
+              )
+            )
+        )
+      )
+      ts-benchmarks
+    )
+    report
+  )
+)
+
+(define (script-fu-ts-benchmark benchmark iterations)
+  (gimp-message
+    (ts-benchmark-run (car (list-tail '("all" "eval" "lookup" "gc" "pdb")
+                                      benchmark))
+                      iterations))
+)
+
+(script-fu-register "script-fu-ts-benchmark"
+    "_Benchmark..."
+    "Runs benchmarks of the Script-Fu interpreter."
+    "GIMP Developers"
+    "GIMP Developers"
+    "2026"
+    ""
+    SF-OPTION     "Benchmark"   '("All" "Evaluation" "Variable lookup"
+                                  "Garbage collection" "PDB calls")
+    SF-ADJUSTMENT "Iterations"  '(10 1 1000 1 10 0 1)
+)
+
+(script-fu-menu-register "script-fu-ts-benchmark"
+                         "<Image>/Filters/Languages/Script-Fu/Test")
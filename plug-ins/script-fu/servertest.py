@@ -1,74 +1,185 @@
 #!/usr/bin/env python
 
-import readline, socket, sys
+import getopt, readline, socket, sys, threading, time
 
-if len(sys.argv) < 1 or len(sys.argv) > 3:
-   print >>sys.stderr, "Usage: %s <host> <port>" % sys.argv[0]
+def usage():
+   print >>sys.stderr, "Usage: %s [-s] [-c <clients> -n <requests> [-e <command>]] [<host> [<port>]]" % sys.argv[0]
    print >>sys.stderr, "       (if omitted connect to localhost, port 10008)"
+   print >>sys.stderr, "  -s  print the queue and latency statistics of the server"
+   print >>sys.stderr, "  -c  number of concurrent clients for a load test"
+   print >>sys.stderr, "  -n  number of requests sent by each client"
+   print >>sys.stderr, "  -e  command sent by the load test (default: (gimp-version))"
    sys.exit(1)
 
 HOST = "localhost"
 PORT = 10008
 
+stats    = False
+clients  = 0
+requests = 0
+command  = "(gimp-version)"
+
+try:
+   opts, args = getopt.getopt(sys.argv[1:], "sc:n:e:")
+except getopt.GetoptError:
+   usage()
+
+for (opt, val) in opts:
+   if opt == "-s":
+      stats = True
+   elif opt == "-c":
+      clients = int(val)
+   elif opt == "-n":
+      requests = int(val)
+   elif opt == "-e":
+      command = val
+
+if len(args) > 2 or (clients > 0) != (requests > 0):
+   usage()
+
 try:
-    HOST = sys.argv[1]
+    HOST = args[0]
     try:
-        PORT = int(sys.argv[2])
+        PORT = int(args[1])
     except IndexError:
         pass
 except IndexError:
     pass
 
-addresses = socket.getaddrinfo(HOST, PORT, socket.AF_UNSPEC, socket.SOCK_STREAM)
+def connect(verbose):
+   addresses = socket.getaddrinfo(HOST, PORT, socket.AF_UNSPEC, socket.SOCK_STREAM)
 
-connected = False
+   for addr in addresses:
+       (family, socktype, proto, canonname, sockaddr) = addr
 
-for addr in addresses:
-    (family, socktype, proto, canonname, sockaddr) = addr
+       numeric_addr = sockaddr[0]
 
-    numeric_addr = sockaddr[0]
+       if verbose:
+           if canonname:
+               print "Trying %s ('%s')." % (numeric_addr, canonname)
+           else:
+               print "Trying %s." % numeric_addr
 
-    if canonname:
-        print "Trying %s ('%s')." % (numeric_addr, canonname)
-    else:
-        print "Trying %s." % numeric_addr
+       try:
+           sock = socket.socket(family, socket.SOCK_STREAM)
+           sock.connect((HOST, PORT))
+           return sock
+       except:
+           pass
 
-    try:
-        sock = socket.socket(family, socket.SOCK_STREAM)
-        sock.connect((HOST, PORT))
-        connected = True
-        break
-    except:
-        pass
+   print "Failed."
+   sys.exit(1)
+
+def recv_all(sock, l):
+   data = ""
+   while len(data) < l:
+      chunk = sock.recv(l - len(data))
+      if not chunk:
+         raise EOFError
+      data += chunk
+   return data
+
+RSP_ERROR     = 0x01
+RSP_CONTINUED = 0x02
+
+# returns (error, message), or None if the response is invalid
+def request(sock, cmd, magic = 'G'):
+   sock.sendall('%c%c%c%s' % (magic, len(cmd) / 256, len(cmd) % 256, cmd))
+
+   error   = False
+   message = ""
+
+   # responses longer than 65535 bytes come in several frames
+   while True:
+      data = recv_all(sock, 4)
+
+      if data[0] != 'G':
+         print "invalid magic: %s\n" % data
+         return None
+
+      flags = ord(data[1])
+      l     = ord(data[2]) * 256 + ord(data[3])
+
+      error    = error or (flags & RSP_ERROR) != 0
+      message += recv_all(sock, l)
+
+      if not flags & RSP_CONTINUED:
+         return (error, message)
+
+def load_client(latencies, errors, lock):
+   sock = connect(False)
 
-if not connected:
-    print "Failed."
-    sys.exit(1)
+   for i in range(requests):
+      start  = time.time()
+      result = request(sock, command)
+      end    = time.time()
+
+      lock.acquire()
+      latencies.append(end - start)
+      if not result or result[0]:
+         errors.append(result)
+      lock.release()
+
+   sock.close()
+
+def load_test():
+   latencies = []
+   errors    = []
+   lock      = threading.Lock()
+   threads   = []
+
+   print "Sending %d x %d requests: %s" % (clients, requests, command)
+
+   start = time.time()
+
+   for i in range(clients):
+      thread = threading.Thread(target = load_client,
+                                args = (latencies, errors, lock))
+      thread.start()
+      threads.append(thread)
+
+   for thread in threads:
+      thread.join()
+
+   total = time.time() - start
+
+   latencies.sort()
+
+   if not latencies:
+      return
+
+   print "requests:     %d (%d errors)" % (len(latencies), len(errors))
+   print "total time:   %.3f s" % total
+   print "throughput:   %.1f requests/s" % (len(latencies) / total)
+   print "mean latency: %.3f s" % (sum(latencies) / len(latencies))
+   print "95%% latency:  %.3f s" % latencies[int(len(latencies) * 0.95)]
+   print "max latency:  %.3f s" % latencies[-1]
+
+if clients > 0:
+   load_test()
+
+if stats or clients > 0:
+   sock = connect(False)
+   result = request(sock, "", 'S')
+   if result:
+      print result[1],
+   sock.close()
+   sys.exit(0)
+
+sock = connect(True)
 
 try:
    cmd = raw_input("Script-Fu-Remote - Testclient\n> ")
 
    while len(cmd) > 0:
-      sock.send('G%c%c%s' % (len(cmd) / 256, len(cmd) % 256, cmd))
-
-      data = ""
-      while len(data) < 4:
-         data += sock.recv(4 - len(data))
-
-      if len(data) >= 4:
-         if data[0] == 'G':
-            l = ord(data[2]) * 256 + ord(data[3])
-            msg = ""
-            while len(msg) < l:
-               msg += sock.recv(l - len(msg))
-            if ord(data[1]):
-               print "(ERR):", msg
-            else:
-               print " (OK):", msg
+      result = request(sock, cmd)
+
+      if result:
+         (error, msg) = result
+         if error:
+            print "(ERR):", msg
          else:
-            print "invalid magic: %s\n" % data
-      else:
-         print "short response: %s\n" % data
+            print " (OK):", msg
       cmd = raw_input("> ")
 
 except EOFError:
@@ -43,6 +43,7 @@ struct cell {
     struct {
       char   *_svalue;
       int   _length;
+      unsigned int _hash;    /* hash of a symbol's name */
     } _string;
     num _number;
     port *_port;
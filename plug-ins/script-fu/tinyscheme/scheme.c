@@ -147,6 +147,12 @@ static int utf8_stricmp(const char *s1, const char *s2)
 # define FIRST_CELLSEGS 3
 #endif
 
+/* Size of the symbol table and of the global environment. A GIMP
+   session has a few thousand symbols, so keep the chains short. */
+#ifndef HASH_TABLE_SIZE
+# define HASH_TABLE_SIZE 4093
+#endif
+
 enum scheme_types {
   T_STRING=1,
   T_NUMBER=2,
@@ -207,6 +213,7 @@ static num num_one;
 INTERFACE INLINE int is_string(pointer p)     { return (type(p)==T_STRING); }
 #define strvalue(p)      ((p)->_object._string._svalue)
 #define strlength(p)     ((p)->_object._string._length)
+#define strhash(p)       ((p)->_object._string._hash)
 
 INTERFACE static int is_list(scheme *sc, pointer a);
 INTERFACE INLINE int is_vector(pointer p)    { return (type(p)==T_VECTOR); }
@@ -376,6 +383,7 @@ static void file_pop(scheme *sc);
 static int file_interactive(scheme *sc);
 static INLINE int is_one_of(char *s, gunichar c);
 static int alloc_cellseg(scheme *sc, int n);
+static void grow_heap(scheme *sc);
 static long binary_decode(const char *s);
 static INLINE pointer get_cell(scheme *sc, pointer a, pointer b);
 static pointer _get_cell(scheme *sc, pointer a, pointer b);
@@ -385,6 +393,7 @@ static pointer find_consecutive_cells(scheme *sc, int n);
 static void finalize_cell(scheme *sc, pointer a);
 static int count_consecutive_cells(pointer x, int needed);
 static pointer find_slot_in_env(scheme *sc, pointer env, pointer sym, int all);
+static unsigned int hash_string(const char *key);
 static pointer mk_number(scheme *sc, num n);
 static char *store_string(scheme *sc, int len, const char *str, gunichar fill);
 static pointer mk_vector(scheme *sc, int len);
@@ -662,6 +671,22 @@ static int alloc_cellseg(scheme *sc, int n) {
      return n;
 }
 
+/* After a collection, add segments until at least half of the heap is
+   free. The cost of a collection grows with the heap, so this keeps the
+   gc time per allocated cell bounded, instead of collecting again and
+   again when most of the heap is in use. */
+static void grow_heap(scheme *sc) {
+     long total = (sc->last_cell_seg + 1) * (long) CELL_SEGSIZE;
+     long n;
+
+     /* smallest n with fcells + n*SEGSIZE >= (total + n*SEGSIZE) / 2 */
+     n = (total - 2 * sc->fcells + CELL_SEGSIZE - 1) / CELL_SEGSIZE;
+
+     if (n > 0) {
+          alloc_cellseg(sc, (int) n);
+     }
+}
+
 static INLINE pointer get_cell_x(scheme *sc, pointer a, pointer b) {
   if (sc->free_cell != sc->NIL) {
     pointer x = sc->free_cell;
@@ -682,15 +707,12 @@ static pointer _get_cell(scheme *sc, pointer a, pointer b) {
   }
 
   if (sc->free_cell == sc->NIL) {
-    const int min_to_be_recovered = sc->last_cell_seg*8;
     gc(sc,a, b);
-    if (sc->fcells < min_to_be_recovered
-        || sc->free_cell == sc->NIL) {
-      /* if only a few recovered, get more to avoid fruitless gc's */
-      if (!alloc_cellseg(sc,1) && sc->free_cell == sc->NIL) {
-        sc->no_memory=1;
-        return sc->sink;
-      }
+    /* if only a few recovered, get more to avoid fruitless gc's */
+    grow_heap(sc);
+    if (sc->free_cell == sc->NIL) {
+      sc->no_memory=1;
+      return sc->sink;
     }
   }
   x = sc->free_cell;
@@ -709,6 +731,7 @@ static pointer reserve_cells(scheme *sc, int n) {
        if (sc->fcells < n) {
                /* If not, try gc'ing some */
                gc(sc, sc->NIL, sc->NIL);
+               grow_heap(sc);
                if (sc->fcells < n) {
                        /* If there still aren't, try getting more heap */
                        if (!alloc_cellseg(sc,1)) {
@@ -736,6 +759,7 @@ static pointer get_consecutive_cells(scheme *sc, int n) {
 
   /* If not, try gc'ing some */
   gc(sc, sc->NIL, sc->NIL);
+  grow_heap(sc);
   x=find_consecutive_cells(sc,n);
   if (x != sc->NIL) { return x; }
 
@@ -873,7 +897,7 @@ static int hash_fn(const char *key, int table_size);
 
 static pointer oblist_initial_value(scheme *sc)
 {
-  return mk_vector(sc, 461); /* probably should be bigger */
+  return mk_vector(sc, HASH_TABLE_SIZE);
 }
 
 /* returns the new symbol */
@@ -885,8 +909,9 @@ static pointer oblist_add_by_name(scheme *sc, const char *name)
   x = immutable_cons(sc, mk_string(sc, name), sc->NIL);
   typeflag(x) = T_SYMBOL;
   setimmutable(car(x));
+  strhash(car(x)) = hash_string(name);
 
-  location = hash_fn(name, ivalue_unchecked(sc->oblist));
+  location = strhash(car(x)) % ivalue_unchecked(sc->oblist);
   set_vector_elem(sc->oblist, location,
                   immutable_cons(sc, x, vector_elem(sc->oblist, location)));
   return x;
@@ -953,6 +978,7 @@ static pointer oblist_add_by_name(scheme *sc, const char *name)
   x = immutable_cons(sc, mk_string(sc, name), sc->NIL);
   typeflag(x) = T_SYMBOL;
   setimmutable(car(x));
+  strhash(car(x)) = hash_string(name);
   sc->oblist = immutable_cons(sc, x, sc->oblist);
   return x;
 }
@@ -2350,9 +2376,9 @@ int eqv(pointer a, pointer b) {
 
 /* ========== Environment implementation  ========== */
 
-#if !defined(USE_ALIST_ENV) || !defined(USE_OBJECT_LIST)
-
-static int hash_fn(const char *key, int table_size)
+/* Every symbol keeps the hash of its name, so looking it up in a
+   hashed frame doesn't have to walk the name again. */
+static unsigned int hash_string(const char *key)
 {
   unsigned int hashed = 0;
   const char *c;
@@ -2363,7 +2389,13 @@ static int hash_fn(const char *key, int table_size)
     hashed = (hashed<<5) | (hashed>>(bits_per_int-5));
     hashed ^= *c;
   }
-  return hashed % table_size;
+  return hashed;
+}
+
+#ifndef USE_OBJECT_LIST
+static int hash_fn(const char *key, int table_size)
+{
+  return hash_string(key) % table_size;
 }
 #endif
 
@@ -2381,9 +2413,10 @@ static void new_frame_in_env(scheme *sc, pointer old_env)
 {
   pointer new_frame;
 
-  /* The interaction-environment has about 300 variables in it. */
+  /* The interaction-environment has about 300 variables in it, plus
+     one for each PDB procedure and script function in GIMP. */
   if (old_env == sc->NIL) {
-    new_frame = mk_vector(sc, 461);
+    new_frame = mk_vector(sc, HASH_TABLE_SIZE);
   } else {
     new_frame = sc->NIL;
   }
@@ -2398,7 +2431,7 @@ static INLINE void new_slot_spec_in_env(scheme *sc, pointer env,
   pointer slot = immutable_cons(sc, variable, value);
 
   if (is_vector(car(env))) {
-    int location = hash_fn(symname(variable), ivalue_unchecked(car(env)));
+    int location = strhash(car(variable)) % ivalue_unchecked(car(env));
 
     set_vector_elem(car(env), location,
                     immutable_cons(sc, slot, vector_elem(car(env), location)));
@@ -2414,7 +2447,7 @@ static pointer find_slot_in_env(scheme *sc, pointer env, pointer hdl, int all)
 
   for (x = env; x != sc->NIL; x = cdr(x)) {
     if (is_vector(car(x))) {
-      location = hash_fn(symname(hdl), ivalue_unchecked(car(x)));
+      location = strhash(car(hdl)) % ivalue_unchecked(car(x));
       y = vector_elem(car(x), location);
     } else {
       y = car(x);